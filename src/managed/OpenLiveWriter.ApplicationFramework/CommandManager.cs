@@ -567,8 +567,15 @@ public Command Get(string commandIdentifier)
 
         public Command Get(CommandId commandIdentifier)
         {
+            // Ribbon commands come straight from the generated table, which carries
+            // the CommandId names; only the rest need the enum formatted once.
             string str;
-            if (!commandIdToString.TryGetValue(commandIdentifier, out str))
+            int ribbonIndex = RibbonCommandTable.FindById((uint)commandIdentifier);
+            if (ribbonIndex >= 0)
+            {
+                str = RibbonCommandTable.GetIdentifier(ribbonIndex);
+            }
+            else if (!commandIdToString.TryGetValue(commandIdentifier, out str))
             {
                 str = commandIdentifier.ToString();
                 commandIdToString.Add(commandIdentifier, str);
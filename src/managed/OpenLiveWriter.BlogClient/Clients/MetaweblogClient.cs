@@ -666,7 +666,7 @@ public override string DoBeforePublishUploadWork(IFileUploadContext uploadContex
                                                                    {
                                                                        new XmlRpcMember( "name", uploadFileName ),
                                                                        new XmlRpcMember( "type", MimeHelper.GetContentType(Path.GetExtension(uploadContext.PreferredFileName),MimeHelper.APP_OCTET_STREAM )),
-                                                                       new XmlRpcMember( "bits", new XmlRpcBase64( StreamHelper.AsBytes(fileContents) ) ),
+                                                                       new XmlRpcMember( "bits", new XmlRpcBase64( fileContents ) ),
                                                                    }
                                                 ));
             }
@@ -0,0 +1,146 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+using System;
+using System.Diagnostics;
+using System.Runtime.InteropServices;
+using OpenLiveWriter.Interop.Com;
+using OpenLiveWriter.Interop.Windows;
+
+namespace OpenLiveWriter.CoreServices.HTML
+{
+    /// <summary>
+    /// A span of the old HTML replaced by new text.
+    /// </summary>
+    public class HtmlDiffHunk
+    {
+        private readonly int _oldStart;
+        private readonly int _oldLength;
+        private readonly string _newText;
+
+        public HtmlDiffHunk(int oldStart, int oldLength, string newText)
+        {
+            _oldStart = oldStart;
+            _oldLength = oldLength;
+            _newText = newText;
+        }
+
+        public int OldStart
+        {
+            get { return _oldStart; }
+        }
+
+        public int OldLength
+        {
+            get { return _oldLength; }
+        }
+
+        public string NewText
+        {
+            get { return _newText; }
+        }
+    }
+
+    /// <summary>
+    /// Compares two versions of a post's HTML natively (OpenLiveWriter.Native.dll),
+    /// word by word and tag by tag, finding the smallest set of changes that turns
+    /// one into the other. Differences that don't change the post, like the case of
+    /// tags, how attributes are quoted and how much white space there is outside
+    /// preformatted elements, can be ignored, as servers often make them when they
+    /// store a post.
+    /// </summary>
+    public class HtmlDiff
+    {
+        private static bool _nativeUnavailable;
+
+        /// <summary>
+        /// Finds the changes that turn oldHtml into newHtml, in order, returning false
+        /// if the native diff can't be used or more than maxDifferences words, spaces
+        /// and tags would have to be deleted or inserted. Replacing the hunks' spans of
+        /// oldHtml with their text gives newHtml unless formatting is ignored.
+        /// </summary>
+        public static bool TryCompare(string oldHtml, string newHtml, bool ignoreFormatting, int maxDifferences, out HtmlDiffHunk[] hunks)
+        {
+            hunks = null;
+            if (_nativeUnavailable)
+                return false;
+
+            try
+            {
+                IntPtr result;
+                int hunkCount;
+                int hr = OpenLiveWriterNative.DiffHtml(oldHtml, oldHtml.Length, newHtml, newHtml.Length, Flags(ignoreFormatting), maxDifferences, out result, out hunkCount);
+                if (hr == HRESULT.S_FALSE)
+                    return false;
+                if (hr != HRESULT.S_OK)
+                {
+                    Trace.Fail("DiffHtml failed: 0x" + hr.ToString("X8"));
+                    return false;
+                }
+
+                hunks = new HtmlDiffHunk[hunkCount];
+                try
+                {
+                    int size = Marshal.SizeOf(typeof(OpenLiveWriterNative.HtmlDiffHunk));
+                    for (int i = 0; i < hunkCount; i++)
+                    {
+                        OpenLiveWriterNative.HtmlDiffHunk hunk = (OpenLiveWriterNative.HtmlDiffHunk)Marshal.PtrToStructure(new IntPtr(result.ToInt64() + i * size), typeof(OpenLiveWriterNative.HtmlDiffHunk));
+                        hunks[i] = new HtmlDiffHunk(hunk.oldStart, hunk.oldLength, newHtml.Substring(hunk.newStart, hunk.newLength));
+                    }
+                }
+                finally
+                {
+                    Marshal.FreeCoTaskMem(result);
+                }
+                return true;
+            }
+            catch (DllNotFoundException)
+            {
+                _nativeUnavailable = true;
+            }
+            catch (EntryPointNotFoundException)
+            {
+                _nativeUnavailable = true;
+            }
+            Trace.WriteLine(OpenLiveWriterNative.DLL_NAME + " is not available, HTML can't be compared");
+            return false;
+        }
+
+        /// <summary>
+        /// Computes a signature of html that is the same for versions TryCompare finds
+        /// no changes between, returning false if the native diff can't be used.
+        /// </summary>
+        public static bool TryGetSignature(string html, bool ignoreFormatting, out long signature)
+        {
+            signature = 0;
+            if (_nativeUnavailable)
+                return false;
+
+            try
+            {
+                int hr = OpenLiveWriterNative.GetHtmlSignature(html, html.Length, Flags(ignoreFormatting), out signature);
+                if (hr != HRESULT.S_OK)
+                {
+                    Trace.Fail("GetHtmlSignature failed: 0x" + hr.ToString("X8"));
+                    return false;
+                }
+                return true;
+            }
+            catch (DllNotFoundException)
+            {
+                _nativeUnavailable = true;
+            }
+            catch (EntryPointNotFoundException)
+            {
+                _nativeUnavailable = true;
+            }
+            Trace.WriteLine(OpenLiveWriterNative.DLL_NAME + " is not available, HTML can't be compared");
+            return false;
+        }
+
+        private static int Flags(bool ignoreFormatting)
+        {
+            return ignoreFormatting ? OpenLiveWriterNative.HTML_DIFF_IGNORE_FORMATTING : 0;
+        }
+    }
+}
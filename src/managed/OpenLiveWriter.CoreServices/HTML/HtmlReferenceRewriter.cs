@@ -0,0 +1,92 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Runtime.InteropServices;
+using OpenLiveWriter.HtmlParser.Parser;
+using OpenLiveWriter.Interop.Com;
+using OpenLiveWriter.Interop.Windows;
+
+namespace OpenLiveWriter.CoreServices.HTML
+{
+    /// <summary>
+    /// Replaces references in HTML with the ones a table maps them to, in a single
+    /// native pass (OpenLiveWriter.Native.dll). The same references are replaced as
+    /// by HtmlReferenceFixer with a fixer that looks them up in the table, but only
+    /// the replaced attribute values change; HtmlReferenceFixer also writes every tag
+    /// with a URL attribute back out in its own formatting.
+    ///
+    /// References are matched ignoring ASCII case, so this is meant for tables of
+    /// URLs whose case doesn't matter, like supporting file and local file URLs.
+    /// </summary>
+    public class HtmlReferenceRewriter
+    {
+        private static bool _nativeUnavailable;
+
+        /// <summary>
+        /// Rewrites html, returning false (and html) if the native rewriter can't be
+        /// used, in which case callers fall back to HtmlReferenceFixer.
+        /// </summary>
+        public static bool TryRewrite(string html, IEnumerable<KeyValuePair<string, string>> references, out string rewrittenHtml)
+        {
+            rewrittenHtml = html;
+            if (_nativeUnavailable || html == null)
+                return false;
+
+            List<string> from = new List<string>();
+            List<string> to = new List<string>();
+            foreach (KeyValuePair<string, string> reference in references)
+            {
+                string escapedValue = HtmlUtils.EscapeEntities(reference.Value);
+                from.Add(reference.Key);
+                to.Add(escapedValue);
+
+                // the HTML has the reference the way the parser would have unescaped it
+                string escapedKey = HtmlUtils.EscapeEntities(reference.Key);
+                if (escapedKey != reference.Key)
+                {
+                    from.Add(escapedKey);
+                    to.Add(escapedValue);
+                }
+            }
+            if (from.Count == 0)
+                return true;
+
+            try
+            {
+                IntPtr result;
+                int resultLength;
+                int hr = OpenLiveWriterNative.RewriteHtmlReferences(html, html.Length, from.ToArray(), to.ToArray(), from.Count, out result, out resultLength);
+                if (hr == HRESULT.S_FALSE)
+                    return true;
+                if (hr != HRESULT.S_OK)
+                {
+                    Trace.Fail("RewriteHtmlReferences failed: 0x" + hr.ToString("X8"));
+                    return false;
+                }
+
+                try
+                {
+                    rewrittenHtml = Marshal.PtrToStringUni(result, resultLength);
+                }
+                finally
+                {
+                    Marshal.FreeCoTaskMem(result);
+                }
+                return true;
+            }
+            catch (DllNotFoundException)
+            {
+                _nativeUnavailable = true;
+            }
+            catch (EntryPointNotFoundException)
+            {
+                _nativeUnavailable = true;
+            }
+            Trace.WriteLine(OpenLiveWriterNative.DLL_NAME + " is not available, falling back to HtmlReferenceFixer");
+            return false;
+        }
+    }
+}
@@ -3,6 +3,7 @@
 
 using System;
 using System.Collections.Generic;
+using System.Diagnostics;
 using System.Drawing;
 using System.Drawing.Imaging;
 using System.Text;
@@ -34,7 +35,22 @@ public Bitmap Load(string path, Size size)
             if (imageCache.ContainsKey(path))
                 return imageCache[path];
 
-            using (Image img = ImageHelper2.SafeGetEmbeddedThumbnail(path) ?? ImageHelper2.SafeFromFile(path))
+            // thumbnails made in earlier sessions, of images with the same contents
+            ThumbnailCache thumbnails = ThumbnailCache.Application;
+            byte[] hash = thumbnails != null ? ThumbnailCache.SafeHashFile(path) : null;
+            if (hash != null)
+            {
+                Bitmap cached = thumbnails.Find(hash, size);
+                if (cached != null)
+                {
+                    imageCache.Add(path, cached);
+                    return cached;
+                }
+            }
+
+            ImageHeader header;
+            Image thumbnail = SafeGetEmbeddedThumbnail(path, out header);
+            using (Image img = thumbnail ?? ImageHelper2.SafeFromFile(path))
             {
                 if (img == null)
                 {
@@ -42,13 +58,47 @@ public Bitmap Load(string path, Size size)
                 }
                 else
                 {
-                    ImageHelper.AutoRotateFromExifOrientation(img);
-                    imageCache.Add(path, ResizeImage((Bitmap)img, size.Width, size.Height));
+                    // the thumbnail doesn't have the image's EXIF orientation, but its headers do
+                    if (thumbnail != null && header != null)
+                        ImageHelper.RotateFromExifOrientation(header.Orientation, img);
+                    else
+                        ImageHelper.AutoRotateFromExifOrientation(img);
+                    Bitmap resized = ResizeImage((Bitmap)img, size.Width, size.Height);
+                    if (hash != null)
+                        thumbnails.Store(hash, size, resized);
+                    imageCache.Add(path, resized);
                 }
             }
             return imageCache[path];
         }
 
+        private static Image SafeGetEmbeddedThumbnail(string path, out ImageHeader header)
+        {
+            header = null;
+            try
+            {
+                using (Stream s = File.OpenRead(path))
+                {
+                    if (ImageHeaderReader.TryRead(s, out header))
+                    {
+                        byte[] thumbnail = ImageHeaderReader.ReadThumbnail(s, header);
+                        return thumbnail != null ? Image.FromStream(new MemoryStream(thumbnail)) : null;
+                    }
+                }
+            }
+            catch (ArgumentException ex)
+            {
+                Debug.WriteLine("Failed to load thumbnail:" + ex);
+                return null;
+            }
+            catch (Exception ex)
+            {
+                Trace.Fail("Failed to load thumbnail:" + ex);
+                return null;
+            }
+            return ImageHelper2.SafeGetEmbeddedThumbnail(path);
+        }
+
         private static Bitmap ResizeImage(Bitmap image, int maxWidth, int maxHeight)
         {
             Size resize = ImageHelper2.ImageResizer.ScaledResize(image, new Size(maxWidth, maxHeight));
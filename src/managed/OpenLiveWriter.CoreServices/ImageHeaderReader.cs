@@ -0,0 +1,249 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+using System;
+using System.Diagnostics;
+using System.Drawing;
+using System.IO;
+using System.Runtime.InteropServices;
+using OpenLiveWriter.Interop.Com;
+using OpenLiveWriter.Interop.Windows;
+
+namespace OpenLiveWriter.CoreServices
+{
+    public enum ImageHeaderFormat
+    {
+        Unknown = OpenLiveWriterNative.IMAGE_HEADER_UNKNOWN,
+        Jpeg = OpenLiveWriterNative.IMAGE_HEADER_JPEG,
+        Png = OpenLiveWriterNative.IMAGE_HEADER_PNG,
+        Gif = OpenLiveWriterNative.IMAGE_HEADER_GIF,
+        Bmp = OpenLiveWriterNative.IMAGE_HEADER_BMP,
+        WebP = OpenLiveWriterNative.IMAGE_HEADER_WEBP
+    }
+
+    /// <summary>
+    /// What an image's headers say about it.
+    /// </summary>
+    public class ImageHeader
+    {
+        private readonly OpenLiveWriterNative.ImageHeader _header;
+
+        internal ImageHeader(OpenLiveWriterNative.ImageHeader header)
+        {
+            _header = header;
+        }
+
+        public ImageHeaderFormat Format
+        {
+            get { return (ImageHeaderFormat)_header.format; }
+        }
+
+        /// <summary>
+        /// The size the pixels are stored at, before any EXIF orientation, as
+        /// Image.Size is.
+        /// </summary>
+        public Size Size
+        {
+            get { return new Size(_header.width, _header.height); }
+        }
+
+        public ExifOrientation Orientation
+        {
+            get { return _header.orientation != 0 ? (ExifOrientation)_header.orientation : ExifOrientation.Unknown; }
+        }
+
+        /// <summary>
+        /// Whether a JPEG has an EXIF thumbnail, for ImageHeaderReader.ReadThumbnail.
+        /// </summary>
+        public bool HasThumbnail
+        {
+            get { return _header.thumbnailLength > 0; }
+        }
+
+        internal long ThumbnailOffset
+        {
+            get { return _header.thumbnailOffset; }
+        }
+
+        internal int ThumbnailLength
+        {
+            get { return _header.thumbnailLength; }
+        }
+
+        /// <summary>
+        /// How many bytes of the image were read for this.
+        /// </summary>
+        public int BytesRead
+        {
+            get { return _header.bytesRead; }
+        }
+    }
+
+    /// <summary>
+    /// Reads the size, EXIF orientation and EXIF thumbnail of JPEG, PNG, GIF, BMP
+    /// and WebP images from their headers, natively (OpenLiveWriter.Native.dll),
+    /// reading a few KB of each rather than decoding it. Images start at the
+    /// beginning of their streams, which can be files or supporting file streams.
+    /// </summary>
+    public class ImageHeaderReader
+    {
+        private static bool _nativeUnavailable;
+
+        /// <summary>
+        /// Reads the headers of an image file, returning false if they can't be read,
+        /// in which case callers fall back to GDI+.
+        /// </summary>
+        public static bool TryRead(string path, out ImageHeader header)
+        {
+            header = null;
+            if (_nativeUnavailable)
+                return false;
+
+            using (Stream stream = File.OpenRead(path))
+                return TryRead(stream, out header);
+        }
+
+        /// <summary>
+        /// Reads the headers of an image, returning false if they can't be read, in
+        /// which case callers fall back to GDI+.
+        /// </summary>
+        public static bool TryRead(Stream stream, out ImageHeader header)
+        {
+            ImageHeader[] headers;
+            header = null;
+            if (!TryRead(new Stream[] { stream }, out headers) || headers[0] == null)
+                return false;
+
+            header = headers[0];
+            return true;
+        }
+
+        /// <summary>
+        /// Reads the headers of a batch of images, returning false if the native reader
+        /// can't be used. Images whose format isn't known or whose headers can't be
+        /// read get null headers.
+        /// </summary>
+        public static bool TryRead(Stream[] streams, out ImageHeader[] headers)
+        {
+            headers = null;
+            if (_nativeUnavailable)
+                return false;
+
+            try
+            {
+                StreamSource source = new StreamSource(streams);
+                OpenLiveWriterNative.ImageHeader[] nativeHeaders = new OpenLiveWriterNative.ImageHeader[streams.Length];
+                OpenLiveWriterNative.ImageHeaderReadCallback read = new OpenLiveWriterNative.ImageHeaderReadCallback(source.Read);
+                int hr = OpenLiveWriterNative.ReadImageHeaders(streams.Length, read, nativeHeaders);
+                GC.KeepAlive(read);
+                if (hr != HRESULT.S_OK)
+                {
+                    Trace.Fail("ReadImageHeaders failed: 0x" + hr.ToString("X8"));
+                    return false;
+                }
+
+                headers = new ImageHeader[streams.Length];
+                for (int i = 0; i < streams.Length; i++)
+                {
+                    if (nativeHeaders[i].format != OpenLiveWriterNative.IMAGE_HEADER_UNKNOWN)
+                        headers[i] = new ImageHeader(nativeHeaders[i]);
+                }
+                return true;
+            }
+            catch (DllNotFoundException)
+            {
+                _nativeUnavailable = true;
+            }
+            catch (EntryPointNotFoundException)
+            {
+                _nativeUnavailable = true;
+            }
+            Trace.WriteLine(OpenLiveWriterNative.DLL_NAME + " is not available, falling back to GDI+ for image headers");
+            return false;
+        }
+
+        /// <summary>
+        /// Reads the EXIF thumbnail JPEG that header found in stream, which has to be
+        /// able to seek, or returns null if there's none or the stream ends first.
+        /// </summary>
+        public static byte[] ReadThumbnail(Stream stream, ImageHeader header)
+        {
+            if (!header.HasThumbnail)
+                return null;
+
+            stream.Seek(header.ThumbnailOffset, SeekOrigin.Begin);
+            byte[] thumbnail = new byte[header.ThumbnailLength];
+            return ReadFully(stream, thumbnail, thumbnail.Length) == thumbnail.Length ? thumbnail : null;
+        }
+
+        // Reads count bytes, or as many as there are.
+        private static int ReadFully(Stream stream, byte[] buffer, int count)
+        {
+            int read = 0;
+            int n;
+            while (read < count && (n = stream.Read(buffer, read, count - read)) > 0)
+                read += n;
+            return read;
+        }
+
+        /// <summary>
+        /// Reads the streams for the native reader, which asks for a few KB of an image
+        /// at a time. Streams that can't seek are read forwards.
+        /// </summary>
+        private class StreamSource
+        {
+            private readonly Stream[] _streams;
+            private readonly long[] _positions;
+            private readonly byte[] _buffer = new byte[4096];
+
+            public StreamSource(Stream[] streams)
+            {
+                _streams = streams;
+                _positions = new long[streams.Length];
+            }
+
+            public int Read(int image, long offset, IntPtr buffer, int count)
+            {
+                // exceptions mustn't unwind through the native reader
+                try
+                {
+                    Stream stream = _streams[image];
+                    if (stream == null)
+                        return -1;
+
+                    if (stream.CanSeek)
+                        stream.Seek(offset, SeekOrigin.Begin);
+                    else
+                    {
+                        if (offset < _positions[image])
+                            return -1;
+                        while (_positions[image] < offset)
+                        {
+                            int skipped = stream.Read(_buffer, 0, (int)Math.Min(_buffer.Length, offset - _positions[image]));
+                            if (skipped == 0)
+                                return 0;
+                            _positions[image] += skipped;
+                        }
+                    }
+
+                    if (count > _buffer.Length)
+                        count = _buffer.Length;
+                    int read = ReadFully(stream, _buffer, count);
+                    _positions[image] += read;
+                    Marshal.Copy(_buffer, 0, buffer, read);
+                    return read;
+                }
+                catch (IOException e)
+                {
+                    Debug.WriteLine("Failed to read image headers: " + e);
+                    return -1;
+                }
+                catch (Exception e)
+                {
+                    Trace.Fail("Failed to read image headers: " + e);
+                    return -1;
+                }
+            }
+        }
+    }
+}
@@ -196,6 +196,15 @@ public static Stream GetEmbeddedThumbnailStream(string filePath)
 
             using (Stream s = File.OpenRead(filePath))
             {
+                // the headers say whether there's a thumbnail and where, without decoding the image
+                ImageHeader header;
+                if (ImageHeaderReader.TryRead(s, out header))
+                {
+                    byte[] thumbnail = ImageHeaderReader.ReadThumbnail(s, header);
+                    return thumbnail != null ? StreamHelper.AsStream(thumbnail) : null;
+                }
+                s.Seek(0, SeekOrigin.Begin);
+
                 using (Image img = Image.FromStream(s, false, false))
                 {
                     if (!Array.Exists(img.PropertyIdList, propertyId => propertyId == THUMBNAIL))
@@ -418,11 +427,18 @@ static unsafe Bitmap IndexedResize(Bitmap bitmap, int xSize, int ySize, ImageFor
                 return new Bitmap(new MemoryStream(ms.ToArray()));
             }
 
+            private static bool _nativeUnavailable;
+
             //Internal resize for RGB colored images
             static Bitmap RGBResize(Bitmap bitmap, int xSize, int ySize)
             {
                 Rectangle srcRect = new Rectangle(0, 0, bitmap.Width, bitmap.Height);
                 AdjustSizes(bitmap, ref xSize, ref ySize);
+
+                Bitmap resampledBitmap = NativeResize(bitmap, xSize, ySize);
+                if (resampledBitmap != null)
+                    return resampledBitmap;
+
                 Bitmap scaledBitmap = new Bitmap(xSize, ySize, bitmap.PixelFormat);
                 using (Graphics g = Graphics.FromImage(scaledBitmap))
                 {
@@ -447,6 +463,76 @@ static Bitmap RGBResize(Bitmap bitmap, int xSize, int ySize)
                 return scaledBitmap;
             }
 
+            /// <summary>
+            /// Resizes with the bicubic resampler in OpenLiveWriter.Native.dll, which takes
+            /// a fraction of the time GDI+ does on camera-sized pictures. Returns null if
+            /// the DLL isn't there or the pixels have straight alpha, which the resampler
+            /// can't filter.
+            /// </summary>
+            static Bitmap NativeResize(Bitmap bitmap, int xSize, int ySize)
+            {
+                int channels;
+                switch (bitmap.PixelFormat)
+                {
+                    case PixelFormat.Format24bppRgb:
+                        channels = 3;
+                        break;
+                    case PixelFormat.Format32bppRgb:
+                    case PixelFormat.Format32bppPArgb:
+                        channels = 4;
+                        break;
+                    default:
+                        return null;
+                }
+                if (_nativeUnavailable)
+                    return null;
+
+                Bitmap scaledBitmap = new Bitmap(xSize, ySize, bitmap.PixelFormat);
+                bool resampled = false;
+                try
+                {
+                    BitmapData sourceBitmapData = bitmap.LockBits(new Rectangle(0, 0, bitmap.Width, bitmap.Height), ImageLockMode.ReadOnly, bitmap.PixelFormat);
+                    try
+                    {
+                        BitmapData destBitmapData = scaledBitmap.LockBits(new Rectangle(0, 0, xSize, ySize), ImageLockMode.WriteOnly, scaledBitmap.PixelFormat);
+                        try
+                        {
+                            int hr;
+                            using (new QuickTimer("Resize"))
+                                hr = OpenLiveWriterNative.ResampleImage(
+                                    sourceBitmapData.Scan0, sourceBitmapData.Width, sourceBitmapData.Height, sourceBitmapData.Stride,
+                                    destBitmapData.Scan0, destBitmapData.Width, destBitmapData.Height, destBitmapData.Stride,
+                                    channels, OpenLiveWriterNative.IMAGE_RESAMPLE_BICUBIC);
+                            resampled = hr == HRESULT.S_OK;
+                            if (!resampled)
+                                Trace.Fail("ResampleImage failed: 0x" + hr.ToString("X8", CultureInfo.InvariantCulture));
+                        }
+                        finally
+                        {
+                            scaledBitmap.UnlockBits(destBitmapData);
+                        }
+                    }
+                    finally
+                    {
+                        bitmap.UnlockBits(sourceBitmapData);
+                    }
+                }
+                catch (DllNotFoundException)
+                {
+                    _nativeUnavailable = true;
+                }
+                catch (EntryPointNotFoundException)
+                {
+                    _nativeUnavailable = true;
+                }
+                finally
+                {
+                    if (!resampled)
+                        scaledBitmap.Dispose();
+                }
+                return resampled ? scaledBitmap : null;
+            }
+
             private static void DoDrawImage(Graphics g, Bitmap bitmap, Rectangle destRect, Rectangle srcRect)
             {
                 /*
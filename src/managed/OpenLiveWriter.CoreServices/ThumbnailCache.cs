@@ -0,0 +1,195 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+using System;
+using System.Diagnostics;
+using System.Drawing;
+using System.Drawing.Imaging;
+using System.IO;
+using System.Runtime.InteropServices;
+using System.Security.Cryptography;
+using OpenLiveWriter.Interop.Com;
+using OpenLiveWriter.Interop.Windows;
+
+namespace OpenLiveWriter.CoreServices
+{
+    /// <summary>
+    /// A thumbnail cache kept in a memory-mapped file (OpenLiveWriter.Native.dll),
+    /// so that thumbnails made in one session are found in the next without
+    /// decoding their images again. Thumbnails are keyed by the SHA-256 of their
+    /// image's contents and the size they were made to fit; the cache evicts the
+    /// ones least recently used when it fills. It can be used from any thread.
+    /// </summary>
+    public class ThumbnailCache : IDisposable
+    {
+        private const long APPLICATION_CACHE_SIZE = 64 * 1024 * 1024;
+
+        private static bool _nativeUnavailable;
+        private static ThumbnailCache _application;
+        private static bool _applicationOpened;
+        private static readonly object _applicationLock = new object();
+
+        private IntPtr _cache;
+
+        private ThumbnailCache(IntPtr cache)
+        {
+            _cache = cache;
+        }
+
+        /// <summary>
+        /// The application's cache, in its local application data directory, or null
+        /// if it can't be used, as when another instance of the application has it.
+        /// It's closed when the process exits.
+        /// </summary>
+        public static ThumbnailCache Application
+        {
+            get
+            {
+                lock (_applicationLock)
+                {
+                    if (!_applicationOpened)
+                    {
+                        _applicationOpened = true;
+                        if (ApplicationEnvironment.LocalApplicationDataDirectory != null)
+                        {
+                            _application = Open(Path.Combine(ApplicationEnvironment.LocalApplicationDataDirectory, "Thumbnails.cache"), APPLICATION_CACHE_SIZE);
+                            if (_application != null)
+                                AppDomain.CurrentDomain.ProcessExit += delegate { _application.Dispose(); };
+                        }
+                    }
+                    return _application;
+                }
+            }
+        }
+
+        /// <summary>
+        /// Opens the cache of size bytes at path, creating it, or emptying it if it
+        /// wasn't closed properly. Returns null if it can't be used.
+        /// </summary>
+        public static ThumbnailCache Open(string path, long size)
+        {
+            if (_nativeUnavailable)
+                return null;
+
+            try
+            {
+                IntPtr cache;
+                int hr = OpenLiveWriterNative.OpenThumbnailCache(path, size, out cache);
+                if (hr != HRESULT.S_OK)
+                {
+                    Trace.WriteLine("Failed to open thumbnail cache " + path + ": 0x" + hr.ToString("X8"));
+                    return null;
+                }
+                return new ThumbnailCache(cache);
+            }
+            catch (DllNotFoundException)
+            {
+                _nativeUnavailable = true;
+            }
+            catch (EntryPointNotFoundException)
+            {
+                _nativeUnavailable = true;
+            }
+            Trace.WriteLine(OpenLiveWriterNative.DLL_NAME + " is not available, thumbnails won't be cached");
+            return null;
+        }
+
+        /// <summary>
+        /// The SHA-256 of a file's contents, which thumbnails of it are keyed by, or
+        /// null if it can't be read.
+        /// </summary>
+        public static byte[] SafeHashFile(string path)
+        {
+            try
+            {
+                using (Stream stream = new FileStream(path, FileMode.Open, FileAccess.Read, FileShare.ReadWrite, 64 * 1024, FileOptions.SequentialScan))
+                using (HashAlgorithm sha = SHA256.Create())
+                    return sha.ComputeHash(stream);
+            }
+            catch (IOException ex)
+            {
+                Debug.WriteLine("Failed to hash " + path + ": " + ex);
+                return null;
+            }
+            catch (UnauthorizedAccessException ex)
+            {
+                Debug.WriteLine("Failed to hash " + path + ": " + ex);
+                return null;
+            }
+        }
+
+        /// <summary>
+        /// Finds the thumbnail made to fit requestedSize of the image whose SHA-256 is
+        /// hash, returning null if there is none.
+        /// </summary>
+        public Bitmap Find(byte[] hash, Size requestedSize)
+        {
+            if (_cache == IntPtr.Zero)
+                return null;
+
+            byte[] pixels = new byte[requestedSize.Width * requestedSize.Height * 4];
+            int width, height;
+            GCHandle pinned = GCHandle.Alloc(pixels, GCHandleType.Pinned);
+            try
+            {
+                int hr = OpenLiveWriterNative.FindThumbnail(_cache, hash, requestedSize.Width, requestedSize.Height, out width, out height, pinned.AddrOfPinnedObject());
+                if (hr != HRESULT.S_OK)
+                {
+                    if (hr != HRESULT.S_FALSE)
+                        Trace.Fail("FindThumbnail failed: 0x" + hr.ToString("X8"));
+                    return null;
+                }
+            }
+            finally
+            {
+                pinned.Free();
+            }
+
+            // the rows of 32 bit bitmaps are packed too
+            Bitmap thumbnail = new Bitmap(width, height, PixelFormat.Format32bppArgb);
+            BitmapData data = thumbnail.LockBits(new Rectangle(0, 0, width, height), ImageLockMode.WriteOnly, PixelFormat.Format32bppArgb);
+            try
+            {
+                Marshal.Copy(pixels, 0, data.Scan0, width * height * 4);
+            }
+            finally
+            {
+                thumbnail.UnlockBits(data);
+            }
+            return thumbnail;
+        }
+
+        /// <summary>
+        /// Stores a thumbnail, made to fit requestedSize, of the image whose SHA-256 is
+        /// hash. Returns false if it isn't kept, as when it's larger than requestedSize
+        /// or than the cache keeps.
+        /// </summary>
+        public bool Store(byte[] hash, Size requestedSize, Bitmap thumbnail)
+        {
+            if (_cache == IntPtr.Zero || thumbnail.Width > requestedSize.Width || thumbnail.Height > requestedSize.Height)
+                return false;
+
+            BitmapData data = thumbnail.LockBits(new Rectangle(Point.Empty, thumbnail.Size), ImageLockMode.ReadOnly, PixelFormat.Format32bppArgb);
+            try
+            {
+                int hr = OpenLiveWriterNative.StoreThumbnail(_cache, hash, requestedSize.Width, requestedSize.Height, data.Width, data.Height, data.Scan0, data.Stride);
+                if (hr != HRESULT.S_OK && hr != HRESULT.S_FALSE)
+                    Trace.Fail("StoreThumbnail failed: 0x" + hr.ToString("X8"));
+                return hr == HRESULT.S_OK;
+            }
+            finally
+            {
+                thumbnail.UnlockBits(data);
+            }
+        }
+
+        public void Dispose()
+        {
+            if (_cache != IntPtr.Zero)
+            {
+                OpenLiveWriterNative.CloseThumbnailCache(_cache);
+                _cache = IntPtr.Zero;
+            }
+        }
+    }
+}
@@ -10,9 +10,15 @@
 using System.Text;
 using System.Xml;
 using OpenLiveWriter.CoreServices.Diagnostics;
+using OpenLiveWriter.Interop.Com;
+using OpenLiveWriter.Interop.Windows;
 
 namespace OpenLiveWriter.CoreServices
 {
+    /// <summary>
+    /// Makes a new request, passes it to filter, sends it and returns the response.
+    /// </summary>
+    public delegate HttpWebResponse XmlRpcRequestSender(HttpRequestFilter filter);
 
     public class XmlRpcClient
     {
@@ -50,9 +56,6 @@ public XmlRpcMethodResponse CallMethod(string methodName, params XmlRpcValue[] p
             //select the encoding
             Encoding encodingToUse = StringHelper.GetEncoding(_transportEncoding, new UTF8Encoding(false, false));
 
-            // build the XmlRpc packet
-            byte[] requestBytes = GetRequestBytes(encodingToUse, methodName, parameters, false);
-
             if (ApplicationDiagnostics.VerboseLogging)
             {
                 LogXmlRpcRequest(encodingToUse, methodName, parameters);
@@ -62,16 +65,18 @@ public XmlRpcMethodResponse CallMethod(string methodName, params XmlRpcValue[] p
             HttpWebResponse response;
             try
             {
-                response = HttpRequestHelper.SendRequest(_hostname, delegate (HttpWebRequest request)
+                response = SendRequest(delegate (HttpRequestFilter filter)
+                {
+                    return HttpRequestHelper.SendRequest(_hostname, filter);
+                },
+                delegate (HttpWebRequest request)
                 {
                     request.Method = "POST";
                     request.AllowAutoRedirect = false;
                     request.ContentType = String.Format(CultureInfo.InvariantCulture, "{0};charset={1}", MimeHelper.TEXT_XML, encodingToUse.WebName);
                     if (_requestFilter != null)
                         _requestFilter(request);
-                    using (Stream requestStream = request.GetRequestStream())
-                        StreamHelper.Transfer(new MemoryStream(requestBytes), requestStream);
-                });
+                }, encodingToUse, methodName, parameters);
             }
             catch
             {
@@ -181,19 +186,98 @@ private void LogXmlRpcResponse(string xmlRpcString)
             Trace.WriteLine("XML-RPC response:\r\n" + _hostname + "\r\n" + xmlRpcString);
         }
 
+        /// <summary>
+        /// Sends an XML-RPC request for methodName through send, with filter applied
+        /// to the request first. A large request goes out unbuffered, and so can't be
+        /// sent again by HttpWebRequest itself when the server asks for credentials;
+        /// if that happens, it is sent once more, buffered.
+        /// </summary>
+        public static HttpWebResponse SendRequest(XmlRpcRequestSender send, HttpRequestFilter filter, Encoding encoding, string methodName, params XmlRpcValue[] parameters)
+        {
+            bool unbuffered = false;
+            bool hasCredentials = false;
+            try
+            {
+                return send(delegate (HttpWebRequest request)
+                {
+                    if (filter != null)
+                        filter(request);
+                    hasCredentials = request.Credentials != null;
+                    unbuffered = WriteRequest(request, encoding, methodName, parameters, true);
+                });
+            }
+            catch (WebException e)
+            {
+                if (!unbuffered || !hasCredentials || !IsAuthenticationChallenge(e))
+                    throw;
+                if (e.Response != null)
+                    e.Response.Close();
+                Trace.WriteLine("Sending XML-RPC request " + methodName + " again, buffered, after an authentication challenge: " + e.Message);
+            }
+
+            return send(delegate (HttpWebRequest request)
+            {
+                if (filter != null)
+                    filter(request);
+                WriteRequest(request, encoding, methodName, parameters, false);
+            });
+        }
+
+        private static bool IsAuthenticationChallenge(WebException e)
+        {
+            HttpWebResponse response = e.Response as HttpWebResponse;
+            if (response == null)
+                return e.Status == WebExceptionStatus.ProtocolError;
+            return response.StatusCode == HttpStatusCode.Unauthorized || response.StatusCode == HttpStatusCode.ProxyAuthenticationRequired;
+        }
+
+        /// <summary>
+        /// Writes an XML-RPC request for methodName to request's stream as it is
+        /// produced. Its length is measured first, without reading the contents of
+        /// streamed base64 values, so that large requests can go out unbuffered
+        /// instead of being held in memory to find it out.
+        /// </summary>
+        public static void WriteRequest(HttpWebRequest request, Encoding encoding, string methodName, params XmlRpcValue[] parameters)
+        {
+            WriteRequest(request, encoding, methodName, parameters, true);
+        }
+
+        /// <summary>
+        /// Returns true if the request went out unbuffered.
+        /// </summary>
+        private static bool WriteRequest(HttpWebRequest request, Encoding encoding, string methodName, XmlRpcValue[] parameters, bool allowUnbuffered)
+        {
+            CountingStream counter = new CountingStream();
+            WriteRequest(counter, encoding, methodName, parameters, false);
+            request.ContentLength = counter.Length;
+
+            // small requests stay buffered so that they can be resent after an
+            // authentication challenge; large ones send Basic credentials up front
+            // once the server has asked for them
+            bool unbuffered = allowUnbuffered && counter.Length > UNBUFFERED_REQUEST_SIZE;
+            if (unbuffered)
+            {
+                request.AllowWriteStreamBuffering = false;
+                request.PreAuthenticate = true;
+            }
+
+            using (Stream requestStream = request.GetRequestStream())
+                WriteRequest(requestStream, encoding, methodName, parameters, false);
+            return unbuffered;
+        }
+
+        private const long UNBUFFERED_REQUEST_SIZE = 256 * 1024;
+
         private static byte[] GetRequestBytes(Encoding encoding, string methodName, XmlRpcValue[] parameters, bool logging)
         {
             MemoryStream request = new MemoryStream();
-            XmlTextWriter writer = new XmlTextWriter(request, encoding);
+            WriteRequest(request, encoding, methodName, parameters, logging);
+            return request.ToArray();
+        }
 
-            // Amazingly, some configs of WordPress complain
-            // about malformed XML when uploading large posts/images (greater than
-            // 100,000 bytes) if we don't indent. More precisely, there needs to be
-            // fewer than 100,000 bytes before the first line break. Let's just
-            // indent and be done with it.
-            writer.Formatting = Formatting.Indented;
-            writer.Indentation = 1;
-            writer.IndentChar = ' ';
+        private static void WriteRequest(Stream request, Encoding encoding, string methodName, XmlRpcValue[] parameters, bool logging)
+        {
+            XmlRpcRequestWriter writer = new XmlRpcRequestWriter(request, encoding);
 
             writer.WriteStartDocument();
             using (new WriteXmlElement(writer, "methodCall"))
@@ -212,8 +296,6 @@ private static byte[] GetRequestBytes(Encoding encoding, string methodName, XmlR
             }
             writer.WriteEndDocument();
             writer.Flush();
-
-            return request.ToArray();
         }
 
         //private Encoding _utf8EncodingNoBOM = new UTF8Encoding(false) ;
@@ -288,15 +370,39 @@ public XmlRpcBase64(byte[] bytes)
         {
         }
 
+        /// <summary>
+        /// The rest of contents, from where it is now, read a block at a time each time
+        /// the request is written rather than all at once. Contents that can't seek
+        /// are read into memory here.
+        /// </summary>
+        public XmlRpcBase64(Stream contents)
+            : base(contents.CanSeek ? contents : StreamHelper.CopyToMemoryStream(contents))
+        {
+            _start = contents.CanSeek ? contents.Position : 0;
+        }
+
+        private readonly long _start;
+
         protected override void WriteValue(XmlWriter writer, object value, bool logging)
         {
-            byte[] bytes = (byte[])value;
+            byte[] bytes = value as byte[];
+            Stream contents = value as Stream;
+            long length = bytes != null ? bytes.Length : contents.Length - _start;
             using (new WriteXmlElement(writer, "base64"))
             {
-                if (!logging)
+                if (logging)
+                    writer.WriteString(string.Format(CultureInfo.InvariantCulture, "[{0} bytes]", length));
+                else if (bytes != null)
                     writer.WriteBase64(bytes, 0, bytes.Length);
                 else
-                    writer.WriteString(string.Format(CultureInfo.InvariantCulture, "[{0} bytes]", bytes.Length));
+                {
+                    contents.Position = _start;
+                    XmlRpcRequestWriter requestWriter = writer as XmlRpcRequestWriter;
+                    if (requestWriter != null)
+                        requestWriter.WriteBase64(contents, length);
+                    else
+                        XmlRpcRequestWriter.WriteBase64(writer, contents, length);
+                }
             }
         }
 
@@ -565,6 +671,198 @@ public XmlRpcClientInvalidResponseException(string response, Exception innerExce
         public readonly string Response;
     }
 
+    /// <summary>
+    /// Writes XML-RPC requests. Base64 values streamed from a file are written past
+    /// the XmlTextWriter, straight to the stream under it, a block at a time as
+    /// OpenLiveWriter.Native.dll's SIMD encoder
+    /// (src\unmanaged\OpenLiveWriter.CppUtils\Include\Base64Encoder.h) encodes them,
+    /// so that neither the file nor its encoding is ever held in memory. That takes
+    /// an encoding in which the base64 characters are the ASCII bytes; with any other
+    /// the XmlTextWriter encodes the blocks itself.
+    /// </summary>
+    internal class XmlRpcRequestWriter : XmlTextWriter
+    {
+        // a multiple of 3, so that every block but the last encodes without padding
+        private const int BLOCK_SIZE = 48 * 1024;
+
+        private const string BASE64_CHARACTERS = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/=";
+
+        private static bool _nativeUnavailable;
+
+        private readonly Stream _stream;
+        private readonly bool _asciiBase64;
+
+        public XmlRpcRequestWriter(Stream stream, Encoding encoding)
+            : base(stream, encoding)
+        {
+            _stream = stream;
+            _asciiBase64 = ArrayHelper.CompareBytes(encoding.GetBytes(BASE64_CHARACTERS), Encoding.ASCII.GetBytes(BASE64_CHARACTERS));
+
+            // Amazingly, some configs of WordPress complain
+            // about malformed XML when uploading large posts/images (greater than
+            // 100,000 bytes) if we don't indent. More precisely, there needs to be
+            // fewer than 100,000 bytes before the first line break. Let's just
+            // indent and be done with it.
+            Formatting = Formatting.Indented;
+            Indentation = 1;
+            IndentChar = ' ';
+        }
+
+        /// <summary>
+        /// Writes the next length bytes of contents as base64.
+        /// </summary>
+        public void WriteBase64(Stream contents, long length)
+        {
+            if (!_asciiBase64)
+            {
+                WriteBase64(this, contents, length);
+                return;
+            }
+
+            // close the start tag and catch the stream up with what has been written so far
+            WriteRaw(String.Empty);
+            Flush();
+
+            // measuring the request
+            CountingStream counter = _stream as CountingStream;
+            if (counter != null)
+            {
+                counter.Skip((length + 2) / 3 * 4);
+                return;
+            }
+
+            byte[] block = new byte[BLOCK_SIZE];
+            byte[] encoded = new byte[BLOCK_SIZE / 3 * 4];
+            char[] characters = null;
+            while (length > 0)
+            {
+                int count = ReadBlock(contents, block, (int)Math.Min(length, BLOCK_SIZE));
+                int encodedLength = Encode(block, count, encoded, ref characters);
+                _stream.Write(encoded, 0, encodedLength);
+                length -= count;
+            }
+        }
+
+        /// <summary>
+        /// Writes the next length bytes of contents as base64 through any XmlWriter.
+        /// </summary>
+        public static void WriteBase64(XmlWriter writer, Stream contents, long length)
+        {
+            byte[] block = new byte[BLOCK_SIZE];
+            while (length > 0)
+            {
+                int count = ReadBlock(contents, block, (int)Math.Min(length, BLOCK_SIZE));
+                writer.WriteBase64(block, 0, count);
+                length -= count;
+            }
+        }
+
+        private static int ReadBlock(Stream contents, byte[] block, int count)
+        {
+            // blocks but the last have to be whole for the encoding to run on
+            int read = 0;
+            while (read < count)
+            {
+                int readNow = contents.Read(block, read, count - read);
+                if (readNow == 0)
+                    throw new EndOfStreamException("The contents of an XML-RPC base64 value ended early");
+                read += readNow;
+            }
+            return read;
+        }
+
+        private static int Encode(byte[] block, int count, byte[] encoded, ref char[] characters)
+        {
+            if (!_nativeUnavailable)
+            {
+                try
+                {
+                    int encodedLength;
+                    int hr = OpenLiveWriterNative.EncodeBase64(block, count, encoded, encoded.Length, out encodedLength);
+                    if (hr == HRESULT.S_OK)
+                        return encodedLength;
+                    Trace.Fail("EncodeBase64 failed: 0x" + hr.ToString("X8", CultureInfo.InvariantCulture));
+                }
+                catch (DllNotFoundException)
+                {
+                    _nativeUnavailable = true;
+                }
+                catch (EntryPointNotFoundException)
+                {
+                    _nativeUnavailable = true;
+                }
+            }
+
+            if (characters == null)
+                characters = new char[encoded.Length];
+            int length = Convert.ToBase64CharArray(block, 0, count, characters, 0);
+            return Encoding.ASCII.GetBytes(characters, 0, length, encoded, 0);
+        }
+    }
+
+    /// <summary>
+    /// A stream that only counts what is written to it.
+    /// </summary>
+    internal class CountingStream : Stream
+    {
+        private long _length;
+
+        public void Skip(long count)
+        {
+            _length += count;
+        }
+
+        public override void Write(byte[] buffer, int offset, int count)
+        {
+            _length += count;
+        }
+
+        public override long Length
+        {
+            get { return _length; }
+        }
+
+        public override bool CanRead
+        {
+            get { return false; }
+        }
+
+        public override bool CanSeek
+        {
+            get { return false; }
+        }
+
+        public override bool CanWrite
+        {
+            get { return true; }
+        }
+
+        public override void Flush()
+        {
+        }
+
+        public override long Position
+        {
+            get { return _length; }
+            set { throw new NotSupportedException(); }
+        }
+
+        public override int Read(byte[] buffer, int offset, int count)
+        {
+            throw new NotSupportedException();
+        }
+
+        public override long Seek(long offset, SeekOrigin origin)
+        {
+            throw new NotSupportedException();
+        }
+
+        public override void SetLength(long value)
+        {
+            throw new NotSupportedException();
+        }
+    }
+
     /// <summary>
     /// Utility class used to write elements
     /// </summary>
@@ -0,0 +1,175 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+using System;
+using System.Diagnostics;
+using System.Globalization;
+using System.Runtime.InteropServices;
+
+namespace OpenLiveWriter.HtmlParser.Parser
+{
+    /// <summary>
+    /// Walks the tokens of an HTML string as OpenLiveWriter.Native.dll's HtmlTokenizer
+    /// (src\unmanaged\OpenLiveWriter.CppUtils\Include\HtmlTokenizer.h) finds them. The
+    /// string is pinned rather than copied for each call, and tokens come back as spans
+    /// into it, a few hundred at a time, in arrays that are reused for the whole string.
+    ///
+    /// This assembly doesn't reference OpenLiveWriter.Interop, so the import is here.
+    /// </summary>
+    internal class NativeHtmlTokenizer
+    {
+        private const string DLL_NAME = "OpenLiveWriter.Native.dll";
+
+        public const int TEXT = 0;
+        public const int COMMENT = 1;
+        public const int DIRECTIVE = 2;
+        public const int BEGIN_TAG = 3;
+        public const int END_TAG = 4;
+        public const int SCRIPT_BODY = 5;
+        public const int STYLE_BODY = 6;
+
+        public const int COMPLETE = 1;
+
+        private const int S_OK = 0;
+        private const int S_FALSE = 1;
+        private const int ERROR_INSUFFICIENT_BUFFER = unchecked((int)0x8007007A);
+
+        private const int MAX_TOKENS = 512;
+
+        [StructLayout(LayoutKind.Sequential)]
+        public struct Token
+        {
+            public int Kind;
+            public int Start;
+            public int Length;
+            public int NameStart;
+            public int NameLength;
+            public int FirstAttribute;
+            public int AttributeCount;
+            public int ResidueStart;
+            public int ResidueLength;
+            public int Flags;
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        public struct Attribute
+        {
+            public int NameStart;
+            public int NameLength;
+            public int ValueStart;
+            public int ValueLength;
+            public int Quote;
+        }
+
+        [DllImport(DLL_NAME, CharSet = CharSet.Unicode, ExactSpelling = true)]
+        private static extern int TokenizeHtml(
+            string html,
+            int htmlLength,
+            ref int position,
+            [Out] Token[] tokens,
+            int tokenCapacity,
+            out int tokenCount,
+            [Out] Attribute[] attributes,
+            int attributeCapacity,
+            out int attributeCount
+            );
+
+        private static bool nativeUnavailable;
+
+        private readonly string data;
+        private int position;
+        private bool done;
+
+        private readonly Token[] tokens;
+        private int tokenCount;
+        private int tokenIndex = -1;
+        private Attribute[] attributes;
+
+        private bool unavailable;
+
+        public NativeHtmlTokenizer(string data)
+        {
+            this.data = data;
+
+            // a token for every 16 characters is plenty for most HTML
+            tokens = new Token[Math.Min(MAX_TOKENS, data.Length / 16 + 4)];
+            attributes = new Attribute[tokens.Length * 2];
+        }
+
+        /// <summary>
+        /// False once OpenLiveWriter.Native.dll turned out to be missing.
+        /// </summary>
+        public static bool IsAvailable
+        {
+            get { return !nativeUnavailable; }
+        }
+
+        /// <summary>
+        /// True if Read returned false because OpenLiveWriter.Native.dll is missing
+        /// rather than because the end was reached.
+        /// </summary>
+        public bool Unavailable
+        {
+            get { return unavailable; }
+        }
+
+        /// <summary>
+        /// Moves to the next token, returning false at the end of the HTML.
+        /// </summary>
+        public bool Read()
+        {
+            if (++tokenIndex < tokenCount)
+                return true;
+            if (done || unavailable)
+                return false;
+
+            Fill();
+            tokenIndex = 0;
+            return tokenCount > 0;
+        }
+
+        public Token Current
+        {
+            get { return tokens[tokenIndex]; }
+        }
+
+        public Attribute GetAttribute(int index)
+        {
+            return attributes[index];
+        }
+
+        private void Fill()
+        {
+            tokenCount = 0;
+            try
+            {
+                while (true)
+                {
+                    int attributeCount;
+                    int hr = TokenizeHtml(data, data.Length, ref position, tokens, tokens.Length, out tokenCount, attributes, attributes.Length, out attributeCount);
+                    if (hr == S_OK)
+                        done = true;
+                    else if (hr == ERROR_INSUFFICIENT_BUFFER)
+                    {
+                        // one tag with more attributes than there's room for
+                        attributes = new Attribute[attributes.Length * 2];
+                        continue;
+                    }
+                    else if (hr != S_FALSE)
+                        throw new InvalidOperationException("TokenizeHtml failed: 0x" + hr.ToString("X8", CultureInfo.InvariantCulture));
+                    return;
+                }
+            }
+            catch (DllNotFoundException)
+            {
+                nativeUnavailable = true;
+            }
+            catch (EntryPointNotFoundException)
+            {
+                nativeUnavailable = true;
+            }
+            Trace.WriteLine(DLL_NAME + " is not available, falling back to the managed HTML parser");
+            unavailable = true;
+        }
+    }
+}
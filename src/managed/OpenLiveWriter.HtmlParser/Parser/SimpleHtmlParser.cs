@@ -40,20 +40,39 @@ public class SimpleHtmlParser : IElementSource
         private static readonly Regex endBeginTag = new Regex(@"\s*(/)?>", RegexOptions.Compiled);
         private static readonly Regex end = new Regex(@"</([a-z][a-z0-9\.\-_:]*)\s*>", RegexOptions.Compiled | RegexOptions.IgnoreCase);
 
-        private readonly StatefulMatcher commentMatcher;
-        private readonly StatefulMatcher directiveMatcher;
-        private readonly StatefulMatcher beginMatcher;
-        private readonly StatefulMatcher attrNameMatcher;
-        private readonly StatefulMatcher quotedAttrValueMatcher;
-        private readonly StatefulMatcher unquotedAttrValueMatcher;
-        private readonly StatefulMatcher endBeginTagMatcher;
-        private readonly StatefulMatcher endMatcher;
+        // only created once the managed tokenizer is needed (see CreateMatchers)
+        private StatefulMatcher commentMatcher;
+        private StatefulMatcher directiveMatcher;
+        private StatefulMatcher beginMatcher;
+        private StatefulMatcher attrNameMatcher;
+        private StatefulMatcher quotedAttrValueMatcher;
+        private StatefulMatcher unquotedAttrValueMatcher;
+        private StatefulMatcher endBeginTagMatcher;
+        private StatefulMatcher endMatcher;
+
+        // below this, creating the matchers costs less than a call into the native tokenizer
+        private const int NATIVE_TOKENIZER_MIN_LENGTH = 512;
+
+        private NativeHtmlTokenizer tokenizer;
+
+        /// <param name="data">The HTML string.</param>
+        public SimpleHtmlParser(string data) : this(data, data.Length >= NATIVE_TOKENIZER_MIN_LENGTH)
+        {
+        }
 
         /// <param name="data">The HTML string.</param>
-        public SimpleHtmlParser(string data)
+        /// <param name="useNativeTokenizer">Whether to tokenize with OpenLiveWriter.Native.dll
+        /// when it's available. Either way the elements are the same.</param>
+        public SimpleHtmlParser(string data, bool useNativeTokenizer)
         {
             this.data = data;
 
+            if (useNativeTokenizer && NativeHtmlTokenizer.IsAvailable)
+                tokenizer = new NativeHtmlTokenizer(data);
+        }
+
+        private void CreateMatchers()
+        {
             commentMatcher = new StatefulMatcher(data, comment);
             directiveMatcher = new StatefulMatcher(data, directive);
             beginMatcher = new StatefulMatcher(data, begin);
@@ -111,6 +130,16 @@ private Element Next(bool allowPeekElement)
                 return elementStack.Pop();
             }
 
+            if (tokenizer != null)
+            {
+                Element element;
+                if (NextToken(out element))
+                    return element;
+
+                // no native tokenizer after all; nothing has been read yet
+                tokenizer = null;
+            }
+
             int dataLen = data.Length;
             if (dataLen == pos)
             {
@@ -119,6 +148,9 @@ private Element Next(bool allowPeekElement)
                 return null;
             }
 
+            if (commentMatcher == null)
+                CreateMatchers();
+
             // None of the special cases are true.  Start consuming characters
 
             int tokenStart = pos;
@@ -193,6 +225,77 @@ private Element Next(bool allowPeekElement)
             }
         }
 
+        /// <summary>
+        /// Makes the element for the native tokenizer's next token. Returns false,
+        /// having read nothing, if OpenLiveWriter.Native.dll is not available.
+        /// </summary>
+        private bool NextToken(out Element element)
+        {
+            while (true)
+            {
+                if (!tokenizer.Read())
+                {
+                    element = null;
+                    if (tokenizer.Unavailable)
+                        return false;
+                    pos = data.Length;
+                    return true;
+                }
+
+                NativeHtmlTokenizer.Token token = tokenizer.Current;
+                pos = token.Start + token.Length;
+                switch (token.Kind)
+                {
+                    case NativeHtmlTokenizer.TEXT:
+                        element = new Text(data, token.Start, token.Length);
+                        return true;
+                    case NativeHtmlTokenizer.COMMENT:
+                        element = new Comment(data, token.Start, token.Length);
+                        return true;
+                    case NativeHtmlTokenizer.DIRECTIVE:
+                        element = new MarkupDirective(data, token.Start, token.Length);
+                        return true;
+                    case NativeHtmlTokenizer.END_TAG:
+                        element = new EndTag(data, token.Start, token.Length, data.Substring(token.NameStart, token.NameLength));
+                        return true;
+                    case NativeHtmlTokenizer.BEGIN_TAG:
+                        element = CreateBeginTag(token);
+                        return true;
+                    default:
+                        // the body of a <script> or <style>
+                        PushStructuredText(token.Kind == NativeHtmlTokenizer.SCRIPT_BODY
+                            ? (IElementSource)new JavascriptParser(data, token.Start, token.Length)
+                            : (IElementSource)new CssParser(data, token.Start, token.Length));
+                        if (elementStack.Count != 0)
+                        {
+                            element = elementStack.Pop();
+                            return true;
+                        }
+                        break;
+                }
+            }
+        }
+
+        private BeginTag CreateBeginTag(NativeHtmlTokenizer.Token token)
+        {
+            Attr[] attributes = null;
+            if (token.AttributeCount != 0)
+            {
+                attributes = new Attr[token.AttributeCount];
+                for (int i = 0; i < attributes.Length; i++)
+                {
+                    NativeHtmlTokenizer.Attribute attribute = tokenizer.GetAttribute(token.FirstAttribute + i);
+                    LazySubstring attrName = new LazySubstring(data, attribute.NameStart, attribute.NameLength);
+                    LazySubstring attrValue = attribute.ValueStart < 0 ? null : new LazySubstring(data, attribute.ValueStart, attribute.ValueLength);
+                    attributes[i] = new Attr(attrName, attrValue);
+                }
+            }
+
+            LazySubstring extraResidue = token.ResidueStart < 0 ? null : new LazySubstring(data, token.ResidueStart, token.ResidueLength);
+            return new BeginTag(data, token.Start, token.Length, data.Substring(token.NameStart, token.NameLength), attributes,
+                (token.Flags & NativeHtmlTokenizer.COMPLETE) != 0, extraResidue);
+        }
+
         /// <summary>
         /// Collects text between the current parsing position and
         /// the matching endTagName.  (Nested instances of the tag
@@ -419,9 +522,15 @@ private int ConsumeStructuredText(string data, int offset, Regex stopAt)
 
             // HACK: this code should not be aware of parser types
             IElementSource source = (stopAt == endScript) ? (IElementSource)new JavascriptParser(data, offset, end - offset) : (IElementSource)new CssParser(data, offset, end - offset);
+            PushStructuredText(source);
+
+            return end - offset;
+        }
+
+        private void PushStructuredText(IElementSource source)
+        {
             Stack stack = new Stack();
             Element element;
-            int last = pos;
             while (null != (element = source.Next()))
             {
                 stack.Push(element);
@@ -430,8 +539,6 @@ private int ConsumeStructuredText(string data, int offset, Regex stopAt)
             {
                 elementStack.Push(el);
             }
-
-            return end - offset;
         }
 
         private class StatefulMatcher
@@ -0,0 +1,279 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+using System;
+using System.Runtime.InteropServices;
+
+namespace OpenLiveWriter.Interop.Windows
+{
+    /// <summary>
+    /// Imports from OpenLiveWriter.Native.dll (src\unmanaged\OpenLiveWriter.Native).
+    /// Memory returned by these functions is freed with Marshal.FreeCoTaskMem.
+    /// </summary>
+    public class OpenLiveWriterNative
+    {
+        public const string DLL_NAME = "OpenLiveWriter.Native.dll";
+
+        /// <summary>
+        /// Replaces the references in html that are in from with the references at
+        /// the same index in to. Returns S_FALSE and IntPtr.Zero if nothing was replaced.
+        /// </summary>
+        [DllImport(DLL_NAME, CharSet = CharSet.Unicode, ExactSpelling = true)]
+        public static extern int RewriteHtmlReferences(
+            string html,
+            int htmlLength,
+            [MarshalAs(UnmanagedType.LPArray, ArraySubType = UnmanagedType.LPWStr)] string[] from,
+            [MarshalAs(UnmanagedType.LPArray, ArraySubType = UnmanagedType.LPWStr)] string[] to,
+            int mappingCount,
+            out IntPtr result,
+            out int resultLength
+            );
+
+        /// <summary>
+        /// Maps a compiled spelling dictionary into memory. The handle is released with
+        /// CloseSpellingDictionary.
+        /// </summary>
+        [DllImport(DLL_NAME, CharSet = CharSet.Unicode, ExactSpelling = true)]
+        public static extern int OpenSpellingDictionary(string path, out IntPtr dictionary);
+
+        [DllImport(DLL_NAME, ExactSpelling = true)]
+        public static extern void CloseSpellingDictionary(IntPtr dictionary);
+
+        /// <summary>
+        /// Checks the words at starts/lengths in text, writing a SpellCheckResult
+        /// (Correct, Capitalization or Misspelled) for each to results.
+        /// </summary>
+        [DllImport(DLL_NAME, CharSet = CharSet.Unicode, ExactSpelling = true)]
+        public static extern int CheckSpelling(
+            IntPtr dictionary,
+            string text,
+            int textLength,
+            int[] starts,
+            int[] lengths,
+            int count,
+            [Out] byte[] results
+            );
+
+        /// <summary>
+        /// Finds up to maxSuggestions words close to word, closest first, separated by
+        /// null characters. Returns S_FALSE and IntPtr.Zero if there are none.
+        /// </summary>
+        [DllImport(DLL_NAME, CharSet = CharSet.Unicode, ExactSpelling = true)]
+        public static extern int SuggestSpelling(
+            IntPtr dictionary,
+            string word,
+            int length,
+            int maxSuggestions,
+            out IntPtr result,
+            out int resultLength
+            );
+
+        public const int IMAGE_RESAMPLE_BOX = 0;
+        public const int IMAGE_RESAMPLE_BICUBIC = 1;
+        public const int IMAGE_RESAMPLE_LANCZOS = 2;
+
+        /// <summary>
+        /// Resizes the pixels of one locked bitmap into another, channels (3 for BGR,
+        /// 4 for BGRA) bytes per pixel, with one of the IMAGE_RESAMPLE_ filters.
+        /// </summary>
+        [DllImport(DLL_NAME, ExactSpelling = true)]
+        public static extern int ResampleImage(
+            IntPtr source,
+            int sourceWidth,
+            int sourceHeight,
+            int sourceStride,
+            IntPtr destination,
+            int destinationWidth,
+            int destinationHeight,
+            int destinationStride,
+            int channels,
+            int filter
+            );
+
+        /// <summary>
+        /// Encodes sourceLength bytes as base64 characters, one byte each, into
+        /// destination, which has room for (sourceLength + 2) / 3 * 4 of them.
+        /// </summary>
+        [DllImport(DLL_NAME, ExactSpelling = true)]
+        public static extern int EncodeBase64(
+            byte[] source,
+            int sourceLength,
+            [Out] byte[] destination,
+            int destinationCapacity,
+            out int destinationLength
+            );
+
+        /// <summary>
+        /// What ReadImageHeaders read of an image's headers; format is one of the
+        /// IMAGE_HEADER_ constants.
+        /// </summary>
+        [StructLayout(LayoutKind.Sequential)]
+        public struct ImageHeader
+        {
+            public int format;
+            public int width;
+            public int height;
+            public int orientation;
+            public long thumbnailOffset;
+            public int thumbnailLength;
+            public int bytesRead;
+        }
+
+        public const int IMAGE_HEADER_UNKNOWN = 0;
+        public const int IMAGE_HEADER_JPEG = 1;
+        public const int IMAGE_HEADER_PNG = 2;
+        public const int IMAGE_HEADER_GIF = 3;
+        public const int IMAGE_HEADER_BMP = 4;
+        public const int IMAGE_HEADER_WEBP = 5;
+
+        /// <summary>
+        /// Reads up to count bytes of image at offset into buffer, returning how many
+        /// there were, or -1 if they couldn't be read. Mustn't throw.
+        /// </summary>
+        [UnmanagedFunctionPointer(CallingConvention.StdCall)]
+        public delegate int ImageHeaderReadCallback(int image, long offset, IntPtr buffer, int count);
+
+        /// <summary>
+        /// Reads the headers of count images, each through read a few KB at a time,
+        /// into headers.
+        /// </summary>
+        [DllImport(DLL_NAME, ExactSpelling = true)]
+        public static extern int ReadImageHeaders(
+            int count,
+            ImageHeaderReadCallback read,
+            [Out] ImageHeader[] headers
+            );
+
+        /// <summary>
+        /// Maps the thumbnail cache file at path into memory, creating or emptying it
+        /// as needed. The handle is released with CloseThumbnailCache.
+        /// </summary>
+        [DllImport(DLL_NAME, CharSet = CharSet.Unicode, ExactSpelling = true)]
+        public static extern int OpenThumbnailCache(string path, long size, out IntPtr cache);
+
+        [DllImport(DLL_NAME, ExactSpelling = true)]
+        public static extern void CloseThumbnailCache(IntPtr cache);
+
+        /// <summary>
+        /// Finds the thumbnail made at requestedWidth x requestedHeight of the image
+        /// whose SHA-256 is hash, copying its packed BGRA pixels to pixels. Returns
+        /// S_FALSE if there is none.
+        /// </summary>
+        [DllImport(DLL_NAME, ExactSpelling = true)]
+        public static extern int FindThumbnail(
+            IntPtr cache,
+            byte[] hash,
+            int requestedWidth,
+            int requestedHeight,
+            out int width,
+            out int height,
+            IntPtr pixels
+            );
+
+        /// <summary>
+        /// Stores a thumbnail of width x height BGRA pixels, stride bytes apart, made at
+        /// requestedWidth x requestedHeight of the image whose SHA-256 is hash. Returns
+        /// S_FALSE if it's too large to keep.
+        /// </summary>
+        [DllImport(DLL_NAME, ExactSpelling = true)]
+        public static extern int StoreThumbnail(
+            IntPtr cache,
+            byte[] hash,
+            int requestedWidth,
+            int requestedHeight,
+            int width,
+            int height,
+            IntPtr pixels,
+            int stride
+            );
+
+        /// <summary>
+        /// A span of the old HTML that DiffHtml found replaced by a span of the new.
+        /// </summary>
+        [StructLayout(LayoutKind.Sequential)]
+        public struct HtmlDiffHunk
+        {
+            public int oldStart;
+            public int oldLength;
+            public int newStart;
+            public int newLength;
+        }
+
+        public const int HTML_DIFF_IGNORE_FORMATTING = 1;
+
+        /// <summary>
+        /// Finds the changes that turn oldHtml into newHtml as hunkCount HtmlDiffHunks,
+        /// which are freed with Marshal.FreeCoTaskMem. Returns S_FALSE if more than
+        /// maxDifferences tokens differ.
+        /// </summary>
+        [DllImport(DLL_NAME, CharSet = CharSet.Unicode, ExactSpelling = true)]
+        public static extern int DiffHtml(
+            string oldHtml,
+            int oldLength,
+            string newHtml,
+            int newLength,
+            int flags,
+            int maxDifferences,
+            out IntPtr hunks,
+            out int hunkCount
+            );
+
+        /// <summary>
+        /// Computes a signature of html that is the same for HTML DiffHtml finds no
+        /// changes in.
+        /// </summary>
+        [DllImport(DLL_NAME, CharSet = CharSet.Unicode, ExactSpelling = true)]
+        public static extern int GetHtmlSignature(string html, int length, int flags, out long signature);
+
+        /// <summary>
+        /// A storage or stream of a post file decoded by ReadPostFile.
+        /// </summary>
+        [StructLayout(LayoutKind.Sequential)]
+        public struct PostFileElement
+        {
+            public int parent;
+            public int type;
+            public int nameOffset;
+            public int nameLength;
+            public int encoding;
+            public int flags;
+            public long dataOffset;
+            public long dataLength;
+        }
+
+        public const int POST_FILE_STORAGE = 1;
+        public const int POST_FILE_STREAM = 2;
+        public const int POST_FILE_BINARY = 0;
+        public const int POST_FILE_UTF16 = 1;
+        public const int POST_FILE_UTF8 = 2;
+        public const int POST_FILE_UTF16BE = 3;
+        public const int POST_FILE_UTF32 = 4;
+        public const int POST_FILE_UTF32BE = 5;
+        public const int POST_FILE_NOT_LOADED = 1;
+
+        /// <summary>
+        /// Maps the post file at path and walks its directory, saying how long the buffer
+        /// ReadPostFile decodes it into is and how many PostFileElements start it. Streams
+        /// longer than maxStreamLength aren't loaded. Returns S_FALSE if the file can't be
+        /// decoded; otherwise the handle is released with ClosePostFile.
+        /// </summary>
+        [DllImport(DLL_NAME, CharSet = CharSet.Unicode, ExactSpelling = true)]
+        public static extern int OpenPostFile(
+            string path,
+            long maxStreamLength,
+            out IntPtr postFile,
+            out int length,
+            out int elementCount
+            );
+
+        /// <summary>
+        /// Decodes the post file into buffer, which is pinned while it does, so nothing is
+        /// copied after. Returns S_FALSE if the file turns out to be damaged.
+        /// </summary>
+        [DllImport(DLL_NAME, ExactSpelling = true)]
+        public static extern int ReadPostFile(IntPtr postFile, [Out] byte[] buffer, int length);
+
+        [DllImport(DLL_NAME, ExactSpelling = true)]
+        public static extern void ClosePostFile(IntPtr postFile);
+    }
+}
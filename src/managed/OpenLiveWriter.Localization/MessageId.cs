@@ -82,6 +82,7 @@ public enum MessageId
         PluginUnexpectedLoadError,
         PostFileInvalid,
         PostFileNoExist,
+        PostSupportingFilesMissing,
         PostTitleTooLong,
         PublishCanceledByPlugin,
         PublishFailed,
@@ -0,0 +1,1447 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+// This file is automatically generated. DO NOT edit it manually.
+// Edit Ribbon.xml or CommandId.cs and run utilities\RibbonTableGenerator.
+
+namespace OpenLiveWriter.Localization
+{
+    /// <summary>
+    /// The commands, tabs and groups of Ribbon.xml, with constant time lookups by id and symbol.
+    /// </summary>
+    public static class RibbonCommandTable
+    {
+        public const int CommandCount = 301;
+        public const int TabCount = 10;
+        public const int GroupCount = 44;
+
+        // sorted by id
+        private static readonly ushort[] ids =
+        {
+            1000, 1001, 1002, 1003, 1005, 1006, 1007, 1008, 1009, 1010, 1013, 1014, 1015, 1016, 1017, 1018,
+            1020, 1021, 1022, 1023, 1024, 1025, 1026, 1027, 1028, 1029, 1030, 1031, 1032, 1033, 1035, 1036,
+            1037, 1039, 1040, 1043, 1044, 1045, 1046, 1047, 1048, 1049, 1050, 1051, 1052, 1053, 1054, 1055,
+            1056, 1057, 1058, 1059, 1060, 1073, 1074, 1075, 1076, 1077, 1078, 1079, 1080, 1081, 1082, 1083,
+            1084, 1085, 1086, 1087, 1088, 1089, 1090, 1091, 1092, 1093, 1094, 1095, 1096, 1097, 1098, 1099,
+            1100, 1101, 1102, 1103, 1104, 1105, 1106, 1107, 1108, 1109, 1114, 1115, 1116, 1117, 23010, 23020,
+            23031, 23033, 23040, 23046, 23047, 23051, 23052, 23053, 23200, 23251, 23252, 23253, 23268, 23273, 23274, 23275,
+            23276, 23277, 23278, 23295, 23296, 23297, 23298, 23299, 23300, 23301, 23302, 23303, 23304, 23305, 23306, 23307,
+            23308, 23309, 23310, 23311, 23312, 23313, 23314, 23315, 23316, 23317, 23318, 23319, 23320, 23321, 23322, 23323,
+            23324, 23325, 23326, 23327, 23332, 23335, 23336, 23339, 23340, 23341, 23342, 23343, 23344, 23348, 23349, 23352,
+            23353, 23354, 23369, 23370, 23371, 23372, 23373, 23374, 23375, 23376, 23377, 23378, 23379, 23380, 23381, 23382,
+            23383, 23384, 23385, 23386, 23387, 23388, 23389, 23390, 23392, 23393, 23394, 23395, 23397, 23398, 23417, 23418,
+            23419, 23420, 23421, 23422, 23424, 23425, 23426, 23427, 23428, 23429, 23430, 23431, 23432, 23434, 23435, 23436,
+            23437, 23438, 23439, 23440, 23441, 23442, 23443, 23444, 23445, 23446, 23447, 23448, 23449, 23450, 23451, 23452,
+            23453, 23454, 23455, 23456, 23457, 23458, 23459, 23460, 23461, 23462, 23463, 23464, 23465, 23466, 23467, 23468,
+            23469, 23470, 23471, 23472, 23473, 23474, 23475, 23476, 23477, 23478, 23479, 23480, 23481, 23482, 23483, 23484,
+            23485, 23486, 23487, 23488, 30000, 30001, 30002, 30005, 30006, 30007, 30015, 30016, 30017, 30019, 30020, 30022,
+            30051, 30052, 30053, 30056, 30060, 30064, 30066, 50000, 50400, 50401, 50402, 50403, 50500, 50502, 50503, 50504,
+            50505, 50506, 50507, 50508, 50509, 50510, 50511, 50512, 50513, 50514, 50515, 50516, 50517
+        };
+
+        private static readonly string[] symbols =
+        {
+            "cmdFontGroup",
+            "cmdFontFamily",
+            "cmdFontSize",
+            "cmdClearFormatting",
+            "cmdSubscript",
+            "cmdSuperscript",
+            "cmdStrikethrough",
+            "cmdUnderline",
+            "cmdItalic",
+            "cmdBold",
+            "cmdFontColorPicker",
+            "cmdTextEditingGroup",
+            "cmdCheckSpelling",
+            "cmdWordCount",
+            "cmdFindButton",
+            "FindAndReplace",
+            "cmdSemanticHtmlGroup",
+            "cmdSemanticHtmlGallery",
+            "cmdInsertHorizontalLine",
+            "cmdInsertLink",
+            "ViewPlainText",
+            "cmdFontBackgroundColor",
+            "cmdBullets",
+            "cmdNumbers",
+            "cmdBlockquote",
+            "cmdAlignLeft",
+            "cmdAlignRight",
+            "cmdAlignCenter",
+            "cmdJustify",
+            "cmdPaste",
+            "cmdCut",
+            "cmdCopyCommand",
+            "cmdPasteSpecial",
+            "cmdInsertClearBreak",
+            "cmdInsertPictureFromFile",
+            "cmdUndo",
+            "cmdRedo",
+            "cmdSelectAll",
+            "Indent",
+            "Outdent",
+            "cmdRTLTextBlock",
+            "cmdLTRTextBlock",
+            "cmdAlignmentGroup",
+            "cmdAlignmentGallery",
+            "cmdMarginsGroup",
+            "cmdAdjustTopMargin",
+            "cmdAdjustBottomMargin",
+            "cmdAdjustLeftMargin",
+            "cmdAdjustRightMargin",
+            "cmdVideoContextTabGroup",
+            "cmdFormatVideoTab",
+            "cmdFormatVideoGroup",
+            "cmdVideoWebPreview",
+            "cmdImageContextTabGroup",
+            "cmdFormatImageTab",
+            "cmdFormatImageSizeGroup",
+            "cmdImageCrop",
+            "cmdFormatImageAdjustWidth",
+            "cmdFormatImageAdjustHeight",
+            "cmdCustomSizeGallery",
+            "cmdSetCustomSizeDefaults",
+            "cmdFormatImageLockAspectRatio",
+            "cmdFormatImageRotateGroup",
+            "cmdImageRotateCW",
+            "cmdImageRotateCCW",
+            "cmdImageTilt",
+            "cmdFormatImageStyleGroup",
+            "cmdImageBorderGallery",
+            "cmdImageEffectsGallery",
+            "cmdImageEffectsRecolorGallery",
+            "cmdImageEffectsSharpenGallery",
+            "cmdImageEffectsBlurGallery",
+            "cmdImageEffectsEmbossGallery",
+            "cmdImageContrast",
+            "cmdWatermark",
+            "cmdFormatImagePropertiesGroup",
+            "cmdFormatImageSelectLink",
+            "cmdFormatImageLinkOptions",
+            "cmdFormatImageAltText",
+            "cmdFormatImageSettingsGroup",
+            "cmdFormatImageSaveSettings",
+            "cmdFormatImageRevertSettings",
+            "cmdInsertEmoticon",
+            "cmdCustomSizeSmall",
+            "cmdCustomSizeMedium",
+            "cmdCustomSizeLarge",
+            "cmdCustomSizeOriginal",
+            "cmdImageLinkToSource",
+            "cmdImageLinkToUrl",
+            "cmdImageLinkToNone",
+            "cmdParagraphGroup",
+            "cmdVideoAspectRatioGroup",
+            "cmdVideoWidescreenAspectRatio",
+            "cmdVideoStandardAspectRatio",
+            "cmdFileMenu",
+            "cmdClose",
+            "ImageBrightness",
+            "cmdWebImage",
+            "cmdClipboardGroup",
+            "cmdAddPlugin",
+            "cmdManagePlugins",
+            "cmdPasteSplit",
+            "cmdInsertImageSplit",
+            "cmdInsertVideoSplit",
+            "cmdOptions",
+            "cmdSplitNew",
+            "cmdSplitSave",
+            "cmdSplitPrint",
+            "cmdMRUList",
+            "cmdInsertMap",
+            "cmdInsertTags",
+            "cmdInsertVideoFromWeb",
+            "cmdInsertVideoFromFile",
+            "cmdInsertVideoFromService",
+            "cmdInsertTable",
+            "cmdNewPost",
+            "cmdNewPage",
+            "cmdSavePost",
+            "cmdPostAsDraft",
+            "cmdPostAsDraftAndEditOnline",
+            "cmdPrint",
+            "cmdPrintPreview",
+            "cmdPostAndPublish",
+            "cmdOpenPost",
+            "cmdHelp",
+            "cmdSelectBlog",
+            "cmdOpenDraftSplit",
+            "OpenDraftMRU0",
+            "OpenDraftMRU1",
+            "OpenDraftMRU2",
+            "OpenDraftMRU3",
+            "OpenDraftMRU4",
+            "OpenDraftMRU5",
+            "OpenDraftMRU6",
+            "OpenDraftMRU7",
+            "OpenDraftMRU8",
+            "OpenDraftMRU9",
+            "cmdOpenPostSplit",
+            "OpenPostMRU0",
+            "OpenPostMRU1",
+            "OpenPostMRU2",
+            "OpenPostMRU3",
+            "OpenPostMRU4",
+            "OpenPostMRU5",
+            "OpenPostMRU6",
+            "OpenPostMRU7",
+            "OpenPostMRU8",
+            "OpenPostMRU9",
+            "cmdPreviewGroup",
+            "cmdConfigureWeblog",
+            "cmdAddWeblog",
+            "cmdClosePreview",
+            "cmdUpdateWeblogStyle",
+            "cmdBrowserGroup",
+            "cmdViewUseStyles",
+            "cmdBlogProviderThemeGroup",
+            "cmdBlogProviderButtonsGallery",
+            "cmdBlogProviderShortcutsGroup",
+            "cmdInsertExtendedEntry",
+            "cmdBreaksGroup",
+            "cmdViewWeblog",
+            "cmdBlogProviderBlogGroup",
+            "cmdFormatTagPropertiesGroup",
+            "cmdEditTags",
+            "cmdFormatTableInsertGroup",
+            "cmdFormatTableMoveGroup",
+            "cmdInsertRowAbove",
+            "cmdInsertRowBelow",
+            "cmdMoveRowUp",
+            "cmdMoveRowDown",
+            "cmdInsertColumnLeft",
+            "cmdInsertColumnRight",
+            "cmdMoveColumnLeft",
+            "cmdMoveColumnRight",
+            "cmdDeleteRow",
+            "cmdDeleteColumn",
+            "cmdDeleteTable",
+            "cmdFormatTableEditingGroup",
+            "cmdFormatTablePropertiesGroup",
+            "cmdRowProperties",
+            "cmdColumnProperties",
+            "cmdTableProperties",
+            "cmdCellProperties",
+            "cmdFormatTablePropertiesSplit",
+            "cmdFormatTagProvidersGroup",
+            "cmdAddTagProvider",
+            "cmdManageTagProviders",
+            "cmdAbout",
+            "cmdClearCell",
+            "cmdAlignNone",
+            "cmdFormatMapGroup",
+            "cmdMapWebPreview",
+            "cmdFormatMapPropertiesGroup",
+            "cmdFormatMapEdit",
+            "cmdDeleteDraft",
+            "cmdActivateContextualTab",
+            "AddDecorator",
+            "AddToDictionary",
+            "AddToGlossary",
+            "ApplySemanticHeader1",
+            "ApplySemanticHeader2",
+            "ApplySemanticHeader3",
+            "ApplySemanticHeader4",
+            "ApplySemanticHeader5",
+            "ApplySemanticHeader6",
+            "Clear",
+            "Colorize",
+            "Delete",
+            "EditLink",
+            "FixWordSpelling",
+            "FocusNextPane",
+            "FocusPreviousPane",
+            "Font",
+            "FontColor",
+            "Glossary",
+            "IgnoreAll",
+            "IgnoreOnce",
+            "ImageDecoratorApply",
+            "ImageEffectBlackAndWhite",
+            "ImageEffectColorPop",
+            "ImageEffectColorTemperature",
+            "ImageEffectEmboss",
+            "ImageEffectGaussianBlur",
+            "ImageEffectSepiaTone",
+            "ImageEffectSharpen",
+            "ImageReset",
+            "ImageRotate",
+            "InsertMenu",
+            "InsertTable2",
+            "MapAddPushpin",
+            "MapCenterMap",
+            "MapDeletePushpin",
+            "MapEditPushpin",
+            "MapZoomCityLevel",
+            "MapZoomRegionLevel",
+            "MapZoomStreetLevel",
+            "OpenDrafts",
+            "OpenLink",
+            "OpenRecentPosts",
+            "OpenSpellingForm",
+            "PostProperties",
+            "RecentPost",
+            "RemoveDecorator",
+            "RemoveLink",
+            "RemoveLinkAndClearFormatting",
+            "ShowCategoryPopup",
+            "ShowImageUploadError",
+            "ShowMenu",
+            "ShowVideoErrorMessage",
+            "Style",
+            "TableMenu",
+            "ToolsMenu",
+            "ViewCode",
+            "ViewNormal",
+            "ViewPreview",
+            "ViewSidebar",
+            "ViewWeblogAdmin",
+            "WeblogMenu",
+            "WeblogPicker",
+            "ApplySemanticParagraph",
+            "cmdHomeTab",
+            "cmdInsertTab",
+            "cmdBlogProviderTab",
+            "cmdTagContextTabGroup",
+            "cmdTableContextTabGroup",
+            "cmdMapContextTabGroup",
+            "cmdDebugTab",
+            "cmdPreviewTab",
+            "cmdFormatMapTab",
+            "cmdFormatTagTab",
+            "cmdFormatTableTab",
+            "cmdAccounts",
+            "cmdMediaGroup",
+            "cmdTablesGroup",
+            "cmdPluginsGroup",
+            "cmdPluginsGallery",
+            "cmdInsertGroup",
+            "ImageArrangeGallery",
+            "cmdPublishGroup",
+            "cmdQAT",
+            "cmdGeneralDebugGroup",
+            "cmdDialogDebugGroup",
+            "cmdTextDebugGroup",
+            "cmdValidateDebugGroup",
+            "cmdDiagnosticsConsole",
+            "cmdShowBetaExpiredDialogs",
+            "cmdShowUpdateMessage",
+            "cmdShowWebLayoutWarning",
+            "cmdShowErrorDialog",
+            "cmdBlogClientOptions",
+            "cmdShowDisplayMessageTestForm",
+            "cmdShowSupportingFilesForm",
+            "cmdInsertLoremIpsum",
+            "cmdValidateHtml",
+            "cmdValidateXhtml",
+            "cmdValidateLocalizedResources",
+            "cmdShowAtomImageEndpointSelector",
+            "cmdRaiseAssertion",
+            "cmdShowGoogleCaptcha",
+            "cmdTerminateProcess",
+            "cmdViewSource",
+        };
+
+        private static readonly string[] identifiers =
+        {
+            "FontGroup",
+            "FontFamily",
+            "FontSize",
+            "ClearFormatting",
+            "Subscript",
+            "Superscript",
+            "Strikethrough",
+            "Underline",
+            "Italic",
+            "Bold",
+            "FontColorPicker",
+            "TextEditingGroup",
+            "CheckSpelling",
+            "WordCount",
+            "FindButton",
+            "FindAndReplace",
+            "SemanticHtmlGroup",
+            "SemanticHtmlGallery",
+            "InsertHorizontalLine",
+            "InsertLink",
+            "ViewPlainText",
+            "FontBackgroundColor",
+            "Bullets",
+            "Numbers",
+            "Blockquote",
+            "AlignLeft",
+            "AlignRight",
+            "AlignCenter",
+            "Justify",
+            "Paste",
+            "Cut",
+            "CopyCommand",
+            "PasteSpecial",
+            "InsertClearBreak",
+            "InsertPictureFromFile",
+            "Undo",
+            "Redo",
+            "SelectAll",
+            "Indent",
+            "Outdent",
+            "RTLTextBlock",
+            "LTRTextBlock",
+            "AlignmentGroup",
+            "AlignmentGallery",
+            "MarginsGroup",
+            "AdjustTopMargin",
+            "AdjustBottomMargin",
+            "AdjustLeftMargin",
+            "AdjustRightMargin",
+            "VideoContextTabGroup",
+            "FormatVideoTab",
+            "FormatVideoGroup",
+            "VideoWebPreview",
+            "ImageContextTabGroup",
+            "FormatImageTab",
+            "FormatImageSizeGroup",
+            "ImageCrop",
+            "FormatImageAdjustWidth",
+            "FormatImageAdjustHeight",
+            "CustomSizeGallery",
+            "SetCustomSizeDefaults",
+            "FormatImageLockAspectRatio",
+            "FormatImageRotateGroup",
+            "ImageRotateCW",
+            "ImageRotateCCW",
+            "ImageTilt",
+            "FormatImageStyleGroup",
+            "ImageBorderGallery",
+            "ImageEffectsGallery",
+            "ImageEffectsRecolorGallery",
+            "ImageEffectsSharpenGallery",
+            "ImageEffectsBlurGallery",
+            "ImageEffectsEmbossGallery",
+            "ImageContrast",
+            "Watermark",
+            "FormatImagePropertiesGroup",
+            "FormatImageSelectLink",
+            "FormatImageLinkOptions",
+            "FormatImageAltText",
+            "FormatImageSettingsGroup",
+            "ImageSaveDefaults",
+            "FormatImageRevertSettings",
+            "InsertEmoticon",
+            "CustomSizeSmall",
+            "CustomSizeMedium",
+            "CustomSizeLarge",
+            "CustomSizeOriginal",
+            "ImageLinkToSource",
+            "ImageLinkToUrl",
+            "ImageLinkToNone",
+            "ParagraphGroup",
+            "VideoAspectRatioGroup",
+            "VideoWidescreenAspectRatio",
+            "VideoStandardAspectRatio",
+            "FileMenu",
+            "Close",
+            "ImageBrightness",
+            "WebImage",
+            "ClipboardGroup",
+            "AddPlugin",
+            "ManagePlugins",
+            "PasteSplit",
+            "InsertImageSplit",
+            "InsertVideoSplit",
+            "Options",
+            "SplitNew",
+            "SplitSave",
+            "SplitPrint",
+            "MRUList",
+            "InsertMap",
+            "InsertTags",
+            "InsertVideoFromWeb",
+            "InsertVideoFromFile",
+            "InsertVideoFromService",
+            "InsertTable",
+            "NewPost",
+            "NewPage",
+            "SavePost",
+            "PostAsDraft",
+            "PostAsDraftAndEditOnline",
+            "Print",
+            "PrintPreview",
+            "PostAndPublish",
+            "OpenPost",
+            "Help",
+            "SelectBlog",
+            "OpenDraftSplit",
+            "OpenDraftMRU0",
+            "OpenDraftMRU1",
+            "OpenDraftMRU2",
+            "OpenDraftMRU3",
+            "OpenDraftMRU4",
+            "OpenDraftMRU5",
+            "OpenDraftMRU6",
+            "OpenDraftMRU7",
+            "OpenDraftMRU8",
+            "OpenDraftMRU9",
+            "OpenPostSplit",
+            "OpenPostMRU0",
+            "OpenPostMRU1",
+            "OpenPostMRU2",
+            "OpenPostMRU3",
+            "OpenPostMRU4",
+            "OpenPostMRU5",
+            "OpenPostMRU6",
+            "OpenPostMRU7",
+            "OpenPostMRU8",
+            "OpenPostMRU9",
+            "PreviewGroup",
+            "ConfigureWeblog",
+            "AddWeblog",
+            "ClosePreview",
+            "UpdateWeblogStyle",
+            "BrowserGroup",
+            "ViewUseStyles",
+            "BlogProviderThemeGroup",
+            "BlogProviderButtonsGallery",
+            "BlogProviderShortcutsGroup",
+            "InsertExtendedEntry",
+            "BreaksGroup",
+            "ViewWeblog",
+            "BlogProviderBlogGroup",
+            "FormatTagPropertiesGroup",
+            "EditTags",
+            "FormatTableInsertGroup",
+            "FormatTableMoveGroup",
+            "InsertRowAbove",
+            "InsertRowBelow",
+            "MoveRowUp",
+            "MoveRowDown",
+            "InsertColumnLeft",
+            "InsertColumnRight",
+            "MoveColumnLeft",
+            "MoveColumnRight",
+            "DeleteRow",
+            "DeleteColumn",
+            "DeleteTable",
+            "FormatTableEditingGroup",
+            "FormatTablePropertiesGroup",
+            "RowProperties",
+            "ColumnProperties",
+            "TableProperties",
+            "CellProperties",
+            "FormatTablePropertiesSplit",
+            "FormatTagProvidersGroup",
+            "AddTagProvider",
+            "ManageTagProviders",
+            "About",
+            "ClearCell",
+            "AlignNone",
+            "FormatMapGroup",
+            "MapWebPreview",
+            "FormatMapPropertiesGroup",
+            "FormatMapEdit",
+            "DeleteDraft",
+            "ActivateContextualTab",
+            "AddDecorator",
+            "AddToDictionary",
+            "AddToGlossary",
+            "ApplySemanticHeader1",
+            "ApplySemanticHeader2",
+            "ApplySemanticHeader3",
+            "ApplySemanticHeader4",
+            "ApplySemanticHeader5",
+            "ApplySemanticHeader6",
+            "Clear",
+            "Colorize",
+            "Delete",
+            "EditLink",
+            "FixWordSpelling",
+            "FocusNextPane",
+            "FocusPreviousPane",
+            "Font",
+            "FontColor",
+            "Glossary",
+            "IgnoreAll",
+            "IgnoreOnce",
+            "ImageDecoratorApply",
+            "ImageEffectBlackAndWhite",
+            "ImageEffectColorPop",
+            "ImageEffectColorTemperature",
+            "ImageEffectEmboss",
+            "ImageEffectGaussianBlur",
+            "ImageEffectSepiaTone",
+            "ImageEffectSharpen",
+            "ImageReset",
+            "ImageRotate",
+            "InsertMenu",
+            "InsertTable2",
+            "MapAddPushpin",
+            "MapCenterMap",
+            "MapDeletePushpin",
+            "MapEditPushpin",
+            "MapZoomCityLevel",
+            "MapZoomRegionLevel",
+            "MapZoomStreetLevel",
+            "OpenDrafts",
+            "OpenLink",
+            "OpenRecentPosts",
+            "OpenSpellingForm",
+            "PostProperties",
+            "RecentPost",
+            "RemoveDecorator",
+            "RemoveLink",
+            "RemoveLinkAndClearFormatting",
+            "ShowCategoryPopup",
+            "ShowImageUploadError",
+            "ShowMenu",
+            "ShowVideoErrorMessage",
+            "Style",
+            "TableMenu",
+            "ToolsMenu",
+            "ViewCode",
+            "ViewNormal",
+            "ViewPreview",
+            "ViewSidebar",
+            "ViewWeblogAdmin",
+            "WeblogMenu",
+            "WeblogPicker",
+            "ApplySemanticParagraph",
+            "HomeTab",
+            "InsertTab",
+            "BlogProviderTab",
+            "TagContextTabGroup",
+            "TableContextTabGroup",
+            "MapContextTabGroup",
+            "DebugTab",
+            "PreviewTab",
+            "FormatMapTab",
+            "FormatTagTab",
+            "FormatTableTab",
+            "Accounts",
+            "MediaGroup",
+            "TablesGroup",
+            "PluginsGroup",
+            "PluginsGallery",
+            "InsertGroup",
+            "ImageArrangeGallery",
+            "PublishGroup",
+            "QAT",
+            "GeneralDebugGroup",
+            "DialogDebugGroup",
+            "TextDebugGroup",
+            "ValidateDebugGroup",
+            "DiagnosticsConsole",
+            "ShowBetaExpiredDialogs",
+            "ShowUpdateMessage",
+            "ShowWebLayoutWarning",
+            "ShowErrorDialog",
+            "BlogClientOptions",
+            "ShowDisplayMessageTestForm",
+            "ShowSupportingFilesForm",
+            "InsertLoremIpsum",
+            "ValidateHtml",
+            "ValidateXhtml",
+            "ValidateLocalizedResources",
+            "ShowAtomImageEndpointSelector",
+            "RaiseAssertion",
+            "ShowGoogleCaptcha",
+            "TerminateProcess",
+            "ViewSource",
+        };
+
+        private static readonly string[] keytips =
+        {
+            "ZF",
+            "FF",
+            "FS",
+            "R",
+            "N",
+            "M",
+            "H",
+            "U",
+            "I",
+            "B",
+            "FC",
+            "ZE",
+            "S",
+            "W",
+            "FD",
+            "",
+            "ZS",
+            "Y",
+            "L",
+            "K",
+            "",
+            "FH",
+            "L1",
+            "L2",
+            "Q",
+            "AL",
+            "AR",
+            "AC",
+            "AJ",
+            "",
+            "X",
+            "C",
+            "",
+            "B",
+            "",
+            "",
+            "",
+            "AS",
+            "MI",
+            "MO",
+            "R1",
+            "R2",
+            "ZA",
+            "",
+            "ZM",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "V",
+            "ZV",
+            "V",
+            "IM",
+            "P",
+            "",
+            "C",
+            "SW",
+            "SH",
+            "U",
+            "",
+            "L",
+            "",
+            "RR",
+            "RL",
+            "RT",
+            "",
+            "B",
+            "E",
+            "",
+            "",
+            "",
+            "",
+            "O",
+            "W",
+            "",
+            "KL",
+            "KK",
+            "T",
+            "",
+            "DS",
+            "DR",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "ZP",
+            "ZR",
+            "W",
+            "S",
+            "",
+            "",
+            "",
+            "",
+            "ZC",
+            "PA",
+            "PM",
+            "V",
+            "E",
+            "O",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "M",
+            "G",
+            "",
+            "",
+            "",
+            "T",
+            "",
+            "",
+            "",
+            "D",
+            "",
+            "",
+            "",
+            "P1",
+            "",
+            "",
+            "P2",
+            "O",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "R",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "B",
+            "",
+            "C",
+            "R",
+            "",
+            "T",
+            "ZT",
+            "S",
+            "ZS",
+            "S",
+            "ZB",
+            "",
+            "ZB",
+            "",
+            "",
+            "ZI",
+            "ZM",
+            "IA",
+            "IB",
+            "MA",
+            "MB",
+            "IL",
+            "IR",
+            "ML",
+            "MR",
+            "DR",
+            "DC",
+            "DT",
+            "ZD",
+            "ZP",
+            "",
+            "",
+            "",
+            "",
+            "T",
+            "",
+            "",
+            "",
+            "",
+            "DE",
+            "M",
+            "M",
+            "M",
+            "M",
+            "M",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "H",
+            "I",
+            "B",
+            "",
+            "",
+            "",
+            "D",
+            "R",
+            "M",
+            "T",
+            "T",
+            "",
+            "ZM",
+            "ZT",
+            "ZP",
+            "PP",
+            "ZI",
+            "",
+            "ZP1",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+        };
+
+        private static readonly string[] groupPaths =
+        {
+            "cmdHomeTab",
+            "cmdHomeTab/cmdFontGroup",
+            "cmdHomeTab/cmdFontGroup",
+            "cmdHomeTab/cmdFontGroup",
+            "cmdHomeTab/cmdFontGroup",
+            "cmdHomeTab/cmdFontGroup",
+            "cmdHomeTab/cmdFontGroup",
+            "cmdHomeTab/cmdFontGroup",
+            "cmdHomeTab/cmdFontGroup",
+            "cmdHomeTab/cmdFontGroup",
+            "cmdHomeTab/cmdFontGroup",
+            "cmdHomeTab",
+            "cmdHomeTab/cmdTextEditingGroup",
+            "cmdHomeTab/cmdTextEditingGroup",
+            "cmdHomeTab/cmdTextEditingGroup",
+            "",
+            "cmdHomeTab",
+            "cmdHomeTab/cmdSemanticHtmlGroup",
+            "cmdInsertTab/cmdBreaksGroup",
+            "cmdHomeTab/cmdInsertGroup",
+            "",
+            "cmdHomeTab/cmdFontGroup",
+            "cmdHomeTab/cmdParagraphGroup",
+            "cmdHomeTab/cmdParagraphGroup",
+            "cmdHomeTab/cmdParagraphGroup",
+            "cmdHomeTab/cmdParagraphGroup",
+            "cmdHomeTab/cmdParagraphGroup",
+            "cmdHomeTab/cmdParagraphGroup",
+            "cmdHomeTab/cmdParagraphGroup",
+            "cmdHomeTab/cmdClipboardGroup",
+            "cmdHomeTab/cmdClipboardGroup",
+            "cmdHomeTab/cmdClipboardGroup",
+            "cmdHomeTab/cmdClipboardGroup",
+            "cmdInsertTab/cmdBreaksGroup",
+            "cmdHomeTab/cmdInsertGroup",
+            "",
+            "",
+            "cmdHomeTab/cmdTextEditingGroup",
+            "",
+            "",
+            "cmdHomeTab/cmdParagraphGroup",
+            "cmdHomeTab/cmdParagraphGroup",
+            "cmdImageContextTabGroup/cmdFormatImageTab",
+            "cmdImageContextTabGroup/cmdFormatImageTab/cmdAlignmentGroup",
+            "cmdImageContextTabGroup/cmdFormatImageTab",
+            "cmdImageContextTabGroup/cmdFormatImageTab/cmdMarginsGroup",
+            "cmdImageContextTabGroup/cmdFormatImageTab/cmdMarginsGroup",
+            "cmdImageContextTabGroup/cmdFormatImageTab/cmdMarginsGroup",
+            "cmdImageContextTabGroup/cmdFormatImageTab/cmdMarginsGroup",
+            "",
+            "cmdVideoContextTabGroup",
+            "cmdVideoContextTabGroup/cmdFormatVideoTab",
+            "cmdVideoContextTabGroup/cmdFormatVideoTab/cmdFormatVideoGroup",
+            "",
+            "cmdImageContextTabGroup",
+            "cmdImageContextTabGroup/cmdFormatImageTab",
+            "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageSizeGroup",
+            "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageSizeGroup",
+            "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageSizeGroup",
+            "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageSizeGroup",
+            "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageSizeGroup",
+            "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageSizeGroup",
+            "cmdImageContextTabGroup/cmdFormatImageTab",
+            "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageRotateGroup",
+            "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageRotateGroup",
+            "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageRotateGroup",
+            "cmdImageContextTabGroup/cmdFormatImageTab",
+            "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageStyleGroup",
+            "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageStyleGroup",
+            "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageStyleGroup",
+            "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageStyleGroup",
+            "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageStyleGroup",
+            "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageStyleGroup",
+            "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageStyleGroup",
+            "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageStyleGroup",
+            "cmdImageContextTabGroup/cmdFormatImageTab",
+            "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImagePropertiesGroup",
+            "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImagePropertiesGroup",
+            "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImagePropertiesGroup",
+            "cmdImageContextTabGroup/cmdFormatImageTab",
+            "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageSettingsGroup",
+            "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageSettingsGroup",
+            "cmdInsertTab/cmdMediaGroup",
+            "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageSizeGroup",
+            "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageSizeGroup",
+            "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageSizeGroup",
+            "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageSizeGroup",
+            "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImagePropertiesGroup",
+            "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImagePropertiesGroup",
+            "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImagePropertiesGroup",
+            "cmdHomeTab",
+            "cmdVideoContextTabGroup/cmdFormatVideoTab",
+            "cmdVideoContextTabGroup/cmdFormatVideoTab/cmdVideoAspectRatioGroup",
+            "cmdVideoContextTabGroup/cmdFormatVideoTab/cmdVideoAspectRatioGroup",
+            "",
+            "cmdFileMenu",
+            "",
+            "cmdHomeTab/cmdInsertGroup",
+            "cmdHomeTab",
+            "cmdInsertTab/cmdPluginsGroup",
+            "cmdInsertTab/cmdPluginsGroup",
+            "cmdHomeTab/cmdClipboardGroup",
+            "cmdHomeTab/cmdInsertGroup",
+            "cmdHomeTab/cmdInsertGroup",
+            "cmdFileMenu",
+            "cmdFileMenu",
+            "cmdFileMenu",
+            "cmdFileMenu",
+            "cmdFileMenu",
+            "cmdInsertTab/cmdMediaGroup",
+            "cmdInsertTab/cmdMediaGroup",
+            "cmdHomeTab/cmdInsertGroup",
+            "cmdHomeTab/cmdInsertGroup",
+            "cmdHomeTab/cmdInsertGroup",
+            "cmdInsertTab/cmdTablesGroup",
+            "cmdFileMenu",
+            "cmdFileMenu",
+            "cmdFileMenu",
+            "cmdFileMenu",
+            "cmdFileMenu",
+            "cmdFileMenu",
+            "cmdFileMenu",
+            "cmdFileMenu",
+            "",
+            "",
+            "cmdHomeTab/cmdPublishGroup",
+            "cmdFileMenu",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "cmdFileMenu",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "cmdPreviewTab",
+            "cmdBlogProviderTab/cmdBlogProviderBlogGroup",
+            "cmdHomeTab/cmdPublishGroup",
+            "cmdPreviewTab/cmdPreviewGroup",
+            "cmdBlogProviderTab/cmdBlogProviderThemeGroup",
+            "cmdPreviewTab",
+            "cmdBlogProviderTab/cmdBlogProviderThemeGroup",
+            "cmdBlogProviderTab",
+            "cmdBlogProviderTab/cmdBlogProviderShortcutsGroup",
+            "cmdBlogProviderTab",
+            "cmdInsertTab/cmdBreaksGroup",
+            "cmdInsertTab",
+            "",
+            "cmdBlogProviderTab",
+            "cmdTagContextTabGroup/cmdFormatTagTab",
+            "cmdTagContextTabGroup/cmdFormatTagTab/cmdFormatTagPropertiesGroup",
+            "cmdTableContextTabGroup/cmdFormatTableTab",
+            "cmdTableContextTabGroup/cmdFormatTableTab",
+            "cmdTableContextTabGroup/cmdFormatTableTab/cmdFormatTableInsertGroup",
+            "cmdTableContextTabGroup/cmdFormatTableTab/cmdFormatTableInsertGroup",
+            "cmdTableContextTabGroup/cmdFormatTableTab/cmdFormatTableMoveGroup",
+            "cmdTableContextTabGroup/cmdFormatTableTab/cmdFormatTableMoveGroup",
+            "cmdTableContextTabGroup/cmdFormatTableTab/cmdFormatTableInsertGroup",
+            "cmdTableContextTabGroup/cmdFormatTableTab/cmdFormatTableInsertGroup",
+            "cmdTableContextTabGroup/cmdFormatTableTab/cmdFormatTableMoveGroup",
+            "cmdTableContextTabGroup/cmdFormatTableTab/cmdFormatTableMoveGroup",
+            "cmdTableContextTabGroup/cmdFormatTableTab/cmdFormatTableEditingGroup",
+            "cmdTableContextTabGroup/cmdFormatTableTab/cmdFormatTableEditingGroup",
+            "cmdTableContextTabGroup/cmdFormatTableTab/cmdFormatTableEditingGroup",
+            "cmdTableContextTabGroup/cmdFormatTableTab",
+            "cmdTableContextTabGroup/cmdFormatTableTab",
+            "cmdTableContextTabGroup/cmdFormatTableTab/cmdFormatTablePropertiesGroup",
+            "cmdTableContextTabGroup/cmdFormatTableTab/cmdFormatTablePropertiesGroup",
+            "cmdTableContextTabGroup/cmdFormatTableTab/cmdFormatTablePropertiesGroup",
+            "cmdTableContextTabGroup/cmdFormatTableTab/cmdFormatTablePropertiesGroup",
+            "cmdTableContextTabGroup/cmdFormatTableTab/cmdFormatTablePropertiesGroup",
+            "cmdTagContextTabGroup/cmdFormatTagTab",
+            "cmdTagContextTabGroup/cmdFormatTagTab/cmdFormatTagProvidersGroup",
+            "cmdTagContextTabGroup/cmdFormatTagTab/cmdFormatTagProvidersGroup",
+            "cmdFileMenu",
+            "cmdTableContextTabGroup/cmdFormatTableTab/cmdFormatTableEditingGroup",
+            "",
+            "cmdMapContextTabGroup/cmdFormatMapTab",
+            "cmdMapContextTabGroup/cmdFormatMapTab/cmdFormatMapGroup",
+            "cmdMapContextTabGroup/cmdFormatMapTab",
+            "cmdMapContextTabGroup/cmdFormatMapTab/cmdFormatMapPropertiesGroup",
+            "cmdFileMenu",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "",
+            "cmdMapContextTabGroup",
+            "cmdTagContextTabGroup",
+            "cmdTableContextTabGroup",
+            "cmdHomeTab/cmdPublishGroup",
+            "cmdInsertTab",
+            "cmdInsertTab",
+            "cmdInsertTab",
+            "cmdInsertTab/cmdPluginsGroup",
+            "cmdHomeTab",
+            "",
+            "cmdHomeTab",
+            "",
+            "cmdDebugTab",
+            "cmdDebugTab",
+            "cmdDebugTab",
+            "cmdDebugTab",
+            "cmdDebugTab/cmdGeneralDebugGroup",
+            "cmdDebugTab/cmdDialogDebugGroup",
+            "cmdDebugTab/cmdDialogDebugGroup",
+            "cmdDebugTab/cmdDialogDebugGroup",
+            "cmdDebugTab/cmdDialogDebugGroup",
+            "cmdDebugTab/cmdGeneralDebugGroup",
+            "cmdDebugTab/cmdDialogDebugGroup",
+            "cmdDebugTab/cmdDialogDebugGroup",
+            "cmdDebugTab/cmdTextDebugGroup",
+            "cmdDebugTab/cmdValidateDebugGroup",
+            "cmdDebugTab/cmdValidateDebugGroup",
+            "cmdDebugTab/cmdValidateDebugGroup",
+            "cmdDebugTab/cmdDialogDebugGroup",
+            "cmdDebugTab/cmdGeneralDebugGroup",
+            "cmdDebugTab/cmdDialogDebugGroup",
+            "cmdDebugTab/cmdGeneralDebugGroup",
+            "cmdDebugTab/cmdGeneralDebugGroup",
+        };
+
+        // command index of each tab
+        private static readonly ushort[] tabCommands =
+        {
+            260, 261, 262, 267, 266, 54, 50, 268, 270, 269
+        };
+
+        // tab i owns groups [tabGroupStarts[i], tabGroupStarts[i + 1])
+        private static readonly ushort[] tabGroupStarts =
+        {
+            0, 8, 13, 16, 19, 23, 30, 34, 38, 42, 44
+        };
+
+        // command index of each group
+        private static readonly ushort[] groupCommands =
+        {
+            98, 278, 0, 90, 90, 16, 276, 11, 159, 273, 272, 274, 274, 161, 157, 155,
+            278, 153, 148, 280, 281, 282, 283, 55, 62, 66, 75, 79, 42, 44, 51, 91,
+            42, 44, 190, 192, 42, 44, 178, 177, 164, 165, 162, 184
+        };
+
+        // tab index of each group
+        private static readonly ushort[] groupTabs =
+        {
+            0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 2, 2, 2,
+            3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 5, 5, 5, 6, 6,
+            6, 6, 7, 7, 7, 7, 8, 8, 8, 8, 9, 9
+        };
+
+        // group i owns groupMembers [groupMemberStarts[i], groupMemberStarts[i + 1])
+        private static readonly ushort[] groupMemberStarts =
+        {
+            0, 5, 10, 21, 28, 37, 38, 46, 50, 53, 54, 65, 67, 70, 71, 72,
+            74, 79, 80, 81, 86, 94, 95, 98, 108, 111, 119, 125, 127, 128, 132, 133,
+            135, 136, 140, 141, 142, 143, 147, 152, 156, 160, 164, 165, 167
+        };
+
+        // command indexes
+        private static readonly ushort[] groupMembers =
+        {
+            101, 29, 32, 30, 31, 122, 125, 150, 271, 118, 1, 2, 3, 9, 8, 7,
+            6, 4, 5, 21, 10, 22, 23, 24, 25, 27, 26, 28, 22, 23, 24, 41,
+            40, 25, 27, 26, 28, 17, 19, 102, 34, 97, 103, 111, 112, 113, 12, 13,
+            14, 37, 18, 33, 158, 114, 19, 102, 34, 97, 103, 111, 112, 113, 109, 110,
+            82, 99, 100, 275, 99, 100, 149, 156, 154, 152, 122, 125, 150, 271, 118, 152,
+            151, 299, 297, 284, 289, 300, 285, 286, 287, 288, 290, 291, 296, 298, 292, 293,
+            294, 295, 56, 57, 58, 59, 83, 84, 85, 86, 60, 61, 64, 63, 65, 67,
+            68, 69, 70, 71, 72, 73, 74, 76, 87, 88, 89, 77, 78, 81, 80, 43,
+            45, 46, 48, 47, 52, 92, 93, 43, 45, 46, 48, 47, 191, 193, 43, 45,
+            46, 48, 47, 183, 181, 179, 180, 182, 174, 175, 176, 188, 166, 167, 170, 171,
+            168, 169, 172, 173, 163, 185, 186
+        };
+
+        private static readonly ushort[] idDisplacements =
+        {
+            48, 0, 3, 17, 73, 2, 47, 58, 116, 17, 72, 268, 173, 1, 3, 268,
+            1, 7, 201, 29, 27, 382, 224, 570, 0, 133, 171, 163, 0, 187, 283, 277,
+            1821, 194, 279, 709, 333, 42, 432, 53, 69, 266, 113, 401, 1, 378, 635, 654,
+            392, 888, 140, 3, 1, 523, 357, 65, 1105, 881, 194, 117, 877, 650, 12, 77,
+            309, 1, 1285, 117, 381, 459, 166, 742, 1101, 740, 718, 2
+        };
+
+        private static readonly ushort[] idSlots =
+        {
+            144, 103, 123, 283, 49, 298, 80, 77, 72, 236, 184, 193, 6, 274, 96, 65,
+            132, 210, 198, 264, 254, 168, 85, 116, 154, 228, 122, 187, 271, 135, 243, 281,
+            253, 100, 145, 146, 34, 300, 268, 142, 278, 237, 67, 284, 35, 139, 296, 12,
+            111, 92, 266, 175, 275, 286, 297, 196, 11, 28, 140, 127, 166, 209, 27, 97,
+            125, 203, 90, 115, 171, 13, 180, 179, 240, 10, 273, 163, 241, 178, 258, 277,
+            159, 69, 257, 108, 75, 55, 130, 295, 7, 42, 164, 291, 101, 66, 165, 181,
+            0, 64, 84, 185, 23, 244, 87, 86, 81, 285, 149, 247, 216, 126, 288, 220,
+            129, 52, 88, 51, 189, 280, 109, 177, 182, 107, 211, 58, 152, 14, 18, 54,
+            270, 43, 172, 124, 292, 249, 2, 106, 221, 93, 8, 41, 120, 38, 121, 232,
+            224, 30, 212, 17, 201, 218, 250, 148, 205, 217, 37, 63, 110, 26, 219, 208,
+            45, 117, 157, 195, 186, 265, 102, 89, 76, 59, 289, 174, 53, 267, 147, 47,
+            138, 169, 104, 158, 73, 99, 60, 215, 248, 197, 24, 261, 199, 94, 167, 50,
+            231, 33, 70, 98, 46, 36, 112, 62, 156, 137, 31, 40, 279, 214, 161, 276,
+            44, 234, 4, 153, 1, 190, 194, 176, 136, 256, 251, 91, 57, 226, 282, 19,
+            200, 242, 287, 82, 114, 113, 95, 68, 141, 245, 105, 79, 128, 131, 207, 260,
+            143, 170, 15, 246, 71, 22, 173, 78, 191, 255, 188, 83, 269, 39, 151, 299,
+            56, 9, 192, 5, 202, 290, 48, 162, 155, 239, 238, 223, 134, 118, 29, 20,
+            259, 74, 160, 133, 119, 233, 225, 183, 3, 61, 32, 222, 293, 229, 263, 204,
+            272, 252, 227, 21, 150, 294, 262, 230, 213, 206, 25, 235, 16
+        };
+
+        private static readonly ushort[] symbolDisplacements =
+        {
+            34, 22, 3, 19, 7, 7, 7, 9, 252, 10, 5, 6, 1, 1, 0, 132,
+            22, 6, 43, 9, 183, 63, 1, 113, 39, 175, 1, 332, 3, 35, 2, 11,
+            110, 6, 278, 805, 121, 19, 11, 126, 1, 4, 12, 22, 10, 21, 8, 851,
+            38, 13, 31, 31, 117, 314, 254, 24, 1, 2685, 28, 2, 22, 4, 327, 187,
+            854, 50, 2282, 62, 38, 197, 265, 632, 116, 829, 7, 5
+        };
+
+        private static readonly ushort[] symbolSlots =
+        {
+            185, 263, 18, 293, 244, 158, 74, 203, 66, 157, 116, 145, 114, 9, 275, 184,
+            199, 182, 72, 44, 296, 84, 60, 127, 69, 61, 280, 232, 266, 37, 257, 236,
+            300, 239, 259, 197, 92, 118, 204, 62, 173, 200, 42, 172, 151, 237, 205, 297,
+            261, 87, 23, 134, 190, 95, 112, 188, 108, 177, 201, 238, 250, 225, 138, 3,
+            161, 70, 90, 245, 265, 93, 107, 169, 22, 67, 224, 193, 46, 11, 50, 82,
+            81, 36, 248, 98, 153, 73, 176, 130, 51, 163, 208, 106, 269, 235, 291, 213,
+            171, 187, 156, 164, 260, 45, 241, 25, 191, 115, 55, 258, 146, 295, 144, 100,
+            149, 180, 96, 251, 186, 221, 86, 126, 195, 289, 41, 211, 88, 207, 29, 226,
+            54, 28, 94, 192, 13, 12, 110, 131, 217, 194, 274, 285, 97, 38, 26, 299,
+            135, 231, 123, 39, 2, 183, 198, 14, 214, 31, 4, 120, 216, 47, 129, 220,
+            76, 219, 117, 279, 294, 215, 53, 233, 150, 254, 247, 85, 281, 111, 7, 210,
+            276, 240, 65, 99, 1, 202, 15, 101, 252, 284, 48, 222, 56, 79, 168, 136,
+            52, 278, 0, 63, 160, 49, 286, 143, 5, 20, 125, 128, 223, 34, 33, 264,
+            32, 71, 121, 91, 119, 256, 242, 272, 255, 16, 10, 287, 282, 24, 162, 105,
+            212, 103, 102, 122, 154, 174, 159, 218, 179, 167, 78, 75, 58, 30, 19, 283,
+            262, 141, 298, 6, 270, 209, 175, 124, 290, 273, 68, 59, 246, 152, 165, 155,
+            64, 277, 142, 83, 268, 27, 43, 40, 181, 17, 253, 288, 166, 80, 104, 133,
+            227, 292, 139, 89, 21, 243, 234, 113, 140, 147, 228, 249, 189, 8, 178, 137,
+            148, 271, 35, 206, 230, 109, 170, 132, 77, 229, 267, 57, 196
+        };
+
+        /// <summary>
+        /// Gets the index of the command with the specified id, or -1.
+        /// </summary>
+        public static int FindById(uint id)
+        {
+            int index = idSlots[HashId(idDisplacements[HashId(0, id) % (uint)idDisplacements.Length], id) % CommandCount];
+            return ids[index] == id ? index : -1;
+        }
+
+        /// <summary>
+        /// Gets the index of the command with the specified Ribbon.xml symbol, or -1.
+        /// </summary>
+        public static int FindBySymbol(string symbol)
+        {
+            if (symbol == null)
+                return -1;
+            int index = symbolSlots[HashSymbol(symbolDisplacements[HashSymbol(0, symbol) % (uint)symbolDisplacements.Length], symbol) % CommandCount];
+            return symbols[index] == symbol ? index : -1;
+        }
+
+        public static uint GetId(int index) { return ids[index]; }
+        public static string GetSymbol(int index) { return symbols[index]; }
+
+        /// <summary>
+        /// Gets the name of the command's CommandId member.
+        /// </summary>
+        public static string GetIdentifier(int index) { return identifiers[index]; }
+
+        public static string GetKeytip(int index) { return keytips[index]; }
+
+        /// <summary>
+        /// Gets the tabs and groups the command first appears under, separated by slashes.
+        /// </summary>
+        public static string GetGroupPath(int index) { return groupPaths[index]; }
+
+        public static int GetTabCommand(int tab) { return tabCommands[tab]; }
+        public static int GetTabGroupStart(int tab) { return tabGroupStarts[tab]; }
+        public static int GetTabGroupEnd(int tab) { return tabGroupStarts[tab + 1]; }
+
+        public static int GetGroupCommand(int group) { return groupCommands[group]; }
+        public static int GetGroupTab(int group) { return groupTabs[group]; }
+        public static int GetGroupMemberStart(int group) { return groupMemberStarts[group]; }
+        public static int GetGroupMemberEnd(int group) { return groupMemberStarts[group + 1]; }
+        public static int GetGroupMember(int position) { return groupMembers[position]; }
+
+        private static uint Avalanche(uint hash)
+        {
+            hash ^= hash >> 16;
+            hash *= 0x85EBCA6B;
+            return hash ^ (hash >> 13);
+        }
+
+        private static uint HashId(uint seed, uint id)
+        {
+            uint hash = 2166136261 ^ seed;
+            for (int i = 0; i < 4; i++)
+                hash = (hash ^ ((id >> (i * 8)) & 0xFF)) * 16777619;
+            return Avalanche(hash);
+        }
+
+        // symbols are identifiers, so hashing chars is hashing their ASCII bytes
+        private static uint HashSymbol(uint seed, string symbol)
+        {
+            uint hash = 2166136261 ^ seed;
+            foreach (char c in symbol)
+                hash = (hash ^ (c & 0xFFu)) * 16777619;
+            return Avalanche(hash);
+        }
+    }
+}
@@ -96,20 +96,35 @@ private void CreateShadowFile(ImageFileData sourceFile, ISupportingFileService f
                 ImageFormat format;
                 string fileExt;
                 ImageHelper2.GetImageFormat(sourceFile.SupportingFile.FileName, out fileExt, out format);
-                using (Bitmap sourceImage = new Bitmap(sourceFile.Uri.LocalPath))
+
+                // images that are small enough already are copied without decoding them
+                ImageHeader header;
+                if (ImageHeaderReader.TryRead(sourceFile.Uri.LocalPath, out header)
+                    && header.Size.Width <= shadowSize.Width && header.Size.Height <= shadowSize.Height)
                 {
-                    if (sourceImage.Width > shadowSize.Width || sourceImage.Height > shadowSize.Height)
+                    shadowSize = header.Size;
+                    using (FileStream fs = File.OpenRead(sourceFile.Uri.LocalPath))
                     {
-                        shadowSize = ImageHelper2.SaveScaledThumbnailImage(Math.Min(shadowSize.Width, sourceImage.Width),
-                                                                           Math.Min(shadowSize.Height, sourceImage.Height),
-                                                                           sourceImage, format, shadowStream);
+                        StreamHelper.Transfer(fs, shadowStream);
                     }
-                    else
+                }
+                else
+                {
+                    using (Bitmap sourceImage = new Bitmap(sourceFile.Uri.LocalPath))
                     {
-                        shadowSize = sourceImage.Size;
-                        using (FileStream fs = File.OpenRead(sourceFile.Uri.LocalPath))
+                        if (sourceImage.Width > shadowSize.Width || sourceImage.Height > shadowSize.Height)
+                        {
+                            shadowSize = ImageHelper2.SaveScaledThumbnailImage(Math.Min(shadowSize.Width, sourceImage.Width),
+                                                                               Math.Min(shadowSize.Height, sourceImage.Height),
+                                                                               sourceImage, format, shadowStream);
+                        }
+                        else
                         {
-                            StreamHelper.Transfer(fs, shadowStream);
+                            shadowSize = sourceImage.Size;
+                            using (FileStream fs = File.OpenRead(sourceFile.Uri.LocalPath))
+                            {
+                                StreamHelper.Transfer(fs, shadowStream);
+                            }
                         }
                     }
                 }
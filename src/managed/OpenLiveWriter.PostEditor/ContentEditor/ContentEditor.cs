@@ -2412,7 +2412,7 @@ public ISpellingChecker SpellingChecker
         {
             get { return _spellingChecker; }
         }
-        private WinSpellingChecker _spellingChecker = new WinSpellingChecker();
+        private NativeSpellingChecker _spellingChecker = new NativeSpellingChecker(new WinSpellingChecker());
 
         public void SetSpellingOptions(string bcp47Code, bool useAutoCorrect)
         {
@@ -0,0 +1,366 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+using System;
+using System.IO;
+using OpenLiveWriter.Interop.Com.StructuredStorage;
+
+namespace OpenLiveWriter.PostEditor
+{
+    /// <summary>
+    /// Append-only journal of edits to the contents stream of a post file.
+    ///
+    /// Rather than rewriting the whole body on every autosave, the difference from the
+    /// previously saved body is appended to the journal as a single replace record, and
+    /// the base stream is only rewritten when the journal is compacted. Readers apply
+    /// every intact record to the base and stop at the first one that is truncated or
+    /// fails its checksum, so a torn append falls back to the last complete autosave.
+    /// A journal whose header doesn't match the base (e.g. because an older version
+    /// rewrote the base without knowing about the journal) is ignored entirely.
+    ///
+    /// Layout (all integers little-endian uint32):
+    ///   header:  magic "OLWJ", version, base length, CRC-32 of the base
+    ///   record:  payload length, CRC-32 of the payload, payload
+    ///   payload: offset, number of bytes removed, inserted bytes
+    ///
+    /// The native filter reads the same format (see ContentsJournal.cpp), so the two
+    /// must be kept in sync.
+    /// </summary>
+    public class PostContentsJournal
+    {
+        public const string StreamName = "ContentsJournal";
+
+        private const uint Magic = 0x4A574C4F;
+        private const uint Version = 1;
+        private const int HeaderLength = 16;
+        private const int RecordHeaderLength = 8;
+        private const int PayloadHeaderLength = 8;
+
+        // fold the journal back into the base once replaying it starts to cost more
+        // than rewriting the base would
+        private const int MaxRecords = 64;
+        private const int MinJournalLength = 16 * 1024;
+
+        private string path;
+        private byte[] contents;
+        private uint baseCrc;
+        private long baseLength;
+        private long journalLength;
+        private int recordCount;
+
+        /// <summary>
+        /// Reads the current contents of a post and remembers them, so that a later
+        /// Write to the same file can append to the journal instead of rewriting the base.
+        /// </summary>
+        public byte[] Read(PostFileReader postStorage, string baseStreamName, string filePath)
+        {
+            Invalidate();
+
+            byte[] baseContents = ReadStream(postStorage, baseStreamName);
+            byte[] current = baseContents;
+            long validLength = 0;
+            int records = 0;
+            if (postStorage.Contains(StreamName))
+            {
+                using (Stream journal = postStorage.OpenStream(StreamName))
+                    current = Apply(baseContents, journal, out validLength, out records);
+            }
+
+            path = filePath;
+            contents = current;
+            baseCrc = Crc32(baseContents, 0, baseContents.Length);
+            baseLength = baseContents.Length;
+            journalLength = validLength;
+            recordCount = records;
+            return current;
+        }
+
+        /// <summary>
+        /// Reads the current contents of a post without keeping any journal state.
+        /// </summary>
+        public static byte[] ReadContents(PostFileReader postStorage, string baseStreamName)
+        {
+            return new PostContentsJournal().Read(postStorage, baseStreamName, null);
+        }
+
+        /// <summary>
+        /// Writes the contents of a post. When append is true and the file is still in the
+        /// state it was last read or written in, only the difference is appended to the
+        /// journal; otherwise (or once the journal grows too long) the base is rewritten
+        /// and the journal removed.
+        /// </summary>
+        public void Write(Storage postStorage, string baseStreamName, string filePath, byte[] newContents, bool append)
+        {
+            if (append && contents != null && string.Equals(path, filePath, StringComparison.OrdinalIgnoreCase))
+            {
+                byte[] record = CreateRecord(contents, newContents);
+                if (record == null)
+                    return;
+
+                if (!ShouldCompact(record.Length) && TryAppend(postStorage, baseStreamName, record))
+                {
+                    contents = newContents;
+                    return;
+                }
+            }
+
+            Compact(postStorage, baseStreamName, filePath, newContents);
+        }
+
+        private bool ShouldCompact(int recordLength)
+        {
+            return recordCount >= MaxRecords
+                || journalLength + recordLength > Math.Max(baseLength / 4, MinJournalLength);
+        }
+
+        private bool TryAppend(Storage postStorage, string baseStreamName, byte[] record)
+        {
+            // if anyone else has touched the file since we last saw it, our idea of the
+            // current contents can't be trusted as the origin of the diff
+            if (postStorage.GetStat(baseStreamName).cbSize != baseLength)
+                return false;
+
+            if (journalLength == 0)
+            {
+                using (Stream journal = postStorage.OpenStream(StreamName, StorageMode.Create, true))
+                {
+                    byte[] header = CreateHeader((uint)baseLength, baseCrc);
+                    byte[] buffer = new byte[header.Length + record.Length];
+                    Buffer.BlockCopy(header, 0, buffer, 0, header.Length);
+                    Buffer.BlockCopy(record, 0, buffer, header.Length, record.Length);
+                    journal.Write(buffer, 0, buffer.Length);
+                }
+                journalLength = HeaderLength + record.Length;
+            }
+            else
+            {
+                try
+                {
+                    using (Stream journal = postStorage.OpenStream(StreamName, StorageMode.Open, true))
+                    {
+                        if (journal.Length != journalLength)
+                            return false;
+                        journal.Seek(journalLength, SeekOrigin.Begin);
+                        journal.Write(record, 0, record.Length);
+                    }
+                }
+                catch (StorageFileNotFoundException)
+                {
+                    return false;
+                }
+                journalLength += record.Length;
+            }
+
+            recordCount++;
+            return true;
+        }
+
+        private void Compact(Storage postStorage, string baseStreamName, string filePath, byte[] newContents)
+        {
+            using (Stream stream = postStorage.OpenStream(baseStreamName, StorageMode.Create, true))
+                stream.Write(newContents, 0, newContents.Length);
+
+            try
+            {
+                postStorage.DeleteElement(StreamName);
+            }
+            catch (StorageFileNotFoundException)
+            {
+            }
+
+            path = filePath;
+            contents = newContents;
+            baseCrc = Crc32(newContents, 0, newContents.Length);
+            baseLength = newContents.Length;
+            journalLength = 0;
+            recordCount = 0;
+        }
+
+        /// <summary>
+        /// Forgets the remembered contents, so the next Write rewrites the base. Used when
+        /// a save fails and the file may not be in the state we last wrote.
+        /// </summary>
+        public void Invalidate()
+        {
+            path = null;
+            contents = null;
+            baseCrc = 0;
+            baseLength = 0;
+            journalLength = 0;
+            recordCount = 0;
+        }
+
+        private static byte[] ReadStream(PostFileReader postStorage, string streamName)
+        {
+            using (Stream stream = postStorage.OpenStream(streamName))
+            {
+                byte[] buffer = new byte[stream.Length];
+                int totalRead = 0;
+                while (totalRead < buffer.Length)
+                {
+                    int read = stream.Read(buffer, totalRead, buffer.Length - totalRead);
+                    if (read == 0)
+                        break;
+                    totalRead += read;
+                }
+                if (totalRead != buffer.Length)
+                    Array.Resize(ref buffer, totalRead);
+                return buffer;
+            }
+        }
+
+        /// <summary>
+        /// Creates the journal header for the given base contents.
+        /// </summary>
+        public static byte[] CreateHeader(byte[] baseContents)
+        {
+            return CreateHeader((uint)baseContents.Length, Crc32(baseContents, 0, baseContents.Length));
+        }
+
+        private static byte[] CreateHeader(uint length, uint crc)
+        {
+            byte[] header = new byte[HeaderLength];
+            PutUInt32(header, 0, Magic);
+            PutUInt32(header, 4, Version);
+            PutUInt32(header, 8, length);
+            PutUInt32(header, 12, crc);
+            return header;
+        }
+
+        /// <summary>
+        /// Creates a record that turns previous into current by replacing everything
+        /// between their common prefix and common suffix, or returns null if the two
+        /// are identical.
+        /// </summary>
+        public static byte[] CreateRecord(byte[] previous, byte[] current)
+        {
+            int prefix = 0;
+            int maxPrefix = Math.Min(previous.Length, current.Length);
+            while (prefix < maxPrefix && previous[prefix] == current[prefix])
+                prefix++;
+
+            if (prefix == previous.Length && prefix == current.Length)
+                return null;
+
+            int suffix = 0;
+            int maxSuffix = maxPrefix - prefix;
+            while (suffix < maxSuffix && previous[previous.Length - suffix - 1] == current[current.Length - suffix - 1])
+                suffix++;
+
+            int removed = previous.Length - prefix - suffix;
+            int inserted = current.Length - prefix - suffix;
+
+            byte[] record = new byte[RecordHeaderLength + PayloadHeaderLength + inserted];
+            PutUInt32(record, 0, (uint)(PayloadHeaderLength + inserted));
+            PutUInt32(record, RecordHeaderLength, (uint)prefix);
+            PutUInt32(record, RecordHeaderLength + 4, (uint)removed);
+            Buffer.BlockCopy(current, prefix, record, RecordHeaderLength + PayloadHeaderLength, inserted);
+            PutUInt32(record, 4, Crc32(record, RecordHeaderLength, PayloadHeaderLength + inserted));
+            return record;
+        }
+
+        /// <summary>
+        /// Applies the records in a journal to the base contents. validLength receives the
+        /// length of the journal up to the end of the last intact record (0 if the journal
+        /// doesn't belong to this base), records the number of records applied.
+        /// </summary>
+        public static byte[] Apply(byte[] baseContents, Stream journal, out long validLength, out int records)
+        {
+            validLength = 0;
+            records = 0;
+
+            byte[] header = new byte[HeaderLength];
+            if (!ReadFully(journal, header, HeaderLength)
+                || GetUInt32(header, 0) != Magic
+                || GetUInt32(header, 4) != Version
+                || GetUInt32(header, 8) != (uint)baseContents.Length
+                || GetUInt32(header, 12) != Crc32(baseContents, 0, baseContents.Length))
+            {
+                return baseContents;
+            }
+            validLength = HeaderLength;
+
+            byte[] current = baseContents;
+            byte[] recordHeader = new byte[RecordHeaderLength];
+            while (ReadFully(journal, recordHeader, RecordHeaderLength))
+            {
+                uint payloadLength = GetUInt32(recordHeader, 0);
+                if (payloadLength < PayloadHeaderLength || payloadLength > journal.Length - journal.Position)
+                    break;
+
+                byte[] payload = new byte[payloadLength];
+                if (!ReadFully(journal, payload, payload.Length) || Crc32(payload, 0, payload.Length) != GetUInt32(recordHeader, 4))
+                    break;
+
+                uint offset = GetUInt32(payload, 0);
+                uint removed = GetUInt32(payload, 4);
+                int inserted = payload.Length - PayloadHeaderLength;
+                if ((ulong)offset + removed > (ulong)current.Length)
+                    break;
+
+                byte[] next = new byte[current.Length - removed + inserted];
+                Buffer.BlockCopy(current, 0, next, 0, (int)offset);
+                Buffer.BlockCopy(payload, PayloadHeaderLength, next, (int)offset, inserted);
+                Buffer.BlockCopy(current, (int)(offset + removed), next, (int)offset + inserted, current.Length - (int)(offset + removed));
+                current = next;
+
+                validLength += RecordHeaderLength + payloadLength;
+                records++;
+            }
+
+            return current;
+        }
+
+        private static bool ReadFully(Stream stream, byte[] buffer, int count)
+        {
+            int totalRead = 0;
+            while (totalRead < count)
+            {
+                int read = stream.Read(buffer, totalRead, count - totalRead);
+                if (read == 0)
+                    return false;
+                totalRead += read;
+            }
+            return true;
+        }
+
+        private static void PutUInt32(byte[] buffer, int offset, uint value)
+        {
+            buffer[offset] = (byte)value;
+            buffer[offset + 1] = (byte)(value >> 8);
+            buffer[offset + 2] = (byte)(value >> 16);
+            buffer[offset + 3] = (byte)(value >> 24);
+        }
+
+        private static uint GetUInt32(byte[] buffer, int offset)
+        {
+            return (uint)(buffer[offset] | (buffer[offset + 1] << 8) | (buffer[offset + 2] << 16) | (buffer[offset + 3] << 24));
+        }
+
+        private static readonly uint[] crcTable = CreateCrcTable();
+
+        private static uint[] CreateCrcTable()
+        {
+            uint[] table = new uint[256];
+            for (uint i = 0; i < table.Length; i++)
+            {
+                uint c = i;
+                for (int k = 0; k < 8; k++)
+                    c = (c & 1) != 0 ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+                table[i] = c;
+            }
+            return table;
+        }
+
+        /// <summary>
+        /// Standard (IEEE 802.3) CRC-32.
+        /// </summary>
+        public static uint Crc32(byte[] buffer, int offset, int count)
+        {
+            uint crc = 0xFFFFFFFF;
+            for (int i = offset; i < offset + count; i++)
+                crc = crcTable[(crc ^ buffer[i]) & 0xFF] ^ (crc >> 8);
+            return crc ^ 0xFFFFFFFF;
+        }
+    }
+}
@@ -3,18 +3,22 @@
 
 using System;
 using System.Collections;
+using System.Collections.Generic;
 using System.Diagnostics;
 using System.Globalization;
 using System.IO;
 using System.Text;
+using System.Threading;
 using System.Xml;
 using OpenLiveWriter.BlogClient;
+using OpenLiveWriter.Controls;
 using OpenLiveWriter.CoreServices;
 using OpenLiveWriter.CoreServices.HTML;
 using OpenLiveWriter.Extensibility.BlogClient;
 using OpenLiveWriter.HtmlParser.Parser;
 using OpenLiveWriter.Interop.Com.StructuredStorage;
 using OpenLiveWriter.Interop.Windows;
+using OpenLiveWriter.Localization;
 using OpenLiveWriter.PostEditor.SupportingFiles;
 
 namespace OpenLiveWriter.PostEditor
@@ -52,7 +56,7 @@ public static PostEditorFileLookupCache.PostKey ReadFile(FileInfo file)
         {
             try
             {
-                using (Storage postStorage = new Storage(file.FullName, StorageMode.Open, false))
+                using (PostFileReader postStorage = PostFileReader.Open(file.FullName))
                 {
                     string blogId = ReadString(postStorage, DESTINATION_BLOG_ID);
                     string postId = ReadString(postStorage, POST_ID);
@@ -130,7 +134,7 @@ public static PostInfo GetPostInfo(FileInfo file)
             try
             {
                 // get post
-                using (Storage postStorage = new Storage(file.FullName, StorageMode.Open, false))
+                using (PostFileReader postStorage = PostFileReader.Open(file.FullName))
                 {
                     PostInfo postInfo = new PostInfo();
                     postInfo.Id = file.FullName;
@@ -140,7 +144,7 @@ public static PostInfo GetPostInfo(FileInfo file)
                     postInfo.BlogName = ReadBlogName(postStorage);
                     postInfo.BlogId = ReadString(postStorage, DESTINATION_BLOG_ID);
                     postInfo.BlogPostId = ReadString(postStorage, POST_ID);
-                    postInfo.Contents = ReadStringUtf8(postStorage, POST_CONTENTS);
+                    postInfo.Contents = DecodeUtf8(PostContentsJournal.ReadContents(postStorage, POST_CONTENTS));
                     postInfo.DateModified = file.LastWriteTimeUtc;
                     return postInfo;
                 }
@@ -172,7 +176,7 @@ public static bool IsValid(string filePath)
                             // ensure that this isn't a storage with no streams!
                             try
                             {
-                                ReadString(storage, POST_ID);
+                                ReadString(PostFileReader.FromStorage(storage), POST_ID);
                                 return true;
                             }
                             catch
@@ -257,6 +261,72 @@ public static void Initialize()
                 Trace.WriteLine("Could not access recent posts folder: " + ex);
                 throw new DirectoryException(RecentPostsFolder.FullName);
             }
+
+            ThreadPool.QueueUserWorkItem(new WaitCallback(CollectSupportingFileBlobs));
+        }
+
+        private static SupportingFileBlobStore SupportingFileBlobs
+        {
+            get
+            {
+                return new SupportingFileBlobStore(new DirectoryInfo(Path.Combine(MyWeblogPostsFolder.FullName, "Supporting Files")));
+            }
+        }
+
+        private static readonly TimeSpan SupportingFileBlobGracePeriod = TimeSpan.FromDays(30);
+
+        /// <summary>
+        /// Autosaved posts, which are rewritten every few minutes and never leave the AutoRecover
+        /// folder, share a single copy of each image and attachment. Drafts, recent posts and
+        /// posts saved anywhere else embed their supporting files, so that they can still be
+        /// opened after being copied, restored from a backup or moved to another machine.
+        /// </summary>
+        private static SupportingFileBlobStore GetSupportingFileBlobStore(string filePath)
+        {
+            string directory = Path.GetDirectoryName(Path.GetFullPath(filePath));
+            string autoSaveDirectory = Path.GetFullPath(PostEditorSettings.AutoSaveDirectory).TrimEnd(Path.DirectorySeparatorChar);
+            if (string.Equals(directory, autoSaveDirectory, StringComparison.OrdinalIgnoreCase))
+                return SupportingFileBlobs;
+            return null;
+        }
+
+        /// <summary>
+        /// Counts the references to shared supporting files from the autosaved posts, the only
+        /// ones written with references, and removes the files that are no longer referenced.
+        /// Drafts and recent posts embed their supporting files, so they aren't opened.
+        /// </summary>
+        private static void CollectSupportingFileBlobs(object state)
+        {
+            try
+            {
+                Dictionary<string, int> referenceCounts = new Dictionary<string, int>(StringComparer.OrdinalIgnoreCase);
+                DirectoryInfo autoSaveFolder = new DirectoryInfo(PostEditorSettings.AutoSaveDirectory);
+                if (autoSaveFolder.Exists)
+                {
+                    foreach (FileInfo file in autoSaveFolder.GetFiles("*" + Extension))
+                    {
+                        try
+                        {
+                            using (Storage postStorage = new Storage(file.FullName, StorageMode.Open, false))
+                            using (Storage supportingFiles = postStorage.OpenStorage(POST_SUPPORTING_FILES, StorageMode.Open, false))
+                                SupportingFilePersister.CountBlobReferences(supportingFiles, referenceCounts);
+                        }
+                        catch (StorageFileNotFoundException)
+                        {
+                            // no supporting files
+                        }
+                    }
+                }
+
+                int deleted = SupportingFileBlobs.CollectGarbage(referenceCounts, SupportingFileBlobGracePeriod);
+                if (deleted > 0)
+                    Trace.WriteLine(String.Format(CultureInfo.InvariantCulture, "Removed {0} unreferenced supporting files", deleted));
+            }
+            catch (Exception ex)
+            {
+                // any post we couldn't read might reference anything, so give up until next time
+                Trace.WriteLine("Failed to collect unreferenced supporting files: " + ex);
+            }
         }
 
         #endregion
@@ -326,7 +396,7 @@ public IBlogPostEditingContext Load(bool addToRecentDocs)
                 if (addToRecentDocs)
                     Shell32.SHAddToRecentDocs(SHARD.PATHW, TargetFile.FullName);
 
-                using (Storage postStorage = new Storage(TargetFile.FullName, StorageMode.Open, false))
+                using (PostFileReader postStorage = PostFileReader.Decode(TargetFile.FullName))
                 {
                     // meta-data
                     string destinationBlogId = ReadString(postStorage, DESTINATION_BLOG_ID);
@@ -360,39 +430,34 @@ public IBlogPostEditingContext Load(bool addToRecentDocs)
                     blogPost.ETag = SafeReadString(postStorage, POST_ETAG, String.Empty);
                     blogPost.AtomRemotePost = (XmlDocument)SafeReadXml(postStorage, POST_ATOM_REMOTE_POST, new XmlReadHandler(XmlDocReadHandler), null);
 
-                    try
-                    {
+                    //BACKWARDS_COMPATABILITY: missing if this file was created before the introduction of content signatures (pre-Beta2)
+                    if (postStorage.Contains(POST_CONTENTS_VERSION_SIGNATURE))
                         blogPost.ContentsVersionSignature = ReadString(postStorage, POST_CONTENTS_VERSION_SIGNATURE);
-                    }
-                    catch (StorageFileNotFoundException) { } //BACKWARDS_COMPATABILITY: occurs if this file was created before the introduction of content signatures (pre-Beta2)
 
                     // post contents (must extract supporting files -- protect against leakage with try/catch
                     BlogPostSupportingFileStorage supportingFileStorage = new BlogPostSupportingFileStorage();
-                    using (Storage postSupportStorage = postStorage.OpenStorage(POST_SUPPORTING_FILES, StorageMode.Open, false))
+                    using (PostFileReader postSupportStorage = postStorage.OpenStorage(POST_SUPPORTING_FILES))
                     {
                         SupportingFilePersister supportingFilePersister = new SupportingFilePersister(postSupportStorage, supportingFileStorage);
 
                         //read the attached files
                         SupportingFileService supportingFileService = new SupportingFileService(supportingFileStorage);
-                        try
-                        {
+                        if (postStorage.Contains(POST_ATTACHED_FILES)) //missing if this file was created before the introduction of extension data
                             ReadXml(postStorage, POST_ATTACHED_FILES, new XmlReadHandler(new AttachedFileListReader(supportingFileService, supportingFilePersister).ReadAttachedFileList));
-                        }
-                        catch (StorageFileNotFoundException) { } //occurs if this file was created before the introduction of extension data
 
                         //read in the image data (note: this must happen before fixing the file references)
                         BlogPostImageDataList imageDataList = (BlogPostImageDataList)ReadXml(postStorage, POST_IMAGE_FILES, new XmlReadHandler(new ImageListReader(supportingFilePersister, supportingFileService).ReadImageFiles));
 
                         //read the extension data settings
                         BlogPostExtensionDataList extensionDataList = new BlogPostExtensionDataList(supportingFileService);
-                        try
-                        {
+                        if (postStorage.Contains(POST_EXTENSION_DATA_LIST)) //missing if this file was created before the introduction of extension data
                             ReadXml(postStorage, POST_EXTENSION_DATA_LIST, new XmlReadHandler(new ExtensionDataListReader(extensionDataList, supportingFilePersister, supportingFileService).ReadExtensionDataList));
-                        }
-                        catch (StorageFileNotFoundException) { } //occurs if this file was created before the introduction of extension data
 
                         //fix up the HTML content to reference the extracted files
-                        blogPost.Contents = supportingFilePersister.FixupHtmlReferences(ReadStringUtf8(postStorage, POST_CONTENTS));
+                        blogPost.Contents = supportingFilePersister.FixupHtmlReferences(DecodeUtf8(contentsJournal.Read(postStorage, POST_CONTENTS, TargetFile.FullName)));
+
+                        if (supportingFilePersister.MissingFileCount > 0)
+                            DisplayMessage.Show(MessageId.PostSupportingFilesMissing, TargetFile.Name, supportingFilePersister.MissingFileCount);
 
                         string originalSourcePath = SafeReadString(postStorage, ORIGINAL_SOURCE_PATH, null);
                         PostEditorFile autoSaveFile;
@@ -445,22 +510,25 @@ private PostEditorFile GetFileFromSourcePath(string originalSourcePath, out Post
         /// this AutoSave operation is storing changes for.</param>
         public void AutoSave(IBlogPostEditingContext editingContext, PostEditorFile autoSaveSourceFile)
         {
-            SaveCore(editingContext, autoSaveSourceFile, ManagePostFilePath(editingContext.BlogPost.IsPage, editingContext.BlogPost.Title));
+            SaveCore(editingContext, autoSaveSourceFile, ManagePostFilePath(editingContext.BlogPost.IsPage, editingContext.BlogPost.Title), true);
         }
 
         public void SaveBlogPost(IBlogPostEditingContext editingContext)
         {
             string filePath = ManagePostFilePath(editingContext.BlogPost.IsPage, editingContext.BlogPost.Title);
-            SaveCore(editingContext, null, filePath);
+            SaveCore(editingContext, null, filePath, false);
             Shell32.SHAddToRecentDocs(SHARD.PATHW, filePath);
         }
 
         public void SaveContentEditorFile(IBlogPostEditingContext editingContext, string fileNameOverride, bool addToRecentDocs)
         {
-            SaveCore(editingContext, null, fileNameOverride);
+            SaveCore(editingContext, null, fileNameOverride, false);
         }
 
-        private void SaveCore(IBlogPostEditingContext editingContext, PostEditorFile autoSaveSourceFile, string filePath)
+        // journalContents appends the contents to the contents journal as a delta rather than
+        // rewriting them (autosave); explicit saves always compact the journal so the saved
+        // file carries a complete Contents stream
+        private void SaveCore(IBlogPostEditingContext editingContext, PostEditorFile autoSaveSourceFile, string filePath, bool journalContents)
         {
             // did this file exist prior to the attempt to save (if no, we need to delete
             // it if an exception occurs -- otherwise we leave a "zombie" post file with
@@ -515,7 +583,7 @@ private void SaveCore(IBlogPostEditingContext editingContext, PostEditorFile aut
                         WriteString(postStorage, POST_CONTENTS_VERSION_SIGNATURE, blogPost.ContentsVersionSignature);
 
                         // contents (with fixups for local files)
-                        SupportingFilePersister supportingFilePersister = new SupportingFilePersister(postStorage.OpenStorage(POST_SUPPORTING_FILES, StorageMode.Create, true));
+                        SupportingFilePersister supportingFilePersister = new SupportingFilePersister(postStorage.OpenStorage(POST_SUPPORTING_FILES, StorageMode.Create, true), GetSupportingFileBlobStore(filePath));
                         //BlogPostReferenceFixedHandler fixedReferenceHandler = new BlogPostReferenceFixedHandler(editingContext.ImageDataList);
                         //string fixedUpPostContents = supportingFilePersister.SaveFilesAndFixupReferences(blogPost.Contents, new ReferenceFixedCallback(fixedReferenceHandler.HandleReferenceFixed)) ;
 
@@ -531,7 +599,7 @@ private void SaveCore(IBlogPostEditingContext editingContext, PostEditorFile aut
 
                         //Convert file references in the HTML contents to the new storage path
                         string fixedUpPostContents = supportingFilePersister.FixupHtmlReferences(blogPost.Contents);
-                        WriteStringUtf8(postStorage, POST_CONTENTS, fixedUpPostContents);
+                        contentsJournal.Write(postStorage, POST_CONTENTS, filePath, EncodeUtf8(fixedUpPostContents), journalContents);
 
                         string originalSourcePath = autoSaveSourceFile == null ? ""
                             : autoSaveSourceFile.IsSaved ? autoSaveSourceFile.TargetFile.FullName
@@ -554,6 +622,9 @@ private void SaveCore(IBlogPostEditingContext editingContext, PostEditorFile aut
             }
             catch
             {
+                // the file can no longer be assumed to hold what we last wrote
+                contentsJournal.Invalidate();
+
                 // if we had no file previously and an exception occurs then
                 // we need to delete the file
                 if (isPreviouslyUnsaved && File.Exists(filePath))
@@ -730,14 +801,12 @@ private static void WriteString(Storage postStorage, string fieldName, string fi
                 writer.Write(fieldValue);
         }
 
-        private static string ReadString(Storage postStorage, string fieldName)
+        private static string ReadString(PostFileReader postStorage, string fieldName)
         {
-
-            using (StreamReader reader = new StreamReader(postStorage.OpenStream(fieldName, StorageMode.Open, false), ucs16Encoding))
-                return reader.ReadToEnd();
+            return postStorage.ReadString(fieldName);
         }
 
-        private static string SafeReadString(Storage postStorage, string fieldName, string defaultValue)
+        private static string SafeReadString(PostFileReader postStorage, string fieldName, string defaultValue)
         {
             try
             {
@@ -757,7 +826,7 @@ private static void WriteBoolean(Storage postStorage, string fieldName, bool fie
                 WriteString(postStorage, fieldName, "0");
         }
 
-        private static bool SafeReadBoolean(Storage postStorage, string fieldName, bool defaultValue)
+        private static bool SafeReadBoolean(PostFileReader postStorage, string fieldName, bool defaultValue)
         {
             try
             {
@@ -769,7 +838,7 @@ private static bool SafeReadBoolean(Storage postStorage, string fieldName, bool
             }
         }
 
-        private static bool ReadBoolean(Storage postStorage, string fieldName)
+        private static bool ReadBoolean(PostFileReader postStorage, string fieldName)
         {
             string booleanValue = ReadString(postStorage, fieldName);
             return (booleanValue == "1");
@@ -781,16 +850,25 @@ private static void WriteStringUtf8(Storage postStorage, string fieldName, strin
                 writer.Write(fieldValue);
         }
 
-        private static string ReadStringUtf8(Storage postStorage, string fieldName)
+        private static byte[] EncodeUtf8(string value)
         {
+            using (MemoryStream stream = new MemoryStream())
+            {
+                using (StreamWriter writer = new StreamWriter(stream, utf8Encoding))
+                    writer.Write(value);
+                return stream.ToArray();
+            }
+        }
 
-            using (StreamReader reader = new StreamReader(postStorage.OpenStream(fieldName, StorageMode.Open, false), utf8Encoding))
+        private static string DecodeUtf8(byte[] value)
+        {
+            using (StreamReader reader = new StreamReader(new MemoryStream(value), utf8Encoding))
                 return reader.ReadToEnd();
         }
 
-        private static DateTime ReadDateTime(Storage postStorage, string fieldName)
+        private static DateTime ReadDateTime(PostFileReader postStorage, string fieldName)
         {
-            using (BinaryReader reader = new BinaryReader(postStorage.OpenStream(fieldName, StorageMode.Open, false)))
+            using (BinaryReader reader = new BinaryReader(postStorage.OpenStream(fieldName)))
                 return new DateTime(reader.ReadInt64());
         }
 
@@ -815,9 +893,9 @@ private static void WriteXml(Storage postStorage, string streamName, object data
             }
         }
 
-        private static object ReadXml(Storage postStorage, string streamName, XmlReadHandler readHandler)
+        private static object ReadXml(PostFileReader postStorage, string streamName, XmlReadHandler readHandler)
         {
-            XmlTextReader reader = new XmlTextReader(new StreamReader(postStorage.OpenStream(streamName, StorageMode.Open, false), utf8Encoding, false));
+            XmlTextReader reader = new XmlTextReader(new StreamReader(postStorage.OpenStream(streamName), utf8Encoding, false));
             try
             {
                 return readHandler(reader);
@@ -831,7 +909,7 @@ private static object ReadXml(Storage postStorage, string streamName, XmlReadHan
         private delegate void XmlWriteHandler(XmlTextWriter writer, object data);
         private delegate object XmlReadHandler(XmlTextReader reader);
 
-        private static object SafeReadXml(Storage postStorage, string streamName, XmlReadHandler readHandler, object defaultValue)
+        private static object SafeReadXml(PostFileReader postStorage, string streamName, XmlReadHandler readHandler, object defaultValue)
         {
             try
             {
@@ -866,7 +944,7 @@ private void WriteCommentPolicy(Storage postStorage, BlogCommentPolicy commentPo
             }
         }
 
-        private BlogCommentPolicy ReadCommentPolicy(Storage postStorage)
+        private BlogCommentPolicy ReadCommentPolicy(PostFileReader postStorage)
         {
             string commentPolicy = ReadString(postStorage, POST_COMMENT_POLICY);
             switch (commentPolicy)
@@ -905,7 +983,7 @@ private void WriteTrackbackPolicy(Storage postStorage, BlogTrackbackPolicy track
             }
         }
 
-        private BlogTrackbackPolicy ReadTrackbackPolicy(Storage postStorage)
+        private BlogTrackbackPolicy ReadTrackbackPolicy(PostFileReader postStorage)
         {
             string trackbackPolicy = ReadString(postStorage, POST_TRACKBACK_POLICY);
             switch (trackbackPolicy)
@@ -1707,7 +1785,7 @@ private static string ReadBlogPostSettingsBag(XmlTextReader reader, BlogPostSett
             return settingsBagName;
         }
 
-        private static string ReadBlogName(Storage postStorage)
+        private static string ReadBlogName(PostFileReader postStorage)
         {
             string blogId = ReadString(postStorage, DESTINATION_BLOG_ID);
             if (BlogSettings.BlogIdIsValid(blogId))
@@ -1827,9 +1905,19 @@ public SupportingFilePersister(Storage fileSubStorage)
                 _fileSubStorage = fileSubStorage;
             }
 
-            public SupportingFilePersister(Storage fileSubStorage, BlogPostSupportingFileStorage supportingFileStorage)
+            /// <summary>
+            /// When blobStore is not null, file contents are added to the store and only their
+            /// hash is written to the post.
+            /// </summary>
+            public SupportingFilePersister(Storage fileSubStorage, SupportingFileBlobStore blobStore)
                 : this(fileSubStorage)
             {
+                _blobStore = blobStore;
+            }
+
+            public SupportingFilePersister(PostFileReader fileSubStorage, BlogPostSupportingFileStorage supportingFileStorage)
+            {
+                _fileSubReader = fileSubStorage;
                 _supportingFileStorage = supportingFileStorage;
             }
 
@@ -1840,10 +1928,30 @@ public SupportingFilePersister(Storage fileSubStorage, BlogPostSupportingFileSto
             /// <returns></returns>
             public string FixupHtmlReferences(string postContents)
             {
-                string fixedUpContents = HtmlReferenceFixer.FixReferences(postContents, new ReferenceFixer(FixReference));
+                string fixedUpContents;
+                if (HtmlReferenceRewriter.TryRewrite(postContents, ReferenceSpellings(), out fixedUpContents))
+                    return fixedUpContents;
+
+                fixedUpContents = HtmlReferenceFixer.FixReferences(postContents, new ReferenceFixer(FixReference));
                 return fixedUpContents;
             }
 
+            /// <summary>
+            /// The ways the references in the table are written in post contents; the
+            /// native rewriter compares strings rather than Uris.
+            /// </summary>
+            private IEnumerable<KeyValuePair<string, string>> ReferenceSpellings()
+            {
+                foreach (DictionaryEntry entry in referencesTable)
+                {
+                    Uri referenceUri = (Uri)entry.Key;
+                    string fixedReference = (string)entry.Value;
+                    yield return new KeyValuePair<string, string>(referenceUri.OriginalString, fixedReference);
+                    if (referenceUri.AbsoluteUri != referenceUri.OriginalString)
+                        yield return new KeyValuePair<string, string>(referenceUri.AbsoluteUri, fixedReference);
+                }
+            }
+
             public string[] SaveFilesAndFixupReferences(string[] references)
             {
                 string[] fixedReferences = new string[references.Length];
@@ -1883,24 +1991,28 @@ private string SaveToStorageReferenceFixer(string reference)
                     return (string)referencesTable[referenceUri];
 
                 string filePath = referenceUri.LocalPath;
-                using (FileStream referenceStream = new FileStream(filePath, FileMode.Open, FileAccess.Read))
+                Guid localFileAlias = Guid.NewGuid();
+                using (Storage localFileStorage = _fileSubStorage.OpenStorage(localFileAlias, StorageMode.Create, true))
                 {
-                    Guid localFileAlias = Guid.NewGuid();
-                    using (Storage localFileStorage = _fileSubStorage.OpenStorage(localFileAlias, StorageMode.Create, true))
-                    {
-                        WriteString(localFileStorage, SUPPORTING_FILE_NAME, Path.GetFileName(filePath));
+                    WriteString(localFileStorage, SUPPORTING_FILE_NAME, Path.GetFileName(filePath));
 
+                    if (_blobStore != null)
+                    {
+                        WriteString(localFileStorage, SUPPORTING_FILE_BLOB, _blobStore.AddFile(filePath));
+                    }
+                    else
+                    {
+                        using (FileStream referenceStream = new FileStream(filePath, FileMode.Open, FileAccess.Read))
                         using (Stream localFileStream = localFileStorage.OpenStream(SUPPORTING_FILE_CONTENTS, StorageMode.Create, true))
                             StreamHelper.Transfer(referenceStream, localFileStream);
-
-                        localFileStorage.Commit();
                     }
 
-                    string fixedReference = SUPPORTING_FILE_PREFIX + localFileAlias.ToString();
-                    referencesTable[referenceUri] = fixedReference;
-                    return fixedReference;
+                    localFileStorage.Commit();
                 }
 
+                string fixedReference = SUPPORTING_FILE_PREFIX + localFileAlias.ToString();
+                referencesTable[referenceUri] = fixedReference;
+                return fixedReference;
             }
 
             public string[] LoadFilesAndFixupReferences(string[] references)
@@ -1923,11 +2035,11 @@ private string LoadFromStorageReferenceFixer(string reference)
                     if (referencesTable.ContainsKey(reference))
                         return (string)referencesTable[new Uri(reference)];
 
-                    using (Storage localFileStorage = _fileSubStorage.OpenStorage(localFileAlias, StorageMode.Open, false))
+                    using (PostFileReader localFileStorage = _fileSubReader.OpenStorage(localFileAlias))
                     {
                         string fileName = ReadString(localFileStorage, SUPPORTING_FILE_NAME);
 
-                        using (Stream localFileStream = localFileStorage.OpenStream(SUPPORTING_FILE_CONTENTS, StorageMode.Open, false))
+                        using (Stream localFileStream = OpenSupportingFileContents(localFileStorage, fileName))
                         {
                             string localFileUri = _supportingFileStorage.AddFile(fileName, localFileStream);
 
@@ -1943,12 +2055,77 @@ private string LoadFromStorageReferenceFixer(string reference)
                 }
             }
 
+            /// <summary>
+            /// Opens the contents of a supporting file, which is either embedded in the post or,
+            /// for autosaved posts, kept in the shared blob store. A shared file that has gone
+            /// missing (say the post was copied to another machine) loads as an empty file, so
+            /// that the rest of the post can still be recovered.
+            /// </summary>
+            private Stream OpenSupportingFileContents(PostFileReader localFileStorage, string fileName)
+            {
+                if (localFileStorage.Contains(SUPPORTING_FILE_CONTENTS))
+                    return localFileStorage.OpenStream(SUPPORTING_FILE_CONTENTS);
+
+                string blobHash = ReadString(localFileStorage, SUPPORTING_FILE_BLOB);
+                try
+                {
+                    return SupportingFileBlobs.Open(blobHash);
+                }
+                catch (FileNotFoundException)
+                {
+                }
+                catch (DirectoryNotFoundException)
+                {
+                }
+
+                Trace.WriteLine("Supporting file " + fileName + " is missing from the shared store: " + blobHash);
+                _missingFileCount++;
+                return new MemoryStream(new byte[0], false);
+            }
+
+            /// <summary>
+            /// The number of supporting files that were missing from the shared store and loaded
+            /// as empty files.
+            /// </summary>
+            public int MissingFileCount
+            {
+                get { return _missingFileCount; }
+            }
+
+            /// <summary>
+            /// Adds one reference to referenceCounts for every supporting file in the post that
+            /// is kept in the shared blob store.
+            /// </summary>
+            public static void CountBlobReferences(Storage fileSubStorage, IDictionary<string, int> referenceCounts)
+            {
+                foreach (System.Runtime.InteropServices.ComTypes.STATSTG element in fileSubStorage.Elements)
+                {
+                    if (element.type != (int)STGTY.STORAGE)
+                        continue;
+
+                    using (Storage localFileStorage = fileSubStorage.OpenStorage(element.pwcsName, StorageMode.Open, false))
+                    {
+                        string blobHash = SafeReadString(PostFileReader.FromStorage(localFileStorage), SUPPORTING_FILE_BLOB, null);
+                        if (blobHash == null)
+                            continue;
+
+                        int references;
+                        referenceCounts.TryGetValue(blobHash, out references);
+                        referenceCounts[blobHash] = references + 1;
+                    }
+                }
+            }
+
             private Storage _fileSubStorage;
+            private PostFileReader _fileSubReader;
             private BlogPostSupportingFileStorage _supportingFileStorage;
+            private SupportingFileBlobStore _blobStore;
+            private int _missingFileCount;
 
             public const string SUPPORTING_FILE_PREFIX = "SupportingFileReference://";
             private const string SUPPORTING_FILE_NAME = "SupportingFileName";
             private const string SUPPORTING_FILE_CONTENTS = "SupportingFileContents";
+            private const string SUPPORTING_FILE_BLOB = "SupportingFileBlob";
         }
 
         #endregion
@@ -1985,6 +2162,10 @@ private DirectoryInfo TargetDirectory
 
         private DirectoryInfo _targetDirectory = null;
 
+        // remembers the contents last read from or written to TargetFile so autosaves
+        // only have to append the difference
+        private readonly PostContentsJournal contentsJournal = new PostContentsJournal();
+
         internal const string Extension = ".wpost";
         private static readonly Guid Version1FormatCLSID = new Guid("20EBD150-5362-417a-8221-84331F79D41D");
         private static readonly Guid Version2FormatCLSID = new Guid("23F4998B-67EB-450b-A41B-C978F5B4AE25");
@@ -0,0 +1,485 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.IO;
+using System.Runtime.InteropServices;
+using System.Runtime.InteropServices.ComTypes;
+using System.Text;
+using OpenLiveWriter.Interop.Com;
+using OpenLiveWriter.Interop.Com.StructuredStorage;
+using OpenLiveWriter.Interop.Windows;
+
+namespace OpenLiveWriter.PostEditor
+{
+    /// <summary>
+    /// Reads the streams of a post file, or of a storage in one.
+    ///
+    /// Decode reads the whole file natively in one pass (OpenLiveWriter.Native.dll walks
+    /// the compound file's directory once and copies every stream straight into one
+    /// managed buffer), so opening a stream after that costs nothing but a lookup and
+    /// strings are decoded straight from the buffer. Open and FromStorage read through
+    /// structured storage a stream at a time, as Decode also does when the native
+    /// decoder can't be used, and for streams too long to be worth copying.
+    /// Either way Contains says whether an optional stream is there, so it needn't be
+    /// opened to find out.
+    /// </summary>
+    public abstract class PostFileReader : IDisposable
+    {
+        // streams longer than this (large embedded pictures) are left in the file until
+        // they're opened, rather than copied into the decoded buffer
+        private const long MAX_DECODED_STREAM_LENGTH = 4 * 1024 * 1024;
+
+        private static readonly Encoding ucs16Encoding = new UnicodeEncoding(false, true);
+        private static readonly Encoding utf32BigEndianEncoding = new UTF32Encoding(true, true);
+
+        /// <summary>
+        /// Reads the post file at path, decoding it natively if possible.
+        /// </summary>
+        public static PostFileReader Decode(string path)
+        {
+            PostFileReader reader = TryDecode(path);
+            if (reader != null)
+                return reader;
+            return Open(path);
+        }
+
+        /// <summary>
+        /// Decodes the post file at path natively, returning null if the native decoder
+        /// isn't available or can't read the file.
+        /// </summary>
+        public static PostFileReader TryDecode(string path)
+        {
+            DecodedPostFile file = DecodedPostFile.TryDecode(path, MAX_DECODED_STREAM_LENGTH);
+            if (file == null)
+                return null;
+            return new DecodedReader(file, 0, true);
+        }
+
+        /// <summary>
+        /// Reads the post file at path through structured storage.
+        /// </summary>
+        public static PostFileReader Open(string path)
+        {
+            return new StorageReader(new Storage(path, StorageMode.Open, false), true);
+        }
+
+        /// <summary>
+        /// Reads a storage that is already open, which disposing the reader leaves open.
+        /// </summary>
+        public static PostFileReader FromStorage(Storage storage)
+        {
+            return new StorageReader(storage, false);
+        }
+
+        /// <summary>
+        /// Whether there is a stream or storage called name.
+        /// </summary>
+        public abstract bool Contains(string name);
+
+        /// <summary>
+        /// Opens the stream called name, throwing StorageFileNotFoundException if there
+        /// isn't one.
+        /// </summary>
+        public abstract Stream OpenStream(string name);
+
+        /// <summary>
+        /// Reads the stream called name as a string written with its byte order mark, or
+        /// as UTF-16 if it has none.
+        /// </summary>
+        public virtual string ReadString(string name)
+        {
+            using (StreamReader reader = new StreamReader(OpenStream(name), ucs16Encoding))
+                return reader.ReadToEnd();
+        }
+
+        /// <summary>
+        /// Opens the storage called name, throwing StorageFileNotFoundException if there
+        /// isn't one.
+        /// </summary>
+        public abstract PostFileReader OpenStorage(string name);
+
+        public PostFileReader OpenStorage(Guid name)
+        {
+            return OpenStorage(Storage.NameFromGuid(name));
+        }
+
+        public abstract void Dispose();
+
+        private static StorageFileNotFoundException NotFound(string name)
+        {
+            return new StorageFileNotFoundException(new COMException(name + " not found", STG_E.FILENOTFOUND));
+        }
+
+        private class StorageReader : PostFileReader
+        {
+            private readonly Storage _storage;
+            private readonly bool _ownsStorage;
+            private HashSet<string> _names;
+
+            public StorageReader(Storage storage, bool ownsStorage)
+            {
+                _storage = storage;
+                _ownsStorage = ownsStorage;
+            }
+
+            public override bool Contains(string name)
+            {
+                if (_names == null)
+                {
+                    _names = new HashSet<string>(StringComparer.OrdinalIgnoreCase);
+                    foreach (STATSTG element in _storage.Elements)
+                        _names.Add(element.pwcsName);
+                }
+                return _names.Contains(name);
+            }
+
+            public override Stream OpenStream(string name)
+            {
+                return _storage.OpenStream(name, StorageMode.Open, false);
+            }
+
+            public override PostFileReader OpenStorage(string name)
+            {
+                return new StorageReader(_storage.OpenStorage(name, StorageMode.Open, false), true);
+            }
+
+            public override void Dispose()
+            {
+                if (_ownsStorage)
+                    _storage.Dispose();
+            }
+        }
+
+        private class DecodedReader : PostFileReader
+        {
+            private readonly DecodedPostFile _file;
+            private readonly int _storage;
+            private readonly bool _ownsFile;
+
+            public DecodedReader(DecodedPostFile file, int storage, bool ownsFile)
+            {
+                _file = file;
+                _storage = storage;
+                _ownsFile = ownsFile;
+            }
+
+            public override bool Contains(string name)
+            {
+                return _file.Find(_storage, name) >= 0;
+            }
+
+            public override Stream OpenStream(string name)
+            {
+                return _file.OpenStream(Find(name, OpenLiveWriterNative.POST_FILE_STREAM));
+            }
+
+            public override string ReadString(string name)
+            {
+                int element = Find(name, OpenLiveWriterNative.POST_FILE_STREAM);
+                string value = _file.ReadString(element);
+                if (value != null)
+                    return value;
+                return base.ReadString(name);
+            }
+
+            public override PostFileReader OpenStorage(string name)
+            {
+                return new DecodedReader(_file, Find(name, OpenLiveWriterNative.POST_FILE_STORAGE), false);
+            }
+
+            public override void Dispose()
+            {
+                if (_ownsFile)
+                    _file.Dispose();
+            }
+
+            private int Find(string name, int type)
+            {
+                int element = _file.Find(_storage, name);
+                if (element < 0 || _file.Elements[element].type != type)
+                    throw NotFound(name);
+                return element;
+            }
+        }
+
+        /// <summary>
+        /// A post file decoded by ReadPostFile, into a buffer of its own.
+        /// </summary>
+        private class DecodedPostFile : IDisposable
+        {
+            private static bool _nativeUnavailable;
+
+            private readonly string _path;
+            private readonly byte[] _buffer;
+            private readonly OpenLiveWriterNative.PostFileElement[] _elements;
+            private readonly Dictionary<string, int> _index = new Dictionary<string, int>(StringComparer.OrdinalIgnoreCase);
+            private Storage _storage;
+
+            public static DecodedPostFile TryDecode(string path, long maxStreamLength)
+            {
+                if (_nativeUnavailable)
+                    return null;
+
+                try
+                {
+                    IntPtr postFile;
+                    int length;
+                    int elementCount;
+                    int hr = OpenLiveWriterNative.OpenPostFile(path, maxStreamLength, out postFile, out length, out elementCount);
+                    if (hr != HRESULT.S_OK)
+                    {
+                        // structured storage will say what's wrong with the file, if anything is
+                        if (hr != HRESULT.S_FALSE)
+                            Trace.WriteLine("OpenPostFile failed: 0x" + hr.ToString("X8"));
+                        return null;
+                    }
+
+                    byte[] buffer;
+                    try
+                    {
+                        buffer = new byte[length];
+                        hr = OpenLiveWriterNative.ReadPostFile(postFile, buffer, length);
+                    }
+                    finally
+                    {
+                        OpenLiveWriterNative.ClosePostFile(postFile);
+                    }
+                    if (hr != HRESULT.S_OK)
+                    {
+                        if (hr != HRESULT.S_FALSE)
+                            Trace.WriteLine("ReadPostFile failed: 0x" + hr.ToString("X8"));
+                        return null;
+                    }
+                    return new DecodedPostFile(path, buffer, elementCount);
+                }
+                catch (DllNotFoundException)
+                {
+                    _nativeUnavailable = true;
+                }
+                catch (EntryPointNotFoundException)
+                {
+                    _nativeUnavailable = true;
+                }
+                Trace.WriteLine(OpenLiveWriterNative.DLL_NAME + " is not available, post files will be read through structured storage");
+                return null;
+            }
+
+            private DecodedPostFile(string path, byte[] buffer, int elementCount)
+            {
+                _path = path;
+                _buffer = buffer;
+                _elements = new OpenLiveWriterNative.PostFileElement[elementCount];
+
+                int size = Marshal.SizeOf(typeof(OpenLiveWriterNative.PostFileElement));
+                for (int i = 0; i < elementCount; i++)
+                {
+                    int offset = i * size;
+                    OpenLiveWriterNative.PostFileElement element;
+                    element.parent = BitConverter.ToInt32(buffer, offset);
+                    element.type = BitConverter.ToInt32(buffer, offset + 4);
+                    element.nameOffset = BitConverter.ToInt32(buffer, offset + 8);
+                    element.nameLength = BitConverter.ToInt32(buffer, offset + 12);
+                    element.encoding = BitConverter.ToInt32(buffer, offset + 16);
+                    element.flags = BitConverter.ToInt32(buffer, offset + 20);
+                    element.dataOffset = BitConverter.ToInt64(buffer, offset + 24);
+                    element.dataLength = BitConverter.ToInt64(buffer, offset + 32);
+                    _elements[i] = element;
+
+                    if (element.parent >= 0)
+                        _index[Key(element.parent, Encoding.Unicode.GetString(buffer, element.nameOffset, element.nameLength * 2))] = i;
+                }
+            }
+
+            public OpenLiveWriterNative.PostFileElement[] Elements
+            {
+                get { return _elements; }
+            }
+
+            /// <summary>
+            /// Finds the element called name in storage, or returns -1.
+            /// </summary>
+            public int Find(int storage, string name)
+            {
+                int element;
+                if (_index.TryGetValue(Key(storage, name), out element))
+                    return element;
+                return -1;
+            }
+
+            public Stream OpenStream(int element)
+            {
+                if (IsLoaded(element))
+                    return new MemoryStream(_buffer, (int)_elements[element].dataOffset, (int)_elements[element].dataLength, false);
+                return OpenFromStorage(element);
+            }
+
+            /// <summary>
+            /// Decodes a string from where it lies in the buffer, by the byte order mark the
+            /// native decoder found the way StreamReader would, or returns null if the
+            /// stream wasn't loaded.
+            /// </summary>
+            public string ReadString(int element)
+            {
+                if (!IsLoaded(element))
+                    return null;
+
+                int offset = (int)_elements[element].dataOffset;
+                int length = (int)_elements[element].dataLength;
+                switch (_elements[element].encoding)
+                {
+                    case OpenLiveWriterNative.POST_FILE_UTF16:
+                        return Encoding.Unicode.GetString(_buffer, offset + 2, length - 2);
+                    case OpenLiveWriterNative.POST_FILE_UTF8:
+                        return Encoding.UTF8.GetString(_buffer, offset + 3, length - 3);
+                    case OpenLiveWriterNative.POST_FILE_UTF16BE:
+                        return Encoding.BigEndianUnicode.GetString(_buffer, offset + 2, length - 2);
+                    case OpenLiveWriterNative.POST_FILE_UTF32:
+                        return Encoding.UTF32.GetString(_buffer, offset + 4, length - 4);
+                    case OpenLiveWriterNative.POST_FILE_UTF32BE:
+                        return utf32BigEndianEncoding.GetString(_buffer, offset + 4, length - 4);
+                    default:
+                        return ucs16Encoding.GetString(_buffer, offset, length);
+                }
+            }
+
+            public void Dispose()
+            {
+                if (_storage != null)
+                {
+                    _storage.Dispose();
+                    _storage = null;
+                }
+            }
+
+            private static string Key(int storage, string name)
+            {
+                return storage.ToString(System.Globalization.CultureInfo.InvariantCulture) + "\\" + name;
+            }
+
+            private bool IsLoaded(int element)
+            {
+                return (_elements[element].flags & OpenLiveWriterNative.POST_FILE_NOT_LOADED) == 0;
+            }
+
+            // streams that were too long to decode are read through structured storage, a
+            // bit at a time rather than whole
+            private Stream OpenFromStorage(int element)
+            {
+                List<string> names = new List<string>();
+                for (int i = _elements[element].parent; i > 0; i = _elements[i].parent)
+                    names.Insert(0, GetName(i));
+
+                if (_storage == null)
+                    _storage = new Storage(_path, StorageMode.Open, false);
+
+                List<Storage> opened = new List<Storage>();
+                try
+                {
+                    Storage storage = _storage;
+                    foreach (string name in names)
+                    {
+                        storage = storage.OpenStorage(name, StorageMode.Open, false);
+                        opened.Add(storage);
+                    }
+                    Stream stream = new StorageStream(storage.OpenStream(GetName(element), StorageMode.Open, false), opened);
+                    opened = null;
+                    return stream;
+                }
+                finally
+                {
+                    if (opened != null)
+                    {
+                        foreach (Storage storage in opened)
+                            storage.Dispose();
+                    }
+                }
+            }
+
+            private string GetName(int element)
+            {
+                return Encoding.Unicode.GetString(_buffer, _elements[element].nameOffset, _elements[element].nameLength * 2);
+            }
+        }
+
+        /// <summary>
+        /// A stream read through structured storage that keeps the storages it is in
+        /// open until it is closed.
+        /// </summary>
+        private class StorageStream : Stream
+        {
+            private readonly Stream _stream;
+            private readonly List<Storage> _storages;
+
+            public StorageStream(Stream stream, List<Storage> storages)
+            {
+                _stream = stream;
+                _storages = storages;
+            }
+
+            public override bool CanRead
+            {
+                get { return _stream.CanRead; }
+            }
+
+            public override bool CanSeek
+            {
+                get { return _stream.CanSeek; }
+            }
+
+            public override bool CanWrite
+            {
+                get { return false; }
+            }
+
+            public override long Length
+            {
+                get { return _stream.Length; }
+            }
+
+            public override long Position
+            {
+                get { return _stream.Position; }
+                set { _stream.Position = value; }
+            }
+
+            public override int Read(byte[] buffer, int offset, int count)
+            {
+                return _stream.Read(buffer, offset, count);
+            }
+
+            public override long Seek(long offset, SeekOrigin origin)
+            {
+                return _stream.Seek(offset, origin);
+            }
+
+            public override void Flush()
+            {
+            }
+
+            public override void SetLength(long value)
+            {
+                throw new NotSupportedException();
+            }
+
+            public override void Write(byte[] buffer, int offset, int count)
+            {
+                throw new NotSupportedException();
+            }
+
+            protected override void Dispose(bool disposing)
+            {
+                if (disposing)
+                {
+                    _stream.Dispose();
+                    foreach (Storage storage in _storages)
+                        storage.Dispose();
+                    _storages.Clear();
+                }
+                base.Dispose(disposing);
+            }
+        }
+    }
+}
@@ -57,6 +57,11 @@ public static Size GetImageSize(string imagePath)
         {
             using (FileStream fs = new FileStream(imagePath, FileMode.Open, FileAccess.Read))
             {
+                ImageHeader header;
+                if (ImageHeaderReader.TryRead(fs, out header))
+                    return header.Size;
+                fs.Seek(0, SeekOrigin.Begin);
+
                 using (Image img = System.Drawing.Image.FromStream(fs, false, false))
                 {
                     return img.Size;
@@ -389,6 +389,10 @@ internal static void InsertImagesCore(IBlogPostHtmlEditor currentEditor, ISuppor
                 // don't insert into the title
                 currentEditor.FocusBody();
 
+                // the local images' sizes and embedded thumbnails, from their headers in one batch
+                Stream[] embeddedThumbnails;
+                ImageHeader[] headers = ReadImageHeaders(imagePaths, out embeddedThumbnails);
+
                 for (int i = 0; i < imageInfos.Length; i++)
                 {
                     string imagePath = imagePaths[i];
@@ -409,7 +413,7 @@ internal static void InsertImagesCore(IBlogPostHtmlEditor currentEditor, ISuppor
                             try
                             {
                                 //check the validity of the image file
-                                imageSize = ImageUtils.GetImageSize(imagePath);
+                                imageSize = headers[i] != null ? headers[i].Size : ImageUtils.GetImageSize(imagePath);
                             }
                             catch (Exception)
                             {
@@ -425,7 +429,7 @@ internal static void InsertImagesCore(IBlogPostHtmlEditor currentEditor, ISuppor
 
                     // If the image has an embedded thumbnail, we'll use it as a place holder for the <img src="...">
                     // until we generate an inline image and apply decorators.
-                    Stream embeddedThumbnailStream = ImageHelper2.GetEmbeddedThumbnailStream(imagePath);
+                    Stream embeddedThumbnailStream = headers[i] != null ? embeddedThumbnails[i] : ImageHelper2.GetEmbeddedThumbnailStream(imagePath);
 
                     if (embeddedThumbnailStream != null)
                     {
@@ -466,6 +470,62 @@ internal static void InsertImagesCore(IBlogPostHtmlEditor currentEditor, ISuppor
             }
         }
 
+        /// <summary>
+        /// Reads the headers and embedded thumbnails of the local images in imagePaths,
+        /// leaving the headers of the rest (and of all of them if the native reader
+        /// isn't available) null.
+        /// </summary>
+        private static ImageHeader[] ReadImageHeaders(string[] imagePaths, out Stream[] embeddedThumbnails)
+        {
+            ImageHeader[] headers = new ImageHeader[imagePaths.Length];
+            embeddedThumbnails = new Stream[imagePaths.Length];
+
+            Stream[] streams = new Stream[imagePaths.Length];
+            try
+            {
+                for (int i = 0; i < imagePaths.Length; i++)
+                {
+                    try
+                    {
+                        if (!UrlHelper.IsUrl(imagePaths[i]) && File.Exists(imagePaths[i]))
+                            streams[i] = File.OpenRead(imagePaths[i]);
+                    }
+                    catch (IOException e)
+                    {
+                        Trace.WriteLine("Failed to open image " + imagePaths[i] + ": " + e.Message);
+                    }
+                    catch (UnauthorizedAccessException e)
+                    {
+                        Trace.WriteLine("Failed to open image " + imagePaths[i] + ": " + e.Message);
+                    }
+                }
+
+                ImageHeader[] read;
+                if (!ImageHeaderReader.TryRead(streams, out read))
+                    return headers;
+
+                for (int i = 0; i < imagePaths.Length; i++)
+                {
+                    if (read[i] == null)
+                        continue;
+
+                    byte[] thumbnail = ImageHeaderReader.ReadThumbnail(streams[i], read[i]);
+                    if (thumbnail != null)
+                        embeddedThumbnails[i] = StreamHelper.AsStream(thumbnail);
+                    headers[i] = read[i];
+                }
+                return headers;
+            }
+            finally
+            {
+                foreach (Stream stream in streams)
+                {
+                    if (stream != null)
+                        stream.Dispose();
+                }
+            }
+        }
+
         private static void HandleNewImage(BlogPostHtmlEditorControl currentEditor, Control owner, IHTMLElement imageElement, bool select)
         {
             // If the selection has changed since we first inserted the img tag, don't force a new selection.
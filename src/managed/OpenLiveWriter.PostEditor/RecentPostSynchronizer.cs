@@ -202,13 +202,40 @@ private static void SynchronizeLocalContentsWithEditingContext(string localConte
             }
             else
             {
-                Debug.WriteLine("RecentPostSynchronizer: Using remote contents");
-
                 // convert image references
                 ConvertImageReferencesToLocal(editingContext);
+
+                // servers often store a post formatted their own way, which changes its
+                // signature without changing the post
+                string remoteContents = editingContext.BlogPost.Contents;
+                if (localContents != null && remoteContents != null && IsOnlyFormattedDifferently(localContents, remoteContents))
+                {
+                    Debug.WriteLine("RecentPostSynchronizer: Remote contents are only formatted differently, using local contents");
+                    editingContext.BlogPost.Contents = localContents;
+                    return;
+                }
+
+                Debug.WriteLine("RecentPostSynchronizer: Using remote contents");
             }
         }
 
+        private static bool IsOnlyFormattedDifferently(string localContents, string remoteContents)
+        {
+            long localSignature;
+            long remoteSignature;
+            if (!HtmlDiff.TryGetSignature(localContents, true, out localSignature) ||
+                !HtmlDiff.TryGetSignature(remoteContents, true, out remoteSignature) ||
+                localSignature != remoteSignature)
+            {
+                return false;
+            }
+
+            // the signatures are hashes, so make sure there really is nothing to change
+            // before the server's copy is replaced
+            HtmlDiffHunk[] hunks;
+            return HtmlDiff.TryCompare(localContents, remoteContents, true, 0, out hunks) && hunks.Length == 0;
+        }
+
         private static BlogPost SafeGetPostFromServer(IWin32Window mainFrameWindow, string destinationBlogId, BlogPost blogPost)
         {
             try
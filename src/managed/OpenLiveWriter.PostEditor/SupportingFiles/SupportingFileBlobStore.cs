@@ -0,0 +1,309 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Globalization;
+using System.IO;
+using System.Security.Cryptography;
+using System.Text;
+
+namespace OpenLiveWriter.PostEditor.SupportingFiles
+{
+    /// <summary>
+    /// Content-addressed store for the images and attachments of locally saved posts.
+    /// Each distinct file is kept once, named after the SHA-256 of its contents, and post
+    /// files reference it by that hash instead of embedding their own copy.
+    ///
+    /// Blobs are written to a temporary file and moved into place, so a blob that exists
+    /// is always complete. References aren't tracked as they are added; instead the
+    /// reference counts are gathered from the post files and handed to CollectGarbage,
+    /// which removes blobs that have gone unreferenced for longer than a grace period.
+    /// The grace period also protects blobs written by saves that are still in flight.
+    /// </summary>
+    public class SupportingFileBlobStore
+    {
+        private const int BufferSize = 64 * 1024;
+        private const string TempExtension = ".tmp";
+
+        private readonly DirectoryInfo root;
+
+        public SupportingFileBlobStore(DirectoryInfo root)
+        {
+            this.root = root;
+        }
+
+        public DirectoryInfo Root
+        {
+            get { return root; }
+        }
+
+        /// <summary>
+        /// Adds a file to the store, unless identical contents are already stored, and
+        /// returns the hash that identifies it.
+        /// </summary>
+        public string Add(Stream contents)
+        {
+            // the common case is a file we already have (every save of a post stores all
+            // of its images again), so when we can, find that out without writing anything
+            if (contents.CanSeek)
+            {
+                long start = contents.Position;
+                string hash;
+                using (HashAlgorithm sha = SHA256.Create())
+                    hash = ToHex(sha.ComputeHash(contents));
+
+                string blobPath = GetBlobPath(hash);
+                if (File.Exists(blobPath))
+                {
+                    MarkReferenced(blobPath);
+                    return hash;
+                }
+                contents.Position = start;
+            }
+
+            return Store(contents);
+        }
+
+        /// <summary>
+        /// Adds a file on disk to the store. The hash of each file is remembered for as long
+        /// as its size and last write time stay the same, so saving a post again doesn't read
+        /// the images that haven't changed since the last save.
+        /// </summary>
+        public string AddFile(string path)
+        {
+            FileInfo file = new FileInfo(path);
+            long length = file.Length;
+            DateTime lastWriteTimeUtc = file.LastWriteTimeUtc;
+
+            CachedHash cached;
+            lock (hashCache)
+            {
+                if (!hashCache.TryGetValue(file.FullName, out cached) || cached.Length != length || cached.LastWriteTimeUtc != lastWriteTimeUtc)
+                    cached = null;
+            }
+            if (cached != null)
+            {
+                string blobPath = GetBlobPath(cached.Hash);
+                if (File.Exists(blobPath))
+                {
+                    MarkReferenced(blobPath);
+                    return cached.Hash;
+                }
+            }
+
+            string hash;
+            using (FileStream contents = new FileStream(file.FullName, FileMode.Open, FileAccess.Read, FileShare.Read, BufferSize))
+                hash = Add(contents);
+
+            // only remember the hash if the file didn't change while it was being read
+            file.Refresh();
+            if (file.Length == length && file.LastWriteTimeUtc == lastWriteTimeUtc)
+            {
+                lock (hashCache)
+                {
+                    if (hashCache.Count >= MaxCachedHashes)
+                        hashCache.Clear();
+                    hashCache[file.FullName] = new CachedHash(length, lastWriteTimeUtc, hash);
+                }
+            }
+            return hash;
+        }
+
+        private class CachedHash
+        {
+            public readonly long Length;
+            public readonly DateTime LastWriteTimeUtc;
+            public readonly string Hash;
+
+            public CachedHash(long length, DateTime lastWriteTimeUtc, string hash)
+            {
+                Length = length;
+                LastWriteTimeUtc = lastWriteTimeUtc;
+                Hash = hash;
+            }
+        }
+
+        // shared by every store, since a file's hash doesn't depend on where it is stored
+        private static readonly Dictionary<string, CachedHash> hashCache = new Dictionary<string, CachedHash>(StringComparer.OrdinalIgnoreCase);
+        private const int MaxCachedHashes = 4096;
+
+        private string Store(Stream contents)
+        {
+            if (!Directory.Exists(root.FullName))
+            {
+                root.Create();
+                root.Attributes |= FileAttributes.Hidden;
+            }
+
+            string tempPath = Path.Combine(root.FullName, Guid.NewGuid().ToString("N") + TempExtension);
+            try
+            {
+                string hash;
+                using (HashAlgorithm sha = SHA256.Create())
+                using (FileStream tempStream = new FileStream(tempPath, FileMode.CreateNew, FileAccess.Write, FileShare.None, BufferSize))
+                {
+                    byte[] buffer = new byte[BufferSize];
+                    int read;
+                    while ((read = contents.Read(buffer, 0, buffer.Length)) > 0)
+                    {
+                        sha.TransformBlock(buffer, 0, read, null, 0);
+                        tempStream.Write(buffer, 0, read);
+                    }
+                    sha.TransformFinalBlock(buffer, 0, 0);
+                    hash = ToHex(sha.Hash);
+                }
+
+                string blobPath = GetBlobPath(hash);
+                if (File.Exists(blobPath))
+                {
+                    MarkReferenced(blobPath);
+                    return hash;
+                }
+
+                Directory.CreateDirectory(Path.GetDirectoryName(blobPath));
+                try
+                {
+                    File.Move(tempPath, blobPath);
+                }
+                catch (IOException)
+                {
+                    // someone else stored the same contents first
+                    if (!File.Exists(blobPath))
+                        throw;
+                }
+                return hash;
+            }
+            finally
+            {
+                try
+                {
+                    if (File.Exists(tempPath))
+                        File.Delete(tempPath);
+                }
+                catch (IOException ex)
+                {
+                    Trace.WriteLine("Failed to delete temporary supporting file " + tempPath + ": " + ex.Message);
+                }
+            }
+        }
+
+        /// <summary>
+        /// Opens a stored file for reading.
+        /// </summary>
+        /// <exception cref="FileNotFoundException">No file with this hash is stored.</exception>
+        public Stream Open(string hash)
+        {
+            return new FileStream(GetBlobPath(hash), FileMode.Open, FileAccess.Read, FileShare.Read, BufferSize);
+        }
+
+        public bool Contains(string hash)
+        {
+            return IsValidHash(hash) && File.Exists(GetBlobPath(hash));
+        }
+
+        /// <summary>
+        /// Deletes every stored file that has no references in referenceCounts and hasn't been
+        /// added or referenced within the grace period, along with abandoned temporary files.
+        /// Returns the number of files deleted.
+        /// </summary>
+        public int CollectGarbage(IDictionary<string, int> referenceCounts, TimeSpan gracePeriod)
+        {
+            if (!Directory.Exists(root.FullName))
+                return 0;
+
+            DateTime cutoff = DateTime.UtcNow - gracePeriod;
+            DateTime refreshBefore = DateTime.UtcNow - TimeSpan.FromTicks(gracePeriod.Ticks / 2);
+            int deleted = 0;
+
+            foreach (FileInfo tempFile in root.GetFiles("*" + TempExtension))
+            {
+                if (tempFile.LastWriteTimeUtc < cutoff && TryDelete(tempFile))
+                    deleted++;
+            }
+
+            foreach (DirectoryInfo fanout in root.GetDirectories())
+            {
+                foreach (FileInfo blob in fanout.GetFiles())
+                {
+                    int references;
+                    if (referenceCounts.TryGetValue(blob.Name, out references) && references > 0)
+                    {
+                        // keeps a blob around for a while if its last post moves out of
+                        // sight, e.g. is copied somewhere else and then deleted
+                        if (blob.LastWriteTimeUtc < refreshBefore)
+                            MarkReferenced(blob.FullName);
+                    }
+                    else if (blob.LastWriteTimeUtc < cutoff && TryDelete(blob))
+                    {
+                        deleted++;
+                    }
+                }
+            }
+
+            return deleted;
+        }
+
+        public static bool IsValidHash(string hash)
+        {
+            if (hash == null || hash.Length != 64)
+                return false;
+            foreach (char c in hash)
+            {
+                if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f')))
+                    return false;
+            }
+            return true;
+        }
+
+        private string GetBlobPath(string hash)
+        {
+            if (!IsValidHash(hash))
+                throw new ArgumentException("Invalid supporting file hash: " + hash, "hash");
+            return Path.Combine(Path.Combine(root.FullName, hash.Substring(0, 2)), hash);
+        }
+
+        private static void MarkReferenced(string blobPath)
+        {
+            try
+            {
+                File.SetLastWriteTimeUtc(blobPath, DateTime.UtcNow);
+            }
+            catch (IOException ex)
+            {
+                Trace.WriteLine("Failed to update supporting file " + blobPath + ": " + ex.Message);
+            }
+            catch (UnauthorizedAccessException ex)
+            {
+                Trace.WriteLine("Failed to update supporting file " + blobPath + ": " + ex.Message);
+            }
+        }
+
+        private static bool TryDelete(FileInfo file)
+        {
+            try
+            {
+                file.Delete();
+                return true;
+            }
+            catch (IOException ex)
+            {
+                Trace.WriteLine("Failed to delete supporting file " + file.FullName + ": " + ex.Message);
+            }
+            catch (UnauthorizedAccessException ex)
+            {
+                Trace.WriteLine("Failed to delete supporting file " + file.FullName + ": " + ex.Message);
+            }
+            return false;
+        }
+
+        private static string ToHex(byte[] bytes)
+        {
+            StringBuilder hex = new StringBuilder(bytes.Length * 2);
+            foreach (byte b in bytes)
+                hex.Append(b.ToString("x2", CultureInfo.InvariantCulture));
+            return hex.ToString();
+        }
+    }
+}
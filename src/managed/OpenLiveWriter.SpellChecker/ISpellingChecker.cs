@@ -68,6 +68,28 @@ public interface ISpellingChecker : IDisposable
         void ReplaceAll( string word, string replaceWith ) ;
     }
 
+    /// <summary>
+    /// Implemented by spell checking engines that can check many words in one call
+    /// </summary>
+    public interface IBatchSpellingChecker
+    {
+        /// <summary>
+        /// Whether CheckWords currently checks the words in one call, rather than
+        /// a word at a time as CheckWord would
+        /// </summary>
+        bool CanCheckWords { get; }
+
+        /// <summary>
+        /// Check the spelling of the first count words, writing a result for each
+        /// </summary>
+        /// <param name="words">words to check</param>
+        /// <param name="count">number of words to check</param>
+        /// <param name="results">check-word result of each word</param>
+        /// <param name="offsets">where in each word the misspelled part starts, as CheckWord returns it</param>
+        /// <param name="lengths">how long the misspelled part of each word is</param>
+        void CheckWords( string[] words, int count, SpellCheckResult[] results, int[] offsets, int[] lengths ) ;
+    }
+
     /// <summary>
     /// Possible result codes from check-word call
     /// </summary>
@@ -106,7 +106,11 @@ public bool IsCurrentWordUrlPart()
 
         public bool FilterApplies()
         {
-            return filter != null && filter(currentWordRange);
+            return FilterApplies(currentWordRange);
+        }
+        public bool FilterApplies(MarkupRange wordRange)
+        {
+            return filter != null && filter(wordRange);
         }
         public bool FilterAppliesRanged(int offset, int length)
         {
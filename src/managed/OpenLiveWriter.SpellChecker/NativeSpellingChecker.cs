@@ -0,0 +1,386 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Globalization;
+using System.IO;
+using System.Runtime.InteropServices;
+using System.Text;
+using OpenLiveWriter.CoreServices;
+using OpenLiveWriter.Interop.Com;
+using OpenLiveWriter.Interop.Windows;
+
+namespace OpenLiveWriter.SpellChecker
+{
+    /// <summary>
+    /// Checks spelling against a compiled dictionary (the Dictionaries folder of the
+    /// installation has one per language, see utilities\SpellingDictionaryCompiler)
+    /// that OpenLiveWriter.Native.dll maps into memory, so that starting to check is
+    /// immediate and a whole batch of words is checked in one call. Languages without
+    /// a compiled dictionary, or machines without the native DLL, are checked by the
+    /// platform spell checker instead.
+    ///
+    /// Words added to the user dictionary are kept in UserDictionary.txt in the
+    /// application data folder; ignored and replaced words last for the session.
+    /// </summary>
+    public class NativeSpellingChecker : ISpellingChecker, IBatchSpellingChecker, IDisposable
+    {
+        private const string DICTIONARY_EXTENSION = ".dic";
+
+        private static bool _nativeUnavailable;
+
+        private readonly WinSpellingChecker _platformChecker;
+        private string _bcp47Code;
+        private IntPtr _dictionary = IntPtr.Zero;
+
+        private readonly HashSet<string> _userWords = new HashSet<string>(StringComparer.CurrentCultureIgnoreCase);
+        private readonly HashSet<string> _ignoredWords = new HashSet<string>(StringComparer.CurrentCultureIgnoreCase);
+        private readonly Dictionary<string, string> _replacements = new Dictionary<string, string>(StringComparer.CurrentCulture);
+
+        public NativeSpellingChecker(WinSpellingChecker platformChecker)
+        {
+            _platformChecker = platformChecker;
+        }
+
+        public event EventHandler WordAdded
+        {
+            add { _wordAdded += value; _platformChecker.WordAdded += value; }
+            remove { _wordAdded -= value; _platformChecker.WordAdded -= value; }
+        }
+        private EventHandler _wordAdded;
+
+        public event EventHandler WordIgnored
+        {
+            add { _wordIgnored += value; _platformChecker.WordIgnored += value; }
+            remove { _wordIgnored -= value; _platformChecker.WordIgnored -= value; }
+        }
+        private EventHandler _wordIgnored;
+
+        public bool IsInitialized
+        {
+            get
+            {
+                return UsingDictionary || _platformChecker.IsInitialized;
+            }
+        }
+
+        private bool UsingDictionary
+        {
+            get { return _dictionary != IntPtr.Zero; }
+        }
+
+        public void SetOptions(string bcp47Code)
+        {
+            _bcp47Code = bcp47Code;
+            _platformChecker.SetOptions(bcp47Code);
+        }
+
+        public void StartChecking()
+        {
+            StopChecking();
+            if (string.IsNullOrEmpty(_bcp47Code))
+                return;
+
+            if (OpenDictionary(_bcp47Code))
+                LoadUserWords();
+            else
+                _platformChecker.StartChecking();
+        }
+
+        public void StopChecking()
+        {
+            if (UsingDictionary)
+            {
+                OpenLiveWriterNative.CloseSpellingDictionary(_dictionary);
+                _dictionary = IntPtr.Zero;
+            }
+            _platformChecker.StopChecking();
+        }
+
+        public SpellCheckResult CheckWord(string word, out string otherWord, out int offset, out int length)
+        {
+            if (!UsingDictionary)
+                return _platformChecker.CheckWord(word, out otherWord, out offset, out length);
+
+            otherWord = null;
+            offset = 0;
+            length = word == null ? 0 : word.Length;
+
+            SpellCheckResult[] results = new SpellCheckResult[1];
+            CheckWords(new string[] { word }, 1, results, new int[1], new int[1]);
+            if (results[0] == SpellCheckResult.AutoReplace)
+                otherWord = _replacements[word];
+            return results[0];
+        }
+
+        public bool CanCheckWords
+        {
+            get { return UsingDictionary; }
+        }
+
+        public void CheckWords(string[] words, int count, SpellCheckResult[] results, int[] offsets, int[] lengths)
+        {
+            if (!UsingDictionary)
+            {
+                for (int i = 0; i < count; i++)
+                {
+                    string otherWord;
+                    results[i] = _platformChecker.CheckWord(words[i], out otherWord, out offsets[i], out lengths[i]);
+                }
+                return;
+            }
+
+            // the words that are up to the dictionary, one after the other
+            StringBuilder text = new StringBuilder();
+            int[] starts = new int[count];
+            int[] lengths = new int[count];
+            int[] indexes = new int[count];
+            int checkCount = 0;
+            for (int i = 0; i < count; i++)
+            {
+                string word = words[i];
+                results[i] = SpellCheckResult.Correct;
+                offsets[i] = 0;
+                lengths[i] = word == null ? 0 : word.Length;
+                if (string.IsNullOrEmpty(word) || ContainsDigit(word) || _userWords.Contains(word) || _ignoredWords.Contains(word))
+                    continue;
+                if (_replacements.ContainsKey(word))
+                {
+                    results[i] = SpellCheckResult.AutoReplace;
+                    continue;
+                }
+
+                starts[checkCount] = text.Length;
+                lengths[checkCount] = word.Length;
+                indexes[checkCount] = i;
+                checkCount++;
+                text.Append(word);
+            }
+            if (checkCount == 0)
+                return;
+
+            byte[] checks = new byte[checkCount];
+            int hr = OpenLiveWriterNative.CheckSpelling(_dictionary, text.ToString(), text.Length, starts, lengths, checkCount, checks);
+            if (hr != HRESULT.S_OK)
+                throw new SpellingCheckerException("CheckSpelling failed: 0x" + hr.ToString("X8", CultureInfo.InvariantCulture));
+
+            for (int i = 0; i < checkCount; i++)
+                results[indexes[i]] = (SpellCheckResult)checks[i];
+        }
+
+        public SpellingSuggestion[] Suggest(string word, short maxSuggestions, short depth)
+        {
+            if (!UsingDictionary)
+                return _platformChecker.Suggest(word, maxSuggestions, depth);
+
+            IntPtr result;
+            int resultLength;
+            int hr = OpenLiveWriterNative.SuggestSpelling(_dictionary, word, word.Length, maxSuggestions, out result, out resultLength);
+            if (hr == HRESULT.S_FALSE)
+                return new SpellingSuggestion[0];
+            if (hr != HRESULT.S_OK)
+                throw new SpellingCheckerException("SuggestSpelling failed: 0x" + hr.ToString("X8", CultureInfo.InvariantCulture));
+
+            string suggestions;
+            try
+            {
+                suggestions = Marshal.PtrToStringUni(result, resultLength);
+            }
+            finally
+            {
+                Marshal.FreeCoTaskMem(result);
+            }
+
+            // suggestions come closest first; score them in that order
+            List<SpellingSuggestion> list = new List<SpellingSuggestion>();
+            foreach (string suggestion in suggestions.Split('\0'))
+                list.Add(new SpellingSuggestion(MatchCase(word, suggestion), (short)(100 - list.Count)));
+            return list.ToArray();
+        }
+
+        public void AddToUserDictionary(string word)
+        {
+            if (!UsingDictionary)
+            {
+                _platformChecker.AddToUserDictionary(word);
+                return;
+            }
+
+            if (_userWords.Add(word))
+            {
+                try
+                {
+                    Directory.CreateDirectory(Path.GetDirectoryName(UserDictionaryPath));
+                    File.AppendAllText(UserDictionaryPath, word + Environment.NewLine, Encoding.UTF8);
+                }
+                catch (Exception ex)
+                {
+                    Trace.Fail("Failed to save " + UserDictionaryPath + ": " + ex);
+                }
+            }
+
+            if (_wordAdded != null)
+                _wordAdded(word, EventArgs.Empty);
+        }
+
+        public void IgnoreAll(string word)
+        {
+            if (!UsingDictionary)
+            {
+                _platformChecker.IgnoreAll(word);
+                return;
+            }
+
+            _ignoredWords.Add(word);
+
+            if (_wordIgnored != null)
+                _wordIgnored(word, EventArgs.Empty);
+        }
+
+        public void ReplaceAll(string word, string replaceWith)
+        {
+            if (!UsingDictionary)
+            {
+                _platformChecker.ReplaceAll(word, replaceWith);
+                return;
+            }
+
+            _replacements[word] = replaceWith;
+        }
+
+        public void Dispose()
+        {
+            StopChecking();
+            _platformChecker.Dispose();
+        }
+
+        /// <summary>
+        /// The languages there are compiled dictionaries or platform dictionaries for.
+        /// </summary>
+        public static string[] GetInstalledLanguages()
+        {
+            List<string> languages = new List<string>(WinSpellingChecker.GetInstalledLanguages());
+            try
+            {
+                if (Directory.Exists(DictionaryDirectory))
+                {
+                    foreach (string path in Directory.GetFiles(DictionaryDirectory, "*" + DICTIONARY_EXTENSION))
+                    {
+                        string bcp47Code = Path.GetFileNameWithoutExtension(path);
+                        if (!languages.Exists(language => string.Equals(language, bcp47Code, StringComparison.OrdinalIgnoreCase)))
+                            languages.Add(bcp47Code);
+                    }
+                }
+            }
+            catch (Exception ex)
+            {
+                Trace.WriteLine("Failed to list spelling dictionaries: " + ex);
+            }
+            return languages.ToArray();
+        }
+
+        public static bool IsLanguageSupported(string bcp47Code)
+        {
+            if (string.IsNullOrEmpty(bcp47Code))
+                return false;
+
+            return File.Exists(GetDictionaryPath(bcp47Code)) || WinSpellingChecker.IsLanguageSupported(bcp47Code);
+        }
+
+        private static string DictionaryDirectory
+        {
+            get { return Path.Combine(ApplicationEnvironment.InstallationDirectory, "Dictionaries"); }
+        }
+
+        private static string UserDictionaryPath
+        {
+            get { return Path.Combine(ApplicationEnvironment.ApplicationDataDirectory, "UserDictionary.txt"); }
+        }
+
+        private static string GetDictionaryPath(string bcp47Code)
+        {
+            return Path.Combine(DictionaryDirectory, bcp47Code + DICTIONARY_EXTENSION);
+        }
+
+        private bool OpenDictionary(string bcp47Code)
+        {
+            string path = GetDictionaryPath(bcp47Code);
+            if (_nativeUnavailable || !File.Exists(path))
+                return false;
+
+            try
+            {
+                int hr = OpenLiveWriterNative.OpenSpellingDictionary(path, out _dictionary);
+                if (hr == HRESULT.S_OK)
+                    return true;
+
+                Trace.Fail("Failed to open " + path + ": 0x" + hr.ToString("X8", CultureInfo.InvariantCulture));
+                _dictionary = IntPtr.Zero;
+                return false;
+            }
+            catch (DllNotFoundException)
+            {
+                _nativeUnavailable = true;
+            }
+            catch (EntryPointNotFoundException)
+            {
+                _nativeUnavailable = true;
+            }
+            Trace.WriteLine(OpenLiveWriterNative.DLL_NAME + " is not available, falling back to the platform spell checker");
+            return false;
+        }
+
+        private void LoadUserWords()
+        {
+            _userWords.Clear();
+            try
+            {
+                if (File.Exists(UserDictionaryPath))
+                {
+                    foreach (string line in File.ReadAllLines(UserDictionaryPath, Encoding.UTF8))
+                    {
+                        if (line.Trim().Length > 0)
+                            _userWords.Add(line.Trim());
+                    }
+                }
+            }
+            catch (Exception ex)
+            {
+                Trace.Fail("Failed to load " + UserDictionaryPath + ": " + ex);
+            }
+        }
+
+        private static bool ContainsDigit(string word)
+        {
+            foreach (char c in word)
+            {
+                if (char.IsDigit(c))
+                    return true;
+            }
+            return false;
+        }
+
+        /// <summary>
+        /// Capitalizes a suggestion the way the misspelling was, so that Teh suggests The
+        /// and TEH suggests THE.
+        /// </summary>
+        private static string MatchCase(string word, string suggestion)
+        {
+            if (word.Length == 0 || suggestion.Length == 0 || !char.IsUpper(word[0]))
+                return suggestion;
+
+            bool capitals = word.Length > 1;
+            foreach (char c in word)
+            {
+                if (char.IsLower(c))
+                    capitals = false;
+            }
+
+            if (capitals)
+                return suggestion.ToUpper(CultureInfo.CurrentCulture);
+            return char.ToUpper(suggestion[0], CultureInfo.CurrentCulture) + suggestion.Substring(1);
+        }
+    }
+}
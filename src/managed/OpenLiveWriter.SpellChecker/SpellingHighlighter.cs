@@ -123,6 +123,10 @@ private void DoWork()
         //return: whether the word range is finished (true) or not
         private bool ProcessWordRange(MshtmlWordRange wordRange)
         {
+            IBatchSpellingChecker batchChecker = _spellingChecker as IBatchSpellingChecker;
+            if (batchChecker != null && batchChecker.CanCheckWords)
+                return ProcessWordRange(wordRange, batchChecker);
+
             if (wordRange.CurrentWordRange.Positioned)
             {
                 //track where we will need to clear;
@@ -163,6 +167,53 @@ private bool ProcessWordRange(MshtmlWordRange wordRange)
                 return true;
         }
 
+        //like ProcessWordRange, but collects the words first and checks them in one call
+        private bool ProcessWordRange(MshtmlWordRange wordRange, IBatchSpellingChecker batchChecker)
+        {
+            if (!wordRange.CurrentWordRange.Positioned)
+                return true;
+
+            MarkupPointer start = _markupServices.CreateMarkupPointer();
+            start.MoveToPointer(wordRange.CurrentWordRange.End);
+
+            string[] words = new string[NUMBER_OF_WORDS_TO_CHECK];
+            MarkupRange[] wordRanges = new MarkupRange[NUMBER_OF_WORDS_TO_CHECK];
+            int count = 0;
+            int i = 0;
+            while (wordRange.HasNext() && i < NUMBER_OF_WORDS_TO_CHECK)
+            {
+                wordRange.Next();
+                string currentWord = wordRange.CurrentWord;
+                if (!wordRange.IsCurrentWordUrlPart() && !WordRangeHelper.ContainsOnlySymbols(currentWord))
+                {
+                    //note: cannot just keep the current word range, as it moves on to the next word
+                    words[count] = currentWord;
+                    wordRanges[count] = wordRange.CurrentWordRange.Clone();
+                    count++;
+                }
+                i++;
+            }
+            MarkupPointer end = wordRange.CurrentWordRange.End;
+
+            SpellCheckResult[] results = new SpellCheckResult[count];
+            int[] offsets = new int[count];
+            int[] lengths = new int[count];
+            batchChecker.CheckWords(words, count, results, offsets, lengths);
+
+            //got our words, clear the checked range and then add the misspellings
+            ClearRange(start, end);
+            for (int word = 0; word < count; word++)
+            {
+                if (results[word] != SpellCheckResult.Correct && !wordRange.FilterApplies(wordRanges[word]))
+                {
+                    MarkupHelpers.AdjustMarkupRange(ref stagingTextRange, wordRanges[word], offsets[word], lengths[word]);
+                    HighlightWordRange(wordRanges[word]);
+                }
+            }
+
+            return !wordRange.HasNext();
+        }
+
         //takes one the first word on the range, and checks it for spelling errors
         //***returns true if word is misspelled***
         private bool ProcessWord(MshtmlWordRange word, out int offset, out int length)
@@ -61,7 +61,7 @@ public static SpellingLanguageEntry[] GetInstalledLanguages()
         {
             List<SpellingLanguageEntry> list = new List<SpellingLanguageEntry>();
 
-            foreach (string entry in WinSpellingChecker.GetInstalledLanguages())
+            foreach (string entry in NativeSpellingChecker.GetInstalledLanguages())
             {
                 try
                 {
@@ -150,7 +150,7 @@ public static string Language
                 if (string.IsNullOrEmpty(preferredLanguage))
                     return string.Empty;
 
-                if (WinSpellingChecker.IsLanguageSupported(preferredLanguage))
+                if (NativeSpellingChecker.IsLanguageSupported(preferredLanguage))
                 {
                     return preferredLanguage;
                 }
@@ -158,13 +158,13 @@ public static string Language
                 // Language in registry is not installed!
                 Trace.WriteLine("Dictionary language specified in registry is not installed. Using fallback");
 
-                if (WinSpellingChecker.IsLanguageSupported(defaultLanguage))
+                if (NativeSpellingChecker.IsLanguageSupported(defaultLanguage))
                 { 
                     Language = defaultLanguage;
                     return defaultLanguage;
                 }
 
-                if (WinSpellingChecker.IsLanguageSupported("en-US"))
+                if (NativeSpellingChecker.IsLanguageSupported("en-US"))
                 {
                     Language = "en-US";
                     return "en-US";
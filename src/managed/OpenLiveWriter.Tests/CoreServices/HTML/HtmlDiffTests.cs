@@ -0,0 +1,136 @@
+﻿using System.Text;
+
+using NUnit.Framework;
+
+using OpenLiveWriter.CoreServices.HTML;
+
+namespace OpenLiveWriter.Tests.CoreServices.HTML
+{
+    /// <summary>
+    /// Compares versions of a post, as the recent post synchronizer does, and
+    /// applies the changes found to the old version to check they give the new.
+    /// </summary>
+    [TestFixture]
+    public class HtmlDiffTests
+    {
+        private const string Post = "<p>The <b>quick</b> brown fox</p>\r\n<p><img src=\"http://example.com/fox.jpg\" alt=\"fox\"></p>";
+
+        private static void IgnoreIfUnavailable()
+        {
+            long signature;
+            if (!HtmlDiff.TryGetSignature("", false, out signature))
+                Assert.Ignore("OpenLiveWriter.Native.dll isn't available");
+        }
+
+        private static HtmlDiffHunk[] Compare(string oldHtml, string newHtml, bool ignoreFormatting)
+        {
+            HtmlDiffHunk[] hunks;
+            IgnoreIfUnavailable();
+            Assert.IsTrue(HtmlDiff.TryCompare(oldHtml, newHtml, ignoreFormatting, 1000, out hunks));
+            return hunks;
+        }
+
+        private static string Apply(string oldHtml, HtmlDiffHunk[] hunks)
+        {
+            StringBuilder html = new StringBuilder(oldHtml.Length);
+            int position = 0;
+            foreach (HtmlDiffHunk hunk in hunks)
+            {
+                html.Append(oldHtml, position, hunk.OldStart - position);
+                html.Append(hunk.NewText);
+                position = hunk.OldStart + hunk.OldLength;
+            }
+            html.Append(oldHtml, position, oldHtml.Length - position);
+            return html.ToString();
+        }
+
+        private static long Signature(string html)
+        {
+            long signature;
+            if (!HtmlDiff.TryGetSignature(html, true, out signature))
+                Assert.Ignore("OpenLiveWriter.Native.dll isn't available");
+            return signature;
+        }
+
+        [TestCase("<p>The <b>quick</b> red fox</p>\r\n<p><img src=\"http://example.com/fox.jpg\" alt=\"fox\"></p>")]
+        [TestCase("<p>A <b>quick</b> brown fox</p>\r\n<p><img src=\"http://example.com/fox.jpg\" alt=\"a fox\"></p>")]
+        [TestCase("<h1>Foxes</h1><p>The <b>quick</b> brown fox</p>\r\n<p><img src=\"http://example.com/fox.jpg\" alt=\"fox\"></p><p>jumps.</p>")]
+        [TestCase("")]
+        public void Applied_Changes_Give_New_Version(string newHtml)
+        {
+            // Act
+            HtmlDiffHunk[] hunks = Compare(Post, newHtml, false);
+
+            // Assert
+            Assert.AreEqual(newHtml, Apply(Post, hunks));
+        }
+
+        [Test]
+        public void Changes_Are_Minimal()
+        {
+            // Act
+            HtmlDiffHunk[] hunks = Compare(Post, Post.Replace("brown", "red"), false);
+
+            // Assert
+            Assert.AreEqual(1, hunks.Length);
+            Assert.AreEqual(Post.IndexOf("brown"), hunks[0].OldStart);
+            Assert.AreEqual("brown".Length, hunks[0].OldLength);
+            Assert.AreEqual("red", hunks[0].NewText);
+        }
+
+        [Test]
+        public void Same_Version_Has_No_Changes()
+        {
+            Assert.AreEqual(0, Compare(Post, Post, false).Length);
+        }
+
+        [Test]
+        public void Formatting_Is_Ignored()
+        {
+            // Arrange
+            string formatted = "<P>The <B>quick</B>   brown fox</P>\n<P><IMG SRC=http://example.com/fox.jpg ALT='fox' /></P>\n";
+
+            // Assert
+            Assert.AreEqual(Signature(Post), Signature(formatted));
+            Assert.AreEqual(0, Compare(Post, formatted, true).Length);
+            Assert.AreNotEqual(Signature(Post), Signature(Post.Replace("quick", "Quick")));
+            Assert.AreNotEqual(Signature(Post), Signature(Post.Replace("fox.jpg", "FOX.jpg")));
+        }
+
+        [Test]
+        public void Space_Next_To_Markup_Is_Not_Ignored()
+        {
+            // Assert: "The<b>quick</b>" reads differently from "The <b>quick</b>"
+            Assert.AreNotEqual(Signature(Post), Signature(Post.Replace("The <b>", "The<b>")));
+            Assert.AreNotEqual(Signature(Post), Signature(Post.Replace("</p>\r\n<p>", "</p><p>")));
+            Assert.AreNotEqual(0, Compare(Post, Post.Replace("The <b>", "The<b>"), true).Length);
+        }
+
+        [TestCase("<pre>a  b</pre>", "<pre>a b</pre>")]
+        [TestCase("<textarea>a\r\nb</textarea>", "<textarea>a\nb</textarea>")]
+        [TestCase("<div style=\"white-space: pre\">a  b</div>", "<div style=\"white-space: pre\">a b</div>")]
+        public void Preformatted_Space_Is_Not_Ignored(string html, string formatted)
+        {
+            // Assert
+            Assert.AreNotEqual(Signature(html), Signature(formatted));
+            Assert.AreNotEqual(0, Compare(html, formatted, true).Length);
+            Assert.AreEqual(Signature("<p>a  b</p>" + html), Signature("<p>a b</p>" + html));
+        }
+
+        [Test]
+        public void Too_Different_Is_Not_Compared()
+        {
+            // Arrange
+            string other = "<div>" + new string('x', 10) + " y z w v</div>";
+            IgnoreIfUnavailable();
+
+            // Act
+            HtmlDiffHunk[] hunks;
+            bool compared = HtmlDiff.TryCompare(Post, other, false, 3, out hunks);
+
+            // Assert
+            Assert.IsFalse(compared);
+            Assert.IsNull(hunks);
+        }
+    }
+}
@@ -0,0 +1,116 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Text;
+
+using NUnit.Framework;
+
+using OpenLiveWriter.CoreServices.HTML;
+using OpenLiveWriter.HtmlParser.Parser;
+
+namespace OpenLiveWriter.Tests.CoreServices.HTML
+{
+    /// <summary>
+    /// Compares the native rewriter with HtmlReferenceFixer. The rewriter leaves the
+    /// formatting of tags alone where HtmlReferenceFixer normalizes it, so both outputs
+    /// are put through HtmlReferenceFixer once more, without changing any reference,
+    /// before they are compared.
+    /// </summary>
+    [TestFixture]
+    public class HtmlReferenceRewriterTests
+    {
+        private static readonly Dictionary<string, string> References = new Dictionary<string, string>(StringComparer.OrdinalIgnoreCase)
+        {
+            { "file:///C:/Users/writer/Pictures/beach.jpg", "SupportingFileReference://3EF3AA3F-5560-4750-9C97-171B37D7F45A" },
+            { "SupportingFileReference://0D3B4C15-26A1-4F6C-9B1E-55F4C1E2B7A0", "file:///C:/Temp/Writer/image%20one.png" },
+            { "http://example.com/photo?w=100&h=50", "file:///C:/Temp/Writer/a&b \"quoted\".png" },
+        };
+
+        private static string Managed(string html)
+        {
+            return HtmlReferenceFixer.FixReferences(html, delegate (BeginTag tag, string reference)
+            {
+                string fixedReference;
+                return References.TryGetValue(reference, out fixedReference) ? fixedReference : reference;
+            });
+        }
+
+        private static string Native(string html)
+        {
+            string rewritten;
+            if (!HtmlReferenceRewriter.TryRewrite(html, References, out rewritten))
+                Assert.Ignore("OpenLiveWriter.Native.dll isn't available");
+            return rewritten;
+        }
+
+        private static string Normalize(string html)
+        {
+            return HtmlReferenceFixer.FixReferences(html, delegate (BeginTag tag, string reference) { return reference; });
+        }
+
+        private static void AssertSameAsManaged(string html)
+        {
+            Assert.AreEqual(Normalize(Managed(html)), Normalize(Native(html)));
+        }
+
+        [TestCase("<p>No references here.</p>")]
+        [TestCase("<img src=\"file:///C:/Users/writer/Pictures/beach.jpg\" alt=\"beach\">")]
+        [TestCase("<IMG ALT='x' SRC = 'FILE:///c:/users/writer/pictures/beach.jpg' />")]
+        [TestCase("<img src=file:///C:/Users/writer/Pictures/beach.jpg width=100>")]
+        [TestCase("<a href=\"SupportingFileReference://0D3B4C15-26A1-4F6C-9B1E-55F4C1E2B7A0\"><img src=\"SupportingFileReference://0D3B4C15-26A1-4F6C-9B1E-55F4C1E2B7A0\"></a>")]
+        [TestCase("<a href=\"http://example.com/photo?w=100&amp;h=50\">photo</a>")]
+        [TestCase("<div src=\"file:///C:/Users/writer/Pictures/beach.jpg\"></div>")]
+        [TestCase("<img data-src=\"file:///C:/Users/writer/Pictures/beach.jpg\" src=\"other.jpg\" src=\"file:///C:/Users/writer/Pictures/beach.jpg\">")]
+        [TestCase("<!-- <img src=\"file:///C:/Users/writer/Pictures/beach.jpg\"> --><img src=\"file:///C:/Users/writer/Pictures/beach.jpg\">")]
+        [TestCase("<script>document.write('<img src=\"file:///C:/Users/writer/Pictures/beach.jpg\">');</script ><img src=\"file:///C:/Users/writer/Pictures/beach.jpg\">")]
+        [TestCase("<style>td { background: url(file:///C:/Users/writer/Pictures/beach.jpg) }</style><td background=\"file:///C:/Users/writer/Pictures/beach.jpg\">")]
+        [TestCase("<param name=\"movie\" value=\"file:///C:/Users/writer/Pictures/beach.jpg\"><embed src=\"file:///C:/Users/writer/Pictures/beach.jpg\">")]
+        [TestCase("<img src=\"file:///C:/Users/writer/Pictures/beach.jpg")]
+        [TestCase("< img src=\"file:///C:/Users/writer/Pictures/beach.jpg\"> 1 < 2 <!doctype html>")]
+        public void Rewrite_Matches_HtmlReferenceFixer(string html)
+        {
+            AssertSameAsManaged(html);
+        }
+
+        [Test]
+        public void Rewrite_Matches_HtmlReferenceFixer_On_Large_Post()
+        {
+            // Arrange
+            StringBuilder html = new StringBuilder();
+            for (int i = 0; i < 2000; i++)
+            {
+                html.Append("<p>Paragraph ").Append(i).Append(" with <b>some</b> text.</p>");
+                if (i % 10 == 0)
+                    html.Append("<a href=\"http://example.com/").Append(i).Append("\"><img src=\"file:///C:/Users/writer/Pictures/beach.jpg\" width=\"640\"></a>");
+            }
+
+            // Act and Assert
+            AssertSameAsManaged(html.ToString());
+        }
+
+        [Test]
+        public void Rewrite_Leaves_Everything_But_References_Alone()
+        {
+            // Arrange
+            string html = "<IMG  class=photo SRC='file:///C:/Users/writer/Pictures/beach.jpg'   alt=beach><a href=other.html >x</a>";
+
+            // Act
+            string rewritten = Native(html);
+
+            // Assert
+            Assert.AreEqual("<IMG  class=photo SRC=\"SupportingFileReference://3EF3AA3F-5560-4750-9C97-171B37D7F45A\"   alt=beach><a href=other.html >x</a>", rewritten);
+        }
+
+        [Test]
+        public void Rewrite_Returns_Same_Instance_When_Nothing_Matches()
+        {
+            // Arrange
+            string html = "<img src=\"other.jpg\">";
+
+            // Act
+            string rewritten = Native(html);
+
+            // Assert
+            Assert.AreSame(html, rewritten);
+        }
+    }
+}
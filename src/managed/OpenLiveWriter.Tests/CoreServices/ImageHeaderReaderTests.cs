@@ -0,0 +1,227 @@
+﻿using System;
+using System.Drawing;
+using System.Drawing.Imaging;
+using System.IO;
+using System.Text;
+
+using NUnit.Framework;
+
+using OpenLiveWriter.CoreServices;
+
+namespace OpenLiveWriter.Tests.CoreServices
+{
+    /// <summary>
+    /// Reads the headers of images put together a field at a time here, and of
+    /// images GDI+ saves, whose sizes are compared with the ones GDI+ decodes.
+    /// </summary>
+    [TestFixture]
+    public class ImageHeaderReaderTests
+    {
+        private static readonly byte[] Thumbnail = MakeThumbnail();
+
+        private static byte[] MakeThumbnail()
+        {
+            byte[] thumbnail = new byte[1000];
+            for (int i = 0; i < thumbnail.Length; i++)
+                thumbnail[i] = (byte)i;
+            thumbnail[0] = 0xFF;
+            thumbnail[1] = 0xD8;
+            return thumbnail;
+        }
+
+        /// <summary>
+        /// Writes the fields of an image in either byte order.
+        /// </summary>
+        private class ImageWriter
+        {
+            public readonly MemoryStream Stream = new MemoryStream();
+            public bool BigEndian = true;
+
+            public ImageWriter Bytes(params byte[] bytes)
+            {
+                Stream.Write(bytes, 0, bytes.Length);
+                return this;
+            }
+
+            public ImageWriter Text(string text)
+            {
+                return Bytes(Encoding.ASCII.GetBytes(text));
+            }
+
+            public ImageWriter U16(int value)
+            {
+                return BigEndian ? Bytes((byte)(value >> 8), (byte)value) : Bytes((byte)value, (byte)(value >> 8));
+            }
+
+            public ImageWriter U32(int value)
+            {
+                return BigEndian ? U16(value >> 16).U16(value) : U16(value).U16(value >> 16);
+            }
+
+            public ImageWriter Segment(byte marker, byte[] contents)
+            {
+                return Bytes(0xFF, marker, (byte)((contents.Length + 2) >> 8), (byte)(contents.Length + 2)).Bytes(contents);
+            }
+
+            public byte[] ToArray()
+            {
+                return Stream.ToArray();
+            }
+        }
+
+        private static byte[] Exif(bool bigEndian, int orientation)
+        {
+            const int IFD1 = 8 + 2 + 12 + 4;
+            const int THUMBNAIL = IFD1 + 2 + 2 * 12 + 4;
+
+            ImageWriter exif = new ImageWriter();
+            exif.Text("Exif\0\0");
+            exif.BigEndian = bigEndian;
+            exif.Text(bigEndian ? "MM" : "II").U16(42).U32(8);
+            exif.U16(1).U16(0x0112).U16(3).U32(1).U16(orientation).U16(0).U32(IFD1);
+            exif.U16(2).U16(0x0201).U16(4).U32(1).U32(THUMBNAIL).U16(0x0202).U16(4).U32(1).U32(Thumbnail.Length).U32(0);
+            exif.Bytes(Thumbnail);
+            return exif.ToArray();
+        }
+
+        private static byte[] Jpeg(int width, int height, byte[] exif)
+        {
+            ImageWriter jpeg = new ImageWriter();
+            jpeg.Bytes(0xFF, 0xD8);
+            if (exif != null)
+                jpeg.Segment(0xE1, exif);
+            jpeg.Segment(0xDB, new byte[65]);
+            jpeg.Segment(0xC2, new ImageWriter().Bytes(8).U16(height).U16(width).Bytes(1, 1, 0x11, 0).ToArray());
+            jpeg.Segment(0xDA, new byte[8]);
+            jpeg.Bytes(new byte[20000]).Bytes(0xFF, 0xD9);
+            return jpeg.ToArray();
+        }
+
+        private static ImageHeader Read(byte[] image)
+        {
+            ImageHeader header;
+            ImageHeader[] headers;
+            if (!ImageHeaderReader.TryRead(new Stream[0], out headers))
+                Assert.Ignore("OpenLiveWriter.Native.dll isn't available");
+            Assert.IsTrue(ImageHeaderReader.TryRead(new MemoryStream(image), out header));
+            return header;
+        }
+
+        [TestCase(true)]
+        [TestCase(false)]
+        public void Jpeg_With_Exif(bool bigEndian)
+        {
+            // Arrange
+            byte[] jpeg = Jpeg(4000, 3000, Exif(bigEndian, 6));
+
+            // Act
+            ImageHeader header = Read(jpeg);
+
+            // Assert
+            Assert.AreEqual(ImageHeaderFormat.Jpeg, header.Format);
+            Assert.AreEqual(new Size(4000, 3000), header.Size);
+            Assert.AreEqual(ExifOrientation.Rotate90CW, header.Orientation);
+            Assert.IsTrue(header.HasThumbnail);
+            Assert.AreEqual(Thumbnail, ImageHeaderReader.ReadThumbnail(new MemoryStream(jpeg), header));
+            Assert.Less(header.BytesRead, 3 * 4096);
+        }
+
+        [Test]
+        public void Jpeg_Without_Exif()
+        {
+            // Act
+            ImageHeader header = Read(Jpeg(640, 480, null));
+
+            // Assert
+            Assert.AreEqual(new Size(640, 480), header.Size);
+            Assert.AreEqual(ExifOrientation.Unknown, header.Orientation);
+            Assert.IsFalse(header.HasThumbnail);
+            Assert.IsNull(ImageHeaderReader.ReadThumbnail(new MemoryStream(), header));
+        }
+
+        [Test]
+        public void Other_Formats()
+        {
+            ImageWriter png = new ImageWriter();
+            png.Bytes(0x89).Text("PNG\r\n\x1A\n").U32(13).Text("IHDR").U32(1200).U32(900).Bytes(8, 6, 0, 0, 0).U32(0);
+            ImageWriter gif = new ImageWriter { BigEndian = false };
+            gif.Text("GIF89a").U16(320).U16(200).Bytes(0, 0, 0, 0x3B);
+            ImageWriter bmp = new ImageWriter { BigEndian = false };
+            bmp.Text("BM").U32(0).U32(0).U32(54).U32(40).U32(800).U32(-600).U16(1).U16(24).Bytes(new byte[24]);
+            ImageWriter webp = new ImageWriter { BigEndian = false };
+            webp.Text("RIFF").U32(22).Text("WEBPVP8L").U32(10).Bytes(0x2F).U32((1919) | (1079 << 14)).Bytes(0, 0, 0, 0, 0);
+
+            Assert.AreEqual(ImageHeaderFormat.Png, Read(png.ToArray()).Format);
+            Assert.AreEqual(new Size(1200, 900), Read(png.ToArray()).Size);
+            Assert.AreEqual(new Size(320, 200), Read(gif.ToArray()).Size);
+            Assert.AreEqual(new Size(800, 600), Read(bmp.ToArray()).Size);
+            Assert.AreEqual(ImageHeaderFormat.WebP, Read(webp.ToArray()).Format);
+            Assert.AreEqual(new Size(1920, 1080), Read(webp.ToArray()).Size);
+        }
+
+        [Test]
+        public void Batch_Leaves_Unreadable_Images_Null()
+        {
+            // Arrange
+            Stream[] streams =
+            {
+                new MemoryStream(Jpeg(100, 200, Exif(false, 8))),
+                new MemoryStream(Encoding.ASCII.GetBytes("<html>not an image</html>")),
+                null,
+                new MemoryStream(Jpeg(100, 200, null), 0, 50),
+                new NonSeekableStream(Jpeg(300, 400, Exif(true, 1))),
+            };
+
+            // Act
+            ImageHeader[] headers;
+            if (!ImageHeaderReader.TryRead(streams, out headers))
+                Assert.Ignore("OpenLiveWriter.Native.dll isn't available");
+
+            // Assert
+            Assert.AreEqual(new Size(100, 200), headers[0].Size);
+            Assert.AreEqual(ExifOrientation.Rotate270CW, headers[0].Orientation);
+            Assert.IsNull(headers[1]);
+            Assert.IsNull(headers[2]);
+            Assert.IsNull(headers[3]);
+            Assert.AreEqual(new Size(300, 400), headers[4].Size);
+            Assert.AreEqual(ExifOrientation.Normal, headers[4].Orientation);
+        }
+
+        private class NonSeekableStream : MemoryStream
+        {
+            public NonSeekableStream(byte[] bytes) : base(bytes)
+            {
+            }
+
+            public override bool CanSeek
+            {
+                get { return false; }
+            }
+
+            public override long Seek(long offset, SeekOrigin loc)
+            {
+                throw new NotSupportedException();
+            }
+        }
+
+        [TestCase("Jpeg")]
+        [TestCase("Png")]
+        [TestCase("Gif")]
+        [TestCase("Bmp")]
+        public void Size_Matches_GdiPlus(string format)
+        {
+            // Arrange
+            ImageFormat imageFormat = (ImageFormat)typeof(ImageFormat).GetProperty(format).GetValue(null, null);
+            MemoryStream saved = new MemoryStream();
+            using (Bitmap bitmap = new Bitmap(123, 45))
+                bitmap.Save(saved, imageFormat);
+
+            // Act
+            ImageHeader header = Read(saved.ToArray());
+
+            // Assert
+            using (Image image = Image.FromStream(new MemoryStream(saved.ToArray()), false, false))
+                Assert.AreEqual(image.Size, header.Size);
+        }
+    }
+}
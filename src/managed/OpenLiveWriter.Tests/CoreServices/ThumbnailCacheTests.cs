@@ -0,0 +1,118 @@
+﻿using System.Drawing;
+using System.Drawing.Imaging;
+using System.IO;
+
+using NUnit.Framework;
+
+using OpenLiveWriter.CoreServices;
+
+namespace OpenLiveWriter.Tests.CoreServices
+{
+    /// <summary>
+    /// Stores thumbnails in a cache file in the temp directory and finds them,
+    /// there and after the cache is opened again.
+    /// </summary>
+    [TestFixture]
+    public class ThumbnailCacheTests
+    {
+        private const long SIZE = 1024 * 1024;
+
+        private string _path;
+
+        [SetUp]
+        public void SetUp()
+        {
+            _path = Path.GetTempFileName();
+            File.Delete(_path);
+        }
+
+        [TearDown]
+        public void TearDown()
+        {
+            File.Delete(_path);
+        }
+
+        private ThumbnailCache Open()
+        {
+            ThumbnailCache cache = ThumbnailCache.Open(_path, SIZE);
+            if (cache == null)
+                Assert.Ignore("OpenLiveWriter.Native.dll isn't available");
+            return cache;
+        }
+
+        private static byte[] Hash(byte seed)
+        {
+            byte[] hash = new byte[32];
+            for (int i = 0; i < hash.Length; i++)
+                hash[i] = (byte)(seed + i);
+            return hash;
+        }
+
+        private static Bitmap MakeThumbnail(int width, int height)
+        {
+            Bitmap thumbnail = new Bitmap(width, height, PixelFormat.Format32bppArgb);
+            for (int y = 0; y < height; y++)
+                for (int x = 0; x < width; x++)
+                    thumbnail.SetPixel(x, y, Color.FromArgb(255 - x, x, y, x ^ y));
+            return thumbnail;
+        }
+
+        private static void AssertSame(Bitmap expected, Bitmap actual)
+        {
+            Assert.IsNotNull(actual);
+            Assert.AreEqual(expected.Size, actual.Size);
+            for (int y = 0; y < expected.Height; y++)
+                for (int x = 0; x < expected.Width; x++)
+                    Assert.AreEqual(expected.GetPixel(x, y), actual.GetPixel(x, y));
+        }
+
+        [Test]
+        public void Finds_What_Was_Stored()
+        {
+            // Arrange
+            using (ThumbnailCache cache = Open())
+            using (Bitmap thumbnail = MakeThumbnail(64, 48))
+            {
+                // Act
+                bool stored = cache.Store(Hash(1), new Size(64, 64), thumbnail);
+
+                // Assert
+                Assert.IsTrue(stored);
+                using (Bitmap found = cache.Find(Hash(1), new Size(64, 64)))
+                    AssertSame(thumbnail, found);
+                Assert.IsNull(cache.Find(Hash(1), new Size(96, 96)));
+                Assert.IsNull(cache.Find(Hash(2), new Size(64, 64)));
+            }
+        }
+
+        [Test]
+        public void Kept_When_Opened_Again()
+        {
+            // Arrange
+            using (Bitmap thumbnail = MakeThumbnail(40, 60))
+            {
+                using (ThumbnailCache cache = Open())
+                    cache.Store(Hash(3), new Size(60, 60), thumbnail);
+
+                // Act
+                using (ThumbnailCache cache = Open())
+                using (Bitmap found = cache.Find(Hash(3), new Size(60, 60)))
+                {
+                    // Assert
+                    AssertSame(thumbnail, found);
+                }
+            }
+        }
+
+        [Test]
+        public void Larger_Than_Requested_Not_Stored()
+        {
+            using (ThumbnailCache cache = Open())
+            using (Bitmap thumbnail = MakeThumbnail(65, 64))
+            {
+                Assert.IsFalse(cache.Store(Hash(4), new Size(64, 64), thumbnail));
+                Assert.IsNull(cache.Find(Hash(4), new Size(64, 64)));
+            }
+        }
+    }
+}
@@ -0,0 +1,347 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Globalization;
+using System.IO;
+using System.Net;
+using System.Net.Sockets;
+using System.Text;
+using System.Threading;
+using System.Xml;
+
+using NUnit.Framework;
+
+using OpenLiveWriter.CoreServices;
+
+namespace OpenLiveWriter.Tests.CoreServices
+{
+    /// <summary>
+    /// Sends metaWeblog.newMediaObject requests to a stand-in XML-RPC server on the
+    /// loopback interface and checks that one streaming its file from disk arrives
+    /// byte for byte the same as one with the file in memory, with a Content-Length
+    /// rather than chunked, and that the file decodes back out of it. Uploads challenged
+for credentials, large unbuffered ones included, have to be sent again with them.
+    /// </summary>
+    [TestFixture]
+    public class XmlRpcClientTests
+    {
+        private const string MEDIA_OBJECT_RESPONSE =
+            "<?xml version=\"1.0\"?><methodResponse><params><param><value><struct>"
+            + "<member><name>url</name><value><string>http://example.com/uploads/beach.jpg</string></value></member>"
+            + "</struct></value></param></params></methodResponse>";
+
+        private string tempFile;
+
+        [SetUp]
+        public void SetUp()
+        {
+            tempFile = Path.GetTempFileName();
+        }
+
+        [TearDown]
+        public void TearDown()
+        {
+            File.Delete(tempFile);
+        }
+
+        /// <summary>
+        /// What the stand-in server received.
+        /// </summary>
+        private class ReceivedRequest
+        {
+            public Dictionary<string, string> Headers = new Dictionary<string, string>(StringComparer.OrdinalIgnoreCase);
+            public byte[] Body;
+        }
+
+        /// <summary>
+        /// Accepts requests on the loopback interface and answers the first one with
+        /// response. Given credentials, it answers requests without them with a Basic
+        /// authentication challenge instead, until one has them.
+        /// </summary>
+        private class StandInServer : IDisposable
+        {
+            private readonly TcpListener listener = new TcpListener(IPAddress.Loopback, 0);
+            private readonly Thread thread;
+            private readonly string response;
+            private readonly string authorization;
+            private ReceivedRequest received;
+            private int challenges;
+            private Exception failure;
+
+            public StandInServer(string response)
+                : this(response, null, null)
+            {
+            }
+
+            public StandInServer(string response, string userName, string password)
+            {
+                this.response = response;
+                if (userName != null)
+                    authorization = "Basic " + Convert.ToBase64String(Encoding.UTF8.GetBytes(userName + ":" + password));
+                listener.Start();
+                thread = new Thread(Serve);
+                thread.IsBackground = true;
+                thread.Start();
+            }
+
+            public string Url
+            {
+                get { return String.Format(CultureInfo.InvariantCulture, "http://127.0.0.1:{0}/xmlrpc.php", ((IPEndPoint)listener.LocalEndpoint).Port); }
+            }
+
+            public ReceivedRequest Received
+            {
+                get
+                {
+                    Assert.IsTrue(thread.Join(TimeSpan.FromSeconds(30)), "the server didn't finish");
+                    if (failure != null)
+                        throw new Exception("The stand-in server failed", failure);
+                    return received;
+                }
+            }
+
+            /// <summary>
+            /// How many requests were answered with a challenge.
+            /// </summary>
+            public int Challenges
+            {
+                get { return challenges; }
+            }
+
+            private void Serve()
+            {
+                try
+                {
+                    while (received == null)
+                        ServeOne();
+                }
+                catch (Exception e)
+                {
+                    failure = e;
+                }
+            }
+
+            private void ServeOne()
+            {
+                using (TcpClient client = listener.AcceptTcpClient())
+                using (NetworkStream stream = client.GetStream())
+                {
+                    ReceivedRequest request = new ReceivedRequest();
+                    string line = ReadLine(stream);
+                    Assert.IsTrue(line.StartsWith("POST ", StringComparison.Ordinal), line);
+                    while ((line = ReadLine(stream)).Length > 0)
+                    {
+                        int colon = line.IndexOf(':');
+                        request.Headers[line.Substring(0, colon)] = line.Substring(colon + 1).Trim();
+                    }
+
+                    string expect;
+                    if (request.Headers.TryGetValue("Expect", out expect) && expect == "100-continue")
+                        Write(stream, "HTTP/1.1 100 Continue\r\n\r\n");
+
+                    MemoryStream body = new MemoryStream();
+                    long length = Int64.Parse(request.Headers["Content-Length"], CultureInfo.InvariantCulture);
+                    byte[] buffer = new byte[64 * 1024];
+                    while (body.Length < length)
+                    {
+                        int read = stream.Read(buffer, 0, (int)Math.Min(buffer.Length, length - body.Length));
+                        if (read == 0)
+                            throw new EndOfStreamException();
+                        body.Write(buffer, 0, read);
+                    }
+                    request.Body = body.ToArray();
+
+                    // the whole body is read first, so the client sees the challenge rather than a reset connection
+                    string credentials;
+                    if (authorization != null && !(request.Headers.TryGetValue("Authorization", out credentials) && credentials == authorization))
+                    {
+                        Write(stream, "HTTP/1.1 401 Unauthorized\r\nWWW-Authenticate: Basic realm=\"xmlrpc\"\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+                        challenges++;
+                        return;
+                    }
+
+                    byte[] responseBytes = Encoding.UTF8.GetBytes(response);
+                    Write(stream, String.Format(CultureInfo.InvariantCulture,
+                        "HTTP/1.1 200 OK\r\nContent-Type: text/xml; charset=utf-8\r\nContent-Length: {0}\r\nConnection: close\r\n\r\n", responseBytes.Length));
+                    stream.Write(responseBytes, 0, responseBytes.Length);
+                    received = request;
+                }
+            }
+
+            private static string ReadLine(Stream stream)
+            {
+                StringBuilder line = new StringBuilder();
+                int c;
+                while ((c = stream.ReadByte()) != '\n')
+                {
+                    if (c == -1)
+                        throw new EndOfStreamException();
+                    if (c != '\r')
+                        line.Append((char)c);
+                }
+                return line.ToString();
+            }
+
+            private static void Write(Stream stream, string text)
+            {
+                byte[] bytes = Encoding.ASCII.GetBytes(text);
+                stream.Write(bytes, 0, bytes.Length);
+            }
+
+            public void Dispose()
+            {
+                listener.Stop();
+            }
+        }
+
+        private static XmlRpcValue[] NewMediaObject(XmlRpcValue bits)
+        {
+            return new XmlRpcValue[]
+            {
+                new XmlRpcString("1"),
+                new XmlRpcString("writer"),
+                new XmlRpcString("p&ssword <1>", true),
+                new XmlRpcStruct(new XmlRpcMember[]
+                {
+                    new XmlRpcMember("name", "beach été.jpg"),
+                    new XmlRpcMember("type", "image/jpeg"),
+                    new XmlRpcMember("bits", bits),
+                }),
+            };
+        }
+
+        private static ReceivedRequest Send(Encoding encoding, XmlRpcValue bits)
+        {
+            using (StandInServer server = new StandInServer(MEDIA_OBJECT_RESPONSE))
+            {
+                HttpWebRequest request = (HttpWebRequest)WebRequest.Create(server.Url);
+                request.Method = "POST";
+                request.KeepAlive = false;
+                request.ContentType = "text/xml;charset=" + encoding.WebName;
+                XmlRpcClient.WriteRequest(request, encoding, "metaWeblog.newMediaObject", NewMediaObject(bits));
+
+                using (HttpWebResponse response = (HttpWebResponse)request.GetResponse())
+                using (StreamReader reader = new StreamReader(response.GetResponseStream()))
+                    Assert.AreEqual(MEDIA_OBJECT_RESPONSE, reader.ReadToEnd());
+
+                return server.Received;
+            }
+        }
+
+        private static byte[] MakeContents(int length, int seed)
+        {
+            byte[] contents = new byte[length];
+            new Random(seed).NextBytes(contents);
+            return contents;
+        }
+
+        private static byte[] DecodeBits(ReceivedRequest request, Encoding encoding)
+        {
+            XmlDocument document = new XmlDocument();
+            using (StreamReader reader = new StreamReader(new MemoryStream(request.Body), encoding))
+                document.LoadXml(reader.ReadToEnd());
+            Assert.AreEqual("metaWeblog.newMediaObject", document.SelectSingleNode("/methodCall/methodName").InnerText);
+            return Convert.FromBase64String(document.SelectSingleNode("//member[name='bits']/value/base64").InnerText);
+        }
+
+        private void AssertStreamedSameAsInMemory(int length, Encoding encoding)
+        {
+            // Arrange
+            byte[] contents = MakeContents(length, length);
+            File.WriteAllBytes(tempFile, contents);
+
+            // Act
+            ReceivedRequest inMemory = Send(encoding, new XmlRpcBase64(contents));
+            ReceivedRequest streamed;
+            using (FileStream file = new FileStream(tempFile, FileMode.Open, FileAccess.Read))
+                streamed = Send(encoding, new XmlRpcBase64(file));
+
+            // Assert
+            Assert.IsFalse(streamed.Headers.ContainsKey("Transfer-Encoding"));
+            Assert.AreEqual(streamed.Body.Length.ToString(CultureInfo.InvariantCulture), streamed.Headers["Content-Length"]);
+            Assert.AreEqual(inMemory.Body, streamed.Body);
+            Assert.AreEqual(contents, DecodeBits(streamed, encoding));
+        }
+
+        [TestCase(0)]
+        [TestCase(1)]
+        [TestCase(2)]
+        [TestCase(3)]
+        [TestCase(1000)]
+        [TestCase(48 * 1024 - 1)]
+        [TestCase(48 * 1024)]
+        [TestCase(48 * 1024 + 1)]
+        [TestCase(100 * 1024 + 2)]
+        public void StreamedUploadMatchesInMemoryUpload(int length)
+        {
+            AssertStreamedSameAsInMemory(length, new UTF8Encoding(false, false));
+        }
+
+        [Test]
+        public void LargeUploadIsStreamedUnbuffered()
+        {
+            // larger than requests that stay buffered
+            AssertStreamedSameAsInMemory(3 * 1024 * 1024 + 1, new UTF8Encoding(false, false));
+        }
+
+        [TestCase("iso-8859-1")]
+        [TestCase("utf-16")]
+        public void StreamedUploadInOtherEncodings(string encoding)
+        {
+            AssertStreamedSameAsInMemory(50 * 1024, Encoding.GetEncoding(encoding));
+        }
+
+        [TestCase(1000)]
+        [TestCase(3 * 1024 * 1024 + 1)]
+        public void UploadIsSentAgainAfterAuthenticationChallenge(int length)
+        {
+            // Arrange
+            byte[] contents = MakeContents(length, length);
+            File.WriteAllBytes(tempFile, contents);
+            Encoding encoding = new UTF8Encoding(false, false);
+
+            using (StandInServer server = new StandInServer(MEDIA_OBJECT_RESPONSE, "writer", "secret"))
+            using (FileStream file = new FileStream(tempFile, FileMode.Open, FileAccess.Read))
+            {
+                // Act
+                XmlRpcRequestSender send = delegate (HttpRequestFilter filter)
+                {
+                    HttpWebRequest request = (HttpWebRequest)WebRequest.Create(server.Url);
+                    request.Method = "POST";
+                    request.KeepAlive = false;
+                    request.ContentType = "text/xml;charset=" + encoding.WebName;
+                    filter(request);
+                    return (HttpWebResponse)request.GetResponse();
+                };
+                HttpRequestFilter credentials = delegate (HttpWebRequest request)
+                {
+                    request.Credentials = new NetworkCredential("writer", "secret");
+                };
+                using (HttpWebResponse response = XmlRpcClient.SendRequest(send, credentials, encoding, "metaWeblog.newMediaObject", NewMediaObject(new XmlRpcBase64(file))))
+                using (StreamReader reader = new StreamReader(response.GetResponseStream()))
+                    Assert.AreEqual(MEDIA_OBJECT_RESPONSE, reader.ReadToEnd());
+
+                // Assert
+                ReceivedRequest received = server.Received;
+                Assert.Greater(server.Challenges, 0);
+                Assert.AreEqual(contents, DecodeBits(received, encoding));
+            }
+        }
+
+        [Test]
+        public void StreamedFromCurrentPosition()
+        {
+            // Arrange
+            byte[] contents = MakeContents(70000, 1);
+            byte[] rest = new byte[contents.Length - 1234];
+            Array.Copy(contents, 1234, rest, 0, rest.Length);
+            MemoryStream stream = new MemoryStream(contents);
+            stream.Position = 1234;
+
+            // Act
+            ReceivedRequest received = Send(Encoding.UTF8, new XmlRpcBase64(stream));
+
+            // Assert
+            Assert.AreEqual(rest, DecodeBits(received, Encoding.UTF8));
+        }
+    }
+}
@@ -0,0 +1,211 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Text;
+
+using NUnit.Framework;
+
+using OpenLiveWriter.CoreServices.HTML;
+using OpenLiveWriter.HtmlParser.Parser;
+
+namespace OpenLiveWriter.Tests.HtmlParser
+{
+    /// <summary>
+    /// Compares SimpleHtmlParser on top of the native tokenizer with the regular
+    /// expressions it uses otherwise: every element, its span, name, attributes and
+    /// residue, and the parser's Position along the way.
+    /// </summary>
+    [TestFixture]
+    public class SimpleHtmlParserTests
+    {
+        public static readonly string[] Posts =
+        {
+            "<p>Just text, with an &amp; entity and a 1 < 2 comparison.</p>",
+            "<!DOCTYPE html PUBLIC \"-//W3C//DTD XHTML 1.0 Transitional//EN\" \"http://www.w3.org/TR/xhtml1/DTD/xhtml1-transitional.dtd\">\r\n<html xmlns=\"http://www.w3.org/1999/xhtml\"><head><title>Post</title>\r\n"
+                + "<meta http-equiv=\"Content-Type\" content=\"text/html; charset=utf-8\" /><link rel=stylesheet href=style.css></head>\r\n<body class=\"post\">",
+            "<p>We spent the weekend at the beach.</p>\r\n<p><a href=\"http://example.com/photos/beach.jpg\"><img style=\"border-bottom: 0px; border-left: 0px; display: inline; border-top: 0px; border-right: 0px\" "
+                + "title=\"beach\" border=\"0\" alt=\"beach\" src=\"http://example.com/photos/beach_thumb.jpg\" width=\"244\" height=\"184\" /></a></p>\r\n"
+                + "<div id=\"scid:5737277B-5D6D-4f48-ABFC-DD9C333F4C5D:4c3e1b14-7a9e-4c1a-8c3f-6f2c0d4e5a91\" class=\"wlWriterEditableSmartContent\" style=\"float: none; margin: 0px; display: inline; padding: 0px\">"
+                + "<div><object width=\"425\" height=\"355\"><param name=\"movie\" value=\"http://www.youtube.com/v/abc123&amp;hl=en\"></param><embed src=\"http://www.youtube.com/v/abc123&amp;hl=en\" type=\"application/x-shockwave-flash\" width=\"425\" height=\"355\"></embed></object></div></div>",
+            "<script type=\"text/javascript\">\r\n// <![CDATA[\r\nvar s = '<p>' + \"</scr\" + \"ipt>\"; if (a < b && c > d) { document.write('<img src=\"x\">'); }\r\n// ]]>\r\n</script><p>after</p>",
+            "<style type=\"text/css\">\r\n.post img { border: 0; background: url('images/bg.png') } /* <b>not a tag</b> */\r\n@media print { p { color: #000 } }\r\n</STYLE >after<style></style><script></script>",
+            "<!--[if lt IE 9]><script src=\"html5shiv.js\"></script><![endif]--><!-- a comment -- ><!---->",
+            "<p>A tag that <a href=\"x\" <b>runs into</b> the next and <img src='y' / > one with a space.</p>",
+            "<table border=1 cellpadding=\"2\" cellspacing='0' width=100%><tr><td valign=top nowrap>one</td><TD ALIGN = \"center\" >two</TD></tr></table>",
+            "<p title=\"multi\r\nline\" data-x = 'it''s' data-y=\"a\"b\" checked disabled=disabled/>text</p ><br/><br /><hr noshade>",
+            "<pre>&lt;not a tag&gt; < p> <1> <_x> <-> <!> <!-> </> </ p> </p junk> <:x> <a:b.c-d_e>ns</a:b.c-d_e></pre>",
+            "<p>été — “quoted” 日本語 <span lang=\"ja\">日本</span> 😀</p>",
+            "<a href=http://example.com/?a=1&b=2>unquoted</a><a href= \"spaced\" >spaced</a><a href=>empty</a><a href='>'>bracket</a>",
+        };
+
+        // HTML that ends in the middle of something
+        public static readonly string[] Fragments =
+        {
+            "<script>unterminated script <b>bold</b>",
+            "<style>p { color: red }",
+            "<p>text<!-- unterminated comment <b>bold</b>",
+            "<p>text<!DOCTYPE unterminated",
+            "<p>text<div class=\"z\" title='unterminated",
+            "<p>text</p",
+            "<",
+            "",
+        };
+
+        private static string Describe(Element element)
+        {
+            if (element == null)
+                return "(end)";
+
+            StringBuilder description = new StringBuilder();
+            description.AppendFormat("{0} {1}+{2}", element.GetType().Name, element.Offset, element.Length);
+            Tag tag = element as Tag;
+            if (tag != null)
+                description.Append(' ').Append(tag.Name);
+            BeginTag beginTag = element as BeginTag;
+            if (beginTag != null)
+            {
+                foreach (Attr attr in beginTag.Attributes)
+                    description.AppendFormat(" [{0}={1}]", attr.Name, attr.Value ?? "(none)");
+                if (beginTag.Complete)
+                    description.Append(" complete");
+                if (beginTag.HasResidue)
+                    description.AppendFormat(" residue [{0}]", beginTag.Residue);
+            }
+            return description.ToString();
+        }
+
+        private static void AssertNativeAvailable()
+        {
+            // the tokenizer is in the same DLL as the reference rewriter
+            string rewritten;
+            if (!HtmlReferenceRewriter.TryRewrite("<img src=\"a\">", new Dictionary<string, string> { { "a", "b" } }, out rewritten))
+                Assert.Ignore("OpenLiveWriter.Native.dll isn't available");
+        }
+
+        private static void AssertSameAsManaged(string html)
+        {
+            AssertNativeAvailable();
+
+            SimpleHtmlParser managed = new SimpleHtmlParser(html, false);
+            SimpleHtmlParser native = new SimpleHtmlParser(html, true);
+            for (int i = 0; ; i++)
+            {
+                Assert.AreEqual(managed.Position, native.Position, "Position before element {0} of {1}", i, html);
+                Element expected = managed.Next();
+                Element actual = native.Next();
+                Assert.AreEqual(Describe(expected), Describe(actual), "Element {0} of {1}", i, html);
+                if (expected == null)
+                    break;
+            }
+        }
+
+        private static string RandomHtml(Random random)
+        {
+            string[] pieces =
+            {
+                "<", ">", "/", "/>", "=", "\"", "'", " ", "\r\n", "\t", "!", "-", "--", "<!--", "-->", "<!", "</",
+                "p", "a", "div", "img", "script", "style", "SCRIPT", "Style", "href", "src", "x:y", "a.b", "_", "1",
+                "<p>", "</p>", "<script>", "</script>", "</script >", "<style>", "</style>", "<a href=\"x\">", "<img src=y />",
+                "text", "&amp;", "é", "日", "😀", "{ }", "/*", "*/", "//", "'<'", "\"<\"",
+            };
+
+            StringBuilder html = new StringBuilder();
+            int count = random.Next(60);
+            for (int i = 0; i < count; i++)
+                html.Append(pieces[random.Next(pieces.Length)]);
+            return html.ToString();
+        }
+
+        private static string LargePost(int paragraphs)
+        {
+            StringBuilder html = new StringBuilder();
+            for (int i = 0; i < paragraphs; i++)
+                html.Append(Posts[i % Posts.Length]).Append("\r\n");
+            return html.ToString();
+        }
+
+        [TestCaseSource(nameof(Posts))]
+        public void Native_Matches_Managed(string html)
+        {
+            AssertSameAsManaged(html);
+        }
+
+        [TestCaseSource(nameof(Fragments))]
+        public void Native_Matches_Managed_On_Fragment(string html)
+        {
+            AssertSameAsManaged(html);
+        }
+
+        [Test]
+        public void Native_Matches_Managed_On_Random_Html()
+        {
+            // Arrange
+            Random random = new Random(20161018);
+
+            // Act and Assert
+            for (int i = 0; i < 5000; i++)
+                AssertSameAsManaged(RandomHtml(random));
+        }
+
+        [Test]
+        public void Native_Matches_Managed_On_Large_Post()
+        {
+            // more tokens than the tokenizer returns at once
+            AssertSameAsManaged(LargePost(500));
+        }
+
+        [Test]
+        public void Native_Matches_Managed_With_Many_Attributes()
+        {
+            // Arrange
+            StringBuilder html = new StringBuilder("<p>x</p><div");
+            for (int i = 0; i < 3000; i++)
+                html.AppendFormat(" data-{0}=\"{0}\"", i);
+            html.Append(">y</div>");
+
+            // Act and Assert
+            AssertSameAsManaged(html.ToString());
+        }
+
+        [Test]
+        public void Peek_Matches_Managed()
+        {
+            // Arrange
+            AssertNativeAvailable();
+            string html = LargePost(20);
+            SimpleHtmlParser managed = new SimpleHtmlParser(html, false);
+            SimpleHtmlParser native = new SimpleHtmlParser(html, true);
+
+            // Act and Assert
+            for (int i = 0; managed.Peek(0) != null; i++)
+            {
+                Assert.AreEqual(Describe(managed.Peek(i % 3)), Describe(native.Peek(i % 3)));
+                Assert.AreEqual(managed.Position, native.Position);
+                Assert.AreEqual(Describe(managed.Next()), Describe(native.Next()));
+            }
+            Assert.IsNull(native.Next());
+        }
+
+        [Test, Explicit("Benchmark")]
+        public void Benchmark_Tokens_Per_Second()
+        {
+            AssertNativeAvailable();
+            string html = LargePost(2000);
+            foreach (bool useNativeTokenizer in new bool[] { false, true })
+            {
+                int elements = 0;
+                Stopwatch stopwatch = Stopwatch.StartNew();
+                for (int i = 0; i < 10; i++)
+                {
+                    SimpleHtmlParser parser = new SimpleHtmlParser(html, useNativeTokenizer);
+                    while (parser.Next() != null)
+                        elements++;
+                }
+                stopwatch.Stop();
+
+                Console.WriteLine("{0}: {1:N0} elements/s, {2:N1} MB/s", useNativeTokenizer ? "native" : "managed",
+                    elements / stopwatch.Elapsed.TotalSeconds, html.Length * 2 * 10 / stopwatch.Elapsed.TotalSeconds / 1e6);
+            }
+        }
+    }
+}
@@ -0,0 +1,172 @@
+﻿using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Xml;
+
+using NUnit.Framework;
+
+using OpenLiveWriter.Localization;
+
+namespace OpenLiveWriter.Tests.Localization
+{
+    [TestFixture]
+    public class RibbonCommandTableTests
+    {
+        private const string RibbonNamespace = "http://schemas.microsoft.com/windows/2009/Ribbon";
+
+        private XmlDocument ribbon;
+        private XmlNamespaceManager namespaces;
+
+        [OneTimeSetUp]
+        public void LoadRibbon()
+        {
+            // the checked-in markup, found by walking up from the test binaries
+            DirectoryInfo directory = new DirectoryInfo(TestContext.CurrentContext.TestDirectory);
+            string path = null;
+            for (; directory != null && path == null; directory = directory.Parent)
+            {
+                string candidate = Path.Combine(directory.FullName, @"src\unmanaged\OpenLiveWriter.Ribbon\Ribbon.xml");
+                if (File.Exists(candidate))
+                    path = candidate;
+            }
+            if (path == null)
+                Assert.Ignore("Ribbon.xml isn't reachable from " + TestContext.CurrentContext.TestDirectory);
+
+            ribbon = new XmlDocument();
+            ribbon.Load(path);
+            namespaces = new XmlNamespaceManager(ribbon.NameTable);
+            namespaces.AddNamespace("ribbon", RibbonNamespace);
+        }
+
+        [Test]
+        public void Table_Matches_Ribbon_Commands()
+        {
+            // Arrange
+            XmlNodeList commands = ribbon.SelectNodes("//ribbon:Application.Commands/ribbon:Command", namespaces);
+
+            // Assert
+            Assert.AreEqual(commands.Count, RibbonCommandTable.CommandCount, "Regenerate RibbonCommandTable.cs from Ribbon.xml");
+            foreach (XmlElement command in commands)
+            {
+                uint id = uint.Parse(command.GetAttribute("Id"));
+                string symbol = command.HasAttribute("Symbol") ? command.GetAttribute("Symbol") : command.GetAttribute("Name");
+
+                int index = RibbonCommandTable.FindById(id);
+                Assert.GreaterOrEqual(index, 0, symbol);
+                Assert.AreEqual(index, RibbonCommandTable.FindBySymbol(symbol), symbol);
+                Assert.AreEqual(id, RibbonCommandTable.GetId(index));
+                Assert.AreEqual(symbol, RibbonCommandTable.GetSymbol(index));
+                Assert.AreEqual(command.GetAttribute("Keytip"), RibbonCommandTable.GetKeytip(index), symbol);
+            }
+        }
+
+        [Test]
+        [TestCase(0u)]
+        [TestCase(4u)]
+        [TestCase(65535u)]
+        [TestCase(uint.MaxValue)]
+        public void FindById_Unknown_Id_Returns_Minus_One(uint id)
+        {
+            // Assert
+            Assert.AreEqual(-1, RibbonCommandTable.FindById(id));
+        }
+
+        [Test]
+        [TestCase(null)]
+        [TestCase("")]
+        [TestCase("Bold")]
+        [TestCase("cmdbold")]
+        public void FindBySymbol_Unknown_Symbol_Returns_Minus_One(string symbol)
+        {
+            // Assert
+            Assert.AreEqual(-1, RibbonCommandTable.FindBySymbol(symbol));
+        }
+
+        [Test]
+        public void Identifiers_Follow_CommandId_Names()
+        {
+            // CommandManager.Get looks ribbon commands up by identifier, and
+            // commands are registered under CommandId.ToString()
+            int found = 0;
+            foreach (CommandId commandId in Enum.GetValues(typeof(CommandId)))
+            {
+                // Act
+                int index = RibbonCommandTable.FindById((uint)commandId);
+                if (index < 0)
+                    continue;
+                found++;
+
+                // Assert
+                Assert.AreEqual(commandId.ToString(), RibbonCommandTable.GetIdentifier(index), "Regenerate RibbonCommandTable.cs from CommandId.cs");
+            }
+            Assert.AreEqual(RibbonCommandTable.CommandCount, found, "Every ribbon command needs a CommandId");
+        }
+
+        [Test]
+        public void Identifier_Differs_From_Symbol()
+        {
+            // Act
+            int index = RibbonCommandTable.FindById((uint)CommandId.ImageSaveDefaults);
+
+            // Assert
+            Assert.AreEqual("cmdFormatImageSaveSettings", RibbonCommandTable.GetSymbol(index));
+            Assert.AreEqual("ImageSaveDefaults", RibbonCommandTable.GetIdentifier(index));
+        }
+
+        [Test]
+        public void GroupPath_Lists_Tab_And_Group()
+        {
+            // Act
+            int index = RibbonCommandTable.FindById((uint)CommandId.Bold);
+
+            // Assert
+            Assert.AreEqual("cmdHomeTab/cmdFontGroup", RibbonCommandTable.GetGroupPath(index));
+        }
+
+        [Test]
+        public void Tabs_And_Groups_Match_Ribbon_Views()
+        {
+            // Arrange
+            XmlNodeList tabs = ribbon.SelectNodes("//ribbon:Application.Views//ribbon:Tab", namespaces);
+
+            // Assert
+            Assert.AreEqual(tabs.Count, RibbonCommandTable.TabCount);
+            int group = 0;
+            for (int tab = 0; tab < tabs.Count; tab++)
+            {
+                XmlElement tabElement = (XmlElement)tabs[tab];
+                Assert.AreEqual(tabElement.GetAttribute("CommandName"), Name(RibbonCommandTable.GetTabCommand(tab)));
+                Assert.AreEqual(group, RibbonCommandTable.GetTabGroupStart(tab));
+
+                foreach (XmlElement groupElement in tabElement.SelectNodes("ribbon:Group", namespaces))
+                {
+                    Assert.AreEqual(groupElement.GetAttribute("CommandName"), Name(RibbonCommandTable.GetGroupCommand(group)));
+                    Assert.AreEqual(tab, RibbonCommandTable.GetGroupTab(group));
+
+                    List<string> expected = new List<string>();
+                    foreach (XmlElement member in groupElement.SelectNodes(".//*[@CommandName]", namespaces))
+                    {
+                        if (!expected.Contains(member.GetAttribute("CommandName")))
+                            expected.Add(member.GetAttribute("CommandName"));
+                    }
+                    List<string> actual = new List<string>();
+                    for (int i = RibbonCommandTable.GetGroupMemberStart(group); i < RibbonCommandTable.GetGroupMemberEnd(group); i++)
+                        actual.Add(Name(RibbonCommandTable.GetGroupMember(i)));
+                    CollectionAssert.AreEqual(expected, actual, groupElement.GetAttribute("CommandName"));
+
+                    group++;
+                }
+                Assert.AreEqual(group, RibbonCommandTable.GetTabGroupEnd(tab));
+            }
+            Assert.AreEqual(group, RibbonCommandTable.GroupCount);
+        }
+
+        // CommandName refers to the Name attribute, which can differ from the symbol
+        private string Name(int index)
+        {
+            XmlElement command = (XmlElement)ribbon.SelectSingleNode(
+                "//ribbon:Application.Commands/ribbon:Command[@Id='" + RibbonCommandTable.GetId(index) + "']", namespaces);
+            return command.GetAttribute("Name");
+        }
+    }
+}
@@ -0,0 +1,201 @@
+﻿using System;
+using System.Diagnostics;
+using System.IO;
+using System.Text;
+
+using NUnit.Framework;
+
+using OpenLiveWriter.Interop.Com.StructuredStorage;
+using OpenLiveWriter.PostEditor;
+
+namespace OpenLiveWriter.Tests.PostEditor
+{
+    [TestFixture]
+    public class PostContentsJournalTests
+    {
+        private static byte[] Bytes(string value)
+        {
+            return Encoding.UTF8.GetBytes(value);
+        }
+
+        private static MemoryStream Journal(byte[] baseContents, params string[] versions)
+        {
+            var journal = new MemoryStream();
+            byte[] header = PostContentsJournal.CreateHeader(baseContents);
+            journal.Write(header, 0, header.Length);
+
+            byte[] previous = baseContents;
+            foreach (string version in versions)
+            {
+                byte[] record = PostContentsJournal.CreateRecord(previous, Bytes(version));
+                journal.Write(record, 0, record.Length);
+                previous = Bytes(version);
+            }
+
+            journal.Position = 0;
+            return journal;
+        }
+
+        [Test]
+        public void Crc32_Matches_Standard_Check_Value()
+        {
+            // Act
+            uint crc = PostContentsJournal.Crc32(Bytes("123456789"), 0, 9);
+
+            // Assert
+            Assert.AreEqual(0xCBF43926, crc);
+        }
+
+        [Test]
+        public void CreateRecord_Identical_Contents_Returns_Null()
+        {
+            // Act
+            byte[] record = PostContentsJournal.CreateRecord(Bytes("<p>same</p>"), Bytes("<p>same</p>"));
+
+            // Assert
+            Assert.IsNull(record);
+        }
+
+        [Test]
+        public void CreateRecord_Only_Stores_Changed_Range()
+        {
+            // Arrange
+            string padding = new string('x', 10000);
+
+            // Act
+            byte[] record = PostContentsJournal.CreateRecord(Bytes(padding + "a" + padding), Bytes(padding + "bc" + padding));
+
+            // Assert
+            Assert.AreEqual(8 + 8 + 2, record.Length);
+        }
+
+        [Test]
+        [TestCase("<p>hello world</p>", "<p>hello brave world</p>", "<p>brave world!</p>")]
+        [TestCase("", "<p>first</p>", "")]
+        [TestCase("<p>aaaa</p>", "<p>aaaaaa</p>", "<p>aa</p>")]
+        [TestCase("<p>café</p>", "<p>cafè</p>", "<p>日本</p>")]
+        public void Apply_Replays_Every_Record(string baseContents, string first, string second)
+        {
+            // Arrange
+            byte[] baseBytes = Bytes(baseContents);
+            MemoryStream journal = Journal(baseBytes, first, second);
+
+            // Act
+            long validLength;
+            int records;
+            byte[] result = PostContentsJournal.Apply(baseBytes, journal, out validLength, out records);
+
+            // Assert
+            Assert.AreEqual(Bytes(second), result);
+            Assert.AreEqual(2, records);
+            Assert.AreEqual(journal.Length, validLength);
+        }
+
+        [Test]
+        public void Apply_Ignores_Torn_Tail()
+        {
+            // Arrange
+            byte[] baseBytes = Bytes("<p>hello world</p>");
+            MemoryStream complete = Journal(baseBytes, "<p>hello brave world</p>", "<p>brave world!</p>");
+            var torn = new MemoryStream(complete.ToArray(), 0, (int)complete.Length - 3);
+
+            // Act
+            long validLength;
+            int records;
+            byte[] result = PostContentsJournal.Apply(baseBytes, torn, out validLength, out records);
+
+            // Assert
+            Assert.AreEqual(Bytes("<p>hello brave world</p>"), result);
+            Assert.AreEqual(1, records);
+            Assert.Less(validLength, torn.Length);
+        }
+
+        [Test]
+        public void Apply_Stops_At_Corrupt_Record()
+        {
+            // Arrange
+            byte[] baseBytes = Bytes("<p>hello world</p>");
+            byte[] journal = Journal(baseBytes, "<p>hello brave world</p>", "<p>brave world!</p>").ToArray();
+            journal[journal.Length - 1] ^= 0xFF;
+
+            // Act
+            long validLength;
+            int records;
+            byte[] result = PostContentsJournal.Apply(baseBytes, new MemoryStream(journal), out validLength, out records);
+
+            // Assert
+            Assert.AreEqual(Bytes("<p>hello brave world</p>"), result);
+            Assert.AreEqual(1, records);
+        }
+
+        [Test]
+        public void Apply_Ignores_Journal_For_Different_Base()
+        {
+            // Arrange
+            MemoryStream journal = Journal(Bytes("<p>hello world</p>"), "<p>hello brave world</p>");
+            byte[] rewrittenBase = Bytes("<p>rewritten by someone else</p>");
+
+            // Act
+            long validLength;
+            int records;
+            byte[] result = PostContentsJournal.Apply(rewrittenBase, journal, out validLength, out records);
+
+            // Assert
+            Assert.AreEqual(rewrittenBase, result);
+            Assert.AreEqual(0, records);
+            Assert.AreEqual(0, validLength);
+        }
+
+        [Test, Explicit("Benchmark")]
+        public void Benchmark_Save_Cost()
+        {
+            const int saves = 20;
+            foreach (int postSize in new int[] { 16 * 1024, 256 * 1024, 4 * 1024 * 1024 })
+            {
+                foreach (int editSize in new int[] { 16, 1024, 16 * 1024 })
+                {
+                    foreach (bool append in new bool[] { false, true })
+                    {
+                        string path = Path.Combine(Path.GetTempPath(), "PostContentsJournalTests-" + Guid.NewGuid().ToString("N") + ".wpost");
+                        try
+                        {
+                            byte[] contents = Bytes(new StringBuilder().Insert(0, "<p>Lorem ipsum dolor sit amet.</p>", postSize / 34 + 1).ToString(0, postSize));
+                            PostContentsJournal journal = new PostContentsJournal();
+                            Save(journal, path, contents, false);
+
+                            // each autosave rewrites a different stretch of the post, the way typing moves through it
+                            Random random = new Random(1);
+                            Stopwatch stopwatch = Stopwatch.StartNew();
+                            for (int i = 0; i < saves; i++)
+                            {
+                                contents = (byte[])contents.Clone();
+                                int offset = random.Next(contents.Length - editSize);
+                                for (int j = 0; j < editSize; j++)
+                                    contents[offset + j] = (byte)('a' + random.Next(26));
+                                Save(journal, path, contents, append);
+                            }
+                            stopwatch.Stop();
+
+                            Console.WriteLine("post {0,9:N0} bytes, edit {1,6:N0} bytes, {2}: {3,8:N2} ms/save, file {4,10:N0} bytes",
+                                postSize, editSize, append ? "journal" : "rewrite",
+                                stopwatch.Elapsed.TotalMilliseconds / saves, new FileInfo(path).Length);
+                        }
+                        finally
+                        {
+                            File.Delete(path);
+                        }
+                    }
+                }
+            }
+        }
+
+        private static void Save(PostContentsJournal journal, string path, byte[] contents, bool append)
+        {
+            using (Storage post = new Storage(path, StorageMode.OpenOrCreate, true))
+            {
+                journal.Write(post, "Contents", path, contents, append);
+                post.Commit();
+            }
+        }
+    }
+}
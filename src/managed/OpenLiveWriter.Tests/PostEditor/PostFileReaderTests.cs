@@ -0,0 +1,178 @@
+﻿using System;
+using System.IO;
+using System.Text;
+
+using NUnit.Framework;
+
+using OpenLiveWriter.Interop.Com.StructuredStorage;
+using OpenLiveWriter.PostEditor;
+
+namespace OpenLiveWriter.Tests.PostEditor
+{
+    [TestFixture]
+    public class PostFileReaderTests
+    {
+        private static readonly Guid pictureName = new Guid("3EF3AA3F-5560-4750-9C97-171B37D7F45A");
+        private string path;
+
+        [SetUp]
+        public void SetUp()
+        {
+            path = Path.Combine(Path.GetTempPath(), "PostFileReaderTests-" + Guid.NewGuid().ToString("N") + ".wpost");
+            using (Storage post = new Storage(path, StorageMode.Create, true))
+            {
+                Write(post, "PostTitle", new UnicodeEncoding(false, true).GetPreamble(), Encoding.Unicode.GetBytes("A title ü"));
+                Write(post, "Contents", Encoding.UTF8.GetPreamble(), Encoding.UTF8.GetBytes("<p>Contents ü</p>"));
+                Write(post, "DatePublished", BitConverter.GetBytes(new DateTime(2016, 1, 2).Ticks));
+                Write(post, "Empty");
+                Write(post, "BigEndian", Encoding.BigEndianUnicode.GetPreamble(), Encoding.BigEndianUnicode.GetBytes("Big endian ü"));
+                Write(post, "Utf32", Encoding.UTF32.GetPreamble(), Encoding.UTF32.GetBytes("UTF-32 ü"));
+                Write(post, "Utf32BigEndian", new UTF32Encoding(true, true).GetPreamble(), new UTF32Encoding(true, true).GetBytes("UTF-32 big endian ü"));
+                using (Storage supportingFiles = post.OpenStorage("SupportingFiles", StorageMode.Create, true))
+                using (Storage picture = supportingFiles.OpenStorage(pictureName, StorageMode.Create, true))
+                {
+                    Write(picture, "SupportingFileName", new UnicodeEncoding(false, true).GetPreamble(), Encoding.Unicode.GetBytes("picture.jpg"));
+                    Write(picture, "SupportingFileContents", Picture());
+                    picture.Commit();
+                    supportingFiles.Commit();
+                }
+                post.Commit();
+            }
+        }
+
+        [TearDown]
+        public void TearDown()
+        {
+            File.Delete(path);
+        }
+
+        private static void Write(Storage storage, string name, params byte[][] parts)
+        {
+            using (Stream stream = storage.OpenStream(name, StorageMode.Create, true))
+            {
+                foreach (byte[] part in parts)
+                    stream.Write(part, 0, part.Length);
+            }
+        }
+
+        private static byte[] Picture()
+        {
+            byte[] picture = new byte[100000];
+            new Random(1).NextBytes(picture);
+            return picture;
+        }
+
+        private static byte[] ReadAll(Stream stream)
+        {
+            using (MemoryStream contents = new MemoryStream())
+            {
+                stream.CopyTo(contents);
+                return contents.ToArray();
+            }
+        }
+
+        private PostFileReader Decode()
+        {
+            PostFileReader reader = PostFileReader.TryDecode(path);
+            if (reader == null)
+                Assert.Ignore("OpenLiveWriter.Native.dll isn't available");
+            return reader;
+        }
+
+        [Test]
+        public void DecodedStringsMatchStructuredStorage()
+        {
+            // Arrange
+            using (PostFileReader expected = PostFileReader.Open(path))
+            using (PostFileReader actual = Decode())
+            {
+                // Act / Assert
+                foreach (string name in new string[] { "PostTitle", "Contents", "DatePublished", "Empty", "BigEndian", "Utf32", "Utf32BigEndian" })
+                {
+                    Assert.AreEqual(expected.ReadString(name), actual.ReadString(name), name);
+                    Assert.AreEqual(ReadAll(expected.OpenStream(name)), ReadAll(actual.OpenStream(name)), name);
+                }
+                Assert.AreEqual("A title ü", actual.ReadString("PostTitle"));
+                Assert.AreEqual("Big endian ü", actual.ReadString("BigEndian"));
+                Assert.AreEqual("UTF-32 ü", actual.ReadString("Utf32"));
+                Assert.AreEqual("UTF-32 big endian ü", actual.ReadString("Utf32BigEndian"));
+            }
+        }
+
+        [Test]
+        public void ReadsStreamsTooLongToDecodeThroughStructuredStorage()
+        {
+            // Arrange
+            byte[] large = new byte[5 * 1024 * 1024];
+            new Random(2).NextBytes(large);
+            using (Storage post = new Storage(path, StorageMode.Open, true))
+            using (Storage supportingFiles = post.OpenStorage("SupportingFiles", StorageMode.Open, true))
+            using (Storage picture = supportingFiles.OpenStorage(pictureName, StorageMode.Open, true))
+            {
+                Write(picture, "SupportingFileContents", large);
+                picture.Commit();
+                supportingFiles.Commit();
+                post.Commit();
+            }
+
+            using (PostFileReader post = Decode())
+            using (PostFileReader supportingFiles = post.OpenStorage("SupportingFiles"))
+            {
+                // Act
+                PostFileReader picture = supportingFiles.OpenStorage(pictureName);
+                byte[] contents;
+                using (Stream stream = picture.OpenStream("SupportingFileContents"))
+                    contents = ReadAll(stream);
+
+                // Assert
+                Assert.AreEqual(large, contents);
+                Assert.AreEqual("picture.jpg", picture.ReadString("SupportingFileName"));
+            }
+        }
+
+        [Test]
+        public void ReadsSupportingFiles()
+        {
+            // Arrange
+            using (PostFileReader post = Decode())
+            using (PostFileReader supportingFiles = post.OpenStorage("SupportingFiles"))
+            {
+                // Act
+                PostFileReader picture = supportingFiles.OpenStorage(pictureName);
+
+                // Assert
+                Assert.AreEqual("picture.jpg", picture.ReadString("SupportingFileName"));
+                Assert.AreEqual(Picture(), ReadAll(picture.OpenStream("SupportingFileContents")));
+            }
+        }
+
+        [Test]
+        public void ContainsIgnoresCase()
+        {
+            // Arrange
+            using (PostFileReader expected = PostFileReader.Open(path))
+            using (PostFileReader actual = Decode())
+            {
+                // Act / Assert
+                foreach (PostFileReader reader in new PostFileReader[] { expected, actual })
+                {
+                    Assert.IsTrue(reader.Contains("posttitle"));
+                    Assert.IsTrue(reader.Contains("SupportingFiles"));
+                    Assert.IsFalse(reader.Contains("ContentsJournal"));
+                }
+            }
+        }
+
+        [Test]
+        public void MissingStreamThrowsNotFound()
+        {
+            // Arrange
+            using (PostFileReader post = Decode())
+            {
+                // Act / Assert
+                Assert.Throws<StorageFileNotFoundException>(delegate { post.OpenStream("ContentsJournal"); });
+                Assert.Throws<StorageFileNotFoundException>(delegate { post.OpenStorage("PostTitle"); });
+            }
+        }
+    }
+}
@@ -0,0 +1,344 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.IO;
+using System.Text;
+
+using NUnit.Framework;
+
+using OpenLiveWriter.PostEditor.SupportingFiles;
+
+namespace OpenLiveWriter.Tests.PostEditor.SupportingFiles
+{
+    [TestFixture]
+    public class SupportingFileBlobStoreTests
+    {
+        private DirectoryInfo root;
+        private SupportingFileBlobStore store;
+        private DirectoryInfo sources;
+
+        [SetUp]
+        public void SetUp()
+        {
+            root = new DirectoryInfo(Path.Combine(Path.GetTempPath(), "BlobStoreTests-" + Guid.NewGuid().ToString("N")));
+            store = new SupportingFileBlobStore(root);
+            sources = new DirectoryInfo(root.FullName + "-sources");
+        }
+
+        [TearDown]
+        public void TearDown()
+        {
+            if (Directory.Exists(root.FullName))
+                Directory.Delete(root.FullName, true);
+            if (Directory.Exists(sources.FullName))
+                Directory.Delete(sources.FullName, true);
+        }
+
+        private static Stream Contents(string value)
+        {
+            return new MemoryStream(Encoding.UTF8.GetBytes(value));
+        }
+
+        private static string ReadAll(Stream stream)
+        {
+            using (StreamReader reader = new StreamReader(stream, Encoding.UTF8))
+                return reader.ReadToEnd();
+        }
+
+        private int BlobCount()
+        {
+            return Directory.GetFiles(root.FullName, "*", SearchOption.AllDirectories).Length;
+        }
+
+        private void Age(string hash, TimeSpan age)
+        {
+            string path = Path.Combine(Path.Combine(root.FullName, hash.Substring(0, 2)), hash);
+            File.SetLastWriteTimeUtc(path, DateTime.UtcNow - age);
+        }
+
+        [Test]
+        public void Add_Returns_Sha256_Of_Contents()
+        {
+            // Act
+            string hash = store.Add(Contents("abc"));
+
+            // Assert
+            Assert.AreEqual("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad", hash);
+            Assert.IsTrue(store.Contains(hash));
+        }
+
+        [Test]
+        public void Add_Identical_Contents_Stores_One_Copy()
+        {
+            // Act
+            string first = store.Add(Contents("<image bytes>"));
+            string second = store.Add(Contents("<image bytes>"));
+
+            // Assert
+            Assert.AreEqual(first, second);
+            Assert.AreEqual(1, BlobCount());
+        }
+
+        [Test]
+        public void Add_Non_Seekable_Stream_Stores_Contents()
+        {
+            // Act
+            string hash = store.Add(new NonSeekableStream(Contents("streamed")));
+
+            // Assert
+            Assert.AreEqual("streamed", ReadAll(store.Open(hash)));
+            Assert.AreEqual(1, BlobCount());
+        }
+
+        [Test]
+        public void Open_Returns_Stored_Contents()
+        {
+            // Arrange
+            string hash = store.Add(Contents("hello"));
+
+            // Act
+            string contents = ReadAll(store.Open(hash));
+
+            // Assert
+            Assert.AreEqual("hello", contents);
+        }
+
+        [Test]
+        [TestCase(null)]
+        [TestCase("")]
+        [TestCase("..\\..\\Windows")]
+        [TestCase("BA7816BF8F01CFEA414140DE5DAE2223B00361A396177A9CB410FF61F20015AD")]
+        public void Open_Invalid_Hash_Throws(string hash)
+        {
+            // Assert
+            Assert.Throws<ArgumentException>(() => store.Open(hash));
+            Assert.IsFalse(store.Contains(hash));
+        }
+
+        [Test]
+        public void CollectGarbage_Keeps_Referenced_And_Recent_Blobs()
+        {
+            // Arrange
+            string referenced = store.Add(Contents("referenced"));
+            string recent = store.Add(Contents("recent"));
+            string stale = store.Add(Contents("stale"));
+            Age(referenced, TimeSpan.FromDays(60));
+            Age(stale, TimeSpan.FromDays(60));
+            var referenceCounts = new Dictionary<string, int> { { referenced, 2 } };
+
+            // Act
+            int deleted = store.CollectGarbage(referenceCounts, TimeSpan.FromDays(30));
+
+            // Assert
+            Assert.AreEqual(1, deleted);
+            Assert.IsTrue(store.Contains(referenced));
+            Assert.IsTrue(store.Contains(recent));
+            Assert.IsFalse(store.Contains(stale));
+        }
+
+        [Test]
+        public void Add_Existing_Blob_Protects_It_From_Collection()
+        {
+            // Arrange
+            string hash = store.Add(Contents("reposted"));
+            Age(hash, TimeSpan.FromDays(60));
+
+            // Act
+            store.Add(Contents("reposted"));
+            int deleted = store.CollectGarbage(new Dictionary<string, int>(), TimeSpan.FromDays(30));
+
+            // Assert
+            Assert.AreEqual(0, deleted);
+            Assert.IsTrue(store.Contains(hash));
+        }
+
+        private string WriteSourceFile(string value)
+        {
+            Directory.CreateDirectory(sources.FullName);
+            string path = Path.Combine(sources.FullName, "image.png");
+            File.WriteAllText(path, value);
+            return path;
+        }
+
+        [Test]
+        public void AddFile_Unchanged_File_Reuses_Hash()
+        {
+            // Arrange
+            string path = WriteSourceFile("first");
+            string hash = store.AddFile(path);
+            DateTime lastWriteTimeUtc = File.GetLastWriteTimeUtc(path);
+
+            // Act: same size and time, so the file isn't read again
+            File.WriteAllText(path, "other");
+            File.SetLastWriteTimeUtc(path, lastWriteTimeUtc);
+
+            // Assert
+            Assert.AreEqual(hash, store.AddFile(path));
+        }
+
+        [Test]
+        public void AddFile_Changed_File_Is_Hashed_Again()
+        {
+            // Arrange
+            string path = WriteSourceFile("first");
+            string hash = store.AddFile(path);
+
+            // Act
+            File.WriteAllText(path, "second, longer");
+            string changedHash = store.AddFile(path);
+
+            // Assert
+            Assert.AreNotEqual(hash, changedHash);
+            Assert.AreEqual("second, longer", ReadAll(store.Open(changedHash)));
+        }
+
+        [Test]
+        public void AddFile_Stores_Again_When_Blob_Was_Deleted()
+        {
+            // Arrange
+            string path = WriteSourceFile("collected");
+            string hash = store.AddFile(path);
+            Directory.Delete(root.FullName, true);
+
+            // Act
+            Assert.AreEqual(hash, store.AddFile(path));
+
+            // Assert
+            Assert.IsTrue(store.Contains(hash));
+        }
+
+        private string WriteSourceFile(string name, int size, Random random)
+        {
+            Directory.CreateDirectory(sources.FullName);
+            byte[] contents = new byte[size];
+            random.NextBytes(contents);
+            string path = Path.Combine(sources.FullName, name);
+            File.WriteAllBytes(path, contents);
+            return path;
+        }
+
+        private long StoredBytes()
+        {
+            long bytes = 0;
+            foreach (string path in Directory.GetFiles(root.FullName, "*", SearchOption.AllDirectories))
+                bytes += new FileInfo(path).Length;
+            return bytes;
+        }
+
+        [Test, Explicit("Benchmark")]
+        public void Benchmark_Dedup_Ratio()
+        {
+            const int posts = 10;
+            const int imagesPerPost = 8;
+            const int autosaves = 30;
+            foreach (double sharedFraction in new double[] { 0, 0.25, 0.5 })
+            {
+                TearDown();
+                Random random = new Random(1);
+
+                // some images (a logo, a signature, a header) are in every post; the rest
+                // are the post's own, and one of those is replaced every few autosaves
+                List<string> shared = new List<string>();
+                int sharedCount = (int)(imagesPerPost * sharedFraction);
+                for (int i = 0; i < sharedCount; i++)
+                    shared.Add(WriteSourceFile("shared" + i + ".png", random.Next(20 * 1024, 300 * 1024), random));
+
+                long embeddedBytes = 0;
+                for (int post = 0; post < posts; post++)
+                {
+                    List<string> images = new List<string>(shared);
+                    for (int i = sharedCount; i < imagesPerPost; i++)
+                        images.Add(WriteSourceFile("post" + post + "-" + i + ".png", random.Next(20 * 1024, 300 * 1024), random));
+
+                    for (int save = 0; save < autosaves; save++)
+                    {
+                        if (save % 5 == 4 && sharedCount < imagesPerPost)
+                        {
+                            int replaced = random.Next(sharedCount, imagesPerPost);
+                            images[replaced] = WriteSourceFile("post" + post + "-" + replaced + "-" + save + ".png", random.Next(20 * 1024, 300 * 1024), random);
+                        }
+                        foreach (string image in images)
+                        {
+                            store.AddFile(image);
+                            embeddedBytes += new FileInfo(image).Length;
+                        }
+                    }
+                }
+
+                long storedBytes = StoredBytes();
+                Console.WriteLine("{0,3:P0} shared: embedded {1,12:N0} bytes, stored {2,11:N0} bytes, {3,6:N1}x less",
+                    sharedFraction, embeddedBytes, storedBytes, (double)embeddedBytes / storedBytes);
+            }
+        }
+
+        [Test, Explicit("Benchmark")]
+        public void Benchmark_Hashing_Throughput()
+        {
+            Random random = new Random(1);
+            foreach (int size in new int[] { 16 * 1024, 256 * 1024, 4 * 1024 * 1024, 32 * 1024 * 1024 })
+            {
+                int files = Math.Max(4, 64 * 1024 * 1024 / size);
+                List<string> paths = new List<string>();
+                for (int i = 0; i < files; i++)
+                    paths.Add(WriteSourceFile(size + "-" + i + ".bin", size, random));
+
+                // first save: hash and store each file
+                Stopwatch stopwatch = Stopwatch.StartNew();
+                foreach (string path in paths)
+                    store.AddFile(path);
+                double storeSeconds = stopwatch.Elapsed.TotalSeconds;
+
+                // a post saved again: the hashes are remembered, so nothing is read
+                stopwatch = Stopwatch.StartNew();
+                foreach (string path in paths)
+                    store.AddFile(path);
+                double cachedSeconds = stopwatch.Elapsed.TotalSeconds;
+
+                // the same contents from another stream: hashed again, found, not written
+                stopwatch = Stopwatch.StartNew();
+                foreach (string path in paths)
+                {
+                    using (FileStream contents = File.OpenRead(path))
+                        store.Add(contents);
+                }
+                double hashSeconds = stopwatch.Elapsed.TotalSeconds;
+
+                double megabytes = (double)size * files / (1024 * 1024);
+                Console.WriteLine("{0,10:N0} bytes x {1,4}: store {2,7:N1} MB/s, hash only {3,7:N1} MB/s, cached {4,8:N3} ms/file",
+                    size, files, megabytes / storeSeconds, megabytes / hashSeconds, cachedSeconds * 1000 / files);
+
+                TearDown();
+            }
+        }
+
+        private class NonSeekableStream : Stream
+        {
+            private readonly Stream inner;
+
+            public NonSeekableStream(Stream inner)
+            {
+                this.inner = inner;
+            }
+
+            public override bool CanRead { get { return true; } }
+            public override bool CanSeek { get { return false; } }
+            public override bool CanWrite { get { return false; } }
+            public override long Length { get { throw new NotSupportedException(); } }
+            public override long Position
+            {
+                get { throw new NotSupportedException(); }
+                set { throw new NotSupportedException(); }
+            }
+
+            public override int Read(byte[] buffer, int offset, int count)
+            {
+                return inner.Read(buffer, offset, count);
+            }
+
+            public override void Flush() { }
+            public override long Seek(long offset, SeekOrigin origin) { throw new NotSupportedException(); }
+            public override void SetLength(long value) { throw new NotSupportedException(); }
+            public override void Write(byte[] buffer, int offset, int count) { throw new NotSupportedException(); }
+        }
+    }
+}
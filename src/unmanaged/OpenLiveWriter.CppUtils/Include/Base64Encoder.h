@@ -0,0 +1,199 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#if defined(_MSC_VER) || defined(__GNUC__)
+#define BASE64_ENCODER_SIMD
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define BASE64_ENCODER_TARGET_SSSE3
+#define BASE64_ENCODER_TARGET_AVX2
+#else
+#define BASE64_ENCODER_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define BASE64_ENCODER_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+#endif
+
+/*
+Encodes bytes as base64 (RFC 4648, with padding and no line breaks), the
+characters written as single bytes so that they can go straight into UTF-8
+or any other ASCII-compatible text.
+
+Every 3 bytes become 4 characters independently of the others, so a long
+input can be encoded a block at a time as long as each block but the last
+is a multiple of 3 bytes long. That is how XML-RPC uploads stream a file into
+the request without holding it, or its encoding, in memory.
+
+The SSSE3 and AVX2 kernels (12 and 24 bytes at a time) are used when the
+processor has them and give exactly the characters the plain C++ one does,
+which is how utilities\Base64EncoderCheck tests them.
+*/
+
+// the instructions used, for comparing them
+enum Base64Kernels
+{
+	BASE64_BEST_KERNELS = 0,
+	BASE64_SCALAR_KERNELS = 1,
+	BASE64_SSSE3_KERNELS = 2,
+	BASE64_AVX2_KERNELS = 3
+} ;
+
+class Base64Encoder
+{
+public:
+	// The characters length bytes encode to.
+	static uint64_t EncodedLength( uint64_t length )
+	{
+		return (length + 2) / 3 * 4 ;
+	}
+
+	/*
+	Encodes length bytes of source into destination, which has room for
+	EncodedLength( length ) characters, and returns how many were written.
+	*/
+	static size_t Encode( const uint8_t* source, size_t length, char* destination, Base64Kernels kernels = BASE64_BEST_KERNELS )
+	{
+		static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/" ;
+
+		const uint8_t* in = source ;
+		const uint8_t* end = source + length ;
+		char* out = destination ;
+
+#ifdef BASE64_ENCODER_SIMD
+		// AVX2 leaves what's too short for it to the SSSE3 kernel
+		Base64Kernels chosen = ChooseKernels( kernels ) ;
+		if ( chosen == BASE64_AVX2_KERNELS )
+			EncodeAvx2( in, end, out ) ;
+		if ( chosen == BASE64_AVX2_KERNELS || chosen == BASE64_SSSE3_KERNELS )
+			EncodeSsse3( in, end, out ) ;
+#else
+		(void)kernels ;
+#endif
+
+		// whole groups of 3
+		for ( ; end - in >= 3 ; in += 3, out += 4 )
+		{
+			uint32_t group = ((uint32_t)in[0] << 16) | ((uint32_t)in[1] << 8) | in[2] ;
+			out[0] = alphabet[group >> 18] ;
+			out[1] = alphabet[(group >> 12) & 63] ;
+			out[2] = alphabet[(group >> 6) & 63] ;
+			out[3] = alphabet[group & 63] ;
+		}
+
+		// and the padded last one
+		if ( in < end )
+		{
+			uint32_t group = (uint32_t)in[0] << 16 ;
+			if ( end - in == 2 )
+				group |= (uint32_t)in[1] << 8 ;
+			out[0] = alphabet[group >> 18] ;
+			out[1] = alphabet[(group >> 12) & 63] ;
+			out[2] = end - in == 2 ? alphabet[(group >> 6) & 63] : '=' ;
+			out[3] = '=' ;
+			out += 4 ;
+		}
+
+		return out - destination ;
+	}
+
+	// What kernels asks for, or the best the processor has if that's less.
+	static Base64Kernels ChooseKernels( Base64Kernels kernels )
+	{
+		Base64Kernels best = BASE64_SCALAR_KERNELS ;
+#ifdef BASE64_ENCODER_SIMD
+		static const Base64Kernels supported = Supported() ;
+		best = supported ;
+#endif
+		if ( kernels == BASE64_BEST_KERNELS || kernels > best )
+			return best ;
+		return kernels ;
+	}
+
+private:
+#ifdef BASE64_ENCODER_SIMD
+	static Base64Kernels Supported()
+	{
+#ifdef _MSC_VER
+		int info[4] ;
+		__cpuid( info, 0 ) ;
+		int maxLeaf = info[0] ;
+		__cpuid( info, 1 ) ;
+		if ( (info[2] & (1 << 9)) == 0 )
+			return BASE64_SCALAR_KERNELS ;
+		bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (_xgetbv( 0 ) & 6) == 6 ;
+		if ( maxLeaf < 7 || !osSavesYmm )
+			return BASE64_SSSE3_KERNELS ;
+		__cpuidex( info, 7, 0 ) ;
+		return (info[1] & (1 << 5)) != 0 ? BASE64_AVX2_KERNELS : BASE64_SSSE3_KERNELS ;
+#else
+		if ( !__builtin_cpu_supports( "ssse3" ) )
+			return BASE64_SCALAR_KERNELS ;
+		return __builtin_cpu_supports( "avx2" ) ? BASE64_AVX2_KERNELS : BASE64_SSSE3_KERNELS ;
+#endif
+	}
+
+	/*
+	Wojciech Mula's method: the 3 bytes of each 32-bit lane are shuffled so
+	that a multiply moves each 6 bits into a byte of its own, and a byte
+	shuffle then looks up what to add to those 0-63 to get the character.
+	*/
+	BASE64_ENCODER_TARGET_SSSE3 static __m128i EncodeLanes( __m128i bytes )
+	{
+		__m128i input = _mm_shuffle_epi8( bytes, _mm_set_epi8( 10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1 ) ) ;
+		__m128i high = _mm_mulhi_epu16( _mm_and_si128( input, _mm_set1_epi32( 0x0FC0FC00 ) ), _mm_set1_epi32( 0x04000040 ) ) ;
+		__m128i low = _mm_mullo_epi16( _mm_and_si128( input, _mm_set1_epi32( 0x003F03F0 ) ), _mm_set1_epi32( 0x01000010 ) ) ;
+		__m128i indices = _mm_or_si128( high, low ) ;
+
+		// 0-25 -> 13, 26-51 -> 0, 52-61 -> 1-10, 62 -> 11, 63 -> 12
+		__m128i ranges = _mm_subs_epu8( indices, _mm_set1_epi8( 51 ) ) ;
+		__m128i upper = _mm_cmpgt_epi8( _mm_set1_epi8( 26 ), indices ) ;
+		ranges = _mm_or_si128( ranges, _mm_and_si128( upper, _mm_set1_epi8( 13 ) ) ) ;
+		__m128i offsets = _mm_setr_epi8( 'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+			'0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0 ) ;
+		return _mm_add_epi8( _mm_shuffle_epi8( offsets, ranges ), indices ) ;
+	}
+
+	// 12 bytes to 16 characters while 16 can be read.
+	BASE64_ENCODER_TARGET_SSSE3 static void EncodeSsse3( const uint8_t*& in, const uint8_t* end, char*& out )
+	{
+		for ( ; end - in >= 16 ; in += 12, out += 16 )
+			_mm_storeu_si128( (__m128i*)out, EncodeLanes( _mm_loadu_si128( (const __m128i*)in ) ) ) ;
+	}
+
+	BASE64_ENCODER_TARGET_AVX2 static __m256i EncodeLanes( __m256i bytes )
+	{
+		__m256i input = _mm256_shuffle_epi8( bytes, _mm256_set_epi8(
+			10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+			10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1 ) ) ;
+		__m256i high = _mm256_mulhi_epu16( _mm256_and_si256( input, _mm256_set1_epi32( 0x0FC0FC00 ) ), _mm256_set1_epi32( 0x04000040 ) ) ;
+		__m256i low = _mm256_mullo_epi16( _mm256_and_si256( input, _mm256_set1_epi32( 0x003F03F0 ) ), _mm256_set1_epi32( 0x01000010 ) ) ;
+		__m256i indices = _mm256_or_si256( high, low ) ;
+
+		__m256i ranges = _mm256_subs_epu8( indices, _mm256_set1_epi8( 51 ) ) ;
+		__m256i upper = _mm256_cmpgt_epi8( _mm256_set1_epi8( 26 ), indices ) ;
+		ranges = _mm256_or_si256( ranges, _mm256_and_si256( upper, _mm256_set1_epi8( 13 ) ) ) ;
+		__m256i offsets = _mm256_setr_epi8(
+			'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+			'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0 ) ;
+		return _mm256_add_epi8( _mm256_shuffle_epi8( offsets, ranges ), indices ) ;
+	}
+
+	// 24 bytes to 32 characters, 12 from each half of the register, while 28 can be read.
+	BASE64_ENCODER_TARGET_AVX2 static void EncodeAvx2( const uint8_t*& in, const uint8_t* end, char*& out )
+	{
+		for ( ; end - in >= 28 ; in += 24, out += 32 )
+		{
+			__m256i bytes = _mm256_inserti128_si256( _mm256_castsi128_si256( _mm_loadu_si128( (const __m128i*)in ) ),
+				_mm_loadu_si128( (const __m128i*)(in + 12) ), 1 ) ;
+			_mm256_storeu_si256( (__m256i*)out, EncodeLanes( bytes ) ) ;
+		}
+	}
+#endif
+} ;
@@ -0,0 +1,383 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+/*
+Reads a compound file (the structured storage format .wpost files are saved
+in, [MS-CFB]) where it lies, normally in a read-only mapping of the file,
+without going through IStorage.
+
+Opening one reads the header, the FAT, the directory and the mini FAT once;
+after that listing a storage and copying a stream only follow sector chains
+through memory. Every sector number, chain and sibling link is checked
+against the size of the file, so a damaged file makes Open or Read return
+false rather than read out of bounds or loop. Only reading is supported, and
+only of version 3 (512 byte sector) and version 4 (4096 byte sector) files.
+
+utilities\PostFileDecoderCheck runs it over damaged files under the address
+sanitizer.
+*/
+
+#ifdef _WIN32
+typedef wchar_t CompoundFileChar ;
+#else
+typedef char16_t CompoundFileChar ;
+#endif
+
+enum CompoundFileEntryType
+{
+	COMPOUND_FILE_UNUSED = 0,
+	COMPOUND_FILE_STORAGE = 1,
+	COMPOUND_FILE_STREAM = 2,
+	COMPOUND_FILE_ROOT = 5
+} ;
+
+// marks a missing sibling or child in the directory
+const uint32_t COMPOUND_FILE_NO_ENTRY = 0xFFFFFFFF ;
+
+// the longest name a directory entry can have, in characters
+const size_t COMPOUND_FILE_MAX_NAME_LENGTH = 31 ;
+
+struct CompoundFileEntry
+{
+	CompoundFileChar name[COMPOUND_FILE_MAX_NAME_LENGTH + 1] ;
+	uint32_t nameLength ;	// in characters, without the terminator
+	uint32_t type ;			// a CompoundFileEntryType
+	uint32_t left ;			// the siblings and first child, or COMPOUND_FILE_NO_ENTRY
+	uint32_t right ;
+	uint32_t child ;
+	uint32_t start ;		// the first sector of a stream, in the mini stream if it's short
+	uint64_t size ;
+} ;
+
+class CompoundFileReader
+{
+public:
+	CompoundFileReader()
+		: m_data( NULL ), m_sectorShift( 0 ), m_sectorCount( 0 ), m_miniStreamCutoff( 0 )
+	{
+	}
+
+	/*
+	Reads the header and the tables of the compound file in the size bytes at
+	data, which must stay there while the reader is used.
+	*/
+	bool Open( const void* data, size_t size )
+	{
+		Close() ;
+
+		const uint8_t* header = static_cast<const uint8_t*>(data) ;
+		static const uint8_t signature[8] = { 0xD0, 0xCF, 0x11, 0xE0, 0xA1, 0xB1, 0x1A, 0xE1 } ;
+		if ( size < HEADER_SIZE || memcmp( header, signature, sizeof(signature) ) != 0 || Read16( header + 0x1C ) != 0xFFFE )
+			return false ;
+
+		uint16_t majorVersion = Read16( header + 0x1A ) ;
+		uint16_t sectorShift = Read16( header + 0x1E ) ;
+		if ( !(majorVersion == 3 && sectorShift == 9) && !(majorVersion == 4 && sectorShift == 12) )
+			return false ;
+		if ( Read16( header + 0x20 ) != MINI_SECTOR_SHIFT || Read32( header + 0x38 ) != MINI_STREAM_CUTOFF )
+			return false ;
+		if ( (size >> sectorShift) == 0 )
+			return false ;
+
+		m_data = header ;
+		m_sectorShift = sectorShift ;
+		m_sectorCount = (uint32_t)(std::min)( (size >> sectorShift) - 1, (size_t)MAX_SECTOR ) ;
+		m_miniStreamCutoff = MINI_STREAM_CUTOFF ;
+
+		if ( !ReadFat( header ) ||
+			 !ReadDirectory( Read32( header + 0x30 ), majorVersion ) ||
+			 !ReadMiniFat( Read32( header + 0x3C ), Read32( header + 0x40 ) ) )
+		{
+			Close() ;
+			return false ;
+		}
+		return true ;
+	}
+
+	void Close()
+	{
+		m_data = NULL ;
+		m_sectorCount = 0 ;
+		m_fat.clear() ;
+		m_miniFat.clear() ;
+		m_miniStreamSectors.clear() ;
+		m_entries.clear() ;
+	}
+
+	bool IsOpen() const
+	{
+		return m_data != NULL ;
+	}
+
+	// Entry 0 is the root storage.
+	uint32_t GetEntryCount() const
+	{
+		return (uint32_t)m_entries.size() ;
+	}
+
+	const CompoundFileEntry& GetEntry( uint32_t id ) const
+	{
+		return m_entries[id] ;
+	}
+
+	/*
+	Lists what is in a storage, in the directory's (name) order, returning
+	false if its tree of siblings is damaged.
+	*/
+	bool GetChildren( uint32_t storage, std::vector<uint32_t>& children ) const
+	{
+		children.clear() ;
+		if ( storage >= m_entries.size() || (m_entries[storage].type != COMPOUND_FILE_STORAGE && m_entries[storage].type != COMPOUND_FILE_ROOT) )
+			return false ;
+
+		// an in-order walk of the red-black tree of siblings, which can't take
+		// more steps than there are entries unless the tree has a cycle in it
+		std::vector<uint32_t> pending ;
+		uint32_t id = m_entries[storage].child ;
+		for ( size_t steps = 0; id != COMPOUND_FILE_NO_ENTRY || !pending.empty(); steps++ )
+		{
+			if ( steps > m_entries.size() * 2 )
+				return false ;
+			if ( id != COMPOUND_FILE_NO_ENTRY )
+			{
+				if ( id >= m_entries.size() || m_entries[id].type == COMPOUND_FILE_UNUSED || m_entries[id].type == COMPOUND_FILE_ROOT )
+					return false ;
+				pending.push_back( id ) ;
+				id = m_entries[id].left ;
+			}
+			else
+			{
+				id = pending.back() ;
+				pending.pop_back() ;
+				children.push_back( id ) ;
+				id = m_entries[id].right ;
+			}
+		}
+		return true ;
+	}
+
+	/*
+	Copies all of a stream's contents (its entry's size) to buffer, returning
+	false if its sectors don't hold that much.
+	*/
+	bool Read( uint32_t id, uint8_t* buffer ) const
+	{
+		if ( id >= m_entries.size() || m_entries[id].type != COMPOUND_FILE_STREAM )
+			return false ;
+
+		const CompoundFileEntry& entry = m_entries[id] ;
+		if ( entry.size < m_miniStreamCutoff )
+			return ReadMiniChain( entry.start, entry.size, buffer ) ;
+		return ReadChain( entry.start, entry.size, buffer ) ;
+	}
+
+private:
+	static const size_t HEADER_SIZE = 512 ;
+	static const size_t ENTRY_SIZE = 128 ;
+	static const uint16_t MINI_SECTOR_SHIFT = 6 ;
+	static const uint32_t MINI_STREAM_CUTOFF = 4096 ;
+	static const uint32_t HEADER_DIFAT_COUNT = 109 ;
+
+	// sector numbers above this mark free sectors, chain ends and so on
+	static const uint32_t MAX_SECTOR = 0xFFFFFFFA ;
+	static const uint32_t END_OF_CHAIN = 0xFFFFFFFE ;
+
+	static uint16_t Read16( const uint8_t* p )
+	{
+		return (uint16_t)(p[0] | (p[1] << 8)) ;
+	}
+
+	static uint32_t Read32( const uint8_t* p )
+	{
+		return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24) ;
+	}
+
+	size_t SectorSize() const
+	{
+		return (size_t)1 << m_sectorShift ;
+	}
+
+	// the sector after the header sector
+	const uint8_t* Sector( uint32_t sector ) const
+	{
+		return m_data + ((size_t)(sector + 1) << m_sectorShift) ;
+	}
+
+	// the FAT is spread over the sectors the header's DIFAT and the DIFAT sectors list
+	bool ReadFat( const uint8_t* header )
+	{
+		uint32_t fatSectorCount = Read32( header + 0x2C ) ;
+		uint32_t difatSector = Read32( header + 0x44 ) ;
+		uint32_t difatSectorCount = Read32( header + 0x48 ) ;
+		if ( fatSectorCount > m_sectorCount || difatSectorCount > m_sectorCount )
+			return false ;
+
+		size_t perSector = SectorSize() / 4 ;
+		m_fat.reserve( fatSectorCount * perSector ) ;
+		for ( uint32_t i = 0; i < fatSectorCount && i < HEADER_DIFAT_COUNT; i++ )
+		{
+			if ( !AppendFatSector( Read32( header + 0x4C + i * 4 ) ) )
+				return false ;
+		}
+
+		uint32_t listed = (std::min)( fatSectorCount, (uint32_t)HEADER_DIFAT_COUNT ) ;
+		for ( uint32_t i = 0; i < difatSectorCount && listed < fatSectorCount; i++ )
+		{
+			if ( difatSector >= m_sectorCount )
+				return false ;
+			const uint8_t* difat = Sector( difatSector ) ;
+			for ( size_t j = 0; j < perSector - 1 && listed < fatSectorCount; j++, listed++ )
+			{
+				if ( !AppendFatSector( Read32( difat + j * 4 ) ) )
+					return false ;
+			}
+			difatSector = Read32( difat + (perSector - 1) * 4 ) ;
+		}
+		return listed == fatSectorCount ;
+	}
+
+	bool AppendFatSector( uint32_t sector )
+	{
+		if ( sector >= m_sectorCount )
+			return false ;
+		const uint8_t* fat = Sector( sector ) ;
+		for ( size_t i = 0; i < SectorSize() / 4; i++ )
+			m_fat.push_back( Read32( fat + i * 4 ) ) ;
+		return true ;
+	}
+
+	// Lists a chain of sectors, which can't be longer than the file.
+	bool GetChain( const std::vector<uint32_t>& fat, uint32_t start, size_t limit, std::vector<uint32_t>& chain ) const
+	{
+		chain.clear() ;
+		for ( uint32_t sector = start; sector != END_OF_CHAIN; sector = fat[sector] )
+		{
+			if ( sector >= fat.size() || sector >= limit || chain.size() >= limit )
+				return false ;
+			chain.push_back( sector ) ;
+		}
+		return true ;
+	}
+
+	bool ReadDirectory( uint32_t start, uint16_t majorVersion )
+	{
+		std::vector<uint32_t> chain ;
+		if ( !GetChain( m_fat, start, m_sectorCount, chain ) || chain.empty() )
+			return false ;
+
+		size_t perSector = SectorSize() / ENTRY_SIZE ;
+		m_entries.resize( chain.size() * perSector ) ;
+		for ( size_t i = 0; i < m_entries.size(); i++ )
+		{
+			const uint8_t* raw = Sector( chain[i / perSector] ) + (i % perSector) * ENTRY_SIZE ;
+			CompoundFileEntry& entry = m_entries[i] ;
+
+			uint16_t nameBytes = Read16( raw + 0x40 ) ;
+			entry.type = raw[0x42] ;
+			if ( nameBytes < 2 || nameBytes > (COMPOUND_FILE_MAX_NAME_LENGTH + 1) * 2 || (nameBytes & 1) != 0 )
+			{
+				if ( entry.type != COMPOUND_FILE_UNUSED )
+					return false ;
+				nameBytes = 2 ;
+			}
+			entry.nameLength = nameBytes / 2 - 1 ;
+			for ( uint32_t j = 0; j < entry.nameLength; j++ )
+				entry.name[j] = (CompoundFileChar)Read16( raw + j * 2 ) ;
+			entry.name[entry.nameLength] = 0 ;
+
+			entry.left = Read32( raw + 0x44 ) ;
+			entry.right = Read32( raw + 0x48 ) ;
+			entry.child = Read32( raw + 0x4C ) ;
+			entry.start = Read32( raw + 0x74 ) ;
+			entry.size = Read32( raw + 0x78 ) ;
+			// version 3 files can have garbage in the high half of the size
+			if ( majorVersion == 4 )
+				entry.size |= (uint64_t)Read32( raw + 0x7C ) << 32 ;
+			if ( entry.type != COMPOUND_FILE_STREAM && entry.type != COMPOUND_FILE_ROOT )
+				entry.size = 0 ;
+		}
+
+		if ( m_entries[0].type != COMPOUND_FILE_ROOT )
+			return false ;
+
+		// the root's stream is the mini stream the short streams are kept in
+		if ( m_entries[0].size == 0 )
+			return true ;
+		if ( !GetChain( m_fat, m_entries[0].start, m_sectorCount, m_miniStreamSectors ) )
+			return false ;
+		return ((uint64_t)m_miniStreamSectors.size() << m_sectorShift) >= m_entries[0].size ;
+	}
+
+	bool ReadMiniFat( uint32_t start, uint32_t sectorCount )
+	{
+		if ( sectorCount == 0 )
+			return true ;
+
+		std::vector<uint32_t> chain ;
+		if ( !GetChain( m_fat, start, m_sectorCount, chain ) || chain.size() < sectorCount )
+			return false ;
+
+		size_t perSector = SectorSize() / 4 ;
+		m_miniFat.reserve( sectorCount * perSector ) ;
+		for ( uint32_t i = 0; i < sectorCount; i++ )
+		{
+			const uint8_t* miniFat = Sector( chain[i] ) ;
+			for ( size_t j = 0; j < perSector; j++ )
+				m_miniFat.push_back( Read32( miniFat + j * 4 ) ) ;
+		}
+		return true ;
+	}
+
+	bool ReadChain( uint32_t sector, uint64_t size, uint8_t* buffer ) const
+	{
+		size_t sectorSize = SectorSize() ;
+		for ( uint32_t steps = 0; size > 0; steps++ )
+		{
+			if ( sector >= m_sectorCount || sector >= m_fat.size() || steps >= m_sectorCount )
+				return false ;
+			size_t count = (size_t)(std::min)( (uint64_t)sectorSize, size ) ;
+			memcpy( buffer, Sector( sector ), count ) ;
+			buffer += count ;
+			size -= count ;
+			sector = m_fat[sector] ;
+		}
+		return true ;
+	}
+
+	// A mini sector never straddles two sectors of the mini stream.
+	bool ReadMiniChain( uint32_t miniSector, uint64_t size, uint8_t* buffer ) const
+	{
+		const size_t miniSectorSize = (size_t)1 << MINI_SECTOR_SHIFT ;
+		uint64_t miniSectorCount = (std::min)( (uint64_t)m_miniFat.size(), m_entries[0].size >> MINI_SECTOR_SHIFT ) ;
+		for ( uint32_t steps = 0; size > 0; steps++ )
+		{
+			if ( miniSector >= miniSectorCount || steps >= miniSectorCount )
+				return false ;
+			size_t offset = (size_t)miniSector << MINI_SECTOR_SHIFT ;
+			const uint8_t* data = Sector( m_miniStreamSectors[offset >> m_sectorShift] ) + (offset & (SectorSize() - 1)) ;
+			size_t count = (size_t)(std::min)( (uint64_t)miniSectorSize, size ) ;
+			memcpy( buffer, data, count ) ;
+			buffer += count ;
+			size -= count ;
+			miniSector = m_miniFat[miniSector] ;
+		}
+		return true ;
+	}
+
+	const uint8_t* m_data ;
+	uint16_t m_sectorShift ;
+	uint32_t m_sectorCount ;		// how many whole sectors follow the header
+	uint32_t m_miniStreamCutoff ;
+	std::vector<uint32_t> m_fat ;
+	std::vector<uint32_t> m_miniFat ;
+	std::vector<uint32_t> m_miniStreamSectors ;
+	std::vector<CompoundFileEntry> m_entries ;
+} ;
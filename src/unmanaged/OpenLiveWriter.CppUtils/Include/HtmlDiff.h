@@ -0,0 +1,1016 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define HTML_DIFF_SSE2
+#include <emmintrin.h>
+#endif
+
+/*
+Compares two versions of a post's HTML, as the recent post synchronizer does
+with the copy it has and the one on the server, and finds the smallest set of
+changes that turns one into the other.
+
+The HTML is split into words, runs of white space and markup (a tag, comment
+or directive, whole), each of which is hashed; the sequences of hashes are
+then compared with Myers' O(ND) algorithm, which finds a shortest edit script.
+When the versions differ by few tokens, as they usually do, it keeps the
+furthest reaching paths of every step and walks back along them. When they
+differ by more than that is worth keeping, the tokens that each version has
+just once are lined up first, as patience diff does, and what lies between
+them compared the same way; that can make the script a little longer than
+the shortest, but large insertions and moves cost little. What has no such
+tokens is compared with the classic dynamic program if one side is short,
+and otherwise split at the middle snake, Myers' linear space refinement. Tokens
+the versions start or end with in common are skipped before any of this, and
+callers can give up on versions that are too different to be worth
+comparing.
+
+With HTML_DIFF_IGNORE_FORMATTING, differences that don't change the post are
+ignored: how much white space there is (but not whether there is any, since
+"foo <b>bar</b>" and "foo<b>bar</b>" read differently), white space at either
+end, the case of tag and attribute names, how attribute values are quoted,
+white space inside tags and the slash of empty elements. Servers often change
+those when they store a post. White space in preformatted elements (pre,
+textarea, listing, xmp and anything styled white-space: pre and the like) is
+shown as it is, so it is compared as it is.
+
+Tokens are hashed eight characters at a time, with SSE2 where the processor
+has it and the same arithmetic in plain C++ where it doesn't, so that hashes
+and signatures don't depend on the processor. A signature is the hash of the
+sequence of token hashes; two versions with the same signature are taken to
+be the same without comparing them.
+
+HtmlDiffChar is wchar_t on Windows and char16_t elsewhere, so that
+utilities\HtmlDiffCheck diffs the same UTF-16 the post editor passes in.
+*/
+
+#ifdef _WIN32
+typedef wchar_t HtmlDiffChar ;
+#else
+typedef char16_t HtmlDiffChar ;
+#endif
+
+// ignore differences that don't change how the post reads (see above)
+const int HTML_DIFF_IGNORE_FORMATTING = 1 ;
+
+enum HtmlDiffTokenKind
+{
+	HTML_DIFF_WORD = 0,
+	HTML_DIFF_SPACE = 1,
+	HTML_DIFF_MARKUP = 2
+} ;
+
+struct HtmlDiffToken
+{
+	int start ;
+	int length ;
+	int kind ;
+	uint64_t hash ;
+} ;
+
+// count tokens at start of the old sequence replaced by those at start of the new
+struct HtmlDiffEdit
+{
+	int oldStart ;
+	int oldCount ;
+	int newStart ;
+	int newCount ;
+} ;
+
+// the characters of the old HTML at oldStart replaced by those of the new at newStart
+struct HtmlDiffHunk
+{
+	int oldStart ;
+	int oldLength ;
+	int newStart ;
+	int newLength ;
+} ;
+
+class HtmlDiff
+{
+public:
+	/*
+	Splits html into tokens, hashed as flags says. With
+	HTML_DIFF_IGNORE_FORMATTING, every run of white space outside preformatted
+	elements hashes the same, and white space at either end is left out.
+	*/
+	static void Tokenize( const HtmlDiffChar* html, int length, int flags, std::vector<HtmlDiffToken>& tokens )
+	{
+		tokens.clear() ;
+		std::vector<HtmlDiffChar> scratch ;
+		std::vector<HtmlDiffChar> preformattedName ;
+		int preformattedDepth = 0 ;
+		int pos = 0 ;
+		while ( pos < length )
+		{
+			HtmlDiffToken token ;
+			token.start = pos ;
+			int markupEnd ;
+			if ( html[pos] == '<' && (markupEnd = MarkupEnd( html, pos, length )) > pos )
+			{
+				token.kind = HTML_DIFF_MARKUP ;
+				pos = markupEnd ;
+			}
+			else if ( IsSpace( html[pos] ) )
+			{
+				token.kind = HTML_DIFF_SPACE ;
+				while ( pos < length && IsSpace( html[pos] ) )
+					pos++ ;
+			}
+			else
+			{
+				// a '<' that doesn't start markup is part of a word
+				token.kind = HTML_DIFF_WORD ;
+				pos++ ;
+				while ( pos < length && !IsSpace( html[pos] ) && html[pos] != '<' )
+					pos++ ;
+			}
+			token.length = pos - token.start ;
+
+			if ( (flags & HTML_DIFF_IGNORE_FORMATTING) != 0 && token.kind == HTML_DIFF_SPACE && preformattedDepth == 0 )
+			{
+				const HtmlDiffChar space = ' ' ;
+				token.hash = Hash( &space, 1 ) ;
+			}
+			else if ( (flags & HTML_DIFF_IGNORE_FORMATTING) != 0 && token.kind == HTML_DIFF_MARKUP )
+			{
+				NormalizeMarkup( html + token.start, token.length, scratch ) ;
+				token.hash = Hash( &scratch[0], scratch.size() ) ;
+				TrackPreformatted( html + token.start, token.length, preformattedName, &preformattedDepth ) ;
+			}
+			else
+			{
+				token.hash = Hash( html + token.start, token.length ) ;
+			}
+			tokens.push_back( token ) ;
+		}
+
+		if ( (flags & HTML_DIFF_IGNORE_FORMATTING) != 0 )
+		{
+			if ( !tokens.empty() && tokens.back().kind == HTML_DIFF_SPACE )
+				tokens.pop_back() ;
+			if ( !tokens.empty() && tokens.front().kind == HTML_DIFF_SPACE )
+				tokens.erase( tokens.begin() ) ;
+		}
+	}
+
+	/*
+	The signature of html: the same for versions that Diff, with the same
+	flags, finds no differences between.
+	*/
+	static uint64_t Signature( const HtmlDiffChar* html, int length, int flags )
+	{
+		std::vector<HtmlDiffToken> tokens ;
+		Tokenize( html, length, flags, tokens ) ;
+		uint64_t signature = PRIME64_1 ;
+		for ( size_t i = 0; i < tokens.size(); i++ )
+			signature = Rotate( (signature ^ tokens[i].hash) * PRIME64_2, 31 ) ;
+		return Avalanche( signature ^ tokens.size() ) ;
+	}
+
+	/*
+	Finds the changes that turn oldHtml into newHtml, as spans of characters,
+	in order. Returns false, leaving hunks empty, if more than maxDifferences
+	tokens would have to be deleted or inserted.
+	*/
+	static bool Diff( const HtmlDiffChar* oldHtml, int oldLength, const HtmlDiffChar* newHtml, int newLength,
+		int flags, int maxDifferences, std::vector<HtmlDiffHunk>& hunks )
+	{
+		hunks.clear() ;
+		std::vector<HtmlDiffToken> oldTokens ;
+		std::vector<HtmlDiffToken> newTokens ;
+		Tokenize( oldHtml, oldLength, flags, oldTokens ) ;
+		Tokenize( newHtml, newLength, flags, newTokens ) ;
+
+		std::vector<uint64_t> oldHashes( oldTokens.size() ) ;
+		std::vector<uint64_t> newHashes( newTokens.size() ) ;
+		for ( size_t i = 0; i < oldTokens.size(); i++ )
+			oldHashes[i] = oldTokens[i].hash ;
+		for ( size_t i = 0; i < newTokens.size(); i++ )
+			newHashes[i] = newTokens[i].hash ;
+
+		std::vector<HtmlDiffEdit> edits ;
+		if ( !DiffSequences( oldHashes.empty() ? NULL : &oldHashes[0], (int)oldHashes.size(),
+				newHashes.empty() ? NULL : &newHashes[0], (int)newHashes.size(), maxDifferences, edits ) )
+			return false ;
+
+		hunks.resize( edits.size() ) ;
+		for ( size_t i = 0; i < edits.size(); i++ )
+		{
+			ToCharacters( oldTokens, oldLength, edits[i].oldStart, edits[i].oldCount, &hunks[i].oldStart, &hunks[i].oldLength ) ;
+			ToCharacters( newTokens, newLength, edits[i].newStart, edits[i].newCount, &hunks[i].newStart, &hunks[i].newLength ) ;
+		}
+		return true ;
+	}
+
+	/*
+	Finds an edit script from a[0, n) to b[0, m), as runs of tokens replaced,
+	in order; the shortest one unless they differ by more than
+	GREEDY_MAX_DIFFERENCES tokens (see above). Returns false if it's longer
+	than maxDifferences deletions and insertions.
+	*/
+	static bool DiffSequences( const uint64_t* a, int n, const uint64_t* b, int m, int maxDifferences, std::vector<HtmlDiffEdit>& edits )
+	{
+		edits.clear() ;
+		std::vector<int> forward ;
+		std::vector<int> backward ;
+		int budget = maxDifferences ;
+		if ( !Compare( a, n, b, m, 0, 0, 0, &budget, forward, backward, edits ) )
+		{
+			edits.clear() ;
+			return false ;
+		}
+		return true ;
+	}
+
+	// Hashes length characters of text.
+	static uint64_t Hash( const HtmlDiffChar* text, size_t length )
+	{
+		const uint8_t* bytes = reinterpret_cast<const uint8_t*>(text) ;
+		size_t blocks = length / BLOCK_CHARACTERS ;
+		uint64_t acc0 = SECRET0 ;
+		uint64_t acc1 = SECRET1 ;
+#ifdef HTML_DIFF_SSE2
+		if ( blocks > 0 )
+		{
+			HashBlocksSse2( bytes, blocks, &acc0, &acc1 ) ;
+			bytes += blocks * 16 ;
+			blocks = 0 ;
+		}
+#endif
+		HashBlocks( bytes, blocks, &acc0, &acc1 ) ;
+		return Finish( acc0, acc1, text + length / BLOCK_CHARACTERS * BLOCK_CHARACTERS, length % BLOCK_CHARACTERS, length ) ;
+	}
+
+	// Hash without SSE2, for checking that they agree.
+	static uint64_t HashScalar( const HtmlDiffChar* text, size_t length )
+	{
+		uint64_t acc0 = SECRET0 ;
+		uint64_t acc1 = SECRET1 ;
+		HashBlocks( reinterpret_cast<const uint8_t*>(text), length / BLOCK_CHARACTERS, &acc0, &acc1 ) ;
+		return Finish( acc0, acc1, text + length / BLOCK_CHARACTERS * BLOCK_CHARACTERS, length % BLOCK_CHARACTERS, length ) ;
+	}
+
+	// \s as SimpleHtmlParser has it, less the rarer Unicode spaces
+	static bool IsSpace( HtmlDiffChar c )
+	{
+		return c == ' ' || (c >= 0x09 && c <= 0x0D) || c == 0xA0 || c == 0x3000 ;
+	}
+
+private:
+	// the most differences Greedy keeps the paths of, about 4 MB of them
+	static const int GREEDY_MAX_DIFFERENCES = 1024 ;
+
+	// Split hands problems smaller than this to Greedy
+	static const int SPLIT_MIN_TOKENS = 256 ;
+
+	// the largest dynamic programming table Compare fills in, 4 MB of it
+	static const int64_t TABLE_MAX_CELLS = 2 * 1024 * 1024 ;
+
+	// how many times Compare lines up tokens between tokens it has lined up
+	static const int MAX_ANCHOR_DEPTH = 16 ;
+
+	static const size_t BLOCK_CHARACTERS = 16 / sizeof(HtmlDiffChar) ;
+
+	static const uint64_t SECRET0 = 0xBE4BA423396CFEB8ULL ;
+	static const uint64_t SECRET1 = 0x1CAD21F72C81017CULL ;
+	static const uint32_t PRIME32 = 0x9E3779B1U ;
+	static const uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL ;
+	static const uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL ;
+
+	struct Anchor
+	{
+		int a ;
+		int b ;
+	} ;
+
+	struct Occurrence
+	{
+		int aCount ;
+		int bCount ;
+		int b ;
+	} ;
+
+	struct Snake
+	{
+		int x ;
+		int y ;
+		int u ;
+		int v ;
+	} ;
+
+	static uint64_t Rotate( uint64_t value, int bits )
+	{
+		return (value << bits) | (value >> (64 - bits)) ;
+	}
+
+	static uint64_t Avalanche( uint64_t h )
+	{
+		h ^= h >> 33 ;
+		h *= 0xFF51AFD7ED558CCDULL ;
+		h ^= h >> 33 ;
+		h *= 0xC4CEB9FE1A85EC53ULL ;
+		h ^= h >> 33 ;
+		return h ;
+	}
+
+	/*
+	Each 16 byte block, as two 64-bit lanes d0 and d1, is mixed into two
+	accumulators the way XXH3 mixes its stripes: each lane, XORed with a
+	secret, has its 32-bit halves multiplied, and the other lane is added.
+	Then each accumulator is scrambled, so that the order of blocks counts.
+	These are the operations SSE2 has for 64-bit lanes (_mm_mul_epu32).
+	*/
+	static void HashBlocks( const uint8_t* bytes, size_t blocks, uint64_t* acc0, uint64_t* acc1 )
+	{
+		uint64_t a0 = *acc0 ;
+		uint64_t a1 = *acc1 ;
+		for ( size_t i = 0; i < blocks; i++, bytes += 16 )
+		{
+			uint64_t d0, d1 ;
+			memcpy( &d0, bytes, 8 ) ;
+			memcpy( &d1, bytes + 8, 8 ) ;
+			uint64_t k0 = d0 ^ SECRET0 ;
+			uint64_t k1 = d1 ^ SECRET1 ;
+			a0 += (k0 & 0xFFFFFFFF) * (k0 >> 32) + d1 ;
+			a1 += (k1 & 0xFFFFFFFF) * (k1 >> 32) + d0 ;
+			a0 = ((a0 ^ (a0 >> 47)) ^ SECRET1) * PRIME32 ;
+			a1 = ((a1 ^ (a1 >> 47)) ^ SECRET0) * PRIME32 ;
+		}
+		*acc0 = a0 ;
+		*acc1 = a1 ;
+	}
+
+#ifdef HTML_DIFF_SSE2
+	static void HashBlocksSse2( const uint8_t* bytes, size_t blocks, uint64_t* acc0, uint64_t* acc1 )
+	{
+		const __m128i secret = _mm_set_epi64x( (long long)SECRET1, (long long)SECRET0 ) ;
+		const __m128i scramble = _mm_set_epi64x( (long long)SECRET0, (long long)SECRET1 ) ;
+		const __m128i prime = _mm_set1_epi32( (int)PRIME32 ) ;
+		__m128i acc = _mm_set_epi64x( (long long)*acc1, (long long)*acc0 ) ;
+		for ( size_t i = 0; i < blocks; i++, bytes += 16 )
+		{
+			__m128i data = _mm_loadu_si128( reinterpret_cast<const __m128i*>(bytes) ) ;
+			__m128i key = _mm_xor_si128( data, secret ) ;
+			__m128i product = _mm_mul_epu32( key, _mm_srli_epi64( key, 32 ) ) ;
+			__m128i swapped = _mm_shuffle_epi32( data, _MM_SHUFFLE( 1, 0, 3, 2 ) ) ;
+			acc = _mm_add_epi64( acc, _mm_add_epi64( product, swapped ) ) ;
+
+			// acc * PRIME32 is lo * PRIME32 + (hi * PRIME32 << 32)
+			acc = _mm_xor_si128( _mm_xor_si128( acc, _mm_srli_epi64( acc, 47 ) ), scramble ) ;
+			__m128i low = _mm_mul_epu32( acc, prime ) ;
+			__m128i high = _mm_mul_epu32( _mm_srli_epi64( acc, 32 ), prime ) ;
+			acc = _mm_add_epi64( low, _mm_slli_epi64( high, 32 ) ) ;
+		}
+		uint64_t lanes[2] ;
+		_mm_storeu_si128( reinterpret_cast<__m128i*>(lanes), acc ) ;
+		*acc0 = lanes[0] ;
+		*acc1 = lanes[1] ;
+	}
+#endif
+
+	static uint64_t Finish( uint64_t acc0, uint64_t acc1, const HtmlDiffChar* tail, size_t tailLength, size_t length )
+	{
+		uint64_t h = acc0 ^ Rotate( acc1, 29 ) ^ (length * PRIME64_1) ;
+		for ( size_t i = 0; i < tailLength; i++ )
+			h = (h ^ (uint16_t)tail[i]) * PRIME64_2 ;
+		return Avalanche( h ) ;
+	}
+
+	static HtmlDiffChar Lower( HtmlDiffChar c )
+	{
+		return c >= 'A' && c <= 'Z' ? (HtmlDiffChar)(c + ('a' - 'A')) : c ;
+	}
+
+	static bool IsNameStart( HtmlDiffChar c )
+	{
+		return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ;
+	}
+
+	static bool Matches( const HtmlDiffChar* html, int pos, int length, const char* text )
+	{
+		for ( ; *text != 0; text++, pos++ )
+		{
+			if ( pos >= length || html[pos] != *text )
+				return false ;
+		}
+		return true ;
+	}
+
+	/*
+	The end of the comment, directive or tag that starts at the '<' at pos, or
+	pos if none does (as when there's no closing '>'). A '>' in a quoted
+	attribute value doesn't end a tag.
+	*/
+	static int MarkupEnd( const HtmlDiffChar* html, int pos, int length )
+	{
+		if ( Matches( html, pos, length, "<!--" ) )
+		{
+			for ( int i = pos + 4; i + 3 <= length; i++ )
+			{
+				if ( Matches( html, i, length, "-->" ) )
+					return i + 3 ;
+			}
+			return pos ;
+		}
+
+		int i = pos + 1 ;
+		if ( i < length && (html[i] == '/' || html[i] == '!' || html[i] == '?') )
+			i++ ;
+		if ( i >= length || !IsNameStart( html[i] ) )
+			return pos ;
+
+		HtmlDiffChar quote = 0 ;
+		HtmlDiffChar previous = 0 ;
+		for ( ; i < length; i++ )
+		{
+			HtmlDiffChar c = html[i] ;
+			if ( quote != 0 )
+			{
+				if ( c == quote )
+					quote = 0 ;
+			}
+			else if ( c == '>' )
+			{
+				return i + 1 ;
+			}
+			else if ( (c == '"' || c == '\'') && previous == '=' )
+			{
+				quote = c ;
+			}
+			if ( !IsSpace( c ) )
+				previous = c ;
+		}
+		return pos ;
+	}
+
+	// Matches, ignoring the case of html
+	static bool MatchesIgnoringCase( const HtmlDiffChar* html, int pos, int length, const char* text )
+	{
+		for ( ; *text != 0; text++, pos++ )
+		{
+			if ( pos >= length || Lower( html[pos] ) != *text )
+				return false ;
+		}
+		return true ;
+	}
+
+	static bool SameName( const HtmlDiffChar* name, int length, const std::vector<HtmlDiffChar>& lowerName )
+	{
+		if ( length != (int)lowerName.size() )
+			return false ;
+		for ( int i = 0; i < length; i++ )
+		{
+			if ( Lower( name[i] ) != lowerName[i] )
+				return false ;
+		}
+		return true ;
+	}
+
+	// whether the tag's style has white-space: pre, pre-wrap, pre-line or break-spaces
+	static bool HasPreformattedStyle( const HtmlDiffChar* markup, int length )
+	{
+		for ( int i = 0; i < length; i++ )
+		{
+			if ( !MatchesIgnoringCase( markup, i, length, "white-space" ) )
+				continue ;
+			int j = i + 11 ;
+			while ( j < length && IsSpace( markup[j] ) )
+				j++ ;
+			if ( j >= length || markup[j] != ':' )
+				continue ;
+			j++ ;
+			while ( j < length && IsSpace( markup[j] ) )
+				j++ ;
+			if ( MatchesIgnoringCase( markup, j, length, "pre" ) || MatchesIgnoringCase( markup, j, length, "break-spaces" ) )
+				return true ;
+		}
+		return false ;
+	}
+
+	/*
+	Follows the preformatted element a tag opens or closes: name is the
+	outermost one open, in lowercase, and depth how many elements of that name
+	are open, counting it, or 0 outside any.
+	*/
+	static void TrackPreformatted( const HtmlDiffChar* markup, int length, std::vector<HtmlDiffChar>& name, int* depth )
+	{
+		static const char* const PREFORMATTED[] = { "pre", "textarea", "listing", "xmp", "plaintext" } ;
+
+		if ( markup[1] == '!' || markup[1] == '?' )
+			return ;
+		bool closing = markup[1] == '/' ;
+		bool selfClosing = markup[length - 2] == '/' ;
+		int nameStart = closing ? 2 : 1 ;
+		int nameEnd = nameStart ;
+		while ( nameEnd < length - 1 && !IsSpace( markup[nameEnd] ) && markup[nameEnd] != '/' )
+			nameEnd++ ;
+
+		if ( *depth > 0 )
+		{
+			if ( SameName( markup + nameStart, nameEnd - nameStart, name ) )
+			{
+				if ( closing )
+					(*depth)-- ;
+				else if ( !selfClosing )
+					(*depth)++ ;
+			}
+			return ;
+		}
+		if ( closing || selfClosing )
+			return ;
+
+		bool preformatted = HasPreformattedStyle( markup, length ) ;
+		for ( size_t i = 0; !preformatted && i < sizeof(PREFORMATTED) / sizeof(PREFORMATTED[0]); i++ )
+			preformatted = nameEnd - nameStart == (int)strlen( PREFORMATTED[i] ) && MatchesIgnoringCase( markup, nameStart, nameEnd, PREFORMATTED[i] ) ;
+		if ( preformatted )
+		{
+			name.clear() ;
+			for ( int i = nameStart; i < nameEnd; i++ )
+				name.push_back( Lower( markup[i] ) ) ;
+			*depth = 1 ;
+		}
+	}
+
+	/*
+	Writes a tag as <name attribute="value" ...> or </name>, names in
+	lowercase and values in double quotes whatever they were in; comments and
+	directives are left as they are.
+	*/
+	static void NormalizeMarkup( const HtmlDiffChar* markup, int length, std::vector<HtmlDiffChar>& normalized )
+	{
+		normalized.clear() ;
+		int i = 1 ;
+		if ( markup[i] == '!' || markup[i] == '?' )
+		{
+			normalized.assign( markup, markup + length ) ;
+			return ;
+		}
+
+		// up to the '>'
+		int end = length - 1 ;
+		normalized.push_back( '<' ) ;
+		if ( markup[i] == '/' )
+			normalized.push_back( markup[i++] ) ;
+		for ( ; i < end && !IsSpace( markup[i] ) && markup[i] != '/'; i++ )
+			normalized.push_back( Lower( markup[i] ) ) ;
+
+		while ( i < end )
+		{
+			if ( IsSpace( markup[i] ) || markup[i] == '/' )
+			{
+				i++ ;
+				continue ;
+			}
+
+			normalized.push_back( ' ' ) ;
+			for ( ; i < end && !IsSpace( markup[i] ) && markup[i] != '=' && markup[i] != '/'; i++ )
+				normalized.push_back( Lower( markup[i] ) ) ;
+			while ( i < end && IsSpace( markup[i] ) )
+				i++ ;
+			if ( i < end && markup[i] == '=' )
+			{
+				normalized.push_back( '=' ) ;
+				normalized.push_back( '"' ) ;
+				i++ ;
+				while ( i < end && IsSpace( markup[i] ) )
+					i++ ;
+				if ( i < end && (markup[i] == '"' || markup[i] == '\'') )
+				{
+					HtmlDiffChar quote = markup[i++] ;
+					for ( ; i < end && markup[i] != quote; i++ )
+						normalized.push_back( markup[i] ) ;
+					i++ ;
+				}
+				else
+				{
+					for ( ; i < end && !IsSpace( markup[i] ); i++ )
+						normalized.push_back( markup[i] ) ;
+				}
+				normalized.push_back( '"' ) ;
+			}
+		}
+		normalized.push_back( '>' ) ;
+	}
+
+	// The characters count tokens from token first cover.
+	static void ToCharacters( const std::vector<HtmlDiffToken>& tokens, int length, int first, int count, int* start, int* characters )
+	{
+		*start = first < (int)tokens.size() ? tokens[first].start : length ;
+		if ( count == 0 )
+		{
+			*characters = 0 ;
+			return ;
+		}
+		const HtmlDiffToken& last = tokens[first + count - 1] ;
+		*characters = last.start + last.length - *start ;
+	}
+
+	static void AddEdit( std::vector<HtmlDiffEdit>& edits, int oldStart, int oldCount, int newStart, int newCount )
+	{
+		if ( oldCount == 0 && newCount == 0 )
+			return ;
+
+		// runs of deletions and insertions that touch make one edit
+		if ( !edits.empty() )
+		{
+			HtmlDiffEdit& last = edits.back() ;
+			if ( last.oldStart + last.oldCount == oldStart && last.newStart + last.newCount == newStart )
+			{
+				last.oldCount += oldCount ;
+				last.newCount += newCount ;
+				return ;
+			}
+		}
+		HtmlDiffEdit edit = { oldStart, oldCount, newStart, newCount } ;
+		edits.push_back( edit ) ;
+	}
+
+	/*
+	Appends the edits from a[0, n) to b[0, m), offset by aOffset and bOffset,
+	taking the number of differences out of *budget. Returns false if there
+	are more than that.
+	*/
+	static bool Compare( const uint64_t* a, int n, const uint64_t* b, int m, int aOffset, int bOffset, int depth,
+		int* budget, std::vector<int>& forward, std::vector<int>& backward, std::vector<HtmlDiffEdit>& edits )
+	{
+		while ( n > 0 && m > 0 && a[0] == b[0] )
+		{
+			a++, b++, n--, m-- ;
+			aOffset++, bOffset++ ;
+		}
+		while ( n > 0 && m > 0 && a[n - 1] == b[m - 1] )
+			n--, m-- ;
+		if ( abs( n - m ) > *budget )
+			return false ;
+
+		// few differences: follow them forwards, keeping the paths
+		int differences = Greedy( a, n, b, m, aOffset, bOffset, (std::min)( *budget, (int)GREEDY_MAX_DIFFERENCES ), edits ) ;
+		if ( differences >= 0 )
+		{
+			*budget -= differences ;
+			return true ;
+		}
+		if ( *budget <= GREEDY_MAX_DIFFERENCES )
+			return false ;
+
+		// many, but one side is short, as when a lot was inserted
+		if ( (int64_t)n * m <= TABLE_MAX_CELLS )
+		{
+			std::vector<HtmlDiffEdit> tableEdits ;
+			differences = Table( a, n, b, m, aOffset, bOffset, tableEdits ) ;
+			if ( differences > *budget )
+				return false ;
+			for ( size_t i = 0; i < tableEdits.size(); i++ )
+				AddEdit( edits, tableEdits[i].oldStart, tableEdits[i].oldCount, tableEdits[i].newStart, tableEdits[i].newCount ) ;
+			*budget -= differences ;
+			return true ;
+		}
+
+		// many: line up the tokens that each has once, as patience diff does, and
+		// compare what's between them
+		std::vector<Anchor> anchors ;
+		if ( depth < MAX_ANCHOR_DEPTH )
+			FindAnchors( a, n, b, m, anchors ) ;
+		if ( !anchors.empty() )
+		{
+			int aPos = 0 ;
+			int bPos = 0 ;
+			for ( size_t i = 0; i <= anchors.size(); i++ )
+			{
+				int aEnd = i < anchors.size() ? anchors[i].a : n ;
+				int bEnd = i < anchors.size() ? anchors[i].b : m ;
+				if ( !Compare( a + aPos, aEnd - aPos, b + bPos, bEnd - bPos, aOffset + aPos, bOffset + bPos, depth + 1, budget, forward, backward, edits ) )
+					return false ;
+				aPos = aEnd + 1 ;
+				bPos = bEnd + 1 ;
+			}
+			return true ;
+		}
+
+		// none: split at the middle snake, which bounds the whole script
+		if ( forward.size() < (size_t)(2 * (n + m) + 4) )
+		{
+			forward.resize( 2 * (n + m) + 4 ) ;
+			backward.resize( forward.size() ) ;
+		}
+		Snake snake ;
+		differences = MiddleSnake( a, n, b, m, *budget, &forward[0], &backward[0], &snake ) ;
+		if ( differences < 0 )
+			return false ;
+		Split( a, n, b, m, aOffset, bOffset, differences, snake, &forward[0], &backward[0], edits ) ;
+		*budget -= differences ;
+		return true ;
+	}
+
+	/*
+	The longest run of tokens that a[0, n) and b[0, m) each have once, in the
+	same order in both.
+	*/
+	static void FindAnchors( const uint64_t* a, int n, const uint64_t* b, int m, std::vector<Anchor>& anchors )
+	{
+		std::unordered_map<uint64_t, Occurrence> occurrences( n + m ) ;
+		for ( int i = 0; i < n; i++ )
+		{
+			Occurrence& occurrence = occurrences[a[i]] ;
+			occurrence.aCount++ ;
+		}
+		for ( int i = 0; i < m; i++ )
+		{
+			std::unordered_map<uint64_t, Occurrence>::iterator found = occurrences.find( b[i] ) ;
+			if ( found != occurrences.end() )
+			{
+				found->second.bCount++ ;
+				found->second.b = i ;
+			}
+		}
+
+		std::vector<Anchor> candidates ;
+		for ( int i = 0; i < n; i++ )
+		{
+			const Occurrence& occurrence = occurrences[a[i]] ;
+			if ( occurrence.aCount == 1 && occurrence.bCount == 1 )
+			{
+				Anchor candidate = { i, occurrence.b } ;
+				candidates.push_back( candidate ) ;
+			}
+		}
+
+		// the longest increasing subsequence of their places in b, by patience sorting
+		std::vector<int> tails ;
+		std::vector<int> previous( candidates.size() ) ;
+		for ( int i = 0; i < (int)candidates.size(); i++ )
+		{
+			int low = 0 ;
+			int high = (int)tails.size() ;
+			while ( low < high )
+			{
+				int middle = (low + high) / 2 ;
+				if ( candidates[tails[middle]].b < candidates[i].b )
+					low = middle + 1 ;
+				else
+					high = middle ;
+			}
+			previous[i] = low > 0 ? tails[low - 1] : -1 ;
+			if ( low == (int)tails.size() )
+				tails.push_back( i ) ;
+			else
+				tails[low] = i ;
+		}
+
+		anchors.resize( tails.size() ) ;
+		int candidate = tails.empty() ? -1 : tails.back() ;
+		for ( size_t i = anchors.size(); i-- > 0; candidate = previous[candidate] )
+			anchors[i] = candidates[candidate] ;
+	}
+
+	/*
+	The dynamic program for the longest common subsequence, which costs n * m
+	whatever the differences are, for when one of the sequences is short and
+	they differ by too much for Myers. Appends the edits to edits and returns
+	the number of differences.
+	*/
+	static int Table( const uint64_t* a, int n, const uint64_t* b, int m, int aOffset, int bOffset, std::vector<HtmlDiffEdit>& edits )
+	{
+		// common[i * (m + 1) + j] is the length of that of a[i, n) and b[j, m),
+		// which is less than 65536 as n * m is at most TABLE_MAX_CELLS
+		size_t row = m + 1 ;
+		std::vector<uint16_t> common( (size_t)(n + 1) * row ) ;
+		for ( int i = n - 1; i >= 0; i-- )
+		{
+			for ( int j = m - 1; j >= 0; j-- )
+			{
+				common[i * row + j] = a[i] == b[j] ? (uint16_t)(common[(i + 1) * row + j + 1] + 1) :
+					(std::max)( common[(i + 1) * row + j], common[i * row + j + 1] ) ;
+			}
+		}
+
+		int i = 0 ;
+		int j = 0 ;
+		while ( i < n && j < m )
+		{
+			if ( a[i] == b[j] )
+			{
+				i++ ;
+				j++ ;
+			}
+			else if ( common[(i + 1) * row + j] >= common[i * row + j + 1] )
+			{
+				AddEdit( edits, aOffset + i, 1, bOffset + j, 0 ) ;
+				i++ ;
+			}
+			else
+			{
+				AddEdit( edits, aOffset + i, 0, bOffset + j, 1 ) ;
+				j++ ;
+			}
+		}
+		AddEdit( edits, aOffset + i, n - i, bOffset + j, m - j ) ;
+		return n + m - 2 * common[0] ;
+	}
+
+	/*
+	Myers' greedy algorithm, keeping the furthest reaching x of each diagonal
+	k after every step d to walk back along. Edits are appended to edits,
+	offset by aOffset and bOffset. Returns the number of differences, or -1,
+	appending nothing, if there are more than maxDifferences.
+	*/
+	static int Greedy( const uint64_t* a, int n, const uint64_t* b, int m, int aOffset, int bOffset, int maxDifferences, std::vector<HtmlDiffEdit>& edits )
+	{
+		if ( n == 0 || m == 0 )
+		{
+			if ( n + m > maxDifferences )
+				return -1 ;
+			AddEdit( edits, aOffset, n, bOffset, m ) ;
+			return n + m ;
+		}
+
+		int limit = (std::min)( maxDifferences, n + m ) ;
+		std::vector<int> v( 2 * limit + 3 ) ;
+		std::vector<int> trace ;
+		int* diagonals = &v[limit + 1] ;
+		diagonals[1] = 0 ;
+
+		int d ;
+		bool found = false ;
+		for ( d = 0; d <= limit && !found; d++ )
+		{
+			for ( int k = -d; k <= d; k += 2 )
+			{
+				int x = (k == -d || (k != d && diagonals[k - 1] < diagonals[k + 1])) ? diagonals[k + 1] : diagonals[k - 1] + 1 ;
+				int y = x - k ;
+				while ( x < n && y < m && a[x] == b[y] )
+				{
+					x++ ;
+					y++ ;
+				}
+				diagonals[k] = x ;
+				if ( x >= n && y >= m )
+				{
+					found = true ;
+					break ;
+				}
+			}
+			trace.insert( trace.end(), diagonals - d, diagonals + d + 1 ) ;
+		}
+		if ( !found )
+			return -1 ;
+		d-- ;
+		int differences = d ;
+
+		// walk back from (n, m), the step before d being stored at (d - 1)^2
+		std::vector<HtmlDiffEdit> reversed ;
+		int x = n ;
+		int y = m ;
+		for ( ; d > 0; d-- )
+		{
+			const int* previous = &trace[(size_t)(d - 1) * (d - 1) + (d - 1)] ;
+			int k = x - y ;
+			int previousK = (k == -d || (k != d && previous[k - 1] < previous[k + 1])) ? k + 1 : k - 1 ;
+			int previousX = previous[previousK] ;
+			int previousY = previousX - previousK ;
+			while ( x > previousX && y > previousY )
+			{
+				x-- ;
+				y-- ;
+			}
+			HtmlDiffEdit edit = { aOffset + x, 0, bOffset + y, 0 } ;
+			if ( x == previousX )
+				edit.newStart--, edit.newCount = 1 ;
+			else
+				edit.oldStart--, edit.oldCount = 1 ;
+			reversed.push_back( edit ) ;
+			x = previousX ;
+			y = previousY ;
+		}
+
+		for ( size_t i = reversed.size(); i-- > 0; )
+			AddEdit( edits, reversed[i].oldStart, reversed[i].oldCount, reversed[i].newStart, reversed[i].newCount ) ;
+		return differences ;
+	}
+
+	/*
+	Finds the middle snake of a shortest edit script from a[0, n) to b[0, m)
+	by following paths forwards from the start and backwards from the end
+	until they overlap, returning the length of the script, or -1 if it's
+	longer than maxDifferences. forward and backward have room for
+	2 * (n + m) + 4 diagonals.
+	*/
+	static int MiddleSnake( const uint64_t* a, int n, const uint64_t* b, int m, int maxDifferences, int* forward, int* backward, Snake* snake )
+	{
+		int delta = n - m ;
+		bool odd = (delta & 1) != 0 ;
+		int maxD = (n + m + 1) / 2 ;
+		int* vf = forward + maxD + 1 ;
+		int* vb = backward + maxD + 1 ;
+		vf[1] = 0 ;
+		vb[1] = 0 ;
+
+		for ( int d = 0; d <= maxD; d++ )
+		{
+			if ( 2 * d - 1 > maxDifferences )
+				return -1 ;
+
+			for ( int k = -d; k <= d; k += 2 )
+			{
+				int x = (k == -d || (k != d && vf[k - 1] < vf[k + 1])) ? vf[k + 1] : vf[k - 1] + 1 ;
+				int y = x - k ;
+				int x0 = x ;
+				int y0 = y ;
+				while ( x < n && y < m && a[x] == b[y] )
+				{
+					x++ ;
+					y++ ;
+				}
+				vf[k] = x ;
+				int c = delta - k ;
+				if ( odd && c >= -(d - 1) && c <= d - 1 && vf[k] + vb[c] >= n )
+				{
+					snake->x = x0 ;
+					snake->y = y0 ;
+					snake->u = x ;
+					snake->v = y ;
+					return 2 * d - 1 ;
+				}
+			}
+
+			// backwards, x and y counted from the ends
+			for ( int c = -d; c <= d; c += 2 )
+			{
+				int x = (c == -d || (c != d && vb[c - 1] < vb[c + 1])) ? vb[c + 1] : vb[c - 1] + 1 ;
+				int y = x - c ;
+				int x0 = x ;
+				int y0 = y ;
+				while ( x < n && y < m && a[n - 1 - x] == b[m - 1 - y] )
+				{
+					x++ ;
+					y++ ;
+				}
+				vb[c] = x ;
+				int k = delta - c ;
+				if ( !odd && k >= -d && k <= d && vf[k] + vb[c] >= n )
+				{
+					if ( 2 * d > maxDifferences )
+						return -1 ;
+					snake->x = n - x ;
+					snake->y = m - y ;
+					snake->u = n - x0 ;
+					snake->v = m - y0 ;
+					return 2 * d ;
+				}
+			}
+		}
+		return -1 ;
+	}
+
+	/*
+	Appends the edits of a shortest script from a[0, n) to b[0, m), given the
+	middle snake of one with differences steps: those of the script up to the
+	snake, then those after it, each found the same way.
+	*/
+	static void Split( const uint64_t* a, int n, const uint64_t* b, int m, int aOffset, int bOffset,
+		int differences, const Snake& snake, int* forward, int* backward, std::vector<HtmlDiffEdit>& edits )
+	{
+		if ( differences <= 1 )
+		{
+			Greedy( a, n, b, m, aOffset, bOffset, differences, edits ) ;
+			return ;
+		}
+		Solve( a, snake.x, b, snake.y, aOffset, bOffset, forward, backward, edits ) ;
+		Solve( a + snake.u, n - snake.u, b + snake.v, m - snake.v, aOffset + snake.u, bOffset + snake.v, forward, backward, edits ) ;
+	}
+
+	static void Solve( const uint64_t* a, int n, const uint64_t* b, int m, int aOffset, int bOffset,
+		int* forward, int* backward, std::vector<HtmlDiffEdit>& edits )
+	{
+		while ( n > 0 && m > 0 && a[0] == b[0] )
+		{
+			a++, b++, n--, m-- ;
+			aOffset++, bOffset++ ;
+		}
+		while ( n > 0 && m > 0 && a[n - 1] == b[m - 1] )
+			n--, m-- ;
+
+		if ( n == 0 || m == 0 || n + m < SPLIT_MIN_TOKENS )
+		{
+			Greedy( a, n, b, m, aOffset, bOffset, n + m, edits ) ;
+			return ;
+		}
+
+		Snake snake ;
+		int differences = MiddleSnake( a, n, b, m, n + m, forward, backward, &snake ) ;
+		Split( a, n, b, m, aOffset, bOffset, differences, snake, forward, backward, edits ) ;
+	}
+} ;
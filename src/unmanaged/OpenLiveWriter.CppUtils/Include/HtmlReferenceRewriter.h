@@ -0,0 +1,288 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include "HtmlTokenizer.h"
+
+/*
+Replaces the references in post HTML that are keys of a mapping table (the
+supporting file URLs of a post) with their values, in one pass over the HTML
+and with a single allocation for the result.
+
+Tags are found by HtmlTokenizer, the way OpenLiveWriter.HtmlParser's
+SimpleHtmlParser finds them, comments, directives and <script>/<style> bodies
+included, and the
+attributes looked at are the ones HtmlReferenceFixer looks at (the URL
+attribute of each element in LightWeightHTMLDocument.AllUrlElements, first
+occurrence with a value). Unlike HtmlReferenceFixer, which writes every such
+tag back out in its own formatting, only the values that are replaced change;
+they are written in double quotes. Everything else is copied as it is.
+
+Keys are compared with the attribute value as it appears in the HTML, ignoring
+ASCII case; callers that care about character references add the escaped form
+of a key as a key too. Values are written as given, so they have to be escaped
+for use in a double quoted attribute already.
+
+The mapping strings are not copied and have to outlive the rewriter.
+*/
+class HtmlReferenceRewriter
+{
+public:
+	HtmlReferenceRewriter()
+		: m_bucketMask( 0 ), m_maxKeyLength( 0 )
+	{
+	}
+
+	void AddMapping( LPCWSTR from, int fromLength, LPCWSTR to, int toLength )
+	{
+		Mapping mapping = { from, fromLength, to, toLength, Hash( from, fromLength ) } ;
+		m_mappings.Add( mapping ) ;
+		m_maxKeyLength = max( m_maxKeyLength, fromLength ) ;
+		m_buckets.RemoveAll() ;
+	}
+
+	/*
+	Rewrites length characters of html. Returns S_OK and the rewritten HTML
+	in *result, allocated with CoTaskMemAlloc and null terminated, or S_FALSE
+	and NULL if no reference was replaced.
+	*/
+	HRESULT Rewrite( LPCWSTR html, int length, LPWSTR* result, int* resultLength )
+	{
+		*result = NULL ;
+		*resultLength = 0 ;
+		if ( html == NULL || length < 0 )
+			return E_INVALIDARG ;
+
+		if ( m_mappings.IsEmpty() )
+			return S_FALSE ;
+		BuildBuckets() ;
+
+		m_replacements.RemoveAll() ;
+		HRESULT hr = FindReplacements( html, length ) ;
+		if ( FAILED( hr ) )
+			return hr ;
+
+		if ( m_replacements.IsEmpty() )
+			return S_FALSE ;
+
+		// size the output exactly, so it is allocated and written once
+		__int64 outputLength = length ;
+		for ( size_t i = 0; i < m_replacements.GetCount(); i++ )
+		{
+			const Replacement& replacement = m_replacements[i] ;
+			outputLength += 2 + m_mappings[replacement.mapping].toLength - (replacement.end - replacement.start) ;
+		}
+		if ( outputLength >= INT_MAX )
+			return E_OUTOFMEMORY ;
+
+		LPWSTR output = (LPWSTR)::CoTaskMemAlloc( (size_t)(outputLength + 1) * sizeof(WCHAR) ) ;
+		if ( output == NULL )
+			return E_OUTOFMEMORY ;
+
+		LPWSTR out = output ;
+		int copied = 0 ;
+		for ( size_t i = 0; i < m_replacements.GetCount(); i++ )
+		{
+			const Replacement& replacement = m_replacements[i] ;
+			const Mapping& mapping = m_mappings[replacement.mapping] ;
+			memcpy( out, html + copied, (replacement.start - copied) * sizeof(WCHAR) ) ;
+			out += replacement.start - copied ;
+			*out++ = L'"' ;
+			memcpy( out, mapping.to, mapping.toLength * sizeof(WCHAR) ) ;
+			out += mapping.toLength ;
+			*out++ = L'"' ;
+			copied = replacement.end ;
+		}
+		memcpy( out, html + copied, (length - copied) * sizeof(WCHAR) ) ;
+		out += length - copied ;
+		*out = L'\0' ;
+
+		*result = output ;
+		*resultLength = (int)outputLength ;
+		return S_OK ;
+	}
+
+private:
+	struct Mapping
+	{
+		LPCWSTR from ;
+		int fromLength ;
+		LPCWSTR to ;
+		int toLength ;
+		DWORD hash ;
+	} ;
+
+	// an attribute value, quotes included, to replace with a mapping's value
+	struct Replacement
+	{
+		int start ;
+		int end ;
+		size_t mapping ;
+	} ;
+
+	struct UrlAttribute
+	{
+		LPCWSTR element ;
+		LPCWSTR attribute ;
+	} ;
+
+	static const UrlAttribute* FindUrlAttribute( LPCWSTR name, int length )
+	{
+		// LightWeightHTMLDocument.AllUrlElements
+		static const UrlAttribute urlAttributes[] =
+		{
+			{ L"a", L"href" }, { L"area", L"href" }, { L"body", L"background" },
+			{ L"embed", L"src" }, { L"form", L"action" }, { L"frame", L"src" },
+			{ L"iframe", L"src" }, { L"img", L"src" }, { L"input", L"src" },
+			{ L"link", L"href" }, { L"object", L"src" }, { L"param", L"value" },
+			{ L"script", L"src" }, { L"table", L"background" }, { L"td", L"background" },
+			{ L"tr", L"background" }
+		} ;
+
+		for ( size_t i = 0; i < _countof(urlAttributes); i++ )
+		{
+			if ( HtmlTokenizer::NameEquals( name, length, urlAttributes[i].element ) )
+				return &urlAttributes[i] ;
+		}
+		return NULL ;
+	}
+
+	// FNV-1a, ignoring ASCII case
+	static DWORD Hash( LPCWSTR text, int length )
+	{
+		DWORD hash = 2166136261 ;
+		for ( int i = 0; i < length; i++ )
+			hash = (hash ^ HtmlTokenizer::FoldAscii( text[i] )) * 16777619 ;
+		return hash ;
+	}
+
+	void BuildBuckets()
+	{
+		if ( !m_buckets.IsEmpty() )
+			return ;
+
+		size_t bucketCount = 16 ;
+		while ( bucketCount < m_mappings.GetCount() * 2 )
+			bucketCount *= 2 ;
+		m_buckets.SetCount( bucketCount ) ;
+		m_bucketMask = bucketCount - 1 ;
+		for ( size_t i = 0; i < bucketCount; i++ )
+			m_buckets[i] = -1 ;
+
+		// the first mapping added for a key wins
+		for ( size_t i = 0; i < m_mappings.GetCount(); i++ )
+		{
+			const Mapping& mapping = m_mappings[i] ;
+			size_t bucket = mapping.hash & m_bucketMask ;
+			bool duplicate = false ;
+			for ( ; m_buckets[bucket] != -1; bucket = (bucket + 1) & m_bucketMask )
+			{
+				const Mapping& other = m_mappings[m_buckets[bucket]] ;
+				if ( other.hash == mapping.hash && KeyEquals( other, mapping.from, mapping.fromLength ) )
+				{
+					duplicate = true ;
+					break ;
+				}
+			}
+			if ( !duplicate )
+				m_buckets[bucket] = (int)i ;
+		}
+	}
+
+	static bool KeyEquals( const Mapping& mapping, LPCWSTR text, int length )
+	{
+		if ( mapping.fromLength != length )
+			return false ;
+		for ( int i = 0; i < length; i++ )
+		{
+			if ( HtmlTokenizer::FoldAscii( mapping.from[i] ) != HtmlTokenizer::FoldAscii( text[i] ) )
+				return false ;
+		}
+		return true ;
+	}
+
+	// The mapping whose key is the value, or -1.
+	int FindMapping( LPCWSTR value, int length ) const
+	{
+		// spares hashing the likes of data: URLs
+		if ( length > m_maxKeyLength )
+			return -1 ;
+
+		DWORD hash = Hash( value, length ) ;
+		for ( size_t bucket = hash & m_bucketMask; m_buckets[bucket] != -1; bucket = (bucket + 1) & m_bucketMask )
+		{
+			const Mapping& mapping = m_mappings[m_buckets[bucket]] ;
+			if ( mapping.hash == hash && KeyEquals( mapping, value, length ) )
+				return m_buckets[bucket] ;
+		}
+		return -1 ;
+	}
+
+	// Records the replacement of the URL attribute of each begin tag that has one.
+	HRESULT FindReplacements( LPCWSTR html, int length )
+	{
+		HtmlTokenizer tokenizer( html, length ) ;
+		if ( m_tokens.IsEmpty() )
+		{
+			m_tokens.SetCount( 256 ) ;
+			m_attributes.SetCount( 1024 ) ;
+		}
+
+		while ( !tokenizer.IsDone() )
+		{
+			int attributeCount ;
+			int tokenCount = tokenizer.Next( m_tokens.GetData(), (int)m_tokens.GetCount(),
+				m_attributes.GetData(), (int)m_attributes.GetCount(), &attributeCount ) ;
+			if ( tokenCount < 0 )
+			{
+				// a tag with more attributes than there is room for
+				if ( m_attributes.GetCount() >= INT_MAX / 2 )
+					return E_OUTOFMEMORY ;
+				m_attributes.SetCount( m_attributes.GetCount() * 2 ) ;
+				continue ;
+			}
+
+			for ( int i = 0; i < tokenCount; i++ )
+			{
+				const HtmlToken& token = m_tokens[i] ;
+				if ( token.kind == HTML_TOKEN_BEGIN_TAG )
+					FindReplacement( html, token ) ;
+			}
+		}
+		return S_OK ;
+	}
+
+	void FindReplacement( LPCWSTR html, const HtmlToken& tag )
+	{
+		const UrlAttribute* urlAttribute = FindUrlAttribute( html + tag.nameStart, tag.nameLength ) ;
+		if ( urlAttribute == NULL )
+			return ;
+
+		// only the first occurrence with a value counts
+		for ( int i = tag.firstAttribute; i < tag.firstAttribute + tag.attributeCount; i++ )
+		{
+			const HtmlTokenAttribute& attribute = m_attributes[i] ;
+			if ( attribute.valueStart < 0 || !HtmlTokenizer::NameEquals( html + attribute.nameStart, attribute.nameLength, urlAttribute->attribute ) )
+				continue ;
+
+			int mapping = FindMapping( html + attribute.valueStart, attribute.valueLength ) ;
+			if ( mapping >= 0 )
+			{
+				// the quotes are replaced too
+				int quoteLength = attribute.quote != 0 ? 1 : 0 ;
+				Replacement replacement = { attribute.valueStart - quoteLength, attribute.valueStart + attribute.valueLength + quoteLength, (size_t)mapping } ;
+				m_replacements.Add( replacement ) ;
+			}
+			return ;
+		}
+	}
+
+	CAtlArray<Mapping> m_mappings ;
+	CAtlArray<int> m_buckets ;
+	size_t m_bucketMask ;
+	int m_maxKeyLength ;
+	CAtlArray<Replacement> m_replacements ;
+	CAtlArray<HtmlToken> m_tokens ;
+	CAtlArray<HtmlTokenAttribute> m_attributes ;
+} ;
@@ -0,0 +1,438 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include <emmintrin.h>
+#include <intrin.h>
+
+/*
+Splits HTML into the same elements as OpenLiveWriter.HtmlParser's
+SimpleHtmlParser, without copying anything: each token is a span of the HTML,
+and begin tags point at a run of attribute spans. Tokens and attributes go into
+arrays the caller provides, so tokenizing a post allocates nothing, and the
+structs are blittable for the managed code to walk.
+
+The rules are SimpleHtmlParser's regular expressions, written out by hand
+(each is quoted where it is matched). As there, a '<' that doesn't start a
+comment, directive or tag is text, and the bodies of <script> and <style> are
+not markup; they are returned as one token for the managed code to hand to
+JavascriptParser or CssParser. Text up to the next '<' is skipped eight
+characters at a time with SSE2 where the processor has it.
+*/
+
+enum HtmlTokenKind
+{
+	HTML_TOKEN_TEXT = 0,
+	HTML_TOKEN_COMMENT = 1,
+	HTML_TOKEN_DIRECTIVE = 2,
+	HTML_TOKEN_BEGIN_TAG = 3,
+	HTML_TOKEN_END_TAG = 4,
+	HTML_TOKEN_SCRIPT_BODY = 5,
+	HTML_TOKEN_STYLE_BODY = 6
+} ;
+
+// HtmlToken.flags: the begin tag ends with />
+const int HTML_TOKEN_COMPLETE = 1 ;
+
+struct HtmlToken
+{
+	int kind ;
+	int start ;
+	int length ;
+	int nameStart ;			// tags only
+	int nameLength ;
+	int firstAttribute ;	// begin tags only: index of the first of attributeCount attributes
+	int attributeCount ;
+	int residueStart ;		// begin tags only: what followed the attributes that wasn't one, or -1
+	int residueLength ;
+	int flags ;
+} ;
+
+struct HtmlTokenAttribute
+{
+	int nameStart ;
+	int nameLength ;
+	int valueStart ;		// -1 if the attribute has no value
+	int valueLength ;
+	int quote ;				// the quote character around the value, or 0
+} ;
+
+class HtmlTokenizer
+{
+public:
+	HtmlTokenizer( LPCWSTR html, int length )
+		: m_html( html ), m_length( length ), m_pos( 0 )
+	{
+	}
+
+	/*
+	Tokenizes from where the last call stopped until the end of the HTML or
+	until the arrays are full, returning how many tokens were written. The
+	attributes of the tokens are written from attributes[0]. Returns -1 if
+	not even one tag fits, in which case the caller needs bigger arrays.
+	*/
+	int Next( HtmlToken* tokens, int tokenCapacity, HtmlTokenAttribute* attributes, int attributeCapacity, int* attributeCount )
+	{
+		int tokenCount = 0 ;
+		*attributeCount = 0 ;
+
+		// a text run, some markup and a <script> body
+		const int MAX_STEP_TOKENS = 3 ;
+		while ( m_pos < m_length && tokenCount + MAX_STEP_TOKENS <= tokenCapacity )
+		{
+			int textStart = m_pos ;
+			int pos = m_pos ;
+			HtmlToken markup ;
+			HtmlToken body ;
+			int stepAttributes = *attributeCount ;
+			bool found = false ;
+			bool full = false ;
+			while ( (pos = Find( m_html, pos, m_length, L'<' )) < m_length )
+			{
+				int markupLength = ParseMarkup( pos, markup, body, attributes, attributeCapacity, &stepAttributes, &full ) ;
+				if ( full )
+					break ;
+				if ( markupLength >= 0 )
+				{
+					found = true ;
+					break ;
+				}
+				pos++ ;
+			}
+
+			if ( full )
+				return tokenCount == 0 ? -1 : tokenCount ;
+
+			if ( pos > textStart )
+			{
+				HtmlToken& text = tokens[tokenCount++] ;
+				InitToken( text, HTML_TOKEN_TEXT, textStart, pos - textStart ) ;
+			}
+			if ( found )
+			{
+				tokens[tokenCount++] = markup ;
+				if ( body.length > 0 )
+					tokens[tokenCount++] = body ;
+				*attributeCount = stepAttributes ;
+				m_pos = body.length > 0 ? body.start + body.length : markup.start + markup.length ;
+			}
+			else
+			{
+				m_pos = m_length ;
+			}
+		}
+
+		if ( tokenCount == 0 && m_pos < m_length )
+			return -1 ;
+		return tokenCount ;
+	}
+
+	bool IsDone() const
+	{
+		return m_pos >= m_length ;
+	}
+
+	// Where the next call to Next carries on.
+	int GetPosition() const
+	{
+		return m_pos ;
+	}
+
+	void SetPosition( int pos )
+	{
+		m_pos = pos ;
+	}
+
+	// The first occurrence of c at or after pos, or length.
+	static int Find( LPCWSTR text, int pos, int length, WCHAR c )
+	{
+		if ( HasSse2() )
+		{
+			const __m128i match = _mm_set1_epi16( (short)c ) ;
+			for ( ; pos + 8 <= length; pos += 8 )
+			{
+				__m128i chars = _mm_loadu_si128( reinterpret_cast<const __m128i*>(text + pos) ) ;
+				int mask = _mm_movemask_epi8( _mm_cmpeq_epi16( chars, match ) ) ;
+				if ( mask != 0 )
+				{
+					unsigned long bit ;
+					_BitScanForward( &bit, mask ) ;
+					return pos + bit / 2 ;
+				}
+			}
+		}
+
+		while ( pos < length && text[pos] != c )
+			pos++ ;
+		return pos ;
+	}
+
+	// \s in .NET regular expressions
+	static bool IsSpace( WCHAR c )
+	{
+		return c == L' ' || (c >= 0x09 && c <= 0x0D) || c == 0x85 || c == 0xA0 || c == 0x1680
+			|| (c >= 0x2000 && c <= 0x200A) || c == 0x2028 || c == 0x2029 || c == 0x202F
+			|| c == 0x205F || c == 0x3000 ;
+	}
+
+	static int SkipSpaces( LPCWSTR text, int pos, int length )
+	{
+		while ( pos < length && IsSpace( text[pos] ) )
+			pos++ ;
+		return pos ;
+	}
+
+	static bool IsNameStart( WCHAR c )
+	{
+		return (c >= L'a' && c <= L'z') || (c >= L'A' && c <= L'Z') ;
+	}
+
+	static bool IsNameChar( WCHAR c )
+	{
+		return IsNameStart( c ) || (c >= L'0' && c <= L'9') || c == L'.' || c == L'-' || c == L'_' || c == L':' ;
+	}
+
+	// The end of the name [a-z][a-z0-9\.\-_:]* that starts at pos.
+	static int NameEnd( LPCWSTR text, int pos, int length )
+	{
+		while ( pos < length && IsNameChar( text[pos] ) )
+			pos++ ;
+		return pos ;
+	}
+
+	static WCHAR FoldAscii( WCHAR c )
+	{
+		return c >= L'A' && c <= L'Z' ? c + (L'a' - L'A') : c ;
+	}
+
+	// Compares a name from the HTML with a lower case one.
+	static bool NameEquals( LPCWSTR name, int length, LPCWSTR lowerCaseName )
+	{
+		int i = 0 ;
+		for ( ; i < length; i++ )
+		{
+			if ( lowerCaseName[i] == L'\0' || FoldAscii( name[i] ) != lowerCaseName[i] )
+				return false ;
+		}
+		return lowerCaseName[i] == L'\0' ;
+	}
+
+	static bool StartsWith( LPCWSTR text, int pos, int length, LPCWSTR lowerCasePrefix )
+	{
+		for ( ; *lowerCasePrefix != L'\0'; lowerCasePrefix++, pos++ )
+		{
+			if ( pos >= length || FoldAscii( text[pos] ) != *lowerCasePrefix )
+				return false ;
+		}
+		return true ;
+	}
+
+private:
+	static bool HasSse2()
+	{
+		static const bool sse2 = IsProcessorFeaturePresent( PF_XMMI64_INSTRUCTIONS_AVAILABLE ) != FALSE ;
+		return sse2 ;
+	}
+
+	static void InitToken( HtmlToken& token, int kind, int start, int length )
+	{
+		token.kind = kind ;
+		token.start = start ;
+		token.length = length ;
+		token.nameStart = token.nameLength = 0 ;
+		token.firstAttribute = token.attributeCount = 0 ;
+		token.residueStart = -1 ;
+		token.residueLength = 0 ;
+		token.flags = 0 ;
+	}
+
+	/*
+	Parses the markup starting with the '<' at pos like SimpleHtmlParser's
+	ParseMarkup, into markup and, for <script> and <style>, body (which is
+	left empty otherwise). Returns the length of the markup, or -1 if the '<'
+	doesn't start markup and is just text. Sets full if a begin tag's
+	attributes don't fit.
+	*/
+	int ParseMarkup( int pos, HtmlToken& markup, HtmlToken& body, HtmlTokenAttribute* attributes, int attributeCapacity, int* attributeCount, bool* full )
+	{
+		LPCWSTR html = m_html ;
+		int length = m_length ;
+		InitToken( body, HTML_TOKEN_TEXT, 0, 0 ) ;
+
+		// <!--.*?--\s*>
+		if ( StartsWith( html, pos, length, L"<!--" ) )
+		{
+			for ( int dash = Find( html, pos + 4, length, L'-' ); dash + 1 < length; dash = Find( html, dash + 1, length, L'-' ) )
+			{
+				if ( html[dash + 1] != L'-' )
+					continue ;
+				int close = SkipSpaces( html, dash + 2, length ) ;
+				if ( close < length && html[close] == L'>' )
+				{
+					InitToken( markup, HTML_TOKEN_COMMENT, pos, close + 1 - pos ) ;
+					return markup.length ;
+				}
+			}
+			// an unterminated comment is neither a directive nor a tag
+			return -1 ;
+		}
+
+		// <!(?!--).*?>
+		if ( StartsWith( html, pos, length, L"<!" ) )
+		{
+			int close = Find( html, pos + 2, length, L'>' ) ;
+			if ( close >= length )
+				return -1 ;
+			InitToken( markup, HTML_TOKEN_DIRECTIVE, pos, close + 1 - pos ) ;
+			return markup.length ;
+		}
+
+		// </([a-z][a-z0-9\.\-_:]*)\s*>
+		if ( pos + 2 < length && html[pos + 1] == L'/' )
+		{
+			if ( !IsNameStart( html[pos + 2] ) )
+				return -1 ;
+			int nameEnd = NameEnd( html, pos + 2, length ) ;
+			int close = SkipSpaces( html, nameEnd, length ) ;
+			if ( close >= length || html[close] != L'>' )
+				return -1 ;
+			InitToken( markup, HTML_TOKEN_END_TAG, pos, close + 1 - pos ) ;
+			markup.nameStart = pos + 2 ;
+			markup.nameLength = nameEnd - (pos + 2) ;
+			return markup.length ;
+		}
+
+		// <([a-z][a-z0-9\.\-_:]*)
+		if ( pos + 1 < length && IsNameStart( html[pos + 1] ) )
+			return ParseBeginTag( pos, markup, body, attributes, attributeCapacity, attributeCount, full ) ;
+
+		return -1 ;
+	}
+
+	int ParseBeginTag( int pos, HtmlToken& tag, HtmlToken& body, HtmlTokenAttribute* attributes, int attributeCapacity, int* attributeCount, bool* full )
+	{
+		LPCWSTR html = m_html ;
+		int length = m_length ;
+
+		int nameStart = pos + 1 ;
+		int nameEnd = NameEnd( html, nameStart, length ) ;
+		InitToken( tag, HTML_TOKEN_BEGIN_TAG, pos, 0 ) ;
+		tag.nameStart = nameStart ;
+		tag.nameLength = nameEnd - nameStart ;
+		tag.firstAttribute = *attributeCount ;
+
+		int tagPos = nameEnd ;
+		while ( true )
+		{
+			// \s*(/)?>
+			int next = SkipSpaces( html, tagPos, length ) ;
+			if ( next < length && html[next] == L'>' )
+			{
+				tagPos = next + 1 ;
+				break ;
+			}
+			if ( next + 1 < length && html[next] == L'/' && html[next + 1] == L'>' )
+			{
+				tag.flags |= HTML_TOKEN_COMPLETE ;
+				tagPos = next + 2 ;
+				break ;
+			}
+
+			// \s*([a-z][a-z0-9\.\-_:]*), or else the rest of the tag is residue
+			if ( next >= length || !IsNameStart( html[next] ) )
+			{
+				int residueStart = tagPos ;
+				while ( tagPos < length && html[tagPos] != L'<' && html[tagPos] != L'>' )
+					tagPos++ ;
+				if ( tagPos > residueStart )
+				{
+					tag.residueStart = residueStart ;
+					tag.residueLength = tagPos - residueStart ;
+				}
+				if ( tagPos < length && html[tagPos] == L'>' )
+					tagPos++ ;
+				break ;
+			}
+
+			if ( *attributeCount >= attributeCapacity )
+			{
+				*full = true ;
+				return -1 ;
+			}
+			HtmlTokenAttribute& attribute = attributes[(*attributeCount)++] ;
+			tag.attributeCount++ ;
+			attribute.nameStart = next ;
+			attribute.nameLength = NameEnd( html, next, length ) - next ;
+			attribute.valueStart = -1 ;
+			attribute.valueLength = 0 ;
+			attribute.quote = 0 ;
+			tagPos = next + attribute.nameLength ;
+
+			// \s*=\s*(["'])(.*?)\1, or else \s*=\s*([^\s>]+)
+			int equals = SkipSpaces( html, tagPos, length ) ;
+			if ( equals < length && html[equals] == L'=' )
+			{
+				int value = SkipSpaces( html, equals + 1, length ) ;
+				if ( value < length && (html[value] == L'"' || html[value] == L'\'') )
+				{
+					int quote = Find( html, value + 1, length, html[value] ) ;
+					if ( quote < length )
+					{
+						attribute.valueStart = value + 1 ;
+						attribute.valueLength = quote - (value + 1) ;
+						attribute.quote = html[value] ;
+						tagPos = quote + 1 ;
+					}
+				}
+				if ( attribute.valueStart < 0 )
+				{
+					int end = value ;
+					while ( end < length && !IsSpace( html[end] ) && html[end] != L'>' )
+						end++ ;
+					if ( end > value )
+					{
+						attribute.valueStart = value ;
+						attribute.valueLength = end - value ;
+						tagPos = end ;
+					}
+				}
+			}
+		}
+		tag.length = tagPos - pos ;
+
+		// the bodies of <script> and <style> are not markup
+		LPCWSTR endTag = NULL ;
+		int bodyKind = HTML_TOKEN_TEXT ;
+		if ( NameEquals( html + nameStart, nameEnd - nameStart, L"script" ) )
+		{
+			endTag = L"</script" ;
+			bodyKind = HTML_TOKEN_SCRIPT_BODY ;
+		}
+		else if ( NameEquals( html + nameStart, nameEnd - nameStart, L"style" ) )
+		{
+			endTag = L"</style" ;
+			bodyKind = HTML_TOKEN_STYLE_BODY ;
+		}
+		if ( endTag != NULL )
+		{
+			int endTagLength = lstrlenW( endTag ) ;
+			int bodyEnd = tagPos ;
+			for ( ; (bodyEnd = Find( html, bodyEnd, length, L'<' )) < length; bodyEnd++ )
+			{
+				if ( !StartsWith( html, bodyEnd, length, endTag ) )
+					continue ;
+				int close = SkipSpaces( html, bodyEnd + endTagLength, length ) ;
+				if ( close < length && html[close] == L'>' )
+					break ;
+			}
+			InitToken( body, bodyKind, tagPos, bodyEnd - tagPos ) ;
+		}
+
+		return tag.length ;
+	}
+
+	LPCWSTR m_html ;
+	int m_length ;
+	int m_pos ;
+} ;
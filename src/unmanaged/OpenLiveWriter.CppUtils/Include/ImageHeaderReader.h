@@ -0,0 +1,383 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+Reads the dimensions of a JPEG, PNG, GIF, BMP or WebP image from its headers,
+along with a JPEG's EXIF orientation and where its EXIF thumbnail is, without
+decoding any pixels.
+
+The image is read through an ImageHeaderSource a window of
+IMAGE_HEADER_WINDOW bytes at a time, only where the headers are: the start of
+the file, and for a JPEG each segment header up to the frame header plus the
+EXIF directories. That is a few KB for most images however large they are.
+*/
+
+enum ImageHeaderFormat
+{
+	IMAGE_HEADER_UNKNOWN = 0,
+	IMAGE_HEADER_JPEG = 1,
+	IMAGE_HEADER_PNG = 2,
+	IMAGE_HEADER_GIF = 3,
+	IMAGE_HEADER_BMP = 4,
+	IMAGE_HEADER_WEBP = 5
+} ;
+
+// What an image's headers say, laid out for the managed code to marshal.
+struct ImageHeader
+{
+	int32_t format ;			// an ImageHeaderFormat
+	int32_t width ;
+	int32_t height ;
+	int32_t orientation ;		// the EXIF orientation (1-8), or 0 if there is none
+	int64_t thumbnailOffset ;	// where the EXIF thumbnail's JPEG is
+	int32_t thumbnailLength ;	// or 0 if there is none
+	int32_t bytesRead ;			// how much of the image was read to find all this
+} ;
+
+// the most read at a time
+const size_t IMAGE_HEADER_WINDOW = 4096 ;
+
+class ImageHeaderSource
+{
+public:
+	// Reads up to count bytes at offset, returning how many there were.
+	virtual size_t ReadAt( uint64_t offset, uint8_t* buffer, size_t count ) = 0 ;
+} ;
+
+class ImageHeaderReader
+{
+public:
+	/*
+	Reads source's headers into header, returning false (and format
+	IMAGE_HEADER_UNKNOWN) if the format isn't one of these or the headers
+	don't make sense.
+	*/
+	static bool Read( ImageHeaderSource& source, ImageHeader* header )
+	{
+		ImageHeaderReader reader( source ) ;
+		memset( header, 0, sizeof(ImageHeader) ) ;
+
+		bool read = reader.ReadFormat( header ) && header->width > 0 && header->height > 0 ;
+		if ( !read )
+			memset( header, 0, sizeof(ImageHeader) ) ;
+		header->bytesRead = (int32_t)reader.m_bytesRead ;
+		return read ;
+	}
+
+private:
+	ImageHeaderReader( ImageHeaderSource& source )
+		: m_source( source ), m_windowOffset( 0 ), m_windowLength( 0 ), m_bytesRead( 0 ), m_bigEndian( false )
+	{
+	}
+
+	bool ReadFormat( ImageHeader* header )
+	{
+		const uint8_t* p = Fetch( 0, 12 ) ;
+		if ( p == NULL )
+			p = Fetch( 0, 2 ) ;
+		if ( p == NULL )
+			return false ;
+
+		if ( p[0] == 0xFF && p[1] == 0xD8 )
+		{
+			header->format = IMAGE_HEADER_JPEG ;
+			return ReadJpeg( header ) ;
+		}
+		if ( m_windowLength < 12 )
+			return false ;
+		if ( memcmp( p, "\x89PNG\r\n\x1A\n", 8 ) == 0 )
+		{
+			header->format = IMAGE_HEADER_PNG ;
+			return ReadPng( header ) ;
+		}
+		if ( memcmp( p, "GIF87a", 6 ) == 0 || memcmp( p, "GIF89a", 6 ) == 0 )
+		{
+			header->format = IMAGE_HEADER_GIF ;
+			header->width = Little16( p + 6 ) ;
+			header->height = Little16( p + 8 ) ;
+			return true ;
+		}
+		if ( p[0] == 'B' && p[1] == 'M' )
+		{
+			header->format = IMAGE_HEADER_BMP ;
+			return ReadBmp( header ) ;
+		}
+		if ( memcmp( p, "RIFF", 4 ) == 0 && memcmp( p + 8, "WEBP", 4 ) == 0 )
+		{
+			header->format = IMAGE_HEADER_WEBP ;
+			return ReadWebP( header ) ;
+		}
+		return false ;
+	}
+
+	bool ReadPng( ImageHeader* header )
+	{
+		// the first chunk is always IHDR
+		const uint8_t* p = Fetch( 8, 16 ) ;
+		if ( p == NULL || memcmp( p + 4, "IHDR", 4 ) != 0 )
+			return false ;
+		header->width = Positive( Big32( p + 8 ) ) ;
+		header->height = Positive( Big32( p + 12 ) ) ;
+		return true ;
+	}
+
+	bool ReadBmp( ImageHeader* header )
+	{
+		const uint8_t* p = Fetch( 14, 12 ) ;
+		if ( p == NULL )
+			return false ;
+		uint32_t size = Little32( p ) ;
+		if ( size == 12 )
+		{
+			// BITMAPCOREHEADER
+			header->width = Little16( p + 4 ) ;
+			header->height = Little16( p + 6 ) ;
+			return true ;
+		}
+		if ( size < 40 )
+			return false ;
+
+		// BITMAPINFOHEADER and its successors; a negative height is top-down
+		int32_t height = (int32_t)Little32( p + 8 ) ;
+		header->width = Positive( Little32( p + 4 ) ) ;
+		header->height = height < 0 ? Positive( 0u - (uint32_t)height ) : height ;
+		return true ;
+	}
+
+	bool ReadWebP( ImageHeader* header )
+	{
+		// the first chunk says which of the three kinds of WebP this is
+		const uint8_t* p = Fetch( 12, 18 ) ;
+		if ( p == NULL )
+			return false ;
+
+		if ( memcmp( p, "VP8 ", 4 ) == 0 )
+		{
+			// lossy: a key frame's start code, then 14 bits each of width and height
+			if ( p[11] != 0x9D || p[12] != 0x01 || p[13] != 0x2A )
+				return false ;
+			header->width = Little16( p + 14 ) & 0x3FFF ;
+			header->height = Little16( p + 16 ) & 0x3FFF ;
+			return true ;
+		}
+		if ( memcmp( p, "VP8L", 4 ) == 0 )
+		{
+			// lossless: a signature byte, then 14 bits each of width and height less one
+			if ( p[8] != 0x2F )
+				return false ;
+			uint32_t bits = Little32( p + 9 ) ;
+			header->width = (bits & 0x3FFF) + 1 ;
+			header->height = ((bits >> 14) & 0x3FFF) + 1 ;
+			return true ;
+		}
+		if ( memcmp( p, "VP8X", 4 ) == 0 )
+		{
+			// extended: flags, then 24 bits each of the canvas width and height less one
+			header->width = Little24( p + 12 ) + 1 ;
+			header->height = Little24( p + 15 ) + 1 ;
+			return true ;
+		}
+		return false ;
+	}
+
+	bool ReadJpeg( ImageHeader* header )
+	{
+		// walk the segments up to the frame header
+		uint64_t position = 2 ;
+		bool exifRead = false ;
+		for ( ;; )
+		{
+			const uint8_t* p = Fetch( position, 4 ) ;
+			if ( p == NULL || p[0] != 0xFF )
+				return false ;
+
+			uint8_t marker = p[1] ;
+			if ( marker == 0xFF )
+			{
+				// fill byte
+				position++ ;
+				continue ;
+			}
+			if ( marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7) )
+			{
+				// markers without a segment
+				position += 2 ;
+				continue ;
+			}
+			if ( marker == 0xD8 || marker == 0xD9 || marker == 0xDA )
+			{
+				// the image data started, or the image ended, without a frame
+				return false ;
+			}
+
+			uint32_t length = Big16( p + 2 ) ;
+			if ( length < 2 )
+				return false ;
+
+			if ( marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC )
+			{
+				// SOFn: precision, then height and width
+				const uint8_t* frame = Fetch( position + 4, 5 ) ;
+				if ( frame == NULL )
+					return false ;
+				header->height = Big16( frame + 1 ) ;
+				header->width = Big16( frame + 3 ) ;
+				return true ;
+			}
+
+			if ( marker == 0xE1 && !exifRead && length >= 2 + 6 + 8 )
+			{
+				const uint8_t* exif = Fetch( position + 4, 6 ) ;
+				if ( exif != NULL && memcmp( exif, "Exif\0\0", 6 ) == 0 )
+				{
+					exifRead = true ;
+					ReadExif( position + 10, length - 8, header ) ;
+				}
+			}
+
+			position += 2 + length ;
+		}
+	}
+
+	/*
+	Reads the orientation from the EXIF's first directory and the thumbnail
+	from the second, in the TIFF structure of size bytes at base. Anything
+	that doesn't make sense is left out.
+	*/
+	void ReadExif( uint64_t base, uint32_t size, ImageHeader* header )
+	{
+		const uint8_t* p = Fetch( base, 8 ) ;
+		if ( p == NULL )
+			return ;
+		if ( memcmp( p, "II*\0", 4 ) == 0 )
+			m_bigEndian = false ;
+		else if ( memcmp( p, "MM\0*", 4 ) == 0 )
+			m_bigEndian = true ;
+		else
+			return ;
+
+		uint32_t directory = Exif32( p + 4 ) ;
+		uint32_t next = ReadExifDirectory( base, size, directory, header, false ) ;
+		if ( next != 0 )
+			ReadExifDirectory( base, size, next, header, true ) ;
+	}
+
+	// Returns the offset of the next directory, or 0.
+	uint32_t ReadExifDirectory( uint64_t base, uint32_t size, uint32_t directory, ImageHeader* header, bool thumbnail )
+	{
+		const uint32_t JPEG_INTERCHANGE_FORMAT = 0x0201 ;
+		const uint32_t JPEG_INTERCHANGE_FORMAT_LENGTH = 0x0202 ;
+		const uint32_t ORIENTATION = 0x0112 ;
+
+		if ( directory < 8 || directory > size - 2 )
+			return 0 ;
+		const uint8_t* p = Fetch( base + directory, 2 ) ;
+		if ( p == NULL )
+			return 0 ;
+		uint32_t count = Exif16( p ) ;
+		if ( (uint64_t)directory + 2 + count * 12 + 4 > size )
+			return 0 ;
+
+		uint32_t thumbnailOffset = 0 ;
+		uint32_t thumbnailLength = 0 ;
+		for ( uint32_t i = 0 ; i < count ; i++ )
+		{
+			const uint8_t* entry = Fetch( base + directory + 2 + i * 12, 12 ) ;
+			if ( entry == NULL )
+				return 0 ;
+
+			uint32_t tag = Exif16( entry ) ;
+			if ( !thumbnail && tag == ORIENTATION )
+			{
+				// a SHORT, in the first two bytes of the value
+				uint32_t orientation = Exif16( entry + 8 ) ;
+				if ( orientation >= 1 && orientation <= 8 )
+					header->orientation = orientation ;
+			}
+			else if ( thumbnail && tag == JPEG_INTERCHANGE_FORMAT )
+				thumbnailOffset = Exif32( entry + 8 ) ;
+			else if ( thumbnail && tag == JPEG_INTERCHANGE_FORMAT_LENGTH )
+				thumbnailLength = Exif32( entry + 8 ) ;
+		}
+
+		if ( thumbnail && thumbnailOffset >= 8 && thumbnailOffset < size && thumbnailLength > 0 && thumbnailLength <= size - thumbnailOffset )
+		{
+			header->thumbnailOffset = (int64_t)(base + thumbnailOffset) ;
+			header->thumbnailLength = (int32_t)thumbnailLength ;
+		}
+
+		p = Fetch( base + directory + 2 + count * 12, 4 ) ;
+		return p != NULL ? Exif32( p ) : 0 ;
+	}
+
+	/*
+	The count (at most IMAGE_HEADER_WINDOW) bytes at offset, read into the
+	window if they aren't there already, or NULL if the image ends first.
+	*/
+	const uint8_t* Fetch( uint64_t offset, size_t count )
+	{
+		if ( offset < m_windowOffset || offset + count > m_windowOffset + m_windowLength )
+		{
+			m_windowOffset = offset ;
+			m_windowLength = m_source.ReadAt( offset, m_window, IMAGE_HEADER_WINDOW ) ;
+			m_bytesRead += m_windowLength ;
+			if ( m_windowLength < count )
+				return NULL ;
+		}
+		return m_window + (size_t)(offset - m_windowOffset) ;
+	}
+
+	uint32_t Exif16( const uint8_t* p ) const
+	{
+		return m_bigEndian ? Big16( p ) : Little16( p ) ;
+	}
+
+	uint32_t Exif32( const uint8_t* p ) const
+	{
+		return m_bigEndian ? Big32( p ) : Little32( p ) ;
+	}
+
+	static uint32_t Big16( const uint8_t* p )
+	{
+		return ((uint32_t)p[0] << 8) | p[1] ;
+	}
+
+	static uint32_t Big32( const uint8_t* p )
+	{
+		return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3] ;
+	}
+
+	static uint32_t Little16( const uint8_t* p )
+	{
+		return p[0] | ((uint32_t)p[1] << 8) ;
+	}
+
+	static uint32_t Little24( const uint8_t* p )
+	{
+		return p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) ;
+	}
+
+	static uint32_t Little32( const uint8_t* p )
+	{
+		return p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24) ;
+	}
+
+	// A dimension, or 0 if it doesn't fit an int.
+	static int32_t Positive( uint32_t value )
+	{
+		return value <= 0x7FFFFFFF ? (int32_t)value : 0 ;
+	}
+
+	ImageHeaderSource& m_source ;
+	uint8_t m_window[IMAGE_HEADER_WINDOW] ;
+	uint64_t m_windowOffset ;
+	size_t m_windowLength ;
+	size_t m_bytesRead ;
+	bool m_bigEndian ;
+} ;
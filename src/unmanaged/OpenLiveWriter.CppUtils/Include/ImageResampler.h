@@ -0,0 +1,746 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define IMAGE_RESAMPLER_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(IMAGE_RESAMPLER_SSE2) && (defined(_MSC_VER) || defined(__GNUC__))
+#define IMAGE_RESAMPLER_AVX2
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define IMAGE_RESAMPLER_TARGET_AVX2
+#else
+#define IMAGE_RESAMPLER_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+/*
+Resizes 8-bit BGR or BGRA pixels (GDI+'s 24 and 32 bits per pixel formats)
+with a separable box, bicubic or Lanczos filter: each row is resampled
+horizontally, then the columns of those rows vertically.
+
+The filter weights are 14-bit fixed point and the sums 32-bit integers, so
+the result doesn't depend on the order they are added in: the SSE2 and AVX2
+kernels give exactly the bytes the plain C++ ones do, which is how
+utilities\ImageResamplerCheck tests them. AVX2 is used when the processor has
+it; SSE2 when the compiler targets it.
+
+The destination is produced in bands of rows, one per core, and each band in
+tiles of rows whose horizontally resampled source rows fit in the cache, so
+the intermediate image is never held in full. When shrinking by more than
+IMAGE_RESAMPLER_REDUCE_GAP times, the source is first averaged over whole
+blocks of pixels (as it is read, a tile at a time) until the filter has to
+shrink it by less than that; the difference from filtering the full image is
+at most a level or two.
+
+Premultiplied BGRA filters correctly; straight alpha would need to be
+premultiplied first.
+*/
+
+enum ImageResampleFilter
+{
+	IMAGE_RESAMPLE_BOX = 0,
+	IMAGE_RESAMPLE_BICUBIC = 1,
+	IMAGE_RESAMPLE_LANCZOS = 2
+} ;
+
+// the instructions used, for comparing them
+enum ImageResampleKernels
+{
+	IMAGE_RESAMPLE_BEST_KERNELS = 0,
+	IMAGE_RESAMPLE_SCALAR_KERNELS = 1,
+	IMAGE_RESAMPLE_SSE2_KERNELS = 2,
+	IMAGE_RESAMPLE_AVX2_KERNELS = 3
+} ;
+
+struct ImageResampleOptions
+{
+	ImageResampleOptions()
+		: threads( 0 ), kernels( IMAGE_RESAMPLE_BEST_KERNELS ), preshrink( true )
+	{
+	}
+
+	int threads ;						// 0 for one per core
+	ImageResampleKernels kernels ;		// downgraded to what the processor has
+	bool preshrink ;
+} ;
+
+// bits of fraction in the filter weights
+const int IMAGE_RESAMPLER_PRECISION = 14 ;
+
+// how many times larger than the destination a box pre-shrink leaves the source
+const int IMAGE_RESAMPLER_REDUCE_GAP = 2 ;
+
+// roughly how many bytes of horizontally resampled rows a tile works on
+const size_t IMAGE_RESAMPLER_TILE_BYTES = 256 * 1024 ;
+
+// the rows of destination a thread is worth starting for
+const int IMAGE_RESAMPLER_MIN_BAND_ROWS = 32 ;
+
+/*
+The source pixels each destination pixel along one axis is made of: for x,
+counts[x] pixels from starts[x], weighted by weights[x * stride] onwards. The
+vector kernels take the weights two at a time, from pairs[x * pairStride].
+*/
+struct ImageResampleTaps
+{
+	std::vector<int> starts ;
+	std::vector<int> counts ;
+	std::vector<int16_t> weights ;
+	int stride ;
+	std::vector<int32_t> pairs ;
+	int pairStride ;
+} ;
+
+class ImageResampler
+{
+public:
+	/*
+	Resizes source into destination, which have channels (3 or 4) bytes per
+	pixel and don't overlap; the strides may be negative for bottom-up
+	bitmaps. Returns false if the arguments don't make sense. Throws
+	std::bad_alloc if the buffers can't be allocated.
+	*/
+	static bool Resample(
+		const uint8_t* source, int sourceWidth, int sourceHeight, ptrdiff_t sourceStride,
+		uint8_t* destination, int destinationWidth, int destinationHeight, ptrdiff_t destinationStride,
+		int channels, ImageResampleFilter filter, const ImageResampleOptions& options = ImageResampleOptions() )
+	{
+		if ( source == NULL || destination == NULL || (channels != 3 && channels != 4)
+			|| sourceWidth <= 0 || sourceHeight <= 0 || destinationWidth <= 0 || destinationHeight <= 0
+			|| filter < IMAGE_RESAMPLE_BOX || filter > IMAGE_RESAMPLE_LANCZOS )
+			return false ;
+		if ( Abs( sourceStride ) < (ptrdiff_t)sourceWidth * channels || Abs( destinationStride ) < (ptrdiff_t)destinationWidth * channels )
+			return false ;
+
+		ImageResampler resampler( source, sourceWidth, sourceHeight, sourceStride, destination, destinationWidth, destinationHeight, destinationStride, channels ) ;
+		resampler.m_kernels = ChooseKernels( options.kernels ) ;
+		resampler.Plan( filter, options ) ;
+		resampler.Run( options.threads ) ;
+		return true ;
+	}
+
+	/*
+	The taps resampling inSize pixels, covering inExtent of them (less than
+	inSize when the last of a pre-shrink's blocks is partial), to outSize.
+	*/
+	static void ComputeTaps( int inSize, double inExtent, int outSize, ImageResampleFilter filter, ImageResampleTaps* taps )
+	{
+		double scale = inExtent / outSize ;
+		double filterScale = (std::max)( scale, 1.0 ) ;
+		double support = Support( filter ) * filterScale ;
+
+		taps->stride = (int)ceil( support ) * 2 + 1 ;
+		taps->starts.assign( outSize, 0 ) ;
+		taps->counts.assign( outSize, 0 ) ;
+		taps->weights.assign( (size_t)outSize * taps->stride, 0 ) ;
+
+		std::vector<double> weights( taps->stride ) ;
+		for ( int x = 0; x < outSize; x++ )
+		{
+			double center = (x + 0.5) * scale ;
+			int first = (std::max)( (int)(center - support + 0.5), 0 ) ;
+			int last = (std::min)( (int)(center + support + 0.5), inSize ) ;
+			int count = (std::min)( last - first, taps->stride ) ;
+
+			double total = 0 ;
+			for ( int k = 0; k < count; k++ )
+			{
+				weights[k] = Filter( filter, (first + k + 0.5 - center) / filterScale ) ;
+				total += weights[k] ;
+			}
+			if ( count <= 0 || total == 0 )
+			{
+				// nothing under the filter (a box narrower than a pixel); take the nearest
+				first = (std::min)( (std::max)( (int)center, 0 ), inSize - 1 ) ;
+				count = 1 ;
+				weights[0] = total = 1 ;
+			}
+
+			// quantize, putting the rounding error on the largest weight so they sum to one
+			int16_t* quantized = &taps->weights[(size_t)x * taps->stride] ;
+			int sum = 0, largest = 0 ;
+			for ( int k = 0; k < count; k++ )
+			{
+				quantized[k] = (int16_t)floor( weights[k] / total * (1 << IMAGE_RESAMPLER_PRECISION) + 0.5 ) ;
+				sum += quantized[k] ;
+				if ( quantized[k] > quantized[largest] )
+					largest = k ;
+			}
+			quantized[largest] = (int16_t)(quantized[largest] + (1 << IMAGE_RESAMPLER_PRECISION) - sum) ;
+
+			// drop the taps that came out zero at either end (all but one, at scale 1)
+			int skip = 0 ;
+			while ( count > 1 && quantized[skip] == 0 )
+				skip++, count-- ;
+			while ( count > 1 && quantized[skip + count - 1] == 0 )
+				count-- ;
+			memmove( quantized, quantized + skip, count * sizeof(int16_t) ) ;
+			memset( quantized + count, 0, (taps->stride - count) * sizeof(int16_t) ) ;
+
+			taps->starts[x] = first + skip ;
+			taps->counts[x] = count ;
+		}
+
+		taps->pairStride = (taps->stride + 1) / 2 ;
+		taps->pairs.assign( (size_t)outSize * taps->pairStride, 0 ) ;
+		for ( int x = 0; x < outSize; x++ )
+		{
+			const int16_t* weights = &taps->weights[(size_t)x * taps->stride] ;
+			for ( int k = 0; k < taps->counts[x]; k += 2 )
+				taps->pairs[(size_t)x * taps->pairStride + k / 2] = WeightPair( weights[k], k + 1 < taps->counts[x] ? weights[k + 1] : 0 ) ;
+		}
+	}
+
+	// two weights side by side, for _mm_madd_epi16 on pairs of pixels
+	static int32_t WeightPair( int16_t first, int16_t second )
+	{
+		return (int32_t)((uint16_t)first | ((uint32_t)(uint16_t)second << 16)) ;
+	}
+
+	// The factor a pre-shrink divides inSize by on the way to outSize.
+	static int ReduceFactor( int inSize, int outSize )
+	{
+		// the sums of a block's rows are 16 bits
+		return (std::min)( (std::max)( inSize / (outSize * IMAGE_RESAMPLER_REDUCE_GAP), 1 ), 256 ) ;
+	}
+
+	static double Support( ImageResampleFilter filter )
+	{
+		switch ( filter )
+		{
+		case IMAGE_RESAMPLE_BOX:
+			return 0.5 ;
+		case IMAGE_RESAMPLE_BICUBIC:
+			return 2 ;
+		default:
+			return 3 ;
+		}
+	}
+
+	static double Filter( ImageResampleFilter filter, double x )
+	{
+		switch ( filter )
+		{
+		case IMAGE_RESAMPLE_BOX:
+			return x >= -0.5 && x < 0.5 ? 1.0 : 0.0 ;
+		case IMAGE_RESAMPLE_BICUBIC:
+			{
+				// Keys' cubic with a = -0.5, as GDI+'s bicubic
+				const double a = -0.5 ;
+				x = fabs( x ) ;
+				if ( x < 1 )
+					return ((a + 2) * x - (a + 3)) * x * x + 1 ;
+				if ( x < 2 )
+					return (((x - 5) * x + 8) * x - 4) * a ;
+				return 0 ;
+			}
+		default:
+			return x > -3 && x < 3 ? Sinc( x ) * Sinc( x / 3 ) : 0 ;
+		}
+	}
+
+	// What kernels asks for, or the best the processor has if that's less.
+	static ImageResampleKernels ChooseKernels( ImageResampleKernels kernels )
+	{
+		ImageResampleKernels best = IMAGE_RESAMPLE_SCALAR_KERNELS ;
+#ifdef IMAGE_RESAMPLER_SSE2
+		best = HasAvx2() ? IMAGE_RESAMPLE_AVX2_KERNELS : IMAGE_RESAMPLE_SSE2_KERNELS ;
+#endif
+		if ( kernels == IMAGE_RESAMPLE_BEST_KERNELS || kernels > best )
+			return best ;
+		return kernels ;
+	}
+
+private:
+	struct Band
+	{
+		int first ;
+		int end ;
+		int maxRows ;		// the most intermediate rows a tile of the band needs
+	} ;
+
+	ImageResampler(
+		const uint8_t* source, int sourceWidth, int sourceHeight, ptrdiff_t sourceStride,
+		uint8_t* destination, int destinationWidth, int destinationHeight, ptrdiff_t destinationStride,
+		int channels )
+		: m_source( source ), m_sourceWidth( sourceWidth ), m_sourceHeight( sourceHeight ), m_sourceStride( sourceStride ),
+		m_destination( destination ), m_destinationWidth( destinationWidth ), m_destinationHeight( destinationHeight ), m_destinationStride( destinationStride ),
+		m_channels( channels ), m_reduceX( 1 ), m_reduceY( 1 ), m_tileRows( 1 ), m_kernels( IMAGE_RESAMPLE_SCALAR_KERNELS )
+	{
+	}
+
+	static ptrdiff_t Abs( ptrdiff_t value )
+	{
+		return value < 0 ? -value : value ;
+	}
+
+	static double Sinc( double x )
+	{
+		if ( x == 0 )
+			return 1 ;
+		x *= 3.14159265358979323846 ;
+		return sin( x ) / x ;
+	}
+
+	void Plan( ImageResampleFilter filter, const ImageResampleOptions& options )
+	{
+		if ( options.preshrink )
+		{
+			m_reduceX = ReduceFactor( m_sourceWidth, m_destinationWidth ) ;
+			m_reduceY = ReduceFactor( m_sourceHeight, m_destinationHeight ) ;
+		}
+
+		int reducedWidth = (m_sourceWidth + m_reduceX - 1) / m_reduceX ;
+		int reducedHeight = (m_sourceHeight + m_reduceY - 1) / m_reduceY ;
+		ComputeTaps( reducedWidth, (double)m_sourceWidth / m_reduceX, m_destinationWidth, filter, &m_tapsX ) ;
+		ComputeTaps( reducedHeight, (double)m_sourceHeight / m_reduceY, m_destinationHeight, filter, &m_tapsY ) ;
+
+		// tiles of about IMAGE_RESAMPLER_TILE_BYTES of intermediate rows
+		size_t rowBytes = (size_t)m_destinationWidth * m_channels ;
+		double rowsPerRow = (std::max)( (double)reducedHeight / m_destinationHeight, 1.0 ) ;
+		double tileRows = (IMAGE_RESAMPLER_TILE_BYTES / (double)rowBytes - m_tapsY.stride) / rowsPerRow ;
+		m_tileRows = (std::max)( (int)(std::min)( tileRows, (double)m_destinationHeight ), 8 ) ;
+	}
+
+	void Run( int threads )
+	{
+		if ( threads <= 0 )
+			threads = (std::max)( (int)std::thread::hardware_concurrency(), 1 ) ;
+		int bandCount = (std::max)( (std::min)( threads, m_destinationHeight / IMAGE_RESAMPLER_MIN_BAND_ROWS ), 1 ) ;
+
+		// everything is allocated here, so the threads can't fail
+		std::vector<Band> bands( bandCount ) ;
+		std::vector< std::vector<uint8_t> > intermediates( bandCount ) ;
+		std::vector< std::vector<uint8_t> > reducedRows( bandCount ) ;
+		std::vector< std::vector<uint16_t> > blockSums( bandCount ) ;
+		size_t rowBytes = (size_t)m_destinationWidth * m_channels ;
+		for ( int i = 0; i < bandCount; i++ )
+		{
+			Band& band = bands[i] ;
+			band.first = (int)((int64_t)m_destinationHeight * i / bandCount) ;
+			band.end = (int)((int64_t)m_destinationHeight * (i + 1) / bandCount) ;
+			band.maxRows = 0 ;
+			for ( int y = band.first; y < band.end; y += m_tileRows )
+			{
+				int first, end ;
+				TileRows( y, (std::min)( y + m_tileRows, band.end ), &first, &end ) ;
+				band.maxRows = (std::max)( band.maxRows, end - first ) ;
+			}
+
+			intermediates[i].resize( band.maxRows * rowBytes ) ;
+			if ( m_reduceX > 1 || m_reduceY > 1 )
+			{
+				reducedRows[i].resize( (size_t)ReducedWidth() * m_channels ) ;
+				blockSums[i].resize( (size_t)m_sourceWidth * m_channels ) ;
+			}
+		}
+
+		std::vector<std::thread> workers ;
+		workers.reserve( bandCount ) ;
+		int started = 1 ;
+		try
+		{
+			for ( ; started < bandCount; started++ )
+				workers.push_back( std::thread( &ImageResampler::RunBand, this, bands[started], &intermediates[started][0], reducedRows[started].empty() ? NULL : &reducedRows[started][0], blockSums[started].empty() ? NULL : &blockSums[started][0] ) ) ;
+		}
+		catch ( ... )
+		{
+			// no more threads to be had; the rest of the bands are done here
+		}
+
+		for ( int i = 0; i < bandCount; i++ )
+		{
+			if ( i == 0 || i >= started )
+				RunBand( bands[i], &intermediates[i][0], reducedRows[i].empty() ? NULL : &reducedRows[i][0], blockSums[i].empty() ? NULL : &blockSums[i][0] ) ;
+		}
+		for ( size_t i = 0; i < workers.size(); i++ )
+			workers[i].join() ;
+	}
+
+	int ReducedWidth() const
+	{
+		return (m_sourceWidth + m_reduceX - 1) / m_reduceX ;
+	}
+
+	// The intermediate rows the destination rows from first up to end are made of.
+	void TileRows( int first, int end, int* firstRow, int* endRow ) const
+	{
+		*firstRow = INT32_MAX ;
+		*endRow = 0 ;
+		for ( int y = first; y < end; y++ )
+		{
+			*firstRow = (std::min)( *firstRow, m_tapsY.starts[y] ) ;
+			*endRow = (std::max)( *endRow, m_tapsY.starts[y] + m_tapsY.counts[y] ) ;
+		}
+	}
+
+	void RunBand( Band band, uint8_t* intermediate, uint8_t* reducedRow, uint16_t* blockSums )
+	{
+		size_t rowBytes = (size_t)m_destinationWidth * m_channels ;
+		const uint8_t* rows[64] ;
+		std::vector<const uint8_t*> moreRows ;
+		const uint8_t** rowPointers = rows ;
+		if ( m_tapsY.stride > 64 )
+		{
+			moreRows.resize( m_tapsY.stride ) ;
+			rowPointers = &moreRows[0] ;
+		}
+
+		for ( int tile = band.first; tile < band.end; tile += m_tileRows )
+		{
+			int tileEnd = (std::min)( tile + m_tileRows, band.end ) ;
+			int firstRow, endRow ;
+			TileRows( tile, tileEnd, &firstRow, &endRow ) ;
+
+			for ( int row = firstRow; row < endRow; row++ )
+			{
+				const uint8_t* sourceRow = m_source + row * m_sourceStride ;
+				if ( reducedRow != NULL )
+				{
+					ReduceRow( row, reducedRow, blockSums ) ;
+					sourceRow = reducedRow ;
+				}
+				ResampleRow( sourceRow, intermediate + (row - firstRow) * rowBytes ) ;
+			}
+
+			for ( int y = tile; y < tileEnd; y++ )
+			{
+				for ( int k = 0; k < m_tapsY.counts[y]; k++ )
+					rowPointers[k] = intermediate + (m_tapsY.starts[y] + k - firstRow) * rowBytes ;
+				ResampleColumns( rowPointers, m_tapsY.counts[y], &m_tapsY.weights[(size_t)y * m_tapsY.stride], &m_tapsY.pairs[(size_t)y * m_tapsY.pairStride], m_destination + y * m_destinationStride, (int)rowBytes ) ;
+			}
+		}
+	}
+
+	// Averages the blocks of source pixels that make up a row of the pre-shrunk image.
+	void ReduceRow( int row, uint8_t* reducedRow, uint16_t* blockSums ) const
+	{
+		int first = row * m_reduceY ;
+		int end = (std::min)( first + m_reduceY, m_sourceHeight ) ;
+		int bytes = m_sourceWidth * m_channels ;
+
+		memset( blockSums, 0, bytes * sizeof(uint16_t) ) ;
+		for ( int y = first; y < end; y++ )
+		{
+			const uint8_t* source = m_source + y * m_sourceStride ;
+			int i = 0 ;
+#ifdef IMAGE_RESAMPLER_SSE2
+			if ( m_kernels != IMAGE_RESAMPLE_SCALAR_KERNELS )
+			{
+				const __m128i zero = _mm_setzero_si128() ;
+				for ( ; i + 16 <= bytes; i += 16 )
+				{
+					__m128i pixels = _mm_loadu_si128( reinterpret_cast<const __m128i*>(source + i) ) ;
+					__m128i* sums = reinterpret_cast<__m128i*>(blockSums + i) ;
+					_mm_storeu_si128( sums, _mm_add_epi16( _mm_loadu_si128( sums ), _mm_unpacklo_epi8( pixels, zero ) ) ) ;
+					_mm_storeu_si128( sums + 1, _mm_add_epi16( _mm_loadu_si128( sums + 1 ), _mm_unpackhi_epi8( pixels, zero ) ) ) ;
+				}
+			}
+#endif
+			for ( ; i < bytes; i++ )
+				blockSums[i] = (uint16_t)(blockSums[i] + source[i]) ;
+		}
+
+		int reducedWidth = ReducedWidth() ;
+		for ( int x = 0; x < reducedWidth; x++ )
+		{
+			int firstColumn = x * m_reduceX ;
+			int endColumn = (std::min)( firstColumn + m_reduceX, m_sourceWidth ) ;
+			uint32_t pixels = (uint32_t)((endColumn - firstColumn) * (end - first)) ;
+			for ( int c = 0; c < m_channels; c++ )
+			{
+				uint32_t sum = 0 ;
+				for ( int column = firstColumn; column < endColumn; column++ )
+					sum += blockSums[column * m_channels + c] ;
+				reducedRow[x * m_channels + c] = (uint8_t)((sum + pixels / 2) / pixels) ;
+			}
+		}
+	}
+
+	void ResampleRow( const uint8_t* source, uint8_t* destination ) const
+	{
+		if ( m_channels == 3 )
+			ResampleRow<3>( source, destination ) ;
+		else
+			ResampleRow<4>( source, destination ) ;
+	}
+
+	template <int CHANNELS>
+	void ResampleRow( const uint8_t* source, uint8_t* destination ) const
+	{
+		switch ( m_kernels )
+		{
+#ifdef IMAGE_RESAMPLER_AVX2
+		case IMAGE_RESAMPLE_AVX2_KERNELS:
+			ResampleRowAvx2<CHANNELS>( m_tapsX, m_destinationWidth, source, destination ) ;
+			break ;
+#endif
+#ifdef IMAGE_RESAMPLER_SSE2
+		case IMAGE_RESAMPLE_SSE2_KERNELS:
+			ResampleRowSse2<CHANNELS>( m_tapsX, m_destinationWidth, source, destination ) ;
+			break ;
+#endif
+		default:
+			ResampleRowScalar<CHANNELS>( m_tapsX, m_destinationWidth, source, destination ) ;
+			break ;
+		}
+	}
+
+	void ResampleColumns( const uint8_t* const* rows, int count, const int16_t* weights, const int32_t* pairs, uint8_t* destination, int bytes ) const
+	{
+		int i = 0 ;
+		switch ( m_kernels )
+		{
+#ifdef IMAGE_RESAMPLER_AVX2
+		case IMAGE_RESAMPLE_AVX2_KERNELS:
+			i = ResampleColumnsAvx2( rows, count, pairs, destination, bytes ) ;
+			i = ResampleColumnsSse2( rows, count, pairs, destination, i, bytes ) ;
+			break ;
+#endif
+#ifdef IMAGE_RESAMPLER_SSE2
+		case IMAGE_RESAMPLE_SSE2_KERNELS:
+			i = ResampleColumnsSse2( rows, count, pairs, destination, 0, bytes ) ;
+			break ;
+#endif
+		default:
+			break ;
+		}
+		ResampleColumnsScalar( rows, count, weights, destination, i, bytes ) ;
+	}
+
+	static uint8_t Clamp( int32_t sum )
+	{
+		sum >>= IMAGE_RESAMPLER_PRECISION ;
+		return (uint8_t)(sum < 0 ? 0 : sum > 255 ? 255 : sum) ;
+	}
+
+	template <int CHANNELS>
+	static void ResampleRowScalar( const ImageResampleTaps& taps, int width, const uint8_t* source, uint8_t* destination )
+	{
+		for ( int x = 0; x < width; x++ )
+		{
+			const uint8_t* pixels = source + taps.starts[x] * CHANNELS ;
+			const int16_t* weights = &taps.weights[(size_t)x * taps.stride] ;
+			int count = taps.counts[x] ;
+			for ( int c = 0; c < CHANNELS; c++ )
+			{
+				int32_t sum = 1 << (IMAGE_RESAMPLER_PRECISION - 1) ;
+				for ( int k = 0; k < count; k++ )
+					sum += pixels[k * CHANNELS + c] * weights[k] ;
+				destination[x * CHANNELS + c] = Clamp( sum ) ;
+			}
+		}
+	}
+
+	static void ResampleColumnsScalar( const uint8_t* const* rows, int count, const int16_t* weights, uint8_t* destination, int i, int bytes )
+	{
+		for ( ; i < bytes; i++ )
+		{
+			int32_t sum = 1 << (IMAGE_RESAMPLER_PRECISION - 1) ;
+			for ( int k = 0; k < count; k++ )
+				sum += rows[k][i] * weights[k] ;
+			destination[i] = Clamp( sum ) ;
+		}
+	}
+
+#ifdef IMAGE_RESAMPLER_SSE2
+	template <int CHANNELS>
+	static __m128i LoadPixel( const uint8_t* pixel )
+	{
+		// three bytes are put together in a register; copying them to memory
+		// and reading back four would stall every load
+		int32_t value ;
+		if ( CHANNELS == 4 )
+			memcpy( &value, pixel, 4 ) ;
+		else
+			value = pixel[0] | (pixel[1] << 8) | (pixel[2] << 16) ;
+		return _mm_cvtsi32_si128( value ) ;
+	}
+
+	template <int CHANNELS>
+	static void StorePixel( __m128i sums, uint8_t* destination )
+	{
+		__m128i words = _mm_packs_epi32( _mm_srai_epi32( sums, IMAGE_RESAMPLER_PRECISION ), _mm_setzero_si128() ) ;
+		int32_t value = _mm_cvtsi128_si32( _mm_packus_epi16( words, words ) ) ;
+		memcpy( destination, &value, CHANNELS ) ;
+	}
+
+	// Adds the pixels from k on to sums, two at a time (the channels of both side by side).
+	template <int CHANNELS>
+	static __m128i AddTapPairs( __m128i sums, const uint8_t* pixels, const int32_t* pairs, int k, int count )
+	{
+		const __m128i zero = _mm_setzero_si128() ;
+		for ( ; k + 2 <= count; k += 2 )
+		{
+			__m128i pair = _mm_unpacklo_epi8( LoadPixel<CHANNELS>( pixels + k * CHANNELS ), LoadPixel<CHANNELS>( pixels + (k + 1) * CHANNELS ) ) ;
+			sums = _mm_add_epi32( sums, _mm_madd_epi16( _mm_unpacklo_epi8( pair, zero ), _mm_set1_epi32( pairs[k / 2] ) ) ) ;
+		}
+		if ( k < count )
+		{
+			// the pair's second weight is 0
+			__m128i single = _mm_unpacklo_epi8( LoadPixel<CHANNELS>( pixels + k * CHANNELS ), zero ) ;
+			sums = _mm_add_epi32( sums, _mm_madd_epi16( _mm_unpacklo_epi8( single, zero ), _mm_set1_epi32( pairs[k / 2] ) ) ) ;
+		}
+		return sums ;
+	}
+
+	template <int CHANNELS>
+	static void ResampleRowSse2( const ImageResampleTaps& taps, int width, const uint8_t* source, uint8_t* destination )
+	{
+		const __m128i half = _mm_set1_epi32( 1 << (IMAGE_RESAMPLER_PRECISION - 1) ) ;
+		for ( int x = 0; x < width; x++ )
+		{
+			__m128i sums = AddTapPairs<CHANNELS>( half, source + taps.starts[x] * CHANNELS, &taps.pairs[(size_t)x * taps.pairStride], 0, taps.counts[x] ) ;
+			StorePixel<CHANNELS>( sums, destination + x * CHANNELS ) ;
+		}
+	}
+
+	// Resamples bytes from i, sixteen at a time, returning where it stopped.
+	static int ResampleColumnsSse2( const uint8_t* const* rows, int count, const int32_t* pairs, uint8_t* destination, int i, int bytes )
+	{
+		const __m128i zero = _mm_setzero_si128() ;
+		const __m128i half = _mm_set1_epi32( 1 << (IMAGE_RESAMPLER_PRECISION - 1) ) ;
+		for ( ; i + 16 <= bytes; i += 16 )
+		{
+			__m128i sums0 = half, sums1 = half, sums2 = half, sums3 = half ;
+			for ( int k = 0; k < count; k += 2 )
+			{
+				// an odd row out is paired with zeros
+				bool pair = k + 1 < count ;
+				__m128i first = _mm_loadu_si128( reinterpret_cast<const __m128i*>(rows[k] + i) ) ;
+				__m128i second = pair ? _mm_loadu_si128( reinterpret_cast<const __m128i*>(rows[k + 1] + i) ) : zero ;
+				__m128i weightPair = _mm_set1_epi32( pairs[k / 2] ) ;
+
+				__m128i low = _mm_unpacklo_epi8( first, second ) ;
+				__m128i high = _mm_unpackhi_epi8( first, second ) ;
+				sums0 = _mm_add_epi32( sums0, _mm_madd_epi16( _mm_unpacklo_epi8( low, zero ), weightPair ) ) ;
+				sums1 = _mm_add_epi32( sums1, _mm_madd_epi16( _mm_unpackhi_epi8( low, zero ), weightPair ) ) ;
+				sums2 = _mm_add_epi32( sums2, _mm_madd_epi16( _mm_unpacklo_epi8( high, zero ), weightPair ) ) ;
+				sums3 = _mm_add_epi32( sums3, _mm_madd_epi16( _mm_unpackhi_epi8( high, zero ), weightPair ) ) ;
+			}
+
+			__m128i low = _mm_packs_epi32( _mm_srai_epi32( sums0, IMAGE_RESAMPLER_PRECISION ), _mm_srai_epi32( sums1, IMAGE_RESAMPLER_PRECISION ) ) ;
+			__m128i high = _mm_packs_epi32( _mm_srai_epi32( sums2, IMAGE_RESAMPLER_PRECISION ), _mm_srai_epi32( sums3, IMAGE_RESAMPLER_PRECISION ) ) ;
+			_mm_storeu_si128( reinterpret_cast<__m128i*>(destination + i), _mm_packus_epi16( low, high ) ) ;
+		}
+		return i ;
+	}
+#endif
+
+#ifdef IMAGE_RESAMPLER_AVX2
+	static bool HasAvx2()
+	{
+#ifdef _MSC_VER
+		int info[4] ;
+		__cpuid( info, 0 ) ;
+		if ( info[0] < 7 )
+			return false ;
+		__cpuid( info, 1 ) ;
+		bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (_xgetbv( 0 ) & 6) == 6 ;
+		__cpuidex( info, 7, 0 ) ;
+		return osSavesYmm && (info[1] & (1 << 5)) != 0 ;
+#else
+		return __builtin_cpu_supports( "avx2" ) != 0 ;
+#endif
+	}
+
+	// Like ResampleRowSse2, four taps at a time.
+	template <int CHANNELS>
+	IMAGE_RESAMPLER_TARGET_AVX2 static void ResampleRowAvx2( const ImageResampleTaps& taps, int width, const uint8_t* source, uint8_t* destination )
+	{
+		const __m128i half = _mm_set1_epi32( 1 << (IMAGE_RESAMPLER_PRECISION - 1) ) ;
+		const __m256i spread = _mm256_setr_epi32( 0, 0, 0, 0, 1, 1, 1, 1 ) ;
+		for ( int x = 0; x < width; x++ )
+		{
+			const uint8_t* pixels = source + taps.starts[x] * CHANNELS ;
+			const int32_t* pairs = &taps.pairs[(size_t)x * taps.pairStride] ;
+			int count = taps.counts[x] ;
+
+			__m256i wideSums = _mm256_setzero_si256() ;
+			int k = 0 ;
+			for ( ; k + 4 <= count; k += 4 )
+			{
+				__m128i pair0 = _mm_unpacklo_epi8( LoadPixel<CHANNELS>( pixels + k * CHANNELS ), LoadPixel<CHANNELS>( pixels + (k + 1) * CHANNELS ) ) ;
+				__m128i pair1 = _mm_unpacklo_epi8( LoadPixel<CHANNELS>( pixels + (k + 2) * CHANNELS ), LoadPixel<CHANNELS>( pixels + (k + 3) * CHANNELS ) ) ;
+				__m256i words = _mm256_cvtepu8_epi16( _mm_unpacklo_epi64( pair0, pair1 ) ) ;
+				__m128i twoPairs = _mm_loadl_epi64( reinterpret_cast<const __m128i*>(pairs + k / 2) ) ;
+				__m256i weightPairs = _mm256_permutevar8x32_epi32( _mm256_castsi128_si256( twoPairs ), spread ) ;
+				wideSums = _mm256_add_epi32( wideSums, _mm256_madd_epi16( words, weightPairs ) ) ;
+			}
+
+			__m128i sums = _mm_add_epi32( _mm256_castsi256_si128( wideSums ), _mm256_extracti128_si256( wideSums, 1 ) ) ;
+			sums = AddTapPairs<CHANNELS>( _mm_add_epi32( sums, half ), pixels, pairs, k, count ) ;
+			StorePixel<CHANNELS>( sums, destination + x * CHANNELS ) ;
+		}
+	}
+
+	// Like ResampleColumnsSse2, thirty-two bytes at a time; the unpacks work
+	// within each half, and so do the packs that put the bytes back in order.
+	IMAGE_RESAMPLER_TARGET_AVX2 static int ResampleColumnsAvx2( const uint8_t* const* rows, int count, const int32_t* pairs, uint8_t* destination, int bytes )
+	{
+		const __m256i zero = _mm256_setzero_si256() ;
+		const __m256i half = _mm256_set1_epi32( 1 << (IMAGE_RESAMPLER_PRECISION - 1) ) ;
+		int i = 0 ;
+		for ( ; i + 32 <= bytes; i += 32 )
+		{
+			__m256i sums0 = half, sums1 = half, sums2 = half, sums3 = half ;
+			for ( int k = 0; k < count; k += 2 )
+			{
+				bool pair = k + 1 < count ;
+				__m256i first = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(rows[k] + i) ) ;
+				__m256i second = pair ? _mm256_loadu_si256( reinterpret_cast<const __m256i*>(rows[k + 1] + i) ) : zero ;
+				__m256i weightPair = _mm256_set1_epi32( pairs[k / 2] ) ;
+
+				__m256i low = _mm256_unpacklo_epi8( first, second ) ;
+				__m256i high = _mm256_unpackhi_epi8( first, second ) ;
+				sums0 = _mm256_add_epi32( sums0, _mm256_madd_epi16( _mm256_unpacklo_epi8( low, zero ), weightPair ) ) ;
+				sums1 = _mm256_add_epi32( sums1, _mm256_madd_epi16( _mm256_unpackhi_epi8( low, zero ), weightPair ) ) ;
+				sums2 = _mm256_add_epi32( sums2, _mm256_madd_epi16( _mm256_unpacklo_epi8( high, zero ), weightPair ) ) ;
+				sums3 = _mm256_add_epi32( sums3, _mm256_madd_epi16( _mm256_unpackhi_epi8( high, zero ), weightPair ) ) ;
+			}
+
+			__m256i low = _mm256_packs_epi32( _mm256_srai_epi32( sums0, IMAGE_RESAMPLER_PRECISION ), _mm256_srai_epi32( sums1, IMAGE_RESAMPLER_PRECISION ) ) ;
+			__m256i high = _mm256_packs_epi32( _mm256_srai_epi32( sums2, IMAGE_RESAMPLER_PRECISION ), _mm256_srai_epi32( sums3, IMAGE_RESAMPLER_PRECISION ) ) ;
+			_mm256_storeu_si256( reinterpret_cast<__m256i*>(destination + i), _mm256_packus_epi16( low, high ) ) ;
+		}
+		return i ;
+	}
+#elif defined(IMAGE_RESAMPLER_SSE2)
+	static bool HasAvx2()
+	{
+		return false ;
+	}
+#endif
+
+	const uint8_t* m_source ;
+	int m_sourceWidth ;
+	int m_sourceHeight ;
+	ptrdiff_t m_sourceStride ;
+	uint8_t* m_destination ;
+	int m_destinationWidth ;
+	int m_destinationHeight ;
+	ptrdiff_t m_destinationStride ;
+	int m_channels ;
+
+	int m_reduceX ;
+	int m_reduceY ;
+	ImageResampleTaps m_tapsX ;
+	ImageResampleTaps m_tapsY ;
+	int m_tileRows ;
+	ImageResampleKernels m_kernels ;
+} ;
@@ -5,12 +5,19 @@
 #pragma once
 
 #include "HResultException.h"
-
+#include "LogRecordFormat.h"
+#include "NativeTracepoints.h"
+
+/*
+Appends errors and failed asserts to <applicationName>.olwlog as binary
+records (see LogRecordFormat.h) rather than formatting CSV lines;
+utilities/LogFileDecoder prints them as the CSV lines they used to be.
+*/
 class LogFile
 {
 public:
 	LogFile(LPCTSTR applicationName, LPCSTR facility) 
-		: m_facility(facility)
+		: m_facility(facility), m_sessionWritten(FALSE)
 	{
 		try
 		{
@@ -36,7 +43,7 @@ public:
 			if ( SUCCEEDED(hr) )
 			{
 				// form the path to the log file
-				m_logFilePath.AppendFormat( _T("%s\\%s.log"), lpszAppDataPath, applicationName) ;
+				m_logFilePath.AppendFormat( _T("%s\\%s.olwlog"), lpszAppDataPath, applicationName) ;
 			}
 			else
 			{
@@ -53,16 +60,7 @@ public:
 	
 	__declspec(noinline) void LogAssertFailed( int sourceLine, LPCSTR lpszSourceFile, LPCSTR lpszTimestamp ) 
 	{
-		try
-		{
-			CStringA strError ;
-			strError.AppendFormat( "ASSERT Failed: Line %ld, %s (%s)", sourceLine, lpszSourceFile, lpszTimestamp ) ;
-			AppendEntry( "Error", strError ) ;
-		}
-		catch(...)
-		{
-			ATLASSERT(FALSE) ;
-		}
+		AppendEntry( LOG_RECORD_ASSERT, S_OK, sourceLine, lpszSourceFile, lpszTimestamp ) ;
 	}
 
 	void LogError( const HResultException& e )
@@ -72,22 +70,21 @@ public:
 
 	__declspec(noinline) void LogError( HRESULT hr, int sourceLine, LPCSTR lpszSourceFile, LPCSTR lpszTimestamp ) 
 	{
-		try
-		{
-			CStringA strError ;
-			strError.AppendFormat( "HRESULT %#08x: Line %ld, %s (%s)", hr, sourceLine, lpszSourceFile, lpszTimestamp ) ;
-			AppendEntry( "Error", strError ) ;
-		}
-		catch(...)
-		{
-			ATLASSERT(FALSE) ;
-		}
+		AppendEntry( LOG_RECORD_ERROR, hr, sourceLine, lpszSourceFile, lpszTimestamp ) ;
 	}
 	
 	
 
 private:
-	__declspec(noinline) void AppendEntry( LPCSTR lpszCategory, LPCSTR lpszMessage ) 
+	// a source location that has been logged from (file names are literals);
+	// its id is its index plus one
+	struct SourceLocation
+	{
+		int line ;
+		LPCSTR lpszSourceFile ;
+	} ;
+
+	__declspec(noinline) void AppendEntry( BYTE kind, HRESULT hr, int sourceLine, LPCSTR lpszSourceFile, LPCSTR lpszTimestamp ) 
 	{
 		// must have initialized to write an entry
 		if ( m_logFilePath.GetLength() == 0 )
@@ -99,38 +96,34 @@ private:
 		try
 		{
 			// get the current time
-			SYSTEMTIME currentTime ;
-			::GetSystemTime( &currentTime ) ;
-			currentTime.wDay ;
-
-			// calculate the log entry
-			CStringA strLogEntry ;
-			strLogEntry.AppendFormat( "%s,%lu,%s,%05ld,%02hu-%02hu-%4hu %02hu:%02hu:%02hu,\"%s\",\"\"\r\n",
-				m_facility,
-				::GetCurrentProcessId(),
-				lpszCategory,
-				::InterlockedIncrement( &s_dwSequenceNumber ),
-				currentTime.wMonth,
-				currentTime.wDay,
-				currentTime.wYear,
-				currentTime.wHour,
-				currentTime.wMinute,
-				currentTime.wSecond,
-				lpszMessage ) ;
+			FILETIME currentTime ;
+			::GetSystemTimeAsFileTime( &currentTime ) ;
+			LONG sequence = ::InterlockedIncrement( &s_dwSequenceNumber ) ;
+
+			// the session and location records must go before the entries that use them
+			CComCritSecLock<CComAutoCriticalSection> lock( m_lock ) ;
 
+			TRACEPOINT_START( "LogFileWrite",
+				TraceLoggingString( LogCategoryName( LOG_CATEGORY_ERROR ), "category" ) ) ;
 
 			// Try to write the message.  Incrementally back off, waiting for the file to 
 			// become available.  (The first backoff is 0ms intentionally -- to give up our 
 			// scheduling quantum -- allowing another thread to run. Subsequent backoffs 
 			// increase linearly at 10ms intervals with up to 10 retries)
-			for (int i = 0; i<10; i++)
+			DWORD dwBytesWritten = 0 ;
+			int i ;
+			for (i = 0; i<10; i++)
 			{
-				if ( DoAppendEntry( strLogEntry ) )			
+				if ( DoAppendEntry( kind, hr, sequence, currentTime, sourceLine, lpszSourceFile, lpszTimestamp, dwBytesWritten ) )
 					break;
 				
 				//	Sleep. Back off linearly, but not more than 2s.
 				::Sleep( min( i * 10, 2000 ) );
 			}					
+
+			TRACEPOINT_STOP( "LogFileWrite",
+				TraceLoggingUInt32( dwBytesWritten, "bytes" ),
+				TraceLoggingInt32( i, "retries" ) ) ;
 		}
 		catch(...)
 		{
@@ -139,33 +132,81 @@ private:
 		}
 	}
 
-	__declspec(noinline) BOOL DoAppendEntry( const CStringA& strLogEntry ) 
+	__declspec(noinline) BOOL DoAppendEntry( BYTE kind, HRESULT hr, LONG sequence, const FILETIME& time, int sourceLine, LPCSTR lpszSourceFile, LPCSTR lpszTimestamp, DWORD& dwBytesWritten ) 
 	{
 		// try to open the file		
 		CAtlFile logFile ;
-		HRESULT hr = logFile.Create( m_logFilePath, GENERIC_WRITE, FILE_SHARE_READ, OPEN_ALWAYS ) ;
-		if ( SUCCEEDED(hr) )
+		HRESULT hrOpen = logFile.Create( m_logFilePath, GENERIC_WRITE, FILE_SHARE_READ, OPEN_ALWAYS ) ;
+		if ( FAILED(hrOpen) )
+			return FALSE ;
+
+		ULONGLONG fileSize ;
+		if ( FAILED(logFile.GetSize( fileSize )) )
+			return FALSE ;
+
+		// a new (or deleted) log has none of our session or locations in it
+		m_record.Clear() ;
+		if ( fileSize == 0 )
 		{
-			DWORD dwBufferSize = strLogEntry.GetLength();
-			DWORD dwBytesWritten = 0 ;
-			if ( SUCCEEDED(logFile.Seek( 0, FILE_END )) )
-				logFile.Write( (const void*)strLogEntry, dwBufferSize, &dwBytesWritten ) ;
-			ATLASSERT( dwBufferSize == dwBytesWritten ) ;
-			
-			logFile.Flush() ;
-			logFile.Close() ;
+			m_record.AppendFileHeader() ;
+			m_sessionWritten = FALSE ;
+			m_locations.RemoveAll() ;
+		}
 
-			return TRUE ;
-		}	
-		else
+		DWORD pid = ::GetCurrentProcessId() ;
+		if ( !m_sessionWritten )
+			m_record.AppendSession( pid, m_facility ) ;
+
+		size_t location = FindLocation( sourceLine, lpszSourceFile ) ;
+		BOOL newLocation = location == m_locations.GetCount() ;
+		if ( newLocation )
+			m_record.AppendLocation( pid, (uint32_t)location + 1, sourceLine, lpszSourceFile, lpszTimestamp ) ;
+
+		ULONGLONG ticks = ((ULONGLONG)time.dwHighDateTime << 32) | time.dwLowDateTime ;
+		m_record.AppendEntry( kind, pid, sequence, ticks, LOG_CATEGORY_ERROR, (uint32_t)location + 1, hr ) ;
+
+		DWORD dwBufferSize = (DWORD)m_record.GetLength() ;
+		dwBytesWritten = 0 ;
+		if ( SUCCEEDED(logFile.Seek( 0, FILE_END )) )
+			logFile.Write( m_record.GetData(), dwBufferSize, &dwBytesWritten ) ;
+		ATLASSERT( dwBufferSize == dwBytesWritten ) ;
+		
+		logFile.Flush() ;
+		logFile.Close() ;
+
+		// only count what made it into the file as written, so that it is
+		// written again with the next entry if it didn't
+		if ( dwBytesWritten == dwBufferSize )
 		{
-			return FALSE ;
+			m_sessionWritten = TRUE ;
+			if ( newLocation )
+			{
+				SourceLocation added = { sourceLine, lpszSourceFile } ;
+				m_locations.Add( added ) ;
+			}
+		}
+		return TRUE ;
+	}
+
+	// the index of the location, or the number of locations if it hasn't been logged from
+	size_t FindLocation( int sourceLine, LPCSTR lpszSourceFile ) const
+	{
+		for ( size_t i = 0; i < m_locations.GetCount(); i++ )
+		{
+			const SourceLocation& location = m_locations[i] ;
+			if ( location.line == sourceLine && ( location.lpszSourceFile == lpszSourceFile || strcmp( location.lpszSourceFile, lpszSourceFile ) == 0 ) )
+				return i ;
 		}
+		return m_locations.GetCount() ;
 	}
 
 private:
 	CString m_logFilePath ;
 	CStringA m_facility ;
+	CComAutoCriticalSection m_lock ;
+	LogRecordBuffer m_record ;
+	BOOL m_sessionWritten ;
+	CAtlArray<SourceLocation> m_locations ;		// only ever a handful of call sites
 	volatile static LONG s_dwSequenceNumber ;
 } ;
 
@@ -175,6 +216,6 @@ extern LogFile *_LogFile ;
 #define LOGERROR(e) { ATLASSERT(FALSE); if (_LogFile) { _LogFile->LogError( e ); } }
 #define LOGERROR_HR(hr) { ATLASSERT(FALSE); if (_LogFile) { _LogFile->LogError( hr, __LINE__, __FILE__, __TIMESTAMP__ ); } }
 
-#define DECLARE_LOGFILE(applicationName, facility) LogFile *_LogFile = new LogFile(applicationName, facility); volatile LONG LogFile::s_dwSequenceNumber = 10000 ;
-#define DECLARE_NULL_LOGFILE LogFile *_LogFile = 0; volatile LONG LogFile::s_dwSequenceNumber = 10000 ;
+#define DECLARE_LOGFILE(applicationName, facility) LogFile *_LogFile = new LogFile(applicationName, facility); volatile LONG LogFile::s_dwSequenceNumber = 10000 ; DEFINE_TRACEPOINT_PROVIDER
+#define DECLARE_NULL_LOGFILE LogFile *_LogFile = 0; volatile LONG LogFile::s_dwSequenceNumber = 10000 ; DEFINE_TRACEPOINT_PROVIDER
 
@@ -0,0 +1,327 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+Layout of the log LogFile writes, which utilities/LogFileDecoder turns back
+into the CSV lines it used to write:
+
+	file:     LOG_RECORD_MAGIC and LOG_RECORD_VERSION, 4 bytes each
+	          records
+	record:   its length (not counting the length itself), its kind (a
+	          byte), then depending on the kind
+	            SESSION   pid, facility
+	            LOCATION  pid, location, line, file, timestamp
+	            ASSERT    pid, sequence, time, category, location
+	            ERROR     pid, sequence, time, category, location, hr
+
+Numbers are unsigned LEB128 varints, except time, which is the raw 8 byte
+FILETIME; strings are a varint length followed by that many bytes. All of it
+is little-endian.
+
+A process writes a SESSION record before its first entry and a LOCATION
+record the first time it logs from a source location, which gives the
+location a number for its entries to use. Both hold for that pid until its
+next SESSION record, so facilities and file names are written once rather
+than in every entry. Categories are a LogCategory.
+
+A reader skips kinds it doesn't know and stops at a record that runs past the
+end of the file, which is what a crash in the middle of a write leaves.
+*/
+
+const uint32_t LOG_RECORD_MAGIC = 0x4C574C4F ;	// "OLWL"
+const uint32_t LOG_RECORD_VERSION = 1 ;
+
+enum LogRecordKind
+{
+	LOG_RECORD_SESSION = 1,
+	LOG_RECORD_LOCATION,
+	LOG_RECORD_ASSERT,
+	LOG_RECORD_ERROR
+} ;
+
+enum LogCategory
+{
+	LOG_CATEGORY_ERROR = 1
+} ;
+
+inline const char* LogCategoryName( uint32_t category )
+{
+	switch ( category )
+	{
+		case LOG_CATEGORY_ERROR:
+			return "Error" ;
+		default:
+			return "Unknown" ;
+	}
+}
+
+// longer strings (file names, facilities) are cut short
+const size_t LOG_RECORD_MAX_STRING = 1024 ;
+
+// enough for a SESSION, a LOCATION and an entry, the most written at once
+const size_t LOG_RECORD_BUFFER_SIZE = 4096 ;
+
+/*
+Builds records in a fixed buffer, so that writing an entry neither formats
+nor allocates anything.
+*/
+class LogRecordBuffer
+{
+public:
+	LogRecordBuffer()
+		: m_length( 0 ), m_recordStart( 0 )
+	{
+	}
+
+	const uint8_t* GetData() const
+	{
+		return m_data ;
+	}
+
+	size_t GetLength() const
+	{
+		return m_length ;
+	}
+
+	void Clear()
+	{
+		m_length = 0 ;
+	}
+
+	void AppendFileHeader()
+	{
+		PutFixed( LOG_RECORD_MAGIC, 4 ) ;
+		PutFixed( LOG_RECORD_VERSION, 4 ) ;
+	}
+
+	void AppendSession( uint32_t pid, const char* facility )
+	{
+		BeginRecord( LOG_RECORD_SESSION ) ;
+		PutVarint( pid ) ;
+		PutString( facility ) ;
+		EndRecord() ;
+	}
+
+	void AppendLocation( uint32_t pid, uint32_t location, uint32_t line, const char* file, const char* timestamp )
+	{
+		BeginRecord( LOG_RECORD_LOCATION ) ;
+		PutVarint( pid ) ;
+		PutVarint( location ) ;
+		PutVarint( line ) ;
+		PutString( file ) ;
+		PutString( timestamp ) ;
+		EndRecord() ;
+	}
+
+	// kind is LOG_RECORD_ASSERT or LOG_RECORD_ERROR; hr is only written for errors
+	void AppendEntry( uint8_t kind, uint32_t pid, uint32_t sequence, uint64_t time, uint32_t category, uint32_t location, uint32_t hr )
+	{
+		BeginRecord( kind ) ;
+		PutVarint( pid ) ;
+		PutVarint( sequence ) ;
+		PutFixed( time, 8 ) ;
+		PutVarint( category ) ;
+		PutVarint( location ) ;
+		if ( kind == LOG_RECORD_ERROR )
+			PutVarint( hr ) ;
+		EndRecord() ;
+	}
+
+private:
+	// the length of a record is at most two bytes, written once the record is
+	void BeginRecord( uint8_t kind )
+	{
+		m_recordStart = m_length ;
+		m_length += 2 ;
+		m_data[m_length++] = kind ;
+	}
+
+	void EndRecord()
+	{
+		size_t length = m_length - m_recordStart - 2 ;
+		if ( length < 0x80 )
+		{
+			m_data[m_recordStart] = (uint8_t)length ;
+			memmove( m_data + m_recordStart + 1, m_data + m_recordStart + 2, length ) ;
+			m_length-- ;
+		}
+		else
+		{
+			m_data[m_recordStart] = (uint8_t)(length | 0x80) ;
+			m_data[m_recordStart + 1] = (uint8_t)(length >> 7) ;
+		}
+	}
+
+	void PutVarint( uint32_t value )
+	{
+		while ( value >= 0x80 )
+		{
+			m_data[m_length++] = (uint8_t)(value | 0x80) ;
+			value >>= 7 ;
+		}
+		m_data[m_length++] = (uint8_t)value ;
+	}
+
+	void PutFixed( uint64_t value, int bytes )
+	{
+		for ( int i = 0; i < bytes; i++ )
+			m_data[m_length++] = (uint8_t)(value >> (i * 8)) ;
+	}
+
+	void PutString( const char* value )
+	{
+		size_t length = value != NULL ? strlen( value ) : 0 ;
+		if ( length > LOG_RECORD_MAX_STRING )
+			length = LOG_RECORD_MAX_STRING ;
+		PutVarint( (uint32_t)length ) ;
+		if ( length > 0 )
+			memcpy( m_data + m_length, value, length ) ;
+		m_length += length ;
+	}
+
+	uint8_t m_data[LOG_RECORD_BUFFER_SIZE] ;
+	size_t m_length ;
+	size_t m_recordStart ;
+} ;
+
+// A record as LogRecordReader reads it; strings point into the log.
+struct LogRecord
+{
+	uint8_t kind ;
+	uint32_t pid ;
+	uint32_t sequence ;
+	uint64_t time ;
+	uint32_t category ;
+	uint32_t location ;
+	uint32_t line ;
+	uint32_t hr ;
+	const char* text[2] ;		// SESSION: facility; LOCATION: file, timestamp
+	uint32_t textLength[2] ;
+} ;
+
+class LogRecordReader
+{
+public:
+	LogRecordReader()
+		: m_data( NULL ), m_size( 0 ), m_offset( 0 )
+	{
+	}
+
+	// returns false if the size bytes at data don't start like a log
+	bool Open( const void* data, size_t size )
+	{
+		m_data = static_cast<const uint8_t*>( data ) ;
+		m_size = size ;
+		m_offset = 0 ;
+		uint64_t magic, version ;
+		return GetFixed( m_offset, m_size, 4, magic ) && magic == LOG_RECORD_MAGIC
+			&& GetFixed( m_offset, m_size, 4, version ) && version == LOG_RECORD_VERSION ;
+	}
+
+	/*
+	Reads the next record, returning false at the end of the log or at a
+	record that is cut short or damaged (IsComplete tells them apart).
+	*/
+	bool Next( LogRecord& record )
+	{
+		for ( ;; )
+		{
+			uint32_t length ;
+			size_t offset = m_offset ;
+			if ( !GetVarint( offset, m_size, length ) || length == 0 || length > m_size - offset )
+				return false ;
+			size_t end = offset + length ;
+
+			memset( &record, 0, sizeof(record) ) ;
+			record.kind = m_data[offset++] ;
+			bool read ;
+			switch ( record.kind )
+			{
+				case LOG_RECORD_SESSION:
+					read = GetVarint( offset, end, record.pid )
+						&& GetString( offset, end, record.text[0], record.textLength[0] ) ;
+					break ;
+				case LOG_RECORD_LOCATION:
+					read = GetVarint( offset, end, record.pid )
+						&& GetVarint( offset, end, record.location )
+						&& GetVarint( offset, end, record.line )
+						&& GetString( offset, end, record.text[0], record.textLength[0] )
+						&& GetString( offset, end, record.text[1], record.textLength[1] ) ;
+					break ;
+				case LOG_RECORD_ASSERT:
+				case LOG_RECORD_ERROR:
+					read = GetVarint( offset, end, record.pid )
+						&& GetVarint( offset, end, record.sequence )
+						&& GetFixed( offset, end, 8, record.time )
+						&& GetVarint( offset, end, record.category )
+						&& GetVarint( offset, end, record.location )
+						&& ( record.kind != LOG_RECORD_ERROR || GetVarint( offset, end, record.hr ) ) ;
+					break ;
+				default:
+					// a kind from a later version
+					m_offset = end ;
+					continue ;
+			}
+			if ( !read )
+				return false ;
+			m_offset = end ;
+			return true ;
+		}
+	}
+
+	// whether every byte of the log has been read
+	bool IsComplete() const
+	{
+		return m_offset == m_size ;
+	}
+
+	size_t GetOffset() const
+	{
+		return m_offset ;
+	}
+
+private:
+	bool GetVarint( size_t& offset, size_t end, uint32_t& value ) const
+	{
+		value = 0 ;
+		for ( int shift = 0; shift < 35; shift += 7 )
+		{
+			if ( offset >= end )
+				return false ;
+			uint8_t byte = m_data[offset++] ;
+			value |= (uint32_t)(byte & 0x7F) << shift ;
+			if ( ( byte & 0x80 ) == 0 )
+				return true ;
+		}
+		return false ;
+	}
+
+	bool GetFixed( size_t& offset, size_t end, int bytes, uint64_t& value ) const
+	{
+		if ( end - offset < (size_t)bytes )
+			return false ;
+		value = 0 ;
+		for ( int i = 0; i < bytes; i++ )
+			value |= (uint64_t)m_data[offset++] << (i * 8) ;
+		return true ;
+	}
+
+	bool GetString( size_t& offset, size_t end, const char*& value, uint32_t& length ) const
+	{
+		if ( !GetVarint( offset, end, length ) || length > end - offset )
+			return false ;
+		value = reinterpret_cast<const char*>( m_data + offset ) ;
+		offset += length ;
+		return true ;
+	}
+
+	const uint8_t* m_data ;
+	size_t m_size ;
+	size_t m_offset ;
+} ;
@@ -0,0 +1,51 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+/*
+Static tracepoints for profiling the native components, built on TraceLogging
+so that any ETW consumer (WPR/WPA, tracelog, PerfView) can pick them up by
+provider name, "OpenLiveWriter.Native". A tracepoint costs a test of the
+provider's enabled bit when nobody is listening, and its arguments are only
+evaluated when somebody is.
+
+Build with OLW_NO_TRACEPOINTS defined to compile them out altogether.
+
+The provider is defined by DECLARE_LOGFILE/DECLARE_NULL_LOGFILE, so every
+module using LogFile has one; it only fires once the module has called
+TRACEPOINT_REGISTER.
+*/
+
+#ifndef OLW_NO_TRACEPOINTS
+
+#include <TraceLoggingProvider.h>
+#include <winmeta.h>
+
+TRACELOGGING_DECLARE_PROVIDER(_TracepointProvider);
+
+// {6A0C5D2E-8B14-4F3A-9E71-2C4D8F03B5A9}
+#define DEFINE_TRACEPOINT_PROVIDER \
+	TRACELOGGING_DEFINE_PROVIDER(_TracepointProvider, "OpenLiveWriter.Native", \
+		(0x6a0c5d2e, 0x8b14, 0x4f3a, 0x9e, 0x71, 0x2c, 0x4d, 0x8f, 0x03, 0xb5, 0xa9));
+
+#define TRACEPOINT_REGISTER() TraceLoggingRegister(_TracepointProvider)
+#define TRACEPOINT_UNREGISTER() TraceLoggingUnregister(_TracepointProvider)
+
+#define TRACEPOINT(name, ...) \
+	TraceLoggingWrite(_TracepointProvider, name, __VA_ARGS__)
+#define TRACEPOINT_START(name, ...) \
+	TraceLoggingWrite(_TracepointProvider, name, TraceLoggingOpcode(WINEVENT_OPCODE_START), __VA_ARGS__)
+#define TRACEPOINT_STOP(name, ...) \
+	TraceLoggingWrite(_TracepointProvider, name, TraceLoggingOpcode(WINEVENT_OPCODE_STOP), __VA_ARGS__)
+
+#else
+
+#define DEFINE_TRACEPOINT_PROVIDER
+#define TRACEPOINT_REGISTER() ((void)0)
+#define TRACEPOINT_UNREGISTER() ((void)0)
+#define TRACEPOINT(name, ...) ((void)0)
+#define TRACEPOINT_START(name, ...) ((void)0)
+#define TRACEPOINT_STOP(name, ...) ((void)0)
+
+#endif
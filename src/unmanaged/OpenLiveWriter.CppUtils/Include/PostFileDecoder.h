@@ -0,0 +1,231 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include "CompoundFileReader.h"
+
+/*
+Decodes a post file (.wpost) in one pass: walks its compound file directory
+once (see CompoundFileReader) and copies every stream, in every storage, into
+one buffer laid out for the managed code to read where it lies:
+
+	elements    a PostFileElement for each storage and stream, the root
+	            storage first and every storage followed by what is in it
+	names       the elements' names, UTF-16, one after another
+	data        the streams' contents, each starting on an 8 byte boundary
+
+The post editor writes strings with a byte order mark, so a stream's
+encoding says which of the ones StreamReader knows it starts with; the
+contents are copied as they are, mark and all. A stream longer than the maxStreamLength
+given to Open, like a large embedded picture, is listed with its length but
+POST_FILE_NOT_LOADED, for the caller to read some other way if it needs it.
+*/
+
+enum PostFileElementType
+{
+	POST_FILE_STORAGE = 1,
+	POST_FILE_STREAM = 2
+} ;
+
+enum PostFileEncoding
+{
+	POST_FILE_BINARY = 0,
+	POST_FILE_UTF16 = 1,	// starts with FF FE
+	POST_FILE_UTF8 = 2,		// starts with EF BB BF
+	POST_FILE_UTF16BE = 3,	// starts with FE FF
+	POST_FILE_UTF32 = 4,	// starts with FF FE 00 00
+	POST_FILE_UTF32BE = 5	// starts with 00 00 FE FF
+} ;
+
+// the stream's contents aren't in the buffer
+const int32_t POST_FILE_NOT_LOADED = 1 ;
+
+// An element of a decoded post, laid out for the managed code to marshal.
+struct PostFileElement
+{
+	int32_t parent ;		// the storage it is in, or -1 for the root
+	int32_t type ;			// a PostFileElementType
+	int32_t nameOffset ;	// where its name is in the buffer
+	int32_t nameLength ;	// in characters
+	int32_t encoding ;		// a PostFileEncoding
+	int32_t flags ;			// POST_FILE_NOT_LOADED
+	int64_t dataOffset ;	// where its contents are in the buffer
+	int64_t dataLength ;
+} ;
+
+class PostFileDecoder
+{
+public:
+	PostFileDecoder()
+		: m_length( 0 )
+	{
+	}
+
+	/*
+	Walks the directory of the compound file in the size bytes at data, which
+	must stay there until Write has been called, and works out the layout,
+	returning false if it isn't a compound file or its directory is damaged.
+	*/
+	bool Open( const void* data, size_t size, uint64_t maxStreamLength )
+	{
+		m_elements.clear() ;
+		m_length = 0 ;
+		if ( !m_file.Open( data, size ) )
+			return false ;
+
+		// walk the directory depth first, so that every storage is followed by
+		// everything in it; an entry turning up twice means the tree is damaged
+		std::vector<bool> visited( m_file.GetEntryCount(), false ) ;
+		std::vector<Element> pending ;
+		std::vector<uint32_t> children ;
+		Element root = { 0, -1, 0, PostFileElement() } ;
+		pending.push_back( root ) ;
+		while ( !pending.empty() )
+		{
+			Element element = pending.back() ;
+			pending.pop_back() ;
+			if ( visited[element.id] || element.depth > MAX_DEPTH )
+				return false ;
+			visited[element.id] = true ;
+
+			int32_t index = (int32_t)m_elements.size() ;
+			m_elements.push_back( element ) ;
+			if ( m_file.GetEntry( element.id ).type == COMPOUND_FILE_STREAM )
+				continue ;
+
+			if ( !m_file.GetChildren( element.id, children ) )
+				return false ;
+			for ( size_t i = children.size(); i-- > 0; )
+			{
+				uint32_t type = m_file.GetEntry( children[i] ).type ;
+				if ( type == COMPOUND_FILE_STREAM || type == COMPOUND_FILE_STORAGE )
+				{
+					Element child = { children[i], index, element.depth + 1, PostFileElement() } ;
+					pending.push_back( child ) ;
+				}
+			}
+		}
+		return Layout( maxStreamLength ) ;
+	}
+
+	// how many bytes Write writes
+	size_t GetLength() const
+	{
+		return m_length ;
+	}
+
+	int32_t GetElementCount() const
+	{
+		return (int32_t)m_elements.size() ;
+	}
+
+	/*
+	Writes the decoded post to the GetLength() bytes at buffer, returning false
+	if a stream's sectors turn out to be damaged.
+	*/
+	bool Write( uint8_t* buffer ) const
+	{
+		memset( buffer, 0, m_length ) ;
+		for ( size_t i = 0; i < m_elements.size(); i++ )
+		{
+			const CompoundFileEntry& entry = m_file.GetEntry( m_elements[i].id ) ;
+			PostFileElement element = m_elements[i].element ;
+
+			uint8_t* name = buffer + element.nameOffset ;
+			for ( uint32_t j = 0; j < entry.nameLength; j++ )
+			{
+				name[j * 2] = (uint8_t)entry.name[j] ;
+				name[j * 2 + 1] = (uint8_t)((uint16_t)entry.name[j] >> 8) ;
+			}
+
+			if ( element.type == POST_FILE_STREAM && element.flags == 0 )
+			{
+				uint8_t* data = buffer + (size_t)element.dataOffset ;
+				if ( !m_file.Read( m_elements[i].id, data ) )
+					return false ;
+				element.encoding = GetEncoding( data, (size_t)element.dataLength ) ;
+			}
+			memcpy( buffer + i * sizeof(PostFileElement), &element, sizeof(PostFileElement) ) ;
+		}
+		return true ;
+	}
+
+private:
+	// .wpost files nest three deep (post, SupportingFiles, file)
+	static const int32_t MAX_DEPTH = 16 ;
+
+	// the managed code reads the buffer with 32-bit offsets
+	static const uint64_t MAX_LENGTH = 0x7FFFFFFF ;
+
+	struct Element
+	{
+		uint32_t id ;			// the directory entry
+		int32_t parent ;		// the element of the storage it's in
+		int32_t depth ;
+		PostFileElement element ;
+	} ;
+
+	// works out where everything goes and fills in all but the encodings
+	bool Layout( uint64_t maxStreamLength )
+	{
+		uint64_t nameOffset = (uint64_t)m_elements.size() * sizeof(PostFileElement) ;
+		uint64_t dataOffset = nameOffset ;
+		for ( size_t i = 0; i < m_elements.size(); i++ )
+			dataOffset += m_file.GetEntry( m_elements[i].id ).nameLength * 2 ;
+		if ( dataOffset > MAX_LENGTH )
+			return false ;
+
+		for ( size_t i = 0; i < m_elements.size(); i++ )
+		{
+			const CompoundFileEntry& entry = m_file.GetEntry( m_elements[i].id ) ;
+			PostFileElement& element = m_elements[i].element ;
+			memset( &element, 0, sizeof(element) ) ;
+			element.parent = m_elements[i].parent ;
+			element.type = entry.type == COMPOUND_FILE_STREAM ? POST_FILE_STREAM : POST_FILE_STORAGE ;
+			element.nameOffset = (int32_t)nameOffset ;
+			element.nameLength = (int32_t)entry.nameLength ;
+			nameOffset += entry.nameLength * 2 ;
+
+			if ( element.type != POST_FILE_STREAM )
+				continue ;
+			element.dataLength = (int64_t)entry.size ;
+			if ( entry.size > maxStreamLength || entry.size > MAX_LENGTH )
+			{
+				element.flags = POST_FILE_NOT_LOADED ;
+				continue ;
+			}
+			dataOffset = (dataOffset + 7) & ~(uint64_t)7 ;
+			element.dataOffset = (int64_t)dataOffset ;
+			dataOffset += entry.size ;
+			if ( dataOffset > MAX_LENGTH )
+				return false ;
+		}
+		m_length = (size_t)dataOffset ;
+		return true ;
+	}
+
+	// in the order StreamReader looks for them, so FF FE 00 00 is UTF-32
+	static int32_t GetEncoding( const uint8_t* data, size_t length )
+	{
+		if ( length >= 2 && data[0] == 0xFE && data[1] == 0xFF )
+			return POST_FILE_UTF16BE ;
+		if ( length >= 4 && data[0] == 0xFF && data[1] == 0xFE && data[2] == 0 && data[3] == 0 )
+			return POST_FILE_UTF32 ;
+		if ( length >= 2 && data[0] == 0xFF && data[1] == 0xFE )
+			return POST_FILE_UTF16 ;
+		if ( length >= 3 && data[0] == 0xEF && data[1] == 0xBB && data[2] == 0xBF )
+			return POST_FILE_UTF8 ;
+		if ( length >= 4 && data[0] == 0 && data[1] == 0 && data[2] == 0xFE && data[3] == 0xFF )
+			return POST_FILE_UTF32BE ;
+		return POST_FILE_BINARY ;
+	}
+
+	CompoundFileReader m_file ;
+	std::vector<Element> m_elements ;
+	size_t m_length ;
+} ;
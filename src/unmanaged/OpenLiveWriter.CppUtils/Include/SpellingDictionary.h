@@ -0,0 +1,530 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+Checks words against a compiled spelling dictionary that is used where it lies,
+normally in a file mapped into memory, so that opening one costs nothing but
+the mapping and pages are only read as lookups touch them.
+
+The image is a sequence of little-endian 32-bit tables followed by the words:
+
+	SpellingDictionaryHeader
+	word offsets           wordCount + 1 offsets of the words in the text
+	word buckets           wordBucketCount { hash, word + 1 } pairs
+	delete buckets         deleteBucketCount { hash, first posting + 1 } pairs
+	postings               postingCount word numbers, the last of each run with the top bit set
+	text                   textLength UTF-16 units, the words one after another
+
+Words are numbered in the order of the word list they were compiled from,
+which is expected to list common words first; suggestions that are equally
+close to a misspelling are given in that order.
+
+The word buckets are an open addressing hash table (at most three quarters
+full, and probed linearly) of the words by their folded (lowercase) spelling. The delete buckets are the "symmetric delete"
+index: every folded word with one character deleted, hashed, with the words
+it came from as postings. Looking up a misspelling, each of its own one
+character deletes, in both tables finds every word within one edit of it
+(a transposition counting as one) and many within two, without generating any
+insertions or substitutions; candidates are then ranked by their real distance.
+Deletes are kept as hashes only, so a collision just adds a candidate that the
+distance check throws away.
+
+utilities\SpellingDictionaryCompiler compiles word lists into this format, and
+tests and benchmarks the lookups.
+*/
+
+#ifdef _WIN32
+typedef wchar_t SpellingChar ;
+#else
+typedef char16_t SpellingChar ;
+#endif
+
+// 'OLWD'
+const uint32_t SPELLING_DICTIONARY_MAGIC = 0x44574C4F ;
+const uint32_t SPELLING_DICTIONARY_VERSION = 1 ;
+
+// words longer than this are never in a dictionary
+const size_t SPELLING_DICTIONARY_MAX_WORD_LENGTH = 64 ;
+
+// the furthest a suggestion can be from the misspelling
+const unsigned int SPELLING_DICTIONARY_MAX_DISTANCE = 2 ;
+
+// marks the last posting of a delete
+const uint32_t SPELLING_DICTIONARY_LAST_POSTING = 0x80000000 ;
+
+// results of Check, the same values as SpellCheckResult in the managed code
+enum SpellingCheck
+{
+	SPELLING_CORRECT = 0,
+	SPELLING_CAPITALIZATION = 3,
+	SPELLING_MISSPELLED = 4
+} ;
+
+struct SpellingDictionaryHeader
+{
+	uint32_t magic ;
+	uint32_t version ;
+	uint32_t wordCount ;
+	uint32_t wordBucketCount ;
+	uint32_t deleteBucketCount ;
+	uint32_t postingCount ;
+	uint32_t textLength ;
+	uint32_t maxWordLength ;
+} ;
+
+struct SpellingSuggestion
+{
+	uint32_t word ;
+	unsigned int distance ;
+} ;
+
+class SpellingDictionary
+{
+public:
+	SpellingDictionary()
+		: m_header( NULL ), m_wordOffsets( NULL ), m_wordBuckets( NULL ),
+		  m_deleteBuckets( NULL ), m_postings( NULL ), m_text( NULL )
+	{
+	}
+
+	/*
+	Uses the dictionary image at data, which must stay mapped (and 4 byte
+	aligned) for as long as the dictionary is used. Returns false, leaving the
+	dictionary closed, if the image isn't a dictionary of this version or its
+	tables don't fit in size.
+	*/
+	bool Open( const void* data, size_t size )
+	{
+		Close() ;
+
+		if ( data == NULL || size < sizeof(SpellingDictionaryHeader) || ((uintptr_t)data & 3) != 0 )
+			return false ;
+
+		const SpellingDictionaryHeader* header = (const SpellingDictionaryHeader*)data ;
+		if ( header->magic != SPELLING_DICTIONARY_MAGIC || header->version != SPELLING_DICTIONARY_VERSION )
+			return false ;
+		if ( header->wordBucketCount <= header->wordCount || header->deleteBucketCount == 0 ||
+			 header->wordCount >= SPELLING_DICTIONARY_LAST_POSTING || header->maxWordLength > SPELLING_DICTIONARY_MAX_WORD_LENGTH )
+			return false ;
+
+		// sizes in 32-bit units, added up in 64 bits so that nothing overflows
+		uint64_t tables = (uint64_t)header->wordCount + 1 +
+			(uint64_t)header->wordBucketCount * 2 +
+			(uint64_t)header->deleteBucketCount * 2 +
+			header->postingCount ;
+		uint64_t required = sizeof(SpellingDictionaryHeader) + tables * 4 + (uint64_t)header->textLength * 2 ;
+		if ( required > size )
+			return false ;
+
+		const uint32_t* wordOffsets = (const uint32_t*)(header + 1) ;
+		const uint32_t* wordBuckets = wordOffsets + header->wordCount + 1 ;
+		const uint32_t* deleteBuckets = wordBuckets + header->wordBucketCount * 2 ;
+		const uint32_t* postings = deleteBuckets + header->deleteBucketCount * 2 ;
+
+		// the offsets are checked once here rather than on every lookup
+		if ( wordOffsets[0] != 0 || wordOffsets[header->wordCount] != header->textLength )
+			return false ;
+		for ( uint32_t i = 0; i < header->wordCount; i++ )
+		{
+			uint32_t length = wordOffsets[i + 1] - wordOffsets[i] ;
+			if ( wordOffsets[i + 1] < wordOffsets[i] || length == 0 || length > header->maxWordLength )
+				return false ;
+		}
+
+		m_header = header ;
+		m_wordOffsets = wordOffsets ;
+		m_wordBuckets = wordBuckets ;
+		m_deleteBuckets = deleteBuckets ;
+		m_postings = postings ;
+		m_text = (const SpellingChar*)(postings + header->postingCount) ;
+		return true ;
+	}
+
+	void Close()
+	{
+		m_header = NULL ;
+		m_wordOffsets = m_wordBuckets = m_deleteBuckets = m_postings = NULL ;
+		m_text = NULL ;
+	}
+
+	bool IsOpen() const
+	{
+		return m_header != NULL ;
+	}
+
+	uint32_t GetWordCount() const
+	{
+		return m_header != NULL ? m_header->wordCount : 0 ;
+	}
+
+	// Returns the spelling of a word, which isn't null terminated.
+	const SpellingChar* GetWord( uint32_t word, size_t* length ) const
+	{
+		*length = m_wordOffsets[word + 1] - m_wordOffsets[word] ;
+		return m_text + m_wordOffsets[word] ;
+	}
+
+	/*
+	Checks the spelling of a word. A word is correct if the dictionary has it
+	as it is, capitalized or in capitals; the dictionary having it only with
+	different capitals (london, LonDon for London) is SPELLING_CAPITALIZATION.
+	*/
+	SpellingCheck Check( const SpellingChar* word, size_t length ) const
+	{
+		if ( length == 0 )
+			return SPELLING_CORRECT ;
+		if ( m_header == NULL || length > m_header->maxWordLength )
+			return SPELLING_MISSPELLED ;
+
+		SpellingCheck result = SPELLING_MISSPELLED ;
+		uint32_t hash = Hash( word, length, length ) ;
+		uint32_t count = m_header->wordBucketCount ;
+		for ( uint32_t i = hash % count, probes = 0; probes < count && m_wordBuckets[i * 2 + 1] != 0; i = Next( i, count ), probes++ )
+		{
+			if ( m_wordBuckets[i * 2] != hash || m_wordBuckets[i * 2 + 1] > m_header->wordCount )
+				continue ;
+
+			size_t entryLength ;
+			const SpellingChar* entry = GetWord( m_wordBuckets[i * 2 + 1] - 1, &entryLength ) ;
+			if ( entryLength != length || !FoldedEqual( entry, word, length ) )
+				continue ;
+
+			if ( CaseMatches( entry, word, length ) )
+				return SPELLING_CORRECT ;
+			result = SPELLING_CAPITALIZATION ;
+		}
+		return result ;
+	}
+
+	/*
+	Checks a batch of words in text, the i-th word being the lengths[i]
+	characters at starts[i], writing a SpellingCheck for each to results.
+	*/
+	void CheckWords( const SpellingChar* text, const int* starts, const int* lengths, size_t count, unsigned char* results ) const
+	{
+		for ( size_t i = 0; i < count; i++ )
+			results[i] = (unsigned char)Check( text + starts[i], lengths[i] ) ;
+	}
+
+	/*
+	Finds the words closest to a misspelling, writing at most maxSuggestions of
+	them to suggestions, closest and then most common first, and returning how
+	many there are. Words that only differ in case have distance 0.
+	*/
+	size_t Suggest( const SpellingChar* word, size_t length, SpellingSuggestion* suggestions, size_t maxSuggestions ) const
+	{
+		if ( m_header == NULL || length == 0 || maxSuggestions == 0 ||
+			 length > m_header->maxWordLength + SPELLING_DICTIONARY_MAX_DISTANCE )
+			return 0 ;
+
+		SpellingChar folded[SPELLING_DICTIONARY_MAX_WORD_LENGTH + SPELLING_DICTIONARY_MAX_DISTANCE] ;
+		for ( size_t i = 0; i < length; i++ )
+			folded[i] = Fold( word[i] ) ;
+
+		Candidates candidates( folded, length, suggestions, maxSuggestions ) ;
+
+		// words that are the misspelling, or have one more character
+		uint32_t hash = Hash( folded, length, length ) ;
+		AddWords( hash, candidates ) ;
+		AddDeletes( hash, candidates ) ;
+
+		// words that have one character less, or one different or moved
+		for ( size_t skip = 0; skip < length; skip++ )
+		{
+			// deleting either of a pair of letters gives the same thing
+			if ( skip > 0 && folded[skip] == folded[skip - 1] )
+				continue ;
+
+			hash = Hash( folded, length, skip ) ;
+			AddWords( hash, candidates ) ;
+			AddDeletes( hash, candidates ) ;
+		}
+
+		return candidates.GetCount() ;
+	}
+
+	/*
+	Lowercases a character for comparisons. Only the Latin, Greek and Cyrillic
+	letters with case are covered rather than all of Unicode; other characters
+	are left as they are.
+	Typographic apostrophes fold to ' so that don't matches don’t.
+	*/
+	static SpellingChar Fold( SpellingChar c )
+	{
+		if ( c < 0x80 )
+			return ( c >= 'A' && c <= 'Z' ) ? (SpellingChar)(c + 32) : c ;
+		if ( c == 0x2019 )
+			return '\'' ;
+		if ( c == 0x178 )
+			return 0xFF ;
+
+		const CaseRange* range = FindCaseRange( c, true ) ;
+		return range != NULL ? (SpellingChar)(c + range->delta) : c ;
+	}
+
+	// Whether a character is a lowercase letter that has a capital.
+	static bool IsLowercase( SpellingChar c )
+	{
+		if ( c < 0x80 )
+			return c >= 'a' && c <= 'z' ;
+		if ( c == 0xFF )
+			return true ;
+		return FindCaseRange( c, false ) != NULL ;
+	}
+
+	/*
+	Hashes the folded characters of text, leaving out the one at skip (or none,
+	if skip is length), so that deletes are hashed without being made.
+	*/
+	static uint32_t Hash( const SpellingChar* text, size_t length, size_t skip )
+	{
+		uint32_t hash = 2166136261u ;
+		for ( size_t i = 0; i < length; i++ )
+		{
+			if ( i == skip )
+				continue ;
+			hash = (hash ^ Fold( text[i] )) * 16777619u ;
+		}
+		return hash ;
+	}
+
+	/*
+	The optimal string alignment distance between two folded words: how many
+	insertions, deletions, substitutions and swaps of adjacent characters make
+	one the other, or limit + 1 if that is more than limit.
+	*/
+	static unsigned int Distance( const SpellingChar* a, size_t aLength, const SpellingChar* b, size_t bLength, unsigned int limit )
+	{
+		const size_t MAX_LENGTH = SPELLING_DICTIONARY_MAX_WORD_LENGTH + SPELLING_DICTIONARY_MAX_DISTANCE ;
+		if ( aLength > MAX_LENGTH || bLength > MAX_LENGTH )
+			return limit + 1 ;
+		if ( (aLength > bLength ? aLength - bLength : bLength - aLength) > limit )
+			return limit + 1 ;
+
+		unsigned int rows[3][MAX_LENGTH + 1] ;
+		unsigned int* previous2 = rows[0] ;
+		unsigned int* previous = rows[1] ;
+		unsigned int* current = rows[2] ;
+		for ( size_t j = 0; j <= bLength; j++ )
+			previous[j] = (unsigned int)j ;
+
+		// a swap reaches back two rows, so it takes two rows over the limit to stop early
+		unsigned int previousMinimum = 0 ;
+		for ( size_t i = 1; i <= aLength; i++ )
+		{
+			current[0] = (unsigned int)i ;
+			unsigned int rowMinimum = current[0] ;
+			for ( size_t j = 1; j <= bLength; j++ )
+			{
+				unsigned int cost = a[i - 1] == b[j - 1] ? 0 : 1 ;
+				unsigned int distance = Lowest( Lowest( previous[j] + 1, current[j - 1] + 1 ), previous[j - 1] + cost ) ;
+				if ( i > 1 && j > 1 && a[i - 1] == b[j - 2] && a[i - 2] == b[j - 1] )
+					distance = Lowest( distance, previous2[j - 2] + 1 ) ;
+				current[j] = distance ;
+				rowMinimum = Lowest( rowMinimum, distance ) ;
+			}
+			if ( rowMinimum > limit && previousMinimum > limit )
+				return limit + 1 ;
+			previousMinimum = rowMinimum ;
+
+			unsigned int* recycled = previous2 ;
+			previous2 = previous ;
+			previous = current ;
+			current = recycled ;
+		}
+		return Lowest( previous[bLength], limit + 1 ) ;
+	}
+
+private:
+	// letters from first to last, every stride-th one, are capitals of the letter delta after them
+	struct CaseRange
+	{
+		SpellingChar first ;
+		SpellingChar last ;
+		unsigned short stride ;
+		unsigned short delta ;
+	} ;
+
+	static const CaseRange* FindCaseRange( SpellingChar c, bool capital )
+	{
+		static const CaseRange ranges[] =
+		{
+			{ 0x00C0, 0x00D6, 1, 32 },		// À-Ö
+			{ 0x00D8, 0x00DE, 1, 32 },		// Ø-Þ
+			{ 0x0100, 0x0136, 2, 1 },		// Ā-Ķ
+			{ 0x0139, 0x0147, 2, 1 },		// Ĺ-Ň
+			{ 0x014A, 0x0176, 2, 1 },		// Ŋ-Ŷ
+			{ 0x0179, 0x017D, 2, 1 },		// Ź-Ž
+			{ 0x0391, 0x03A1, 1, 32 },		// Α-Ρ
+			{ 0x03A3, 0x03AB, 1, 32 },		// Σ-Ϋ
+			{ 0x0400, 0x040F, 1, 80 },		// Ѐ-Џ
+			{ 0x0410, 0x042F, 1, 32 },		// А-Я
+		} ;
+
+		for ( size_t i = 0; i < sizeof(ranges) / sizeof(ranges[0]); i++ )
+		{
+			const CaseRange& range = ranges[i] ;
+			unsigned int letter = capital ? c : (unsigned int)c - range.delta ;
+			if ( letter >= range.first && letter <= range.last && (letter - range.first) % range.stride == 0 )
+				return &range ;
+		}
+		return NULL ;
+	}
+
+	static bool FoldedEqual( const SpellingChar* a, const SpellingChar* b, size_t length )
+	{
+		for ( size_t i = 0; i < length; i++ )
+		{
+			if ( a[i] != b[i] && Fold( a[i] ) != Fold( b[i] ) )
+				return false ;
+		}
+		return true ;
+	}
+
+	// Whether word is entry (which it equals when folded), capitalized or in capitals.
+	static bool CaseMatches( const SpellingChar* entry, const SpellingChar* word, size_t length )
+	{
+		bool differs = false ;
+		bool capitalized = true ;
+		bool capitals = true ;
+		for ( size_t i = 0; i < length; i++ )
+		{
+			if ( IsLowercase( word[i] ) )
+				capitals = false ;
+
+			// characters that fold together without either being a capital, like ' and ’, are the same
+			if ( word[i] != entry[i] && (IsCapital( word[i] ) || IsCapital( entry[i] )) )
+			{
+				differs = true ;
+				if ( i > 0 || IsLowercase( word[i] ) )
+					capitalized = false ;
+			}
+		}
+		return !differs || capitalized || capitals ;
+	}
+
+	static bool IsCapital( SpellingChar c )
+	{
+		return c != 0x2019 && Fold( c ) != c ;
+	}
+
+	static uint32_t Next( uint32_t bucket, uint32_t count )
+	{
+		return bucket + 1 < count ? bucket + 1 : 0 ;
+	}
+
+	static unsigned int Lowest( unsigned int a, unsigned int b )
+	{
+		return a < b ? a : b ;
+	}
+
+	// The best suggestions found so far, kept in order.
+	class Candidates
+	{
+	public:
+		Candidates( const SpellingChar* word, size_t length, SpellingSuggestion* suggestions, size_t capacity )
+			: m_word( word ), m_length( length ), m_suggestions( suggestions ), m_capacity( capacity ), m_count( 0 )
+		{
+		}
+
+		void Add( const SpellingDictionary& dictionary, uint32_t word )
+		{
+			for ( size_t i = 0; i < m_count; i++ )
+			{
+				if ( m_suggestions[i].word == word )
+					return ;
+			}
+
+			// anything further than the worst kept suggestion can't get in
+			unsigned int limit = SPELLING_DICTIONARY_MAX_DISTANCE ;
+			if ( m_count == m_capacity && m_suggestions[m_count - 1].distance < limit )
+				limit = m_suggestions[m_count - 1].distance ;
+
+			size_t length ;
+			const SpellingChar* spelling = dictionary.GetWord( word, &length ) ;
+			SpellingChar folded[SPELLING_DICTIONARY_MAX_WORD_LENGTH] ;
+			for ( size_t i = 0; i < length; i++ )
+				folded[i] = Fold( spelling[i] ) ;
+
+			unsigned int distance = Distance( m_word, m_length, folded, length, limit ) ;
+			if ( distance > limit )
+				return ;
+
+			// when full, the worst kept suggestion makes way
+			size_t position ;
+			if ( m_count < m_capacity )
+				position = m_count++ ;
+			else if ( IsBetter( distance, word, m_suggestions[m_count - 1] ) )
+				position = m_count - 1 ;
+			else
+				return ;
+
+			for ( ; position > 0 && IsBetter( distance, word, m_suggestions[position - 1] ); position-- )
+				m_suggestions[position] = m_suggestions[position - 1] ;
+			m_suggestions[position].word = word ;
+			m_suggestions[position].distance = distance ;
+		}
+
+		size_t GetCount() const
+		{
+			return m_count ;
+		}
+
+	private:
+		static bool IsBetter( unsigned int distance, uint32_t word, const SpellingSuggestion& other )
+		{
+			return distance < other.distance || (distance == other.distance && word < other.word) ;
+		}
+
+		const SpellingChar* m_word ;
+		size_t m_length ;
+		SpellingSuggestion* m_suggestions ;
+		size_t m_capacity ;
+		size_t m_count ;
+	} ;
+
+	// Adds the words whose folded spelling hashes to hash.
+	void AddWords( uint32_t hash, Candidates& candidates ) const
+	{
+		uint32_t count = m_header->wordBucketCount ;
+		for ( uint32_t i = hash % count, probes = 0; probes < count && m_wordBuckets[i * 2 + 1] != 0; i = Next( i, count ), probes++ )
+		{
+			if ( m_wordBuckets[i * 2] == hash && m_wordBuckets[i * 2 + 1] <= m_header->wordCount )
+				candidates.Add( *this, m_wordBuckets[i * 2 + 1] - 1 ) ;
+		}
+	}
+
+	// Adds the words with a delete that hashes to hash.
+	void AddDeletes( uint32_t hash, Candidates& candidates ) const
+	{
+		uint32_t count = m_header->deleteBucketCount ;
+		for ( uint32_t i = hash % count, probes = 0; probes < count && m_deleteBuckets[i * 2 + 1] != 0; i = Next( i, count ), probes++ )
+		{
+			if ( m_deleteBuckets[i * 2] != hash )
+				continue ;
+
+			for ( uint32_t posting = m_deleteBuckets[i * 2 + 1] - 1; posting < m_header->postingCount; posting++ )
+			{
+				uint32_t word = m_postings[posting] & ~SPELLING_DICTIONARY_LAST_POSTING ;
+				if ( word < m_header->wordCount )
+					candidates.Add( *this, word ) ;
+				if ( m_postings[posting] & SPELLING_DICTIONARY_LAST_POSTING )
+					break ;
+			}
+			return ;
+		}
+	}
+
+	const SpellingDictionaryHeader* m_header ;
+	const uint32_t* m_wordOffsets ;
+	const uint32_t* m_wordBuckets ;
+	const uint32_t* m_deleteBuckets ;
+	const uint32_t* m_postings ;
+	const SpellingChar* m_text ;
+} ;
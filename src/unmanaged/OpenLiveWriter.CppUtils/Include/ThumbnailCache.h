@@ -0,0 +1,401 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+A persistent cache of thumbnails, kept in a fixed size block of memory that is
+normally a file mapped into memory, so that thumbnails made in one session are
+there in the next without decoding their images again.
+
+Thumbnails are keyed by the SHA-256 of their image's contents and the size
+they were asked for (which they fit inside), and stored as 32-bit BGRA pixels
+ready to be copied into a bitmap. The block is laid out as:
+
+	ThumbnailCacheHeader
+	slots                  slotCount { fingerprint, record offset } pairs
+	records                a ring of ThumbnailCacheRecords, each followed by its pixels
+
+The slots are an open addressing hash table, probed linearly and at most half
+full, of the records by a fingerprint of their keys, so a lookup is one probe
+sequence and a comparison of the record's key. Records are written at the
+head of the ring; making room evicts the oldest at its tail, removing their
+slots. A thumbnail found among the oldest quarter of the ring is stored again
+at the head (see Find), so the ones that keep being used are the ones kept,
+which is least recently used eviction to within that quarter.
+
+The header is marked open while the cache is used and closed by Close. A
+cache that wasn't closed, like one of a process that crashed while writing
+to it, or one of another size or version, is emptied rather than trusted when
+it is opened. Records are checked against the bounds of the ring as they are
+read all the same.
+
+This isn't synchronized: callers lock around Find (which only reads unless it
+asks for a thumbnail to be stored again) and Store, which writes.
+*/
+
+// 'OLWT'
+const uint32_t THUMBNAIL_CACHE_MAGIC = 0x54574C4F ;
+const uint32_t THUMBNAIL_CACHE_VERSION = 1 ;
+
+// SHA-256
+const size_t THUMBNAIL_CACHE_HASH_LENGTH = 32 ;
+
+// records start and end on cache lines
+const uint32_t THUMBNAIL_CACHE_ALIGNMENT = 64 ;
+
+// the least the cache can be
+const uint64_t THUMBNAIL_CACHE_MIN_SIZE = 1024 * 1024 ;
+
+enum ThumbnailCacheState
+{
+	THUMBNAIL_CACHE_CLOSED = 1,
+	THUMBNAIL_CACHE_OPEN = 2
+} ;
+
+enum ThumbnailCacheRecordKind
+{
+	THUMBNAIL_CACHE_THUMBNAIL = 1,
+	THUMBNAIL_CACHE_PADDING = 2		// the end of the ring, skipped to start again at the beginning
+} ;
+
+struct ThumbnailCacheHeader
+{
+	uint32_t magic ;
+	uint32_t version ;
+	uint32_t state ;
+	uint32_t slotCount ;
+	uint64_t size ;				// of the whole cache
+	uint64_t ringOffset ;
+	uint64_t ringSize ;
+	uint64_t head ;				// where the next record goes
+	uint64_t tail ;				// the oldest record
+	uint64_t used ;				// bytes of records from tail to head
+	uint32_t thumbnailCount ;
+	uint32_t reserved ;
+} ;
+
+struct ThumbnailCacheSlot
+{
+	uint64_t fingerprint ;		// 0 if the slot is empty
+	uint64_t offset ;			// of the record in the ring
+} ;
+
+struct ThumbnailCacheRecord
+{
+	uint32_t size ;				// with the pixels and padding to THUMBNAIL_CACHE_ALIGNMENT
+	uint32_t kind ;
+	uint32_t requestedWidth ;
+	uint32_t requestedHeight ;
+	uint32_t width ;
+	uint32_t height ;
+	uint32_t reserved[2] ;
+	uint8_t hash[THUMBNAIL_CACHE_HASH_LENGTH] ;
+} ;
+
+class ThumbnailCache
+{
+public:
+	ThumbnailCache()
+		: m_header( NULL ), m_slots( NULL ), m_ring( NULL )
+	{
+	}
+
+	/*
+	Uses the cache of size bytes at memory, which must stay mapped (and 8 byte
+	aligned) until Close, emptying it first unless it's a closed cache of this
+	size and version. Returns false if size is less than THUMBNAIL_CACHE_MIN_SIZE.
+	*/
+	bool Open( void* memory, uint64_t size )
+	{
+		m_header = NULL ;
+		if ( memory == NULL || size < THUMBNAIL_CACHE_MIN_SIZE || ((uintptr_t)memory & 7) != 0 )
+			return false ;
+
+		m_header = (ThumbnailCacheHeader*)memory ;
+		if ( !IsValid( size ) )
+			Format( size ) ;
+
+		m_slots = (ThumbnailCacheSlot*)(m_header + 1) ;
+		m_ring = (uint8_t*)memory + m_header->ringOffset ;
+		m_header->state = THUMBNAIL_CACHE_OPEN ;
+		return true ;
+	}
+
+	// Marks the cache closed; the caller flushes it.
+	void Close()
+	{
+		if ( m_header != NULL )
+			m_header->state = THUMBNAIL_CACHE_CLOSED ;
+		m_header = NULL ;
+	}
+
+	/*
+	Copies the thumbnail of the image with hash made for the requested size
+	into pixels (which has room for requestedWidth * requestedHeight of them),
+	returning false if there is none. store is set if the thumbnail is old
+	enough that it should be stored again, for it not to be evicted soon.
+	*/
+	bool Find( const uint8_t* hash, uint32_t requestedWidth, uint32_t requestedHeight,
+		uint32_t* width, uint32_t* height, uint8_t* pixels, bool* store ) const
+	{
+		int64_t slot = FindSlot( hash, requestedWidth, requestedHeight ) ;
+		if ( slot < 0 )
+			return false ;
+
+		uint64_t offset = m_slots[slot].offset ;
+		const ThumbnailCacheRecord* record = (const ThumbnailCacheRecord*)(m_ring + offset) ;
+		*width = record->width ;
+		*height = record->height ;
+		memcpy( pixels, record + 1, (size_t)record->width * record->height * 4 ) ;
+
+		uint64_t age = offset >= m_header->tail ? offset - m_header->tail : offset + m_header->ringSize - m_header->tail ;
+		*store = age < m_header->used / 4 ;
+		return true ;
+	}
+
+	/*
+	Stores a thumbnail of width x height (fitting the requested size) BGRA
+	pixels, stride bytes apart, for the image with hash, replacing any it
+	already has. Returns false if it's too large for the cache to keep.
+	*/
+	bool Store( const uint8_t* hash, uint32_t requestedWidth, uint32_t requestedHeight,
+		uint32_t width, uint32_t height, const uint8_t* pixels, size_t stride )
+	{
+		if ( width == 0 || height == 0 || width > requestedWidth || height > requestedHeight )
+			return false ;
+		uint64_t size = Align( sizeof(ThumbnailCacheRecord) + (uint64_t)width * height * 4 ) ;
+		if ( size > m_header->ringSize / 4 )
+			return false ;
+
+		int64_t existing = FindSlot( hash, requestedWidth, requestedHeight ) ;
+		if ( existing >= 0 )
+			RemoveSlot( (uint64_t)existing ) ;
+		while ( m_header->thumbnailCount >= m_header->slotCount / 2 )
+			EvictTail() ;
+
+		uint64_t offset = Allocate( size ) ;
+		ThumbnailCacheRecord* record = (ThumbnailCacheRecord*)(m_ring + offset) ;
+		memset( record, 0, sizeof(ThumbnailCacheRecord) ) ;
+		record->size = (uint32_t)size ;
+		record->kind = THUMBNAIL_CACHE_THUMBNAIL ;
+		record->requestedWidth = requestedWidth ;
+		record->requestedHeight = requestedHeight ;
+		record->width = width ;
+		record->height = height ;
+		memcpy( record->hash, hash, THUMBNAIL_CACHE_HASH_LENGTH ) ;
+
+		uint8_t* destination = (uint8_t*)(record + 1) ;
+		for ( uint32_t y = 0 ; y < height ; y++ )
+			memcpy( destination + (size_t)y * width * 4, pixels + y * stride, (size_t)width * 4 ) ;
+
+		// the slot goes in last, so the thumbnail is complete before it can be found
+		uint64_t fingerprint = Fingerprint( hash, requestedWidth, requestedHeight ) ;
+		uint64_t mask = m_header->slotCount - 1 ;
+		uint64_t slot = fingerprint & mask ;
+		while ( m_slots[slot].fingerprint != 0 )
+			slot = (slot + 1) & mask ;
+		m_slots[slot].offset = offset ;
+		m_slots[slot].fingerprint = fingerprint ;
+		m_header->thumbnailCount++ ;
+		return true ;
+	}
+
+	uint32_t GetThumbnailCount() const
+	{
+		return m_header->thumbnailCount ;
+	}
+
+	// bytes of the ring in use, including evicted thumbnails still there
+	uint64_t GetUsed() const
+	{
+		return m_header->used ;
+	}
+
+private:
+	static uint64_t Align( uint64_t size )
+	{
+		return (size + THUMBNAIL_CACHE_ALIGNMENT - 1) & ~(uint64_t)(THUMBNAIL_CACHE_ALIGNMENT - 1) ;
+	}
+
+	// A slot for every 8 KB, twice as many as the 16 KB thumbnails (64x64) that fit.
+	static uint32_t SlotCountFor( uint64_t size )
+	{
+		uint64_t slotCount = 64 ;
+		while ( slotCount * 8192 < size && slotCount < 0x40000000 )
+			slotCount *= 2 ;
+		return (uint32_t)slotCount ;
+	}
+
+	static uint64_t RingOffsetFor( uint32_t slotCount )
+	{
+		return Align( sizeof(ThumbnailCacheHeader) + (uint64_t)slotCount * sizeof(ThumbnailCacheSlot) ) ;
+	}
+
+	bool IsValid( uint64_t size ) const
+	{
+		const ThumbnailCacheHeader* header = m_header ;
+		if ( header->magic != THUMBNAIL_CACHE_MAGIC || header->version != THUMBNAIL_CACHE_VERSION
+			|| header->state != THUMBNAIL_CACHE_CLOSED || header->size != size )
+			return false ;
+
+		// a closed cache is consistent unless something else wrote to it
+		return header->slotCount == SlotCountFor( size )
+			&& header->ringOffset == RingOffsetFor( header->slotCount )
+			&& header->ringSize == ((size - header->ringOffset) & ~(uint64_t)(THUMBNAIL_CACHE_ALIGNMENT - 1))
+			&& header->head < header->ringSize && header->tail < header->ringSize
+			&& header->used <= header->ringSize && header->thumbnailCount <= header->slotCount / 2 ;
+	}
+
+	void Format( uint64_t size )
+	{
+		uint32_t slotCount = SlotCountFor( size ) ;
+		uint64_t ringOffset = RingOffsetFor( slotCount ) ;
+		memset( m_header, 0, (size_t)ringOffset ) ;
+		m_header->magic = THUMBNAIL_CACHE_MAGIC ;
+		m_header->version = THUMBNAIL_CACHE_VERSION ;
+		m_header->state = THUMBNAIL_CACHE_CLOSED ;
+		m_header->slotCount = slotCount ;
+		m_header->size = size ;
+		m_header->ringOffset = ringOffset ;
+		m_header->ringSize = (size - ringOffset) & ~(uint64_t)(THUMBNAIL_CACHE_ALIGNMENT - 1) ;
+	}
+
+	static uint64_t Fingerprint( const uint8_t* hash, uint32_t requestedWidth, uint32_t requestedHeight )
+	{
+		// the hash is already random, so its first bytes do with the size mixed in
+		uint64_t fingerprint ;
+		memcpy( &fingerprint, hash, sizeof(fingerprint) ) ;
+		fingerprint ^= ((uint64_t)requestedWidth << 32 | requestedHeight) * 0x9E3779B97F4A7C15ull ;
+		fingerprint ^= fingerprint >> 29 ;
+		return fingerprint | 1 ;
+	}
+
+	// The slot of the thumbnail with this key, or -1.
+	int64_t FindSlot( const uint8_t* hash, uint32_t requestedWidth, uint32_t requestedHeight ) const
+	{
+		uint64_t fingerprint = Fingerprint( hash, requestedWidth, requestedHeight ) ;
+		uint64_t mask = m_header->slotCount - 1 ;
+		for ( uint64_t slot = fingerprint & mask ; m_slots[slot].fingerprint != 0 ; slot = (slot + 1) & mask )
+		{
+			if ( m_slots[slot].fingerprint != fingerprint )
+				continue ;
+
+			const ThumbnailCacheRecord* record = GetRecord( m_slots[slot].offset ) ;
+			if ( record != NULL && record->kind == THUMBNAIL_CACHE_THUMBNAIL
+				&& record->requestedWidth == requestedWidth && record->requestedHeight == requestedHeight
+				&& memcmp( record->hash, hash, THUMBNAIL_CACHE_HASH_LENGTH ) == 0
+				&& record->width <= requestedWidth && record->height <= requestedHeight
+				&& sizeof(ThumbnailCacheRecord) + (uint64_t)record->width * record->height * 4 <= record->size )
+				return (int64_t)slot ;
+		}
+		return -1 ;
+	}
+
+	// Empties a slot, moving the ones probed past it back so that they're still found.
+	void RemoveSlot( uint64_t slot )
+	{
+		uint64_t mask = m_header->slotCount - 1 ;
+		for ( uint64_t next = (slot + 1) & mask ; m_slots[next].fingerprint != 0 ; next = (next + 1) & mask )
+		{
+			uint64_t home = m_slots[next].fingerprint & mask ;
+			bool between = slot <= next ? (slot < home && home <= next) : (slot < home || home <= next) ;
+			if ( !between )
+			{
+				m_slots[slot] = m_slots[next] ;
+				slot = next ;
+			}
+		}
+		m_slots[slot].fingerprint = 0 ;
+		m_slots[slot].offset = 0 ;
+		m_header->thumbnailCount-- ;
+	}
+
+	// The record at offset, or NULL if it isn't one that fits in the ring.
+	const ThumbnailCacheRecord* GetRecord( uint64_t offset ) const
+	{
+		if ( offset % THUMBNAIL_CACHE_ALIGNMENT != 0 || offset >= m_header->ringSize )
+			return NULL ;
+		const ThumbnailCacheRecord* record = (const ThumbnailCacheRecord*)(m_ring + offset) ;
+		if ( record->size < THUMBNAIL_CACHE_ALIGNMENT || record->size % THUMBNAIL_CACHE_ALIGNMENT != 0
+			|| record->size > m_header->ringSize - offset )
+			return NULL ;
+		return record ;
+	}
+
+	// Finds size bytes at the head of the ring, evicting from its tail to make room.
+	uint64_t Allocate( uint64_t size )
+	{
+		for ( ;; )
+		{
+			ThumbnailCacheHeader* header = m_header ;
+			if ( header->used == 0 )
+				header->head = header->tail = 0 ;
+
+			bool full = header->used > 0 && header->head == header->tail ;
+			if ( !full && header->head >= header->tail )
+			{
+				// free from the head to the end, and from the beginning to the tail
+				if ( header->ringSize - header->head >= size )
+					break ;
+				if ( header->tail == 0 )
+				{
+					EvictTail() ;
+					continue ;
+				}
+
+				// skip the rest of the ring
+				ThumbnailCacheRecord* padding = (ThumbnailCacheRecord*)(m_ring + header->head) ;
+				memset( padding, 0, sizeof(ThumbnailCacheRecord) ) ;
+				padding->size = (uint32_t)(header->ringSize - header->head) ;
+				padding->kind = THUMBNAIL_CACHE_PADDING ;
+				header->used += padding->size ;
+				header->head = 0 ;
+			}
+			else if ( !full && header->tail - header->head >= size )
+				break ;
+			else
+				EvictTail() ;
+		}
+
+		uint64_t offset = m_header->head ;
+		m_header->head += size ;
+		if ( m_header->head == m_header->ringSize )
+			m_header->head = 0 ;
+		m_header->used += size ;
+		return offset ;
+	}
+
+	void EvictTail()
+	{
+		const ThumbnailCacheRecord* record = GetRecord( m_header->tail ) ;
+		if ( record == NULL || record->size > m_header->used )
+		{
+			// not what was written; start again
+			Format( m_header->size ) ;
+			m_header->state = THUMBNAIL_CACHE_OPEN ;
+			return ;
+		}
+
+		if ( record->kind == THUMBNAIL_CACHE_THUMBNAIL )
+		{
+			// unless it was stored again since
+			int64_t slot = FindSlot( record->hash, record->requestedWidth, record->requestedHeight ) ;
+			if ( slot >= 0 && m_slots[slot].offset == m_header->tail )
+				RemoveSlot( (uint64_t)slot ) ;
+		}
+
+		m_header->used -= record->size ;
+		m_header->tail += record->size ;
+		if ( m_header->tail == m_header->ringSize )
+			m_header->tail = 0 ;
+	}
+
+	ThumbnailCacheHeader* m_header ;
+	ThumbnailCacheSlot* m_slots ;
+	uint8_t* m_ring ;
+} ;
@@ -0,0 +1,584 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include <stddef.h>
+#include <string.h>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define URL_CODEC_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/*
+Converts between Windows file paths and file: URLs without allocating, in the
+form .NET's Uri gives them (which is what the managed code compares against):
+
+	C:\My Pictures\café.jpg       file:///C:/My%20Pictures/caf%C3%A9.jpg
+	\\server\share\a#1.png        file://server/share/a%231.png
+	\\?\C:\long\path              file:///C:/long/path
+	\\?\UNC\server\share          file://server/share
+
+Characters other than letters, digits and -._~!$&'()*+,;=:@ are percent-encoded
+as UTF-8; backslashes become slashes. Going back, file://localhost/, file:/C:/
+and the legacy C| drive are accepted too, anything after ? or # is dropped and
+escapes that aren't valid UTF-8 are left as they are. Relative paths, and URLs
+that aren't file: URLs of a drive or share, can't be converted.
+
+Runs of characters that don't need escaping are found eight at a time with
+SSE2 when the compiler targets it. The code is plain C++ apart from that, so it
+builds anywhere; utilities\UrlCodecCheck tests and benchmarks it that way.
+
+Single conversions work like snprintf: they return the length of the result
+and write as much of it as fits, null terminated. Batches of conversions go
+into a caller's arena (UrlCodecArena), so that hundreds of paths take one
+buffer between them.
+*/
+
+#ifdef _WIN32
+typedef wchar_t UrlChar ;
+#else
+typedef char16_t UrlChar ;
+#endif
+
+// returned by conversions of paths or URLs that can't be converted
+const size_t URL_CODEC_INVALID = (size_t)-1 ;
+
+/*
+A caller-provided buffer that batch conversions write their results into, one
+after the other. Results stay valid until the arena is reset.
+*/
+class UrlCodecArena
+{
+public:
+	UrlCodecArena( UrlChar* buffer, size_t capacity )
+		: m_buffer( buffer ), m_capacity( capacity ), m_used( 0 )
+	{
+	}
+
+	void Reset()
+	{
+		m_used = 0 ;
+	}
+
+	size_t GetUsed() const
+	{
+		return m_used ;
+	}
+
+	size_t GetCapacity() const
+	{
+		return m_capacity ;
+	}
+
+private:
+	UrlChar* m_buffer ;
+	size_t m_capacity ;
+	size_t m_used ;
+
+	friend class UrlCodec ;
+} ;
+
+class UrlCodec
+{
+public:
+	/*
+	Writes the file: URL of a path to url, returning its length, or
+	URL_CODEC_INVALID for paths that aren't absolute. Nothing is written past
+	capacity, so a capacity of zero just measures.
+	*/
+	static size_t PathToUrl( const UrlChar* path, size_t length, UrlChar* url, size_t capacity )
+	{
+		Output out( url, capacity ) ;
+		if ( !EncodePath( path, length, out ) )
+			return URL_CODEC_INVALID ;
+		return out.Finish() ;
+	}
+
+	// Writes the path of a file: URL to path, like PathToUrl.
+	static size_t UrlToPath( const UrlChar* url, size_t length, UrlChar* path, size_t capacity )
+	{
+		Output out( path, capacity ) ;
+		if ( !DecodeUrl( url, length, out ) )
+			return URL_CODEC_INVALID ;
+		return out.Finish() ;
+	}
+
+	/*
+	Converts paths to URLs into the arena. results[i] points at the null
+	terminated URL of paths[i], or is NULL if the path can't be converted.
+	Returns how many paths were done; fewer than count means the arena is
+	full, and the rest can be done once the caller has reset it.
+	*/
+	static size_t PathsToUrls( const UrlChar* const* paths, const size_t* lengths, size_t count,
+		UrlCodecArena& arena, const UrlChar** results, size_t* resultLengths )
+	{
+		return Convert( &UrlCodec::PathToUrl, paths, lengths, count, arena, results, resultLengths ) ;
+	}
+
+	// Converts URLs to paths into the arena, like PathsToUrls.
+	static size_t UrlsToPaths( const UrlChar* const* urls, const size_t* lengths, size_t count,
+		UrlCodecArena& arena, const UrlChar** results, size_t* resultLengths )
+	{
+		return Convert( &UrlCodec::UrlToPath, urls, lengths, count, arena, results, resultLengths ) ;
+	}
+
+	static size_t Length( const UrlChar* text )
+	{
+		size_t length = 0 ;
+		while ( text[length] != 0 )
+			length++ ;
+		return length ;
+	}
+
+private:
+	typedef size_t (*Converter)( const UrlChar*, size_t, UrlChar*, size_t ) ;
+
+	// Counts everything written, but only stores what fits.
+	class Output
+	{
+	public:
+		Output( UrlChar* buffer, size_t capacity )
+			: m_buffer( buffer ), m_capacity( capacity ), m_length( 0 )
+		{
+		}
+
+		void Put( UrlChar c )
+		{
+			if ( m_length < m_capacity )
+				m_buffer[m_length] = c ;
+			m_length++ ;
+		}
+
+		void Put( const UrlChar* text, size_t length )
+		{
+			if ( m_length < m_capacity )
+				memcpy( m_buffer + m_length, text, Min( length, m_capacity - m_length ) * sizeof(UrlChar) ) ;
+			m_length += length ;
+		}
+
+		void PutAscii( const char* text )
+		{
+			for ( ; *text != 0; text++ )
+				Put( (UrlChar)*text ) ;
+		}
+
+		void PutEscaped( unsigned int byte )
+		{
+			static const char hex[] = "0123456789ABCDEF" ;
+			Put( '%' ) ;
+			Put( (UrlChar)hex[byte >> 4] ) ;
+			Put( (UrlChar)hex[byte & 0xF] ) ;
+		}
+
+		size_t Finish()
+		{
+			if ( m_capacity > 0 )
+				m_buffer[Min( m_length, m_capacity - 1 )] = 0 ;
+			return m_length ;
+		}
+
+	private:
+		UrlChar* m_buffer ;
+		size_t m_capacity ;
+		size_t m_length ;
+	} ;
+
+	static size_t Min( size_t a, size_t b )
+	{
+		return a < b ? a : b ;
+	}
+
+	static size_t Convert( Converter convert, const UrlChar* const* inputs, const size_t* lengths, size_t count,
+		UrlCodecArena& arena, const UrlChar** results, size_t* resultLengths )
+	{
+		for ( size_t i = 0; i < count; i++ )
+		{
+			UrlChar* buffer = arena.m_buffer + arena.m_used ;
+			size_t available = arena.m_capacity - arena.m_used ;
+			size_t length = convert( inputs[i], lengths[i], buffer, available ) ;
+			if ( length == URL_CODEC_INVALID )
+			{
+				results[i] = NULL ;
+				resultLengths[i] = 0 ;
+				continue ;
+			}
+			if ( length >= available )
+				return i ;
+
+			arena.m_used += length + 1 ;
+			results[i] = buffer ;
+			resultLengths[i] = length ;
+		}
+		return count ;
+	}
+
+	static unsigned int LowestBit( unsigned int mask )
+	{
+#ifdef _MSC_VER
+		unsigned long bit ;
+		_BitScanForward( &bit, mask ) ;
+		return bit ;
+#else
+		return __builtin_ctz( mask ) ;
+#endif
+	}
+
+	// letters, digits and -._~!$&'()*+,;=:@ and the / separator
+	static bool IsUrlSafe( UrlChar c )
+	{
+		return (c >= 0x26 && c <= 0x3B) || (c >= 0x40 && c <= 0x5A) || (c >= 0x61 && c <= 0x7A)
+			|| c == 0x21 || c == 0x24 || c == 0x3D || c == 0x5F || c == 0x7E ;
+	}
+
+	// The number of characters text starts with that go into a URL as they are.
+	static size_t UrlSafeRun( const UrlChar* text, size_t length )
+	{
+		size_t i = 0 ;
+#ifdef URL_CODEC_SSE2
+		// characters from 0x8000 up compare as negative, so they are never in range
+		const __m128i exclamation = _mm_set1_epi16( 0x21 ) ;
+		const __m128i dollar = _mm_set1_epi16( 0x24 ) ;
+		const __m128i equals = _mm_set1_epi16( 0x3D ) ;
+		const __m128i underscore = _mm_set1_epi16( 0x5F ) ;
+		const __m128i tilde = _mm_set1_epi16( 0x7E ) ;
+		for ( ; i + 8 <= length; i += 8 )
+		{
+			__m128i chars = _mm_loadu_si128( reinterpret_cast<const __m128i*>(text + i) ) ;
+			__m128i safe = _mm_and_si128( _mm_cmpgt_epi16( chars, _mm_set1_epi16( 0x25 ) ), _mm_cmplt_epi16( chars, _mm_set1_epi16( 0x3C ) ) ) ;
+			safe = _mm_or_si128( safe, _mm_and_si128( _mm_cmpgt_epi16( chars, _mm_set1_epi16( 0x3F ) ), _mm_cmplt_epi16( chars, _mm_set1_epi16( 0x5B ) ) ) ) ;
+			safe = _mm_or_si128( safe, _mm_and_si128( _mm_cmpgt_epi16( chars, _mm_set1_epi16( 0x60 ) ), _mm_cmplt_epi16( chars, _mm_set1_epi16( 0x7B ) ) ) ) ;
+			safe = _mm_or_si128( safe, _mm_or_si128( _mm_cmpeq_epi16( chars, exclamation ), _mm_cmpeq_epi16( chars, dollar ) ) ) ;
+			safe = _mm_or_si128( safe, _mm_or_si128( _mm_cmpeq_epi16( chars, equals ), _mm_cmpeq_epi16( chars, underscore ) ) ) ;
+			safe = _mm_or_si128( safe, _mm_cmpeq_epi16( chars, tilde ) ) ;
+			int mask = _mm_movemask_epi8( safe ) ;
+			if ( mask != 0xFFFF )
+				return i + LowestBit( ~mask & 0xFFFF ) / 2 ;
+		}
+#endif
+		while ( i < length && IsUrlSafe( text[i] ) )
+			i++ ;
+		return i ;
+	}
+
+	// The number of characters text starts with that go into a path as they are.
+	static size_t PathLiteralRun( const UrlChar* text, size_t length )
+	{
+		size_t i = 0 ;
+#ifdef URL_CODEC_SSE2
+		const __m128i percent = _mm_set1_epi16( '%' ) ;
+		const __m128i slash = _mm_set1_epi16( '/' ) ;
+		const __m128i question = _mm_set1_epi16( '?' ) ;
+		const __m128i hash = _mm_set1_epi16( '#' ) ;
+		for ( ; i + 8 <= length; i += 8 )
+		{
+			__m128i chars = _mm_loadu_si128( reinterpret_cast<const __m128i*>(text + i) ) ;
+			__m128i special = _mm_or_si128(
+				_mm_or_si128( _mm_cmpeq_epi16( chars, percent ), _mm_cmpeq_epi16( chars, slash ) ),
+				_mm_or_si128( _mm_cmpeq_epi16( chars, question ), _mm_cmpeq_epi16( chars, hash ) ) ) ;
+			int mask = _mm_movemask_epi8( special ) ;
+			if ( mask != 0 )
+				return i + LowestBit( mask ) / 2 ;
+		}
+#endif
+		while ( i < length && text[i] != '%' && text[i] != '/' && text[i] != '?' && text[i] != '#' )
+			i++ ;
+		return i ;
+	}
+
+	static bool IsSeparator( UrlChar c )
+	{
+		return c == '\\' || c == '/' ;
+	}
+
+	static bool IsDriveLetter( UrlChar c )
+	{
+		return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') ;
+	}
+
+	static UrlChar FoldAscii( UrlChar c )
+	{
+		return c >= 'A' && c <= 'Z' ? (UrlChar)(c + ('a' - 'A')) : c ;
+	}
+
+	static bool StartsWith( const UrlChar* text, size_t length, const char* lowerCasePrefix )
+	{
+		size_t i = 0 ;
+		for ( ; lowerCasePrefix[i] != 0; i++ )
+		{
+			if ( i >= length || FoldAscii( text[i] ) != (UrlChar)lowerCasePrefix[i] )
+				return false ;
+		}
+		return true ;
+	}
+
+	// Percent-encodes the UTF-8 of a path (or host), turning backslashes into slashes.
+	static void EncodeComponent( const UrlChar* text, size_t length, Output& out )
+	{
+		size_t i = 0 ;
+		while ( i < length )
+		{
+			size_t run = UrlSafeRun( text + i, length - i ) ;
+			out.Put( text + i, run ) ;
+			i += run ;
+			if ( i >= length )
+				break ;
+
+			unsigned int c = text[i++] ;
+			if ( c == '\\' )
+			{
+				out.Put( '/' ) ;
+				continue ;
+			}
+			if ( c >= 0xD800 && c < 0xDC00 && i < length && text[i] >= 0xDC00 && text[i] < 0xE000 )
+				c = 0x10000 + ((c - 0xD800) << 10) + (text[i++] - 0xDC00) ;
+			else if ( c >= 0xD800 && c < 0xE000 )
+				c = 0xFFFD ;
+
+			if ( c < 0x80 )
+			{
+				out.PutEscaped( c ) ;
+			}
+			else if ( c < 0x800 )
+			{
+				out.PutEscaped( 0xC0 | (c >> 6) ) ;
+				out.PutEscaped( 0x80 | (c & 0x3F) ) ;
+			}
+			else if ( c < 0x10000 )
+			{
+				out.PutEscaped( 0xE0 | (c >> 12) ) ;
+				out.PutEscaped( 0x80 | ((c >> 6) & 0x3F) ) ;
+				out.PutEscaped( 0x80 | (c & 0x3F) ) ;
+			}
+			else
+			{
+				out.PutEscaped( 0xF0 | (c >> 18) ) ;
+				out.PutEscaped( 0x80 | ((c >> 12) & 0x3F) ) ;
+				out.PutEscaped( 0x80 | ((c >> 6) & 0x3F) ) ;
+				out.PutEscaped( 0x80 | (c & 0x3F) ) ;
+			}
+		}
+	}
+
+	static bool EncodePath( const UrlChar* path, size_t length, Output& out )
+	{
+		// \\?\UNC\server\share and \\?\C:\ long paths
+		bool unc = false ;
+		if ( StartsWith( path, length, "\\\\?\\unc\\" ) )
+		{
+			path += 8 ;
+			length -= 8 ;
+			unc = true ;
+		}
+		else if ( StartsWith( path, length, "\\\\?\\" ) )
+		{
+			path += 4 ;
+			length -= 4 ;
+		}
+		else if ( length >= 2 && IsSeparator( path[0] ) && IsSeparator( path[1] ) )
+		{
+			path += 2 ;
+			length -= 2 ;
+			unc = true ;
+		}
+
+		if ( unc )
+		{
+			if ( length == 0 || IsSeparator( path[0] ) )
+				return false ;
+			out.PutAscii( "file://" ) ;
+			EncodeComponent( path, length, out ) ;
+			return true ;
+		}
+
+		if ( length < 2 || !IsDriveLetter( path[0] ) || path[1] != ':' || (length > 2 && !IsSeparator( path[2] )) )
+			return false ;
+
+		out.PutAscii( "file:///" ) ;
+		out.Put( path, 2 ) ;
+		if ( length == 2 )
+			out.Put( '/' ) ;
+		else
+			EncodeComponent( path + 2, length - 2, out ) ;
+		return true ;
+	}
+
+	static int HexValue( UrlChar c )
+	{
+		if ( c >= '0' && c <= '9' )
+			return c - '0' ;
+		if ( c >= 'A' && c <= 'F' )
+			return c - 'A' + 10 ;
+		if ( c >= 'a' && c <= 'f' )
+			return c - 'a' + 10 ;
+		return -1 ;
+	}
+
+	// The byte of the %XX escape at pos, or -1.
+	static int EscapedByte( const UrlChar* text, size_t length, size_t pos )
+	{
+		if ( pos + 2 >= length || text[pos] != '%' )
+			return -1 ;
+		int high = HexValue( text[pos + 1] ) ;
+		int low = HexValue( text[pos + 2] ) ;
+		return high < 0 || low < 0 ? -1 : (high << 4) | low ;
+	}
+
+	/*
+	Decodes the UTF-8 character escaped at pos, returning how much of text it
+	takes, or 0 if it isn't valid UTF-8.
+	*/
+	static size_t DecodeEscaped( const UrlChar* text, size_t length, size_t pos, Output& out )
+	{
+		int lead = EscapedByte( text, length, pos ) ;
+		if ( lead < 0 )
+			return 0 ;
+		if ( lead < 0x80 )
+		{
+			out.Put( (UrlChar)lead ) ;
+			return 3 ;
+		}
+
+		int count ;
+		unsigned int c ;
+		unsigned int lowest = 0x80, highest = 0xBF ;
+		if ( lead >= 0xC2 && lead <= 0xDF )
+		{
+			count = 1 ;
+			c = lead & 0x1F ;
+		}
+		else if ( lead >= 0xE0 && lead <= 0xEF )
+		{
+			count = 2 ;
+			c = lead & 0x0F ;
+			if ( lead == 0xE0 )
+				lowest = 0xA0 ;
+			else if ( lead == 0xED )
+				highest = 0x9F ;
+		}
+		else if ( lead >= 0xF0 && lead <= 0xF4 )
+		{
+			count = 3 ;
+			c = lead & 0x07 ;
+			if ( lead == 0xF0 )
+				lowest = 0x90 ;
+			else if ( lead == 0xF4 )
+				highest = 0x8F ;
+		}
+		else
+		{
+			return 0 ;
+		}
+
+		for ( int i = 1; i <= count; i++ )
+		{
+			int byte = EscapedByte( text, length, pos + 3 * i ) ;
+			if ( byte < 0 || (unsigned int)byte < (i == 1 ? lowest : 0x80) || (unsigned int)byte > (i == 1 ? highest : 0xBF) )
+				return 0 ;
+			c = (c << 6) | (byte & 0x3F) ;
+		}
+
+		if ( c >= 0x10000 )
+		{
+			out.Put( (UrlChar)(0xD800 + ((c - 0x10000) >> 10)) ) ;
+			out.Put( (UrlChar)(0xDC00 + ((c - 0x10000) & 0x3FF)) ) ;
+		}
+		else
+		{
+			out.Put( (UrlChar)c ) ;
+		}
+		return 3 * (count + 1) ;
+	}
+
+	// Percent-decodes a path (or host), turning slashes into backslashes.
+	static void DecodeComponent( const UrlChar* text, size_t length, Output& out )
+	{
+		size_t i = 0 ;
+		while ( i < length )
+		{
+			size_t run = PathLiteralRun( text + i, length - i ) ;
+			out.Put( text + i, run ) ;
+			i += run ;
+			if ( i >= length )
+				break ;
+
+			if ( text[i] == '/' )
+			{
+				out.Put( '\\' ) ;
+				i++ ;
+				continue ;
+			}
+			if ( text[i] == '%' )
+			{
+				size_t used = DecodeEscaped( text, length, i, out ) ;
+				if ( used > 0 )
+				{
+					i += used ;
+					continue ;
+				}
+			}
+			out.Put( text[i++] ) ;
+		}
+	}
+
+	static bool DecodeUrl( const UrlChar* url, size_t length, Output& out )
+	{
+		if ( !StartsWith( url, length, "file:" ) )
+			return false ;
+
+		// the query and fragment aren't part of the path
+		size_t end = 5 ;
+		while ( end < length && url[end] != '?' && url[end] != '#' )
+			end++ ;
+		const UrlChar* rest = url + 5 ;
+		size_t restLength = end - 5 ;
+
+		// file://host/path, file:///path, file:////server/share
+		if ( restLength >= 2 && rest[0] == '/' && rest[1] == '/' )
+		{
+			size_t host = 2 ;
+			size_t hostEnd = host ;
+			while ( hostEnd < restLength && rest[hostEnd] != '/' )
+				hostEnd++ ;
+
+			bool local = hostEnd == host || (hostEnd - host == 9 && StartsWith( rest + host, restLength - host, "localhost" )) ;
+			if ( !local )
+			{
+				out.Put( '\\' ) ;
+				out.Put( '\\' ) ;
+				DecodeComponent( rest + host, restLength - host, out ) ;
+				return true ;
+			}
+			rest += hostEnd ;
+			restLength -= hostEnd ;
+			if ( restLength >= 2 && rest[0] == '/' && rest[1] == '/' )
+			{
+				out.Put( '\\' ) ;
+				DecodeComponent( rest + 1, restLength - 1, out ) ;
+				return true ;
+			}
+		}
+
+		// /C:/path, /C|/path, C:/path
+		if ( restLength > 0 && rest[0] == '/' )
+		{
+			rest++ ;
+			restLength-- ;
+		}
+		if ( restLength < 2 || !IsDriveLetter( rest[0] ) || (rest[1] != ':' && rest[1] != '|') || (restLength > 2 && rest[2] != '/') )
+			return false ;
+
+		out.Put( rest[0] ) ;
+		out.Put( ':' ) ;
+		if ( restLength <= 3 )
+			out.Put( '\\' ) ;
+		else
+			DecodeComponent( rest + 2, restLength - 2, out ) ;
+		return true ;
+	}
+} ;
@@ -5,30 +5,37 @@
 
 #pragma once
 
+#include "UrlCodec.h"
+
 class UrlHelper
 {
 public:
 	
-	__declspec(noinline) static CString CreateUrlFromPath( const CString& path )
+	// Returns the file: URL of an absolute path (see UrlCodec), or the path
+	// itself if it isn't one.
+	__declspec(noinline) static CStringW CreateUrlFromPath( const CStringW& path )
 	{
-		// allocate string to hold url
-		CString url ;
-		DWORD dwBufferSize = 4096 ;
-		
-		// normalize the url
-		HRESULT hr = ::UrlCreateFromPath( path, url.GetBufferSetLength(dwBufferSize), &dwBufferSize, 0 ) ;
-		url.ReleaseBuffer() ;
-
-		// returns S_OK for successful conversion and S_FALSE if it didn't need conversion
-		if ( hr == S_OK || hr == S_FALSE )
-		{
-			return url ;
-		}
-		else
-		{
-			// couldn't convert!
-			LOGASSERT(FALSE) ;
-			return path ;
-		}		
+		return Convert( &UrlCodec::PathToUrl, path ) ;
+	}
+
+	// Returns the path of a file: URL, or the URL itself if it isn't one.
+	__declspec(noinline) static CStringW CreatePathFromUrl( const CStringW& url )
+	{
+		return Convert( &UrlCodec::UrlToPath, url ) ;
+	}
+
+private:
+
+	static CStringW Convert( size_t (*convert)( const UrlChar*, size_t, UrlChar*, size_t ), const CStringW& input )
+	{
+		// measure first, so the result is allocated once at its exact size
+		size_t length = convert( input, input.GetLength(), NULL, 0 ) ;
+		if ( length == URL_CODEC_INVALID )
+			return input ;
+
+		CStringW output ;
+		convert( input, input.GetLength(), output.GetBufferSetLength( (int)length ), length + 1 ) ;
+		output.ReleaseBuffer( (int)length ) ;
+		return output ;
 	}
 };
\ No newline at end of file
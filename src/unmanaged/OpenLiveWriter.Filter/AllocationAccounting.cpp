@@ -0,0 +1,94 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "StdAfx.h"
+#include <new>
+#include ".\allocationaccounting.h"
+
+static __declspec(thread) AllocationAccount *t_currentAccount = NULL;
+
+AllocationAccount *AllocationAccount::GetCurrent(void)
+{
+	return t_currentAccount;
+}
+
+AllocationAccount *AllocationAccount::SetCurrent(AllocationAccount *account)
+{
+	AllocationAccount *previous = t_currentAccount;
+	t_currentAccount = account;
+	return previous;
+}
+
+void AllocationAccount::Allocated(int site, size_t cb)
+{
+	Add(counters[site], 1, cb, true);
+	Add(counters[ALLOCATION_SITE_COUNT], 1, cb, true);
+}
+
+void AllocationAccount::Freed(int site, size_t cb)
+{
+	InterlockedExchangeAdd64(&counters[site].liveBytes, -(LONGLONG)cb);
+	InterlockedExchangeAdd64(&counters[ALLOCATION_SITE_COUNT].liveBytes, -(LONGLONG)cb);
+}
+
+void AllocationAccount::Transient(int site, LONG count, size_t cb)
+{
+	Add(counters[site], count, cb, false);
+	Add(counters[ALLOCATION_SITE_COUNT], count, cb, false);
+}
+
+void AllocationAccount::Add(AllocationCounters &c, LONG count, size_t cb, bool live)
+{
+	InterlockedExchangeAdd(&c.allocations, count);
+	InterlockedExchangeAdd64(&c.bytes, (LONGLONG)cb);
+
+	// a transient allocation is live for a moment on top of everything else
+	LONGLONG liveBytes = (live ? InterlockedExchangeAdd64(&c.liveBytes, (LONGLONG)cb) : c.liveBytes) + (LONGLONG)cb;
+
+	LONGLONG peak;
+	while (liveBytes > (peak = c.peakLiveBytes)
+		&& InterlockedCompareExchange64(&c.peakLiveBytes, liveBytes, peak) != peak)
+	{
+	}
+}
+
+#ifdef OLW_ALLOCATION_ACCOUNTING
+
+// Every block remembers its size so that frees can be accounted for. Two
+// words keep the block as aligned as malloc made it.
+struct AllocationHeader
+{
+	size_t size;
+	size_t unused;
+};
+
+void *operator new(size_t size)
+{
+	AllocationHeader *header = static_cast<AllocationHeader*>(malloc(sizeof(AllocationHeader) + size));
+	if (!header)
+		throw std::bad_alloc();
+	header->size = size;
+	ACCOUNT_ALLOCATION(ALLOCATION_SITE_NEW, size);
+	return header + 1;
+}
+
+void *operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void *p)
+{
+	if (!p)
+		return;
+	AllocationHeader *header = static_cast<AllocationHeader*>(p) - 1;
+	ACCOUNT_FREE(ALLOCATION_SITE_NEW, header->size);
+	free(header);
+}
+
+void operator delete[](void *p)
+{
+	operator delete(p);
+}
+
+#endif
@@ -0,0 +1,105 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+#include "AllocationSites.h"
+
+/*
+Opt-in accounting of the filter's heap traffic, per post and per call site.
+It is only built with OLW_ALLOCATION_ACCOUNTING defined; otherwise the macros
+below compile to nothing and operator new is left alone.
+
+Allocations are charged to the account that is current on the allocating
+thread. CWebPostFilter makes its account current for the duration of each
+IFilter call (ALLOCATION_SCOPE) and ParallelHtmlSubFilter passes it on to its
+workers. Anything allocated or freed outside a scope isn't counted, so live
+bytes are only as good as the pairing of allocations and frees within the
+post. Transient allocations are counted without ever becoming live.
+*/
+struct AllocationCounters
+{
+	volatile LONG allocations;
+	volatile LONGLONG bytes;
+	volatile LONGLONG liveBytes;
+	volatile LONGLONG peakLiveBytes;
+};
+
+class AllocationAccount
+{
+	// indexed by AllocationSite, with the totals at ALLOCATION_SITE_COUNT
+	AllocationCounters counters[ALLOCATION_SITE_COUNT + 1];
+
+	void Add(AllocationCounters &c, LONG count, size_t cb, bool live);
+
+public:
+	AllocationAccount(void)
+	{
+		Reset();
+	}
+
+	void Reset(void)
+	{
+		ZeroMemory((void*)counters, sizeof(counters));
+	}
+
+	void Allocated(int site, size_t cb);
+	void Freed(int site, size_t cb);
+	void Transient(int site, LONG count, size_t cb);
+
+	const AllocationCounters &Get(int site) const
+	{
+		return counters[site];
+	}
+
+	static AllocationAccount *GetCurrent(void);
+	// Returns the account that was current before.
+	static AllocationAccount *SetCurrent(AllocationAccount *account);
+};
+
+class AllocationScope
+{
+	AllocationAccount *previous;
+public:
+	AllocationScope(AllocationAccount *account) :
+		previous(AllocationAccount::SetCurrent(account))
+	{
+	}
+
+	~AllocationScope(void)
+	{
+		AllocationAccount::SetCurrent(previous);
+	}
+};
+
+#ifdef OLW_ALLOCATION_ACCOUNTING
+
+#define ALLOCATION_SCOPE(account) AllocationScope _allocationScope(account)
+#define ACCOUNT_ALLOCATION(site, cb) { AllocationAccount *_account = AllocationAccount::GetCurrent(); if (_account) _account->Allocated(site, cb); }
+#define ACCOUNT_FREE(site, cb) { AllocationAccount *_account = AllocationAccount::GetCurrent(); if (_account) _account->Freed(site, cb); }
+#define ACCOUNT_TRANSIENT(site, count, cb) { AllocationAccount *_account = AllocationAccount::GetCurrent(); if (_account) _account->Transient(site, count, cb); }
+
+// What the string manager allocated for s: its header and the characters it
+// rounded the length up to, which is what ATL asks the heap for.
+inline size_t CStringAllocationSize(const CStringA &s)
+{
+	return sizeof(ATL::CStringData) + (s.GetAllocLength() + 1) * sizeof(char);
+}
+
+// CHECK_HRESULT copies __FILE__ and __TIMESTAMP__ into a CStringA each, even
+// when the call succeeded; these are built here instead, so that what they
+// allocated can be measured, and handed on
+#define ACCOUNTED_CHECK_HRESULT(hr) { \
+	CStringA _file(__FILE__), _timestamp(__TIMESTAMP__); \
+	ACCOUNT_TRANSIENT(ALLOCATION_SITE_CHECK_HRESULT, 2, CStringAllocationSize(_file) + CStringAllocationSize(_timestamp)); \
+	_INLINE_CHECK_HRESULT(hr, _file, __LINE__, _timestamp); }
+
+#else
+
+// statements that do nothing, so that they can still follow an if
+#define ALLOCATION_SCOPE(account)
+#define ACCOUNT_ALLOCATION(site, cb) ((void)0)
+#define ACCOUNT_FREE(site, cb) ((void)0)
+#define ACCOUNT_TRANSIENT(site, count, cb) ((void)0)
+#define ACCOUNTED_CHECK_HRESULT(hr) CHECK_HRESULT(hr)
+
+#endif
@@ -0,0 +1,32 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+/*
+The call sites the filter's allocation accounting tells apart (see
+AllocationAccounting.h), shared with the FilterTool that reports them.
+IWebPostFilterAllocations::GetAllocations takes one of these, or
+ALLOCATION_SITE_COUNT for the totals.
+*/
+enum AllocationSite
+{
+	ALLOCATION_SITE_NEW = 0,		// operator new: sub filters, segments, chunks
+	ALLOCATION_SITE_PROPVARIANT,	// ValueSubFilter's copies of its value
+	ALLOCATION_SITE_SAFEBUFFER,		// SafeBuffer, e.g. in CopyStreamToTempFile
+	ALLOCATION_SITE_CHECK_HRESULT,	// the CStringA temporaries CHECK_HRESULT builds
+	ALLOCATION_SITE_COUNT
+};
+
+inline LPCWSTR GetAllocationSiteName(ULONG site)
+{
+	switch (site)
+	{
+	case ALLOCATION_SITE_NEW: return L"new";
+	case ALLOCATION_SITE_PROPVARIANT: return L"PROPVARIANT";
+	case ALLOCATION_SITE_SAFEBUFFER: return L"SafeBuffer";
+	case ALLOCATION_SITE_CHECK_HRESULT: return L"CHECK_HRESULT";
+	case ALLOCATION_SITE_COUNT: return L"total";
+	default: return L"?";
+	}
+}
@@ -0,0 +1,31 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+/*
+Reconstructs the current body of a post from its Contents stream and the
+append-only ContentsJournal that autosave writes next to it. The format is
+defined by PostContentsJournal.cs in OpenLiveWriter.PostEditor:
+
+	header:  magic "OLWJ", version, base length, CRC-32 of the base
+	record:  payload length, CRC-32 of the payload, payload
+	payload: offset, number of bytes removed, inserted bytes
+
+(all integers little-endian DWORDs). Records are applied in order up to the
+first one that is truncated or fails its checksum; a journal whose header
+doesn't match the base is ignored.
+*/
+class ContentsJournal
+{
+public:
+	// Returns a stream positioned at the start of the current body. When the
+	// journal has nothing to apply this is the contents stream itself.
+	static HRESULT Apply(IStream *contents, IStream *journal, IStream **result);
+
+	static DWORD Crc32(const BYTE *data, size_t cb);
+
+private:
+	static HRESULT ReadAll(IStream *stream, CAtlArray<BYTE> &buffer);
+	static DWORD GetDword(const BYTE *data);
+};
@@ -0,0 +1,84 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "StdAfx.h"
+#include ".\filtertrace.h"
+
+FilterTrace::FilterTrace(void) :
+	mapping(NULL), header(NULL), session(0)
+{
+}
+
+FilterTrace::~FilterTrace(void)
+{
+	Detach();
+}
+
+void FilterTrace::Attach(void)
+{
+	Detach();
+
+	mapping = OpenFileMapping(FILE_MAP_READ | FILE_MAP_WRITE, FALSE, FILTER_TRACE_SECTION_NAME);
+	if (!mapping)
+		return;
+
+	header = static_cast<FilterTraceHeader*>(MapViewOfFile(mapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, 0));
+	if (!header
+		|| header->magic != FILTER_TRACE_MAGIC
+		|| header->version != FILTER_TRACE_VERSION
+		|| header->recordSize != sizeof(FilterTraceRecord))
+	{
+		Detach();
+		return;
+	}
+
+	session = (DWORD)InterlockedIncrement(&header->sessions);
+}
+
+void FilterTrace::Detach(void)
+{
+	if (header)
+	{
+		UnmapViewOfFile(header);
+		header = NULL;
+	}
+	if (mapping)
+	{
+		CloseHandle(mapping);
+		mapping = NULL;
+	}
+}
+
+void FilterTrace::Record(DWORD call, ULONGLONG started, HRESULT hr, DWORD argument, DWORD result, ULONGLONG key)
+{
+	if (!header || !started)
+		return;
+
+	ULONGLONG duration = FilterTraceMicroseconds() - started;
+
+	// checked first so that 'next' stops growing once the section is full
+	if ((DWORD)header->next >= header->capacity)
+	{
+		InterlockedIncrement(&header->dropped);
+		return;
+	}
+	DWORD index = (DWORD)InterlockedIncrement(&header->next) - 1;
+	if (index >= header->capacity)
+	{
+		InterlockedIncrement(&header->dropped);
+		return;
+	}
+
+	FilterTraceRecord *record = reinterpret_cast<FilterTraceRecord*>(header + 1) + index;
+	record->session = session;
+	record->hr = hr;
+	record->argument = argument;
+	record->result = result;
+	record->duration = (DWORD)min(duration, (ULONGLONG)MAXDWORD);
+	record->start = started;
+	record->key = key;
+
+	// publish the record
+	MemoryBarrier();
+	record->call = call;
+}
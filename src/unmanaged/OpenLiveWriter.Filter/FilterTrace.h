@@ -0,0 +1,34 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+#include "FilterTraceFormat.h"
+
+/*
+Records the IFilter calls made on one CWebPostFilter into the trace section,
+if the FilterTool has created one (see FilterTraceFormat.h). The section is
+looked for each time a post is loaded, so recording starts and stops with
+the next post. When there is no section every call is a cheap no-op.
+*/
+class FilterTrace
+{
+	HANDLE mapping;
+	FilterTraceHeader *header;
+	DWORD session;
+
+public:
+	FilterTrace(void);
+	~FilterTrace(void);
+
+	// Starts a new session for the post about to be loaded.
+	void Attach(void);
+	void Detach(void);
+
+	// Returns the time to pass to Record, or 0 when not recording.
+	ULONGLONG Start(void) const
+	{
+		return header ? FilterTraceMicroseconds() : 0;
+	}
+
+	void Record(DWORD call, ULONGLONG started, HRESULT hr, DWORD argument = 0, DWORD result = 0, ULONGLONG key = 0);
+};
@@ -0,0 +1,93 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+/*
+Layout of the IFilter call traces CWebPostFilter records (see FilterTrace),
+shared with the FilterTool that captures and replays them.
+
+The trace section is created by the FilterTool, since the search host isn't
+allowed to touch the file system. It starts with a FilterTraceHeader followed
+by room for 'capacity' fixed-size records. Writers reserve a slot by
+incrementing 'next' and publish it by setting its call last; slots that were
+never published (call 0) are skipped. Calls made once the section is full are
+only counted in 'dropped'.
+
+A saved trace file is the header followed by the published records.
+*/
+
+#define FILTER_TRACE_SECTION_NAME L"Global\\OpenLiveWriter.FilterTrace"
+
+const DWORD FILTER_TRACE_MAGIC = 0x54574C4F;	// "OLWT"
+const DWORD FILTER_TRACE_VERSION = 1;
+
+enum FilterTraceCall
+{
+	FILTER_TRACE_NONE = 0,
+	FILTER_TRACE_LOAD_FILE,
+	FILTER_TRACE_LOAD_STREAM,
+	FILTER_TRACE_INIT,
+	FILTER_TRACE_GETCHUNK,
+	FILTER_TRACE_GETTEXT,
+	FILTER_TRACE_GETVALUE,
+	FILTER_TRACE_CALL_COUNT
+};
+
+struct FilterTraceHeader
+{
+	DWORD magic;
+	DWORD version;
+	DWORD recordSize;
+	DWORD capacity;
+	volatile LONG next;
+	volatile LONG dropped;
+	volatile LONG sessions;
+	DWORD unused;
+};
+
+struct FilterTraceRecord
+{
+	DWORD session;		// one per loaded post
+	DWORD call;			// FilterTraceCall
+	HRESULT hr;
+	DWORD argument;		// Load: size of the post; Init: grfFlags; GetText: characters requested
+	DWORD result;		// GetChunk: idChunk; GetText: characters returned
+	DWORD duration;		// microseconds
+	ULONGLONG start;	// microseconds, see FilterTraceMicroseconds
+	ULONGLONG key;		// LoadFile: FilterTraceNameKey of the post's file name
+};
+
+// 64-bit FNV-1a over the lower-cased file name part of a path. Traces
+// identify posts this way, so that a trace can be replayed against a copy of
+// the posts in another directory without recording anyone's post titles.
+inline ULONGLONG FilterTraceNameKey(LPCWSTR path)
+{
+	LPCWSTR name = path;
+	for (LPCWSTR p = path; *p; p++)
+	{
+		if (*p == L'\\' || *p == L'/')
+			name = p + 1;
+	}
+
+	ULONGLONG hash = 0xcbf29ce484222325ULL;
+	for (LPCWSTR p = name; *p; p++)
+	{
+		hash ^= (WORD)towlower(*p);
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+inline ULONGLONG FilterTraceMicroseconds(void)
+{
+	static LARGE_INTEGER frequency = { 0 };
+	if (frequency.QuadPart == 0)
+		QueryPerformanceFrequency(&frequency);
+
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	// split up so the multiplication can't overflow
+	return (counter.QuadPart / frequency.QuadPart) * 1000000
+		+ (counter.QuadPart % frequency.QuadPart) * 1000000 / frequency.QuadPart;
+}
@@ -0,0 +1,259 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "StdAfx.h"
+#include ".\htmlsegmenter.h"
+
+const size_t MAX_TAG_NAME = 16;
+
+static const char *RAW_TEXT_ELEMENTS[] = { "script", "style", "textarea", "title", "xmp" };
+
+static const char *BLOCK_ELEMENTS[] = {
+	"address", "article", "aside", "blockquote", "br", "dd", "div", "dl", "dt", "figure", "footer",
+	"form", "h1", "h2", "h3", "h4", "h5", "h6", "header", "hr", "li", "nav", "ol", "p", "pre",
+	"section", "table", "tbody", "td", "tfoot", "th", "thead", "tr", "ul" };
+
+inline bool IsAsciiAlpha(BYTE c)
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+inline bool IsHtmlSpace(BYTE c)
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f';
+}
+
+inline BYTE ToLowerAscii(BYTE c)
+{
+	return (c >= 'A' && c <= 'Z') ? (BYTE)(c + ('a' - 'A')) : c;
+}
+
+static bool IsOneOf(const char *tagName, const char **names, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		if (strcmp(tagName, names[i]) == 0)
+			return true;
+	}
+	return false;
+}
+
+HRESULT HtmlSegmenter::Split(const BYTE *html, size_t cb, size_t targetSegmentSize, CAtlArray<HtmlSegment> &segments)
+{
+	if (!html && cb)
+		return E_POINTER;
+
+	segments.RemoveAll();
+
+	size_t segmentStart = 0;
+	size_t pos = 0;
+	while (pos < cb)
+	{
+		// text state: jump straight to the next markup
+		const BYTE *next = static_cast<const BYTE*>(memchr(html + pos, '<', cb - pos));
+		if (!next)
+			break;
+		pos = next - html;
+
+		if (pos - segmentStart >= targetSegmentSize && IsSafeBoundary(html, cb, pos))
+		{
+			HtmlSegment segment = { segmentStart, pos - segmentStart };
+			segments.Add(segment);
+			segmentStart = pos;
+		}
+
+		pos = SkipMarkup(html, cb, pos);
+	}
+
+	if (segmentStart < cb || segments.IsEmpty())
+	{
+		HtmlSegment segment = { segmentStart, cb - segmentStart };
+		segments.Add(segment);
+	}
+
+	return S_OK;
+}
+
+// Finds the <meta> tag that declares the character set (<meta charset=...> or
+// <meta http-equiv="Content-Type" content="...; charset=...">), which has to
+// come before <body> or any block-level content.
+bool HtmlSegmenter::FindCharsetDeclaration(const BYTE *html, size_t cb, HtmlSegment &declaration)
+{
+	size_t pos = 0;
+	while (pos < cb)
+	{
+		const BYTE *next = static_cast<const BYTE*>(memchr(html + pos, '<', cb - pos));
+		if (!next)
+			return false;
+		pos = next - html;
+
+		size_t end = SkipMarkup(html, cb, pos);
+		if (pos + 1 < cb && IsAsciiAlpha(html[pos + 1]))
+		{
+			char tagName[MAX_TAG_NAME + 1];
+			ReadTagName(html, cb, pos + 1, tagName, MAX_TAG_NAME + 1);
+			if (strcmp(tagName, "body") == 0 || IsOneOf(tagName, BLOCK_ELEMENTS, _countof(BLOCK_ELEMENTS)))
+				return false;
+			if (strcmp(tagName, "meta") == 0)
+			{
+				for (size_t i = pos + 5; i < end; i++)
+				{
+					if (MatchesIgnoreCase(html, end, i, "charset", 7))
+					{
+						declaration.start = pos;
+						declaration.length = end - pos;
+						return true;
+					}
+				}
+			}
+		}
+		pos = end;
+	}
+	return false;
+}
+
+// Returns the position just past the markup that begins at html[pos] == '<'.
+size_t HtmlSegmenter::SkipMarkup(const BYTE *html, size_t cb, size_t pos)
+{
+	size_t found;
+
+	if (pos + 1 >= cb)
+		return cb;
+
+	BYTE next = html[pos + 1];
+
+	// comment, doctype, CDATA section or processing instruction
+	if (next == '!' || next == '?')
+	{
+		if (next == '!' && pos + 3 < cb && html[pos + 2] == '-' && html[pos + 3] == '-')
+			return FindIgnoreCase(html, cb, pos + 4, "-->", 3, &found) ? found + 3 : cb;
+		if (next == '!' && MatchesIgnoreCase(html, cb, pos + 2, "[CDATA[", 7))
+			return FindIgnoreCase(html, cb, pos + 9, "]]>", 3, &found) ? found + 3 : cb;
+		const BYTE *end = static_cast<const BYTE*>(memchr(html + pos, '>', cb - pos));
+		return end ? (end - html) + 1 : cb;
+	}
+
+	bool endTag = next == '/';
+	size_t nameStart = endTag ? pos + 2 : pos + 1;
+	if (nameStart >= cb || !IsAsciiAlpha(html[nameStart]))
+	{
+		// a stray '<' in text
+		return pos + 1;
+	}
+
+	char tagName[MAX_TAG_NAME + 1];
+	size_t i = ReadTagName(html, cb, nameStart, tagName, MAX_TAG_NAME + 1);
+
+	// scan to the end of the tag, honoring quoted attribute values
+	BYTE quote = 0;
+	bool selfClosing = false;
+	for (; i < cb; i++)
+	{
+		BYTE c = html[i];
+		if (quote)
+		{
+			if (c == quote)
+				quote = 0;
+		}
+		else if (c == '"' || c == '\'')
+		{
+			quote = c;
+		}
+		else if (c == '>')
+		{
+			selfClosing = i > 0 && html[i - 1] == '/';
+			i++;
+			break;
+		}
+	}
+
+	if (!endTag && !selfClosing && IsOneOf(tagName, RAW_TEXT_ELEMENTS, _countof(RAW_TEXT_ELEMENTS)))
+		return SkipRawText(html, cb, i, tagName, strlen(tagName));
+
+	return i;
+}
+
+// Skips the contents of a raw text element up to and including its end tag.
+size_t HtmlSegmenter::SkipRawText(const BYTE *html, size_t cb, size_t pos, const char *tagName, size_t cchTagName)
+{
+	char endTag[MAX_TAG_NAME + 3] = "</";
+	memcpy(endTag + 2, tagName, cchTagName);
+	endTag[cchTagName + 2] = 0;
+
+	size_t found;
+	while (FindIgnoreCase(html, cb, pos, endTag, cchTagName + 2, &found))
+	{
+		size_t after = found + cchTagName + 2;
+		if (after >= cb)
+			return cb;
+		if (html[after] == '>' || html[after] == '/' || IsHtmlSpace(html[after]))
+		{
+			const BYTE *end = static_cast<const BYTE*>(memchr(html + after, '>', cb - after));
+			return end ? (end - html) + 1 : cb;
+		}
+		pos = after;
+	}
+	return cb;
+}
+
+bool HtmlSegmenter::IsSafeBoundary(const BYTE *html, size_t cb, size_t pos)
+{
+	if (pos > 0 && IsHtmlSpace(html[pos - 1]))
+		return true;
+
+	size_t nameStart = pos + 1;
+	if (nameStart < cb && html[nameStart] == '/')
+		nameStart++;
+	if (nameStart >= cb || !IsAsciiAlpha(html[nameStart]))
+		return false;
+
+	char tagName[MAX_TAG_NAME + 1];
+	ReadTagName(html, cb, nameStart, tagName, MAX_TAG_NAME + 1);
+	return IsOneOf(tagName, BLOCK_ELEMENTS, _countof(BLOCK_ELEMENTS));
+}
+
+// Reads a lower-cased tag name (truncated to fit) and returns the position after it.
+size_t HtmlSegmenter::ReadTagName(const BYTE *html, size_t cb, size_t pos, char *tagName, size_t cchTagName)
+{
+	size_t length = 0;
+	for (; pos < cb; pos++)
+	{
+		BYTE c = html[pos];
+		if (IsHtmlSpace(c) || c == '>' || c == '/')
+			break;
+		if (length + 1 < cchTagName)
+			tagName[length++] = (char)ToLowerAscii(c);
+	}
+	tagName[length] = 0;
+	return pos;
+}
+
+bool HtmlSegmenter::MatchesIgnoreCase(const BYTE *html, size_t cb, size_t pos, const char *match, size_t cchMatch)
+{
+	if (pos + cchMatch > cb)
+		return false;
+	for (size_t i = 0; i < cchMatch; i++)
+	{
+		if (ToLowerAscii(html[pos + i]) != ToLowerAscii((BYTE)match[i]))
+			return false;
+	}
+	return true;
+}
+
+// The first character of match must not be a letter; it is located with memchr.
+bool HtmlSegmenter::FindIgnoreCase(const BYTE *html, size_t cb, size_t pos, const char *match, size_t cchMatch, size_t *found)
+{
+	while (pos + cchMatch <= cb)
+	{
+		const BYTE *candidate = static_cast<const BYTE*>(memchr(html + pos, match[0], cb - pos - cchMatch + 1));
+		if (!candidate)
+			return false;
+		if (MatchesIgnoreCase(html, cb, candidate - html, match, cchMatch))
+		{
+			*found = candidate - html;
+			return true;
+		}
+		pos = (candidate - html) + 1;
+	}
+	return false;
+}
@@ -0,0 +1,41 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+/*
+Splits a UTF-8 HTML buffer into segments that can be filtered independently.
+
+Segments only ever begin at the '<' of a tag that is outside of any markup,
+comment or raw text element (<script>, <style>, <textarea>, <title>, <xmp>),
+so a segment never starts inside a tag, a comment or script source. Character
+references can't straddle a boundary either, since '<' always ends them.
+
+To keep words from being glued together or torn apart when the segments are
+filtered separately, a boundary is only taken in front of a block-level tag
+or where the preceding byte is whitespace.
+
+Only the first segment has the document's <head>, so a document in a legacy
+code page has to have its <meta> charset declaration repeated in front of the
+others; FindCharsetDeclaration finds it.
+*/
+struct HtmlSegment
+{
+	size_t start;
+	size_t length;
+};
+
+class HtmlSegmenter
+{
+public:
+	static HRESULT Split(const BYTE *html, size_t cb, size_t targetSegmentSize, CAtlArray<HtmlSegment> &segments);
+	static bool FindCharsetDeclaration(const BYTE *html, size_t cb, HtmlSegment &declaration);
+
+private:
+	static size_t SkipMarkup(const BYTE *html, size_t cb, size_t pos);
+	static size_t SkipRawText(const BYTE *html, size_t cb, size_t pos, const char *tagName, size_t cchTagName);
+	static bool IsSafeBoundary(const BYTE *html, size_t cb, size_t pos);
+	static size_t ReadTagName(const BYTE *html, size_t cb, size_t pos, char *tagName, size_t cchTagName);
+	static bool MatchesIgnoreCase(const BYTE *html, size_t cb, size_t pos, const char *match, size_t cchMatch);
+	static bool FindIgnoreCase(const BYTE *html, size_t cb, size_t pos, const char *match, size_t cchMatch, size_t *found);
+};
@@ -29,6 +29,10 @@ extern "C" BOOL WINAPI DllMain(HINSTANCE hInstance, DWORD dwReason, LPVOID lpRes
         return FALSE;
 #endif
 	hInstance;
+	if (dwReason == DLL_PROCESS_ATTACH)
+		TRACEPOINT_REGISTER();
+	else if (dwReason == DLL_PROCESS_DETACH)
+		TRACEPOINT_UNREGISTER();
     return _AtlModule.DllMain(dwReason, lpReserved); 
 }
 
@@ -0,0 +1,338 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "StdAfx.h"
+#include <process.h>
+#include <filterr.h>
+#include ".\parallelhtmlsubfilter.h"
+
+HRESULT CopyStreamToTempFile(IStream *stream, LPCWSTR extension, LPWSTR fileName, int cbFileName);
+
+const BYTE UTF8_BOM[] = { 0xEF, 0xBB, 0xBF };
+const ULONG TEXT_BUFFER_SIZE = 0x1000;
+
+ParallelHtmlSubFilter::ParallelHtmlSubFilter(const FULLPROPSPEC &aPropSpec, const CLSID &aHtmlFilterClsid) :
+	propSpec(aPropSpec), htmlFilterClsid(aHtmlFilterClsid), byteOrderMark(false), charsetDeclaration(), hasCharsetDeclaration(false), nextSegment(0), cancelled(0),
+	currentSegment(0), currentChunk(0), currentTextPos(0), nextChunkId(0), allocations(NULL)
+{
+}
+
+ParallelHtmlSubFilter::~ParallelHtmlSubFilter(void)
+{
+	try
+	{
+		// workers reference the segments, so they must be gone before we free anything
+		InterlockedExchange(&cancelled, 1);
+		if (!workers.IsEmpty())
+			WaitForMultipleObjects((DWORD)workers.GetCount(), workers.GetData(), TRUE, INFINITE);
+		for (size_t i = 0; i < workers.GetCount(); i++)
+			CloseHandle(workers[i]);
+
+		for (size_t i = 0; i < segments.GetCount(); i++)
+		{
+			Segment *segment = segments[i];
+			for (size_t j = 0; j < segment->chunks.GetCount(); j++)
+				delete segment->chunks[j];
+			if (segment->ready)
+				CloseHandle(segment->ready);
+			delete segment;
+		}
+	}
+	catch(...)
+	{
+	}
+}
+
+HRESULT ParallelHtmlSubFilter::Init(IStream *sourceStream, size_t targetSegmentSize)
+{
+	HRESULT hr;
+
+	// the workers' allocations are charged to the post being filtered
+	allocations = AllocationAccount::GetCurrent();
+
+	STATSTG statstg;
+	if (FAILED(hr = sourceStream->Stat(&statstg, STATFLAG_NONAME)))
+		return hr;
+	if (statstg.cbSize.HighPart)
+		return E_OUTOFMEMORY;
+
+	if (!html.SetCount(statstg.cbSize.LowPart))
+		return E_OUTOFMEMORY;
+
+	ULONG totalRead = 0;
+	while (totalRead < html.GetCount())
+	{
+		ULONG bytesRead = 0;
+		hr = sourceStream->Read(html.GetData() + totalRead, (ULONG)html.GetCount() - totalRead, &bytesRead);
+		if (FAILED(hr))
+			return hr;
+		if (bytesRead == 0)
+			break;
+		totalRead += bytesRead;
+	}
+	html.SetCount(totalRead);
+
+	// the byte order mark is re-applied to every segment when it is filtered
+	byteOrderMark = html.GetCount() >= sizeof(UTF8_BOM) && memcmp(html.GetData(), UTF8_BOM, sizeof(UTF8_BOM)) == 0;
+	size_t bodyStart = byteOrderMark ? sizeof(UTF8_BOM) : 0;
+
+	CAtlArray<HtmlSegment> ranges;
+	if (FAILED(hr = HtmlSegmenter::Split(html.GetData() + bodyStart, html.GetCount() - bodyStart, targetSegmentSize, ranges)))
+		return hr;
+
+	// and so is a <meta> charset declaration, which is all that says how later segments are encoded
+	hasCharsetDeclaration = HtmlSegmenter::FindCharsetDeclaration(html.GetData() + bodyStart, html.GetCount() - bodyStart, charsetDeclaration);
+	if (hasCharsetDeclaration)
+		charsetDeclaration.start += bodyStart;
+
+	for (size_t i = 0; i < ranges.GetCount(); i++)
+	{
+		Segment *segment = new Segment();
+		if (!segment)
+			return E_OUTOFMEMORY;
+		segment->range = ranges[i];
+		segment->range.start += bodyStart;
+		segment->hr = S_OK;
+		segment->ready = CreateEvent(NULL, TRUE, FALSE, NULL);
+		segments.Add(segment);
+		if (!segment->ready)
+			return HRESULT_FROM_WIN32(GetLastError());
+	}
+
+	SYSTEM_INFO systemInfo;
+	GetSystemInfo(&systemInfo);
+	size_t workerCount = min(min(segments.GetCount(), (size_t)systemInfo.dwNumberOfProcessors), (size_t)MAXIMUM_WAIT_OBJECTS);
+	for (size_t i = 0; i < workerCount; i++)
+	{
+		HANDLE worker = (HANDLE)_beginthreadex(NULL, 0, WorkerProc, this, 0, NULL);
+		if (!worker)
+		{
+			// whatever workers did start will still drain every segment
+			if (workers.IsEmpty())
+				return E_OUTOFMEMORY;
+			break;
+		}
+		workers.Add(worker);
+	}
+
+	return S_OK;
+}
+
+unsigned __stdcall ParallelHtmlSubFilter::WorkerProc(void *parameter)
+{
+	// each worker is its own apartment so the HTML filter instances don't
+	// get marshaled back to a single thread
+	HRESULT hrCoInit = CoInitializeEx(NULL, COINIT_APARTMENTTHREADED);
+	ParallelHtmlSubFilter *self = static_cast<ParallelHtmlSubFilter*>(parameter);
+	{
+		ALLOCATION_SCOPE(self->allocations);
+		self->ProcessSegments();
+	}
+	if (SUCCEEDED(hrCoInit))
+		CoUninitialize();
+	return 0;
+}
+
+void ParallelHtmlSubFilter::ProcessSegments(void)
+{
+	while (true)
+	{
+		LONG index = InterlockedIncrement(&nextSegment) - 1;
+		if ((size_t)index >= segments.GetCount())
+			return;
+
+		Segment *segment = segments[index];
+		try
+		{
+			segment->hr = cancelled ? E_ABORT : ExtractSegment(segment);
+		}
+		catch(...)
+		{
+			segment->hr = E_UNEXPECTED;
+		}
+		SetEvent(segment->ready);
+	}
+}
+
+HRESULT ParallelHtmlSubFilter::ExtractSegment(Segment *segment)
+{
+	HRESULT hr;
+	size_t cbBom = byteOrderMark ? sizeof(UTF8_BOM) : 0;
+	size_t cbDeclaration = hasCharsetDeclaration && segment->range.start > charsetDeclaration.start ? charsetDeclaration.length : 0;
+	size_t cbPrefix = cbBom + cbDeclaration;
+
+	HGLOBAL hGlobal = GlobalAlloc(GMEM_MOVEABLE, cbPrefix + segment->range.length);
+	if (!hGlobal)
+		return E_OUTOFMEMORY;
+	BYTE *buffer = static_cast<BYTE*>(GlobalLock(hGlobal));
+	memcpy(buffer, UTF8_BOM, cbBom);
+	if (cbDeclaration)
+		memcpy(buffer + cbBom, html.GetData() + charsetDeclaration.start, cbDeclaration);
+	memcpy(buffer + cbPrefix, html.GetData() + segment->range.start, segment->range.length);
+	GlobalUnlock(hGlobal);
+
+	CComPtr<IStream> segmentStream;
+	if (FAILED(hr = CreateStreamOnHGlobal(hGlobal, TRUE, &segmentStream)))
+	{
+		GlobalFree(hGlobal);
+		return hr;
+	}
+	ULARGE_INTEGER cbSegment;
+	cbSegment.QuadPart = cbPrefix + segment->range.length;
+	if (FAILED(hr = segmentStream->SetSize(cbSegment)))
+		return hr;
+
+	CComQIPtr<IFilter> htmlFilter;
+	if (FAILED(hr = htmlFilter.CoCreateInstance(htmlFilterClsid)))
+		return hr;
+
+	CString tempFileName;
+	CComQIPtr<IPersistStream> persistStream = htmlFilter;
+	if (persistStream)
+	{
+		if (FAILED(hr = persistStream->Load(segmentStream.p)))
+			return hr;
+	}
+	else
+	{
+		CComQIPtr<IPersistFile> persistFile(htmlFilter);
+		if (!persistFile)
+			return E_NOINTERFACE;
+		wchar_t fileName[MAX_PATH + 1];
+		if (FAILED(hr = CopyStreamToTempFile(segmentStream.p, L".htm", fileName, sizeof(fileName))))
+			return hr;
+		tempFileName = fileName;
+		hr = persistFile->Load(fileName, 0);
+	}
+
+	ULONG flags;
+	if (SUCCEEDED(hr))
+		hr = htmlFilter->Init(IFILTER_INIT_INDEXING_ONLY, 0, NULL, &flags);
+
+	WCHAR textBuffer[TEXT_BUFFER_SIZE];
+	while (SUCCEEDED(hr) && !cancelled)
+	{
+		STAT_CHUNK stat;
+		hr = htmlFilter->GetChunk(&stat);
+		if (hr == FILTER_E_END_OF_CHUNKS)
+		{
+			hr = S_OK;
+			break;
+		}
+		if (hr == FILTER_E_EMBEDDING_UNAVAILABLE || hr == FILTER_E_LINK_UNAVAILABLE)
+		{
+			hr = S_OK;
+			continue;
+		}
+		if (FAILED(hr) || !(stat.flags & CHUNK_TEXT))
+			continue;
+
+		TextChunk *chunk = new TextChunk();
+		if (!chunk)
+		{
+			hr = E_OUTOFMEMORY;
+			break;
+		}
+		chunk->stat = stat;
+		segment->chunks.Add(chunk);
+
+		while (true)
+		{
+			ULONG cwc = TEXT_BUFFER_SIZE;
+			SCODE sc = htmlFilter->GetText(&cwc, textBuffer);
+			if (FAILED(sc))
+				break;
+			chunk->text.Append(textBuffer, cwc);
+			if (sc == FILTER_S_LAST_TEXT)
+				break;
+		}
+	}
+
+	if (tempFileName.GetLength() > 0)
+	{
+		htmlFilter.Release();
+		::DeleteFile(tempFileName);
+	}
+
+	return hr;
+}
+
+ParallelHtmlSubFilter::TextChunk *ParallelHtmlSubFilter::CurrentChunk(void)
+{
+	if (currentSegment >= segments.GetCount() || currentChunk == 0)
+		return NULL;
+	Segment *segment = segments[currentSegment];
+	return currentChunk <= segment->chunks.GetCount() ? segment->chunks[currentChunk - 1] : NULL;
+}
+
+SCODE ParallelHtmlSubFilter::GetChunk(
+		STAT_CHUNK * pStat
+		)
+{
+	while (currentSegment < segments.GetCount())
+	{
+		Segment *segment = segments[currentSegment];
+		if (WaitForSingleObject(segment->ready, 0) == WAIT_TIMEOUT)
+			return E_PENDING;
+		if (FAILED(segment->hr))
+			return segment->hr;
+
+		if (currentChunk < segment->chunks.GetCount())
+		{
+			TextChunk *chunk = segment->chunks[currentChunk++];
+			currentTextPos = 0;
+
+			*pStat = chunk->stat;
+			pStat->attribute = propSpec;
+			pStat->idChunk = nextChunkId++;
+			pStat->idChunkSource = pStat->idChunk;
+			pStat->cwcStartSource = 0;
+			pStat->cwcLenSource = 0;
+			return S_OK;
+		}
+
+		// done with this segment, release its text before moving on
+		for (size_t i = 0; i < segment->chunks.GetCount(); i++)
+			delete segment->chunks[i];
+		segment->chunks.RemoveAll();
+		currentSegment++;
+		currentChunk = 0;
+	}
+
+	return FILTER_E_END_OF_CHUNKS;
+}
+
+HANDLE ParallelHtmlSubFilter::GetPendingHandle(void)
+{
+	return currentSegment < segments.GetCount() ? segments[currentSegment]->ready : NULL;
+}
+
+SCODE ParallelHtmlSubFilter::GetText(
+		ULONG * pcwcBuffer,
+		WCHAR * awcBuffer
+		)
+{
+	TextChunk *chunk = CurrentChunk();
+	if (!chunk)
+		return FILTER_E_NO_MORE_TEXT;
+
+	int remaining = chunk->text.GetLength() - currentTextPos;
+	if (remaining <= 0)
+	{
+		*pcwcBuffer = 0;
+		return FILTER_E_NO_MORE_TEXT;
+	}
+
+	ULONG cwc = min(*pcwcBuffer, (ULONG)remaining);
+	memcpy(awcBuffer, chunk->text.GetString() + currentTextPos, cwc * sizeof(WCHAR));
+	currentTextPos += cwc;
+	*pcwcBuffer = cwc;
+	return S_OK;
+}
+
+SCODE ParallelHtmlSubFilter::GetValue(
+		PROPVARIANT ** ppPropValue
+		)
+{
+	return FILTER_E_NO_VALUES;
+}
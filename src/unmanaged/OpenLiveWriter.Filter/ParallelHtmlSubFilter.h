@@ -0,0 +1,76 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+#include "subfilter.h"
+#include "AllocationAccounting.h"
+#include "HtmlSegmenter.h"
+
+/*
+Filters an oversized HTML body by splitting it into segments (see HtmlSegmenter)
+and running a separate instance of the HTML IFilter over each segment on its own
+worker thread. Every segment after the first gets the document's byte order
+mark and <meta> charset declaration in front of it, so that it is decoded the
+same way as the whole document would be. Chunks are handed back strictly in
+document order, renumbered so that chunk ids are contiguous across segment
+boundaries. GetChunk returns E_PENDING rather than blocking while the next
+segment is still being filtered.
+*/
+class ParallelHtmlSubFilter :
+	public SubFilter
+{
+	struct TextChunk
+	{
+		STAT_CHUNK stat;
+		CStringW text;
+	};
+
+	struct Segment
+	{
+		HtmlSegment range;
+		CAtlArray<TextChunk*> chunks;
+		HRESULT hr;
+		HANDLE ready;
+	};
+
+	FULLPROPSPEC propSpec;
+	CLSID htmlFilterClsid;
+	CAtlArray<BYTE> html;
+	bool byteOrderMark;
+	HtmlSegment charsetDeclaration;
+	bool hasCharsetDeclaration;
+	CAtlArray<Segment*> segments;
+	CAtlArray<HANDLE> workers;
+	volatile LONG nextSegment;
+	volatile LONG cancelled;
+	AllocationAccount *allocations;
+
+	size_t currentSegment;
+	size_t currentChunk;
+	int currentTextPos;
+	ULONG nextChunkId;
+
+	static unsigned __stdcall WorkerProc(void *parameter);
+	void ProcessSegments(void);
+	HRESULT ExtractSegment(Segment *segment);
+	TextChunk *CurrentChunk(void);
+
+public:
+	ParallelHtmlSubFilter(const FULLPROPSPEC &propSpec, const CLSID &htmlFilterClsid);
+	virtual ~ParallelHtmlSubFilter(void);
+
+	HRESULT Init(IStream *sourceStream, size_t targetSegmentSize);
+	size_t GetSegmentCount(void) const { return segments.GetCount(); }
+
+	SCODE GetChunk(
+		STAT_CHUNK * pStat
+		);
+	SCODE GetText(
+		ULONG * pcwcBuffer,
+		WCHAR * awcBuffer
+		);
+	SCODE GetValue(
+		PROPVARIANT ** ppPropValue
+		);
+	HANDLE GetPendingHandle(void);
+};
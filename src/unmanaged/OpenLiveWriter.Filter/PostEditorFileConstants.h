@@ -5,6 +5,7 @@
 #define POST_TITLE				L"Title"
 #define POST_LINK				L"Link"
 #define POST_CONTENTS			L"Contents"
+#define POST_CONTENTS_JOURNAL	L"ContentsJournal"
 #define POST_CATEGORIES			L"Categories"
 #define POST_IMAGE_FILES		L"ImageFiles"
 #define POST_DATEPUBLISHED		L"DatePublished"
@@ -15,3 +16,4 @@
 #define POST_EXCERPT			L"Excerpt"
 #define POST_PINGURLS			L"PingUrls"
 #define POST_SUPPORTING_FILES	L"SupportingFiles"
+#define POST_DESTINATION_BLOG_ID	L"DestinationBlogId"
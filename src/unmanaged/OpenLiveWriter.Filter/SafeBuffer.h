@@ -2,19 +2,26 @@
 // Licensed under the MIT license. See LICENSE file in the project root for details.
 
 #pragma once
+#include "AllocationAccounting.h"
 
 class SafeBuffer
 {
+	size_t cb;
+
 public:
 	void *p;
 
-	SafeBuffer(size_t size)
+	SafeBuffer(size_t size) : cb(size)
 	{
 		p = malloc(size);
+		if (p)
+			ACCOUNT_ALLOCATION(ALLOCATION_SITE_SAFEBUFFER, cb);
 	}
 
 	~SafeBuffer(void)
 	{
+		if (p)
+			ACCOUNT_FREE(ALLOCATION_SITE_SAFEBUFFER, cb);
 		free(p);
 	}
 };
@@ -0,0 +1,139 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "StdAfx.h"
+#include <filterr.h>
+#include ".\segmentingsubfilter.h"
+#include ".\wordsegmenter.h"
+
+// how much text is asked of the inner sub filter at a time
+const ULONG SEGMENT_READ_SIZE = 0x1000;
+
+SegmentingSubFilter::SegmentingSubFilter(SubFilter *innerSubFilter) :
+	inner(innerSubFilter), outputPos(0), textDone(false), needSeparator(false)
+{
+}
+
+SegmentingSubFilter::~SegmentingSubFilter(void)
+{
+	delete inner;
+}
+
+SCODE SegmentingSubFilter::GetChunk(
+		STAT_CHUNK * pStat
+		)
+{
+	SCODE sc = inner->GetChunk(pStat);
+	if (SUCCEEDED(sc))
+	{
+		input.Empty();
+		output.Empty();
+		outputPos = 0;
+		textDone = false;
+		needSeparator = false;
+	}
+	return sc;
+}
+
+SCODE SegmentingSubFilter::GetText(
+		ULONG * pcwcBuffer,
+		WCHAR * awcBuffer
+		)
+{
+	if (*pcwcBuffer == 0)
+		return S_OK;
+
+	while (outputPos >= output.GetLength())
+	{
+		if (textDone && input.IsEmpty())
+			return FILTER_E_NO_MORE_TEXT;
+
+		if (!textDone)
+		{
+			int length = input.GetLength();
+			ULONG cwc = SEGMENT_READ_SIZE;
+			SCODE sc = inner->GetText(&cwc, input.GetBuffer(length + SEGMENT_READ_SIZE) + length);
+			input.ReleaseBuffer(length + (SUCCEEDED(sc) ? cwc : 0));
+
+			// a pending read hasn't changed anything, so neither has this call
+			if (sc == E_PENDING)
+				return sc;
+			if (sc == FILTER_E_NO_MORE_TEXT || sc == FILTER_S_LAST_TEXT)
+				textDone = true;
+			else if (FAILED(sc))
+				return sc;
+		}
+		Segment();
+	}
+
+	ULONG cwc = min(*pcwcBuffer, (ULONG)(output.GetLength() - outputPos));
+	memcpy(awcBuffer, (LPCWSTR)output + outputPos, cwc * sizeof(WCHAR));
+	outputPos += cwc;
+	*pcwcBuffer = cwc;
+	return S_OK;
+}
+
+SCODE SegmentingSubFilter::GetValue(
+		PROPVARIANT ** ppPropValue
+		)
+{
+	return inner->GetValue(ppPropValue);
+}
+
+HANDLE SegmentingSubFilter::GetPendingHandle(void)
+{
+	return inner->GetPendingHandle();
+}
+
+// Moves the words that are final from input to output.
+void SegmentingSubFilter::Segment(void)
+{
+	output.Empty();
+	outputPos = 0;
+
+	const WCHAR *text = input;
+	ULONG length = input.GetLength();
+	ULONG heldStart[2];
+	ULONG heldEnd[2];
+	int held = 0;
+	for (ULONG start = 0; start < length; )
+	{
+		ULONG end = WordSegmenter::NextBoundary(text, length, start);
+		if (textDone)
+		{
+			Emit(text + start, end - start);
+		}
+		else
+		{
+			if (held == 2)
+			{
+				Emit(text + heldStart[0], heldEnd[0] - heldStart[0]);
+				heldStart[0] = heldStart[1];
+				heldEnd[0] = heldEnd[1];
+				held = 1;
+			}
+			heldStart[held] = start;
+			heldEnd[held] = end;
+			held++;
+		}
+		start = end;
+	}
+
+	input.Delete(0, held ? heldStart[0] : length);
+}
+
+void SegmentingSubFilter::Emit(const WCHAR *text, ULONG length)
+{
+	if (!WordSegmenter::IsWord(text, length))
+		return;
+
+	if (needSeparator)
+		output.AppendChar(L' ');
+	needSeparator = true;
+
+	int start = output.GetLength();
+	output.Append(text, length);
+	WCHAR *token = output.GetBuffer() + start;
+	WordSegmenter::FoldCase(token, length);
+	output.ReleaseBuffer(start + length);
+}
@@ -0,0 +1,45 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+#include "subfilter.h"
+
+/*
+Wraps another sub filter and replaces the text of its chunks with the words
+in it (see WordSegmenter), case folded and separated by single spaces, so
+that consumers can split on spaces instead of breaking words again. Chunks
+and values are passed through as they are.
+
+Text is read from the inner sub filter a buffer at a time. The last two
+segments of a buffer are held back until more text arrives, because where
+they end can depend on text that hasn't been read yet.
+*/
+class SegmentingSubFilter :
+	public SubFilter
+{
+	SubFilter *inner;
+	CStringW input;
+	CStringW output;
+	int outputPos;
+	bool textDone;
+	bool needSeparator;
+
+	void Segment(void);
+	void Emit(const WCHAR *text, ULONG length);
+public:
+	// Takes ownership of innerSubFilter.
+	SegmentingSubFilter(SubFilter *innerSubFilter);
+	virtual ~SegmentingSubFilter(void);
+
+	SCODE GetChunk(
+		STAT_CHUNK * pStat
+		);
+	SCODE GetText(
+		ULONG * pcwcBuffer,
+		WCHAR * awcBuffer
+		);
+	SCODE GetValue(
+		PROPVARIANT ** ppPropValue
+		);
+	HANDLE GetPendingHandle(void);
+};
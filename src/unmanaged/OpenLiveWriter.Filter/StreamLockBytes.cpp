@@ -32,10 +32,20 @@ LARGE_INTEGER ConvertToLargeInteger(const ULARGE_INTEGER& ulVal)
 	if (!_pStream.p)
 		return E_POINTER;
 
+	TRACEPOINT_START("StreamLockBytesReadAt",
+		TraceLoggingPointer(this, "lockBytes"),
+		TraceLoggingUInt64(ulOffset.QuadPart, "offset"),
+		TraceLoggingUInt32(cb, "bytesRequested"));
+
 	HRESULT hr = _pStream->Seek(ConvertToLargeInteger(ulOffset), STREAM_SEEK_SET, 0);
-	if (FAILED(hr))
-		return hr;
-	return _pStream->Read(pv, cb, pcbRead);
+	if (SUCCEEDED(hr))
+		hr = _pStream->Read(pv, cb, pcbRead);
+
+	TRACEPOINT_STOP("StreamLockBytesReadAt",
+		TraceLoggingPointer(this, "lockBytes"),
+		TraceLoggingUInt32(SUCCEEDED(hr) && pcbRead ? *pcbRead : 0, "bytesRead"),
+		TraceLoggingHResult(hr, "hr"));
+	return hr;
 }
         
 /* [local] */ HRESULT STDMETHODCALLTYPE CStreamLockBytes::WriteAt( 
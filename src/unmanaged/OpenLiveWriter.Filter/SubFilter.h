@@ -8,6 +8,11 @@
 
 /*
 Represents inner components that IFilters can use to delegate.
+
+Any of the calls may return E_PENDING when the data behind the sub filter
+isn't available yet. A pending call has no effect: the sub filter keeps its
+place, and the same call should simply be made again once the handle from
+GetPendingHandle is signaled, or after a short delay if there is no handle.
 */
 class SubFilter
 {
@@ -26,4 +31,10 @@ public:
 		PROPVARIANT ** ppPropValue
 		) = 0;
 
+	// Signaled when the call that last returned E_PENDING is worth retrying.
+	// Owned by the sub filter; NULL if it has nothing to wait on.
+	virtual HANDLE GetPendingHandle(void)
+	{
+		return NULL;
+	}
 };
@@ -0,0 +1,50 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "StdAfx.h"
+#include "SafeBuffer.h"
+
+// For HTML filters that only load from a file: writes the stream out to a
+// temporary file and returns its name, which the caller deletes.
+HRESULT CopyStreamToTempFile(IStream *stream, LPCWSTR extension, LPWSTR fileName, int cbFileName)
+{
+	HRESULT hr;
+
+	CAtlTemporaryFile tempFile;
+	if (FAILED(hr = tempFile.Create()))
+		return hr;
+#define BUF_SIZE 0x2000
+	{
+		SafeBuffer buf(BUF_SIZE);
+		if (buf.p == 0)
+			return E_OUTOFMEMORY;
+		while (hr == S_OK)
+		{
+			ULONG bytesRead;
+			// will return S_FALSE if end of stream?
+			hr = stream->Read(buf.p, BUF_SIZE, &bytesRead);
+			if (hr == S_OK)
+			{
+				if (bytesRead == 0)
+					break;
+				hr = tempFile.Write(buf.p, bytesRead);
+			}
+		}
+	}
+	if (FAILED(hr))
+		return hr;
+	hr = S_OK;  // in case previously set to S_FALSE
+
+	LPCTSTR tempFileName = tempFile.TempFileName();
+
+	if (FAILED(hr = StringCbCopy(fileName, cbFileName, tempFileName)))
+		return hr;
+	if (FAILED(hr = StringCbCat(fileName, cbFileName, L".htm")))
+		return hr;
+
+	hr = tempFile.Close(fileName);
+	if (FAILED(hr))
+		return hr;
+
+	return hr;
+}
@@ -6,7 +6,7 @@
 #include ".\unicodetextstreamsubfilter.h"
 
 UnicodeTextStreamSubFilter::UnicodeTextStreamSubFilter(const FULLPROPSPEC &aPropSpec, IStream *sourceStream) :
-	propSpec(aPropSpec), stream(sourceStream), done(false)
+	propSpec(aPropSpec), stream(sourceStream), done(false), hasCarry(false), carry(0)
 {
 }
 
@@ -39,21 +39,45 @@ SCODE UnicodeTextStreamSubFilter::GetText(
 		WCHAR * awcBuffer
 		)
 {
-	ULONG countBytes = *pcwcBuffer * 2;
-	HRESULT hr = stream->Read(awcBuffer, countBytes, &countBytes);
-	switch (hr)
-	{
-	case S_OK:
-		*pcwcBuffer = countBytes / 2;
-		return countBytes ? S_OK : FILTER_E_NO_MORE_TEXT;
-	case E_PENDING:
-		*pcwcBuffer = 0;
+	if (*pcwcBuffer == 0)
 		return S_OK;
-	case S_FALSE:
-		return FILTER_E_NO_MORE_TEXT;
-	default:
-		return hr;
+
+	BYTE *buffer = reinterpret_cast<BYTE*>(awcBuffer);
+	ULONG countCarried = 0;
+	if (hasCarry)
+	{
+		buffer[0] = carry;
+		countCarried = 1;
 	}
+
+	// a read too short for a whole character isn't the end of the stream;
+	// only one that returns nothing is
+	ULONG countBytes = countCarried;
+	HRESULT hr;
+	do
+	{
+		ULONG bytesRead = 0;
+		hr = stream->Read(buffer + countBytes, *pcwcBuffer * 2 - countBytes, &bytesRead);
+		if (FAILED(hr) && hr != E_PENDING)
+		{
+			*pcwcBuffer = 0;
+			return hr;
+		}
+		if (bytesRead == 0)
+			break;
+		countBytes += bytesRead;
+	} while (countBytes < 2 && hr != E_PENDING);
+
+	// hand over whatever did arrive, even if the rest of it is still pending
+	hasCarry = (countBytes & 1) != 0;
+	if (hasCarry)
+		carry = buffer[countBytes - 1];
+
+	// leave *pcwcBuffer alone when nothing arrived, so a pending call can be repeated as is
+	if (countBytes < 2)
+		return hr == E_PENDING ? E_PENDING : FILTER_E_NO_MORE_TEXT;
+	*pcwcBuffer = countBytes / 2;
+	return S_OK;
 }
 
 SCODE UnicodeTextStreamSubFilter::GetValue(
@@ -62,3 +86,12 @@ SCODE UnicodeTextStreamSubFilter::GetValue(
 {
 	return FILTER_E_NO_VALUES;
 }
+
+HANDLE UnicodeTextStreamSubFilter::GetPendingHandle(void)
+{
+	HANDLE handle = NULL;
+	CComQIPtr<ISynchronizeHandle> synchronize(stream);
+	if (!synchronize || FAILED(synchronize->GetHandle(&handle)))
+		return NULL;
+	return handle;
+}
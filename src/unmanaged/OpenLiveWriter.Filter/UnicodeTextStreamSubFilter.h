@@ -4,12 +4,22 @@
 #pragma once
 #include "subfilter.h"
 
+/*
+Exposes a stream of UTF-16 text as a single text chunk.
+
+Streams that can't produce their data yet (E_PENDING from Read) make GetText
+pending too, unless some text did arrive. A read that ends halfway through a
+character keeps the odd byte for the next call. Streams that support
+ISynchronizeHandle provide the handle to wait on.
+*/
 class UnicodeTextStreamSubFilter :
 	public SubFilter
 {
 	BOOL done;
 	FULLPROPSPEC propSpec;
 	CComPtr<IStream> stream;
+	bool hasCarry;
+	BYTE carry;
 public:
 	UnicodeTextStreamSubFilter(const FULLPROPSPEC &propSpec, IStream *sourceStream);
 	virtual ~UnicodeTextStreamSubFilter(void);
@@ -24,4 +34,5 @@ public:
 	SCODE GetValue(
 		PROPVARIANT ** ppPropValue
 		);
+	HANDLE GetPendingHandle(void);
 };
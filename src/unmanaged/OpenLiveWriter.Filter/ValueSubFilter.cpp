@@ -4,6 +4,23 @@
 #include "StdAfx.h"
 #include <filterr.h>
 #include ".\valuesubfilter.h"
+#include "AllocationAccounting.h"
+
+// the heap memory a copy of the value holds on to, for allocation accounting
+static size_t PropVariantHeapSize(const PROPVARIANT &value)
+{
+	switch (value.vt)
+	{
+	case VT_LPWSTR:
+		return value.pwszVal ? (wcslen(value.pwszVal) + 1) * sizeof(WCHAR) : 0;
+	case VT_LPSTR:
+		return value.pszVal ? strlen(value.pszVal) + 1 : 0;
+	case VT_BSTR:
+		return value.bstrVal ? SysStringByteLen(value.bstrVal) + sizeof(DWORD) + sizeof(WCHAR) : 0;
+	default:
+		return 0;
+	}
+}
 
 ValueSubFilter::ValueSubFilter(const FULLPROPSPEC &aPropSpec) :
 	propSpec(aPropSpec), done(false)
@@ -17,6 +34,8 @@ HRESULT ValueSubFilter::Init(const PROPVARIANT &aValue)
 	if(FAILED(hr))
 		return hr;
 
+	if (PropVariantHeapSize(value))
+		ACCOUNT_ALLOCATION(ALLOCATION_SITE_PROPVARIANT, PropVariantHeapSize(value));
 	return S_OK;
 }
 
@@ -24,6 +43,8 @@ ValueSubFilter::~ValueSubFilter(void)
 {
 	try
 	{
+		if (PropVariantHeapSize(value))
+			ACCOUNT_FREE(ALLOCATION_SITE_PROPVARIANT, PropVariantHeapSize(value));
 		PropVariantClear(&value);
 	}
 	catch(...)
@@ -67,5 +88,9 @@ SCODE ValueSubFilter::GetValue(
 	HRESULT hr = PropVariantCopy(*ppPropValue, &value);
 	if(FAILED(hr))
 		return hr;
+
+	// the copy belongs to the host from here on
+	size_t heapSize = PropVariantHeapSize(value);
+	ACCOUNT_TRANSIENT(ALLOCATION_SITE_PROPVARIANT, heapSize ? 2 : 1, sizeof(PROPVARIANT) + heapSize);
 	return S_OK;
 }
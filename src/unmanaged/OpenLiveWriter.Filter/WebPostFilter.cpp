@@ -13,8 +13,10 @@
 #include "PostEditorFileConstants.h"
 #include "ValueSubFilter.h"
 #include "UnicodeTextStreamSubFilter.h"
-#include "SafeBuffer.h"
 #include "FilterSubFilter.h"
+#include "ParallelHtmlSubFilter.h"
+#include "ContentsJournal.h"
+#include "SegmentingSubFilter.h"
 
 
 const int POS_PERCEIVEDTYPE = 0;
@@ -23,11 +25,71 @@ const int POS_PRIMARYDATE = 2;
 const int POS_KEYWORDS = 3;
 const int POS_BODY = 4;
 
+// bodies at least this large are split up and filtered on multiple threads
+const ULONGLONG PARALLEL_BODY_THRESHOLD = 0x100000;
+const size_t PARALLEL_BODY_MIN_SEGMENT = 0x40000;
+
+// pending calls with no handle to wait on are retried after this interval,
+// which blocked hosts double up to PENDING_POLL_MAX_INTERVAL
+const DWORD PENDING_POLL_INTERVAL = 50;
+const DWORD PENDING_POLL_MAX_INTERVAL = 1000;
+
 inline const FULLPROPSPEC PropSpec(const GUID &guidPropSet, const LPWSTR &lpwstr);
 inline const FULLPROPSPEC PropSpec(const GUID &guidPropSet, ULONG propid);
 HRESULT GetLastModified(LPCTSTR filename, FILETIME *filetime);
+ULONGLONG GetPostSize(LPCTSTR filename);
 HRESULT CopyStreamToTempFile(IStream *stream, LPCWSTR extension, LPWSTR fileName, int cbFileName);
 
+static volatile LONG s_documentCount = 0;
+
+/*
+Brackets a Load with its FilterLoad start and stop events and its trace
+record. Both are written when the guard goes out of scope, so a Load that
+throws, or returns early, still ends them; hr stays E_UNEXPECTED unless the
+Load says otherwise. The post's size is only looked up if somebody is
+listening.
+*/
+class LoadTrace
+{
+	FilterTrace &trace;
+	DWORD call;
+	DWORD documentId;
+	LPCWSTR fileName;
+	ULONGLONG started;
+
+	ULONGLONG GetSize(void) const
+	{
+		return fileName ? GetPostSize(fileName) : bytes;
+	}
+
+public:
+	HRESULT hr;
+	ULONGLONG bytes;		// for a stream, once it has been opened
+	const void *lockBytes;
+
+	LoadTrace(FilterTrace &aTrace, DWORD aCall, DWORD aDocumentId, LPCWSTR aFileName = NULL) :
+		trace(aTrace), call(aCall), documentId(aDocumentId), fileName(aFileName),
+		hr(E_UNEXPECTED), bytes(0), lockBytes(NULL)
+	{
+		TRACEPOINT_START("FilterLoad",
+			TraceLoggingUInt32(documentId, "documentId"));
+		trace.Attach();
+		started = trace.Start();
+	}
+
+	~LoadTrace(void)
+	{
+		if (started)
+			trace.Record(call, started, hr, (DWORD)GetSize(), 0, fileName ? FilterTraceNameKey(fileName) : 0);
+		// ReadAt tracepoints are tagged with the lock bytes rather than the document
+		TRACEPOINT_STOP("FilterLoad",
+			TraceLoggingUInt32(documentId, "documentId"),
+			TraceLoggingUInt64(GetSize(), "bytes"),
+			TraceLoggingPointer(lockBytes, "lockBytes"),
+			TraceLoggingHResult(hr, "hr"));
+	}
+};
+
 // CWebPostFilter
 
 STDMETHODIMP CWebPostFilter::Init(
@@ -39,10 +101,13 @@ STDMETHODIMP CWebPostFilter::Init(
 {
 	try
 	{
+		ALLOCATION_SCOPE(&allocations);
+		ULONGLONG traceStarted = trace.Start();
 		pos = 0;
 		idChunkLastValue = -1;
 		idChunkOffset = 0;
 		CleanupSubFilter();
+		trace.Record(FILTER_TRACE_INIT, traceStarted, S_OK, grfFlags);
 		return S_OK;
 	}
 	catch(HResultException e)
@@ -59,6 +124,9 @@ STDMETHODIMP CWebPostFilter::Init(
 
 void CWebPostFilter::CleanupSubFilter(void)
 {
+	// the wait may be on a handle the sub filter owns
+	CancelReadyCallback();
+
 	SubFilter *localSubFilter = subFilter;
 	if (localSubFilter)
 	{
@@ -73,39 +141,16 @@ STDMETHODIMP CWebPostFilter::GetChunk(
 {
 	try
 	{
-		HRESULT hr = S_OK;
-
-		while (true)
+		ALLOCATION_SCOPE(&allocations);
+		ULONGLONG traceStarted = trace.Start();
+		DWORD pollInterval = PENDING_POLL_INTERVAL;
+		HRESULT hr;
+		while ((hr = GetChunkCore(pStat)) == E_PENDING)
 		{
-			while (!subFilter)
-			{
-				idChunkOffset = idChunkLastValue + 1;
-				hr = NextSubFilter();
-				// no more subfilters to load
-				if (FILTER_E_END_OF_CHUNKS == hr)
-				{
-					return hr;
-				}
-				if (FAILED(hr))
-					return hr;
-			}
-
-			// there is a subfilter--let's try it
-			hr = subFilter->GetChunk(pStat);
-			if (hr == FILTER_E_END_OF_CHUNKS)
-			{
-				CleanupSubFilter();
-				continue;
-			}
-			if (SUCCEEDED(hr))
-			{
-				pStat->idChunk += idChunkOffset;
-				pStat->idChunkSource += idChunkOffset;
-				idChunkLastValue = pStat->idChunk;
-			}
-			return hr;
+			if (FAILED(hr = WaitForPending(pollInterval)))
+				break;
 		}
-
+		trace.Record(FILTER_TRACE_GETCHUNK, traceStarted, hr, 0, SUCCEEDED(hr) ? pStat->idChunk : 0);
 		return hr;
 	}
 	catch(HResultException e)
@@ -120,7 +165,73 @@ STDMETHODIMP CWebPostFilter::GetChunk(
 	}	
 }
 
+HRESULT CWebPostFilter::GetChunkCore(STAT_CHUNK *pStat)
+{
+	HRESULT hr = S_OK;
+
+	while (true)
+	{
+		while (!subFilter)
+		{
+			idChunkOffset = idChunkLastValue + 1;
+			hr = NextSubFilter();
+			// no more subfilters to load
+			if (FILTER_E_END_OF_CHUNKS == hr)
+			{
+				return hr;
+			}
+			if (FAILED(hr))
+				return hr;
+		}
+
+		// there is a subfilter--let's try it
+		hr = subFilter->GetChunk(pStat);
+		if (hr == FILTER_E_END_OF_CHUNKS)
+		{
+			CleanupSubFilter();
+			continue;
+		}
+		if (SUCCEEDED(hr))
+		{
+			pStat->idChunk += idChunkOffset;
+			pStat->idChunkSource += idChunkOffset;
+			idChunkLastValue = pStat->idChunk;
+		}
+		return hr;
+	}
+}
+
 HRESULT CWebPostFilter::NextSubFilter(void)
+{
+	while (true)
+	{
+		CleanupSubFilter();
+
+		TRACEPOINT_START("FilterStage",
+			TraceLoggingUInt32(documentId, "documentId"),
+			TraceLoggingInt32(pos, "stage"));
+
+		// a pending stage is created again from scratch on the next call
+		HRESULT hr = CreateSubFilter(pos);
+
+		TRACEPOINT_STOP("FilterStage",
+			TraceLoggingUInt32(documentId, "documentId"),
+			TraceLoggingInt32(pos, "stage"),
+			TraceLoggingHResult(hr, "hr"));
+		if (hr == E_PENDING || hr == FILTER_E_END_OF_CHUNKS)
+			return hr;
+
+		pos++;
+		if (hr == S_OK && segmentText)
+			subFilter = new SegmentingSubFilter(subFilter);
+		if (hr != S_FALSE)
+			return hr;
+	}
+}
+
+// Creates the sub filter for the given stage. Returns S_FALSE if the post has
+// nothing for that stage.
+HRESULT CWebPostFilter::CreateSubFilter(int stage)
 {
 	static GUID SYSTEM_PROPSET = { 0xB725F130, 0x47EF, 0x101A, { 0xA5, 0xF1, 0x02, 0x60, 0x8C, 0x9E, 0xEB, 0xAC } };
 	static GUID SHAREPOINT_PROPSET = { 0xF29F85E0, 0x4FF9, 0x1068, { 0xAB, 0x91, 0x08, 0x00, 0x2B, 0x27, 0xB3, 0xD9 } };
@@ -131,125 +242,155 @@ HRESULT CWebPostFilter::NextSubFilter(void)
 
 	HRESULT hr = S_OK;
 
-	while (true)
+	switch (stage)
 	{
-		CleanupSubFilter();
-
-		switch (pos++)
+	case POS_PERCEIVEDTYPE:
 		{
-		case POS_PERCEIVEDTYPE:
+			PROPVARIANT var;
+			PropVariantInit(&var);
+			var.vt = VT_LPWSTR;
+			var.pwszVal = L"document";
+			ValueSubFilter* pValueSubFilter = new ValueSubFilter(PropSpec(WDS_PROPSET, L"PerceivedType"));
+			if (!pValueSubFilter)
+				return E_OUTOFMEMORY;
+			hr = pValueSubFilter->Init(var);				
+			if(FAILED(hr))
+				return hr;
+			subFilter = pValueSubFilter;
+			break;
+		}
+	case POS_TITLE:
+		{
+			CComPtr<IStream> stream;
+			hr = OpenTextStream(POST_TITLE, &stream);
+			if (STG_E_FILENOTFOUND == hr)
 			{
-				PROPVARIANT var;
-				PropVariantInit(&var);
-				var.vt = VT_LPWSTR;
-				var.pwszVal = L"document";
-				ValueSubFilter* pValueSubFilter = new ValueSubFilter(PropSpec(WDS_PROPSET, L"PerceivedType"));
-				if (!pValueSubFilter)
-					return E_OUTOFMEMORY;
-				hr = pValueSubFilter->Init(var);				
-				if(FAILED(hr))
-					return hr;
-				subFilter = pValueSubFilter;
-				break;
+				return S_FALSE;
 			}
-		case POS_TITLE:
+			if (FAILED(hr))
 			{
-				CComPtr<IStream> stream;
-				hr = OpenTextStream(POST_TITLE, &stream);
-				if (STG_E_FILENOTFOUND == hr)
-				{
-					continue;
-				}
-				if (FAILED(hr))
-				{
-					return hr;
-				}
-
-				subFilter = new UnicodeTextStreamSubFilter(PropSpec(SHAREPOINT_PROPSET, 2), stream.p);
-				break;
+				return hr;
 			}
-		case POS_PRIMARYDATE:
+
+			subFilter = new UnicodeTextStreamSubFilter(PropSpec(SHAREPOINT_PROPSET, 2), stream.p);
+			break;
+		}
+	case POS_PRIMARYDATE:
+		{
+			PROPVARIANT *var = static_cast<PROPVARIANT*>(CoTaskMemAlloc(sizeof(PROPVARIANT)));
+			if (!var)
+				return E_OUTOFMEMORY;
+			ACCOUNT_TRANSIENT(ALLOCATION_SITE_PROPVARIANT, 1, sizeof(PROPVARIANT));
+			PropVariantInit(var);
+
+			var->vt = VT_FILETIME;
+			var->filetime = lastModified;
+			ValueSubFilter* pValueSubFilter = new ValueSubFilter(PropSpec(WDS_PROPSET, L"PrimaryDate"));
+			hr = pValueSubFilter->Init(*var);
+			PropVariantClear(var);
+			if(FAILED(hr))
+				return hr;
+			subFilter = pValueSubFilter;
+			break;
+		}
+	case POS_KEYWORDS:
+		{
+			CComPtr<IStream> stream;
+			hr = OpenTextStream(POST_KEYWORDS, &stream);
+			if (STG_E_FILENOTFOUND == hr)
+				return S_FALSE;
+			if (FAILED(hr))
+				return hr;
+
+			subFilter = new UnicodeTextStreamSubFilter(PropSpec(SHAREPOINT_PROPSET, 5), stream.p);
+			break;
+		}
+	case POS_BODY:
+		{
+			CComPtr<IStream> sourceStream;
+			if (FAILED(hr = OpenTextStream(POST_CONTENTS, &sourceStream)))
 			{
-				PROPVARIANT *var = static_cast<PROPVARIANT*>(CoTaskMemAlloc(sizeof(PROPVARIANT)));
-				if (!var)
-					return E_OUTOFMEMORY;
-				PropVariantInit(var);
-
-				var->vt = VT_FILETIME;
-				var->filetime = lastModified;
-				ValueSubFilter* pValueSubFilter = new ValueSubFilter(PropSpec(WDS_PROPSET, L"PrimaryDate"));
-				hr = pValueSubFilter->Init(*var);
-				PropVariantClear(var);
-				if(FAILED(hr))
-					return hr;
-				subFilter = pValueSubFilter;
-				break;
+				if (hr == STG_E_FILENOTFOUND)
+					return S_FALSE;
+				return hr;
 			}
-		case POS_KEYWORDS:
-			{
-				CComPtr<IStream> stream;
-				hr = OpenTextStream(POST_KEYWORDS, &stream);
-				if (STG_E_FILENOTFOUND == hr)
-					continue;
-				if (FAILED(hr))
-					return hr;
 
-				subFilter = new UnicodeTextStreamSubFilter(PropSpec(SHAREPOINT_PROPSET, 5), stream.p);
-				break;
-			}
-		case POS_BODY:
+			// autosaved posts keep their latest edits in a journal next to the contents
+			CComPtr<IStream> journalStream;
+			hr = OpenTextStream(POST_CONTENTS_JOURNAL, &journalStream);
+			if (hr == E_PENDING)
+				return hr;
+			if (SUCCEEDED(hr))
 			{
-				CComPtr<IStream> sourceStream;
-				if (FAILED(hr = OpenTextStream(POST_CONTENTS, &sourceStream)))
-				{
-					if (hr == STG_E_FILENOTFOUND)
-						continue;
-					return hr;
-				}
-
-				// 
-				CLSID htmlFilterClsid;
-				if (FAILED(hr = CLSIDFromString(L"{E0CA5340-4534-11CF-B952-00AA0051FE20}", &htmlFilterClsid)))
-					return hr;
-				CComQIPtr<IFilter> htmlFilter;
-
-				if (FAILED(hr = htmlFilter.CoCreateInstance(htmlFilterClsid)))
+				CComPtr<IStream> bodyStream;
+				if (FAILED(hr = ContentsJournal::Apply(sourceStream.p, journalStream.p, &bodyStream)))
 					return hr;
+				sourceStream = bodyStream;
+			}
 
-				// The HTML ifilter should implement IPersistStream,
-				// but I'm not seeing it so far.
+			// 
+			CLSID htmlFilterClsid;
+			if (FAILED(hr = CLSIDFromString(L"{E0CA5340-4534-11CF-B952-00AA0051FE20}", &htmlFilterClsid)))
+				return hr;
 
-				CComQIPtr<IPersistStream> persistStream = htmlFilter;
-				if (persistStream)
+			STATSTG statstg;
+			if (SUCCEEDED(sourceStream->Stat(&statstg, STATFLAG_NONAME)) && statstg.cbSize.QuadPart >= PARALLEL_BODY_THRESHOLD)
+			{
+				SYSTEM_INFO systemInfo;
+				GetSystemInfo(&systemInfo);
+				if (systemInfo.dwNumberOfProcessors > 1)
 				{
-					if (FAILED(hr = persistStream->Load(sourceStream.p)))
+					size_t targetSegmentSize = max((size_t)(statstg.cbSize.QuadPart / (systemInfo.dwNumberOfProcessors * 2)), PARALLEL_BODY_MIN_SEGMENT);
+					ParallelHtmlSubFilter *pParallelSubFilter = new ParallelHtmlSubFilter(PropSpec(SYSTEM_PROPSET, 19), htmlFilterClsid);
+					if (!pParallelSubFilter)
+						return E_OUTOFMEMORY;
+					if (FAILED(hr = pParallelSubFilter->Init(sourceStream.p, targetSegmentSize)))
+					{
+						delete pParallelSubFilter;
 						return hr;
-					subFilter = new FilterSubFilter(PropSpec(SYSTEM_PROPSET, 19), htmlFilter.p, sourceStream.p);
+					}
+					subFilter = pParallelSubFilter;
+					break;
 				}
-				else
-				{
-					wchar_t fileName[MAX_PATH + 1];
-					if (FAILED(hr = CopyStreamToTempFile(sourceStream.p, L".htm", fileName, sizeof(fileName))))
-						return hr;
-					CComQIPtr<IPersistFile> persistFile(htmlFilter);
-					if (!persistFile)
-						continue;
-					if (FAILED(hr = persistFile->Load(fileName, 0)))
-						return hr;
+			}
 
-					subFilter = new FilterSubFilter(PropSpec(SYSTEM_PROPSET, 19), htmlFilter.p, NULL, fileName);
-				}
-				break;
+			CComQIPtr<IFilter> htmlFilter;
+
+			if (FAILED(hr = htmlFilter.CoCreateInstance(htmlFilterClsid)))
+				return hr;
 
+			// The HTML ifilter should implement IPersistStream,
+			// but I'm not seeing it so far.
+
+			CComQIPtr<IPersistStream> persistStream = htmlFilter;
+			if (persistStream)
+			{
+				if (FAILED(hr = persistStream->Load(sourceStream.p)))
+					return hr;
+				subFilter = new FilterSubFilter(PropSpec(SYSTEM_PROPSET, 19), htmlFilter.p, sourceStream.p);
 			}
-		default:
+			else
 			{
-				--pos;
-				return FILTER_E_END_OF_CHUNKS;
+				wchar_t fileName[MAX_PATH + 1];
+				if (FAILED(hr = CopyStreamToTempFile(sourceStream.p, L".htm", fileName, sizeof(fileName))))
+					return hr;
+				CComQIPtr<IPersistFile> persistFile(htmlFilter);
+				if (!persistFile)
+					return S_FALSE;
+				if (FAILED(hr = persistFile->Load(fileName, 0)))
+					return hr;
+
+				subFilter = new FilterSubFilter(PropSpec(SYSTEM_PROPSET, 19), htmlFilter.p, NULL, fileName);
 			}
+			break;
+
+		}
+	default:
+		{
+			return FILTER_E_END_OF_CHUNKS;
 		}
-		return hr;
 	}
+	return S_OK;
 }
 
 HRESULT CWebPostFilter::OpenTextStream(LPCOLESTR streamName, IStream **stream)
@@ -264,10 +405,30 @@ STDMETHODIMP CWebPostFilter::GetText(
 {
 	try
 	{
-		if (subFilter != NULL)
-			return subFilter->GetText(pcwcBuffer, awcBuffer);
-		else
+		if (subFilter == NULL)
 			return E_FAIL;
+
+		ALLOCATION_SCOPE(&allocations);
+		ULONGLONG traceStarted = trace.Start();
+		ULONG requested = *pcwcBuffer;
+		TRACEPOINT_START("FilterGetText",
+			TraceLoggingUInt32(documentId, "documentId"),
+			TraceLoggingUInt32(requested, "charactersRequested"));
+
+		DWORD pollInterval = PENDING_POLL_INTERVAL;
+		HRESULT hr;
+		while ((hr = subFilter->GetText(pcwcBuffer, awcBuffer)) == E_PENDING)
+		{
+			if (FAILED(hr = WaitForPending(pollInterval)))
+				break;
+		}
+
+		TRACEPOINT_STOP("FilterGetText",
+			TraceLoggingUInt32(documentId, "documentId"),
+			TraceLoggingUInt32(SUCCEEDED(hr) ? *pcwcBuffer : 0, "characters"),
+			TraceLoggingHResult(hr, "hr"));
+		trace.Record(FILTER_TRACE_GETTEXT, traceStarted, hr, requested, SUCCEEDED(hr) ? *pcwcBuffer : 0);
+		return hr;
 	}
 	catch(HResultException e)
 	{
@@ -287,10 +448,20 @@ STDMETHODIMP CWebPostFilter::GetValue(
 {
 	try
 	{
-		if (subFilter != NULL)
-			return subFilter->GetValue(ppPropValue);
-		else
+		if (subFilter == NULL)
 			return E_FAIL;
+
+		ALLOCATION_SCOPE(&allocations);
+		ULONGLONG traceStarted = trace.Start();
+		DWORD pollInterval = PENDING_POLL_INTERVAL;
+		HRESULT hr;
+		while ((hr = subFilter->GetValue(ppPropValue)) == E_PENDING)
+		{
+			if (FAILED(hr = WaitForPending(pollInterval)))
+				break;
+		}
+		trace.Record(FILTER_TRACE_GETVALUE, traceStarted, hr);
+		return hr;
 	}
 	catch(HResultException e)
 	{
@@ -304,6 +475,126 @@ STDMETHODIMP CWebPostFilter::GetValue(
 	}	
 }
 
+/*
+The thread pool's wait for a host with a ready callback. It holds the host's
+callback rather than the filter, so that a filter released with a wait still
+outstanding goes away at once, and the wait only has to be disarmed. The
+filter and the thread pool each hold a reference.
+*/
+struct CWebPostFilter::ReadyWait
+{
+	CComPtr<IWebPostFilterReadyCallback> callback;
+	HANDLE wait;
+	volatile LONG references;
+	volatile LONG armed;				// until OnReady is called or the wait is cancelled
+	volatile LONG threadPoolReference;	// until the callback has run or the wait is unregistered
+
+	void Release(void)
+	{
+		if (InterlockedDecrement(&references) == 0)
+			delete this;
+	}
+
+	void ReleaseThreadPoolReference(void)
+	{
+		if (InterlockedExchange(&threadPoolReference, 0) != 0)
+			Release();
+	}
+};
+
+// Called when a sub filter is pending. Hosts with a ready callback get
+// E_PENDING back and are told when to retry; everyone else waits here, and
+// S_OK means the call should be made again.
+HRESULT CWebPostFilter::WaitForPending(DWORD &pollInterval)
+{
+	HANDLE ready = subFilter ? subFilter->GetPendingHandle() : NULL;
+
+	Lock();
+	CComPtr<IWebPostFilterReadyCallback> callback = readyCallback;
+	Unlock();
+	if (callback)
+	{
+		HRESULT hr = ScheduleReadyCallback(callback, ready);
+		return FAILED(hr) ? hr : E_PENDING;
+	}
+
+	if (ready)
+	{
+		if (WaitForSingleObject(ready, INFINITE) == WAIT_FAILED)
+			return HRESULT_FROM_WIN32(GetLastError());
+		return S_OK;
+	}
+
+	// nothing to wait on, so poll, less often the longer the data takes
+	Sleep(pollInterval);
+	pollInterval = min(pollInterval * 2, PENDING_POLL_MAX_INTERVAL);
+	return S_OK;
+}
+
+HRESULT CWebPostFilter::ScheduleReadyCallback(IWebPostFilterReadyCallback *callback, HANDLE ready)
+{
+	// the host already has a callback coming
+	ReadyWait *current = readyWait;
+	if (current && InterlockedCompareExchange(&current->armed, 0, 0) != 0)
+		return S_OK;
+
+	// drop the wait left over from the last callback
+	CancelReadyCallback();
+
+	DWORD timeout = INFINITE;
+	if (!ready)
+	{
+		// nothing to wait on, so wait on an event that is never set and poll
+		if (!pollEvent && !(pollEvent = CreateEvent(NULL, TRUE, FALSE, NULL)))
+			return HRESULT_FROM_WIN32(GetLastError());
+		ready = pollEvent;
+		timeout = PENDING_POLL_INTERVAL;
+	}
+
+	ReadyWait *newWait = new ReadyWait();
+	if (!newWait)
+		return E_OUTOFMEMORY;
+	newWait->callback = callback;
+	newWait->wait = NULL;
+	newWait->references = 2;
+	newWait->armed = 1;
+	newWait->threadPoolReference = 1;
+	if (!RegisterWaitForSingleObject(&newWait->wait, ready, ReadyCallbackProc, newWait, timeout, WT_EXECUTEONLYONCE))
+	{
+		HRESULT hr = HRESULT_FROM_WIN32(GetLastError());
+		delete newWait;
+		return hr;
+	}
+	InterlockedExchangePointer(reinterpret_cast<PVOID volatile*>(&readyWait), newWait);
+	return S_OK;
+}
+
+void CWebPostFilter::CancelReadyCallback(void)
+{
+	ReadyWait *localReadyWait = static_cast<ReadyWait*>(InterlockedExchangePointer(reinterpret_cast<PVOID volatile*>(&readyWait), NULL));
+	if (!localReadyWait)
+		return;
+
+	// Doesn't block, since the host may be calling us from OnReady. Once
+	// disarmed the wait won't call the host, and once unregistered without
+	// its callback running it never will, so its reference is ours to release.
+	InterlockedExchange(&localReadyWait->armed, 0);
+	if (UnregisterWait(localReadyWait->wait))
+		localReadyWait->ReleaseThreadPoolReference();
+	localReadyWait->Release();
+}
+
+VOID CALLBACK CWebPostFilter::ReadyCallbackProc(PVOID parameter, BOOLEAN timedOut)
+{
+	ReadyWait *readyWait = static_cast<ReadyWait*>(parameter);
+
+	// once disarmed, the host may schedule the next callback from OnReady
+	if (InterlockedExchange(&readyWait->armed, 0) != 0)
+		readyWait->callback->OnReady();
+
+	readyWait->ReleaseThreadPoolReference();
+}
+
 STDMETHODIMP CWebPostFilter::BindRegion(
 	FILTERREGION origPos,
 	REFIID riid,
@@ -328,6 +619,8 @@ STDMETHODIMP CWebPostFilter::IsDirty(void)
 
 STDMETHODIMP CWebPostFilter::Load(LPCOLESTR pszFileName, DWORD dwMode)
 {
+	documentId = (DWORD)InterlockedIncrement(&s_documentCount);
+	LoadTrace loadTrace(trace, FILTER_TRACE_LOAD_FILE, documentId, pszFileName);
 	try
 	{
 		ATLASSERT(!stg);
@@ -337,24 +630,29 @@ STDMETHODIMP CWebPostFilter::Load(LPCOLESTR pszFileName, DWORD dwMode)
 
 		pos = 0;
 
-		HRESULT hr = GetLastModified(pszFileName, &lastModified);
-		if (FAILED(hr))
-			return hr;
+		// the previous post's sub filter mustn't count against this one
+		CleanupSubFilter();
+		allocations.Reset();
+		ALLOCATION_SCOPE(&allocations);
 
-		hr = StgOpenStorage(
-			pszFileName, 
-			NULL, 
-			STGM_DIRECT | STGM_READ | STGM_SHARE_DENY_WRITE, 
-			NULL, 
-			0, 
-			&stg);
+		HRESULT hr = GetLastModified(pszFileName, &lastModified);
+		if (SUCCEEDED(hr))
+		{
+			hr = StgOpenStorage(
+				pszFileName, 
+				NULL, 
+				STGM_DIRECT | STGM_READ | STGM_SHARE_DENY_WRITE, 
+				NULL, 
+				0, 
+				&stg);
+		}
 
-		return hr;
+		return loadTrace.hr = hr;
 	}
 	catch(HResultException e)
 	{
 		LOGERROR(e) ;		
-		return e.GetErrorCode() ;
+		return loadTrace.hr = e.GetErrorCode() ;
 	}
 	catch(...)
 	{
@@ -382,18 +680,37 @@ STDMETHODIMP CWebPostFilter::GetCurFile(LPOLESTR * ppszFileName)
 // IPersistStream
 STDMETHODIMP CWebPostFilter::Load(IStream * pStm)
 {
+	documentId = (DWORD)InterlockedIncrement(&s_documentCount);
+	LoadTrace loadTrace(trace, FILTER_TRACE_LOAD_STREAM, documentId);
 	try
 	{
-		CComQIPtr<IStreamLockBytes> pSlb;
-		CHECK_HRESULT(pSlb.CoCreateInstance(CLSID_StreamLockBytes));
-		CHECK_HRESULT(pSlb->Init(pStm));
-		
-		plkbyt = pSlb;
+		CleanupSubFilter();
+		allocations.Reset();
+		ALLOCATION_SCOPE(&allocations);
+
+		// a post in a mapped pack is opened through the pack's own lock bytes
+		// rather than seeked around through a StreamLockBytes. Other streams
+		// that happen to be ILockBytes too aren't trusted to be the same data.
+		CComQIPtr<IWebPostFilterPackedPost> packedPost(pStm);
+		CComPtr<ILockBytes> packedLockBytes;
+		if (packedPost && SUCCEEDED(packedPost->GetLockBytes(&packedLockBytes)))
+		{
+			plkbyt = packedLockBytes;
+		}
+		else
+		{
+			CComQIPtr<IStreamLockBytes> pSlb;
+			ACCOUNTED_CHECK_HRESULT(pSlb.CoCreateInstance(CLSID_StreamLockBytes));
+			ACCOUNTED_CHECK_HRESULT(pSlb->Init(pStm));
+			plkbyt = pSlb;
+		}
 		STATSTG statstg;
-		CHECK_HRESULT(plkbyt->Stat(&statstg, STATFLAG_NONAME));
+		ACCOUNTED_CHECK_HRESULT(plkbyt->Stat(&statstg, STATFLAG_NONAME));
 		lastModified = statstg.mtime;
+		loadTrace.bytes = statstg.cbSize.QuadPart;
+		loadTrace.lockBytes = plkbyt.p;
 
-		CHECK_HRESULT(StgOpenStorageOnILockBytes(
+		ACCOUNTED_CHECK_HRESULT(StgOpenStorageOnILockBytes(
 			plkbyt,
 			NULL,
 			STGM_DIRECT | STGM_READ | STGM_SHARE_DENY_WRITE,
@@ -401,12 +718,12 @@ STDMETHODIMP CWebPostFilter::Load(IStream * pStm)
 			0,
 			&stg));
 
-		return S_OK;
+		return loadTrace.hr = S_OK;
 	}
 	catch(HResultException e)
 	{
 		LOGERROR(e) ;		
-		return e.GetErrorCode() ;
+		return loadTrace.hr = e.GetErrorCode() ;
 	}
 	catch(...)
 	{
@@ -425,6 +742,46 @@ STDMETHODIMP CWebPostFilter::GetSizeMax(ULARGE_INTEGER * pcbSize)
 	return E_NOTIMPL;
 }
 
+// IWebPostFilterAsync
+STDMETHODIMP CWebPostFilter::SetReadyCallback(IWebPostFilterReadyCallback * pCallback)
+{
+	Lock();
+	readyCallback = pCallback;
+	Unlock();
+
+	// a host that drops its callback isn't called back any more
+	if (!pCallback)
+		CancelReadyCallback();
+	return S_OK;
+}
+
+// IWebPostFilterAllocations
+STDMETHODIMP CWebPostFilter::GetAllocations(ULONG site, ULONG * pAllocations, ULONGLONG * pBytes, ULONGLONG * pPeakLiveBytes)
+{
+#ifdef OLW_ALLOCATION_ACCOUNTING
+	if (site > ALLOCATION_SITE_COUNT)
+		return E_INVALIDARG;
+	if (!pAllocations || !pBytes || !pPeakLiveBytes)
+		return E_POINTER;
+
+	const AllocationCounters &counters = allocations.Get(site);
+	*pAllocations = (ULONG)counters.allocations;
+	*pBytes = (ULONGLONG)counters.bytes;
+	*pPeakLiveBytes = (ULONGLONG)counters.peakLiveBytes;
+	return S_OK;
+#else
+	return E_NOTIMPL;
+#endif
+}
+
+// IWebPostFilterSegmentation
+STDMETHODIMP CWebPostFilter::SetSegmentedText(BOOL segmented)
+{
+	// takes effect from the next stage on
+	segmentText = segmented != FALSE;
+	return S_OK;
+}
+
 
 
 
@@ -465,45 +822,10 @@ HRESULT GetLastModified(LPCTSTR filename, FILETIME *filetime)
 	return hr;
 }
 
-HRESULT CopyStreamToTempFile(IStream *stream, LPCWSTR extension, LPWSTR fileName, int cbFileName)
+ULONGLONG GetPostSize(LPCTSTR filename)
 {
-	HRESULT hr;
-
-	CAtlTemporaryFile tempFile;
-	if (FAILED(hr = tempFile.Create()))
-		return hr;
-#define BUF_SIZE 0x2000
-	{
-		SafeBuffer buf(BUF_SIZE);
-		if (buf.p == 0)
-			return E_OUTOFMEMORY;
-		while (hr == S_OK)
-		{
-			ULONG bytesRead;
-			// will return S_FALSE if end of stream?
-			hr = stream->Read(buf.p, BUF_SIZE, &bytesRead);
-			if (hr == S_OK)
-			{
-				if (bytesRead == 0)
-					break;
-				hr = tempFile.Write(buf.p, bytesRead);
-			}
-		}
-	}
-	if (FAILED(hr))
-		return hr;
-	hr = S_OK;  // in case previously set to S_FALSE
-
-	LPCTSTR tempFileName = tempFile.TempFileName();
-
-	if (FAILED(hr = StringCbCopy(fileName, cbFileName, tempFileName)))
-		return hr;
-	if (FAILED(hr = StringCbCat(fileName, cbFileName, L".htm")))
-		return hr;
-
-	hr = tempFile.Close(fileName);
-	if (FAILED(hr))
-		return hr;
-
-	return hr;
-}
\ No newline at end of file
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!GetFileAttributesEx(filename, GetFileExInfoStandard, &attributes))
+		return 0;
+	return ((ULONGLONG)attributes.nFileSizeHigh << 32) | attributes.nFileSizeLow;
+}
@@ -9,10 +9,38 @@
 
 #include "OpenLiveWriter.Filter.h"
 #include "SubFilter.h"
+#include "FilterTrace.h"
+#include "AllocationAccounting.h"
 
 
 // CWebPostFilter
-
+/*
+Sub filters can return E_PENDING when the post's data isn't available yet
+(see SubFilter). Each stage of the filter is a small state machine that
+leaves pos, the current sub filter and the chunk id offset untouched when it
+is pending, so a pending call can simply be made again.
+
+Hosts that can wait register an IWebPostFilterReadyCallback through
+IWebPostFilterAsync. They get E_PENDING straight back, and OnReady is called
+on a thread pool thread once the call is worth retrying (it may retry it
+right there). The wait holds the callback rather than the filter, and is
+cancelled when the filter is released. Other hosts are blocked until the
+data arrives, as they always were; a stream with nothing to wait on is
+polled less and less often until it has some.
+
+While the FilterTool is capturing a trace, the calls made by the host are
+recorded with their arguments, results and timings (see FilterTrace).
+Loading, each stage and each GetText call are also marked with tracepoints
+(see NativeTracepoints.h) tagged with documentId, which numbers the posts
+loaded in this process.
+
+Builds with OLW_ALLOCATION_ACCOUNTING defined count the heap traffic of each
+post, available through IWebPostFilterAllocations until the next Load.
+
+Hosts that want the text already broken into words can turn on segmented
+text through IWebPostFilterSegmentation; text chunks then carry case folded
+words separated by single spaces (see SegmentingSubFilter).
+*/
 class ATL_NO_VTABLE CWebPostFilter : 
 	public CComObjectRootEx<CComMultiThreadModel>,
 	public CComCoClass<CWebPostFilter, &CLSID_WebPostFilter>,
@@ -20,7 +48,10 @@ class ATL_NO_VTABLE CWebPostFilter :
 	public IFilter,
 	//public IPersist,
 	public IPersistStream,
-	public IPersistFile
+	public IPersistFile,
+	public IWebPostFilterAsync,
+	public IWebPostFilterAllocations,
+	public IWebPostFilterSegmentation
 {
 	CComPtr<IStorage> stg;
 	CComPtr<ILockBytes> plkbyt;
@@ -29,14 +60,30 @@ class ATL_NO_VTABLE CWebPostFilter :
 	int idChunkOffset;
 	int idChunkLastValue;
 	SubFilter *subFilter;
+	struct ReadyWait;
+
+	CComPtr<IWebPostFilterReadyCallback> readyCallback;
+	ReadyWait * volatile readyWait;
+	HANDLE pollEvent;
+	FilterTrace trace;
+	DWORD documentId;
+	AllocationAccount allocations;
+	bool segmentText;
 
 	HRESULT OpenTextStream(LPCOLESTR streamName, IStream **stream);
 	HRESULT NextSubFilter(void);
+	HRESULT CreateSubFilter(int stage);
 	void CleanupSubFilter(void);
+	HRESULT GetChunkCore(STAT_CHUNK *pStat);
+	HRESULT WaitForPending(DWORD &pollInterval);
+	HRESULT ScheduleReadyCallback(IWebPostFilterReadyCallback *callback, HANDLE ready);
+	void CancelReadyCallback(void);
+	static VOID CALLBACK ReadyCallbackProc(PVOID parameter, BOOLEAN timedOut);
 
 public:
 	CWebPostFilter() :
-	  stg(NULL), subFilter(NULL), m_pUnkMarshaler(NULL), pos(0), idChunkOffset(0), idChunkLastValue(-1)
+	  stg(NULL), subFilter(NULL), m_pUnkMarshaler(NULL), pos(0), idChunkOffset(0), idChunkLastValue(-1),
+	  readyWait(NULL), pollEvent(NULL), documentId(0), segmentText(false)
 	{
 		ZeroMemory(&lastModified, sizeof(FILETIME));
 	}
@@ -56,6 +103,9 @@ BEGIN_COM_MAP(CWebPostFilter)
 	COM_INTERFACE_ENTRY2(IPersist, IPersistStream)
 	COM_INTERFACE_ENTRY(IPersistStream)
 	COM_INTERFACE_ENTRY(IPersistFile)
+	COM_INTERFACE_ENTRY(IWebPostFilterAsync)
+	COM_INTERFACE_ENTRY(IWebPostFilterAllocations)
+	COM_INTERFACE_ENTRY(IWebPostFilterSegmentation)
 END_COM_MAP()
 
 
@@ -71,6 +121,9 @@ END_COM_MAP()
 	void FinalRelease()
 	{
 		CleanupSubFilter();
+		trace.Detach();
+		if (pollEvent)
+			CloseHandle(pollEvent);
 		m_pUnkMarshaler.Release();
 	}
 
@@ -131,6 +184,24 @@ public:
 	STDMETHOD(GetSizeMax)(
 		ULARGE_INTEGER * pcbSize
 		);
+
+	// IWebPostFilterAsync
+	STDMETHOD(SetReadyCallback)(
+		IWebPostFilterReadyCallback * pCallback
+		);
+
+	// IWebPostFilterAllocations
+	STDMETHOD(GetAllocations)(
+		ULONG site,
+		ULONG * pAllocations,
+		ULONGLONG * pBytes,
+		ULONGLONG * pPeakLiveBytes
+		);
+
+	// IWebPostFilterSegmentation
+	STDMETHOD(SetSegmentedText)(
+		BOOL segmented
+		);
 };
 
 OBJECT_ENTRY_AUTO(__uuidof(WebPostFilter), CWebPostFilter)
@@ -0,0 +1,245 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "StdAfx.h"
+#include <emmintrin.h>
+#include <intrin.h>
+#include ".\wordsegmenter.h"
+#include ".\wordbreaktable.h"
+
+// no more code points past the text
+const int WB_END_OF_TEXT = -1;
+
+inline unsigned int DecodeAt(const WCHAR *text, ULONG length, ULONG pos, ULONG *next)
+{
+	unsigned int c = text[pos];
+	if (c >= 0xD800 && c < 0xDC00 && pos + 1 < length && text[pos + 1] >= 0xDC00 && text[pos + 1] < 0xE000)
+	{
+		*next = pos + 2;
+		return 0x10000 + ((c - 0xD800) << 10) + (text[pos + 1] - 0xDC00);
+	}
+	*next = pos + 1;
+	return c;
+}
+
+inline bool IsAHLetter(int property)
+{
+	return property == WB_ALETTER || property == WB_HEBREW_LETTER;
+}
+
+inline bool IsMidLetterQ(int property)
+{
+	return property == WB_MIDLETTER || property == WB_MIDNUMLET || property == WB_SINGLE_QUOTE;
+}
+
+inline bool IsMidNumQ(int property)
+{
+	return property == WB_MIDNUM || property == WB_MIDNUMLET || property == WB_SINGLE_QUOTE;
+}
+
+// characters that rule WB4 attaches to whatever precedes them
+inline bool IsIgnored(int property)
+{
+	return property == WB_EXTEND || property == WB_FORMAT || property == WB_ZWJ;
+}
+
+inline bool IsAsciiAlphanumeric(WCHAR c)
+{
+	return (c >= L'a' && c <= L'z') || (c >= L'A' && c <= L'Z') || (c >= L'0' && c <= L'9');
+}
+
+// The property of the first code point at or after pos that isn't ignored.
+static int PeekProperty(const WCHAR *text, ULONG length, ULONG pos)
+{
+	while (pos < length)
+	{
+		int property = GetWordBreak(DecodeAt(text, length, pos, &pos)) & WB_PROPERTY_MASK;
+		if (!IsIgnored(property))
+			return property;
+	}
+	return WB_END_OF_TEXT;
+}
+
+bool WordSegmenter::HasSse2(void)
+{
+	static const bool sse2 = IsProcessorFeaturePresent(PF_XMMI64_INSTRUCTIONS_AVAILABLE) != FALSE;
+	return sse2;
+}
+
+// The number of ASCII letters and digits text starts with.
+ULONG WordSegmenter::AsciiAlphanumericRun(const WCHAR *text, ULONG length)
+{
+	ULONG i = 0;
+	if (HasSse2())
+	{
+		// characters from 0x8000 up compare as negative, so they never match
+		const __m128i caseBit = _mm_set1_epi16(0x20);
+		const __m128i beforeA = _mm_set1_epi16(L'a' - 1);
+		const __m128i afterZ = _mm_set1_epi16(L'z' + 1);
+		const __m128i before0 = _mm_set1_epi16(L'0' - 1);
+		const __m128i after9 = _mm_set1_epi16(L'9' + 1);
+		for (; i + 8 <= length; i += 8)
+		{
+			__m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+			__m128i lower = _mm_or_si128(chars, caseBit);
+			__m128i letters = _mm_and_si128(_mm_cmpgt_epi16(lower, beforeA), _mm_cmplt_epi16(lower, afterZ));
+			__m128i digits = _mm_and_si128(_mm_cmpgt_epi16(chars, before0), _mm_cmplt_epi16(chars, after9));
+			int mask = _mm_movemask_epi8(_mm_or_si128(letters, digits));
+			if (mask != 0xFFFF)
+			{
+				unsigned long bit;
+				_BitScanForward(&bit, ~mask & 0xFFFF);
+				return i + bit / 2;
+			}
+		}
+	}
+
+	while (i < length && IsAsciiAlphanumeric(text[i]))
+		i++;
+	return i;
+}
+
+ULONG WordSegmenter::NextBoundary(const WCHAR *text, ULONG length, ULONG start)
+{
+	if (start >= length)
+		return length;
+
+	ULONG pos;
+	unsigned char last = GetWordBreak(DecodeAt(text, length, start, &pos));
+	int property = last & WB_PROPERTY_MASK;
+
+	// WB3, WB3a, WB3b
+	if (property == WB_CR)
+		return pos < length && text[pos] == L'\n' ? pos + 1 : pos;
+	if (property == WB_LF || property == WB_NEWLINE)
+		return pos;
+
+	// the last two code points that weren't ignored, and how many regional
+	// indicators in a row end with the last one
+	int prev = property;
+	int prevPrev = WB_OTHER;
+	int regionalIndicators = property == WB_REGIONAL_INDICATOR ? 1 : 0;
+
+	while (pos < length)
+	{
+		// WB5, WB8, WB9, WB10 for a whole run of ASCII letters and digits
+		if ((IsAHLetter(prev) || prev == WB_NUMERIC) && IsAsciiAlphanumeric(text[pos]))
+		{
+			ULONG run = AsciiAlphanumericRun(text + pos, length - pos);
+			pos += run;
+			last = GetWordBreak(text[pos - 1]);
+			prevPrev = run > 1 ? GetWordBreak(text[pos - 2]) & WB_PROPERTY_MASK : prev;
+			prev = last & WB_PROPERTY_MASK;
+			regionalIndicators = 0;
+			continue;
+		}
+
+		ULONG next;
+		unsigned char flags = GetWordBreak(DecodeAt(text, length, pos, &next));
+		int current = flags & WB_PROPERTY_MASK;
+		int lastProperty = last & WB_PROPERTY_MASK;
+
+		// WB3a, WB3b
+		if (current == WB_CR || current == WB_LF || current == WB_NEWLINE)
+			return pos;
+
+		// WB3c: emoji ZWJ sequences
+		if (lastProperty == WB_ZWJ && (flags & WB_EXTENDED_PICTOGRAPHIC))
+		{
+			prevPrev = prev;
+			prev = current;
+			last = flags;
+			regionalIndicators = 0;
+			pos = next;
+			continue;
+		}
+
+		// WB3d, WB4
+		if ((lastProperty == WB_WSEGSPACE && current == WB_WSEGSPACE) || IsIgnored(current))
+		{
+			last = flags;
+			pos = next;
+			continue;
+		}
+
+		bool join =
+			// WB5
+			(IsAHLetter(prev) && IsAHLetter(current))
+			// WB6, WB7
+			|| (IsAHLetter(prev) && IsMidLetterQ(current) && IsAHLetter(PeekProperty(text, length, next)))
+			|| (IsAHLetter(prevPrev) && IsMidLetterQ(prev) && IsAHLetter(current))
+			// WB7a, WB7b, WB7c
+			|| (prev == WB_HEBREW_LETTER && current == WB_SINGLE_QUOTE)
+			|| (prev == WB_HEBREW_LETTER && current == WB_DOUBLE_QUOTE && PeekProperty(text, length, next) == WB_HEBREW_LETTER)
+			|| (prevPrev == WB_HEBREW_LETTER && prev == WB_DOUBLE_QUOTE && current == WB_HEBREW_LETTER)
+			// WB8, WB9, WB10
+			|| ((prev == WB_NUMERIC || IsAHLetter(prev)) && current == WB_NUMERIC)
+			|| (prev == WB_NUMERIC && IsAHLetter(current))
+			// WB11, WB12
+			|| (prevPrev == WB_NUMERIC && IsMidNumQ(prev) && current == WB_NUMERIC)
+			|| (prev == WB_NUMERIC && IsMidNumQ(current) && PeekProperty(text, length, next) == WB_NUMERIC)
+			// WB13, WB13a, WB13b
+			|| (prev == WB_KATAKANA && current == WB_KATAKANA)
+			|| ((IsAHLetter(prev) || prev == WB_NUMERIC || prev == WB_KATAKANA || prev == WB_EXTENDNUMLET) && current == WB_EXTENDNUMLET)
+			|| (prev == WB_EXTENDNUMLET && (IsAHLetter(current) || current == WB_NUMERIC || current == WB_KATAKANA))
+			// WB15, WB16: regional indicators pair up
+			|| (prev == WB_REGIONAL_INDICATOR && current == WB_REGIONAL_INDICATOR && (regionalIndicators & 1));
+
+		// WB999
+		if (!join)
+			return pos;
+
+		prevPrev = prev;
+		prev = current;
+		last = flags;
+		regionalIndicators = current == WB_REGIONAL_INDICATOR ? regionalIndicators + 1 : 0;
+		pos = next;
+	}
+	return length;
+}
+
+bool WordSegmenter::IsWord(const WCHAR *text, ULONG length)
+{
+	ULONG pos = 0;
+	while (pos < length)
+	{
+		unsigned char flags = GetWordBreak(DecodeAt(text, length, pos, &pos));
+		int property = flags & WB_PROPERTY_MASK;
+		if ((flags & WB_WORD_CHARACTER) || IsAHLetter(property) || property == WB_NUMERIC || property == WB_KATAKANA)
+			return true;
+	}
+	return false;
+}
+
+void WordSegmenter::FoldCase(WCHAR *text, ULONG length)
+{
+	ULONG i = 0;
+	if (HasSse2())
+	{
+		const __m128i beforeA = _mm_set1_epi16(L'A' - 1);
+		const __m128i afterZ = _mm_set1_epi16(L'Z' + 1);
+		const __m128i caseBit = _mm_set1_epi16(0x20);
+		const __m128i nonAsciiBits = _mm_set1_epi16((short)0xFF80);
+		const __m128i zero = _mm_setzero_si128();
+		for (; i + 8 <= length; i += 8)
+		{
+			__m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+			if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(chars, nonAsciiBits), zero)) != 0xFFFF)
+				break;
+			__m128i upper = _mm_and_si128(_mm_cmpgt_epi16(chars, beforeA), _mm_cmplt_epi16(chars, afterZ));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(text + i), _mm_add_epi16(chars, _mm_and_si128(upper, caseBit)));
+		}
+	}
+
+	for (; i < length; i++)
+	{
+		if (text[i] >= 0x80)
+		{
+			// case mapping is one to one in UTF-16, so it can be done in place
+			LCMapStringW(LOCALE_INVARIANT, LCMAP_LOWERCASE, text + i, length - i, text + i, length - i);
+			return;
+		}
+		if (text[i] >= L'A' && text[i] <= L'Z')
+			text[i] += 0x20;
+	}
+}
@@ -0,0 +1,50 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+/*
+Splits UTF-16 text into words following the default word boundary rules of
+UAX #29 (Unicode Text Segmentation), so that the filter's text can be
+tokenized once instead of by every consumer.
+
+Runs of ASCII letters and digits, by far the most common case in posts, are
+skipped eight characters at a time with SSE2 where the processor has it.
+Everything else goes through the rules with the Word_Break property looked up
+in WordBreakTable.h, which is generated from the Unicode Character Database
+by utilities\WordBreakTableGenerator. Unpaired surrogates are treated as
+Word_Break=Other.
+
+Typical use:
+
+	for (ULONG start = 0; start < length; )
+	{
+		ULONG end = WordSegmenter::NextBoundary(text, length, start);
+		if (WordSegmenter::IsWord(text + start, end - start))
+			...
+		start = end;
+	}
+
+Deciding a boundary can take a look at up to two code points (plus any
+Extend/Format/ZWJ) past it, so when text arrives in pieces only the segments
+before the last two are final.
+*/
+class WordSegmenter
+{
+public:
+	// Returns the end of the segment that starts at start, which has to be a
+	// boundary itself. Returns length when start is at or past the end.
+	static ULONG NextBoundary(const WCHAR *text, ULONG length, ULONG start);
+
+	// Whether a segment is a word rather than spaces or punctuation: it has a
+	// letter, a number, or a character that joins into words like they do.
+	static bool IsWord(const WCHAR *text, ULONG length);
+
+	// Lower cases text in place with the invariant locale; ASCII is done
+	// without calling into the system.
+	static void FoldCase(WCHAR *text, ULONG length);
+
+private:
+	static ULONG AsciiAlphanumericRun(const WCHAR *text, ULONG length);
+	static bool HasSse2(void);
+};
@@ -39,6 +39,7 @@
 #include <atlcom.h>
 #include <atlstr.h>
 #include <atlfile.h>
+#include <atlcoll.h>
 
 using namespace ATL;
 
@@ -0,0 +1,83 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+/*
+A fixed-capacity producer/consumer queue. Push blocks while the queue is
+full, which is how downstream stages push back on the ones feeding them.
+*/
+template <class T>
+class BoundedQueue
+{
+public:
+	explicit BoundedQueue(size_t capacity)
+		: m_capacity(max(capacity, (size_t)1)), m_closed(false)
+	{
+		::InitializeCriticalSection(&m_lock);
+		::InitializeConditionVariable(&m_notEmpty);
+		::InitializeConditionVariable(&m_notFull);
+	}
+
+	~BoundedQueue()
+	{
+		::DeleteCriticalSection(&m_lock);
+	}
+
+	// returns false if the queue was closed before the item could be added
+	bool Push(const T &item)
+	{
+		::EnterCriticalSection(&m_lock);
+		while (m_items.GetCount() >= m_capacity && !m_closed)
+			::SleepConditionVariableCS(&m_notFull, &m_lock, INFINITE);
+		bool added = !m_closed;
+		if (added)
+			m_items.AddTail(item);
+		::LeaveCriticalSection(&m_lock);
+		if (added)
+			::WakeConditionVariable(&m_notEmpty);
+		return added;
+	}
+
+	// returns false once the queue is closed and drained
+	bool Pop(T &item)
+	{
+		::EnterCriticalSection(&m_lock);
+		while (m_items.IsEmpty() && !m_closed)
+			::SleepConditionVariableCS(&m_notEmpty, &m_lock, INFINITE);
+		bool removed = !m_items.IsEmpty();
+		if (removed)
+			item = m_items.RemoveHead();
+		::LeaveCriticalSection(&m_lock);
+		if (removed)
+			::WakeConditionVariable(&m_notFull);
+		return removed;
+	}
+
+	void Close()
+	{
+		::EnterCriticalSection(&m_lock);
+		m_closed = true;
+		::LeaveCriticalSection(&m_lock);
+		::WakeAllConditionVariable(&m_notEmpty);
+		::WakeAllConditionVariable(&m_notFull);
+	}
+
+	size_t GetCount()
+	{
+		::EnterCriticalSection(&m_lock);
+		size_t count = m_items.GetCount();
+		::LeaveCriticalSection(&m_lock);
+		return count;
+	}
+
+	size_t GetCapacity() const { return m_capacity; }
+
+private:
+	CRITICAL_SECTION m_lock ;
+	CONDITION_VARIABLE m_notEmpty ;
+	CONDITION_VARIABLE m_notFull ;
+	CAtlList<T> m_items ;
+	size_t m_capacity ;
+	bool m_closed ;
+} ;
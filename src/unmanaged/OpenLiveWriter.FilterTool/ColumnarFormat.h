@@ -0,0 +1,86 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+/*
+Columnar export of posts (.olwc), written by ColumnarWriter and read by
+ColumnarReader.
+
+	file:       ColumnarFileHeader, padded to a block
+	            row groups
+	            footer: a ColumnarRowGroup per row group, then ColumnarTrailer
+	            at the very end of the file
+	row group:  one chunk per column, each starting on a block boundary
+	chunk:      ColumnarChunkHeader, then depending on the encoding
+	              PLAIN:      the end offset of every row's value (DWORD), then
+	                          the UTF-8 bytes of the values
+	              DICTIONARY: the end offset of every distinct value (DWORD),
+	                          the UTF-8 bytes of the values padded to a DWORD,
+	                          then every row's index into the values (DWORD)
+	              FILETIME:   a FILETIME per row (ULONGLONG)
+
+All integers are little-endian. A string column is dictionary encoded
+wherever that halves the number of values stored, which is typically the
+case for blog ids and keywords.
+*/
+
+const DWORD COLUMNAR_MAGIC = 0x434C574F;	// "OLWC"
+const DWORD COLUMNAR_VERSION = 1;
+
+// everything is written in whole blocks, and chunks start on block boundaries
+const DWORD COLUMNAR_BLOCK_SIZE = 0x1000;
+
+enum ColumnarColumn
+{
+	COLUMNAR_ID = 0,
+	COLUMNAR_BLOG_ID,
+	COLUMNAR_TITLE,
+	COLUMNAR_KEYWORDS,
+	COLUMNAR_DATE,
+	COLUMNAR_BODY,
+	COLUMNAR_COLUMN_COUNT
+};
+
+enum ColumnarEncoding
+{
+	COLUMNAR_PLAIN = 1,
+	COLUMNAR_DICTIONARY,
+	COLUMNAR_FILETIME
+};
+
+struct ColumnarFileHeader
+{
+	DWORD magic;
+	DWORD version;
+};
+
+struct ColumnarChunkHeader
+{
+	DWORD encoding;
+	DWORD rowCount;
+	DWORD valueCount;		// distinct values when dictionary encoded, otherwise rowCount
+	DWORD valueBytes;		// size of the UTF-8 bytes, not counting padding
+};
+
+struct ColumnarChunk
+{
+	ULONGLONG offset;
+	ULONGLONG size;
+};
+
+struct ColumnarRowGroup
+{
+	DWORD rowCount;
+	DWORD unused;
+	ColumnarChunk chunks[COLUMNAR_COLUMN_COUNT];
+};
+
+struct ColumnarTrailer
+{
+	ULONGLONG footerOffset;
+	DWORD rowGroupCount;
+	DWORD columnCount;
+	DWORD version;
+	DWORD magic;
+};
@@ -0,0 +1,149 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "stdafx.h"
+#include "ColumnarReader.h"
+
+static const HRESULT COLUMNAR_E_CORRUPT = HRESULT_FROM_WIN32(ERROR_FILE_CORRUPT);
+
+HRESULT ColumnarReader::Open(LPCWSTR path)
+{
+	HRESULT hr;
+
+	CAtlFile file;
+	if (FAILED(hr = file.Create(path, GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN)))
+		return hr;
+	ULONGLONG size;
+	if (FAILED(hr = file.GetSize(size)))
+		return hr;
+	if (size < COLUMNAR_BLOCK_SIZE + sizeof(ColumnarTrailer) || size > (SIZE_T)-1)
+		return COLUMNAR_E_CORRUPT;
+	if (FAILED(hr = m_mapping.MapFile(file)))
+		return hr;
+
+	const BYTE *data = m_mapping;
+	const ColumnarFileHeader *header = reinterpret_cast<const ColumnarFileHeader*>(data);
+	const ColumnarTrailer *trailer = reinterpret_cast<const ColumnarTrailer*>(data + size - sizeof(ColumnarTrailer));
+	if (header->magic != COLUMNAR_MAGIC || trailer->magic != COLUMNAR_MAGIC)
+		return COLUMNAR_E_CORRUPT;
+	if (header->version != COLUMNAR_VERSION || trailer->version != COLUMNAR_VERSION || trailer->columnCount != COLUMNAR_COLUMN_COUNT)
+		return HRESULT_FROM_WIN32(ERROR_UNSUPPORTED_TYPE);
+
+	ULONGLONG footerEnd = size - sizeof(ColumnarTrailer);
+	if (trailer->footerOffset > footerEnd
+		|| (footerEnd - trailer->footerOffset) != (ULONGLONG)trailer->rowGroupCount * sizeof(ColumnarRowGroup))
+		return COLUMNAR_E_CORRUPT;
+
+	m_rowGroups = reinterpret_cast<const ColumnarRowGroup*>(data + trailer->footerOffset);
+	m_rowGroupCount = trailer->rowGroupCount;
+
+	// chunks have to lie between the file header and the footer
+	for (DWORD rowGroup = 0; rowGroup < m_rowGroupCount; rowGroup++)
+	{
+		for (int column = 0; column < COLUMNAR_COLUMN_COUNT; column++)
+		{
+			const ColumnarChunk &chunk = m_rowGroups[rowGroup].chunks[column];
+			if (chunk.offset < COLUMNAR_BLOCK_SIZE || chunk.offset % COLUMNAR_BLOCK_SIZE
+				|| chunk.offset > trailer->footerOffset || chunk.size > trailer->footerOffset - chunk.offset
+				|| chunk.size < sizeof(ColumnarChunkHeader))
+				return COLUMNAR_E_CORRUPT;
+		}
+	}
+	return S_OK;
+}
+
+ULONGLONG ColumnarReader::GetTotalRowCount(void) const
+{
+	ULONGLONG rowCount = 0;
+	for (DWORD rowGroup = 0; rowGroup < m_rowGroupCount; rowGroup++)
+		rowCount += m_rowGroups[rowGroup].rowCount;
+	return rowCount;
+}
+
+HRESULT ColumnarReader::GetChunk(DWORD rowGroup, int column, const ColumnarChunkHeader **header, const BYTE **end) const
+{
+	if (rowGroup >= m_rowGroupCount || column < 0 || column >= COLUMNAR_COLUMN_COUNT)
+		return E_INVALIDARG;
+
+	const ColumnarChunk &chunk = m_rowGroups[rowGroup].chunks[column];
+	const BYTE *start = static_cast<const BYTE*>(m_mapping) + chunk.offset;
+	*header = reinterpret_cast<const ColumnarChunkHeader*>(start);
+	*end = start + chunk.size;
+	if ((*header)->rowCount != m_rowGroups[rowGroup].rowCount)
+		return COLUMNAR_E_CORRUPT;
+	return S_OK;
+}
+
+HRESULT ColumnarReader::GetStringColumn(DWORD rowGroup, int column, ColumnarStringColumn &strings) const
+{
+	HRESULT hr;
+	const ColumnarChunkHeader *header;
+	const BYTE *end;
+	if (FAILED(hr = GetChunk(rowGroup, column, &header, &end)))
+		return hr;
+	if (header->encoding != COLUMNAR_PLAIN && header->encoding != COLUMNAR_DICTIONARY)
+		return E_INVALIDARG;
+
+	bool dictionary = header->encoding == COLUMNAR_DICTIONARY;
+	if (!dictionary && header->valueCount != header->rowCount)
+		return COLUMNAR_E_CORRUPT;
+
+	const BYTE *p = reinterpret_cast<const BYTE*>(header + 1);
+	ULONGLONG available = end - p;
+	ULONGLONG needed = (ULONGLONG)header->valueCount * sizeof(DWORD) + header->valueBytes;
+	if (dictionary)
+		needed = (needed + sizeof(ColumnarChunkHeader) + sizeof(DWORD) - 1) / sizeof(DWORD) * sizeof(DWORD)
+			- sizeof(ColumnarChunkHeader) + (ULONGLONG)header->rowCount * sizeof(DWORD);
+	if (needed > available)
+		return COLUMNAR_E_CORRUPT;
+
+	const DWORD *offsets = reinterpret_cast<const DWORD*>(p);
+	const char *bytes = reinterpret_cast<const char*>(offsets + header->valueCount);
+
+	// offsets only ever grow, so checking each against the last one bounds every value
+	DWORD last = 0;
+	for (DWORD value = 0; value < header->valueCount; value++)
+	{
+		if (offsets[value] < last)
+			return COLUMNAR_E_CORRUPT;
+		last = offsets[value];
+	}
+	if (last != header->valueBytes)
+		return COLUMNAR_E_CORRUPT;
+
+	const DWORD *indexes = NULL;
+	if (dictionary)
+	{
+		size_t padded = ((reinterpret_cast<const BYTE*>(bytes) - reinterpret_cast<const BYTE*>(header)) + header->valueBytes + sizeof(DWORD) - 1)
+			/ sizeof(DWORD) * sizeof(DWORD);
+		indexes = reinterpret_cast<const DWORD*>(reinterpret_cast<const BYTE*>(header) + padded);
+		for (DWORD row = 0; row < header->rowCount; row++)
+		{
+			if (indexes[row] >= header->valueCount)
+				return COLUMNAR_E_CORRUPT;
+		}
+	}
+
+	strings.rowCount = header->rowCount;
+	strings.valueCount = header->valueCount;
+	strings.offsets = offsets;
+	strings.bytes = bytes;
+	strings.indexes = indexes;
+	return S_OK;
+}
+
+HRESULT ColumnarReader::GetDateColumn(DWORD rowGroup, const FILETIME **dates) const
+{
+	HRESULT hr;
+	const ColumnarChunkHeader *header;
+	const BYTE *end;
+	if (FAILED(hr = GetChunk(rowGroup, COLUMNAR_DATE, &header, &end)))
+		return hr;
+	if (header->encoding != COLUMNAR_FILETIME)
+		return E_INVALIDARG;
+	if ((ULONGLONG)header->rowCount * sizeof(FILETIME) > (ULONGLONG)(end - reinterpret_cast<const BYTE*>(header + 1)))
+		return COLUMNAR_E_CORRUPT;
+
+	*dates = reinterpret_cast<const FILETIME*>(header + 1);
+	return S_OK;
+}
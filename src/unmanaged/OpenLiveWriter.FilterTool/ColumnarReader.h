@@ -0,0 +1,66 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+#include "ColumnarFormat.h"
+
+/*
+One string column of one row group, pointing straight into the mapped file.
+Values are UTF-8 and not null terminated.
+*/
+class ColumnarStringColumn
+{
+	friend class ColumnarReader;
+
+	DWORD rowCount;
+	DWORD valueCount;
+	const DWORD *offsets;
+	const char *bytes;
+	const DWORD *indexes;		// NULL unless dictionary encoded
+
+public:
+	ColumnarStringColumn(void) : rowCount(0), valueCount(0), offsets(NULL), bytes(NULL), indexes(NULL)
+	{
+	}
+
+	DWORD GetRowCount(void) const { return rowCount; }
+
+	void Get(DWORD row, const char **value, DWORD *cb) const
+	{
+		DWORD index = indexes ? indexes[row] : row;
+		DWORD start = index ? offsets[index - 1] : 0;
+		*value = bytes + start;
+		*cb = offsets[index] - start;
+	}
+};
+
+/*
+Reads a columnar export file (see ColumnarFormat.h) through a read-only
+mapping of the whole file. Everything the accessors hand out is checked
+against the size of the file once, when the column is opened, so a
+truncated or corrupt file fails with HRESULT_FROM_WIN32(ERROR_FILE_CORRUPT)
+instead of reading out of bounds.
+*/
+class ColumnarReader
+{
+public:
+	ColumnarReader(void) : m_rowGroups(NULL), m_rowGroupCount(0)
+	{
+	}
+
+	HRESULT Open(LPCWSTR path);
+
+	DWORD GetRowGroupCount(void) const { return m_rowGroupCount; }
+	DWORD GetRowCount(DWORD rowGroup) const { return m_rowGroups[rowGroup].rowCount; }
+	ULONGLONG GetTotalRowCount(void) const;
+
+	HRESULT GetStringColumn(DWORD rowGroup, int column, ColumnarStringColumn &strings) const;
+	HRESULT GetDateColumn(DWORD rowGroup, const FILETIME **dates) const;
+
+private:
+	HRESULT GetChunk(DWORD rowGroup, int column, const ColumnarChunkHeader **header, const BYTE **end) const;
+
+	CAtlFileMapping<BYTE> m_mapping;
+	const ColumnarRowGroup *m_rowGroups;
+	DWORD m_rowGroupCount;
+};
@@ -0,0 +1,224 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "stdafx.h"
+#include "ColumnarWriter.h"
+
+ColumnarWriter::ColumnarWriter(void) :
+	m_offset(0), m_pendingBytes(0)
+{
+}
+
+ColumnarWriter::~ColumnarWriter(void)
+{
+}
+
+HRESULT ColumnarWriter::Create(LPCWSTR path)
+{
+	HRESULT hr = m_file.Create(path, GENERIC_WRITE, 0, CREATE_ALWAYS, FILE_FLAG_SEQUENTIAL_SCAN);
+	if (FAILED(hr))
+		return hr;
+
+	ColumnarFileHeader header;
+	header.magic = COLUMNAR_MAGIC;
+	header.version = COLUMNAR_VERSION;
+
+	CAtlArray<BYTE> buffer;
+	Append(buffer, &header, sizeof(header));
+	PadToBlock(buffer);
+	return Write(buffer.GetData(), buffer.GetCount());
+}
+
+HRESULT ColumnarWriter::Append(const ColumnarRow &row)
+{
+	CStringA values[COLUMNAR_COLUMN_COUNT];
+	values[COLUMNAR_ID] = ToUtf8(row.id);
+	values[COLUMNAR_BLOG_ID] = ToUtf8(row.blogId);
+	values[COLUMNAR_TITLE] = ToUtf8(row.title);
+	values[COLUMNAR_KEYWORDS] = ToUtf8(row.keywords);
+	values[COLUMNAR_BODY] = ToUtf8(row.body);
+
+	for (int column = 0; column < COLUMNAR_COLUMN_COUNT; column++)
+	{
+		if (column == COLUMNAR_DATE)
+			continue;
+		m_strings[column].Add(values[column]);
+		m_pendingBytes += values[column].GetLength();
+	}
+	m_dates.Add(((ULONGLONG)row.date.dwHighDateTime << 32) | row.date.dwLowDateTime);
+
+	if (m_dates.GetCount() >= ROW_GROUP_ROWS || m_pendingBytes >= ROW_GROUP_BYTES)
+		return FlushRowGroup();
+	return S_OK;
+}
+
+HRESULT ColumnarWriter::Close(void)
+{
+	HRESULT hr;
+	if (!m_dates.IsEmpty() && FAILED(hr = FlushRowGroup()))
+		return hr;
+
+	ColumnarTrailer trailer;
+	trailer.footerOffset = m_offset;
+	trailer.rowGroupCount = (DWORD)m_rowGroups.GetCount();
+	trailer.columnCount = COLUMNAR_COLUMN_COUNT;
+	trailer.version = COLUMNAR_VERSION;
+	trailer.magic = COLUMNAR_MAGIC;
+
+	// the footer is the one part that isn't padded, so that the trailer ends the file
+	CAtlArray<BYTE> buffer;
+	if (!m_rowGroups.IsEmpty())
+		Append(buffer, m_rowGroups.GetData(), m_rowGroups.GetCount() * sizeof(ColumnarRowGroup));
+	Append(buffer, &trailer, sizeof(trailer));
+	if (FAILED(hr = Write(buffer.GetData(), buffer.GetCount())))
+		return hr;
+
+	m_file.Close();
+	return S_OK;
+}
+
+HRESULT ColumnarWriter::FlushRowGroup(void)
+{
+	ColumnarRowGroup rowGroup;
+	ZeroMemory(&rowGroup, sizeof(rowGroup));
+	rowGroup.rowCount = (DWORD)m_dates.GetCount();
+
+	m_buffer.RemoveAll();
+	for (int column = 0; column < COLUMNAR_COLUMN_COUNT; column++)
+	{
+		size_t start = m_buffer.GetCount();
+		if (column == COLUMNAR_DATE)
+			EncodeDates(m_dates, m_buffer);
+		else
+			EncodeStrings(m_strings[column], m_buffer);
+
+		rowGroup.chunks[column].offset = m_offset + start;
+		rowGroup.chunks[column].size = m_buffer.GetCount() - start;
+		PadToBlock(m_buffer);
+	}
+
+	HRESULT hr = Write(m_buffer.GetData(), m_buffer.GetCount());
+	if (FAILED(hr))
+		return hr;
+	m_rowGroups.Add(rowGroup);
+
+	for (int column = 0; column < COLUMNAR_COLUMN_COUNT; column++)
+		m_strings[column].RemoveAll();
+	m_dates.RemoveAll();
+	m_pendingBytes = 0;
+	return S_OK;
+}
+
+HRESULT ColumnarWriter::Write(const void *data, size_t cb)
+{
+	HRESULT hr = m_file.Write(data, (DWORD)cb);
+	if (FAILED(hr))
+		return hr;
+	m_offset += cb;
+	return S_OK;
+}
+
+void ColumnarWriter::EncodeStrings(const CAtlArray<CStringA> &values, CAtlArray<BYTE> &buffer)
+{
+	DWORD rowCount = (DWORD)values.GetCount();
+
+	// assign every distinct value an index in order of first appearance
+	CAtlMap<CStringA, DWORD, CStringElementTraits<CStringA> > dictionary;
+	dictionary.InitHashTable(AtlPrimeNumberNear(rowCount), false);
+	CAtlArray<DWORD> indexes;
+	indexes.SetCount(rowCount);
+	CAtlArray<size_t> distinct;
+	for (DWORD row = 0; row < rowCount; row++)
+	{
+		const CAtlMap<CStringA, DWORD, CStringElementTraits<CStringA> >::CPair *pair = dictionary.Lookup(values[row]);
+		if (pair)
+		{
+			indexes[row] = pair->m_value;
+		}
+		else
+		{
+			indexes[row] = (DWORD)distinct.GetCount();
+			dictionary.SetAt(values[row], indexes[row]);
+			distinct.Add(row);
+		}
+	}
+
+	bool useDictionary = distinct.GetCount() * 2 <= rowCount;
+
+	ColumnarChunkHeader header;
+	header.encoding = useDictionary ? COLUMNAR_DICTIONARY : COLUMNAR_PLAIN;
+	header.rowCount = rowCount;
+	header.valueCount = useDictionary ? (DWORD)distinct.GetCount() : rowCount;
+	header.valueBytes = 0;
+	for (DWORD value = 0; value < header.valueCount; value++)
+		header.valueBytes += values[useDictionary ? distinct[value] : value].GetLength();
+
+	// size the chunk up front; growing a byte array in small steps is quadratic
+	size_t size = sizeof(header) + header.valueCount * sizeof(DWORD) + header.valueBytes;
+	if (useDictionary)
+		size = (size + sizeof(DWORD) - 1) / sizeof(DWORD) * sizeof(DWORD) + rowCount * sizeof(DWORD);
+	size_t start = buffer.GetCount();
+	buffer.SetCount(start + size, (int)min(max(start + size, (size_t)COLUMNAR_BLOCK_SIZE), (size_t)0x10000000));
+	BYTE *p = buffer.GetData() + start;
+
+	memcpy(p, &header, sizeof(header));
+	DWORD *offsets = reinterpret_cast<DWORD*>(p + sizeof(header));
+	BYTE *bytes = reinterpret_cast<BYTE*>(offsets + header.valueCount);
+	DWORD end = 0;
+	for (DWORD value = 0; value < header.valueCount; value++)
+	{
+		const CStringA &s = values[useDictionary ? distinct[value] : value];
+		memcpy(bytes + end, s.GetString(), s.GetLength());
+		end += s.GetLength();
+		offsets[value] = end;
+	}
+
+	if (useDictionary)
+	{
+		BYTE *padded = bytes + end;
+		while ((padded - p) % sizeof(DWORD))
+			*padded++ = 0;
+		memcpy(padded, indexes.GetData(), rowCount * sizeof(DWORD));
+	}
+}
+
+void ColumnarWriter::EncodeDates(const CAtlArray<ULONGLONG> &values, CAtlArray<BYTE> &buffer)
+{
+	ColumnarChunkHeader header;
+	header.encoding = COLUMNAR_FILETIME;
+	header.rowCount = (DWORD)values.GetCount();
+	header.valueCount = header.rowCount;
+	header.valueBytes = 0;
+
+	Append(buffer, &header, sizeof(header));
+	if (!values.IsEmpty())
+		Append(buffer, values.GetData(), values.GetCount() * sizeof(ULONGLONG));
+}
+
+void ColumnarWriter::Append(CAtlArray<BYTE> &buffer, const void *data, size_t cb)
+{
+	size_t start = buffer.GetCount();
+	buffer.SetCount(start + cb, (int)min(max(start + cb, (size_t)COLUMNAR_BLOCK_SIZE), (size_t)0x10000000));
+	memcpy(buffer.GetData() + start, data, cb);
+}
+
+void ColumnarWriter::PadToBlock(CAtlArray<BYTE> &buffer)
+{
+	size_t padding = (COLUMNAR_BLOCK_SIZE - buffer.GetCount() % COLUMNAR_BLOCK_SIZE) % COLUMNAR_BLOCK_SIZE;
+	if (padding == 0)
+		return;
+	size_t start = buffer.GetCount();
+	buffer.SetCount(start + padding, (int)min(max(start + padding, (size_t)COLUMNAR_BLOCK_SIZE), (size_t)0x10000000));
+	ZeroMemory(buffer.GetData() + start, padding);
+}
+
+CStringA ColumnarWriter::ToUtf8(const CStringW &value)
+{
+	CStringA result;
+	if (value.IsEmpty())
+		return result;
+	int cb = WideCharToMultiByte(CP_UTF8, 0, value, value.GetLength(), NULL, 0, NULL, NULL);
+	WideCharToMultiByte(CP_UTF8, 0, value, value.GetLength(), result.GetBuffer(cb), cb, NULL, NULL);
+	result.ReleaseBuffer(cb);
+	return result;
+}
@@ -0,0 +1,55 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+#include "ColumnarFormat.h"
+
+struct ColumnarRow
+{
+	CStringW id;
+	CStringW blogId;
+	CStringW title;
+	CStringW keywords;
+	FILETIME date;
+	CStringW body;
+};
+
+/*
+Writes posts to a columnar export file (see ColumnarFormat.h). Rows are
+collected in memory until a row group is full, then every column of the
+group is encoded and the whole group goes out in a single block-aligned
+write.
+*/
+class ColumnarWriter
+{
+public:
+	ColumnarWriter(void);
+	~ColumnarWriter(void);
+
+	HRESULT Create(LPCWSTR path);
+	HRESULT Append(const ColumnarRow &row);
+	// Writes the last row group and the footer.
+	HRESULT Close(void);
+
+	ULONGLONG GetBytesWritten(void) const { return m_offset; }
+
+private:
+	static const DWORD ROW_GROUP_ROWS = 0x2000;
+	static const size_t ROW_GROUP_BYTES = 0x4000000;
+
+	HRESULT FlushRowGroup(void);
+	HRESULT Write(const void *data, size_t cb);
+	static void EncodeStrings(const CAtlArray<CStringA> &values, CAtlArray<BYTE> &buffer);
+	static void EncodeDates(const CAtlArray<ULONGLONG> &values, CAtlArray<BYTE> &buffer);
+	static void Append(CAtlArray<BYTE> &buffer, const void *data, size_t cb);
+	static void PadToBlock(CAtlArray<BYTE> &buffer);
+	static CStringA ToUtf8(const CStringW &value);
+
+	CAtlFile m_file;
+	ULONGLONG m_offset;
+	CAtlArray<CStringA> m_strings[COLUMNAR_COLUMN_COUNT];
+	CAtlArray<ULONGLONG> m_dates;
+	size_t m_pendingBytes;
+	CAtlArray<ColumnarRowGroup> m_rowGroups;
+	CAtlArray<BYTE> m_buffer;
+};
@@ -0,0 +1,60 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+/*
+Splits the arguments following a command into positional arguments and
+/name or /name:value options.
+*/
+class CommandLine
+{
+public:
+	CommandLine( int argc, wchar_t *argv[] )
+	{
+		for ( int i = 0; i < argc; i++ )
+		{
+			CString strArg( argv[i] ) ;
+			if ( strArg.GetLength() > 1 && strArg[0] == _T('/') )
+			{
+				int colon = strArg.Find( _T(':') ) ;
+				if ( colon < 0 )
+					m_options.SetAt( strArg.Mid(1), CString() ) ;
+				else
+					m_options.SetAt( strArg.Mid(1, colon - 1), strArg.Mid(colon + 1) ) ;
+			}
+			else
+			{
+				m_arguments.Add( strArg ) ;
+			}
+		}
+	}
+
+	size_t GetArgumentCount() const { return m_arguments.GetCount() ; }
+
+	CString GetArgument( size_t index ) const
+	{
+		return index < m_arguments.GetCount() ? m_arguments[index] : CString() ;
+	}
+
+	bool HasOption( LPCTSTR lpszName ) const
+	{
+		return m_options.Lookup( CString(lpszName) ) != NULL ;
+	}
+
+	CString GetOption( LPCTSTR lpszName, LPCTSTR lpszDefault = _T("") ) const
+	{
+		const CAtlMap<CString, CString, CStringElementTraitsI<CString> >::CPair *pair = m_options.Lookup( CString(lpszName) ) ;
+		return pair ? pair->m_value : CString( lpszDefault ) ;
+	}
+
+	ULONG GetNumericOption( LPCTSTR lpszName, ULONG ulDefault ) const
+	{
+		CString strValue = GetOption( lpszName ) ;
+		return strValue.GetLength() > 0 ? _tcstoul( strValue, NULL, 10 ) : ulDefault ;
+	}
+
+private:
+	CAtlArray<CString> m_arguments ;
+	CAtlMap<CString, CString, CStringElementTraitsI<CString> > m_options ;
+} ;
@@ -0,0 +1,53 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+/*
+64-bit FNV-1a over the raw bytes of a file. Autosave rewrites files whose
+contents often haven't changed at all, so the fingerprint (rather than the
+timestamp) decides whether a post needs to be filtered again.
+*/
+class ContentFingerprint
+{
+public:
+	static const ULONGLONG OFFSET_BASIS = 0xcbf29ce484222325ULL;
+	static const ULONGLONG PRIME = 0x100000001b3ULL;
+
+	static ULONGLONG Update(ULONGLONG hash, const BYTE *data, size_t cb)
+	{
+		for (size_t i = 0; i < cb; i++)
+		{
+			hash ^= data[i];
+			hash *= PRIME;
+		}
+		return hash;
+	}
+
+	static HRESULT FromFile(LPCTSTR path, ULONGLONG *fingerprint)
+	{
+		CAtlFile file;
+		HRESULT hr = file.Create(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN);
+		if (FAILED(hr))
+			return hr;
+
+		const DWORD BUFFER_SIZE = 0x10000;
+		CAtlArray<BYTE> buffer;
+		if (!buffer.SetCount(BUFFER_SIZE))
+			return E_OUTOFMEMORY;
+
+		ULONGLONG hash = OFFSET_BASIS;
+		while (true)
+		{
+			DWORD bytesRead = 0;
+			if (FAILED(hr = file.Read(buffer.GetData(), BUFFER_SIZE, bytesRead)))
+				return hr;
+			if (bytesRead == 0)
+				break;
+			hash = Update(hash, buffer.GetData(), bytesRead);
+		}
+
+		*fingerprint = hash;
+		return S_OK;
+	}
+} ;
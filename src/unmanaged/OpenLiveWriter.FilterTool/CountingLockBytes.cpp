@@ -0,0 +1,139 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "stdafx.h"
+#include "CountingLockBytes.h"
+
+HRESULT CountingLockBytes::Open(LPCWSTR path, CountingLockBytes **ppLockBytes)
+{
+	if (!ppLockBytes)
+		return E_POINTER;
+	*ppLockBytes = NULL;
+
+	HANDLE hFile = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE)
+		return HRESULT_FROM_WIN32(GetLastError());
+
+	*ppLockBytes = new CountingLockBytes(hFile, path);
+	if (!*ppLockBytes)
+	{
+		CloseHandle(hFile);
+		return E_OUTOFMEMORY;
+	}
+	return S_OK;
+}
+
+CountingLockBytes::CountingLockBytes(HANDLE hFile, LPCWSTR path) :
+	m_refCount(1), m_hFile(hFile), m_path(path), m_readCount(0), m_seekCount(0), m_bytesRead(0), m_nextOffset(0)
+{
+}
+
+CountingLockBytes::~CountingLockBytes(void)
+{
+	CloseHandle(m_hFile);
+}
+
+STDMETHODIMP CountingLockBytes::QueryInterface(REFIID riid, void **ppvObject)
+{
+	if (!ppvObject)
+		return E_POINTER;
+	if (riid == IID_IUnknown || riid == IID_ILockBytes)
+	{
+		*ppvObject = static_cast<ILockBytes*>(this);
+		AddRef();
+		return S_OK;
+	}
+	*ppvObject = NULL;
+	return E_NOINTERFACE;
+}
+
+STDMETHODIMP_(ULONG) CountingLockBytes::AddRef(void)
+{
+	return InterlockedIncrement(&m_refCount);
+}
+
+STDMETHODIMP_(ULONG) CountingLockBytes::Release(void)
+{
+	LONG refCount = InterlockedDecrement(&m_refCount);
+	if (refCount == 0)
+		delete this;
+	return refCount;
+}
+
+STDMETHODIMP CountingLockBytes::ReadAt(ULARGE_INTEGER ulOffset, void *pv, ULONG cb, ULONG *pcbRead)
+{
+	OVERLAPPED overlapped = { 0 };
+	overlapped.Offset = ulOffset.LowPart;
+	overlapped.OffsetHigh = ulOffset.HighPart;
+
+	DWORD bytesRead = 0;
+	if (!ReadFile(m_hFile, pv, cb, &bytesRead, &overlapped) && GetLastError() != ERROR_HANDLE_EOF)
+		return STG_E_READFAULT;
+
+	if (ulOffset.QuadPart != m_nextOffset)
+		m_seekCount++;
+	m_readCount++;
+	m_bytesRead += bytesRead;
+	m_nextOffset = ulOffset.QuadPart + bytesRead;
+
+	if (pcbRead)
+		*pcbRead = bytesRead;
+	return S_OK;
+}
+
+STDMETHODIMP CountingLockBytes::WriteAt(ULARGE_INTEGER ulOffset, const void *pv, ULONG cb, ULONG *pcbWritten)
+{
+	return STG_E_ACCESSDENIED;
+}
+
+STDMETHODIMP CountingLockBytes::Flush(void)
+{
+	return S_OK;
+}
+
+STDMETHODIMP CountingLockBytes::SetSize(ULARGE_INTEGER cb)
+{
+	return STG_E_ACCESSDENIED;
+}
+
+STDMETHODIMP CountingLockBytes::LockRegion(ULARGE_INTEGER libOffset, ULARGE_INTEGER cb, DWORD dwLockType)
+{
+	// the file is opened deny-write, so there is nothing left to lock
+	return STG_E_INVALIDFUNCTION;
+}
+
+STDMETHODIMP CountingLockBytes::UnlockRegion(ULARGE_INTEGER libOffset, ULARGE_INTEGER cb, DWORD dwLockType)
+{
+	return STG_E_INVALIDFUNCTION;
+}
+
+STDMETHODIMP CountingLockBytes::Stat(STATSTG *pstatstg, DWORD grfStatFlag)
+{
+	if (!pstatstg)
+		return E_POINTER;
+	ZeroMemory(pstatstg, sizeof(STATSTG));
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_hFile, &size))
+		return HRESULT_FROM_WIN32(GetLastError());
+	FILETIME creationTime, lastAccessTime, lastWriteTime;
+	if (!GetFileTime(m_hFile, &creationTime, &lastAccessTime, &lastWriteTime))
+		return HRESULT_FROM_WIN32(GetLastError());
+
+	pstatstg->type = STGTY_LOCKBYTES;
+	pstatstg->cbSize.QuadPart = size.QuadPart;
+	pstatstg->ctime = creationTime;
+	pstatstg->atime = lastAccessTime;
+	pstatstg->mtime = lastWriteTime;
+	pstatstg->grfMode = STGM_READ | STGM_SHARE_DENY_WRITE;
+
+	if (!(grfStatFlag & STATFLAG_NONAME))
+	{
+		size_t cbName = (m_path.GetLength() + 1) * sizeof(WCHAR);
+		pstatstg->pwcsName = static_cast<LPOLESTR>(CoTaskMemAlloc(cbName));
+		if (!pstatstg->pwcsName)
+			return E_OUTOFMEMORY;
+		memcpy(pstatstg->pwcsName, m_path.GetString(), cbName);
+	}
+	return S_OK;
+}
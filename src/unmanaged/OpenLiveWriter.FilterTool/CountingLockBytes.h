@@ -0,0 +1,49 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+/*
+A read-only, file-backed ILockBytes that counts the reads the compound file
+implementation issues against it. Opening a storage on top of it
+(StgOpenStorageOnILockBytes) shows what reading a post actually costs in
+I/O requests, rather than guessing from its size.
+
+A read is counted as a seek when it doesn't start where the previous read
+ended.
+*/
+class CountingLockBytes : public ILockBytes
+{
+public:
+	static HRESULT Open(LPCWSTR path, CountingLockBytes **ppLockBytes);
+
+	ULONG GetReadCount(void) const { return m_readCount; }
+	ULONG GetSeekCount(void) const { return m_seekCount; }
+	ULONGLONG GetBytesRead(void) const { return m_bytesRead; }
+
+	// IUnknown
+	STDMETHOD(QueryInterface)(REFIID riid, void **ppvObject);
+	STDMETHOD_(ULONG, AddRef)(void);
+	STDMETHOD_(ULONG, Release)(void);
+
+	// ILockBytes
+	STDMETHOD(ReadAt)(ULARGE_INTEGER ulOffset, void *pv, ULONG cb, ULONG *pcbRead);
+	STDMETHOD(WriteAt)(ULARGE_INTEGER ulOffset, const void *pv, ULONG cb, ULONG *pcbWritten);
+	STDMETHOD(Flush)(void);
+	STDMETHOD(SetSize)(ULARGE_INTEGER cb);
+	STDMETHOD(LockRegion)(ULARGE_INTEGER libOffset, ULARGE_INTEGER cb, DWORD dwLockType);
+	STDMETHOD(UnlockRegion)(ULARGE_INTEGER libOffset, ULARGE_INTEGER cb, DWORD dwLockType);
+	STDMETHOD(Stat)(STATSTG *pstatstg, DWORD grfStatFlag);
+
+private:
+	CountingLockBytes(HANDLE hFile, LPCWSTR path);
+	~CountingLockBytes(void);
+
+	LONG m_refCount;
+	HANDLE m_hFile;
+	CStringW m_path;
+	ULONG m_readCount;
+	ULONG m_seekCount;
+	ULONGLONG m_bytesRead;
+	ULONGLONG m_nextOffset;
+};
@@ -0,0 +1,286 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "stdafx.h"
+#include <process.h>
+#include "DraftsIndexer.h"
+#include "ContentFingerprint.h"
+#include "PostExtractor.h"
+
+typedef CComCritSecLock<CComAutoCriticalSection> FingerprintLock;
+
+DraftsIndexer::DraftsIndexer(const DraftsIndexerOptions &aOptions, IndexSink *aSink) :
+	options(aOptions), sink(aSink), queue(aOptions.queueCapacity), fingerprintsDirty(false)
+{
+	if (options.directory.Right(1) != _T("\\"))
+		options.directory += _T("\\");
+}
+
+HRESULT DraftsIndexer::Run(HANDLE stopEvent)
+{
+	HRESULT hr;
+
+	if (options.statePath.GetLength() > 0 && FAILED(hr = LoadState()))
+		LOGERROR_HR(hr);
+
+	// start watching before the initial scan so nothing slips between the two
+	DraftsWatcher watcher(metrics);
+	if (FAILED(hr = watcher.Start(options.directory)))
+		return hr;
+
+	CAtlArray<HANDLE> workers;
+	for (size_t i = 0; i < max(options.workerCount, (size_t)1); i++)
+	{
+		HANDLE worker = (HANDLE)_beginthreadex(NULL, 0, WorkerProc, this, 0, NULL);
+		if (worker)
+			workers.Add(worker);
+	}
+	if (workers.IsEmpty())
+		return E_OUTOFMEMORY;
+
+	MetricsServer metricsServer(metrics);
+	if (options.metricsPipe.GetLength() > 0 &&
+		FAILED(hr = metricsServer.Start(options.metricsPipe, GetQueueDepth, GetDocumentCount, queue.GetCapacity(), this)))
+	{
+		LOGERROR_HR(hr);
+	}
+
+	EnqueueDirectory();
+
+	DWORD pollInterval = max(options.debounceMilliseconds / 4, (DWORD)50);
+	while (WaitForSingleObject(stopEvent, pollInterval) == WAIT_TIMEOUT)
+	{
+		CAtlArray<DraftChange> settled;
+		if (watcher.CollectSettled(options.debounceMilliseconds, settled))
+			EnqueueDirectory();
+		for (size_t i = 0; i < settled.GetCount(); i++)
+			Enqueue(settled[i]);
+	}
+
+	watcher.Stop();
+	queue.Close();
+	WaitForMultipleObjects((DWORD)workers.GetCount(), workers.GetData(), TRUE, INFINITE);
+	for (size_t i = 0; i < workers.GetCount(); i++)
+		CloseHandle(workers[i]);
+	metricsServer.Stop();
+
+	if (options.statePath.GetLength() > 0 && FAILED(hr = SaveState()))
+		return hr;
+	return S_OK;
+}
+
+void DraftsIndexer::Enqueue(const DraftChange &change)
+{
+	if (queue.GetCount() >= queue.GetCapacity())
+		IndexerMetrics::Increment(metrics.queueFullWaits);
+	if (queue.Push(change))
+		IndexerMetrics::Increment(metrics.queued);
+}
+
+void DraftsIndexer::EnqueueDirectory(void)
+{
+	WIN32_FIND_DATA findData;
+	HANDLE find = FindFirstFile(options.directory + _T("*.wpost"), &findData);
+	if (find == INVALID_HANDLE_VALUE)
+		return;
+
+	CAtlMap<CString, bool, CStringElementTraitsI<CString> > present;
+	do
+	{
+		if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+			continue;
+		DraftChange change;
+		change.path = options.directory + findData.cFileName;
+		change.removed = false;
+		present.SetAt(change.path, true);
+		Enqueue(change);
+	}
+	while (FindNextFile(find, &findData));
+	FindClose(find);
+
+	// anything we remember that is no longer on disk was removed while we weren't looking
+	CAtlArray<CString> missing;
+	{
+		FingerprintLock guard(fingerprintLock);
+		POSITION position = fingerprints.GetStartPosition();
+		while (position)
+		{
+			CString path = fingerprints.GetNextKey(position);
+			bool found;
+			if (!present.Lookup(path, found))
+				missing.Add(path);
+		}
+	}
+	for (size_t i = 0; i < missing.GetCount(); i++)
+	{
+		DraftChange change;
+		change.path = missing[i];
+		change.removed = true;
+		Enqueue(change);
+	}
+}
+
+unsigned __stdcall DraftsIndexer::WorkerProc(void *parameter)
+{
+	HRESULT hrCoInit = CoInitializeEx(NULL, COINIT_MULTITHREADED);
+	static_cast<DraftsIndexer*>(parameter)->ProcessChanges();
+	if (SUCCEEDED(hrCoInit))
+		CoUninitialize();
+	return 0;
+}
+
+size_t DraftsIndexer::GetQueueDepth(void *context)
+{
+	return static_cast<DraftsIndexer*>(context)->queue.GetCount();
+}
+
+size_t DraftsIndexer::GetDocumentCount(void *context)
+{
+	return static_cast<DraftsIndexer*>(context)->sink->GetDocumentCount();
+}
+
+void DraftsIndexer::ProcessChanges(void)
+{
+	DraftChange change;
+	while (queue.Pop(change))
+	{
+		try
+		{
+			ProcessChange(change);
+		}
+		catch(HResultException e)
+		{
+			LOGERROR(e);
+			IndexerMetrics::Increment(metrics.failed);
+		}
+		catch(...)
+		{
+			LOGASSERT(FALSE);
+			IndexerMetrics::Increment(metrics.failed);
+		}
+	}
+}
+
+void DraftsIndexer::ProcessChange(const DraftChange &change)
+{
+	if (change.removed || GetFileAttributes(change.path) == INVALID_FILE_ATTRIBUTES)
+	{
+		bool known;
+		{
+			FingerprintLock guard(fingerprintLock);
+			known = fingerprints.RemoveKey(change.path);
+			fingerprintsDirty |= known;
+		}
+		if (known)
+		{
+			IndexerMetrics::Increment(metrics.removed);
+			CHECK_HRESULT(sink->Remove(change.path));
+		}
+		return;
+	}
+
+	ULONGLONG fingerprint;
+	HRESULT hr = ContentFingerprint::FromFile(change.path, &fingerprint);
+	if (FAILED(hr))
+	{
+		// most likely still being written; the next notification will bring it back
+		IndexerMetrics::Increment(metrics.failed);
+		return;
+	}
+
+	{
+		FingerprintLock guard(fingerprintLock);
+		ULONGLONG previous;
+		if (fingerprints.Lookup(change.path, previous) && previous == fingerprint)
+		{
+			IndexerMetrics::Increment(metrics.unchanged);
+			return;
+		}
+	}
+
+	LARGE_INTEGER frequency, start, end;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&start);
+
+	ExtractedPost post;
+	hr = PostExtractor::Extract(change.path, post);
+
+	QueryPerformanceCounter(&end);
+	IndexerMetrics::Add(metrics.extractMicroseconds, (end.QuadPart - start.QuadPart) * 1000000 / frequency.QuadPart);
+
+	if (FAILED(hr))
+	{
+		IndexerMetrics::Increment(metrics.failed);
+		return;
+	}
+
+	post.fingerprint = fingerprint;
+	CHECK_HRESULT(sink->Publish(post));
+	IndexerMetrics::Increment(metrics.extracted);
+
+	FingerprintLock guard(fingerprintLock);
+	fingerprints.SetAt(change.path, fingerprint);
+	fingerprintsDirty = true;
+}
+
+// The state file has one "<fingerprint>\t<path>" line per post, in UTF-8.
+HRESULT DraftsIndexer::LoadState(void)
+{
+	CAtlFile file;
+	HRESULT hr = file.Create(options.statePath, GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING);
+	if (hr == HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND))
+		return S_OK;
+	if (FAILED(hr))
+		return hr;
+
+	ULONGLONG size;
+	if (FAILED(hr = file.GetSize(size)))
+		return hr;
+	CStringA contents;
+	DWORD bytesRead = 0;
+	hr = file.Read(contents.GetBufferSetLength((int)size), (DWORD)size, bytesRead);
+	contents.ReleaseBufferSetLength(bytesRead);
+	if (FAILED(hr))
+		return hr;
+
+	FingerprintLock guard(fingerprintLock);
+	int position = 0;
+	CStringA line = contents.Tokenize("\r\n", position);
+	while (position >= 0)
+	{
+		int tab = line.Find('\t');
+		if (tab > 0)
+		{
+			ULONGLONG fingerprint = _strtoui64(line.Left(tab), NULL, 16);
+			fingerprints.SetAt(CString(CA2W(line.Mid(tab + 1), CP_UTF8)), fingerprint);
+		}
+		line = contents.Tokenize("\r\n", position);
+	}
+	return S_OK;
+}
+
+HRESULT DraftsIndexer::SaveState(void)
+{
+	CStringA contents;
+	{
+		FingerprintLock guard(fingerprintLock);
+		if (!fingerprintsDirty)
+			return S_OK;
+		POSITION position = fingerprints.GetStartPosition();
+		while (position)
+		{
+			const CAtlMap<CString, ULONGLONG, CStringElementTraitsI<CString> >::CPair *pair = fingerprints.GetNext(position);
+			contents.AppendFormat("%016I64x\t%s\r\n", pair->m_value, (LPCSTR)CW2A(pair->m_key, CP_UTF8));
+		}
+	}
+
+	CAtlTemporaryFile file;
+	HRESULT hr = file.Create();
+	if (FAILED(hr))
+		return hr;
+	if (FAILED(hr = file.Write(contents.GetString(), contents.GetLength())))
+		return hr;
+
+	// replaces the previous state file only once the new one is complete
+	return file.Close(options.statePath);
+}
@@ -0,0 +1,58 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include "BoundedQueue.h"
+#include "DraftsWatcher.h"
+#include "IndexSink.h"
+#include "IndexerMetrics.h"
+
+struct DraftsIndexerOptions
+{
+	CString directory;
+	CString metricsPipe;	// empty to disable the metrics endpoint
+	CString statePath;		// fingerprints are kept here between runs; may be empty
+	DWORD debounceMilliseconds;
+	size_t queueCapacity;
+	size_t workerCount;
+
+	DraftsIndexerOptions() : debounceMilliseconds(2000), queueCapacity(64), workerCount(2)
+	{
+	}
+};
+
+/*
+Keeps an IndexSink up to date with the posts in a drafts directory. Settled
+changes from the DraftsWatcher go through a bounded queue to a pool of
+workers, which only run the filter over files whose content fingerprint
+differs from the last one that was published.
+*/
+class DraftsIndexer
+{
+	DraftsIndexerOptions options;
+	IndexSink *sink;
+	IndexerMetrics metrics;
+	BoundedQueue<DraftChange> queue;
+	CComAutoCriticalSection fingerprintLock;
+	CAtlMap<CString, ULONGLONG, CStringElementTraitsI<CString> > fingerprints;
+	bool fingerprintsDirty;
+
+	static unsigned __stdcall WorkerProc(void *parameter);
+	static size_t GetQueueDepth(void *context);
+	static size_t GetDocumentCount(void *context);
+	void ProcessChanges(void);
+	void ProcessChange(const DraftChange &change);
+	void Enqueue(const DraftChange &change);
+	void EnqueueDirectory(void);
+	HRESULT LoadState(void);
+	HRESULT SaveState(void);
+
+public:
+	DraftsIndexer(const DraftsIndexerOptions &options, IndexSink *sink);
+
+	// runs until stopEvent is signaled
+	HRESULT Run(HANDLE stopEvent);
+
+	const IndexerMetrics &GetMetrics(void) const { return metrics; }
+};
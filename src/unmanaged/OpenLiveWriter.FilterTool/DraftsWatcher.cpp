@@ -0,0 +1,153 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "stdafx.h"
+#include <process.h>
+#include "DraftsWatcher.h"
+
+typedef CComCritSecLock<CComAutoCriticalSection> WatcherLock;
+
+const DWORD NOTIFY_BUFFER_SIZE = 0x10000;
+
+DraftsWatcher::DraftsWatcher(IndexerMetrics &aMetrics) :
+	metrics(aMetrics), directoryHandle(INVALID_HANDLE_VALUE), thread(NULL), stopping(0), rescanRequested(false)
+{
+}
+
+DraftsWatcher::~DraftsWatcher(void)
+{
+	Stop();
+}
+
+bool DraftsWatcher::IsPostFile(LPCTSTR path)
+{
+	LPCTSTR extension = ::PathFindExtension(path);
+	return _tcsicmp(extension, _T(".wpost")) == 0;
+}
+
+HRESULT DraftsWatcher::Start(LPCTSTR aDirectory)
+{
+	directory = aDirectory;
+	if (directory.Right(1) != _T("\\"))
+		directory += _T("\\");
+
+	directoryHandle = CreateFile(directory, FILE_LIST_DIRECTORY,
+		FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+		OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL);
+	if (directoryHandle == INVALID_HANDLE_VALUE)
+		return HRESULT_FROM_WIN32(GetLastError());
+
+	thread = (HANDLE)_beginthreadex(NULL, 0, WatchProc, this, 0, NULL);
+	if (!thread)
+		return E_OUTOFMEMORY;
+	return S_OK;
+}
+
+void DraftsWatcher::Stop(void)
+{
+	InterlockedExchange(&stopping, 1);
+	if (thread)
+	{
+		// unblock the synchronous ReadDirectoryChangesW call
+		CancelSynchronousIo(thread);
+		WaitForSingleObject(thread, INFINITE);
+		CloseHandle(thread);
+		thread = NULL;
+	}
+	if (directoryHandle != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(directoryHandle);
+		directoryHandle = INVALID_HANDLE_VALUE;
+	}
+}
+
+unsigned __stdcall DraftsWatcher::WatchProc(void *parameter)
+{
+	static_cast<DraftsWatcher*>(parameter)->Watch();
+	return 0;
+}
+
+void DraftsWatcher::Watch(void)
+{
+	CAtlArray<BYTE> buffer;
+	if (!buffer.SetCount(NOTIFY_BUFFER_SIZE))
+		return;
+
+	while (!stopping)
+	{
+		DWORD bytesReturned = 0;
+		BOOL succeeded = ReadDirectoryChangesW(directoryHandle, buffer.GetData(), NOTIFY_BUFFER_SIZE, TRUE,
+			FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE,
+			&bytesReturned, NULL, NULL);
+		if (stopping)
+			break;
+
+		if (!succeeded || bytesReturned == 0)
+		{
+			// the notification buffer overflowed; we no longer know what changed
+			DWORD error = succeeded ? ERROR_NOTIFY_ENUM_DIR : GetLastError();
+			if (error != ERROR_NOTIFY_ENUM_DIR)
+			{
+				LOGERROR_HR(HRESULT_FROM_WIN32(error));
+				Sleep(1000);
+			}
+			WatcherLock guard(lock);
+			rescanRequested = true;
+			IndexerMetrics::Increment(metrics.rescans);
+			continue;
+		}
+
+		FILE_NOTIFY_INFORMATION *info = reinterpret_cast<FILE_NOTIFY_INFORMATION*>(buffer.GetData());
+		while (true)
+		{
+			CString relativePath(info->FileName, info->FileNameLength / sizeof(WCHAR));
+			if (IsPostFile(relativePath))
+			{
+				bool removed = info->Action == FILE_ACTION_REMOVED || info->Action == FILE_ACTION_RENAMED_OLD_NAME;
+				RecordChange(directory + relativePath, removed);
+			}
+
+			if (info->NextEntryOffset == 0)
+				break;
+			info = reinterpret_cast<FILE_NOTIFY_INFORMATION*>(reinterpret_cast<BYTE*>(info) + info->NextEntryOffset);
+		}
+	}
+}
+
+void DraftsWatcher::RecordChange(const CString &path, bool removed)
+{
+	IndexerMetrics::Increment(metrics.changeEvents);
+
+	WatcherLock guard(lock);
+	PendingChange change;
+	if (pending.Lookup(path, change))
+		IndexerMetrics::Increment(metrics.debounced);
+	change.lastTick = GetTickCount64();
+	change.removed = removed;
+	pending.SetAt(path, change);
+}
+
+bool DraftsWatcher::CollectSettled(DWORD debounceMilliseconds, CAtlArray<DraftChange> &settled)
+{
+	ULONGLONG now = GetTickCount64();
+
+	WatcherLock guard(lock);
+	POSITION position = pending.GetStartPosition();
+	while (position)
+	{
+		POSITION current = position;
+		const CAtlMap<CString, PendingChange, CStringElementTraitsI<CString> >::CPair *pair = pending.GetNext(position);
+		if (now - pair->m_value.lastTick >= debounceMilliseconds)
+		{
+			DraftChange change;
+			change.path = pair->m_key;
+			change.removed = pair->m_value.removed;
+			settled.Add(change);
+			pending.RemoveAtPos(current);
+		}
+	}
+
+	bool rescan = rescanRequested;
+	rescanRequested = false;
+	return rescan;
+}
@@ -0,0 +1,53 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include "IndexerMetrics.h"
+
+struct DraftChange
+{
+	CString path;
+	bool removed;
+};
+
+/*
+Watches a drafts directory for .wpost changes. Autosave rewrites the same
+file several times in quick succession, so notifications are held back
+until a file has been quiet for the debounce interval.
+*/
+class DraftsWatcher
+{
+	struct PendingChange
+	{
+		ULONGLONG lastTick;
+		bool removed;
+	};
+
+	IndexerMetrics &metrics;
+	CString directory;
+	HANDLE directoryHandle;
+	HANDLE thread;
+	volatile LONG stopping;
+	CComAutoCriticalSection lock;
+	CAtlMap<CString, PendingChange, CStringElementTraitsI<CString> > pending;
+	bool rescanRequested;
+
+	static unsigned __stdcall WatchProc(void *parameter);
+	void Watch(void);
+	void RecordChange(const CString &path, bool removed);
+
+public:
+	explicit DraftsWatcher(IndexerMetrics &metrics);
+	~DraftsWatcher(void);
+
+	HRESULT Start(LPCTSTR directory);
+	void Stop(void);
+
+	// Moves changes that have been quiet for at least debounceMilliseconds into
+	// settled. Returns true if notifications were lost and the caller should
+	// rescan the whole directory.
+	bool CollectSettled(DWORD debounceMilliseconds, CAtlArray<DraftChange> &settled);
+
+	static bool IsPostFile(LPCTSTR path);
+};
@@ -0,0 +1,80 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "stdafx.h"
+#include "FilterTraceCapture.h"
+
+FilterTraceCapture::FilterTraceCapture(void) :
+	m_mapping(NULL), m_header(NULL)
+{
+}
+
+FilterTraceCapture::~FilterTraceCapture(void)
+{
+	if (m_header)
+		UnmapViewOfFile(m_header);
+	if (m_mapping)
+		CloseHandle(m_mapping);
+}
+
+HRESULT FilterTraceCapture::Create(DWORD capacity)
+{
+	ATLASSERT(!m_mapping);
+
+	ULONGLONG size = sizeof(FilterTraceHeader) + (ULONGLONG)capacity * sizeof(FilterTraceRecord);
+	m_mapping = CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (DWORD)(size >> 32), (DWORD)size, FILTER_TRACE_SECTION_NAME);
+	if (!m_mapping)
+		return HRESULT_FROM_WIN32(GetLastError());
+	if (GetLastError() == ERROR_ALREADY_EXISTS)
+	{
+		// someone else is capturing already
+		CloseHandle(m_mapping);
+		m_mapping = NULL;
+		return HRESULT_FROM_WIN32(ERROR_ALREADY_EXISTS);
+	}
+
+	m_header = static_cast<FilterTraceHeader*>(MapViewOfFile(m_mapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, 0));
+	if (!m_header)
+		return HRESULT_FROM_WIN32(GetLastError());
+
+	// the section starts out zeroed; filters ignore it until the magic is set
+	m_header->version = FILTER_TRACE_VERSION;
+	m_header->recordSize = sizeof(FilterTraceRecord);
+	m_header->capacity = capacity;
+	MemoryBarrier();
+	m_header->magic = FILTER_TRACE_MAGIC;
+	return S_OK;
+}
+
+HRESULT FilterTraceCapture::Save(LPCWSTR path, ULONG *recordCount, ULONG *droppedCount)
+{
+	if (!m_header)
+		return E_UNEXPECTED;
+
+	const FilterTraceRecord *records = reinterpret_cast<const FilterTraceRecord*>(m_header + 1);
+	DWORD reserved = min((DWORD)m_header->next, m_header->capacity);
+
+	CAtlArray<FilterTraceRecord> published;
+	for (DWORD i = 0; i < reserved; i++)
+	{
+		if (records[i].call != FILTER_TRACE_NONE)
+			published.Add(records[i]);
+	}
+
+	FilterTraceHeader header = *m_header;
+	header.capacity = (DWORD)published.GetCount();
+	header.next = (LONG)published.GetCount();
+
+	CAtlFile file;
+	HRESULT hr = file.Create(path, GENERIC_WRITE, 0, CREATE_ALWAYS);
+	if (FAILED(hr))
+		return hr;
+	if (FAILED(hr = file.Write(&header, sizeof(header))))
+		return hr;
+	if (published.GetCount() && FAILED(hr = file.Write(published.GetData(), (DWORD)(published.GetCount() * sizeof(FilterTraceRecord)))))
+		return hr;
+
+	*recordCount = (ULONG)published.GetCount();
+	*droppedCount = (ULONG)header.dropped;
+	return S_OK;
+}
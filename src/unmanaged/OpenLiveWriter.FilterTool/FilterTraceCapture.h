@@ -0,0 +1,26 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+#include "..\OpenLiveWriter.Filter\FilterTraceFormat.h"
+
+/*
+Owns the trace section that WebPostFilter instances record their calls into
+(see FilterTraceFormat.h). Filters in the search host only find the section
+in the global namespace, so capturing has to run elevated.
+*/
+class FilterTraceCapture
+{
+public:
+	FilterTraceCapture(void);
+	~FilterTraceCapture(void);
+
+	HRESULT Create(DWORD capacity);
+
+	// Writes the records published so far to a trace file.
+	HRESULT Save(LPCWSTR path, ULONG *recordCount, ULONG *droppedCount);
+
+private:
+	HANDLE m_mapping;
+	FilterTraceHeader *m_header;
+};
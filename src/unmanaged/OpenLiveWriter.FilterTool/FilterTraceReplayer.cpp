@@ -0,0 +1,200 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "stdafx.h"
+#include "FilterTraceReplayer.h"
+#include "..\OpenLiveWriter.Filter\OpenLiveWriter.Filter.h"
+
+// the file isn't a trace, or one written by a different version
+const HRESULT TRACE_E_FORMAT = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_ITF, 0x0301);
+
+HRESULT FilterTraceReplayer::Load(LPCWSTR tracePath)
+{
+	CAtlFile file;
+	HRESULT hr = file.Create(tracePath, GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN);
+	if (FAILED(hr))
+		return hr;
+
+	FilterTraceHeader header;
+	if (FAILED(hr = file.Read(&header, sizeof(header))))
+		return hr;
+	if (header.magic != FILTER_TRACE_MAGIC || header.version != FILTER_TRACE_VERSION || header.recordSize != sizeof(FilterTraceRecord))
+		return TRACE_E_FORMAT;
+
+	if (!m_records.SetCount(header.capacity))
+		return E_OUTOFMEMORY;
+	if (header.capacity && FAILED(hr = file.Read(m_records.GetData(), header.capacity * sizeof(FilterTraceRecord))))
+		return hr;
+	m_droppedCount = (ULONG)header.dropped;
+
+	// the host interleaves posts across threads; replay them one by one in call order
+	qsort(m_records.GetData(), m_records.GetCount(), sizeof(FilterTraceRecord), CompareRecords);
+	return S_OK;
+}
+
+int __cdecl FilterTraceReplayer::CompareRecords(const void *left, const void *right)
+{
+	const FilterTraceRecord *a = static_cast<const FilterTraceRecord*>(left);
+	const FilterTraceRecord *b = static_cast<const FilterTraceRecord*>(right);
+	if (a->session != b->session)
+		return a->session < b->session ? -1 : 1;
+	if (a->start != b->start)
+		return a->start < b->start ? -1 : 1;
+	return 0;
+}
+
+HRESULT FilterTraceReplayer::IndexCorpus(LPCWSTR directory)
+{
+	CStringW pattern(directory);
+	pattern += L"\\*.wpost";
+
+	WIN32_FIND_DATAW findData;
+	HANDLE hFind = FindFirstFileW(pattern, &findData);
+	if (hFind == INVALID_HANDLE_VALUE)
+		return HRESULT_FROM_WIN32(GetLastError());
+	do
+	{
+		if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+			continue;
+		CStringW path(directory);
+		path += L"\\";
+		path += findData.cFileName;
+		m_filesByName.SetAt(FilterTraceNameKey(findData.cFileName), path);
+		m_filesBySize.SetAt(findData.nFileSizeLow, path);
+	} while (FindNextFileW(hFind, &findData));
+	FindClose(hFind);
+	return S_OK;
+}
+
+HRESULT FilterTraceReplayer::Replay(ULONG repeat)
+{
+	for (ULONG pass = 0; pass < repeat; pass++)
+	{
+		size_t first = 0;
+		while (first < m_records.GetCount())
+		{
+			size_t end = first + 1;
+			while (end < m_records.GetCount() && m_records[end].session == m_records[first].session)
+				end++;
+
+			HRESULT hr = ReplaySession(m_records.GetData() + first, end - first);
+			if (FAILED(hr))
+				return hr;
+			if (pass == 0)
+			{
+				if (hr == S_FALSE)
+					m_missingCount++;
+				else
+					m_sessionCount++;
+			}
+			first = end;
+		}
+	}
+	return S_OK;
+}
+
+HRESULT FilterTraceReplayer::ReplaySession(const FilterTraceRecord *records, size_t count)
+{
+	HRESULT hr;
+
+	// a session starts with the post being loaded; anything else was cut off
+	const FilterTraceRecord &load = records[0];
+	const CAtlMap<ULONGLONG, CStringW>::CPair *byName = NULL;
+	const CAtlMap<DWORD, CStringW>::CPair *bySize = NULL;
+	if (load.call == FILTER_TRACE_LOAD_FILE)
+		byName = m_filesByName.Lookup(load.key);
+	else if (load.call == FILTER_TRACE_LOAD_STREAM)
+		bySize = m_filesBySize.Lookup(load.argument);
+	if (!byName && !bySize)
+		return S_FALSE;
+
+	CComPtr<IFilter> filter;
+	if (FAILED(hr = filter.CoCreateInstance(CLSID_WebPostFilter)))
+		return hr;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		const FilterTraceRecord &record = records[i];
+		ULONGLONG started = FilterTraceMicroseconds();
+		HRESULT replayed;
+		switch (record.call)
+		{
+		case FILTER_TRACE_LOAD_FILE:
+			{
+				CComQIPtr<IPersistFile> persistFile(filter);
+				if (!persistFile)
+					return E_NOINTERFACE;
+				replayed = persistFile->Load(byName->m_value, STGM_READ);
+				break;
+			}
+		case FILTER_TRACE_LOAD_STREAM:
+			{
+				CComQIPtr<IPersistStream> persistStream(filter);
+				if (!persistStream)
+					return E_NOINTERFACE;
+				CComPtr<IStream> stream;
+				if (FAILED(hr = SHCreateStreamOnFileW(bySize->m_value, STGM_READ | STGM_SHARE_DENY_WRITE, &stream)))
+					return hr;
+				started = FilterTraceMicroseconds();
+				replayed = persistStream->Load(stream);
+				break;
+			}
+		case FILTER_TRACE_INIT:
+			{
+				ULONG flags;
+				replayed = filter->Init(record.argument, 0, NULL, &flags);
+				break;
+			}
+		case FILTER_TRACE_GETCHUNK:
+			{
+				STAT_CHUNK stat;
+				replayed = filter->GetChunk(&stat);
+				break;
+			}
+		case FILTER_TRACE_GETTEXT:
+			{
+				if (m_textBuffer.GetCount() < record.argument && !m_textBuffer.SetCount(record.argument))
+					return E_OUTOFMEMORY;
+				ULONG cwc = record.argument;
+				replayed = filter->GetText(&cwc, m_textBuffer.GetData());
+				break;
+			}
+		case FILTER_TRACE_GETVALUE:
+			{
+				PROPVARIANT *value = NULL;
+				replayed = filter->GetValue(&value);
+				if (SUCCEEDED(replayed) && value)
+				{
+					PropVariantClear(value);
+					CoTaskMemFree(value);
+				}
+				break;
+			}
+		default:
+			continue;
+		}
+		ULONGLONG elapsed = FilterTraceMicroseconds() - started;
+
+		FilterTraceCallStatistics &statistics = m_statistics[record.call];
+		statistics.calls++;
+		statistics.recordedMicroseconds += record.duration;
+		statistics.replayedMicroseconds += elapsed;
+		if (replayed != record.hr)
+			statistics.mismatches++;
+	}
+	return S_OK;
+}
+
+LPCWSTR FilterTraceReplayer::GetCallName(DWORD call)
+{
+	switch (call)
+	{
+	case FILTER_TRACE_LOAD_FILE: return L"Load(file)";
+	case FILTER_TRACE_LOAD_STREAM: return L"Load(stream)";
+	case FILTER_TRACE_INIT: return L"Init";
+	case FILTER_TRACE_GETCHUNK: return L"GetChunk";
+	case FILTER_TRACE_GETTEXT: return L"GetText";
+	case FILTER_TRACE_GETVALUE: return L"GetValue";
+	default: return L"?";
+	}
+}
@@ -0,0 +1,59 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+#include "..\OpenLiveWriter.Filter\FilterTraceFormat.h"
+
+struct FilterTraceCallStatistics
+{
+	ULONG calls;
+	ULONG mismatches;		// replayed calls that returned something else than recorded
+	ULONGLONG recordedMicroseconds;
+	ULONGLONG replayedMicroseconds;
+
+	FilterTraceCallStatistics() : calls(0), mismatches(0), recordedMicroseconds(0), replayedMicroseconds(0)
+	{
+	}
+};
+
+/*
+Re-drives the calls in a captured trace against a WebPostFilter in this
+process, so that a slow crawl can be reproduced and profiled outside the
+search host.
+
+Every session in the trace is one post. Posts loaded from a file are found
+in the corpus directory by file name (see FilterTraceNameKey), posts loaded
+from a stream by their size. Sessions are replayed one after the other with
+the buffer sizes and Init flags the host used, on a fresh filter each.
+*/
+class FilterTraceReplayer
+{
+public:
+	FilterTraceReplayer(void) : m_sessionCount(0), m_missingCount(0), m_droppedCount(0)
+	{
+	}
+
+	HRESULT Load(LPCWSTR tracePath);
+	HRESULT IndexCorpus(LPCWSTR directory);
+	HRESULT Replay(ULONG repeat);
+
+	ULONG GetSessionCount(void) const { return m_sessionCount; }
+	ULONG GetMissingCount(void) const { return m_missingCount; }
+	ULONG GetDroppedCount(void) const { return m_droppedCount; }
+	const FilterTraceCallStatistics &GetStatistics(DWORD call) const { return m_statistics[call]; }
+
+	static LPCWSTR GetCallName(DWORD call);
+
+private:
+	HRESULT ReplaySession(const FilterTraceRecord *records, size_t count);
+	static int __cdecl CompareRecords(const void *left, const void *right);
+
+	CAtlArray<FilterTraceRecord> m_records;
+	CAtlMap<ULONGLONG, CStringW> m_filesByName;
+	CAtlMap<DWORD, CStringW> m_filesBySize;
+	CAtlArray<WCHAR> m_textBuffer;
+	FilterTraceCallStatistics m_statistics[FILTER_TRACE_CALL_COUNT];
+	ULONG m_sessionCount;
+	ULONG m_missingCount;
+	ULONG m_droppedCount;
+};
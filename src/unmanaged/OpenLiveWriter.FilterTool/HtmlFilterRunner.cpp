@@ -0,0 +1,157 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "stdafx.h"
+#include "HtmlFilterRunner.h"
+#include "..\OpenLiveWriter.Filter\ParallelHtmlSubFilter.h"
+
+HRESULT CopyStreamToTempFile(IStream *stream, LPCWSTR extension, LPWSTR fileName, int cbFileName);
+
+static const GUID SYSTEM_PROPSET = { 0xB725F130, 0x47EF, 0x101A, { 0xA5, 0xF1, 0x02, 0x60, 0x8C, 0x9E, 0xEB, 0xAC } };
+
+const ULONG TEXT_BUFFER_SIZE = 0x1000;
+
+HRESULT HtmlFilterRunner::CreateStream(const BYTE *html, size_t cb, IStream **stream)
+{
+	HRESULT hr;
+	HGLOBAL hGlobal = GlobalAlloc(GMEM_MOVEABLE, max(cb, (size_t)1));
+	if (!hGlobal)
+		return E_OUTOFMEMORY;
+	memcpy(GlobalLock(hGlobal), html, cb);
+	GlobalUnlock(hGlobal);
+
+	if (FAILED(hr = CreateStreamOnHGlobal(hGlobal, TRUE, stream)))
+	{
+		GlobalFree(hGlobal);
+		return hr;
+	}
+	ULARGE_INTEGER size;
+	size.QuadPart = cb;
+	return (*stream)->SetSize(size);
+}
+
+HRESULT HtmlFilterRunner::FilterWhole(const BYTE *html, size_t cb, CStringW &text)
+{
+	HRESULT hr;
+	CComPtr<IStream> stream;
+	if (FAILED(hr = CreateStream(html, cb, &stream)))
+		return hr;
+
+	CLSID htmlFilterClsid;
+	if (FAILED(hr = CLSIDFromString(L"{E0CA5340-4534-11CF-B952-00AA0051FE20}", &htmlFilterClsid)))
+		return hr;
+	CComPtr<IFilter> htmlFilter;
+	if (FAILED(hr = htmlFilter.CoCreateInstance(htmlFilterClsid)))
+		return hr;
+
+	// loaded the same way CWebPostFilter loads it
+	CString tempFileName;
+	CComQIPtr<IPersistStream> persistStream(htmlFilter);
+	if (persistStream)
+	{
+		hr = persistStream->Load(stream);
+	}
+	else
+	{
+		CComQIPtr<IPersistFile> persistFile(htmlFilter);
+		if (!persistFile)
+			return E_NOINTERFACE;
+		wchar_t fileName[MAX_PATH + 1];
+		if (FAILED(hr = CopyStreamToTempFile(stream, L".htm", fileName, sizeof(fileName))))
+			return hr;
+		tempFileName = fileName;
+		hr = persistFile->Load(fileName, 0);
+	}
+
+	ULONG flags;
+	if (SUCCEEDED(hr))
+		hr = htmlFilter->Init(IFILTER_INIT_INDEXING_ONLY, 0, NULL, &flags);
+
+	WCHAR buffer[TEXT_BUFFER_SIZE];
+	while (SUCCEEDED(hr))
+	{
+		STAT_CHUNK stat;
+		hr = htmlFilter->GetChunk(&stat);
+		if (hr == FILTER_E_END_OF_CHUNKS)
+		{
+			hr = S_OK;
+			break;
+		}
+		if (hr == FILTER_E_EMBEDDING_UNAVAILABLE || hr == FILTER_E_LINK_UNAVAILABLE)
+		{
+			hr = S_OK;
+			continue;
+		}
+		if (FAILED(hr) || !(stat.flags & CHUNK_TEXT))
+			continue;
+
+		text.AppendChar(L' ');
+		while (true)
+		{
+			ULONG cwc = TEXT_BUFFER_SIZE;
+			SCODE sc = htmlFilter->GetText(&cwc, buffer);
+			if (FAILED(sc))
+				break;
+			text.Append(buffer, cwc);
+			if (sc == FILTER_S_LAST_TEXT)
+				break;
+		}
+	}
+
+	if (tempFileName.GetLength() > 0)
+	{
+		htmlFilter.Release();
+		::DeleteFile(tempFileName);
+	}
+	return hr;
+}
+
+HRESULT HtmlFilterRunner::FilterSegmented(const BYTE *html, size_t cb, size_t targetSegmentSize, CStringW &text, size_t *segmentCount)
+{
+	HRESULT hr;
+	CComPtr<IStream> stream;
+	if (FAILED(hr = CreateStream(html, cb, &stream)))
+		return hr;
+
+	CLSID htmlFilterClsid;
+	if (FAILED(hr = CLSIDFromString(L"{E0CA5340-4534-11CF-B952-00AA0051FE20}", &htmlFilterClsid)))
+		return hr;
+
+	// the body's property, as CWebPostFilter asks for it
+	FULLPROPSPEC propSpec;
+	propSpec.guidPropSet = SYSTEM_PROPSET;
+	propSpec.psProperty.ulKind = PRSPEC_PROPID;
+	propSpec.psProperty.propid = 19;
+
+	ParallelHtmlSubFilter filter(propSpec, htmlFilterClsid);
+	if (FAILED(hr = filter.Init(stream, targetSegmentSize)))
+		return hr;
+	if (segmentCount)
+		*segmentCount = filter.GetSegmentCount();
+
+	WCHAR buffer[TEXT_BUFFER_SIZE];
+	while (true)
+	{
+		STAT_CHUNK stat;
+		hr = filter.GetChunk(&stat);
+		if (hr == E_PENDING)
+		{
+			WaitForSingleObject(filter.GetPendingHandle(), INFINITE);
+			continue;
+		}
+		if (hr == FILTER_E_END_OF_CHUNKS)
+			return S_OK;
+		if (FAILED(hr))
+			return hr;
+
+		text.AppendChar(L' ');
+		while (true)
+		{
+			ULONG cwc = TEXT_BUFFER_SIZE;
+			SCODE sc = filter.GetText(&cwc, buffer);
+			if (FAILED(sc))
+				break;
+			text.Append(buffer, cwc);
+		}
+	}
+}
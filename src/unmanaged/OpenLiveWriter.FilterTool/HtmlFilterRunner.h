@@ -0,0 +1,20 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+/*
+Runs the HTML IFilter over an HTML body the two ways the WebPostFilter can:
+whole, in a single filter instance, or split by ParallelHtmlSubFilter into
+segments that are filtered on worker threads. Either way the text of every
+text chunk is collected, with a space between chunks.
+*/
+class HtmlFilterRunner
+{
+public:
+	static HRESULT FilterWhole(const BYTE *html, size_t cb, CStringW &text);
+	static HRESULT FilterSegmented(const BYTE *html, size_t cb, size_t targetSegmentSize, CStringW &text, size_t *segmentCount);
+
+private:
+	static HRESULT CreateStream(const BYTE *html, size_t cb, IStream **stream);
+};
@@ -0,0 +1,210 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "stdafx.h"
+#include "IndexSink.h"
+#include "JsonHelper.h"
+
+typedef CComCritSecLock<CComAutoCriticalSection> SinkLock;
+
+HRESULT IndexSink::Create(const CString &specification, IndexSink **sink)
+{
+	*sink = NULL;
+
+	int separator = specification.Find(_T('='));
+	CString kind = separator < 0 ? specification : specification.Left(separator);
+	CString argument = separator < 0 ? CString() : specification.Mid(separator + 1);
+
+	if (kind.CompareNoCase(_T("memory")) == 0)
+	{
+		*sink = new MemoryIndexSink();
+	}
+	else if (kind.CompareNoCase(_T("pipe")) == 0 && argument.GetLength() > 0)
+	{
+		*sink = new PipeIndexSink(argument);
+	}
+	else if (kind.CompareNoCase(_T("jsonl")) == 0 && argument.GetLength() > 0)
+	{
+		JsonlIndexSink *jsonlSink = new JsonlIndexSink();
+		HRESULT hr = jsonlSink->Open(argument);
+		if (FAILED(hr))
+		{
+			delete jsonlSink;
+			return hr;
+		}
+		*sink = jsonlSink;
+	}
+	else
+	{
+		return E_INVALIDARG;
+	}
+
+	return *sink ? S_OK : E_OUTOFMEMORY;
+}
+
+CStringA IndexSink::FormatRecord(const ExtractedPost &post)
+{
+	CStringA record;
+	record.Append("{\"path\":");
+	JsonHelper::AppendString(record, CStringW(post.path));
+	record.AppendFormat(",\"fingerprint\":\"%016I64x\",\"date\":", post.fingerprint);
+	JsonHelper::AppendFileTime(record, post.primaryDate);
+	record.Append(",\"title\":");
+	JsonHelper::AppendString(record, post.title);
+	record.Append(",\"keywords\":");
+	JsonHelper::AppendString(record, post.keywords);
+	record.Append(",\"body\":");
+	JsonHelper::AppendString(record, post.body);
+	record.Append("}\n");
+	return record;
+}
+
+CStringA IndexSink::FormatRemoval(LPCTSTR path)
+{
+	CStringA record;
+	record.Append("{\"path\":");
+	JsonHelper::AppendString(record, CStringW(path));
+	record.Append(",\"removed\":true}\n");
+	return record;
+}
+
+// JsonlIndexSink
+
+HRESULT JsonlIndexSink::Open(LPCTSTR path)
+{
+	HRESULT hr = file.Create(path, FILE_APPEND_DATA, FILE_SHARE_READ, OPEN_ALWAYS);
+	if (FAILED(hr))
+		return hr;
+	return file.Seek(0, FILE_END);
+}
+
+HRESULT JsonlIndexSink::Publish(const ExtractedPost &post)
+{
+	CStringA record = FormatRecord(post);
+	SinkLock guard(lock);
+	documents.SetAt(post.path, true);
+	return file.Write(record.GetString(), record.GetLength());
+}
+
+HRESULT JsonlIndexSink::Remove(LPCTSTR path)
+{
+	CStringA record = FormatRemoval(path);
+	SinkLock guard(lock);
+	documents.RemoveKey(CString(path));
+	return file.Write(record.GetString(), record.GetLength());
+}
+
+size_t JsonlIndexSink::GetDocumentCount(void)
+{
+	SinkLock guard(lock);
+	return documents.GetCount();
+}
+
+// MemoryIndexSink
+
+MemoryIndexSink::~MemoryIndexSink(void)
+{
+	POSITION position = documents.GetStartPosition();
+	while (position)
+		delete documents.GetNextValue(position);
+}
+
+HRESULT MemoryIndexSink::Publish(const ExtractedPost &post)
+{
+	ExtractedPost *copy = new ExtractedPost(post);
+	if (!copy)
+		return E_OUTOFMEMORY;
+
+	SinkLock guard(lock);
+	ExtractedPost *previous = NULL;
+	if (documents.Lookup(post.path, previous))
+		delete previous;
+	documents.SetAt(post.path, copy);
+	return S_OK;
+}
+
+HRESULT MemoryIndexSink::Remove(LPCTSTR path)
+{
+	SinkLock guard(lock);
+	ExtractedPost *previous = NULL;
+	if (documents.Lookup(CString(path), previous))
+	{
+		delete previous;
+		documents.RemoveKey(CString(path));
+	}
+	return S_OK;
+}
+
+size_t MemoryIndexSink::GetDocumentCount(void)
+{
+	SinkLock guard(lock);
+	return documents.GetCount();
+}
+
+bool MemoryIndexSink::Lookup(LPCTSTR path, ExtractedPost &post)
+{
+	SinkLock guard(lock);
+	ExtractedPost *found = NULL;
+	if (!documents.Lookup(CString(path), found))
+		return false;
+	post = *found;
+	return true;
+}
+
+// PipeIndexSink
+
+PipeIndexSink::PipeIndexSink(LPCTSTR name) :
+	pipe(INVALID_HANDLE_VALUE), documentCount(0)
+{
+	pipeName.Format(_T("\\\\.\\pipe\\%s"), name);
+}
+
+PipeIndexSink::~PipeIndexSink(void)
+{
+	if (pipe != INVALID_HANDLE_VALUE)
+		CloseHandle(pipe);
+}
+
+HRESULT PipeIndexSink::Write(const CStringA &record)
+{
+	SinkLock guard(lock);
+
+	// one reconnect attempt per record; the server may have restarted
+	for (int attempt = 0; attempt < 2; attempt++)
+	{
+		if (pipe == INVALID_HANDLE_VALUE)
+		{
+			if (!WaitNamedPipe(pipeName, 1000))
+				return HRESULT_FROM_WIN32(GetLastError());
+			pipe = CreateFile(pipeName, GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, NULL);
+			if (pipe == INVALID_HANDLE_VALUE)
+				return HRESULT_FROM_WIN32(GetLastError());
+		}
+
+		DWORD written = 0;
+		if (WriteFile(pipe, record.GetString(), record.GetLength(), &written, NULL))
+			return S_OK;
+
+		CloseHandle(pipe);
+		pipe = INVALID_HANDLE_VALUE;
+	}
+	return HRESULT_FROM_WIN32(ERROR_PIPE_NOT_CONNECTED);
+}
+
+HRESULT PipeIndexSink::Publish(const ExtractedPost &post)
+{
+	HRESULT hr = Write(FormatRecord(post));
+	if (SUCCEEDED(hr))
+		InterlockedIncrement(&documentCount);
+	return hr;
+}
+
+HRESULT PipeIndexSink::Remove(LPCTSTR path)
+{
+	return Write(FormatRemoval(path));
+}
+
+size_t PipeIndexSink::GetDocumentCount(void)
+{
+	return documentCount;
+}
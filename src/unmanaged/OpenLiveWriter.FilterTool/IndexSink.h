@@ -0,0 +1,69 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include "PostExtractor.h"
+
+/*
+Destination for posts extracted by the drafts indexer. Sinks are called
+from several worker threads and must do their own locking.
+*/
+class IndexSink
+{
+public:
+	virtual ~IndexSink(void) {}
+
+	virtual HRESULT Publish(const ExtractedPost &post) = 0;
+	virtual HRESULT Remove(LPCTSTR path) = 0;
+	virtual size_t GetDocumentCount(void) = 0;
+
+	// creates a sink from a /sink: specification (jsonl=<file>, pipe=<name> or memory)
+	static HRESULT Create(const CString &specification, IndexSink **sink);
+
+protected:
+	static CStringA FormatRecord(const ExtractedPost &post);
+	static CStringA FormatRemoval(LPCTSTR path);
+};
+
+// Appends one JSON object per line to a file.
+class JsonlIndexSink : public IndexSink
+{
+	CComAutoCriticalSection lock;
+	CAtlFile file;
+	CAtlMap<CString, bool, CStringElementTraitsI<CString> > documents;
+public:
+	HRESULT Open(LPCTSTR path);
+	HRESULT Publish(const ExtractedPost &post);
+	HRESULT Remove(LPCTSTR path);
+	size_t GetDocumentCount(void);
+};
+
+// Keeps the latest extraction of every post in memory, keyed by path.
+class MemoryIndexSink : public IndexSink
+{
+	CComAutoCriticalSection lock;
+	CAtlMap<CString, ExtractedPost*, CStringElementTraitsI<CString> > documents;
+public:
+	virtual ~MemoryIndexSink(void);
+	HRESULT Publish(const ExtractedPost &post);
+	HRESULT Remove(LPCTSTR path);
+	size_t GetDocumentCount(void);
+	bool Lookup(LPCTSTR path, ExtractedPost &post);
+};
+
+// Streams JSON lines to a local named pipe server, reconnecting as needed.
+class PipeIndexSink : public IndexSink
+{
+	CComAutoCriticalSection lock;
+	CString pipeName;
+	HANDLE pipe;
+	LONG documentCount;
+	HRESULT Write(const CStringA &record);
+public:
+	explicit PipeIndexSink(LPCTSTR name);
+	virtual ~PipeIndexSink(void);
+	HRESULT Publish(const ExtractedPost &post);
+	HRESULT Remove(LPCTSTR path);
+	size_t GetDocumentCount(void);
+};
@@ -0,0 +1,134 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "stdafx.h"
+#include <process.h>
+#include "IndexerMetrics.h"
+
+CStringA IndexerMetrics::Format(size_t queueDepth, size_t queueCapacity, size_t documentCount) const
+{
+	CStringA strMetrics;
+	strMetrics.AppendFormat("change_events %I64d\n", changeEvents);
+	strMetrics.AppendFormat("rescans %I64d\n", rescans);
+	strMetrics.AppendFormat("debounced %I64d\n", debounced);
+	strMetrics.AppendFormat("queued %I64d\n", queued);
+	strMetrics.AppendFormat("unchanged %I64d\n", unchanged);
+	strMetrics.AppendFormat("extracted %I64d\n", extracted);
+	strMetrics.AppendFormat("failed %I64d\n", failed);
+	strMetrics.AppendFormat("removed %I64d\n", removed);
+	strMetrics.AppendFormat("extract_microseconds %I64d\n", extractMicroseconds);
+	strMetrics.AppendFormat("queue_full_waits %I64d\n", queueFullWaits);
+	strMetrics.AppendFormat("queue_depth %Iu\n", queueDepth);
+	strMetrics.AppendFormat("queue_capacity %Iu\n", queueCapacity);
+	strMetrics.AppendFormat("documents %Iu\n", documentCount);
+	return strMetrics;
+}
+
+MetricsServer::MetricsServer(const IndexerMetrics &metrics)
+	: m_metrics(metrics), m_queueDepth(NULL), m_documentCount(NULL), m_queueCapacity(0), m_context(NULL),
+	  m_stopEvent(NULL), m_thread(NULL)
+{
+}
+
+MetricsServer::~MetricsServer(void)
+{
+	Stop();
+}
+
+HRESULT MetricsServer::Start(LPCTSTR pipeName, GaugeCallback queueDepth, GaugeCallback documentCount, size_t queueCapacity, void *context)
+{
+	m_pipeName.Format(_T("\\\\.\\pipe\\%s"), pipeName);
+	m_queueDepth = queueDepth;
+	m_documentCount = documentCount;
+	m_queueCapacity = queueCapacity;
+	m_context = context;
+
+	m_stopEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+	if (!m_stopEvent)
+		return HRESULT_FROM_WIN32(GetLastError());
+
+	m_thread = (HANDLE)_beginthreadex(NULL, 0, ServerProc, this, 0, NULL);
+	if (!m_thread)
+		return E_OUTOFMEMORY;
+	return S_OK;
+}
+
+void MetricsServer::Stop(void)
+{
+	if (m_thread)
+	{
+		SetEvent(m_stopEvent);
+		WaitForSingleObject(m_thread, INFINITE);
+		CloseHandle(m_thread);
+		m_thread = NULL;
+	}
+	if (m_stopEvent)
+	{
+		CloseHandle(m_stopEvent);
+		m_stopEvent = NULL;
+	}
+}
+
+unsigned __stdcall MetricsServer::ServerProc(void *parameter)
+{
+	static_cast<MetricsServer*>(parameter)->Serve();
+	return 0;
+}
+
+void MetricsServer::Serve(void)
+{
+	CHandle connected(CreateEvent(NULL, TRUE, FALSE, NULL));
+	if (!connected)
+		return;
+
+	while (WaitForSingleObject(m_stopEvent, 0) != WAIT_OBJECT_0)
+	{
+		HANDLE pipe = CreateNamedPipe(m_pipeName, PIPE_ACCESS_OUTBOUND | FILE_FLAG_OVERLAPPED,
+			PIPE_TYPE_BYTE | PIPE_WAIT, 1, 0x1000, 0, 0, NULL);
+		if (pipe == INVALID_HANDLE_VALUE)
+		{
+			LOGERROR_HR(HRESULT_FROM_WIN32(GetLastError()));
+			return;
+		}
+
+		OVERLAPPED overlapped;
+		ZeroMemory(&overlapped, sizeof(overlapped));
+		overlapped.hEvent = connected;
+		ResetEvent(connected);
+
+		bool clientConnected = false;
+		if (ConnectNamedPipe(pipe, &overlapped) || GetLastError() == ERROR_PIPE_CONNECTED)
+		{
+			clientConnected = true;
+		}
+		else if (GetLastError() == ERROR_IO_PENDING)
+		{
+			HANDLE handles[] = { m_stopEvent, connected };
+			DWORD signaled = WaitForMultipleObjects(2, handles, FALSE, INFINITE);
+			DWORD transferred;
+			if (signaled == WAIT_OBJECT_0 + 1)
+				clientConnected = GetOverlappedResult(pipe, &overlapped, &transferred, FALSE) != FALSE;
+			else
+				CancelIoEx(pipe, &overlapped);
+		}
+
+		if (clientConnected)
+		{
+			CStringA snapshot = m_metrics.Format(
+				m_queueDepth ? m_queueDepth(m_context) : 0,
+				m_queueCapacity,
+				m_documentCount ? m_documentCount(m_context) : 0);
+
+			ZeroMemory(&overlapped, sizeof(overlapped));
+			overlapped.hEvent = connected;
+			ResetEvent(connected);
+
+			DWORD written = 0;
+			if (WriteFile(pipe, snapshot.GetString(), snapshot.GetLength(), NULL, &overlapped) || GetLastError() == ERROR_IO_PENDING)
+				GetOverlappedResult(pipe, &overlapped, &written, TRUE);
+			FlushFileBuffers(pipe);
+			DisconnectNamedPipe(pipe);
+		}
+		CloseHandle(pipe);
+	}
+}
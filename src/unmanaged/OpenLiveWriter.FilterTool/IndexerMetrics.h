@@ -0,0 +1,65 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+/*
+Counters maintained by the drafts indexer. A snapshot is served as plain
+"name value" lines to every client that connects to the metrics pipe.
+*/
+struct IndexerMetrics
+{
+	volatile LONGLONG changeEvents;		// raw directory change notifications
+	volatile LONGLONG rescans;			// full rescans after notification overflow
+	volatile LONGLONG debounced;		// notifications folded into a pending change
+	volatile LONGLONG queued;			// files handed to the extraction workers
+	volatile LONGLONG unchanged;		// files skipped because the fingerprint matched
+	volatile LONGLONG extracted;		// files run through the filter
+	volatile LONGLONG failed;			// files the filter or the sink failed on
+	volatile LONGLONG removed;			// files deleted or renamed away
+	volatile LONGLONG extractMicroseconds;	// total time spent in the filter
+	volatile LONGLONG queueFullWaits;	// pushes that blocked on a full queue
+
+	IndexerMetrics()
+	{
+		ZeroMemory(this, sizeof(*this));
+	}
+
+	static void Increment(volatile LONGLONG &counter)
+	{
+		InterlockedIncrement64(&counter);
+	}
+
+	static void Add(volatile LONGLONG &counter, LONGLONG value)
+	{
+		InterlockedExchangeAdd64(&counter, value);
+	}
+
+	CStringA Format(size_t queueDepth, size_t queueCapacity, size_t documentCount) const;
+};
+
+class MetricsServer
+{
+public:
+	MetricsServer(const IndexerMetrics &metrics);
+	~MetricsServer(void);
+
+	// queueDepth and documentCount are polled for every snapshot
+	typedef size_t (*GaugeCallback)(void *context);
+
+	HRESULT Start(LPCTSTR pipeName, GaugeCallback queueDepth, GaugeCallback documentCount, size_t queueCapacity, void *context);
+	void Stop(void);
+
+private:
+	static unsigned __stdcall ServerProc(void *parameter);
+	void Serve(void);
+
+	const IndexerMetrics &m_metrics ;
+	CString m_pipeName ;
+	GaugeCallback m_queueDepth ;
+	GaugeCallback m_documentCount ;
+	size_t m_queueCapacity ;
+	void *m_context ;
+	HANDLE m_stopEvent ;
+	HANDLE m_thread ;
+};
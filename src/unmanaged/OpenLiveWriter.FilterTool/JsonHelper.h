@@ -0,0 +1,46 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+class JsonHelper
+{
+public:
+	// appends strValue as a quoted, escaped UTF-8 JSON string
+	static void AppendString( CStringA& strJson, const CStringW& strValue )
+	{
+		CStringW strEscaped ;
+		strEscaped.Preallocate( strValue.GetLength() + 2 ) ;
+		strEscaped.AppendChar( L'"' ) ;
+		for ( int i = 0; i < strValue.GetLength(); i++ )
+		{
+			WCHAR c = strValue[i] ;
+			switch ( c )
+			{
+			case L'"':	strEscaped.Append( L"\\\"" ) ; break ;
+			case L'\\':	strEscaped.Append( L"\\\\" ) ; break ;
+			case L'\n':	strEscaped.Append( L"\\n" ) ; break ;
+			case L'\r':	strEscaped.Append( L"\\r" ) ; break ;
+			case L'\t':	strEscaped.Append( L"\\t" ) ; break ;
+			default:
+				if ( c < 0x20 )
+					strEscaped.AppendFormat( L"\\u%04x", c ) ;
+				else
+					strEscaped.AppendChar( c ) ;
+			}
+		}
+		strEscaped.AppendChar( L'"' ) ;
+
+		strJson.Append( CW2A( strEscaped, CP_UTF8 ) ) ;
+	}
+
+	// appends a FILETIME as an ISO 8601 UTC timestamp string
+	static void AppendFileTime( CStringA& strJson, const FILETIME& fileTime )
+	{
+		SYSTEMTIME st ;
+		if ( !::FileTimeToSystemTime( &fileTime, &st ) )
+			ZeroMemory( &st, sizeof(st) ) ;
+		strJson.AppendFormat( "\"%04hu-%02hu-%02huT%02hu:%02hu:%02huZ\"",
+			st.wYear, st.wMonth, st.wDay, st.wHour, st.wMinute, st.wSecond ) ;
+	}
+} ;
@@ -0,0 +1,1214 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+// OpenLiveWriter.FilterTool.cpp : Command line host for the WebPostFilter.
+
+#include "stdafx.h"
+#include "CommandLine.h"
+#include "HtmlFilterRunner.h"
+#include "DraftsIndexer.h"
+#include "IndexSink.h"
+#include "PostCompactor.h"
+#include "FilterTraceCapture.h"
+#include "FilterTraceReplayer.h"
+#include "PostExtractor.h"
+#include "ColumnarWriter.h"
+#include "ColumnarReader.h"
+#include "PostSource.h"
+#include "PostPackWriter.h"
+#include "PostFileLoader.h"
+#include "PostFileDecoder.h"
+#include "PendingCheck.h"
+#include "PackCheck.h"
+#include "..\OpenLiveWriter.Filter\WordSegmenter.h"
+#include "..\OpenLiveWriter.Filter\OpenLiveWriter.Filter.h"
+#include "..\OpenLiveWriter.Filter\AllocationSites.h"
+#include "..\OpenLiveWriter.Filter\PostEditorFileConstants.h"
+
+// a console tool has no business writing to the application log
+DECLARE_NULL_LOGFILE
+
+static double ElapsedSeconds(const LARGE_INTEGER &start)
+{
+	LARGE_INTEGER now, frequency;
+	QueryPerformanceCounter(&now);
+	QueryPerformanceFrequency(&frequency);
+	return (double)(now.QuadPart - start.QuadPart) / frequency.QuadPart;
+}
+
+// segmented filtering that doesn't produce the text whole filtering does
+const HRESULT FILTERTOOL_E_PARALLEL_MISMATCH = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_ITF, 0x0101);
+
+struct HtmlDocument
+{
+	CString name;
+	CAtlArray<BYTE> html;
+};
+
+/*
+Builds about cb bytes of paragraphs, with accented letters (one byte each in
+windows-1252, two in UTF-8) in every one, so that a segment decoded with the
+wrong encoding comes out different.
+*/
+static void AddSyntheticDocument(CAtlArray<HtmlDocument*> &documents, LPCTSTR name, const char *head, bool utf8, size_t cb)
+{
+	CStringA html;
+	html.Preallocate((int)cb + 0x100);
+	if (utf8 && strstr(head, "charset") == NULL)
+		html += "\xEF\xBB\xBF";
+	html += "<html><head>";
+	html += head;
+	html += "<title>Synthetic post</title></head><body>\n";
+	for (ULONG i = 0; (size_t)html.GetLength() < cb; i++)
+	{
+		html.AppendFormat("<p>Paragraph %u, a caf%s with cr%sme br%sl%se and <b>bold</b> text.</p>\n",
+			i, utf8 ? "\xC3\xA9" : "\xE9", utf8 ? "\xC3\xA8" : "\xE8", utf8 ? "\xC3\xBB" : "\xFB", utf8 ? "\xC3\xA9" : "\xE9");
+	}
+	html += "</body></html>\n";
+
+	HtmlDocument *document = new HtmlDocument();
+	document->name = name;
+	document->html.SetCount(html.GetLength());
+	memcpy(document->html.GetData(), html.GetString(), html.GetLength());
+	documents.Add(document);
+}
+
+static HRESULT AddDocument(CAtlArray<HtmlDocument*> &documents, const CString &path)
+{
+	HRESULT hr;
+	CAtlFile file;
+	if (FAILED(hr = file.Create(path, GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING)))
+	{
+		fwprintf(stderr, L"Can't open %s\n", (LPCWSTR)path);
+		return hr;
+	}
+	ULONGLONG size;
+	if (FAILED(hr = file.GetSize(size)))
+		return hr;
+
+	HtmlDocument *document = new HtmlDocument();
+	document->name = path;
+	if (!document->html.SetCount((size_t)size))
+	{
+		delete document;
+		return E_OUTOFMEMORY;
+	}
+	if (size > 0 && FAILED(hr = file.Read(document->html.GetData(), (DWORD)size)))
+	{
+		delete document;
+		return hr;
+	}
+	documents.Add(document);
+	return S_OK;
+}
+
+// Adds the .htm and .html files in target if it is a directory, or target itself.
+static HRESULT AddDocuments(CAtlArray<HtmlDocument*> &documents, const CString &target)
+{
+	DWORD attributes = GetFileAttributes(target);
+	if (attributes == INVALID_FILE_ATTRIBUTES)
+	{
+		fwprintf(stderr, L"Can't find %s\n", (LPCWSTR)target);
+		return HRESULT_FROM_WIN32(GetLastError());
+	}
+	if (!(attributes & FILE_ATTRIBUTE_DIRECTORY))
+		return AddDocument(documents, target);
+
+	HRESULT hr = S_OK;
+	WIN32_FIND_DATA findData;
+	HANDLE hFind = FindFirstFile(target + _T("\\*.htm*"), &findData);
+	if (hFind != INVALID_HANDLE_VALUE)
+	{
+		do
+		{
+			CString extension(PathFindExtension(findData.cFileName));
+			if (!(findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+				&& (extension.CompareNoCase(_T(".htm")) == 0 || extension.CompareNoCase(_T(".html")) == 0))
+				hr = AddDocument(documents, target + _T("\\") + findData.cFileName);
+		} while (SUCCEEDED(hr) && FindNextFile(hFind, &findData));
+		FindClose(hFind);
+	}
+	return hr;
+}
+
+// The documents named on the command line, or synthetic ones if there are none.
+static HRESULT GetDocuments(const CommandLine &commandLine, CAtlArray<HtmlDocument*> &documents)
+{
+	HRESULT hr = S_OK;
+	for (size_t i = 1; i < commandLine.GetArgumentCount() && SUCCEEDED(hr); i++)
+		hr = AddDocuments(documents, commandLine.GetArgument(i));
+	if (commandLine.GetArgumentCount() > 1)
+		return hr;
+
+	size_t cb = commandLine.GetNumericOption(_T("size"), 0x200000);
+	AddSyntheticDocument(documents, _T("windows-1252, <meta charset>"), "<meta charset=\"windows-1252\">", false, cb);
+	AddSyntheticDocument(documents, _T("windows-1252, <meta http-equiv>"), "<meta http-equiv=\"Content-Type\" content=\"text/html; charset=windows-1252\">", false, cb);
+	AddSyntheticDocument(documents, _T("UTF-8, <meta charset>"), "<meta charset=\"utf-8\">", true, cb);
+	AddSyntheticDocument(documents, _T("UTF-8, byte order mark"), "", true, cb);
+	return S_OK;
+}
+
+static void FreeDocuments(CAtlArray<HtmlDocument*> &documents)
+{
+	for (size_t i = 0; i < documents.GetCount(); i++)
+		delete documents[i];
+	documents.RemoveAll();
+}
+
+// Collapses each run of white space to a single space and trims the ends.
+static CStringW NormalizeSpace(const CStringW &text)
+{
+	CStringW normalized;
+	normalized.Preallocate(text.GetLength());
+	bool space = false;
+	for (int i = 0; i < text.GetLength(); i++)
+	{
+		if (iswspace(text[i]))
+		{
+			space = !normalized.IsEmpty();
+			continue;
+		}
+		if (space)
+			normalized.AppendChar(L' ');
+		normalized.AppendChar(text[i]);
+		space = false;
+	}
+	return normalized;
+}
+
+static int ParallelCheck(const CommandLine &commandLine)
+{
+	CAtlArray<HtmlDocument*> documents;
+	HRESULT hr = GetDocuments(commandLine, documents);
+	if (FAILED(hr))
+	{
+		FreeDocuments(documents);
+		return hr;
+	}
+
+	// at least a few segments per document, unless the size is given
+	ULONG segmentCount = max(commandLine.GetNumericOption(_T("segments"), 8), 2UL);
+	ULONG failures = 0;
+	for (size_t i = 0; i < documents.GetCount(); i++)
+	{
+		const HtmlDocument *document = documents[i];
+		size_t cb = document->html.GetCount();
+		size_t segmentSize = commandLine.GetNumericOption(_T("segment"), (ULONG)max(cb / segmentCount, (size_t)1));
+
+		CStringW whole, segmented;
+		size_t segments = 0;
+		if (FAILED(hr = HtmlFilterRunner::FilterWhole(document->html.GetData(), cb, whole))
+			|| FAILED(hr = HtmlFilterRunner::FilterSegmented(document->html.GetData(), cb, segmentSize, segmented, &segments)))
+		{
+			fwprintf(stderr, L"%s: failed with HRESULT %#08x\n", (LPCWSTR)document->name, hr);
+			failures++;
+			continue;
+		}
+
+		whole = NormalizeSpace(whole);
+		segmented = NormalizeSpace(segmented);
+		int position = 0;
+		while (position < whole.GetLength() && position < segmented.GetLength() && whole[position] == segmented[position])
+			position++;
+		if (position == whole.GetLength() && position == segmented.GetLength())
+		{
+			fwprintf(stdout, L"%s: %u segments, %d characters, same\n", (LPCWSTR)document->name, (ULONG)segments, whole.GetLength());
+			continue;
+		}
+
+		// show the word the texts part at
+		int wordStart = position;
+		while (wordStart > 0 && whole[wordStart - 1] != L' ')
+			wordStart--;
+		fwprintf(stdout, L"%s: %u segments, differs at character %d: \"%.40s\" whole, \"%.40s\" segmented\n",
+			(LPCWSTR)document->name, (ULONG)segments, position,
+			whole.GetString() + min(wordStart, whole.GetLength()), segmented.GetString() + min(wordStart, segmented.GetLength()));
+		failures++;
+	}
+
+	fwprintf(stdout, L"%u of %u documents the same\n", (ULONG)documents.GetCount() - failures, (ULONG)documents.GetCount());
+	FreeDocuments(documents);
+	return failures ? FILTERTOOL_E_PARALLEL_MISMATCH : S_OK;
+}
+
+static int ParallelBenchmark(const CommandLine &commandLine)
+{
+	CAtlArray<HtmlDocument*> documents;
+	HRESULT hr = GetDocuments(commandLine, documents);
+	if (FAILED(hr))
+	{
+		FreeDocuments(documents);
+		return hr;
+	}
+	ULONG repeat = max(commandLine.GetNumericOption(_T("repeat"), 5), 1UL);
+
+	ULONGLONG cb = 0;
+	for (size_t i = 0; i < documents.GetCount(); i++)
+		cb += documents[i]->html.GetCount();
+	double megabytes = cb * repeat / (1024.0 * 1024.0);
+
+	// whole filtering, then segments up to twice the processors, which is
+	// what CWebPostFilter aims for
+	SYSTEM_INFO systemInfo;
+	GetSystemInfo(&systemInfo);
+	fwprintf(stdout, L"%u documents, %.1f MB, %u processors\n", (ULONG)documents.GetCount(), cb / (1024.0 * 1024.0), systemInfo.dwNumberOfProcessors);
+	fwprintf(stdout, L"%-10s %10s %10s %10s\n", L"segments", L"seconds", L"MB/s", L"speedup");
+
+	double wholeSeconds = 0;
+	for (ULONG segmentCount = 0; segmentCount <= systemInfo.dwNumberOfProcessors * 2; segmentCount = segmentCount ? segmentCount * 2 : 1)
+	{
+		LARGE_INTEGER start;
+		QueryPerformanceCounter(&start);
+		for (ULONG pass = 0; pass < repeat && SUCCEEDED(hr); pass++)
+		{
+			for (size_t i = 0; i < documents.GetCount() && SUCCEEDED(hr); i++)
+			{
+				const CAtlArray<BYTE> &html = documents[i]->html;
+				CStringW text;
+				if (segmentCount == 0)
+					hr = HtmlFilterRunner::FilterWhole(html.GetData(), html.GetCount(), text);
+				else
+					hr = HtmlFilterRunner::FilterSegmented(html.GetData(), html.GetCount(), max(html.GetCount() / segmentCount, (size_t)1), text, NULL);
+			}
+		}
+		if (FAILED(hr))
+			break;
+		double seconds = ElapsedSeconds(start);
+		if (segmentCount == 0)
+			wholeSeconds = seconds;
+
+		CString segments;
+		if (segmentCount == 0)
+			segments = _T("whole");
+		else
+			segments.Format(_T("%u"), segmentCount);
+		fwprintf(stdout, L"%-10s %10.3f %10.1f %9.2fx\n", (LPCWSTR)segments, seconds, megabytes / seconds, wholeSeconds / seconds);
+	}
+
+	FreeDocuments(documents);
+	return hr;
+}
+
+static int Parallel(const CommandLine &commandLine)
+{
+	CString action = commandLine.GetArgument(0);
+	if (action.CompareNoCase(_T("check")) == 0)
+		return ParallelCheck(commandLine);
+	if (action.CompareNoCase(_T("benchmark")) == 0)
+		return ParallelBenchmark(commandLine);
+	return -1;
+}
+
+static HANDLE s_stopEvent = NULL;
+
+static BOOL WINAPI ConsoleCtrlHandler(DWORD dwCtrlType)
+{
+	if (s_stopEvent)
+		SetEvent(s_stopEvent);
+	return TRUE;
+}
+
+static int Watch(const CommandLine &commandLine)
+{
+	DraftsIndexerOptions options;
+	options.directory = commandLine.GetArgument(0);
+	if (options.directory.IsEmpty())
+		return -1;
+	options.metricsPipe = commandLine.GetOption(_T("metrics"));
+	options.statePath = commandLine.GetOption(_T("state"));
+	options.debounceMilliseconds = commandLine.GetNumericOption(_T("debounce"), options.debounceMilliseconds);
+	options.queueCapacity = commandLine.GetNumericOption(_T("queue"), (ULONG)options.queueCapacity);
+	options.workerCount = commandLine.GetNumericOption(_T("workers"), (ULONG)options.workerCount);
+
+	IndexSink *pSink = NULL;
+	HRESULT hr = IndexSink::Create(commandLine.GetOption(_T("sink"), _T("memory")), &pSink);
+	if (FAILED(hr))
+	{
+		fwprintf(stderr, L"Invalid sink: %s\n", (LPCWSTR)commandLine.GetOption(_T("sink")));
+		return hr;
+	}
+	CAutoPtr<IndexSink> sink(pSink);
+
+	s_stopEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+	SetConsoleCtrlHandler(ConsoleCtrlHandler, TRUE);
+
+	DraftsIndexer indexer(options, sink);
+	hr = indexer.Run(s_stopEvent);
+
+	SetConsoleCtrlHandler(ConsoleCtrlHandler, FALSE);
+	CloseHandle(s_stopEvent);
+	s_stopEvent = NULL;
+
+	fprintf(stdout, "%s", (LPCSTR)indexer.GetMetrics().Format(0, options.queueCapacity, sink->GetDocumentCount()));
+	return hr;
+}
+
+static void PrintCompaction(LPCWSTR name, const CompactionResult &result)
+{
+	fwprintf(stdout, L"%s: %I64u -> %I64u bytes, %u -> %u reads, %u -> %u seeks%s\n",
+		name, result.sizeBefore, result.sizeAfter,
+		result.readsBefore.reads, result.readsAfter.reads,
+		result.readsBefore.seeks, result.readsAfter.seeks,
+		result.replaced ? L"" : L" (not replaced)");
+}
+
+static int Compact(const CommandLine &commandLine)
+{
+	CString target = commandLine.GetArgument(0);
+	if (target.IsEmpty())
+		return -1;
+	bool replace = !commandLine.HasOption(_T("dryrun"));
+
+	CAtlArray<CString> files;
+	HRESULT hr = PostSource::FindPosts(target, files);
+	if (FAILED(hr))
+		return hr;
+
+	CompactionResult totals;
+	ULONG failures = 0;
+	for (size_t i = 0; i < files.GetCount(); i++)
+	{
+		CompactionResult result;
+		HRESULT hr = PostCompactor::Compact(files[i], replace, result);
+		if (FAILED(hr))
+		{
+			// typically a post that is open in Writer; leave it for the next run
+			fwprintf(stderr, L"%s: failed with HRESULT %#08x\n", (LPCWSTR)files[i], hr);
+			failures++;
+			continue;
+		}
+		PrintCompaction(PathFindFileName(files[i]), result);
+
+		totals.sizeBefore += result.sizeBefore;
+		totals.sizeAfter += result.sizeAfter;
+		totals.readsBefore.reads += result.readsBefore.reads;
+		totals.readsAfter.reads += result.readsAfter.reads;
+		totals.readsBefore.seeks += result.readsBefore.seeks;
+		totals.readsAfter.seeks += result.readsAfter.seeks;
+		totals.replaced = result.replaced;
+	}
+
+	if (files.GetCount() > 1)
+		PrintCompaction(L"Total", totals);
+	return failures ? E_FAIL : S_OK;
+}
+
+// exceeded an allocation budget
+const HRESULT FILTERTOOL_E_BUDGET = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_ITF, 0x0401);
+
+static int Allocations(const CommandLine &commandLine)
+{
+	CString target = commandLine.GetArgument(0);
+	if (target.IsEmpty())
+		return -1;
+	bool sites = commandLine.HasOption(_T("sites"));
+	ULONG countBudget = commandLine.GetNumericOption(_T("count"), 0);
+	ULONG bytesBudget = commandLine.GetNumericOption(_T("bytes"), 0);
+	ULONG peakBudget = commandLine.GetNumericOption(_T("peak"), 0);
+
+	CAtlArray<CString> files;
+	HRESULT hr = PostSource::FindPosts(target, files);
+	if (FAILED(hr))
+		return hr;
+
+	ULONG overBudget = 0;
+	fwprintf(stdout, L"%-40s %-14s %10s %12s %12s\n", L"post", L"site", L"count", L"bytes", L"peak live");
+	for (size_t i = 0; i < files.GetCount(); i++)
+	{
+		CComPtr<IFilter> filter;
+		if (FAILED(hr = filter.CoCreateInstance(CLSID_WebPostFilter)))
+			return hr;
+		CComQIPtr<IPersistFile> persistFile(filter);
+		CComQIPtr<IWebPostFilterAllocations> filterAllocations(filter);
+		if (!persistFile || !filterAllocations)
+			return E_NOINTERFACE;
+
+		ExtractedPost post;
+		if (FAILED(hr = persistFile->Load(files[i], STGM_READ)) || FAILED(hr = PostExtractor::ExtractFromFilter(filter, post)))
+		{
+			fwprintf(stderr, L"%s: failed with HRESULT %#08x\n", (LPCWSTR)files[i], hr);
+			continue;
+		}
+
+		for (ULONG site = sites ? 0 : ALLOCATION_SITE_COUNT; site <= ALLOCATION_SITE_COUNT; site++)
+		{
+			ULONG count;
+			ULONGLONG bytes, peak;
+			if (FAILED(hr = filterAllocations->GetAllocations(site, &count, &bytes, &peak)))
+			{
+				if (hr == E_NOTIMPL)
+					fwprintf(stderr, L"The filter was built without OLW_ALLOCATION_ACCOUNTING.\n");
+				return hr;
+			}
+			fwprintf(stdout, L"%-40s %-14s %10u %12I64u %12I64u\n",
+				PathFindFileName(files[i]), GetAllocationSiteName(site), count, bytes, peak);
+
+			if (site == ALLOCATION_SITE_COUNT
+				&& ((countBudget && count > countBudget) || (bytesBudget && bytes > bytesBudget) || (peakBudget && peak > peakBudget)))
+			{
+				fwprintf(stderr, L"%s: over the allocation budget\n", (LPCWSTR)files[i]);
+				overBudget++;
+			}
+		}
+	}
+
+	return overBudget ? FILTERTOOL_E_BUDGET : S_OK;
+}
+
+static int RecordTrace(const CommandLine &commandLine)
+{
+	CString path = commandLine.GetArgument(1);
+	if (path.IsEmpty())
+		return -1;
+	DWORD capacity = commandLine.GetNumericOption(_T("records"), 0x100000);
+	DWORD seconds = commandLine.GetNumericOption(_T("seconds"), INFINITE);
+
+	FilterTraceCapture capture;
+	HRESULT hr = capture.Create(capacity);
+	if (FAILED(hr))
+		return hr;
+
+	fwprintf(stderr, L"Recording filter calls, press Ctrl+C to stop.\n");
+	s_stopEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+	SetConsoleCtrlHandler(ConsoleCtrlHandler, TRUE);
+	WaitForSingleObject(s_stopEvent, seconds == INFINITE ? INFINITE : seconds * 1000);
+	SetConsoleCtrlHandler(ConsoleCtrlHandler, FALSE);
+	CloseHandle(s_stopEvent);
+	s_stopEvent = NULL;
+
+	ULONG recordCount, droppedCount;
+	if (FAILED(hr = capture.Save(path, &recordCount, &droppedCount)))
+		return hr;
+	fwprintf(stdout, L"%u calls recorded, %u dropped\n", recordCount, droppedCount);
+	return S_OK;
+}
+
+static int ReplayTrace(const CommandLine &commandLine)
+{
+	CString path = commandLine.GetArgument(1);
+	CString corpus = commandLine.GetArgument(2);
+	if (path.IsEmpty() || corpus.IsEmpty())
+		return -1;
+	ULONG repeat = max(commandLine.GetNumericOption(_T("repeat"), 1), 1UL);
+
+	FilterTraceReplayer replayer;
+	HRESULT hr;
+	if (FAILED(hr = replayer.Load(path)))
+		return hr;
+	if (FAILED(hr = replayer.IndexCorpus(corpus)))
+		return hr;
+	if (FAILED(hr = replayer.Replay(repeat)))
+		return hr;
+
+	fwprintf(stdout, L"%u posts replayed, %u not found in the corpus, %u calls dropped while recording\n",
+		replayer.GetSessionCount(), replayer.GetMissingCount(), replayer.GetDroppedCount());
+	fwprintf(stdout, L"%-14s %10s %14s %14s %10s\n", L"call", L"count", L"recorded ms", L"replayed ms", L"mismatch");
+	for (DWORD call = FILTER_TRACE_LOAD_FILE; call < FILTER_TRACE_CALL_COUNT; call++)
+	{
+		const FilterTraceCallStatistics &statistics = replayer.GetStatistics(call);
+		if (statistics.calls == 0)
+			continue;
+		fwprintf(stdout, L"%-14s %10u %14.1f %14.1f %10u\n",
+			FilterTraceReplayer::GetCallName(call), statistics.calls,
+			statistics.recordedMicroseconds * repeat / 1000.0, statistics.replayedMicroseconds / 1000.0,
+			statistics.mismatches);
+	}
+	return S_OK;
+}
+
+static int Trace(const CommandLine &commandLine)
+{
+	CString action = commandLine.GetArgument(0);
+	if (action.CompareNoCase(_T("record")) == 0)
+		return RecordTrace(commandLine);
+	if (action.CompareNoCase(_T("replay")) == 0)
+		return ReplayTrace(commandLine);
+	return -1;
+}
+
+// Title and keywords come out of the filter with the byte order mark they were stored with.
+static CStringW WithoutByteOrderMark(const CStringW &value)
+{
+	return !value.IsEmpty() && value[0] == 0xFEFF ? value.Mid(1) : value;
+}
+
+static int Export(const CommandLine &commandLine)
+{
+	CString target = commandLine.GetArgument(0);
+	CString output = commandLine.GetArgument(1);
+	if (target.IsEmpty() || output.IsEmpty())
+		return -1;
+
+	PostSource posts;
+	HRESULT hr = posts.Open(target);
+	if (FAILED(hr))
+		return hr;
+
+	ColumnarWriter writer;
+	if (FAILED(hr = writer.Create(output)))
+		return hr;
+
+	ULONG failures = 0;
+	for (size_t i = 0; i < posts.GetCount(); i++)
+	{
+		ExtractedPost post;
+		ColumnarRow row;
+		if (FAILED(hr = posts.Extract(i, post)) || FAILED(hr = posts.ReadIdentity(i, row.id, row.blogId)))
+		{
+			fwprintf(stderr, L"%s: failed with HRESULT %#08x\n", (LPCWSTR)posts.GetName(i), hr);
+			failures++;
+			continue;
+		}
+		row.title = WithoutByteOrderMark(post.title);
+		row.keywords = WithoutByteOrderMark(post.keywords);
+		row.date = post.primaryDate;
+		row.body = post.body;
+		if (FAILED(hr = writer.Append(row)))
+			return hr;
+	}
+	if (FAILED(hr = writer.Close()))
+		return hr;
+
+	fwprintf(stdout, L"%u posts exported, %u failed, %I64u bytes\n",
+		(ULONG)posts.GetCount() - failures, failures, writer.GetBytesWritten());
+	return failures ? E_FAIL : S_OK;
+}
+
+static int Benchmark(const CommandLine &commandLine)
+{
+	CString output = commandLine.GetArgument(0);
+	if (output.IsEmpty())
+		return -1;
+	ULONG postCount = commandLine.GetNumericOption(_T("posts"), 100000);
+	ULONG bodyLength = commandLine.GetNumericOption(_T("body"), 4096);
+
+	// a handful of blogs and tags across many posts, like a real drafts folder
+	static LPCWSTR KEYWORDS[] = { L"", L"travel", L"photography, travel", L"code", L"news", L"recipes" };
+	CStringW body;
+	for (ULONG i = 0; i < bodyLength; i++)
+		body.AppendChar((WCHAR)(L'a' + i % 26));
+
+	HRESULT hr;
+	ColumnarWriter writer;
+	if (FAILED(hr = writer.Create(output)))
+		return hr;
+
+	LARGE_INTEGER start;
+	QueryPerformanceCounter(&start);
+	ColumnarRow row;
+	row.body = body;
+	for (ULONG i = 0; i < postCount; i++)
+	{
+		row.id.Format(L"%08x-0000-0000-0000-%012x", i, i);
+		row.blogId.Format(L"blog-%u", i % 4);
+		row.title.Format(L"Post number %u", i);
+		row.keywords = KEYWORDS[i % _countof(KEYWORDS)];
+		ULONGLONG date = 0x01D0000000000000ULL + (ULONGLONG)i * 36000000000ULL;
+		row.date.dwLowDateTime = (DWORD)date;
+		row.date.dwHighDateTime = (DWORD)(date >> 32);
+		if (FAILED(hr = writer.Append(row)))
+			return hr;
+	}
+	if (FAILED(hr = writer.Close()))
+		return hr;
+	double writeSeconds = ElapsedSeconds(start);
+
+	QueryPerformanceCounter(&start);
+	ColumnarReader reader;
+	if (FAILED(hr = reader.Open(output)))
+		return hr;
+	ULONGLONG scannedBytes = 0;
+	ULONG checksum = 0;
+	for (DWORD rowGroup = 0; rowGroup < reader.GetRowGroupCount(); rowGroup++)
+	{
+		for (int column = 0; column < COLUMNAR_COLUMN_COUNT; column++)
+		{
+			if (column == COLUMNAR_DATE)
+				continue;
+			ColumnarStringColumn strings;
+			if (FAILED(hr = reader.GetStringColumn(rowGroup, column, strings)))
+				return hr;
+			for (DWORD i = 0; i < strings.GetRowCount(); i++)
+			{
+				// touch the last byte of every value so that the scan can't skip the data
+				const char *value;
+				DWORD cb;
+				strings.Get(i, &value, &cb);
+				scannedBytes += cb;
+				if (cb)
+					checksum += (BYTE)value[cb - 1];
+			}
+		}
+	}
+	double scanSeconds = ElapsedSeconds(start);
+
+	double megabytes = writer.GetBytesWritten() / (1024.0 * 1024.0);
+	fwprintf(stdout, L"%u posts, %.1f MB written in %.3f s (%.1f MB/s)\n",
+		postCount, megabytes, writeSeconds, megabytes / writeSeconds);
+	fwprintf(stdout, L"%I64u rows, %.1f MB of values scanned in %.3f s (%.1f MB/s, checksum %u)\n",
+		reader.GetTotalRowCount(), scannedBytes / (1024.0 * 1024.0), scanSeconds,
+		scannedBytes / (1024.0 * 1024.0) / scanSeconds, checksum);
+	return S_OK;
+}
+
+// failed Unicode conformance tests
+const HRESULT FILTERTOOL_E_CONFORMANCE = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_ITF, 0x0501);
+
+/*
+Checks WordSegmenter against the WordBreakTest.txt of the Unicode version
+its table was generated from. Each test is a line of hex code points with
+a division sign (U+00F7, a boundary) or a multiplication sign (U+00D7, no
+boundary) between them, in UTF-8.
+*/
+static int SegmentConformance(const CommandLine &commandLine)
+{
+	CString path = commandLine.GetArgument(1);
+	if (path.IsEmpty())
+		return -1;
+
+	FILE *file = NULL;
+	if (_wfopen_s(&file, path, L"rb") != 0 || !file)
+	{
+		fwprintf(stderr, L"Can't open %s\n", (LPCWSTR)path);
+		return HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND);
+	}
+
+	ULONG tests = 0, failures = 0, lineNumber = 0;
+	char line[0x1000];
+	while (fgets(line, sizeof(line), file))
+	{
+		lineNumber++;
+		char *comment = strchr(line, '#');
+		if (comment)
+			*comment = '\0';
+
+		CStringW text;
+		CAtlArray<ULONG> expected;
+		char *context = NULL;
+		for (char *token = strtok_s(line, " \t\r\n", &context); token; token = strtok_s(NULL, " \t\r\n", &context))
+		{
+			if (strcmp(token, "\xC3\xB7") == 0)
+				expected.Add(text.GetLength());
+			else if (strcmp(token, "\xC3\x97") != 0)
+			{
+				unsigned int codePoint = strtoul(token, NULL, 16);
+				if (codePoint >= 0x10000)
+				{
+					text.AppendChar((WCHAR)(0xD800 + ((codePoint - 0x10000) >> 10)));
+					text.AppendChar((WCHAR)(0xDC00 + ((codePoint - 0x10000) & 0x3FF)));
+				}
+				else
+				{
+					text.AppendChar((WCHAR)codePoint);
+				}
+			}
+		}
+		if (text.IsEmpty())
+			continue;
+		tests++;
+
+		// the test data always has a boundary at the start and at the end
+		bool passed = expected.GetCount() > 1 && expected[0] == 0;
+		size_t boundary = 1;
+		for (ULONG start = 0; passed && start < (ULONG)text.GetLength(); boundary++)
+		{
+			start = WordSegmenter::NextBoundary(text, text.GetLength(), start);
+			passed = boundary < expected.GetCount() && expected[boundary] == start;
+		}
+		passed = passed && boundary == expected.GetCount();
+
+		if (!passed)
+		{
+			if (failures < 20)
+				fwprintf(stderr, L"Line %u fails\n", lineNumber);
+			failures++;
+		}
+	}
+	fclose(file);
+
+	fwprintf(stdout, L"%u of %u tests passed\n", tests - failures, tests);
+	return failures ? FILTERTOOL_E_CONFORMANCE : S_OK;
+}
+
+static int SegmentBenchmark(const CommandLine &commandLine)
+{
+	CString target = commandLine.GetArgument(1);
+	if (target.IsEmpty())
+		return -1;
+	ULONG repeat = max(commandLine.GetNumericOption(_T("repeat"), 10), 1UL);
+
+	PostSource posts;
+	HRESULT hr = posts.Open(target);
+	if (FAILED(hr))
+		return hr;
+
+	// segment what the filter produces, not the HTML
+	CAtlArray<CStringW> texts;
+	ULONGLONG characters = 0;
+	for (size_t i = 0; i < posts.GetCount(); i++)
+	{
+		ExtractedPost post;
+		if (FAILED(hr = posts.Extract(i, post)))
+		{
+			fwprintf(stderr, L"%s: failed with HRESULT %#08x\n", (LPCWSTR)posts.GetName(i), hr);
+			continue;
+		}
+		texts.Add(post.title + L" " + post.keywords + L" " + post.body);
+		characters += texts[texts.GetCount() - 1].GetLength();
+	}
+	if (texts.IsEmpty())
+		return E_FAIL;
+
+	ULONGLONG segments = 0, words = 0;
+	LARGE_INTEGER start;
+	QueryPerformanceCounter(&start);
+	for (ULONG pass = 0; pass < repeat; pass++)
+	{
+		for (size_t i = 0; i < texts.GetCount(); i++)
+		{
+			const WCHAR *text = texts[i];
+			ULONG length = texts[i].GetLength();
+			for (ULONG position = 0; position < length; )
+			{
+				ULONG end = WordSegmenter::NextBoundary(text, length, position);
+				segments++;
+				if (WordSegmenter::IsWord(text + position, end - position))
+					words++;
+				position = end;
+			}
+		}
+	}
+	double seconds = ElapsedSeconds(start);
+
+	fwprintf(stdout, L"%u posts, %I64u characters, %I64u words, %I64u segments per pass\n",
+		(ULONG)texts.GetCount(), characters, words / repeat, segments / repeat);
+	fwprintf(stdout, L"%.0f words/s, %.1f MB/s of UTF-16 text\n",
+		words / seconds, characters * repeat * sizeof(WCHAR) / (1024.0 * 1024.0) / seconds);
+	return S_OK;
+}
+
+static int Segment(const CommandLine &commandLine)
+{
+	CString action = commandLine.GetArgument(0);
+	if (action.CompareNoCase(_T("conformance")) == 0)
+		return SegmentConformance(commandLine);
+	if (action.CompareNoCase(_T("benchmark")) == 0)
+		return SegmentBenchmark(commandLine);
+	return -1;
+}
+
+static int Pending(const CommandLine &commandLine)
+{
+	if (commandLine.GetArgument(0).CompareNoCase(_T("check")) != 0)
+		return -1;
+
+	// run every check, so that one failure doesn't hide another
+	HRESULT results[] = {
+		PendingCheck::CheckSlowStream(false),
+		PendingCheck::CheckSlowStream(true),
+		PendingCheck::CheckAsyncHost() };
+	for (size_t i = 0; i < _countof(results); i++)
+	{
+		if (FAILED(results[i]))
+			return results[i];
+	}
+	return S_OK;
+}
+
+static void PrintRepack(LPCWSTR path, ULONGLONG sizeBefore, ULONGLONG sizeAfter)
+{
+	fwprintf(stdout, L"%s: repacked, %I64u -> %I64u bytes\n", PathFindFileName(path), sizeBefore, sizeAfter);
+}
+
+static int PackAdd(const CommandLine &commandLine)
+{
+	CString target = commandLine.GetArgument(1);
+	CString path = commandLine.GetArgument(2);
+	if (target.IsEmpty() || path.IsEmpty())
+		return -1;
+	DWORD payload = commandLine.HasOption(_T("streams")) ? POST_PACK_STREAMS : POST_PACK_COMPOUND;
+	ULONG repackPercent = commandLine.GetNumericOption(_T("repack"), 50);
+
+	CAtlArray<CString> files;
+	HRESULT hr = PostSource::FindPosts(target, files);
+	if (FAILED(hr))
+		return hr;
+
+	PostPackWriter writer;
+	if (FAILED(hr = writer.Open(path)))
+		return hr;
+	ULONG failures = 0;
+	for (size_t i = 0; i < files.GetCount(); i++)
+	{
+		if (FAILED(hr = writer.AppendFile(files[i], payload)))
+		{
+			fwprintf(stderr, L"%s: failed with HRESULT %#08x\n", (LPCWSTR)files[i], hr);
+			failures++;
+		}
+	}
+	if (FAILED(hr = writer.Close()))
+		return hr;
+	fwprintf(stdout, L"%u posts packed, %u failed, %I64u of %I64u bytes live\n",
+		(ULONG)files.GetCount() - failures, failures, writer.GetLiveBytes(), writer.GetFileSize());
+
+	// posts packed again leave their earlier records behind
+	ULONGLONG deadBytes = writer.GetFileSize() - writer.GetLiveBytes();
+	if (repackPercent && deadBytes * 100 > writer.GetFileSize() * repackPercent)
+	{
+		ULONGLONG sizeBefore, sizeAfter;
+		if (FAILED(hr = PostPackWriter::Repack(path, &sizeBefore, &sizeAfter)))
+			return hr;
+		PrintRepack(path, sizeBefore, sizeAfter);
+	}
+	return failures ? E_FAIL : S_OK;
+}
+
+static void PrintPackEntry(const PostPackReader &reader, DWORD entry)
+{
+	PostPackEntry post;
+	reader.GetEntry(entry, post);
+	SYSTEMTIME date = { 0 };
+	FileTimeToSystemTime(&post.date, &date);
+	fwprintf(stdout, L"%04u-%02u-%02u %02u:%02u:%02u  %-38.*s %-38.*s %12I64u\n",
+		date.wYear, date.wMonth, date.wDay, date.wHour, date.wMinute, date.wSecond,
+		(int)post.blogIdLength, post.blogId, (int)post.postIdLength, post.postId, post.recordSize);
+}
+
+static int PackList(const CommandLine &commandLine)
+{
+	CString path = commandLine.GetArgument(1);
+	if (path.IsEmpty())
+		return -1;
+	bool byDate = commandLine.HasOption(_T("bydate"));
+
+	PostPackReader reader;
+	HRESULT hr = reader.Open(path);
+	if (FAILED(hr))
+		return hr;
+
+	fwprintf(stdout, L"%-20s %-38s %-38s %12s\n", L"date", L"blog", L"post", L"bytes");
+	if (commandLine.HasOption(_T("post")))
+	{
+		DWORD entry;
+		if (!reader.Find(CStringW(commandLine.GetOption(_T("blog"))), CStringW(commandLine.GetOption(_T("post"))), &entry))
+			return HRESULT_FROM_WIN32(ERROR_NOT_FOUND);
+		PrintPackEntry(reader, entry);
+		return S_OK;
+	}
+
+	for (DWORD i = 0; i < reader.GetCount(); i++)
+		PrintPackEntry(reader, byDate ? reader.GetEntryByDate(i) : i);
+	fwprintf(stdout, L"%u posts, %I64u of %I64u bytes live\n", reader.GetCount(), reader.GetLiveBytes(), reader.GetFileSize());
+	return S_OK;
+}
+
+static int PackRepack(const CommandLine &commandLine)
+{
+	CString path = commandLine.GetArgument(1);
+	if (path.IsEmpty())
+		return -1;
+
+	ULONGLONG sizeBefore, sizeAfter;
+	HRESULT hr = PostPackWriter::Repack(path, &sizeBefore, &sizeAfter);
+	if (FAILED(hr))
+		return hr;
+	PrintRepack(path, sizeBefore, sizeAfter);
+	return S_OK;
+}
+
+static int PackCheckAll(const CommandLine &commandLine)
+{
+	// run every check, so that one failure doesn't hide another
+	HRESULT results[] = {
+		PackCheck::CheckJournal(),
+		PackCheck::CheckStringEncodings(),
+		PackCheck::CheckForeignStream() };
+	for (size_t i = 0; i < _countof(results); i++)
+	{
+		if (FAILED(results[i]))
+			return results[i];
+	}
+	return S_OK;
+}
+
+static int Pack(const CommandLine &commandLine)
+{
+	CString action = commandLine.GetArgument(0);
+	if (action.CompareNoCase(_T("add")) == 0)
+		return PackAdd(commandLine);
+	if (action.CompareNoCase(_T("list")) == 0)
+		return PackList(commandLine);
+	if (action.CompareNoCase(_T("repack")) == 0)
+		return PackRepack(commandLine);
+	if (action.CompareNoCase(_T("check")) == 0)
+		return PackCheckAll(commandLine);
+	return -1;
+}
+
+/*
+Reads the id and title of each post the way the lookup cache does, decoding
+the compound file from memory and leaving the contents and pictures alone.
+*/
+class HeaderScanner : public PostFileConsumer
+{
+public:
+	HeaderScanner(void) : m_postCount(0), m_failureCount(0), m_titleCharacters(0)
+	{
+	}
+
+	virtual void Consume(const LoadedPostFile &file)
+	{
+		HRESULT hr = file.hr;
+		CStringW id, title;
+		if (SUCCEEDED(hr))
+		{
+			try
+			{
+				PostFileDecoder decoder;
+				CAtlArray<BYTE> decoded;
+				if (!decoder.Open(file.data, (size_t)file.size, HEADER_STREAM_LENGTH))
+					hr = HRESULT_FROM_WIN32(ERROR_FILE_CORRUPT);
+				else if (!decoded.SetCount(decoder.GetLength()))
+					hr = E_OUTOFMEMORY;
+				else if (!decoder.Write(decoded.GetData()))
+					hr = HRESULT_FROM_WIN32(ERROR_FILE_CORRUPT);
+				else if (SUCCEEDED(hr = PostPackReader::ReadDecodedString(decoded.GetData(), decoded.GetCount(), decoder.GetElementCount(), POST_ID, id)))
+					hr = PostPackReader::ReadDecodedString(decoded.GetData(), decoded.GetCount(), decoder.GetElementCount(), POST_TITLE, title);
+			}
+			catch (std::bad_alloc&)
+			{
+				hr = E_OUTOFMEMORY;
+			}
+		}
+
+		if (FAILED(hr))
+		{
+			fwprintf(stderr, L"%s: failed with HRESULT %#08x\n", (LPCWSTR)file.path, hr);
+			InterlockedIncrement(&m_failureCount);
+			return;
+		}
+		InterlockedIncrement(&m_postCount);
+		InterlockedExchangeAdd(&m_titleCharacters, title.GetLength());
+	}
+
+	ULONG GetPostCount(void) const { return (ULONG)m_postCount; }
+	ULONG GetFailureCount(void) const { return (ULONG)m_failureCount; }
+	ULONG GetTitleCharacters(void) const { return (ULONG)m_titleCharacters; }
+
+private:
+	// enough for the id and the title
+	static const ULONGLONG HEADER_STREAM_LENGTH = 0x1000;
+
+	volatile LONG m_postCount;
+	volatile LONG m_failureCount;
+	volatile LONG m_titleCharacters;
+};
+
+static LPCWSTR GetBackendName(PostFileLoaderBackend backend)
+{
+	switch (backend)
+	{
+	case POST_FILE_LOADER_SYNC:
+		return L"sync";
+	case POST_FILE_LOADER_THREADS:
+		return L"threads";
+	default:
+		return L"overlapped";
+	}
+}
+
+static HRESULT ScanHeaders(const CAtlArray<CString> &files, const PostFileLoaderOptions &options, LPCWSTR cache)
+{
+	HeaderScanner scanner;
+	PostFileLoader loader(options);
+
+	LARGE_INTEGER start;
+	QueryPerformanceCounter(&start);
+	HRESULT hr = loader.Run(files, &scanner);
+	double seconds = ElapsedSeconds(start);
+	if (FAILED(hr))
+		return hr;
+
+	double megabytes = loader.GetBytesRead() / (1024.0 * 1024.0);
+	fwprintf(stdout, L"%-11s %-9s %8u %8u %12.0f %10.1f %10.3f\n",
+		GetBackendName(options.backend), cache, scanner.GetPostCount(), scanner.GetFailureCount(),
+		scanner.GetPostCount() / seconds, megabytes / seconds, seconds);
+	return S_OK;
+}
+
+static int Scan(const CommandLine &commandLine)
+{
+	CString target = commandLine.GetArgument(0);
+	if (target.IsEmpty())
+		return -1;
+
+	PostFileLoaderOptions options;
+	options.queueDepth = commandLine.GetNumericOption(_T("depth"), (ULONG)options.queueDepth);
+	options.workerCount = commandLine.GetNumericOption(_T("workers"), (ULONG)options.workerCount);
+	options.uncached = commandLine.HasOption(_T("uncached"));
+	CString backend = commandLine.GetOption(_T("backend"), _T("overlapped"));
+	if (backend.CompareNoCase(_T("sync")) == 0)
+		options.backend = POST_FILE_LOADER_SYNC;
+	else if (backend.CompareNoCase(_T("threads")) == 0)
+		options.backend = POST_FILE_LOADER_THREADS;
+	else if (backend.CompareNoCase(_T("overlapped")) != 0)
+		return -1;
+
+	CAtlArray<CString> files;
+	HRESULT hr = PostSource::FindPosts(target, files);
+	if (FAILED(hr))
+		return hr;
+
+	fwprintf(stdout, L"%-11s %-9s %8s %8s %12s %10s %10s\n", L"backend", L"cache", L"posts", L"failed", L"posts/s", L"MB/s", L"seconds");
+	if (!commandLine.HasOption(_T("compare")))
+		return ScanHeaders(files, options, options.uncached ? L"uncached" : L"cached");
+
+	// every backend reading around the cache, as on a cold one, then through a
+	// cache the first cached pass has filled
+	static const PostFileLoaderBackend BACKENDS[] = { POST_FILE_LOADER_SYNC, POST_FILE_LOADER_THREADS, POST_FILE_LOADER_OVERLAPPED };
+	options.uncached = true;
+	for (size_t i = 0; i < _countof(BACKENDS); i++)
+	{
+		options.backend = BACKENDS[i];
+		if (FAILED(hr = ScanHeaders(files, options, L"uncached")))
+			return hr;
+	}
+	options.uncached = false;
+	options.backend = POST_FILE_LOADER_SYNC;
+	if (FAILED(hr = ScanHeaders(files, options, L"filling")))
+		return hr;
+	for (size_t i = 0; i < _countof(BACKENDS); i++)
+	{
+		options.backend = BACKENDS[i];
+		if (FAILED(hr = ScanHeaders(files, options, L"cached")))
+			return hr;
+	}
+	return S_OK;
+}
+
+static void Usage(void)
+{
+	fwprintf(stderr,
+		L"Usage: OpenLiveWriter.FilterTool <command> [arguments]\n"
+		L"\n"
+		L"  parallel check [<file|directory>...] [/segments:<n>] [/segment:<bytes>]\n"
+		L"      Filters HTML documents whole and in <n> (8) segments, the way the filter\n"
+		L"      does large bodies, and checks that the text is the same. Without any\n"
+		L"      .htm or .html files, checks synthetic documents of /size:<bytes> (2 MB)\n"
+		L"      in windows-1252 and UTF-8.\n"
+		L"  parallel benchmark [<file|directory>...] [/repeat:<n>] [/size:<bytes>]\n"
+		L"      Times filtering the same documents whole and in 1 up to twice the\n"
+		L"      processors' segments.\n"
+		L"  watch <directory> [/sink:jsonl=<file>|pipe=<name>|memory] [/debounce:<ms>]\n"
+		L"        [/queue:<n>] [/workers:<n>] [/metrics:<pipe name>] [/state:<file>]\n"
+		L"      Keeps the sink up to date with the .wpost files in <directory>.\n"
+		L"  compact <file|directory> [/dryrun]\n"
+		L"      Rewrites .wpost files without free space and with their streams laid out\n"
+		L"      in read order, reporting sizes and storage reads before and after.\n"
+		L"  allocations <file|directory> [/sites] [/count:<n>] [/bytes:<n>] [/peak:<n>]\n"
+		L"      Filters each post and reports its heap allocations, per call site with\n"
+		L"      /sites. Fails if a post goes over any of the budgets given. Needs a\n"
+		L"      filter built with OLW_ALLOCATION_ACCOUNTING.\n"
+		L"  trace record <trace file> [/records:<n>] [/seconds:<n>]\n"
+		L"      Records the calls the search host makes on the filter until Ctrl+C.\n"
+		L"      Has to run elevated to see the host's filters.\n"
+		L"  trace replay <trace file> <directory> [/repeat:<n>]\n"
+		L"      Makes the recorded calls again on the .wpost files in <directory>\n"
+		L"      and compares timings and results with the recording.\n"
+		L"  export <file|directory|pack> <output file>\n"
+		L"      Writes the id, blog id, title, keywords, date and body of each post to\n"
+		L"      a columnar file for bulk analysis.\n"
+		L"  benchmark <output file> [/posts:<n>] [/body:<chars>]\n"
+		L"      Exports synthetic posts to <output file>, then scans it back, and\n"
+		L"      reports write and scan throughput.\n"
+		L"  segment conformance <WordBreakTest.txt>\n"
+		L"      Runs the Unicode word boundary tests against the filter's word segmenter.\n"
+		L"  segment benchmark <file|directory|pack> [/repeat:<n>]\n"
+		L"      Breaks the filtered text of the posts into words and reports words per\n"
+		L"      second.\n"
+		L"  pending check\n"
+		L"      Filters a stream that is slow to produce its data, and a large post\n"
+		L"      for a host with a ready callback, and checks that the text comes out\n"
+		L"      whole and that the host's callback is let go with the filter.\n"
+		L"  pack add <file|directory> <pack file> [/streams] [/repack:<percent>]\n"
+		L"      Appends .wpost files to a pack (.olwpack), replacing posts with the same\n"
+		L"      blog id and id, and repacks it once more than <percent> (50) of it is\n"
+		L"      dead space. /streams stores the posts' streams decoded rather than\n"
+		L"      their compound files, which the filter can't read.\n"
+		L"  pack list <pack file> [/bydate] [/blog:<id> /post:<id>]\n"
+		L"      Lists the posts in a pack, or finds one.\n"
+		L"  pack repack <pack file>\n"
+		L"      Rewrites a pack with only the latest copy of each post.\n"
+		L"  pack check\n"
+		L"      Packs a post with an autosaved body both ways, and checks that the\n"
+		L"      filter and the STREAMS reader both find the autosaved body, that the\n"
+		L"      reader reads strings with any byte order mark, and that the filter\n"
+		L"      only reads a stream's own ILockBytes if it is a pack's.\n"
+		L"  scan <file|directory> [/backend:overlapped|threads|sync] [/depth:<n>]\n"
+		L"        [/workers:<n>] [/uncached] [/compare]\n"
+		L"      Reads the id and title of each post, with <n> (32) files being read at\n"
+		L"      once and handed to <n> (2) workers, and reports posts per second.\n"
+		L"      /uncached reads around the file cache, as if it were cold. /compare\n"
+		L"      runs every backend uncached, then cached.\n"
+		L"\n"
+		L"A pack can stand in for a directory of posts wherever it says pack; its posts\n"
+		L"are filtered straight out of the mapped file.\n");
+}
+
+int wmain(int argc, wchar_t *argv[])
+{
+	if (argc < 2)
+	{
+		Usage();
+		return -1;
+	}
+
+	HRESULT hr = CoInitializeEx(NULL, COINIT_MULTITHREADED);
+	if (FAILED(hr))
+		return hr;
+	TRACEPOINT_REGISTER();
+
+	int result = -1;
+	try
+	{
+		CString command(argv[1]);
+		CommandLine commandLine(argc - 2, argv + 2);
+
+		if (command.CompareNoCase(_T("parallel")) == 0)
+			result = Parallel(commandLine);
+		else if (command.CompareNoCase(_T("watch")) == 0)
+			result = Watch(commandLine);
+		else if (command.CompareNoCase(_T("compact")) == 0)
+			result = Compact(commandLine);
+		else if (command.CompareNoCase(_T("allocations")) == 0)
+			result = Allocations(commandLine);
+		else if (command.CompareNoCase(_T("trace")) == 0)
+			result = Trace(commandLine);
+		else if (command.CompareNoCase(_T("export")) == 0)
+			result = Export(commandLine);
+		else if (command.CompareNoCase(_T("benchmark")) == 0)
+			result = Benchmark(commandLine);
+		else if (command.CompareNoCase(_T("segment")) == 0)
+			result = Segment(commandLine);
+		else if (command.CompareNoCase(_T("pending")) == 0)
+			result = Pending(commandLine);
+		else if (command.CompareNoCase(_T("pack")) == 0)
+			result = Pack(commandLine);
+		else if (command.CompareNoCase(_T("scan")) == 0)
+			result = Scan(commandLine);
+
+		if (result == -1)
+			Usage();
+		else if (FAILED(result))
+			fwprintf(stderr, L"Failed with HRESULT %#08x\n", result);
+	}
+	catch(HResultException e)
+	{
+		fwprintf(stderr, L"Failed with HRESULT %#08x (%S, line %d)\n", e.GetErrorCode(), (LPCSTR)e.GetFile(), e.GetLine());
+		result = e.GetErrorCode();
+	}
+
+	TRACEPOINT_UNREGISTER();
+	CoUninitialize();
+	return result;
+}
@@ -0,0 +1,422 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "stdafx.h"
+#include "PackCheck.h"
+#include "PostExtractor.h"
+#include "PostPackReader.h"
+#include "PostPackWriter.h"
+#include "..\OpenLiveWriter.Filter\ContentsJournal.h"
+#include "..\OpenLiveWriter.Filter\PostEditorFileConstants.h"
+
+// a pack check that fails
+const HRESULT FILTERTOOL_E_PACK_CHECK = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_ITF, 0x0801);
+
+// the body as it was last saved in full, and as it was autosaved since
+static const char BASE_BODY[] = "\xEF\xBB\xBF<html><body><p>The first draft of a packed post.</p></body></html>";
+static const char AUTOSAVED_BODY[] = "\xEF\xBB\xBF<html><body><p>The autosaved draft of a packed post.</p></body></html>";
+
+/*
+A stream that is ILockBytes as well, without being a pack's view: it reads
+through to another stream, but none of its lock bytes can be read, so a
+filter that opened the post through them would fail.
+*/
+class ForeignLockBytesStream : public IStream, public ILockBytes
+{
+public:
+	ForeignLockBytesStream(IStream *stream) : m_refCount(1), m_stream(stream)
+	{
+	}
+
+	// IUnknown
+	STDMETHODIMP QueryInterface(REFIID riid, void **ppvObject)
+	{
+		if (!ppvObject)
+			return E_POINTER;
+		*ppvObject = NULL;
+		if (riid == IID_IUnknown || riid == IID_IStream || riid == IID_ISequentialStream)
+			*ppvObject = static_cast<IStream*>(this);
+		else if (riid == IID_ILockBytes)
+			*ppvObject = static_cast<ILockBytes*>(this);
+		else
+			return E_NOINTERFACE;
+		AddRef();
+		return S_OK;
+	}
+
+	STDMETHODIMP_(ULONG) AddRef(void)
+	{
+		return InterlockedIncrement(&m_refCount);
+	}
+
+	STDMETHODIMP_(ULONG) Release(void)
+	{
+		LONG refCount = InterlockedDecrement(&m_refCount);
+		if (refCount == 0)
+			delete this;
+		return refCount;
+	}
+
+	// ISequentialStream
+	STDMETHODIMP Read(void *pv, ULONG cb, ULONG *pcbRead) { return m_stream->Read(pv, cb, pcbRead); }
+	STDMETHODIMP Write(const void *pv, ULONG cb, ULONG *pcbWritten) { return STG_E_ACCESSDENIED; }
+
+	// IStream
+	STDMETHODIMP Seek(LARGE_INTEGER dlibMove, DWORD dwOrigin, ULARGE_INTEGER *plibNewPosition) { return m_stream->Seek(dlibMove, dwOrigin, plibNewPosition); }
+	STDMETHODIMP CopyTo(IStream *pstm, ULARGE_INTEGER cb, ULARGE_INTEGER *pcbRead, ULARGE_INTEGER *pcbWritten) { return m_stream->CopyTo(pstm, cb, pcbRead, pcbWritten); }
+	STDMETHODIMP Commit(DWORD grfCommitFlags) { return S_OK; }
+	STDMETHODIMP Revert(void) { return S_OK; }
+	STDMETHODIMP Clone(IStream **ppstm) { return E_NOTIMPL; }
+
+	// ILockBytes
+	STDMETHODIMP ReadAt(ULARGE_INTEGER ulOffset, void *pv, ULONG cb, ULONG *pcbRead) { return STG_E_READFAULT; }
+	STDMETHODIMP WriteAt(ULARGE_INTEGER ulOffset, const void *pv, ULONG cb, ULONG *pcbWritten) { return STG_E_ACCESSDENIED; }
+	STDMETHODIMP Flush(void) { return S_OK; }
+
+	// both
+	STDMETHODIMP SetSize(ULARGE_INTEGER cb) { return STG_E_ACCESSDENIED; }
+	STDMETHODIMP LockRegion(ULARGE_INTEGER libOffset, ULARGE_INTEGER cb, DWORD dwLockType) { return STG_E_INVALIDFUNCTION; }
+	STDMETHODIMP UnlockRegion(ULARGE_INTEGER libOffset, ULARGE_INTEGER cb, DWORD dwLockType) { return STG_E_INVALIDFUNCTION; }
+	STDMETHODIMP Stat(STATSTG *pstatstg, DWORD grfStatFlag) { return m_stream->Stat(pstatstg, grfStatFlag); }
+
+private:
+	volatile LONG m_refCount;
+	CComPtr<IStream> m_stream;
+};
+
+static void AppendBytes(CAtlArray<BYTE> &buffer, const void *data, size_t cb)
+{
+	size_t count = buffer.GetCount();
+	buffer.SetCount(count + cb);
+	memcpy(buffer.GetData() + count, data, cb);
+}
+
+static void AppendDword(CAtlArray<BYTE> &buffer, DWORD value)
+{
+	BYTE bytes[4] = { (BYTE)value, (BYTE)(value >> 8), (BYTE)(value >> 16), (BYTE)(value >> 24) };
+	AppendBytes(buffer, bytes, sizeof(bytes));
+}
+
+// The journal autosave would write to turn BASE_BODY into AUTOSAVED_BODY, in
+// the format of PostContentsJournal.cs: a header, then one record replacing
+// the words that differ.
+static void CreateJournal(CAtlArray<BYTE> &journal)
+{
+	const BYTE *base = reinterpret_cast<const BYTE*>(BASE_BODY);
+	DWORD cbBase = sizeof(BASE_BODY) - 1;
+	DWORD cbAutosaved = sizeof(AUTOSAVED_BODY) - 1;
+	DWORD prefix = 0, suffix = 0;
+	while (prefix < min(cbBase, cbAutosaved) && BASE_BODY[prefix] == AUTOSAVED_BODY[prefix])
+		prefix++;
+	while (suffix < min(cbBase, cbAutosaved) - prefix && BASE_BODY[cbBase - suffix - 1] == AUTOSAVED_BODY[cbAutosaved - suffix - 1])
+		suffix++;
+
+	CAtlArray<BYTE> payload;
+	AppendDword(payload, prefix);
+	AppendDword(payload, cbBase - prefix - suffix);
+	AppendBytes(payload, AUTOSAVED_BODY + prefix, cbAutosaved - prefix - suffix);
+
+	AppendDword(journal, 0x4A574C4F);
+	AppendDword(journal, 1);
+	AppendDword(journal, cbBase);
+	AppendDword(journal, ContentsJournal::Crc32(base, cbBase));
+	AppendDword(journal, (DWORD)payload.GetCount());
+	AppendDword(journal, ContentsJournal::Crc32(payload.GetData(), payload.GetCount()));
+	AppendBytes(journal, payload.GetData(), payload.GetCount());
+}
+
+static HRESULT WriteStream(IStorage *storage, LPCWSTR name, const void *data, ULONG cb)
+{
+	HRESULT hr;
+	CComPtr<IStream> stream;
+	if (FAILED(hr = storage->CreateStream(name, STGM_CREATE | STGM_WRITE | STGM_SHARE_EXCLUSIVE, 0, 0, &stream)))
+		return hr;
+	return stream->Write(data, cb, NULL);
+}
+
+// Writes a post whose body has been autosaved once since it was saved in full.
+static HRESULT CreatePost(LPCWSTR path)
+{
+	HRESULT hr;
+	CComPtr<IStorage> storage;
+	if (FAILED(hr = StgCreateStorageEx(path, STGM_CREATE | STGM_READWRITE | STGM_SHARE_EXCLUSIVE, STGFMT_DOCFILE, 0, NULL, NULL, IID_IStorage, (void**)&storage)))
+		return hr;
+
+	static const WCHAR TITLE[] = L"\xFEFFPacked post";
+	static const WCHAR ID[] = L"\xFEFFpacked-post";
+	CAtlArray<BYTE> journal;
+	CreateJournal(journal);
+	if (FAILED(hr = WriteStream(storage, POST_TITLE, TITLE, sizeof(TITLE) - sizeof(WCHAR)))
+		|| FAILED(hr = WriteStream(storage, POST_ID, ID, sizeof(ID) - sizeof(WCHAR)))
+		|| FAILED(hr = WriteStream(storage, POST_CONTENTS, BASE_BODY, sizeof(BASE_BODY) - 1))
+		|| FAILED(hr = WriteStream(storage, POST_CONTENTS_JOURNAL, journal.GetData(), (ULONG)journal.GetCount())))
+		return hr;
+	return storage->Commit(STGC_DEFAULT);
+}
+
+// a title with a character outside the BMP, and what it is written as by
+// each byte order mark the decoder knows
+static const DWORD ENCODED_TITLE[] = { 'P', 'a', 'c', 'k', 0xE9, ' ', 0x1D11E };
+static const WCHAR DECODED_TITLE[] = L"Pack\x00E9 \xD834\xDD1E";
+static const struct
+{
+	LPCWSTR name;
+	int bytesPerUnit;			// 1, 2 or 4
+	bool bigEndian;
+	BYTE mark[4];
+} TITLE_ENCODINGS[] = {
+	{ L"TitleUtf8", 1, false, { 0xEF, 0xBB, 0xBF } },
+	{ L"TitleUtf16", 2, false, { 0xFF, 0xFE } },
+	{ L"TitleUtf16BE", 2, true, { 0xFE, 0xFF } },
+	{ L"TitleUtf32", 4, false, { 0xFF, 0xFE, 0x00, 0x00 } },
+	{ L"TitleUtf32BE", 4, true, { 0x00, 0x00, 0xFE, 0xFF } },
+};
+
+static void AppendUnit(CAtlArray<BYTE> &buffer, DWORD unit, int cb, bool bigEndian)
+{
+	for (int i = 0; i < cb; i++)
+		buffer.Add((BYTE)(unit >> ((bigEndian ? cb - 1 - i : i) * 8)));
+}
+
+// Writes ENCODED_TITLE with the byte order mark and in the encoding given.
+static void EncodeTitle(int bytesPerUnit, bool bigEndian, const BYTE *mark, CAtlArray<BYTE> &buffer)
+{
+	AppendBytes(buffer, mark, bytesPerUnit == 1 ? 3 : bytesPerUnit);
+	for (size_t i = 0; i < _countof(ENCODED_TITLE); i++)
+	{
+		DWORD c = ENCODED_TITLE[i];
+		if (bytesPerUnit == 4)
+			AppendUnit(buffer, c, 4, bigEndian);
+		else if (bytesPerUnit == 2 && c >= 0x10000)
+		{
+			AppendUnit(buffer, 0xD800 + ((c - 0x10000) >> 10), 2, bigEndian);
+			AppendUnit(buffer, 0xDC00 + ((c - 0x10000) & 0x3FF), 2, bigEndian);
+		}
+		else if (bytesPerUnit == 2)
+			AppendUnit(buffer, c, 2, bigEndian);
+		else if (c < 0x80)
+			buffer.Add((BYTE)c);
+		else if (c < 0x800)
+		{
+			buffer.Add((BYTE)(0xC0 | (c >> 6)));
+			buffer.Add((BYTE)(0x80 | (c & 0x3F)));
+		}
+		else if (c < 0x10000)
+		{
+			buffer.Add((BYTE)(0xE0 | (c >> 12)));
+			buffer.Add((BYTE)(0x80 | ((c >> 6) & 0x3F)));
+			buffer.Add((BYTE)(0x80 | (c & 0x3F)));
+		}
+		else
+		{
+			buffer.Add((BYTE)(0xF0 | (c >> 18)));
+			buffer.Add((BYTE)(0x80 | ((c >> 12) & 0x3F)));
+			buffer.Add((BYTE)(0x80 | ((c >> 6) & 0x3F)));
+			buffer.Add((BYTE)(0x80 | (c & 0x3F)));
+		}
+	}
+}
+
+// Writes a post that also has the title in every encoding the decoder knows.
+static HRESULT CreateEncodedPost(LPCWSTR path)
+{
+	HRESULT hr;
+	if (FAILED(hr = CreatePost(path)))
+		return hr;
+	CComPtr<IStorage> storage;
+	if (FAILED(hr = StgOpenStorageEx(path, STGM_READWRITE | STGM_SHARE_EXCLUSIVE, STGFMT_DOCFILE, 0, NULL, NULL, IID_IStorage, (void**)&storage)))
+		return hr;
+	for (size_t i = 0; i < _countof(TITLE_ENCODINGS); i++)
+	{
+		CAtlArray<BYTE> title;
+		EncodeTitle(TITLE_ENCODINGS[i].bytesPerUnit, TITLE_ENCODINGS[i].bigEndian, TITLE_ENCODINGS[i].mark, title);
+		if (FAILED(hr = WriteStream(storage, TITLE_ENCODINGS[i].name, title.GetData(), (ULONG)title.GetCount())))
+			return hr;
+	}
+	return storage->Commit(STGC_DEFAULT);
+}
+
+// Packs the post into a pack of its own, with the payload given.
+static HRESULT CreatePack(LPCWSTR postPath, LPCWSTR packPath, DWORD payload)
+{
+	HRESULT hr;
+	PostPackWriter writer;
+	if (FAILED(hr = writer.Open(packPath)))
+		return hr;
+	if (FAILED(hr = writer.AppendFile(postPath, payload)))
+	{
+		writer.Close();
+		return hr;
+	}
+	return writer.Close();
+}
+
+static HRESULT CreateTempFile(LPWSTR path)
+{
+	WCHAR directory[MAX_PATH];
+	if (!GetTempPathW(_countof(directory), directory) || !GetTempFileNameW(directory, L"olw", 0, path))
+		return HRESULT_FROM_WIN32(GetLastError());
+	return S_OK;
+}
+
+// Packs the post create writes, with the payload given, into a new pack at
+// packPath, and opens it. The caller deletes the pack once the reader is closed.
+static HRESULT OpenPackedPost(DWORD payload, LPWSTR packPath, PostPackReader &reader, HRESULT (*create)(LPCWSTR path) = CreatePost)
+{
+	HRESULT hr;
+	WCHAR postPath[MAX_PATH];
+	if (FAILED(hr = CreateTempFile(postPath)))
+		return hr;
+	if (FAILED(hr = CreateTempFile(packPath)))
+	{
+		DeleteFileW(postPath);
+		return hr;
+	}
+
+	if (SUCCEEDED(hr = create(postPath)) && SUCCEEDED(hr = CreatePack(postPath, packPath, payload)))
+		hr = reader.Open(packPath);
+	DeleteFileW(postPath);
+	return hr;
+}
+
+// Checks that the filter's body holds the autosaved words, not the first draft's.
+static bool IsAutosavedBody(const CStringW &body)
+{
+	return body.Find(L"autosaved draft") >= 0 && body.Find(L"first draft") < 0;
+}
+
+HRESULT PackCheck::CheckJournal(void)
+{
+	HRESULT hr;
+	ULONG failures = 0;
+	WCHAR packPath[MAX_PATH] = L"";
+
+	{
+		PostPackReader reader;
+		ExtractedPost post;
+		if (SUCCEEDED(hr = OpenPackedPost(POST_PACK_COMPOUND, packPath, reader)))
+		{
+			CComPtr<IStream> stream;
+			if (SUCCEEDED(hr = reader.OpenStream(0, &stream)))
+				hr = PostExtractor::Extract(stream, post);
+		}
+		reader.Close();
+		DeleteFileW(packPath);
+
+		if (FAILED(hr))
+		{
+			fwprintf(stdout, L"journal, compound payload: failed with HRESULT %#08x\n", hr);
+			failures++;
+		}
+		else
+		{
+			bool autosaved = IsAutosavedBody(post.body);
+			if (!autosaved)
+				failures++;
+			fwprintf(stdout, L"journal, compound payload: filter read the %s body\n", autosaved ? L"autosaved" : L"wrong");
+		}
+	}
+
+	{
+		PostPackReader reader;
+		CAtlArray<BYTE> contents;
+		if (SUCCEEDED(hr = OpenPackedPost(POST_PACK_STREAMS, packPath, reader)))
+		{
+			DWORD payload;
+			const BYTE *data;
+			ULONGLONG size;
+			if (SUCCEEDED(hr = reader.GetPayload(0, &payload, &data, &size)))
+			{
+				const PostPackStreamsHeader *streams = reinterpret_cast<const PostPackStreamsHeader*>(data);
+				hr = PostPackReader::ReadDecodedContents(data + sizeof(PostPackStreamsHeader), size - sizeof(PostPackStreamsHeader),
+					streams->elementCount, contents);
+			}
+		}
+		reader.Close();
+		DeleteFileW(packPath);
+
+		if (FAILED(hr))
+		{
+			fwprintf(stdout, L"journal, streams payload: failed with HRESULT %#08x\n", hr);
+			failures++;
+		}
+		else
+		{
+			bool autosaved = contents.GetCount() == sizeof(AUTOSAVED_BODY) - 1
+				&& memcmp(contents.GetData(), AUTOSAVED_BODY, contents.GetCount()) == 0;
+			if (!autosaved)
+				failures++;
+			fwprintf(stdout, L"journal, streams payload: %u bytes, %s body\n",
+				(ULONG)contents.GetCount(), autosaved ? L"autosaved" : L"wrong");
+		}
+	}
+
+	return failures ? FILTERTOOL_E_PACK_CHECK : S_OK;
+}
+
+HRESULT PackCheck::CheckStringEncodings(void)
+{
+	HRESULT hr;
+	ULONG failures = 0;
+	WCHAR packPath[MAX_PATH] = L"";
+	PostPackReader reader;
+	DWORD payload;
+	const BYTE *data;
+	ULONGLONG size;
+	if (SUCCEEDED(hr = OpenPackedPost(POST_PACK_STREAMS, packPath, reader, CreateEncodedPost))
+		&& SUCCEEDED(hr = reader.GetPayload(0, &payload, &data, &size)))
+	{
+		const PostPackStreamsHeader *streams = reinterpret_cast<const PostPackStreamsHeader*>(data);
+		for (size_t i = 0; i < _countof(TITLE_ENCODINGS); i++)
+		{
+			CStringW title;
+			HRESULT hrRead = PostPackReader::ReadDecodedString(data + sizeof(PostPackStreamsHeader), size - sizeof(PostPackStreamsHeader),
+				streams->elementCount, TITLE_ENCODINGS[i].name, title);
+			bool same = hrRead == S_OK && title == DECODED_TITLE;
+			if (!same)
+				failures++;
+			fwprintf(stdout, L"string encodings, %s: %s\n", TITLE_ENCODINGS[i].name, same ? L"read back" : L"read wrongly");
+		}
+	}
+	reader.Close();
+	DeleteFileW(packPath);
+
+	if (FAILED(hr))
+	{
+		fwprintf(stdout, L"string encodings: failed with HRESULT %#08x\n", hr);
+		return FILTERTOOL_E_PACK_CHECK;
+	}
+	return failures ? FILTERTOOL_E_PACK_CHECK : S_OK;
+}
+
+HRESULT PackCheck::CheckForeignStream(void)
+{
+	HRESULT hr;
+	WCHAR packPath[MAX_PATH] = L"";
+	ExtractedPost post;
+	{
+		PostPackReader reader;
+		if (SUCCEEDED(hr = OpenPackedPost(POST_PACK_COMPOUND, packPath, reader)))
+		{
+			CComPtr<IStream> view;
+			if (SUCCEEDED(hr = reader.OpenStream(0, &view)))
+			{
+				CComPtr<IStream> stream;
+				stream.Attach(new ForeignLockBytesStream(view));
+				hr = PostExtractor::Extract(stream, post);
+			}
+		}
+		reader.Close();
+		DeleteFileW(packPath);
+	}
+
+	if (FAILED(hr))
+	{
+		fwprintf(stdout, L"foreign stream: failed with HRESULT %#08x\n", hr);
+		return FILTERTOOL_E_PACK_CHECK;
+	}
+
+	bool autosaved = IsAutosavedBody(post.body);
+	fwprintf(stdout, L"foreign stream: filter read the %s body\n", autosaved ? L"autosaved" : L"wrong");
+	return autosaved ? S_OK : FILTERTOOL_E_PACK_CHECK;
+}
@@ -0,0 +1,27 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+/*
+Checks that a post reads the same out of a pack as out of its own file:
+
+	journal         a post whose body was autosaved to its ContentsJournal is
+	                packed both ways; the filter has to find the autosaved
+	                body in the COMPOUND payload, and ReadDecodedContents the
+	                same body in the STREAMS payload
+	encodings       a STREAMS post with its title written with every byte
+	                order mark the decoder knows, which ReadDecodedString has
+	                to read back the same
+	foreign stream  the COMPOUND post behind a stream that is ILockBytes too,
+	                but not a pack's, which the filter mustn't read through
+
+Each check prints what it found and returns a failure if it didn't pass.
+*/
+class PackCheck
+{
+public:
+	static HRESULT CheckJournal(void);
+	static HRESULT CheckStringEncodings(void);
+	static HRESULT CheckForeignStream(void);
+};
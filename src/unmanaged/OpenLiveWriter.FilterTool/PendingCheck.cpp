@@ -0,0 +1,417 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "stdafx.h"
+#include "PendingCheck.h"
+#include "..\OpenLiveWriter.Filter\OpenLiveWriter.Filter.h"
+#include "..\OpenLiveWriter.Filter\PostEditorFileConstants.h"
+#include "..\OpenLiveWriter.Filter\UnicodeTextStreamSubFilter.h"
+
+static const GUID SHAREPOINT_PROPSET = { 0xF29F85E0, 0x4FF9, 0x1068, { 0xAB, 0x91, 0x08, 0x00, 0x2B, 0x27, 0xB3, 0xD9 } };
+
+// a pending check that fails
+const HRESULT FILTERTOOL_E_PENDING_CHECK = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_ITF, 0x0701);
+
+// a host that is never told to retry gives up after this long
+const DWORD READY_TIMEOUT = 60000;
+
+/*
+A read-only stream that hands out its data a few bytes at a time, and
+returns E_PENDING, with or without some data, on two reads in three. With a
+handle, it supports ISynchronizeHandle with an event that is always set.
+*/
+class SlowStream : public IStream, public ISynchronizeHandle
+{
+public:
+	SlowStream(const BYTE *data, ULONG cb, bool withHandle) :
+		m_refCount(1), m_data(data), m_cb(cb), m_position(0), m_readCount(0), m_ready(NULL)
+	{
+		if (withHandle)
+			m_ready = CreateEvent(NULL, TRUE, TRUE, NULL);
+	}
+
+	// IUnknown
+	STDMETHODIMP QueryInterface(REFIID riid, void **ppvObject)
+	{
+		if (!ppvObject)
+			return E_POINTER;
+		*ppvObject = NULL;
+		if (riid == IID_IUnknown || riid == IID_IStream || riid == IID_ISequentialStream)
+			*ppvObject = static_cast<IStream*>(this);
+		else if (riid == IID_ISynchronizeHandle && m_ready)
+			*ppvObject = static_cast<ISynchronizeHandle*>(this);
+		else
+			return E_NOINTERFACE;
+		AddRef();
+		return S_OK;
+	}
+
+	STDMETHODIMP_(ULONG) AddRef(void)
+	{
+		return InterlockedIncrement(&m_refCount);
+	}
+
+	STDMETHODIMP_(ULONG) Release(void)
+	{
+		LONG refCount = InterlockedDecrement(&m_refCount);
+		if (refCount == 0)
+			delete this;
+		return refCount;
+	}
+
+	// ISequentialStream
+	STDMETHODIMP Read(void *pv, ULONG cb, ULONG *pcbRead)
+	{
+		// 0, 1, 3, 5 or 7 bytes, so that characters get split between reads
+		ULONG read = m_readCount++;
+		ULONG count = read % 3 == 0 ? 0 : min(min((read % 4) * 2 + 1, cb), m_cb - m_position);
+		memcpy(pv, m_data + m_position, count);
+		m_position += count;
+		if (pcbRead)
+			*pcbRead = count;
+		return read % 3 == 2 || m_position == m_cb ? S_OK : E_PENDING;
+	}
+
+	STDMETHODIMP Write(const void *pv, ULONG cb, ULONG *pcbWritten) { return STG_E_ACCESSDENIED; }
+
+	// IStream
+	STDMETHODIMP Seek(LARGE_INTEGER dlibMove, DWORD dwOrigin, ULARGE_INTEGER *plibNewPosition) { return E_NOTIMPL; }
+	STDMETHODIMP SetSize(ULARGE_INTEGER libNewSize) { return STG_E_ACCESSDENIED; }
+	STDMETHODIMP CopyTo(IStream *pstm, ULARGE_INTEGER cb, ULARGE_INTEGER *pcbRead, ULARGE_INTEGER *pcbWritten) { return E_NOTIMPL; }
+	STDMETHODIMP Commit(DWORD grfCommitFlags) { return S_OK; }
+	STDMETHODIMP Revert(void) { return S_OK; }
+	STDMETHODIMP LockRegion(ULARGE_INTEGER libOffset, ULARGE_INTEGER cb, DWORD dwLockType) { return STG_E_INVALIDFUNCTION; }
+	STDMETHODIMP UnlockRegion(ULARGE_INTEGER libOffset, ULARGE_INTEGER cb, DWORD dwLockType) { return STG_E_INVALIDFUNCTION; }
+	STDMETHODIMP Stat(STATSTG *pstatstg, DWORD grfStatFlag) { return E_NOTIMPL; }
+	STDMETHODIMP Clone(IStream **ppstm) { return E_NOTIMPL; }
+
+	// ISynchronizeHandle
+	STDMETHODIMP GetHandle(HANDLE *ph)
+	{
+		*ph = m_ready;
+		return S_OK;
+	}
+
+private:
+	~SlowStream(void)
+	{
+		if (m_ready)
+			CloseHandle(m_ready);
+	}
+
+	volatile LONG m_refCount;
+	const BYTE *m_data;
+	ULONG m_cb;
+	ULONG m_position;
+	ULONG m_readCount;
+	HANDLE m_ready;
+};
+
+/*
+The host's side of IWebPostFilterAsync: sets an event whenever the filter
+says a pending call is worth retrying, and lets the check see how many
+references the filter still holds.
+*/
+class ReadyCallback : public IWebPostFilterReadyCallback
+{
+public:
+	ReadyCallback(void) : m_refCount(1), m_ready(CreateEvent(NULL, FALSE, FALSE, NULL))
+	{
+	}
+
+	HANDLE GetReadyEvent(void) const { return m_ready; }
+	LONG GetReferenceCount(void) const { return m_refCount; }
+
+	STDMETHODIMP QueryInterface(REFIID riid, void **ppvObject)
+	{
+		if (!ppvObject)
+			return E_POINTER;
+		if (riid == IID_IUnknown || riid == IID_IWebPostFilterReadyCallback)
+		{
+			*ppvObject = static_cast<IWebPostFilterReadyCallback*>(this);
+			AddRef();
+			return S_OK;
+		}
+		*ppvObject = NULL;
+		return E_NOINTERFACE;
+	}
+
+	STDMETHODIMP_(ULONG) AddRef(void)
+	{
+		return InterlockedIncrement(&m_refCount);
+	}
+
+	STDMETHODIMP_(ULONG) Release(void)
+	{
+		LONG refCount = InterlockedDecrement(&m_refCount);
+		if (refCount == 0)
+			delete this;
+		return refCount;
+	}
+
+	STDMETHODIMP OnReady(void)
+	{
+		SetEvent(m_ready);
+		return S_OK;
+	}
+
+private:
+	~ReadyCallback(void)
+	{
+		CloseHandle(m_ready);
+	}
+
+	volatile LONG m_refCount;
+	HANDLE m_ready;
+};
+
+HRESULT PendingCheck::CheckSlowStream(bool withHandle)
+{
+	// some of it outside ASCII, so that a character split between reads shows
+	CStringW expected;
+	for (int i = 0; expected.GetLength() < 5000; i++)
+		expected.AppendFormat(L"word%d caf\x00E9 \x65E5\x672C ", i);
+
+	FULLPROPSPEC propSpec;
+	propSpec.guidPropSet = SHAREPOINT_PROPSET;
+	propSpec.psProperty.ulKind = PRSPEC_PROPID;
+	propSpec.psProperty.propid = 2;
+
+	SlowStream *stream = new SlowStream(reinterpret_cast<const BYTE*>(expected.GetString()), expected.GetLength() * sizeof(WCHAR), withHandle);
+	UnicodeTextStreamSubFilter filter(propSpec, stream);
+	stream->Release();
+
+	STAT_CHUNK stat;
+	HRESULT hr = filter.GetChunk(&stat);
+	if (FAILED(hr))
+		return hr;
+
+	CStringW text;
+	ULONG pendingCalls = 0, failures = 0;
+	WCHAR buffer[8];
+	for (ULONG call = 0; ; call++)
+	{
+		// buffers of 1 to 8 characters
+		ULONG requested = call % _countof(buffer) + 1;
+		ULONG cwc = requested;
+		hr = filter.GetText(&cwc, buffer);
+		if (hr == E_PENDING)
+		{
+			pendingCalls++;
+			if (cwc != requested)
+			{
+				fwprintf(stdout, L"slow stream: a pending call changed the buffer size\n");
+				failures++;
+			}
+			if ((filter.GetPendingHandle() != NULL) != withHandle)
+			{
+				fwprintf(stdout, L"slow stream: the pending handle is %s\n", withHandle ? L"missing" : L"unexpected");
+				failures++;
+			}
+			continue;
+		}
+		if (hr == FILTER_E_NO_MORE_TEXT)
+			break;
+		if (FAILED(hr))
+			return hr;
+		text.Append(buffer, cwc);
+	}
+
+	bool same = text == expected;
+	if (!same)
+		failures++;
+	fwprintf(stdout, L"slow stream %s: %d of %d characters, %u pending calls, %s\n",
+		withHandle ? L"with a handle" : L"without a handle", text.GetLength(), expected.GetLength(), pendingCalls,
+		same ? L"same" : L"different");
+	return failures || pendingCalls == 0 ? FILTERTOOL_E_PENDING_CHECK : S_OK;
+}
+
+// Writes a post with a title and a body of about cb bytes of HTML.
+static HRESULT CreatePost(LPCWSTR path, size_t cb)
+{
+	HRESULT hr;
+	CComPtr<IStorage> storage;
+	if (FAILED(hr = StgCreateStorageEx(path, STGM_CREATE | STGM_READWRITE | STGM_SHARE_EXCLUSIVE, STGFMT_DOCFILE, 0, NULL, NULL, IID_IStorage, (void**)&storage)))
+		return hr;
+
+	CComPtr<IStream> title;
+	if (FAILED(hr = storage->CreateStream(POST_TITLE, STGM_CREATE | STGM_WRITE | STGM_SHARE_EXCLUSIVE, 0, 0, &title)))
+		return hr;
+	static const WCHAR TITLE[] = L"\xFEFFPending post";
+	if (FAILED(hr = title->Write(TITLE, sizeof(TITLE) - sizeof(WCHAR), NULL)))
+		return hr;
+
+	CStringA html("\xEF\xBB\xBF<html><body>\n");
+	html.Preallocate((int)cb + 0x100);
+	for (ULONG i = 0; (size_t)html.GetLength() < cb; i++)
+		html.AppendFormat("<p>Paragraph %u of a post that takes a while to filter.</p>\n", i);
+	html += "</body></html>\n";
+
+	CComPtr<IStream> contents;
+	if (FAILED(hr = storage->CreateStream(POST_CONTENTS, STGM_CREATE | STGM_WRITE | STGM_SHARE_EXCLUSIVE, 0, 0, &contents)))
+		return hr;
+	if (FAILED(hr = contents->Write(html.GetString(), html.GetLength(), NULL)))
+		return hr;
+	return storage->Commit(STGC_DEFAULT);
+}
+
+static HRESULT OpenPost(LPCWSTR path, ReadyCallback *callback, IFilter **filter)
+{
+	HRESULT hr;
+	CComPtr<IFilter> postFilter;
+	if (FAILED(hr = postFilter.CoCreateInstance(CLSID_WebPostFilter)))
+		return hr;
+
+	if (callback)
+	{
+		CComQIPtr<IWebPostFilterAsync> async(postFilter);
+		if (!async)
+			return E_NOINTERFACE;
+		if (FAILED(hr = async->SetReadyCallback(callback)))
+			return hr;
+	}
+
+	CComQIPtr<IPersistFile> persistFile(postFilter);
+	if (!persistFile)
+		return E_NOINTERFACE;
+	if (FAILED(hr = persistFile->Load(path, STGM_READ)))
+		return hr;
+
+	ULONG flags;
+	if (FAILED(hr = postFilter->Init(IFILTER_INIT_INDEXING_ONLY, 0, NULL, &flags)))
+		return hr;
+	*filter = postFilter.Detach();
+	return S_OK;
+}
+
+// Waits for the filter to say that the pending call is worth making again.
+static HRESULT WaitForReady(ReadyCallback *callback, ULONG &pendingCalls)
+{
+	if (!callback)
+		return E_UNEXPECTED;
+	pendingCalls++;
+	if (WaitForSingleObject(callback->GetReadyEvent(), READY_TIMEOUT) != WAIT_OBJECT_0)
+		return HRESULT_FROM_WIN32(ERROR_TIMEOUT);
+	return S_OK;
+}
+
+// Collects the text of every chunk, waiting whenever a call is pending.
+static HRESULT ReadPost(IFilter *filter, ReadyCallback *callback, CStringW &text, ULONG &pendingCalls)
+{
+	HRESULT hr;
+	WCHAR buffer[0x1000];
+	while (true)
+	{
+		STAT_CHUNK stat;
+		hr = filter->GetChunk(&stat);
+		if (hr == E_PENDING)
+		{
+			if (FAILED(hr = WaitForReady(callback, pendingCalls)))
+				return hr;
+			continue;
+		}
+		if (hr == FILTER_E_END_OF_CHUNKS)
+			return S_OK;
+		if (FAILED(hr))
+			return hr;
+		if (!(stat.flags & CHUNK_TEXT))
+			continue;
+
+		text.AppendChar(L' ');
+		while (true)
+		{
+			ULONG cwc = _countof(buffer);
+			SCODE sc = filter->GetText(&cwc, buffer);
+			if (sc == E_PENDING)
+			{
+				if (FAILED(hr = WaitForReady(callback, pendingCalls)))
+					return hr;
+				continue;
+			}
+			if (FAILED(sc))
+				break;
+			text.Append(buffer, cwc);
+			if (sc == FILTER_S_LAST_TEXT)
+				break;
+		}
+	}
+}
+
+HRESULT PendingCheck::CheckAsyncHost(void)
+{
+	HRESULT hr;
+	WCHAR directory[MAX_PATH], path[MAX_PATH];
+	if (!GetTempPathW(_countof(directory), directory) || !GetTempFileNameW(directory, L"olw", 0, path))
+		return HRESULT_FROM_WIN32(GetLastError());
+
+	// over PARALLEL_BODY_THRESHOLD, so that the body is filtered on worker
+	// threads and its chunks are pending until they are done
+	if (FAILED(hr = CreatePost(path, 0x400000)))
+	{
+		DeleteFileW(path);
+		return hr;
+	}
+
+	ULONG failures = 0;
+	ReadyCallback *callback = new ReadyCallback();
+	{
+		CStringW blocked, async;
+		ULONG pendingCalls = 0, blockedPendingCalls = 0;
+		CComPtr<IFilter> blockedFilter, asyncFilter;
+		if (FAILED(hr = OpenPost(path, NULL, &blockedFilter))
+			|| FAILED(hr = ReadPost(blockedFilter, NULL, blocked, blockedPendingCalls))
+			|| FAILED(hr = OpenPost(path, callback, &asyncFilter))
+			|| FAILED(hr = ReadPost(asyncFilter, callback, async, pendingCalls)))
+		{
+			fwprintf(stdout, L"async host: failed with HRESULT %#08x\n", hr);
+			failures++;
+		}
+		else
+		{
+			bool same = blocked == async;
+			if (!same)
+				failures++;
+			fwprintf(stdout, L"async host: %d characters, %u pending calls, %s as a blocked host\n",
+				async.GetLength(), pendingCalls, same ? L"same" : L"different");
+		}
+	}
+
+	// release the filter while the body is still pending
+	{
+		CComPtr<IFilter> filter;
+		bool pending = false;
+		if (SUCCEEDED(hr = OpenPost(path, callback, &filter)))
+		{
+			STAT_CHUNK stat;
+			while ((hr = filter->GetChunk(&stat)) == S_OK)
+			{
+			}
+			pending = hr == E_PENDING;
+		}
+		if (pending || hr == FILTER_E_END_OF_CHUNKS)
+			hr = S_OK;
+		if (FAILED(hr))
+		{
+			fwprintf(stdout, L"async host release: failed with HRESULT %#08x\n", hr);
+			failures++;
+		}
+		else
+		{
+			filter.Release();
+
+			// the only reference left should be ours
+			DWORD started = GetTickCount();
+			while (callback->GetReferenceCount() > 1 && GetTickCount() - started < 1000)
+				Sleep(10);
+			bool released = callback->GetReferenceCount() == 1;
+			if (!released)
+				failures++;
+			fwprintf(stdout, L"async host release: %s, callback %s\n",
+				pending ? L"pending" : L"never pending", released ? L"released" : L"still held");
+		}
+	}
+
+	callback->Release();
+	DeleteFileW(path);
+	return failures ? FILTERTOOL_E_PENDING_CHECK : S_OK;
+}
@@ -0,0 +1,25 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+/*
+Checks how the filter copes with data that isn't there yet:
+
+	slow stream   UnicodeTextStreamSubFilter over a stream that hands out a
+	              few bytes at a time, often half a character, and returns
+	              E_PENDING in between, with and without ISynchronizeHandle
+	async host    the WebPostFilter over a post with a body large enough to
+	              be filtered in parallel, driven by a host with a ready
+	              callback, which has to get the same text as a blocked host,
+	              and whose callback has to be let go as soon as it releases
+	              the filter, even with a callback still outstanding
+
+Each check prints what it found and returns a failure if it didn't pass.
+*/
+class PendingCheck
+{
+public:
+	static HRESULT CheckSlowStream(bool withHandle);
+	static HRESULT CheckAsyncHost(void);
+};
@@ -0,0 +1,389 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "stdafx.h"
+#include "PostCompactor.h"
+#include "CountingLockBytes.h"
+#include "..\OpenLiveWriter.Filter\PostEditorFileConstants.h"
+
+// streams smaller than this are stored in the mini-stream
+const ULONGLONG MINI_STREAM_CUTOFF = 4096;
+
+// the compacted copy doesn't match the original
+const HRESULT COMPACT_E_MISMATCH = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_ITF, 0x0201);
+
+// read first by the filter and the post lists, so they are kept side by side
+static LPCWSTR HOT_STREAMS[] = { POST_TITLE, POST_KEYWORDS, POST_ID };
+
+// the large streams to lay out first, right after the mini-stream
+static LPCWSTR BODY_STREAMS[] = { POST_CONTENTS, POST_CONTENTS_JOURNAL };
+
+HRESULT PostCompactor::Compact(LPCWSTR path, bool replace, CompactionResult &result)
+{
+	HRESULT hr;
+
+	WIN32_FILE_ATTRIBUTE_DATA before;
+	if (!GetFileAttributesExW(path, GetFileExInfoStandard, &before))
+		return HRESULT_FROM_WIN32(GetLastError());
+	result.sizeBefore = ((ULONGLONG)before.nFileSizeHigh << 32) | before.nFileSizeLow;
+
+	if (FAILED(hr = MeasureReads(path, result.readsBefore)))
+		return hr;
+
+	// the copy goes next to the original so that it can be swapped in without a copy
+	CStringW directory(path);
+	PathRemoveFileSpecW(directory.GetBuffer());
+	directory.ReleaseBuffer();
+	if (directory.IsEmpty())
+		directory = L".";
+	WCHAR tempPath[MAX_PATH];
+	if (!GetTempFileNameW(directory, L"olw", 0, tempPath))
+		return HRESULT_FROM_WIN32(GetLastError());
+
+	{
+		CComPtr<IStorage> source;
+		hr = StgOpenStorageEx(path, STGM_READ | STGM_SHARE_DENY_WRITE, STGFMT_DOCFILE, 0, NULL, NULL, IID_IStorage, (void**)&source);
+		if (SUCCEEDED(hr))
+			hr = CompactToFile(source, tempPath);
+	}
+
+	WIN32_FILE_ATTRIBUTE_DATA after;
+	if (SUCCEEDED(hr) && !GetFileAttributesExW(tempPath, GetFileExInfoStandard, &after))
+		hr = HRESULT_FROM_WIN32(GetLastError());
+	if (SUCCEEDED(hr))
+	{
+		result.sizeAfter = ((ULONGLONG)after.nFileSizeHigh << 32) | after.nFileSizeLow;
+		hr = MeasureReads(tempPath, result.readsAfter);
+	}
+
+	if (SUCCEEDED(hr) && replace)
+	{
+		if (!ReplaceFileW(path, tempPath, NULL, REPLACEFILE_IGNORE_MERGE_ERRORS, NULL, NULL))
+		{
+			hr = HRESULT_FROM_WIN32(GetLastError());
+		}
+		else
+		{
+			result.replaced = true;
+
+			HANDLE hFile = CreateFileW(path, FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+			if (hFile == INVALID_HANDLE_VALUE)
+				return HRESULT_FROM_WIN32(GetLastError());
+			if (!SetFileTime(hFile, &before.ftCreationTime, NULL, &before.ftLastWriteTime))
+				hr = HRESULT_FROM_WIN32(GetLastError());
+			CloseHandle(hFile);
+			return hr;
+		}
+	}
+
+	DeleteFileW(tempPath);
+	return hr;
+}
+
+HRESULT PostCompactor::CompactToFile(IStorage *source, LPCWSTR tempPath)
+{
+	HRESULT hr;
+
+	// direct mode, so sectors are allocated in exactly the order we write them
+	CComPtr<IStorage> destination;
+	if (FAILED(hr = StgCreateStorageEx(tempPath, STGM_CREATE | STGM_READWRITE | STGM_SHARE_EXCLUSIVE | STGM_DIRECT,
+		STGFMT_DOCFILE, 0, NULL, NULL, IID_IStorage, (void**)&destination)))
+		return hr;
+
+	if (FAILED(hr = CopyStreams(source, destination, true, true)))
+		return hr;
+	if (FAILED(hr = CopyStreams(source, destination, false, true)))
+		return hr;
+	if (FAILED(hr = CopyMetadata(source, destination)))
+		return hr;
+	if (FAILED(hr = destination->Commit(STGC_DEFAULT)))
+		return hr;
+	destination.Release();
+
+	// check what actually made it to disk, not what we think we wrote
+	CComPtr<IStorage> compacted;
+	if (FAILED(hr = StgOpenStorageEx(tempPath, STGM_READ | STGM_SHARE_DENY_WRITE, STGFMT_DOCFILE, 0, NULL, NULL, IID_IStorage, (void**)&compacted)))
+		return hr;
+	return Verify(source, compacted);
+}
+
+HRESULT PostCompactor::MeasureReads(LPCWSTR path, ReadStatistics &statistics)
+{
+	HRESULT hr;
+
+	CountingLockBytes *pLockBytes;
+	if (FAILED(hr = CountingLockBytes::Open(path, &pLockBytes)))
+		return hr;
+	CComPtr<CountingLockBytes> lockBytes;
+	lockBytes.Attach(pLockBytes);
+
+	{
+		CComPtr<IStorage> storage;
+		if (FAILED(hr = StgOpenStorageOnILockBytes(lockBytes, NULL, STGM_READ | STGM_SHARE_DENY_WRITE, NULL, 0, &storage)))
+			return hr;
+		if (FAILED(hr = ReadStreams(storage)))
+			return hr;
+	}
+
+	statistics.reads = lockBytes->GetReadCount();
+	statistics.seeks = lockBytes->GetSeekCount();
+	statistics.bytesRead = lockBytes->GetBytesRead();
+	return S_OK;
+}
+
+HRESULT PostCompactor::GetElements(IStorage *storage, CAtlArray<Element> &elements)
+{
+	HRESULT hr;
+
+	CComPtr<IEnumSTATSTG> enumerator;
+	if (FAILED(hr = storage->EnumElements(0, NULL, 0, &enumerator)))
+		return hr;
+
+	STATSTG stat;
+	while ((hr = enumerator->Next(1, &stat, NULL)) == S_OK)
+	{
+		Element element;
+		element.name = stat.pwcsName;
+		element.stat = stat;
+		element.stat.pwcsName = NULL;
+		CoTaskMemFree(stat.pwcsName);
+		elements.Add(element);
+	}
+	return FAILED(hr) ? hr : S_OK;
+}
+
+int PostCompactor::Priority(const Element &element, bool smallStreams, bool root)
+{
+	if (element.stat.type == STGTY_STORAGE)
+		return 100;
+
+	if (root)
+	{
+		LPCWSTR *names = smallStreams ? HOT_STREAMS : BODY_STREAMS;
+		size_t count = smallStreams ? _countof(HOT_STREAMS) : _countof(BODY_STREAMS);
+		for (size_t i = 0; i < count; i++)
+		{
+			if (element.name == names[i])
+				return (int)i;
+		}
+	}
+	return 50;
+}
+
+HRESULT PostCompactor::CopyStreams(IStorage *source, IStorage *destination, bool smallStreams, bool root)
+{
+	HRESULT hr;
+
+	CAtlArray<Element> elements;
+	if (FAILED(hr = GetElements(source, elements)))
+		return hr;
+
+	// stable insertion sort on priority; there are only ever a few dozen elements
+	CAtlArray<size_t> order;
+	for (size_t i = 0; i < elements.GetCount(); i++)
+	{
+		int priority = Priority(elements[i], smallStreams, root);
+		size_t j = order.GetCount();
+		while (j > 0 && Priority(elements[order[j - 1]], smallStreams, root) > priority)
+			j--;
+		order.InsertAt(j, i);
+	}
+
+	for (size_t i = 0; i < order.GetCount(); i++)
+	{
+		const Element &element = elements[order[i]];
+		if (element.stat.type == STGTY_STREAM)
+		{
+			if ((element.stat.cbSize.QuadPart < MINI_STREAM_CUTOFF) != smallStreams)
+				continue;
+			if (FAILED(hr = CopyStream(source, destination, element.name)))
+				return hr;
+		}
+		else if (element.stat.type == STGTY_STORAGE)
+		{
+			CComPtr<IStorage> sourceChild;
+			if (FAILED(hr = source->OpenStorage(element.name, NULL, STGM_READ | STGM_SHARE_EXCLUSIVE, NULL, 0, &sourceChild)))
+				return hr;
+
+			// the first pass creates the storage, the second fills in its large streams
+			CComPtr<IStorage> destinationChild;
+			if (smallStreams)
+				hr = destination->CreateStorage(element.name, STGM_CREATE | STGM_READWRITE | STGM_SHARE_EXCLUSIVE | STGM_DIRECT, 0, 0, &destinationChild);
+			else
+				hr = destination->OpenStorage(element.name, NULL, STGM_READWRITE | STGM_SHARE_EXCLUSIVE | STGM_DIRECT, NULL, 0, &destinationChild);
+			if (FAILED(hr))
+				return hr;
+
+			if (FAILED(hr = CopyStreams(sourceChild, destinationChild, smallStreams, false)))
+				return hr;
+		}
+	}
+	return S_OK;
+}
+
+HRESULT PostCompactor::CopyStream(IStorage *source, IStorage *destination, LPCWSTR name)
+{
+	HRESULT hr;
+
+	CAtlArray<BYTE> buffer;
+	if (FAILED(hr = ReadStream(source, name, buffer)))
+		return hr;
+
+	CComPtr<IStream> stream;
+	if (FAILED(hr = destination->CreateStream(name, STGM_CREATE | STGM_WRITE | STGM_SHARE_EXCLUSIVE, 0, 0, &stream)))
+		return hr;
+
+	// sizing the stream first gets its whole sector chain allocated in one go
+	ULARGE_INTEGER size;
+	size.QuadPart = buffer.GetCount();
+	if (FAILED(hr = stream->SetSize(size)))
+		return hr;
+
+	ULONG written = 0;
+	if (buffer.GetCount() > 0 && FAILED(hr = stream->Write(buffer.GetData(), (ULONG)buffer.GetCount(), &written)))
+		return hr;
+	return written == buffer.GetCount() ? S_OK : STG_E_MEDIUMFULL;
+}
+
+HRESULT PostCompactor::CopyMetadata(IStorage *source, IStorage *destination)
+{
+	HRESULT hr;
+
+	STATSTG stat;
+	if (FAILED(hr = source->Stat(&stat, STATFLAG_NONAME)))
+		return hr;
+	if (FAILED(hr = destination->SetClass(stat.clsid)))
+		return hr;
+	if (FAILED(hr = destination->SetStateBits(stat.grfStateBits, 0xFFFFFFFF)))
+		return hr;
+
+	CAtlArray<Element> elements;
+	if (FAILED(hr = GetElements(source, elements)))
+		return hr;
+
+	for (size_t i = 0; i < elements.GetCount(); i++)
+	{
+		const Element &element = elements[i];
+
+		// times are best effort; not every element keeps them
+		destination->SetElementTimes(element.name, &element.stat.ctime, &element.stat.atime, &element.stat.mtime);
+
+		if (element.stat.type == STGTY_STORAGE)
+		{
+			CComPtr<IStorage> sourceChild, destinationChild;
+			if (FAILED(hr = source->OpenStorage(element.name, NULL, STGM_READ | STGM_SHARE_EXCLUSIVE, NULL, 0, &sourceChild)))
+				return hr;
+			if (FAILED(hr = destination->OpenStorage(element.name, NULL, STGM_READWRITE | STGM_SHARE_EXCLUSIVE | STGM_DIRECT, NULL, 0, &destinationChild)))
+				return hr;
+			if (FAILED(hr = CopyMetadata(sourceChild, destinationChild)))
+				return hr;
+		}
+	}
+	return S_OK;
+}
+
+HRESULT PostCompactor::Verify(IStorage *original, IStorage *compacted)
+{
+	HRESULT hr;
+
+	STATSTG originalStat, compactedStat;
+	if (FAILED(hr = original->Stat(&originalStat, STATFLAG_NONAME)))
+		return hr;
+	if (FAILED(hr = compacted->Stat(&compactedStat, STATFLAG_NONAME)))
+		return hr;
+	if (originalStat.clsid != compactedStat.clsid)
+		return COMPACT_E_MISMATCH;
+
+	CAtlArray<Element> originalElements, compactedElements;
+	if (FAILED(hr = GetElements(original, originalElements)))
+		return hr;
+	if (FAILED(hr = GetElements(compacted, compactedElements)))
+		return hr;
+	if (originalElements.GetCount() != compactedElements.GetCount())
+		return COMPACT_E_MISMATCH;
+
+	for (size_t i = 0; i < originalElements.GetCount(); i++)
+	{
+		const Element &element = originalElements[i];
+		if (element.stat.type == STGTY_STREAM)
+		{
+			CAtlArray<BYTE> originalBytes, compactedBytes;
+			if (FAILED(hr = ReadStream(original, element.name, originalBytes)))
+				return hr;
+			if (FAILED(hr = ReadStream(compacted, element.name, compactedBytes)))
+				return hr == STG_E_FILENOTFOUND ? COMPACT_E_MISMATCH : hr;
+			if (originalBytes.GetCount() != compactedBytes.GetCount()
+				|| memcmp(originalBytes.GetData(), compactedBytes.GetData(), originalBytes.GetCount()) != 0)
+				return COMPACT_E_MISMATCH;
+		}
+		else if (element.stat.type == STGTY_STORAGE)
+		{
+			CComPtr<IStorage> originalChild, compactedChild;
+			if (FAILED(hr = original->OpenStorage(element.name, NULL, STGM_READ | STGM_SHARE_EXCLUSIVE, NULL, 0, &originalChild)))
+				return hr;
+			if (FAILED(hr = compacted->OpenStorage(element.name, NULL, STGM_READ | STGM_SHARE_EXCLUSIVE, NULL, 0, &compactedChild)))
+				return hr == STG_E_FILENOTFOUND ? COMPACT_E_MISMATCH : hr;
+			if (FAILED(hr = Verify(originalChild, compactedChild)))
+				return hr;
+		}
+	}
+	return S_OK;
+}
+
+HRESULT PostCompactor::ReadStreams(IStorage *storage)
+{
+	HRESULT hr;
+
+	CAtlArray<Element> elements;
+	if (FAILED(hr = GetElements(storage, elements)))
+		return hr;
+
+	for (size_t i = 0; i < elements.GetCount(); i++)
+	{
+		const Element &element = elements[i];
+		if (element.stat.type == STGTY_STREAM)
+		{
+			CAtlArray<BYTE> buffer;
+			if (FAILED(hr = ReadStream(storage, element.name, buffer)))
+				return hr;
+		}
+		else if (element.stat.type == STGTY_STORAGE)
+		{
+			CComPtr<IStorage> child;
+			if (FAILED(hr = storage->OpenStorage(element.name, NULL, STGM_READ | STGM_SHARE_EXCLUSIVE, NULL, 0, &child)))
+				return hr;
+			if (FAILED(hr = ReadStreams(child)))
+				return hr;
+		}
+	}
+	return S_OK;
+}
+
+HRESULT PostCompactor::ReadStream(IStorage *storage, LPCWSTR name, CAtlArray<BYTE> &buffer)
+{
+	HRESULT hr;
+
+	CComPtr<IStream> stream;
+	if (FAILED(hr = storage->OpenStream(name, NULL, STGM_READ | STGM_SHARE_EXCLUSIVE, 0, &stream)))
+		return hr;
+
+	STATSTG stat;
+	if (FAILED(hr = stream->Stat(&stat, STATFLAG_NONAME)))
+		return hr;
+	if (stat.cbSize.HighPart)
+		return E_OUTOFMEMORY;
+	if (!buffer.SetCount(stat.cbSize.LowPart))
+		return E_OUTOFMEMORY;
+
+	ULONG totalRead = 0;
+	while (totalRead < buffer.GetCount())
+	{
+		ULONG bytesRead = 0;
+		if (FAILED(hr = stream->Read(buffer.GetData() + totalRead, (ULONG)buffer.GetCount() - totalRead, &bytesRead)))
+			return hr;
+		if (bytesRead == 0)
+			return STG_E_READFAULT;
+		totalRead += bytesRead;
+	}
+	return S_OK;
+}
@@ -0,0 +1,71 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+/*
+The I/O it takes to read every stream of a post, as seen through a
+CountingLockBytes.
+*/
+struct ReadStatistics
+{
+	ULONG reads;
+	ULONG seeks;
+	ULONGLONG bytesRead;
+
+	ReadStatistics() : reads(0), seeks(0), bytesRead(0)
+	{
+	}
+};
+
+struct CompactionResult
+{
+	ULONGLONG sizeBefore;
+	ULONGLONG sizeAfter;
+	ReadStatistics readsBefore;
+	ReadStatistics readsAfter;
+	bool replaced;
+
+	CompactionResult() : sizeBefore(0), sizeAfter(0), replaced(false)
+	{
+	}
+};
+
+/*
+Rewrites a .wpost compound file into a fresh one so that it has no free
+sectors and its streams sit in contiguous sector runs.
+
+Streams are copied in two passes over the whole storage tree. The first
+writes every stream small enough to live in the mini-stream, starting with
+the streams the filter and the post list read first (Title, Keywords, Id),
+so they end up next to each other. The second writes the remaining streams,
+Contents first, each sized up front and written with a single call so that
+its sectors are allocated as one run.
+
+The copy is compared stream by stream against the original before it
+replaces it. The original's timestamps are kept, since the post lists sort
+on them.
+*/
+class PostCompactor
+{
+public:
+	static HRESULT Compact(LPCWSTR path, bool replace, CompactionResult &result);
+	static HRESULT MeasureReads(LPCWSTR path, ReadStatistics &statistics);
+
+private:
+	struct Element
+	{
+		CStringW name;
+		STATSTG stat;
+	};
+
+	static HRESULT CompactToFile(IStorage *source, LPCWSTR tempPath);
+	static HRESULT GetElements(IStorage *storage, CAtlArray<Element> &elements);
+	static HRESULT CopyStreams(IStorage *source, IStorage *destination, bool smallStreams, bool root);
+	static HRESULT CopyStream(IStorage *source, IStorage *destination, LPCWSTR name);
+	static HRESULT CopyMetadata(IStorage *source, IStorage *destination);
+	static HRESULT Verify(IStorage *original, IStorage *compacted);
+	static HRESULT ReadStreams(IStorage *storage);
+	static HRESULT ReadStream(IStorage *storage, LPCWSTR name, CAtlArray<BYTE> &buffer);
+	static int Priority(const Element &element, bool smallStreams, bool root);
+};
@@ -0,0 +1,163 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "stdafx.h"
+#include "PostExtractor.h"
+#include "..\OpenLiveWriter.Filter\OpenLiveWriter.Filter.h"
+#include "..\OpenLiveWriter.Filter\PostEditorFileConstants.h"
+
+static const GUID SYSTEM_PROPSET = { 0xB725F130, 0x47EF, 0x101A, { 0xA5, 0xF1, 0x02, 0x60, 0x8C, 0x9E, 0xEB, 0xAC } };
+static const GUID SHAREPOINT_PROPSET = { 0xF29F85E0, 0x4FF9, 0x1068, { 0xAB, 0x91, 0x08, 0x00, 0x2B, 0x27, 0xB3, 0xD9 } };
+static const GUID WDS_PROPSET = { 0xD5CDD505, 0x2E9C, 0x101B, { 0x93, 0x97, 0x08, 0x00, 0x2B, 0x2C, 0xF9, 0xAE } };
+
+const ULONG TEXT_BUFFER_SIZE = 0x1000;
+
+inline bool IsProperty(const FULLPROPSPEC &propSpec, const GUID &guidPropSet, ULONG propid)
+{
+	return propSpec.guidPropSet == guidPropSet
+		&& propSpec.psProperty.ulKind == PRSPEC_PROPID
+		&& propSpec.psProperty.propid == propid;
+}
+
+inline bool IsProperty(const FULLPROPSPEC &propSpec, const GUID &guidPropSet, LPCWSTR name)
+{
+	return propSpec.guidPropSet == guidPropSet
+		&& propSpec.psProperty.ulKind == PRSPEC_LPWSTR
+		&& _wcsicmp(propSpec.psProperty.lpwstr, name) == 0;
+}
+
+HRESULT PostExtractor::Extract(LPCWSTR path, ExtractedPost &post)
+{
+	HRESULT hr;
+
+	CComPtr<IFilter> filter;
+	if (FAILED(hr = filter.CoCreateInstance(CLSID_WebPostFilter)))
+		return hr;
+
+	CComQIPtr<IPersistFile> persistFile(filter);
+	if (!persistFile)
+		return E_NOINTERFACE;
+	if (FAILED(hr = persistFile->Load(path, STGM_READ)))
+		return hr;
+
+	post.path = path;
+	return ExtractFromFilter(filter, post);
+}
+
+HRESULT PostExtractor::Extract(IStream *stream, ExtractedPost &post)
+{
+	HRESULT hr;
+
+	CComPtr<IFilter> filter;
+	if (FAILED(hr = filter.CoCreateInstance(CLSID_WebPostFilter)))
+		return hr;
+
+	CComQIPtr<IPersistStream> persistStream(filter);
+	if (!persistStream)
+		return E_NOINTERFACE;
+	if (FAILED(hr = persistStream->Load(stream)))
+		return hr;
+
+	return ExtractFromFilter(filter, post);
+}
+
+HRESULT PostExtractor::ExtractFromFilter(IFilter *filter, ExtractedPost &post)
+{
+	HRESULT hr;
+
+	ULONG flags;
+	if (FAILED(hr = filter->Init(IFILTER_INIT_INDEXING_ONLY, 0, NULL, &flags)))
+		return hr;
+
+	WCHAR textBuffer[TEXT_BUFFER_SIZE];
+	while (true)
+	{
+		STAT_CHUNK stat;
+		hr = filter->GetChunk(&stat);
+		if (hr == FILTER_E_END_OF_CHUNKS)
+			return S_OK;
+		if (FAILED(hr))
+			return hr;
+
+		if (stat.flags & CHUNK_TEXT)
+		{
+			CStringW *target = NULL;
+			if (IsProperty(stat.attribute, SHAREPOINT_PROPSET, 2))
+				target = &post.title;
+			else if (IsProperty(stat.attribute, SHAREPOINT_PROPSET, 5))
+				target = &post.keywords;
+			else if (IsProperty(stat.attribute, SYSTEM_PROPSET, 19))
+				target = &post.body;
+
+			// keep adjacent body chunks from running together
+			if (target == &post.body && stat.breakType != CHUNK_NO_BREAK && !post.body.IsEmpty())
+				post.body.AppendChar(L' ');
+
+			while (true)
+			{
+				ULONG cwc = TEXT_BUFFER_SIZE;
+				SCODE sc = filter->GetText(&cwc, textBuffer);
+				if (FAILED(sc))
+					break;
+				if (target)
+					target->Append(textBuffer, cwc);
+				if (sc == FILTER_S_LAST_TEXT)
+					break;
+			}
+		}
+		else if (stat.flags & CHUNK_VALUE)
+		{
+			PROPVARIANT *value = NULL;
+			if (SUCCEEDED(filter->GetValue(&value)) && value)
+			{
+				if (IsProperty(stat.attribute, WDS_PROPSET, L"PrimaryDate") && value->vt == VT_FILETIME)
+					post.primaryDate = value->filetime;
+				PropVariantClear(value);
+				CoTaskMemFree(value);
+			}
+		}
+	}
+}
+
+HRESULT PostExtractor::ReadIdentity(LPCWSTR path, CStringW &id, CStringW &blogId)
+{
+	HRESULT hr;
+
+	CComPtr<IStorage> storage;
+	if (FAILED(hr = StgOpenStorageEx(path, STGM_READ | STGM_SHARE_DENY_WRITE, STGFMT_DOCFILE, 0, NULL, NULL, IID_IStorage, (void**)&storage)))
+		return hr;
+	if (FAILED(hr = ReadString(storage, POST_ID, id)))
+		return hr;
+	return ReadString(storage, POST_DESTINATION_BLOG_ID, blogId);
+}
+
+// Reads a string stream the way Writer wrote it: UTF-16 with a byte order mark.
+HRESULT PostExtractor::ReadString(IStorage *storage, LPCWSTR name, CStringW &value)
+{
+	HRESULT hr;
+
+	value.Empty();
+	CComPtr<IStream> stream;
+	hr = storage->OpenStream(name, NULL, STGM_READ | STGM_SHARE_EXCLUSIVE, 0, &stream);
+	if (hr == STG_E_FILENOTFOUND)
+		return S_OK;
+	if (FAILED(hr))
+		return hr;
+
+	STATSTG stat;
+	if (FAILED(hr = stream->Stat(&stat, STATFLAG_NONAME)))
+		return hr;
+	if (stat.cbSize.HighPart)
+		return E_OUTOFMEMORY;
+
+	int cwc = stat.cbSize.LowPart / sizeof(WCHAR);
+	ULONG bytesRead = 0;
+	hr = stream->Read(value.GetBuffer(cwc), cwc * sizeof(WCHAR), &bytesRead);
+	value.ReleaseBuffer(SUCCEEDED(hr) ? bytesRead / sizeof(WCHAR) : 0);
+	if (FAILED(hr))
+		return hr;
+
+	if (!value.IsEmpty() && value[0] == 0xFEFF)
+		value.Delete(0);
+	return S_OK;
+}
@@ -0,0 +1,42 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+/*
+The text and values the WebPostFilter produces for a single post.
+*/
+struct ExtractedPost
+{
+	CString path;
+	CStringW title;
+	CStringW keywords;
+	CStringW body;
+	FILETIME primaryDate;
+	ULONGLONG fingerprint;
+
+	ExtractedPost() : fingerprint(0)
+	{
+		ZeroMemory(&primaryDate, sizeof(FILETIME));
+	}
+};
+
+/*
+Drives the WebPostFilter over a post exactly the way an indexing host
+would (IPersistFile/IPersistStream::Load, Init, then GetChunk/GetText/GetValue
+until the chunks run out) and collects the results.
+*/
+class PostExtractor
+{
+public:
+	static HRESULT Extract(LPCWSTR path, ExtractedPost &post);
+	static HRESULT Extract(IStream *stream, ExtractedPost &post);
+	static HRESULT ExtractFromFilter(IFilter *filter, ExtractedPost &post);
+
+	// Reads the post's id and the id of the blog it is posted to, which the
+	// filter doesn't emit. Either is empty if the post doesn't have one yet.
+	static HRESULT ReadIdentity(LPCWSTR path, CStringW &id, CStringW &blogId);
+
+private:
+	static HRESULT ReadString(IStorage *storage, LPCWSTR name, CStringW &value);
+};
@@ -0,0 +1,253 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "stdafx.h"
+#include <process.h>
+#include "PostFileLoader.h"
+
+PostFileLoader::PendingFile::PendingFile(const CString &aPath) :
+	path(aPath), hFile(INVALID_HANDLE_VALUE), buffer(NULL), size(0), offset(0), hr(S_OK)
+{
+	ZeroMemory(&overlapped, sizeof(overlapped));
+}
+
+PostFileLoader::PendingFile::~PendingFile(void)
+{
+	if (hFile != INVALID_HANDLE_VALUE)
+		CloseHandle(hFile);
+	if (buffer)
+		VirtualFree(buffer, 0, MEM_RELEASE);
+}
+
+PostFileLoader::PostFileLoader(const PostFileLoaderOptions &options) :
+	m_options(options), m_files(NULL), m_consumer(NULL), m_queue(options.queueDepth),
+	m_next(0), m_fileCount(0), m_failureCount(0), m_bytesRead(0)
+{
+	m_options.queueDepth = max(m_options.queueDepth, (size_t)1);
+	m_options.workerCount = max(m_options.workerCount, (size_t)1);
+
+	// threads are waited for all at once
+	m_options.workerCount = min(m_options.workerCount, (size_t)MAXIMUM_WAIT_OBJECTS);
+	if (m_options.backend == POST_FILE_LOADER_THREADS)
+		m_options.queueDepth = min(m_options.queueDepth, (size_t)MAXIMUM_WAIT_OBJECTS);
+}
+
+HRESULT PostFileLoader::Run(const CAtlArray<CString> &files, PostFileConsumer *consumer)
+{
+	m_files = &files;
+	m_consumer = consumer;
+
+	if (m_options.backend == POST_FILE_LOADER_SYNC)
+	{
+		for (size_t i = 0; i < files.GetCount(); i++)
+		{
+			PendingFile *file = new PendingFile(files[i]);
+			ReadSynchronously(file);
+			Consume(file);
+		}
+		return S_OK;
+	}
+
+	CAtlArray<HANDLE> workers;
+	for (size_t i = 0; i < m_options.workerCount; i++)
+	{
+		HANDLE worker = (HANDLE)_beginthreadex(NULL, 0, WorkerProc, this, 0, NULL);
+		if (worker)
+			workers.Add(worker);
+	}
+	if (workers.IsEmpty())
+		return E_OUTOFMEMORY;
+
+	HRESULT hr = S_OK;
+	if (m_options.backend == POST_FILE_LOADER_OVERLAPPED)
+		hr = ReadOverlapped();
+	else
+		ReadOnThreads();
+
+	m_queue.Close();
+	WaitForMultipleObjects((DWORD)workers.GetCount(), workers.GetData(), TRUE, INFINITE);
+	for (size_t i = 0; i < workers.GetCount(); i++)
+		CloseHandle(workers[i]);
+	return hr;
+}
+
+HRESULT PostFileLoader::Open(PendingFile *file, DWORD flags) const
+{
+	flags |= m_options.uncached ? FILE_FLAG_NO_BUFFERING : FILE_FLAG_SEQUENTIAL_SCAN;
+	file->hFile = CreateFile(file->path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, flags, NULL);
+	if (file->hFile == INVALID_HANDLE_VALUE)
+		return HRESULT_FROM_WIN32(GetLastError());
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file->hFile, &size))
+		return HRESULT_FROM_WIN32(GetLastError());
+	if ((ULONGLONG)size.QuadPart > MAX_FILE_SIZE)
+		return HRESULT_FROM_WIN32(ERROR_FILE_TOO_LARGE);
+	file->size = size.QuadPart;
+
+	// page aligned, and rounded up to whole sectors, for uncached reads
+	SIZE_T cb = (SIZE_T)((max(file->size, 1ULL) + SECTOR_SIZE - 1) & ~(ULONGLONG)(SECTOR_SIZE - 1));
+	file->buffer = static_cast<BYTE*>(VirtualAlloc(NULL, cb, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+	if (!file->buffer)
+		return E_OUTOFMEMORY;
+	return S_OK;
+}
+
+HRESULT PostFileLoader::ReadNext(PendingFile *file) const
+{
+	ULONGLONG remaining = (file->size - file->offset + SECTOR_SIZE - 1) & ~(ULONGLONG)(SECTOR_SIZE - 1);
+	DWORD cb = (DWORD)min(remaining, (ULONGLONG)READ_SIZE);
+	file->overlapped.Offset = (DWORD)file->offset;
+	file->overlapped.OffsetHigh = (DWORD)(file->offset >> 32);
+	if (!ReadFile(file->hFile, file->buffer + file->offset, cb, NULL, &file->overlapped) && GetLastError() != ERROR_IO_PENDING)
+		return HRESULT_FROM_WIN32(GetLastError());
+	return S_OK;
+}
+
+void PostFileLoader::ReadSynchronously(PendingFile *file) const
+{
+	if (FAILED(file->hr = Open(file, 0)))
+		return;
+	while (file->offset < file->size)
+	{
+		ULONGLONG remaining = (file->size - file->offset + SECTOR_SIZE - 1) & ~(ULONGLONG)(SECTOR_SIZE - 1);
+		DWORD bytesRead = 0;
+		if (!ReadFile(file->hFile, file->buffer + file->offset, (DWORD)min(remaining, (ULONGLONG)READ_SIZE), &bytesRead, NULL))
+		{
+			file->hr = HRESULT_FROM_WIN32(GetLastError());
+			return;
+		}
+		if (bytesRead == 0)
+		{
+			// the file got shorter since it was opened
+			file->hr = HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
+			return;
+		}
+		file->offset += bytesRead;
+	}
+}
+
+HRESULT PostFileLoader::ReadOverlapped(void)
+{
+	HANDLE port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1);
+	if (!port)
+		return HRESULT_FROM_WIN32(GetLastError());
+
+	HRESULT hr = S_OK;
+	size_t next = 0, reading = 0;
+	while (next < m_files->GetCount() || reading > 0)
+	{
+		while (reading < m_options.queueDepth && next < m_files->GetCount())
+		{
+			PendingFile *file = new PendingFile((*m_files)[next++]);
+			file->hr = Open(file, FILE_FLAG_OVERLAPPED);
+			if (SUCCEEDED(file->hr) && file->size > 0 && !CreateIoCompletionPort(file->hFile, port, 0, 0))
+				file->hr = HRESULT_FROM_WIN32(GetLastError());
+			if (SUCCEEDED(file->hr) && file->size > 0 && SUCCEEDED(file->hr = ReadNext(file)))
+				reading++;
+			else
+				Complete(file);
+		}
+		if (reading == 0)
+			continue;
+
+		DWORD bytesRead = 0;
+		ULONG_PTR key;
+		LPOVERLAPPED overlapped = NULL;
+		BOOL succeeded = GetQueuedCompletionStatus(port, &bytesRead, &key, &overlapped, INFINITE);
+		if (!overlapped)
+		{
+			// the port itself failed; closing it abandons the reads still outstanding
+			hr = HRESULT_FROM_WIN32(GetLastError());
+			break;
+		}
+
+		PendingFile *file = CONTAINING_RECORD(overlapped, PendingFile, overlapped);
+		if (!succeeded)
+			file->hr = HRESULT_FROM_WIN32(GetLastError());
+		file->offset += bytesRead;
+		if (SUCCEEDED(file->hr) && file->offset < file->size)
+		{
+			if (bytesRead == 0)
+				file->hr = HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
+			else if (SUCCEEDED(file->hr = ReadNext(file)))
+				continue;
+		}
+		reading--;
+		Complete(file);
+	}
+
+	CloseHandle(port);
+	return hr;
+}
+
+void PostFileLoader::ReadOnThreads(void)
+{
+	CAtlArray<HANDLE> readers;
+	for (size_t i = 0; i < m_options.queueDepth; i++)
+	{
+		HANDLE reader = (HANDLE)_beginthreadex(NULL, 0, ReaderProc, this, 0, NULL);
+		if (reader)
+			readers.Add(reader);
+	}
+
+	// without any threads to spare, read on this one
+	if (readers.IsEmpty())
+		ReaderProc(this);
+
+	WaitForMultipleObjects((DWORD)readers.GetCount(), readers.GetData(), TRUE, INFINITE);
+	for (size_t i = 0; i < readers.GetCount(); i++)
+		CloseHandle(readers[i]);
+}
+
+unsigned __stdcall PostFileLoader::ReaderProc(void *parameter)
+{
+	PostFileLoader *loader = static_cast<PostFileLoader*>(parameter);
+	for (;;)
+	{
+		LONG next = InterlockedIncrement(&loader->m_next) - 1;
+		if ((size_t)next >= loader->m_files->GetCount())
+			return 0;
+		PendingFile *file = new PendingFile((*loader->m_files)[next]);
+		loader->ReadSynchronously(file);
+		loader->Complete(file);
+	}
+}
+
+unsigned __stdcall PostFileLoader::WorkerProc(void *parameter)
+{
+	PostFileLoader *loader = static_cast<PostFileLoader*>(parameter);
+	PendingFile *file;
+	while (loader->m_queue.Pop(file))
+		loader->Consume(file);
+	return 0;
+}
+
+// Hands a file that has been read, or has failed, to the workers.
+void PostFileLoader::Complete(PendingFile *file)
+{
+	if (file->hFile != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(file->hFile);
+		file->hFile = INVALID_HANDLE_VALUE;
+	}
+	if (!m_queue.Push(file))
+		delete file;
+}
+
+void PostFileLoader::Consume(PendingFile *file)
+{
+	LoadedPostFile loaded;
+	loaded.path = file->path;
+	loaded.hr = file->hr;
+	loaded.data = SUCCEEDED(file->hr) ? file->buffer : NULL;
+	loaded.size = SUCCEEDED(file->hr) ? file->size : 0;
+	m_consumer->Consume(loaded);
+
+	InterlockedIncrement(&m_fileCount);
+	if (FAILED(file->hr))
+		InterlockedIncrement(&m_failureCount);
+	else
+		InterlockedExchangeAdd64(&m_bytesRead, (LONGLONG)file->size);
+	delete file;
+}
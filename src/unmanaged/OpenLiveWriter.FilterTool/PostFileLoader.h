@@ -0,0 +1,117 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include "BoundedQueue.h"
+
+enum PostFileLoaderBackend
+{
+	POST_FILE_LOADER_SYNC = 0,
+	POST_FILE_LOADER_THREADS,
+	POST_FILE_LOADER_OVERLAPPED
+};
+
+struct PostFileLoaderOptions
+{
+	PostFileLoaderBackend backend;
+	size_t queueDepth;		// files being read at once
+	size_t workerCount;		// threads the files are handed to once they're read
+	bool uncached;			// read around the file cache, as if it were cold
+
+	PostFileLoaderOptions() : backend(POST_FILE_LOADER_OVERLAPPED), queueDepth(32), workerCount(2), uncached(false)
+	{
+	}
+};
+
+// A file read whole. data is NULL if it couldn't be opened or read, and hr says why.
+struct LoadedPostFile
+{
+	CString path;
+	const BYTE *data;
+	ULONGLONG size;
+	HRESULT hr;
+};
+
+/*
+What to do with each file once it has been read. Consume is called on the
+loader's workers, several at once, and the data goes away when it returns.
+*/
+class PostFileConsumer
+{
+public:
+	virtual ~PostFileConsumer(void) {}
+	virtual void Consume(const LoadedPostFile &file) = 0;
+};
+
+/*
+Reads many post files whole, for the native compound file reader to decode
+from memory, and hands each to a pool of workers as soon as it is read:
+
+	OVERLAPPED  keeps queueDepth files open and their reads outstanding on one
+	            completion port, opening the next file as each one finishes
+	THREADS     queueDepth threads open and read files synchronously, for
+	            where overlapped reads aren't any faster
+	SYNC        opens, reads and consumes one file at a time on the calling
+	            thread, the way the batch commands always have
+
+The size comes from the open handle rather than a separate look up of the
+path. Files are opened with FILE_FLAG_SEQUENTIAL_SCAN, so that the cache
+manager reads ahead of the reads, or when uncached with
+FILE_FLAG_NO_BUFFERING, so that every read goes to the disk. Read files wait
+for a worker in a queue that holds queueDepth of them, so reading stalls
+rather than buffering without limit when the workers fall behind.
+
+A loader runs once.
+*/
+class PostFileLoader
+{
+public:
+	explicit PostFileLoader(const PostFileLoaderOptions &options);
+
+	HRESULT Run(const CAtlArray<CString> &files, PostFileConsumer *consumer);
+
+	ULONG GetFileCount(void) const { return (ULONG)m_fileCount; }
+	ULONG GetFailureCount(void) const { return (ULONG)m_failureCount; }
+	ULONGLONG GetBytesRead(void) const { return (ULONGLONG)m_bytesRead; }
+
+private:
+	// reads are at most this long, and uncached ones a whole number of sectors
+	static const DWORD READ_SIZE = 0x400000;
+	static const DWORD SECTOR_SIZE = 0x1000;
+	static const ULONGLONG MAX_FILE_SIZE = 0x40000000;
+
+	struct PendingFile
+	{
+		OVERLAPPED overlapped;
+		CString path;
+		HANDLE hFile;
+		BYTE *buffer;
+		ULONGLONG size;
+		ULONGLONG offset;		// read so far
+		HRESULT hr;
+
+		explicit PendingFile(const CString &aPath);
+		~PendingFile(void);
+	};
+
+	HRESULT ReadOverlapped(void);
+	void ReadOnThreads(void);
+	static unsigned __stdcall ReaderProc(void *parameter);
+	static unsigned __stdcall WorkerProc(void *parameter);
+
+	HRESULT Open(PendingFile *file, DWORD flags) const;
+	HRESULT ReadNext(PendingFile *file) const;
+	void ReadSynchronously(PendingFile *file) const;
+	void Complete(PendingFile *file);
+	void Consume(PendingFile *file);
+
+	PostFileLoaderOptions m_options;
+	const CAtlArray<CString> *m_files;
+	PostFileConsumer *m_consumer;
+	BoundedQueue<PendingFile*> m_queue;
+	volatile LONG m_next;
+	volatile LONG m_fileCount;
+	volatile LONG m_failureCount;
+	volatile LONGLONG m_bytesRead;
+};
@@ -0,0 +1,122 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+/*
+Packs of many posts in one file (.olwpack), written by PostPackWriter and
+read by PostPackReader.
+
+	file:     PostPackHeader
+	          records and indexes, in the order they were appended
+	          PostPackTrailer, at the very end of the file
+	record:   PostPackRecordHeader, the blog id and the post id (UTF-16, not
+	          terminated), padded to 8 bytes, then the payload, padded to 8
+	          bytes; depending on the payload
+	            COMPOUND: the post file as it was
+	            STREAMS:  PostPackStreamsHeader, then the post's streams
+	                      decoded into the layout of PostFileDecoder.h, which
+	                      can be read without a compound file implementation
+	index:    PostPackIndexHeader, a PostPackIndexEntry per post sorted by
+	          blog id then post id, the entries' numbers sorted by date
+	          (DWORD), then the ids the entries point at (UTF-16)
+
+Posts are only ever appended. Every batch of appends ends with a new index of
+the latest record of every post and a trailer pointing at it. Appending a
+post again (same blog id and post id) leaves its earlier record behind as
+dead space, like the earlier indexes, until the pack is repacked, which
+copies the live records into a new file. A batch cut short by a crash leaves no trailer; the records
+before it can still be found by walking them from the header.
+
+Ids are compared by UTF-16 code unit. The date is the post file's last write
+time, which is what the filter reports as its primary date.
+
+All integers are little-endian; records and indexes start on 8 byte
+boundaries, so that a mapped payload is aligned.
+*/
+
+const DWORD POST_PACK_MAGIC = 0x504C574F;			// "OLWP"
+const DWORD POST_PACK_RECORD_MAGIC = 0x524C574F;	// "OLWR"
+const DWORD POST_PACK_INDEX_MAGIC = 0x494C574F;		// "OLWI"
+const DWORD POST_PACK_VERSION = 1;
+
+const DWORD POST_PACK_ALIGNMENT = 8;
+
+enum PostPackPayload
+{
+	POST_PACK_COMPOUND = 1,
+	POST_PACK_STREAMS
+};
+
+struct PostPackHeader
+{
+	DWORD magic;
+	DWORD version;
+};
+
+struct PostPackRecordHeader
+{
+	DWORD magic;
+	DWORD payload;			// a PostPackPayload
+	FILETIME date;
+	DWORD blogIdLength;		// in characters
+	DWORD postIdLength;
+	ULONGLONG payloadSize;	// not counting padding
+};
+
+struct PostPackStreamsHeader
+{
+	DWORD elementCount;		// PostFileElements at the start of the decoded post
+	DWORD unused;
+};
+
+struct PostPackIndexHeader
+{
+	DWORD magic;
+	DWORD entryCount;
+	ULONGLONG idLength;		// characters of ids after the date order
+};
+
+struct PostPackIndexEntry
+{
+	ULONGLONG recordOffset;
+	ULONGLONG recordSize;	// including padding
+	FILETIME date;
+	DWORD blogIdOffset;		// in characters, from the start of the ids
+	DWORD blogIdLength;
+	DWORD postIdOffset;
+	DWORD postIdLength;
+};
+
+struct PostPackTrailer
+{
+	ULONGLONG indexOffset;
+	DWORD version;
+	DWORD magic;
+};
+
+inline ULONGLONG PostPackAlign(ULONGLONG cb)
+{
+	return (cb + POST_PACK_ALIGNMENT - 1) & ~(ULONGLONG)(POST_PACK_ALIGNMENT - 1);
+}
+
+// the size of an index, not counting the trailer that follows it
+inline ULONGLONG PostPackIndexSize(DWORD entryCount, ULONGLONG idLength)
+{
+	return sizeof(PostPackIndexHeader) + (ULONGLONG)entryCount * sizeof(PostPackIndexEntry)
+		+ PostPackAlign((ULONGLONG)entryCount * sizeof(DWORD)) + PostPackAlign(idLength * sizeof(WCHAR));
+}
+
+// the order of the index: by blog id, then by post id
+inline int ComparePostPackIds(LPCWSTR blogId1, DWORD blogIdLength1, LPCWSTR postId1, DWORD postIdLength1,
+	LPCWSTR blogId2, DWORD blogIdLength2, LPCWSTR postId2, DWORD postIdLength2)
+{
+	int result = wmemcmp(blogId1, blogId2, min(blogIdLength1, blogIdLength2));
+	if (result == 0 && blogIdLength1 != blogIdLength2)
+		result = blogIdLength1 < blogIdLength2 ? -1 : 1;
+	if (result == 0)
+		result = wmemcmp(postId1, postId2, min(postIdLength1, postIdLength2));
+	if (result == 0 && postIdLength1 != postIdLength2)
+		result = postIdLength1 < postIdLength2 ? -1 : 1;
+	return result;
+}
@@ -0,0 +1,323 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "stdafx.h"
+#include "PostPackReader.h"
+#include "PostPackView.h"
+#include "PostFileDecoder.h"
+#include "..\OpenLiveWriter.Filter\ContentsJournal.h"
+#include "..\OpenLiveWriter.Filter\PostEditorFileConstants.h"
+
+static const HRESULT POST_PACK_E_CORRUPT = HRESULT_FROM_WIN32(ERROR_FILE_CORRUPT);
+
+PostPackReader::PostPackReader(void) :
+	m_size(0), m_entries(NULL), m_byDate(NULL), m_ids(NULL), m_entryCount(0)
+{
+}
+
+HRESULT PostPackReader::Open(LPCWSTR path)
+{
+	HRESULT hr;
+	Close();
+
+	CAtlFile file;
+	if (FAILED(hr = file.Create(path, GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS)))
+		return hr;
+	ULONGLONG size;
+	if (FAILED(hr = file.GetSize(size)))
+		return hr;
+	if (size < sizeof(PostPackHeader) + sizeof(PostPackIndexHeader) + sizeof(PostPackTrailer) || size > (SIZE_T)-1)
+		return POST_PACK_E_CORRUPT;
+	if (FAILED(hr = m_mapping.MapFile(file)))
+		return hr;
+
+	const BYTE *data = m_mapping;
+	const PostPackHeader *header = reinterpret_cast<const PostPackHeader*>(data);
+	const PostPackTrailer *trailer = reinterpret_cast<const PostPackTrailer*>(data + size - sizeof(PostPackTrailer));
+	if (header->magic != POST_PACK_MAGIC || trailer->magic != POST_PACK_MAGIC)
+		return POST_PACK_E_CORRUPT;
+	if (header->version != POST_PACK_VERSION || trailer->version != POST_PACK_VERSION)
+		return HRESULT_FROM_WIN32(ERROR_UNSUPPORTED_TYPE);
+
+	// the index runs right up to the trailer
+	ULONGLONG indexEnd = size - sizeof(PostPackTrailer);
+	if (trailer->indexOffset < sizeof(PostPackHeader) || trailer->indexOffset % POST_PACK_ALIGNMENT
+		|| trailer->indexOffset > indexEnd - sizeof(PostPackIndexHeader))
+		return POST_PACK_E_CORRUPT;
+	const PostPackIndexHeader *index = reinterpret_cast<const PostPackIndexHeader*>(data + trailer->indexOffset);
+	if (index->magic != POST_PACK_INDEX_MAGIC || index->idLength > size
+		|| PostPackIndexSize(index->entryCount, index->idLength) != indexEnd - trailer->indexOffset)
+		return POST_PACK_E_CORRUPT;
+
+	const PostPackIndexEntry *entries = reinterpret_cast<const PostPackIndexEntry*>(index + 1);
+	const DWORD *byDate = reinterpret_cast<const DWORD*>(entries + index->entryCount);
+	LPCWSTR ids = reinterpret_cast<LPCWSTR>(reinterpret_cast<const BYTE*>(byDate) + PostPackAlign((ULONGLONG)index->entryCount * sizeof(DWORD)));
+
+	// records have to lie between the file header and the index; the records
+	// themselves are checked when they're read
+	for (DWORD entry = 0; entry < index->entryCount; entry++)
+	{
+		const PostPackIndexEntry &e = entries[entry];
+		if (e.recordOffset < sizeof(PostPackHeader) || e.recordOffset % POST_PACK_ALIGNMENT
+			|| e.recordOffset > trailer->indexOffset || e.recordSize > trailer->indexOffset - e.recordOffset
+			|| e.recordSize < sizeof(PostPackRecordHeader)
+			|| (ULONGLONG)e.blogIdOffset + e.blogIdLength > index->idLength
+			|| (ULONGLONG)e.postIdOffset + e.postIdLength > index->idLength
+			|| byDate[entry] >= index->entryCount)
+			return POST_PACK_E_CORRUPT;
+	}
+
+	m_size = size;
+	m_entries = entries;
+	m_byDate = byDate;
+	m_ids = ids;
+	m_entryCount = index->entryCount;
+	return S_OK;
+}
+
+void PostPackReader::Close(void)
+{
+	m_mapping.Unmap();
+	m_size = 0;
+	m_entries = NULL;
+	m_byDate = NULL;
+	m_ids = NULL;
+	m_entryCount = 0;
+}
+
+ULONGLONG PostPackReader::GetLiveBytes(void) const
+{
+	ULONGLONG liveBytes = 0;
+	for (DWORD entry = 0; entry < m_entryCount; entry++)
+		liveBytes += m_entries[entry].recordSize;
+	return liveBytes;
+}
+
+void PostPackReader::GetEntry(DWORD entry, PostPackEntry &post) const
+{
+	const PostPackIndexEntry &e = m_entries[entry];
+	post.blogId = m_ids + e.blogIdOffset;
+	post.blogIdLength = e.blogIdLength;
+	post.postId = m_ids + e.postIdOffset;
+	post.postIdLength = e.postIdLength;
+	post.date = e.date;
+	post.recordOffset = e.recordOffset;
+	post.recordSize = e.recordSize;
+}
+
+bool PostPackReader::Find(const CStringW &blogId, const CStringW &postId, DWORD *entry) const
+{
+	DWORD low = 0, high = m_entryCount;
+	while (low < high)
+	{
+		DWORD middle = low + (high - low) / 2;
+		PostPackEntry post;
+		GetEntry(middle, post);
+		int result = ComparePostPackIds(post.blogId, post.blogIdLength, post.postId, post.postIdLength,
+			blogId, blogId.GetLength(), postId, postId.GetLength());
+		if (result == 0)
+		{
+			*entry = middle;
+			return true;
+		}
+		if (result < 0)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	return false;
+}
+
+HRESULT PostPackReader::CheckRecord(const BYTE *data, ULONGLONG offset, ULONGLONG end,
+	const PostPackRecordHeader **header, const BYTE **payload, ULONGLONG *recordSize)
+{
+	if (offset % POST_PACK_ALIGNMENT || offset > end || end - offset < sizeof(PostPackRecordHeader))
+		return POST_PACK_E_CORRUPT;
+	const PostPackRecordHeader *record = reinterpret_cast<const PostPackRecordHeader*>(data + offset);
+	if (record->magic != POST_PACK_RECORD_MAGIC)
+		return POST_PACK_E_CORRUPT;
+
+	ULONGLONG available = end - offset - sizeof(PostPackRecordHeader);
+	ULONGLONG idsSize = PostPackAlign(((ULONGLONG)record->blogIdLength + record->postIdLength) * sizeof(WCHAR));
+	if (idsSize > available || record->payloadSize > available - idsSize
+		|| PostPackAlign(record->payloadSize) > available - idsSize)
+		return POST_PACK_E_CORRUPT;
+	if (record->payload == POST_PACK_STREAMS && record->payloadSize < sizeof(PostPackStreamsHeader))
+		return POST_PACK_E_CORRUPT;
+
+	*header = record;
+	*payload = reinterpret_cast<const BYTE*>(record + 1) + idsSize;
+	*recordSize = sizeof(PostPackRecordHeader) + idsSize + PostPackAlign(record->payloadSize);
+	return S_OK;
+}
+
+HRESULT PostPackReader::GetPayload(DWORD entry, DWORD *payload, const BYTE **data, ULONGLONG *size) const
+{
+	if (entry >= m_entryCount)
+		return E_INVALIDARG;
+
+	HRESULT hr;
+	const PostPackIndexEntry &e = m_entries[entry];
+	const PostPackRecordHeader *header;
+	ULONGLONG recordSize;
+	if (FAILED(hr = CheckRecord(m_mapping, e.recordOffset, e.recordOffset + e.recordSize, &header, data, &recordSize)))
+		return hr;
+	if (recordSize != e.recordSize)
+		return POST_PACK_E_CORRUPT;
+
+	*payload = header->payload;
+	*size = header->payloadSize;
+	return S_OK;
+}
+
+HRESULT PostPackReader::OpenStream(DWORD entry, IStream **ppStream) const
+{
+	HRESULT hr;
+	DWORD payload;
+	const BYTE *data;
+	ULONGLONG size;
+	if (FAILED(hr = GetPayload(entry, &payload, &data, &size)))
+		return hr;
+	if (payload != POST_PACK_COMPOUND)
+		return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+
+	PostPackEntry post;
+	GetEntry(entry, post);
+	CStringW name = CStringW(post.blogId, post.blogIdLength) + L"/" + CStringW(post.postId, post.postIdLength);
+	return PostPackView::Create(data, size, post.date, name, ppStream);
+}
+
+// Finds a stream in the root storage of a decoded post and checks that its
+// data is all there, S_FALSE if there is no such stream.
+static HRESULT FindDecodedStream(const BYTE *data, ULONGLONG size, DWORD elementCount, LPCWSTR name, const PostFileElement **stream)
+{
+	*stream = NULL;
+	if ((ULONGLONG)elementCount * sizeof(PostFileElement) > size)
+		return POST_PACK_E_CORRUPT;
+
+	const PostFileElement *elements = reinterpret_cast<const PostFileElement*>(data);
+	int nameLength = (int)wcslen(name);
+	for (DWORD i = 0; i < elementCount; i++)
+	{
+		const PostFileElement &element = elements[i];
+		if (element.parent != 0 || element.type != POST_FILE_STREAM || element.nameLength != nameLength)
+			continue;
+		if (element.nameOffset < 0 || (ULONGLONG)element.nameOffset + (ULONGLONG)nameLength * sizeof(WCHAR) > size)
+			return POST_PACK_E_CORRUPT;
+		if (_wcsnicmp(reinterpret_cast<LPCWSTR>(data + element.nameOffset), name, nameLength) != 0)
+			continue;
+
+		if (element.flags & POST_FILE_NOT_LOADED)
+			return HRESULT_FROM_WIN32(ERROR_FILE_TOO_LARGE);
+		if (element.dataOffset < 0 || element.dataLength < 0 || element.dataLength > INT_MAX
+			|| (ULONGLONG)element.dataOffset > size || (ULONGLONG)element.dataLength > size - element.dataOffset)
+			return POST_PACK_E_CORRUPT;
+		*stream = &element;
+		return S_OK;
+	}
+	return S_FALSE;
+}
+
+// Decodes count UTF-32 characters as UTF-16, with U+FFFD for any that aren't
+// characters, as .NET's UTF32Encoding does.
+static void ReadUtf32(const BYTE *p, int count, bool bigEndian, CStringW &value)
+{
+	value.Preallocate(count);
+	for (int i = 0; i < count; i++, p += 4)
+	{
+		DWORD c = bigEndian
+			? ((DWORD)p[0] << 24) | ((DWORD)p[1] << 16) | ((DWORD)p[2] << 8) | p[3]
+			: ((DWORD)p[3] << 24) | ((DWORD)p[2] << 16) | ((DWORD)p[1] << 8) | p[0];
+		if (c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF))
+			c = 0xFFFD;
+		if (c >= 0x10000)
+		{
+			value.AppendChar((WCHAR)(0xD800 + ((c - 0x10000) >> 10)));
+			value.AppendChar((WCHAR)(0xDC00 + ((c - 0x10000) & 0x3FF)));
+		}
+		else
+			value.AppendChar((WCHAR)c);
+	}
+}
+
+HRESULT PostPackReader::ReadDecodedString(const BYTE *data, ULONGLONG size, DWORD elementCount, LPCWSTR name, CStringW &value)
+{
+	value.Empty();
+	const PostFileElement *element;
+	HRESULT hr = FindDecodedStream(data, size, elementCount, name, &element);
+	if (hr != S_OK)
+		return hr;
+
+	// written the way PostExtractor::ReadString reads them, by their byte order
+	// mark, or as UTF-16 if they have none
+	const BYTE *p = data + element->dataOffset;
+	int cb = (int)element->dataLength;
+	switch (element->encoding)
+	{
+	case POST_FILE_UTF8:
+	{
+		int cwc = MultiByteToWideChar(CP_UTF8, 0, reinterpret_cast<LPCSTR>(p + 3), cb - 3, NULL, 0);
+		MultiByteToWideChar(CP_UTF8, 0, reinterpret_cast<LPCSTR>(p + 3), cb - 3, value.GetBuffer(cwc), cwc);
+		value.ReleaseBuffer(cwc);
+		break;
+	}
+	case POST_FILE_UTF16:
+		value.SetString(reinterpret_cast<LPCWSTR>(p + 2), (cb - 2) / (int)sizeof(WCHAR));
+		break;
+	case POST_FILE_UTF16BE:
+	{
+		int cwc = (cb - 2) / (int)sizeof(WCHAR);
+		LPWSTR buffer = value.GetBuffer(cwc);
+		for (int i = 0; i < cwc; i++)
+			buffer[i] = (WCHAR)((p[2 + i * 2] << 8) | p[3 + i * 2]);
+		value.ReleaseBuffer(cwc);
+		break;
+	}
+	case POST_FILE_UTF32:
+	case POST_FILE_UTF32BE:
+		ReadUtf32(p + 4, (cb - 4) / 4, element->encoding == POST_FILE_UTF32BE, value);
+		break;
+	default:
+		value.SetString(reinterpret_cast<LPCWSTR>(p), cb / (int)sizeof(WCHAR));
+		break;
+	}
+	return S_OK;
+}
+
+HRESULT PostPackReader::ReadDecodedContents(const BYTE *data, ULONGLONG size, DWORD elementCount, CAtlArray<BYTE> &contents)
+{
+	contents.RemoveAll();
+	const PostFileElement *base, *journal;
+	HRESULT hr = FindDecodedStream(data, size, elementCount, POST_CONTENTS, &base);
+	if (hr != S_OK)
+		return hr;
+	if (FAILED(hr = FindDecodedStream(data, size, elementCount, POST_CONTENTS_JOURNAL, &journal)))
+		return hr;
+
+	if (!journal)
+	{
+		if (!contents.SetCount((size_t)base->dataLength))
+			return E_OUTOFMEMORY;
+		memcpy(contents.GetData(), data + base->dataOffset, (size_t)base->dataLength);
+		return S_OK;
+	}
+
+	// the journal is applied exactly as the filter applies it to a compound file
+	FILETIME noDate = { 0 };
+	CComPtr<IStream> baseStream, journalStream, body;
+	if (FAILED(hr = PostPackView::Create(data + base->dataOffset, base->dataLength, noDate, POST_CONTENTS, &baseStream))
+		|| FAILED(hr = PostPackView::Create(data + journal->dataOffset, journal->dataLength, noDate, POST_CONTENTS_JOURNAL, &journalStream))
+		|| FAILED(hr = ContentsJournal::Apply(baseStream, journalStream, &body)))
+		return hr;
+
+	STATSTG statstg;
+	if (FAILED(hr = body->Stat(&statstg, STATFLAG_NONAME)))
+		return hr;
+	if (!contents.SetCount((size_t)statstg.cbSize.QuadPart))
+		return E_OUTOFMEMORY;
+	ULONG bytesRead = 0;
+	if (FAILED(hr = body->Read(contents.GetData(), (ULONG)contents.GetCount(), &bytesRead)))
+		return hr;
+	contents.SetCount(bytesRead);
+	return S_OK;
+}
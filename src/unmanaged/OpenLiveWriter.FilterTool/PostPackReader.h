@@ -0,0 +1,77 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+#include "PostPackFormat.h"
+
+/*
+A post as the index of a pack has it, pointing straight into the mapped
+file. Ids are not null terminated.
+*/
+struct PostPackEntry
+{
+	LPCWSTR blogId;
+	DWORD blogIdLength;
+	LPCWSTR postId;
+	DWORD postIdLength;
+	FILETIME date;
+	ULONGLONG recordOffset;
+	ULONGLONG recordSize;
+};
+
+/*
+Reads a pack of posts (see PostPackFormat.h) through a read-only mapping of
+the whole file. The index is checked against the size of the file when the
+pack is opened and each record when its payload is asked for, so a
+truncated or corrupt pack fails with HRESULT_FROM_WIN32(ERROR_FILE_CORRUPT)
+instead of reading out of bounds. Entries are numbered in index order, which
+is also the order of the records in a repacked pack.
+
+Streams from OpenStream read the mapping, so the reader has to outlive them.
+*/
+class PostPackReader
+{
+public:
+	PostPackReader(void);
+
+	HRESULT Open(LPCWSTR path);
+	void Close(void);
+
+	DWORD GetCount(void) const { return m_entryCount; }
+	ULONGLONG GetFileSize(void) const { return m_size; }
+	// the size of the records the index points at, which a repack keeps
+	ULONGLONG GetLiveBytes(void) const;
+
+	void GetEntry(DWORD entry, PostPackEntry &post) const;
+	// the number of the entry that is position'th by date, oldest first
+	DWORD GetEntryByDate(DWORD position) const { return m_byDate[position]; }
+	bool Find(const CStringW &blogId, const CStringW &postId, DWORD *entry) const;
+
+	HRESULT GetPayload(DWORD entry, DWORD *payload, const BYTE **data, ULONGLONG *size) const;
+
+	// Opens a COMPOUND post as a stream that is also ILockBytes, reading straight
+	// from the mapping (see PostPackView).
+	HRESULT OpenStream(DWORD entry, IStream **ppStream) const;
+
+	// Reads a string stream from the root storage of a STREAMS payload (or any
+	// post decoded by PostFileDecoder, given its element count), S_FALSE if
+	// there is no such stream.
+	static HRESULT ReadDecodedString(const BYTE *data, ULONGLONG size, DWORD elementCount, LPCWSTR name, CStringW &value);
+
+	// Reads the body of a STREAMS payload (or any decoded post) as the filter
+	// would read it from the compound file, with the autosaved ContentsJournal
+	// applied to Contents. S_FALSE, and no contents, if there is no body.
+	static HRESULT ReadDecodedContents(const BYTE *data, ULONGLONG size, DWORD elementCount, CAtlArray<BYTE> &contents);
+
+	// Checks the record at offset, which has to end by end, and finds its payload.
+	static HRESULT CheckRecord(const BYTE *data, ULONGLONG offset, ULONGLONG end,
+		const PostPackRecordHeader **header, const BYTE **payload, ULONGLONG *recordSize);
+
+private:
+	CAtlFileMapping<BYTE> m_mapping;
+	ULONGLONG m_size;
+	const PostPackIndexEntry *m_entries;
+	const DWORD *m_byDate;
+	LPCWSTR m_ids;
+	DWORD m_entryCount;
+};
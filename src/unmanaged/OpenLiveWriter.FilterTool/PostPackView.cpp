@@ -0,0 +1,218 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "stdafx.h"
+#include "PostPackView.h"
+
+HRESULT PostPackView::Create(const BYTE *data, ULONGLONG size, const FILETIME &date, LPCWSTR name, IStream **ppStream)
+{
+	if (!ppStream)
+		return E_POINTER;
+	*ppStream = new PostPackView(data, size, date, name);
+	return *ppStream ? S_OK : E_OUTOFMEMORY;
+}
+
+PostPackView::PostPackView(const BYTE *data, ULONGLONG size, const FILETIME &date, LPCWSTR name) :
+	m_refCount(1), m_data(data), m_size(size), m_date(date), m_name(name), m_position(0)
+{
+}
+
+STDMETHODIMP PostPackView::QueryInterface(REFIID riid, void **ppvObject)
+{
+	if (!ppvObject)
+		return E_POINTER;
+	if (riid == IID_IUnknown || riid == IID_ISequentialStream || riid == IID_IStream)
+		*ppvObject = static_cast<IStream*>(this);
+	else if (riid == IID_ILockBytes)
+		*ppvObject = static_cast<ILockBytes*>(this);
+	else if (riid == IID_IWebPostFilterPackedPost)
+		*ppvObject = static_cast<IWebPostFilterPackedPost*>(this);
+	else
+	{
+		*ppvObject = NULL;
+		return E_NOINTERFACE;
+	}
+	AddRef();
+	return S_OK;
+}
+
+STDMETHODIMP_(ULONG) PostPackView::AddRef(void)
+{
+	return InterlockedIncrement(&m_refCount);
+}
+
+STDMETHODIMP_(ULONG) PostPackView::Release(void)
+{
+	LONG refCount = InterlockedDecrement(&m_refCount);
+	if (refCount == 0)
+		delete this;
+	return refCount;
+}
+
+ULONG PostPackView::CopyOut(ULONGLONG offset, void *pv, ULONG cb) const
+{
+	if (offset >= m_size)
+		return 0;
+	if (cb > m_size - offset)
+		cb = (ULONG)(m_size - offset);
+	memcpy(pv, m_data + offset, cb);
+	return cb;
+}
+
+STDMETHODIMP PostPackView::Read(void *pv, ULONG cb, ULONG *pcbRead)
+{
+	if (!pv)
+		return STG_E_INVALIDPOINTER;
+	ULONG bytesRead = CopyOut(m_position, pv, cb);
+	m_position += bytesRead;
+	if (pcbRead)
+		*pcbRead = bytesRead;
+	return bytesRead < cb ? S_FALSE : S_OK;
+}
+
+STDMETHODIMP PostPackView::Write(const void *pv, ULONG cb, ULONG *pcbWritten)
+{
+	return STG_E_ACCESSDENIED;
+}
+
+STDMETHODIMP PostPackView::Seek(LARGE_INTEGER dlibMove, DWORD dwOrigin, ULARGE_INTEGER *plibNewPosition)
+{
+	LONGLONG origin;
+	switch (dwOrigin)
+	{
+	case STREAM_SEEK_SET:
+		origin = 0;
+		break;
+	case STREAM_SEEK_CUR:
+		origin = (LONGLONG)m_position;
+		break;
+	case STREAM_SEEK_END:
+		origin = (LONGLONG)m_size;
+		break;
+	default:
+		return STG_E_INVALIDFUNCTION;
+	}
+	if (origin + dlibMove.QuadPart < 0)
+		return STG_E_INVALIDFUNCTION;
+
+	// like any stream, the position may go past the end; reads there return nothing
+	m_position = (ULONGLONG)(origin + dlibMove.QuadPart);
+	if (plibNewPosition)
+		plibNewPosition->QuadPart = m_position;
+	return S_OK;
+}
+
+STDMETHODIMP PostPackView::CopyTo(IStream *pstm, ULARGE_INTEGER cb, ULARGE_INTEGER *pcbRead, ULARGE_INTEGER *pcbWritten)
+{
+	if (!pstm)
+		return STG_E_INVALIDPOINTER;
+
+	ULONGLONG remaining = m_position < m_size ? min(cb.QuadPart, m_size - m_position) : 0;
+	ULONGLONG read = 0, written = 0;
+	HRESULT hr = S_OK;
+	while (remaining > 0)
+	{
+		ULONG chunk = (ULONG)min(remaining, (ULONGLONG)0x40000000);
+		ULONG chunkWritten = 0;
+		hr = pstm->Write(m_data + m_position, chunk, &chunkWritten);
+		read += chunk;
+		written += chunkWritten;
+		m_position += chunk;
+		remaining -= chunk;
+		if (FAILED(hr))
+			break;
+	}
+	if (pcbRead)
+		pcbRead->QuadPart = read;
+	if (pcbWritten)
+		pcbWritten->QuadPart = written;
+	return hr;
+}
+
+STDMETHODIMP PostPackView::Commit(DWORD grfCommitFlags)
+{
+	return S_OK;
+}
+
+STDMETHODIMP PostPackView::Revert(void)
+{
+	return S_OK;
+}
+
+STDMETHODIMP PostPackView::Clone(IStream **ppstm)
+{
+	HRESULT hr;
+	if (FAILED(hr = Create(m_data, m_size, m_date, m_name, ppstm)))
+		return hr;
+	static_cast<PostPackView*>(*ppstm)->m_position = m_position;
+	return S_OK;
+}
+
+STDMETHODIMP PostPackView::ReadAt(ULARGE_INTEGER ulOffset, void *pv, ULONG cb, ULONG *pcbRead)
+{
+	if (!pv)
+		return STG_E_INVALIDPOINTER;
+	ULONG bytesRead = CopyOut(ulOffset.QuadPart, pv, cb);
+	if (pcbRead)
+		*pcbRead = bytesRead;
+	return S_OK;
+}
+
+STDMETHODIMP PostPackView::WriteAt(ULARGE_INTEGER ulOffset, const void *pv, ULONG cb, ULONG *pcbWritten)
+{
+	return STG_E_ACCESSDENIED;
+}
+
+STDMETHODIMP PostPackView::Flush(void)
+{
+	return S_OK;
+}
+
+STDMETHODIMP PostPackView::SetSize(ULARGE_INTEGER cb)
+{
+	return STG_E_ACCESSDENIED;
+}
+
+STDMETHODIMP PostPackView::LockRegion(ULARGE_INTEGER libOffset, ULARGE_INTEGER cb, DWORD dwLockType)
+{
+	// nothing can write to the view, so there is nothing to lock
+	return STG_E_INVALIDFUNCTION;
+}
+
+STDMETHODIMP PostPackView::UnlockRegion(ULARGE_INTEGER libOffset, ULARGE_INTEGER cb, DWORD dwLockType)
+{
+	return STG_E_INVALIDFUNCTION;
+}
+
+STDMETHODIMP PostPackView::Stat(STATSTG *pstatstg, DWORD grfStatFlag)
+{
+	if (!pstatstg)
+		return E_POINTER;
+	ZeroMemory(pstatstg, sizeof(STATSTG));
+
+	pstatstg->type = STGTY_STREAM;
+	pstatstg->cbSize.QuadPart = m_size;
+	pstatstg->ctime = m_date;
+	pstatstg->atime = m_date;
+	pstatstg->mtime = m_date;
+	pstatstg->grfMode = STGM_READ | STGM_SHARE_DENY_WRITE;
+
+	if (!(grfStatFlag & STATFLAG_NONAME))
+	{
+		size_t cbName = (m_name.GetLength() + 1) * sizeof(WCHAR);
+		pstatstg->pwcsName = static_cast<LPOLESTR>(CoTaskMemAlloc(cbName));
+		if (!pstatstg->pwcsName)
+			return E_OUTOFMEMORY;
+		memcpy(pstatstg->pwcsName, m_name.GetString(), cbName);
+	}
+	return S_OK;
+}
+
+STDMETHODIMP PostPackView::GetLockBytes(ILockBytes **ppLockBytes)
+{
+	if (!ppLockBytes)
+		return E_POINTER;
+	*ppLockBytes = static_cast<ILockBytes*>(this);
+	AddRef();
+	return S_OK;
+}
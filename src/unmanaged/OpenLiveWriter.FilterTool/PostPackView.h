@@ -0,0 +1,64 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+#include "..\OpenLiveWriter.Filter\OpenLiveWriter.Filter.h"
+
+/*
+A read-only stream over a post file that lies in memory, typically in a
+mapped pack (see PostPackReader::OpenStream). It is ILockBytes as well, so
+that StgOpenStorageOnILockBytes reads the compound file straight out of the
+mapping, with nothing copied and no seeking around a stream. The filter
+only takes the shortcut for streams that hand it their lock bytes through
+IWebPostFilterPackedPost, as this one does. Stat reports the date given as the last write time, which is what
+the filter takes as the post's primary date.
+
+The memory has to stay where it is until the view is released.
+*/
+class PostPackView : public IStream, public ILockBytes, public IWebPostFilterPackedPost
+{
+public:
+	static HRESULT Create(const BYTE *data, ULONGLONG size, const FILETIME &date, LPCWSTR name, IStream **ppStream);
+
+	// IUnknown
+	STDMETHOD(QueryInterface)(REFIID riid, void **ppvObject);
+	STDMETHOD_(ULONG, AddRef)(void);
+	STDMETHOD_(ULONG, Release)(void);
+
+	// ISequentialStream
+	STDMETHOD(Read)(void *pv, ULONG cb, ULONG *pcbRead);
+	STDMETHOD(Write)(const void *pv, ULONG cb, ULONG *pcbWritten);
+
+	// IStream
+	STDMETHOD(Seek)(LARGE_INTEGER dlibMove, DWORD dwOrigin, ULARGE_INTEGER *plibNewPosition);
+	STDMETHOD(CopyTo)(IStream *pstm, ULARGE_INTEGER cb, ULARGE_INTEGER *pcbRead, ULARGE_INTEGER *pcbWritten);
+	STDMETHOD(Commit)(DWORD grfCommitFlags);
+	STDMETHOD(Revert)(void);
+	STDMETHOD(Clone)(IStream **ppstm);
+
+	// ILockBytes
+	STDMETHOD(ReadAt)(ULARGE_INTEGER ulOffset, void *pv, ULONG cb, ULONG *pcbRead);
+	STDMETHOD(WriteAt)(ULARGE_INTEGER ulOffset, const void *pv, ULONG cb, ULONG *pcbWritten);
+	STDMETHOD(Flush)(void);
+
+	// both
+	STDMETHOD(SetSize)(ULARGE_INTEGER cb);
+	STDMETHOD(LockRegion)(ULARGE_INTEGER libOffset, ULARGE_INTEGER cb, DWORD dwLockType);
+	STDMETHOD(UnlockRegion)(ULARGE_INTEGER libOffset, ULARGE_INTEGER cb, DWORD dwLockType);
+	STDMETHOD(Stat)(STATSTG *pstatstg, DWORD grfStatFlag);
+
+	// IWebPostFilterPackedPost
+	STDMETHOD(GetLockBytes)(ILockBytes **ppLockBytes);
+
+private:
+	PostPackView(const BYTE *data, ULONGLONG size, const FILETIME &date, LPCWSTR name);
+
+	ULONG CopyOut(ULONGLONG offset, void *pv, ULONG cb) const;
+
+	LONG m_refCount;
+	const BYTE *m_data;
+	ULONGLONG m_size;
+	FILETIME m_date;
+	CStringW m_name;
+	ULONGLONG m_position;
+};
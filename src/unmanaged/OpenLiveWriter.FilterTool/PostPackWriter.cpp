@@ -0,0 +1,439 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "stdafx.h"
+#include "PostPackWriter.h"
+#include "PostPackReader.h"
+#include "PostFileDecoder.h"
+#include "..\OpenLiveWriter.Filter\PostEditorFileConstants.h"
+
+static const HRESULT POST_PACK_E_CORRUPT = HRESULT_FROM_WIN32(ERROR_FILE_CORRUPT);
+
+static const BYTE PADDING[POST_PACK_ALIGNMENT] = { 0 };
+
+PostPackWriter::PostPackWriter(void) :
+	m_offset(0), m_liveBytes(0), m_buffered(0)
+{
+}
+
+PostPackWriter::~PostPackWriter(void)
+{
+}
+
+HRESULT PostPackWriter::Open(LPCWSTR path)
+{
+	HRESULT hr;
+
+	// a pack that was closed properly has all its posts in its index
+	bool indexed = false;
+	{
+		PostPackReader reader;
+		hr = reader.Open(path);
+		if (SUCCEEDED(hr))
+		{
+			for (DWORD entry = 0; entry < reader.GetCount(); entry++)
+			{
+				PostPackEntry post;
+				reader.GetEntry(entry, post);
+				AddPost(CStringW(post.blogId, post.blogIdLength), CStringW(post.postId, post.postIdLength),
+					post.date, post.recordOffset, post.recordSize);
+			}
+			indexed = true;
+		}
+		else if (hr != HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND) && hr != POST_PACK_E_CORRUPT)
+		{
+			return hr;
+		}
+	}
+
+	if (FAILED(hr = m_file.Create(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, OPEN_ALWAYS, FILE_FLAG_SEQUENTIAL_SCAN)))
+		return hr;
+	ULONGLONG size;
+	if (FAILED(hr = m_file.GetSize(size)))
+		return hr;
+	if (size == 0)
+	{
+		PostPackHeader header;
+		header.magic = POST_PACK_MAGIC;
+		header.version = POST_PACK_VERSION;
+		return Write(&header, sizeof(header));
+	}
+
+	m_offset = size;
+	if (!indexed && FAILED(hr = Recover(size)))
+		return hr;
+	return m_file.Seek(m_offset, FILE_BEGIN);
+}
+
+// Finds the posts in a pack without a trailer by walking its records, and cuts
+// off whatever follows the last whole one.
+HRESULT PostPackWriter::Recover(ULONGLONG size)
+{
+	HRESULT hr;
+	if (size < sizeof(PostPackHeader) || size > (SIZE_T)-1)
+		return POST_PACK_E_CORRUPT;
+
+	ULONGLONG end = sizeof(PostPackHeader);
+	{
+		CAtlFileMapping<BYTE> mapping;
+		if (FAILED(hr = mapping.MapFile(m_file)))
+			return hr;
+		const BYTE *data = mapping;
+
+		// anything that doesn't start like a pack is left alone
+		const PostPackHeader *header = reinterpret_cast<const PostPackHeader*>(data);
+		if (header->magic != POST_PACK_MAGIC)
+			return POST_PACK_E_CORRUPT;
+		if (header->version != POST_PACK_VERSION)
+			return HRESULT_FROM_WIN32(ERROR_UNSUPPORTED_TYPE);
+
+		while (size - end >= sizeof(DWORD))
+		{
+			DWORD magic = *reinterpret_cast<const DWORD*>(data + end);
+			if (magic == POST_PACK_RECORD_MAGIC)
+			{
+				const PostPackRecordHeader *record;
+				const BYTE *payload;
+				ULONGLONG recordSize;
+				if (FAILED(PostPackReader::CheckRecord(data, end, size, &record, &payload, &recordSize)))
+					break;
+				LPCWSTR ids = reinterpret_cast<LPCWSTR>(record + 1);
+				AddPost(CStringW(ids, record->blogIdLength), CStringW(ids + record->blogIdLength, record->postIdLength),
+					record->date, end, recordSize);
+				end += recordSize;
+			}
+			else if (magic == POST_PACK_INDEX_MAGIC && size - end >= sizeof(PostPackIndexHeader))
+			{
+				// an earlier batch's index, and its trailer
+				const PostPackIndexHeader *index = reinterpret_cast<const PostPackIndexHeader*>(data + end);
+				if (index->idLength > size
+					|| PostPackIndexSize(index->entryCount, index->idLength) + sizeof(PostPackTrailer) > size - end)
+					break;
+				end += PostPackIndexSize(index->entryCount, index->idLength) + sizeof(PostPackTrailer);
+			}
+			else
+			{
+				break;
+			}
+		}
+	}
+
+	// the file can't be cut short while it is mapped
+	if (FAILED(hr = m_file.SetSize(end)))
+		return hr;
+	m_offset = end;
+	return S_OK;
+}
+
+void PostPackWriter::AddPost(const CStringW &blogId, const CStringW &postId, const FILETIME &date, ULONGLONG recordOffset, ULONGLONG recordSize)
+{
+	// ids never have line breaks in them
+	CStringW key = blogId + L'\n' + postId;
+	const CAtlMap<CStringW, size_t, CStringElementTraits<CStringW> >::CPair *pair = m_postsByKey.Lookup(key);
+	size_t index;
+	if (pair)
+	{
+		index = pair->m_value;
+		m_liveBytes -= m_posts[index].recordSize;
+	}
+	else
+	{
+		index = m_posts.Add();
+		m_posts[index].blogId = blogId;
+		m_posts[index].postId = postId;
+		m_postsByKey.SetAt(key, index);
+	}
+
+	Post &post = m_posts[index];
+	post.date = date;
+	post.recordOffset = recordOffset;
+	post.recordSize = recordSize;
+	m_liveBytes += recordSize;
+}
+
+HRESULT PostPackWriter::AppendFile(LPCWSTR path, DWORD payload)
+{
+	if (payload != POST_PACK_COMPOUND && payload != POST_PACK_STREAMS)
+		return E_INVALIDARG;
+
+	HRESULT hr;
+	CAtlFile file;
+	if (FAILED(hr = file.Create(path, GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN)))
+		return hr;
+	ULONGLONG size;
+	if (FAILED(hr = file.GetSize(size)))
+		return hr;
+	if (size == 0)
+		return POST_PACK_E_CORRUPT;
+	if (size > MAX_POST_SIZE)
+		return HRESULT_FROM_WIN32(ERROR_FILE_TOO_LARGE);
+	FILETIME date;
+	if (!GetFileTime(file, NULL, NULL, &date))
+		return HRESULT_FROM_WIN32(GetLastError());
+
+	CAtlArray<BYTE> contents;
+	if (!contents.SetCount((size_t)size))
+		return E_OUTOFMEMORY;
+	DWORD bytesRead = 0;
+	if (FAILED(hr = file.Read(contents.GetData(), (DWORD)size, bytesRead)))
+		return hr;
+	if (bytesRead != size)
+		return HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
+
+	// the ids come out of the decoded streams, whichever payload is stored
+	CAtlArray<BYTE> decoded;
+	DWORD elementCount;
+	try
+	{
+		PostFileDecoder decoder;
+		if (!decoder.Open(contents.GetData(), contents.GetCount(), payload == POST_PACK_STREAMS ? ULLONG_MAX : IDENTITY_STREAM_LENGTH))
+			return POST_PACK_E_CORRUPT;
+		if (!decoded.SetCount(sizeof(PostPackStreamsHeader) + decoder.GetLength()))
+			return E_OUTOFMEMORY;
+		elementCount = (DWORD)decoder.GetElementCount();
+		if (!decoder.Write(decoded.GetData() + sizeof(PostPackStreamsHeader)))
+			return POST_PACK_E_CORRUPT;
+	}
+	catch (std::bad_alloc&)
+	{
+		return E_OUTOFMEMORY;
+	}
+	PostPackStreamsHeader *streams = reinterpret_cast<PostPackStreamsHeader*>(decoded.GetData());
+	streams->elementCount = elementCount;
+	streams->unused = 0;
+
+	CStringW blogId, postId;
+	const BYTE *elements = decoded.GetData() + sizeof(PostPackStreamsHeader);
+	ULONGLONG decodedSize = decoded.GetCount() - sizeof(PostPackStreamsHeader);
+	if (FAILED(hr = PostPackReader::ReadDecodedString(elements, decodedSize, elementCount, POST_ID, postId))
+		|| FAILED(hr = PostPackReader::ReadDecodedString(elements, decodedSize, elementCount, POST_DESTINATION_BLOG_ID, blogId)))
+		return hr;
+	if (postId.IsEmpty())
+	{
+		postId = PathFindFileNameW(path);
+		int extension = postId.ReverseFind(L'.');
+		if (extension > 0)
+			postId.Truncate(extension);
+	}
+
+	if (payload == POST_PACK_STREAMS)
+		return Append(blogId, postId, date, payload, decoded.GetData(), decoded.GetCount());
+	return Append(blogId, postId, date, payload, contents.GetData(), contents.GetCount());
+}
+
+HRESULT PostPackWriter::Append(const CStringW &blogId, const CStringW &postId, const FILETIME &date, DWORD payload, const void *data, ULONGLONG size)
+{
+	HRESULT hr;
+
+	PostPackRecordHeader header;
+	header.magic = POST_PACK_RECORD_MAGIC;
+	header.payload = payload;
+	header.date = date;
+	header.blogIdLength = blogId.GetLength();
+	header.postIdLength = postId.GetLength();
+	header.payloadSize = size;
+
+	ULONGLONG recordOffset = m_offset;
+	ULONGLONG idsSize = ((ULONGLONG)header.blogIdLength + header.postIdLength) * sizeof(WCHAR);
+	if (FAILED(hr = Write(&header, sizeof(header)))
+		|| FAILED(hr = Write(blogId.GetString(), header.blogIdLength * sizeof(WCHAR)))
+		|| FAILED(hr = Write(postId.GetString(), header.postIdLength * sizeof(WCHAR)))
+		|| FAILED(hr = Write(PADDING, PostPackAlign(idsSize) - idsSize))
+		|| FAILED(hr = Write(data, size))
+		|| FAILED(hr = Write(PADDING, PostPackAlign(size) - size)))
+		return hr;
+
+	AddPost(blogId, postId, date, recordOffset, m_offset - recordOffset);
+	return S_OK;
+}
+
+int __cdecl PostPackWriter::CompareIds(const void *post1, const void *post2)
+{
+	const Post *p1 = *static_cast<const Post* const*>(post1);
+	const Post *p2 = *static_cast<const Post* const*>(post2);
+	return ComparePostPackIds(p1->blogId, p1->blogId.GetLength(), p1->postId, p1->postId.GetLength(),
+		p2->blogId, p2->blogId.GetLength(), p2->postId, p2->postId.GetLength());
+}
+
+// orders entries by date, and posts with the same date by their ids
+int __cdecl PostPackWriter::CompareDates(void *posts, const void *entry1, const void *entry2)
+{
+	const Post *const *sorted = static_cast<const Post* const*>(posts);
+	DWORD e1 = *static_cast<const DWORD*>(entry1);
+	DWORD e2 = *static_cast<const DWORD*>(entry2);
+	LONG result = CompareFileTime(&sorted[e1]->date, &sorted[e2]->date);
+	if (result == 0)
+		result = e1 < e2 ? -1 : e1 > e2 ? 1 : 0;
+	return result;
+}
+
+HRESULT PostPackWriter::Close(void)
+{
+	HRESULT hr;
+
+	DWORD count = (DWORD)m_posts.GetCount();
+	CAtlArray<const Post*> sorted;
+	CAtlArray<DWORD> byDate;
+	CAtlArray<PostPackIndexEntry> entries;
+	if (!sorted.SetCount(count) || !byDate.SetCount(count) || !entries.SetCount(count))
+		return E_OUTOFMEMORY;
+	for (DWORD i = 0; i < count; i++)
+	{
+		sorted[i] = &m_posts[i];
+		byDate[i] = i;
+	}
+	if (count)
+	{
+		qsort(sorted.GetData(), count, sizeof(const Post*), CompareIds);
+		qsort_s(byDate.GetData(), count, sizeof(DWORD), CompareDates, sorted.GetData());
+	}
+
+	// a blog's id is written once, however many posts it has
+	CStringW ids;
+	DWORD blogIdOffset = 0;
+	for (DWORD i = 0; i < count; i++)
+	{
+		const Post &post = *sorted[i];
+		if (i == 0 || post.blogId != sorted[i - 1]->blogId)
+		{
+			blogIdOffset = ids.GetLength();
+			ids += post.blogId;
+		}
+
+		PostPackIndexEntry &entry = entries[i];
+		entry.recordOffset = post.recordOffset;
+		entry.recordSize = post.recordSize;
+		entry.date = post.date;
+		entry.blogIdOffset = blogIdOffset;
+		entry.blogIdLength = post.blogId.GetLength();
+		entry.postIdOffset = ids.GetLength();
+		entry.postIdLength = post.postId.GetLength();
+		ids += post.postId;
+	}
+
+	PostPackIndexHeader header;
+	header.magic = POST_PACK_INDEX_MAGIC;
+	header.entryCount = count;
+	header.idLength = ids.GetLength();
+
+	PostPackTrailer trailer;
+	trailer.indexOffset = m_offset;
+	trailer.version = POST_PACK_VERSION;
+	trailer.magic = POST_PACK_MAGIC;
+
+	ULONGLONG byDateSize = (ULONGLONG)count * sizeof(DWORD);
+	ULONGLONG idsSize = (ULONGLONG)ids.GetLength() * sizeof(WCHAR);
+	if (FAILED(hr = Write(&header, sizeof(header)))
+		|| FAILED(hr = Write(entries.GetData(), (ULONGLONG)count * sizeof(PostPackIndexEntry)))
+		|| FAILED(hr = Write(byDate.GetData(), byDateSize))
+		|| FAILED(hr = Write(PADDING, PostPackAlign(byDateSize) - byDateSize))
+		|| FAILED(hr = Write(ids.GetString(), idsSize))
+		|| FAILED(hr = Write(PADDING, PostPackAlign(idsSize) - idsSize))
+		|| FAILED(hr = Write(&trailer, sizeof(trailer)))
+		|| FAILED(hr = Flush()))
+		return hr;
+
+	m_file.Close();
+	return S_OK;
+}
+
+HRESULT PostPackWriter::Write(const void *data, ULONGLONG cb)
+{
+	HRESULT hr;
+	if (m_buffer.IsEmpty() && !m_buffer.SetCount(BUFFER_SIZE))
+		return E_OUTOFMEMORY;
+
+	m_offset += cb;
+	if (cb > BUFFER_SIZE - m_buffered)
+	{
+		if (FAILED(hr = Flush()))
+			return hr;
+
+		// large payloads go straight to the file
+		const BYTE *p = static_cast<const BYTE*>(data);
+		while (cb >= BUFFER_SIZE)
+		{
+			DWORD chunk = (DWORD)min(cb, (ULONGLONG)0x40000000);
+			if (FAILED(hr = m_file.Write(p, chunk)))
+				return hr;
+			p += chunk;
+			cb -= chunk;
+		}
+		data = p;
+	}
+	memcpy(m_buffer.GetData() + m_buffered, data, (size_t)cb);
+	m_buffered += (size_t)cb;
+	return S_OK;
+}
+
+HRESULT PostPackWriter::Flush(void)
+{
+	HRESULT hr;
+	if (m_buffered && FAILED(hr = m_file.Write(m_buffer.GetData(), (DWORD)m_buffered)))
+		return hr;
+	m_buffered = 0;
+	return S_OK;
+}
+
+HRESULT PostPackWriter::Repack(LPCWSTR path, ULONGLONG *sizeBefore, ULONGLONG *sizeAfter)
+{
+	HRESULT hr;
+	CStringW temporary = CStringW(path) + L".repack";
+	{
+		PostPackReader reader;
+		hr = reader.Open(path);
+		if (hr == POST_PACK_E_CORRUPT)
+		{
+			// opening the pack to append recovers what the last batch left behind
+			PostPackWriter writer;
+			if (FAILED(hr = writer.Open(path)) || FAILED(hr = writer.Close()))
+				return hr;
+			hr = reader.Open(path);
+		}
+		if (FAILED(hr))
+			return hr;
+		*sizeBefore = reader.GetFileSize();
+
+		if (FAILED(hr = CopyLiveRecords(reader, temporary, sizeAfter)))
+		{
+			DeleteFileW(temporary);
+			return hr;
+		}
+	}
+
+	// the reader has let go of the pack, so it can be replaced
+	if (!MoveFileExW(temporary, path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+	{
+		hr = HRESULT_FROM_WIN32(GetLastError());
+		DeleteFileW(temporary);
+		return hr;
+	}
+	return S_OK;
+}
+
+HRESULT PostPackWriter::CopyLiveRecords(const PostPackReader &reader, LPCWSTR path, ULONGLONG *size)
+{
+	HRESULT hr;
+
+	// whatever an earlier repack left behind
+	DeleteFileW(path);
+	PostPackWriter writer;
+	if (FAILED(hr = writer.Open(path)))
+		return hr;
+	for (DWORD entry = 0; entry < reader.GetCount(); entry++)
+	{
+		PostPackEntry post;
+		reader.GetEntry(entry, post);
+		DWORD payload;
+		const BYTE *data;
+		ULONGLONG payloadSize;
+		if (FAILED(hr = reader.GetPayload(entry, &payload, &data, &payloadSize))
+			|| FAILED(hr = writer.Append(CStringW(post.blogId, post.blogIdLength), CStringW(post.postId, post.postIdLength),
+				post.date, payload, data, payloadSize)))
+			return hr;
+	}
+	if (FAILED(hr = writer.Close()))
+		return hr;
+	*size = writer.GetFileSize();
+	return S_OK;
+}
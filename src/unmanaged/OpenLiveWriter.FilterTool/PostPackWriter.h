@@ -0,0 +1,70 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+#include "PostPackFormat.h"
+
+class PostPackReader;
+
+/*
+Appends posts to a pack (see PostPackFormat.h), creating it if there isn't
+one. The posts already in the pack come from its index or, if its last batch
+of appends was cut short, from walking its records, in which case whatever
+follows the last whole record is cut off. Close writes the index of every
+post, old and new, and the trailer that makes it the pack's index.
+
+Records are collected in a buffer and written a megabyte at a time; the
+posts are kept in memory, ids and all, until the index is written.
+*/
+class PostPackWriter
+{
+public:
+	PostPackWriter(void);
+	~PostPackWriter(void);
+
+	HRESULT Open(LPCWSTR path);
+	// Appends the .wpost file at path, as it is or decoded into its streams. A
+	// post that has never been posted has no id, so it goes by its file name.
+	HRESULT AppendFile(LPCWSTR path, DWORD payload);
+	HRESULT Append(const CStringW &blogId, const CStringW &postId, const FILETIME &date, DWORD payload, const void *data, ULONGLONG size);
+	HRESULT Close(void);
+
+	ULONGLONG GetFileSize(void) const { return m_offset; }
+	// the size of the latest record of every post, which a repack keeps
+	ULONGLONG GetLiveBytes(void) const { return m_liveBytes; }
+
+	// Copies the live records of the pack at path into a new pack, in index
+	// order, and replaces the pack with it.
+	static HRESULT Repack(LPCWSTR path, ULONGLONG *sizeBefore, ULONGLONG *sizeAfter);
+
+private:
+	static const size_t BUFFER_SIZE = 0x100000;
+	// enough for the id streams, which is all a COMPOUND payload needs decoded
+	static const ULONGLONG IDENTITY_STREAM_LENGTH = 0x1000;
+	static const ULONGLONG MAX_POST_SIZE = 0x40000000;
+
+	struct Post
+	{
+		CStringW blogId;
+		CStringW postId;
+		FILETIME date;
+		ULONGLONG recordOffset;
+		ULONGLONG recordSize;
+	};
+
+	HRESULT Recover(ULONGLONG size);
+	void AddPost(const CStringW &blogId, const CStringW &postId, const FILETIME &date, ULONGLONG recordOffset, ULONGLONG recordSize);
+	HRESULT Write(const void *data, ULONGLONG cb);
+	HRESULT Flush(void);
+	static HRESULT CopyLiveRecords(const PostPackReader &reader, LPCWSTR path, ULONGLONG *size);
+	static int __cdecl CompareIds(const void *post1, const void *post2);
+	static int __cdecl CompareDates(void *posts, const void *entry1, const void *entry2);
+
+	CAtlFile m_file;
+	ULONGLONG m_offset;
+	CAtlArray<Post> m_posts;
+	CAtlMap<CStringW, size_t, CStringElementTraits<CStringW> > m_postsByKey;
+	ULONGLONG m_liveBytes;
+	CAtlArray<BYTE> m_buffer;
+	size_t m_buffered;
+};
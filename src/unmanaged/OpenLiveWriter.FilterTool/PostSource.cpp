@@ -0,0 +1,88 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "stdafx.h"
+#include "PostSource.h"
+
+bool PostSource::IsPack(const CString &target)
+{
+	return CString(PathFindExtension(target)).CompareNoCase(_T(".olwpack")) == 0;
+}
+
+HRESULT PostSource::FindPosts(const CString &target, CAtlArray<CString> &files)
+{
+	DWORD attributes = GetFileAttributes(target);
+	if (attributes == INVALID_FILE_ATTRIBUTES)
+	{
+		HRESULT hr = HRESULT_FROM_WIN32(GetLastError());
+		fwprintf(stderr, L"Can't find %s\n", (LPCWSTR)target);
+		return hr;
+	}
+
+	if (attributes & FILE_ATTRIBUTE_DIRECTORY)
+	{
+		WIN32_FIND_DATA findData;
+		HANDLE hFind = FindFirstFile(target + _T("\\*.wpost"), &findData);
+		if (hFind != INVALID_HANDLE_VALUE)
+		{
+			do
+			{
+				if (!(findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+					files.Add(target + _T("\\") + findData.cFileName);
+			} while (FindNextFile(hFind, &findData));
+			FindClose(hFind);
+		}
+	}
+	else
+	{
+		files.Add(target);
+	}
+	return S_OK;
+}
+
+HRESULT PostSource::Open(const CString &target)
+{
+	m_isPack = IsPack(target);
+	if (!m_isPack)
+		return FindPosts(target, m_files);
+
+	HRESULT hr = m_pack.Open(target);
+	if (FAILED(hr))
+		fwprintf(stderr, L"Can't open %s\n", (LPCWSTR)target);
+	return hr;
+}
+
+CString PostSource::GetName(size_t post) const
+{
+	if (!m_isPack)
+		return m_files[post];
+
+	PostPackEntry entry;
+	m_pack.GetEntry((DWORD)post, entry);
+	return CString(CStringW(entry.blogId, entry.blogIdLength) + L"/" + CStringW(entry.postId, entry.postIdLength));
+}
+
+HRESULT PostSource::Extract(size_t post, ExtractedPost &extracted) const
+{
+	if (!m_isPack)
+		return PostExtractor::Extract(m_files[post], extracted);
+
+	HRESULT hr;
+	CComPtr<IStream> stream;
+	if (FAILED(hr = m_pack.OpenStream((DWORD)post, &stream)))
+		return hr;
+	extracted.path = GetName(post);
+	return PostExtractor::Extract(stream, extracted);
+}
+
+HRESULT PostSource::ReadIdentity(size_t post, CStringW &id, CStringW &blogId) const
+{
+	if (!m_isPack)
+		return PostExtractor::ReadIdentity(m_files[post], id, blogId);
+
+	PostPackEntry entry;
+	m_pack.GetEntry((DWORD)post, entry);
+	id.SetString(entry.postId, entry.postIdLength);
+	blogId.SetString(entry.blogId, entry.blogIdLength);
+	return S_OK;
+}
@@ -0,0 +1,38 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+#include "PostExtractor.h"
+#include "PostPackReader.h"
+
+/*
+The posts a batch command works through: the .wpost files in a directory, a
+single .wpost file, or the posts in a pack (.olwpack). Posts in a pack are
+filtered straight out of the mapped pack, and their ids come from its index
+rather than from opening each post.
+*/
+class PostSource
+{
+public:
+	PostSource(void) : m_isPack(false)
+	{
+	}
+
+	HRESULT Open(const CString &target);
+
+	size_t GetCount(void) const { return m_isPack ? m_pack.GetCount() : m_files.GetCount(); }
+	// the file's path, or the post's blog id and id
+	CString GetName(size_t post) const;
+	HRESULT Extract(size_t post, ExtractedPost &extracted) const;
+	HRESULT ReadIdentity(size_t post, CStringW &id, CStringW &blogId) const;
+
+	// Lists the .wpost files in target if it is a directory, or target itself.
+	static HRESULT FindPosts(const CString &target, CAtlArray<CString> &files);
+
+	static bool IsPack(const CString &target);
+
+private:
+	CAtlArray<CString> m_files;
+	PostPackReader m_pack;
+	bool m_isPack;
+};
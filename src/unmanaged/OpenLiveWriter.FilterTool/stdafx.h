@@ -0,0 +1,56 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+// stdafx.h : include file for standard system include files,
+// or project specific include files that are used frequently,
+// but are changed infrequently
+
+#pragma once
+
+#ifndef STRICT
+#define STRICT
+#endif
+
+// The drafts watcher relies on condition variables and CancelIoEx.
+#ifndef WINVER
+#define WINVER 0x0600
+#endif
+
+#ifndef _WIN32_WINNT
+#define _WIN32_WINNT 0x0600
+#endif
+
+#ifndef _WIN32_IE
+#define _WIN32_IE 0x0600
+#endif
+
+#define _ATL_NO_AUTOMATIC_NAMESPACE
+
+#define _ATL_CSTRING_EXPLICIT_CONSTRUCTORS	// some CString constructors will be explicit
+
+// turns off ATL's hiding of some common and often safely ignored warning messages
+#define _ATL_ALL_WARNINGS
+
+#include <stdio.h>
+#include <atlbase.h>
+#include <atlcom.h>
+#include <atlstr.h>
+#include <atlfile.h>
+#include <atlcoll.h>
+
+using namespace ATL;
+
+#include <filter.h>
+#include <filterr.h>
+
+// Shell
+#include <shlobj.h>
+#include <shlwapi.h>
+
+// Use safe strings
+#include <strsafe.h>
+
+#include "HResultException.h"
+#include "LogFile.h"
+
+#include "ApplicationConstants.h"
@@ -0,0 +1,677 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+// Plain exports of native helpers for the managed code to P/Invoke. They
+// don't throw, and memory they return is allocated with CoTaskMemAlloc.
+
+#include "stdafx.h"
+#include "Base64Encoder.h"
+#include "HtmlDiff.h"
+#include "HtmlReferenceRewriter.h"
+#include "HtmlTokenizer.h"
+#include "ImageHeaderReader.h"
+#include "ImageResampler.h"
+#include "PostFileDecoder.h"
+#include "SpellingDictionary.h"
+#include "ThumbnailCache.h"
+
+/*
+Replaces the references in html that are in from with the references at the
+same index in to (see HtmlReferenceRewriter). Returns S_FALSE and NULL if
+nothing was replaced.
+*/
+extern "C" HRESULT __stdcall RewriteHtmlReferences(
+	LPCWSTR html,
+	int htmlLength,
+	LPCWSTR* from,
+	LPCWSTR* to,
+	int mappingCount,
+	LPWSTR* result,
+	int* resultLength
+	)
+{
+	if (result == NULL || resultLength == NULL || mappingCount < 0 || (mappingCount > 0 && (from == NULL || to == NULL)))
+		return E_INVALIDARG;
+
+	try
+	{
+		HtmlReferenceRewriter rewriter;
+		for (int i = 0; i < mappingCount; i++)
+		{
+			if (from[i] == NULL || to[i] == NULL)
+				return E_INVALIDARG;
+			rewriter.AddMapping(from[i], lstrlenW(from[i]), to[i], lstrlenW(to[i]));
+		}
+		return rewriter.Rewrite(html, htmlLength, result, resultLength);
+	}
+	catch (CAtlException& e)
+	{
+		return e;
+	}
+}
+
+/*
+Tokenizes html from *position (see HtmlTokenizer) until the arrays are full,
+leaving *position where the next call carries on. Returns S_OK once the end
+is reached, S_FALSE if there is more, and
+HRESULT_FROM_WIN32(ERROR_INSUFFICIENT_BUFFER) if a tag doesn't fit at all.
+*/
+extern "C" HRESULT __stdcall TokenizeHtml(
+	LPCWSTR html,
+	int htmlLength,
+	int* position,
+	HtmlToken* tokens,
+	int tokenCapacity,
+	int* tokenCount,
+	HtmlTokenAttribute* attributes,
+	int attributeCapacity,
+	int* attributeCount
+	)
+{
+	if (html == NULL || htmlLength < 0 || position == NULL || *position < 0 || *position > htmlLength
+		|| tokens == NULL || tokenCount == NULL || attributes == NULL || attributeCount == NULL)
+		return E_INVALIDARG;
+
+	HtmlTokenizer tokenizer(html, htmlLength);
+	tokenizer.SetPosition(*position);
+	*tokenCount = tokenizer.Next(tokens, tokenCapacity, attributes, attributeCapacity, attributeCount);
+	if (*tokenCount < 0)
+	{
+		*tokenCount = 0;
+		*attributeCount = 0;
+		return HRESULT_FROM_WIN32(ERROR_INSUFFICIENT_BUFFER);
+	}
+
+	*position = tokenizer.GetPosition();
+	return tokenizer.IsDone() ? S_OK : S_FALSE;
+}
+
+/*
+A spelling dictionary (see SpellingDictionary.h) and the read-only mapping of
+the file it lies in, which is what OpenSpellingDictionary hands out.
+*/
+class MappedSpellingDictionary
+{
+public:
+	HRESULT Open(LPCWSTR path)
+	{
+		HRESULT hr;
+
+		CAtlFile file;
+		if (FAILED(hr = file.Create(path, GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS)))
+			return hr;
+		ULONGLONG size;
+		if (FAILED(hr = file.GetSize(size)))
+			return hr;
+		if (size < sizeof(SpellingDictionaryHeader) || size > (SIZE_T)-1)
+			return HRESULT_FROM_WIN32(ERROR_FILE_CORRUPT);
+		if (FAILED(hr = m_mapping.MapFile(file)))
+			return hr;
+
+		if (!m_dictionary.Open(static_cast<const BYTE*>(m_mapping), (size_t)size))
+			return HRESULT_FROM_WIN32(ERROR_FILE_CORRUPT);
+		return S_OK;
+	}
+
+	const SpellingDictionary& GetDictionary() const
+	{
+		return m_dictionary;
+	}
+
+private:
+	CAtlFileMapping<BYTE> m_mapping;
+	SpellingDictionary m_dictionary;
+};
+
+/*
+Maps the compiled spelling dictionary at path into memory. The dictionary is
+used from any thread until CloseSpellingDictionary is called with it.
+*/
+extern "C" HRESULT __stdcall OpenSpellingDictionary(
+	LPCWSTR path,
+	void** dictionary
+	)
+{
+	if (path == NULL || dictionary == NULL)
+		return E_INVALIDARG;
+	*dictionary = NULL;
+
+	MappedSpellingDictionary* mapped = new (std::nothrow) MappedSpellingDictionary();
+	if (mapped == NULL)
+		return E_OUTOFMEMORY;
+
+	HRESULT hr = mapped->Open(path);
+	if (FAILED(hr))
+	{
+		delete mapped;
+		return hr;
+	}
+	*dictionary = mapped;
+	return S_OK;
+}
+
+extern "C" void __stdcall CloseSpellingDictionary(
+	void* dictionary
+	)
+{
+	delete static_cast<MappedSpellingDictionary*>(dictionary);
+}
+
+/*
+Checks a batch of words, the i-th being the lengths[i] characters of text at
+starts[i], writing the SpellCheckResult of each to results: Correct,
+Capitalization or Misspelled.
+*/
+extern "C" HRESULT __stdcall CheckSpelling(
+	void* dictionary,
+	LPCWSTR text,
+	int textLength,
+	const int* starts,
+	const int* lengths,
+	int count,
+	BYTE* results
+	)
+{
+	if (dictionary == NULL || text == NULL || count < 0 || (count > 0 && (starts == NULL || lengths == NULL || results == NULL)))
+		return E_INVALIDARG;
+	for (int i = 0; i < count; i++)
+	{
+		if (starts[i] < 0 || lengths[i] < 0 || starts[i] > textLength || lengths[i] > textLength - starts[i])
+			return E_INVALIDARG;
+	}
+
+	static_cast<MappedSpellingDictionary*>(dictionary)->GetDictionary().CheckWords(text, starts, lengths, count, results);
+	return S_OK;
+}
+
+/*
+Finds up to maxSuggestions words close to a misspelling, closest first, and
+returns them separated by null characters. Returns S_FALSE and NULL if there
+are none.
+*/
+extern "C" HRESULT __stdcall SuggestSpelling(
+	void* dictionary,
+	LPCWSTR word,
+	int length,
+	int maxSuggestions,
+	LPWSTR* result,
+	int* resultLength
+	)
+{
+	const int MAX_SUGGESTIONS = 32;
+	if (dictionary == NULL || word == NULL || length < 0 || result == NULL || resultLength == NULL)
+		return E_INVALIDARG;
+	*result = NULL;
+	*resultLength = 0;
+
+	const SpellingDictionary& spelling = static_cast<MappedSpellingDictionary*>(dictionary)->GetDictionary();
+	SpellingSuggestion suggestions[MAX_SUGGESTIONS];
+	size_t count = spelling.Suggest(word, length, suggestions, min(max(maxSuggestions, 0), MAX_SUGGESTIONS));
+	if (count == 0)
+		return S_FALSE;
+
+	// measure, then copy the words into one allocation
+	size_t total = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		size_t wordLength;
+		spelling.GetWord(suggestions[i].word, &wordLength);
+		total += wordLength + 1;
+	}
+
+	LPWSTR buffer = static_cast<LPWSTR>(CoTaskMemAlloc(total * sizeof(WCHAR)));
+	if (buffer == NULL)
+		return E_OUTOFMEMORY;
+
+	LPWSTR next = buffer;
+	for (size_t i = 0; i < count; i++)
+	{
+		size_t wordLength;
+		const SpellingChar* spellingWord = spelling.GetWord(suggestions[i].word, &wordLength);
+		memcpy(next, spellingWord, wordLength * sizeof(WCHAR));
+		next += wordLength;
+		*next++ = 0;
+	}
+
+	*result = buffer;
+	*resultLength = (int)total - 1;
+	return S_OK;
+}
+
+/*
+Resizes a bitmap's pixels, 3 (BGR) or 4 (BGRA) bytes of them per pixel, into
+another's with an ImageResampleFilter (see ImageResampler).
+*/
+extern "C" HRESULT __stdcall ResampleImage(
+	const BYTE* source,
+	int sourceWidth,
+	int sourceHeight,
+	int sourceStride,
+	BYTE* destination,
+	int destinationWidth,
+	int destinationHeight,
+	int destinationStride,
+	int channels,
+	int filter
+	)
+{
+	try
+	{
+		if (!ImageResampler::Resample(source, sourceWidth, sourceHeight, sourceStride,
+			destination, destinationWidth, destinationHeight, destinationStride, channels, (ImageResampleFilter)filter))
+			return E_INVALIDARG;
+	}
+	catch (std::bad_alloc&)
+	{
+		return E_OUTOFMEMORY;
+	}
+	return S_OK;
+}
+
+/*
+Encodes sourceLength bytes as base64 characters, one byte each, into
+destination, which has room for (sourceLength + 2) / 3 * 4 of them. A stream
+can be encoded a block at a time if every block but the last is a multiple
+of 3 bytes long.
+*/
+extern "C" HRESULT __stdcall EncodeBase64(
+	const BYTE* source,
+	int sourceLength,
+	BYTE* destination,
+	int destinationCapacity,
+	int* destinationLength
+	)
+{
+	if (source == NULL || sourceLength < 0 || destination == NULL || destinationLength == NULL)
+		return E_INVALIDARG;
+	if (Base64Encoder::EncodedLength(sourceLength) > (ULONGLONG)max(destinationCapacity, 0))
+		return HRESULT_FROM_WIN32(ERROR_INSUFFICIENT_BUFFER);
+
+	*destinationLength = (int)Base64Encoder::Encode(source, sourceLength, reinterpret_cast<char*>(destination));
+	return S_OK;
+}
+
+/*
+Called by ReadImageHeaders for up to count bytes of an image at offset,
+returning how many it wrote to buffer, or -1 if it couldn't read them.
+*/
+typedef int (__stdcall *ImageHeaderReadCallback)(int image, LONGLONG offset, BYTE* buffer, int count);
+
+class CallbackImageHeaderSource : public ImageHeaderSource
+{
+public:
+	CallbackImageHeaderSource(ImageHeaderReadCallback read, int image)
+		: m_read(read), m_image(image)
+	{
+	}
+
+	virtual size_t ReadAt(uint64_t offset, uint8_t* buffer, size_t count)
+	{
+		int read = m_read(m_image, (LONGLONG)offset, buffer, (int)count);
+		return read > 0 ? min((size_t)read, count) : 0;
+	}
+
+private:
+	ImageHeaderReadCallback m_read;
+	int m_image;
+};
+
+/*
+Reads the headers of count images, each through read a few KB at a time,
+into headers (see ImageHeaderReader). An image whose format isn't known or
+whose headers don't make sense gets IMAGE_HEADER_UNKNOWN.
+*/
+extern "C" HRESULT __stdcall ReadImageHeaders(
+	int count,
+	ImageHeaderReadCallback read,
+	ImageHeader* headers
+	)
+{
+	if (count < 0 || read == NULL || (count > 0 && headers == NULL))
+		return E_INVALIDARG;
+
+	for (int i = 0; i < count; i++)
+	{
+		CallbackImageHeaderSource source(read, i);
+		ImageHeaderReader::Read(source, &headers[i]);
+	}
+	return S_OK;
+}
+
+/*
+A thumbnail cache (see ThumbnailCache.h), the read-write mapping of the file it
+lies in and the lock that lets any number of threads find thumbnails in it at
+once while one stores. This is what OpenThumbnailCache hands out. The file
+isn't shared, so the cache belongs to one process at a time.
+*/
+class MappedThumbnailCache
+{
+public:
+	MappedThumbnailCache()
+	{
+		InitializeSRWLock(&m_lock);
+	}
+
+	~MappedThumbnailCache()
+	{
+		if (m_mapping.GetData() != NULL)
+		{
+			m_cache.Close();
+			m_mapping.Flush();
+		}
+	}
+
+	HRESULT Open(LPCWSTR path, ULONGLONG size)
+	{
+		HRESULT hr;
+
+		if (size < THUMBNAIL_CACHE_MIN_SIZE || size > (SIZE_T)-1)
+			return E_INVALIDARG;
+		if (FAILED(hr = m_file.Create(path, GENERIC_READ | GENERIC_WRITE, 0, OPEN_ALWAYS, FILE_FLAG_RANDOM_ACCESS)))
+			return hr;
+		ULONGLONG currentSize;
+		if (FAILED(hr = m_file.GetSize(currentSize)))
+			return hr;
+		if (currentSize != size && FAILED(hr = m_file.SetSize(size)))
+			return hr;
+		if (FAILED(hr = m_mapping.MapFile(m_file, 0, 0, PAGE_READWRITE, FILE_MAP_WRITE)))
+			return hr;
+
+		if (!m_cache.Open(m_mapping.GetData(), size))
+			return HRESULT_FROM_WIN32(ERROR_FILE_CORRUPT);
+		return S_OK;
+	}
+
+	bool Find(const BYTE* hash, UINT requestedWidth, UINT requestedHeight, UINT* width, UINT* height, BYTE* pixels)
+	{
+		bool found;
+		bool store;
+		AcquireSRWLockShared(&m_lock);
+		found = m_cache.Find(hash, requestedWidth, requestedHeight, width, height, pixels, &store);
+		ReleaseSRWLockShared(&m_lock);
+
+		// keep it from being evicted, from the copy, now that it's being used
+		if (found && store)
+			Store(hash, requestedWidth, requestedHeight, *width, *height, pixels, *width * 4);
+		return found;
+	}
+
+	bool Store(const BYTE* hash, UINT requestedWidth, UINT requestedHeight, UINT width, UINT height, const BYTE* pixels, size_t stride)
+	{
+		AcquireSRWLockExclusive(&m_lock);
+		bool stored = m_cache.Store(hash, requestedWidth, requestedHeight, width, height, pixels, stride);
+		ReleaseSRWLockExclusive(&m_lock);
+		return stored;
+	}
+
+private:
+	CAtlFile m_file;
+	CAtlFileMapping<BYTE> m_mapping;
+	SRWLOCK m_lock;
+	ThumbnailCache m_cache;
+};
+
+/*
+Maps the thumbnail cache at path into memory, creating it or emptying it if
+it isn't a cache of size bytes that was closed properly. The cache is used
+from any thread until CloseThumbnailCache is called with it. Fails with a
+sharing violation if another process has it open.
+*/
+extern "C" HRESULT __stdcall OpenThumbnailCache(
+	LPCWSTR path,
+	LONGLONG size,
+	void** cache
+	)
+{
+	if (path == NULL || size <= 0 || cache == NULL)
+		return E_INVALIDARG;
+	*cache = NULL;
+
+	MappedThumbnailCache* mapped = new (std::nothrow) MappedThumbnailCache();
+	if (mapped == NULL)
+		return E_OUTOFMEMORY;
+
+	HRESULT hr = mapped->Open(path, (ULONGLONG)size);
+	if (FAILED(hr))
+	{
+		delete mapped;
+		return hr;
+	}
+	*cache = mapped;
+	return S_OK;
+}
+
+extern "C" void __stdcall CloseThumbnailCache(
+	void* cache
+	)
+{
+	delete static_cast<MappedThumbnailCache*>(cache);
+}
+
+/*
+Finds the thumbnail made at requestedWidth x requestedHeight of the image whose
+SHA-256 is hash, copying its BGRA pixels, packed, to pixels (which has room
+for requestedWidth x requestedHeight of them) and its size to width and height.
+Returns S_FALSE if there is none.
+*/
+extern "C" HRESULT __stdcall FindThumbnail(
+	void* cache,
+	const BYTE* hash,
+	int requestedWidth,
+	int requestedHeight,
+	int* width,
+	int* height,
+	BYTE* pixels
+	)
+{
+	if (cache == NULL || hash == NULL || requestedWidth <= 0 || requestedHeight <= 0 || width == NULL || height == NULL || pixels == NULL)
+		return E_INVALIDARG;
+
+	UINT foundWidth, foundHeight;
+	if (!static_cast<MappedThumbnailCache*>(cache)->Find(hash, requestedWidth, requestedHeight, &foundWidth, &foundHeight, pixels))
+		return S_FALSE;
+	*width = (int)foundWidth;
+	*height = (int)foundHeight;
+	return S_OK;
+}
+
+/*
+Stores a thumbnail of width x height BGRA pixels, stride bytes apart, made at
+requestedWidth x requestedHeight (which it fits inside) of the image whose
+SHA-256 is hash. Returns S_FALSE if it's too large for the cache to keep.
+*/
+extern "C" HRESULT __stdcall StoreThumbnail(
+	void* cache,
+	const BYTE* hash,
+	int requestedWidth,
+	int requestedHeight,
+	int width,
+	int height,
+	const BYTE* pixels,
+	int stride
+	)
+{
+	if (cache == NULL || hash == NULL || requestedWidth <= 0 || requestedHeight <= 0 || width <= 0 || height <= 0 ||
+		width > requestedWidth || height > requestedHeight || pixels == NULL || stride < width * 4)
+		return E_INVALIDARG;
+
+	return static_cast<MappedThumbnailCache*>(cache)->Store(hash, requestedWidth, requestedHeight, width, height, pixels, stride) ? S_OK : S_FALSE;
+}
+
+/*
+Finds the changes that turn oldHtml into newHtml (see HtmlDiff), as hunkCount
+spans of characters in memory the caller frees with CoTaskMemFree, or NULL if
+there are none. flags can be HTML_DIFF_IGNORE_FORMATTING. Returns S_FALSE and
+no hunks if more than maxDifferences tokens differ.
+*/
+extern "C" HRESULT __stdcall DiffHtml(
+	LPCWSTR oldHtml,
+	int oldLength,
+	LPCWSTR newHtml,
+	int newLength,
+	int flags,
+	int maxDifferences,
+	HtmlDiffHunk** hunks,
+	int* hunkCount
+	)
+{
+	if (oldHtml == NULL || oldLength < 0 || newHtml == NULL || newLength < 0 || maxDifferences < 0 || hunks == NULL || hunkCount == NULL)
+		return E_INVALIDARG;
+	*hunks = NULL;
+	*hunkCount = 0;
+
+	try
+	{
+		std::vector<HtmlDiffHunk> found;
+		if (!HtmlDiff::Diff(oldHtml, oldLength, newHtml, newLength, flags, maxDifferences, found))
+			return S_FALSE;
+		if (found.empty())
+			return S_OK;
+
+		HtmlDiffHunk* buffer = static_cast<HtmlDiffHunk*>(CoTaskMemAlloc(found.size() * sizeof(HtmlDiffHunk)));
+		if (buffer == NULL)
+			return E_OUTOFMEMORY;
+		memcpy(buffer, &found[0], found.size() * sizeof(HtmlDiffHunk));
+		*hunks = buffer;
+		*hunkCount = (int)found.size();
+	}
+	catch (std::bad_alloc&)
+	{
+		return E_OUTOFMEMORY;
+	}
+	return S_OK;
+}
+
+/*
+Computes the signature of html (see HtmlDiff), which is the same for HTML
+that DiffHtml, with the same flags, finds no changes in.
+*/
+extern "C" HRESULT __stdcall GetHtmlSignature(
+	LPCWSTR html,
+	int length,
+	int flags,
+	ULONGLONG* signature
+	)
+{
+	if (html == NULL || length < 0 || signature == NULL)
+		return E_INVALIDARG;
+
+	try
+	{
+		*signature = HtmlDiff::Signature(html, length, flags);
+	}
+	catch (std::bad_alloc&)
+	{
+		return E_OUTOFMEMORY;
+	}
+	return S_OK;
+}
+
+/*
+A post file (.wpost) decoder (see PostFileDecoder) and the read-only mapping
+of the file it decodes, which is what OpenPostFile hands out, so that the
+caller can allocate the buffer ReadPostFile decodes into.
+*/
+class MappedPostFile
+{
+public:
+	HRESULT Open(LPCWSTR path, ULONGLONG maxStreamLength)
+	{
+		HRESULT hr;
+
+		CAtlFile file;
+		if (FAILED(hr = file.Create(path, GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN)))
+			return hr;
+		ULONGLONG size;
+		if (FAILED(hr = file.GetSize(size)))
+			return hr;
+		if (size == 0 || size > (SIZE_T)-1)
+			return S_FALSE;
+		if (FAILED(hr = m_mapping.MapFile(file)))
+			return hr;
+
+		if (!m_decoder.Open(static_cast<const BYTE*>(m_mapping), (size_t)size, (uint64_t)maxStreamLength))
+			return S_FALSE;
+		return S_OK;
+	}
+
+	const PostFileDecoder& GetDecoder() const
+	{
+		return m_decoder;
+	}
+
+private:
+	CAtlFileMapping<BYTE> m_mapping;
+	PostFileDecoder m_decoder;
+};
+
+/*
+Walks the directory of the post file at path in one pass, and says how long
+the buffer ReadPostFile decodes it into is, and how many elements start it.
+Streams longer than maxStreamLength are listed but not loaded. Returns
+S_FALSE and no file if it isn't a compound file the decoder can read;
+otherwise the file stays mapped until ClosePostFile is called with it.
+*/
+extern "C" HRESULT __stdcall OpenPostFile(
+	LPCWSTR path,
+	LONGLONG maxStreamLength,
+	void** postFile,
+	int* length,
+	int* elementCount
+	)
+{
+	if (path == NULL || maxStreamLength < 0 || postFile == NULL || length == NULL || elementCount == NULL)
+		return E_INVALIDARG;
+	*postFile = NULL;
+	*length = 0;
+	*elementCount = 0;
+
+	MappedPostFile* mapped = new (std::nothrow) MappedPostFile();
+	if (mapped == NULL)
+		return E_OUTOFMEMORY;
+
+	HRESULT hr;
+	try
+	{
+		hr = mapped->Open(path, (ULONGLONG)maxStreamLength);
+	}
+	catch (std::bad_alloc&)
+	{
+		hr = E_OUTOFMEMORY;
+	}
+	if (hr != S_OK)
+	{
+		delete mapped;
+		return hr;
+	}
+	*postFile = mapped;
+	*length = (int)mapped->GetDecoder().GetLength();
+	*elementCount = mapped->GetDecoder().GetElementCount();
+	return S_OK;
+}
+
+/*
+Decodes the post file straight into buffer, which is the length OpenPostFile
+said. Returns S_FALSE if a stream's sectors turn out to be damaged.
+*/
+extern "C" HRESULT __stdcall ReadPostFile(
+	void* postFile,
+	BYTE* buffer,
+	int length
+	)
+{
+	if (postFile == NULL || buffer == NULL)
+		return E_INVALIDARG;
+
+	const PostFileDecoder& decoder = static_cast<MappedPostFile*>(postFile)->GetDecoder();
+	if (length < 0 || (size_t)length != decoder.GetLength())
+		return E_INVALIDARG;
+	return decoder.Write(buffer) ? S_OK : S_FALSE;
+}
+
+extern "C" void __stdcall ClosePostFile(
+	void* postFile
+	)
+{
+	delete static_cast<MappedPostFile*>(postFile);
+}
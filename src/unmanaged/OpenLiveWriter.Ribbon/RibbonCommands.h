@@ -0,0 +1,536 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+// This file is automatically generated. DO NOT edit it manually.
+// Edit Ribbon.xml or CommandId.cs and run utilities\RibbonTableGenerator.
+
+#pragma once
+
+namespace RibbonCommands
+{
+	struct Range
+	{
+		unsigned short begin;
+		unsigned short end;
+	};
+
+	struct Command
+	{
+		unsigned int id;
+		const char *name;
+		const char *symbol;
+		const char *keytip;
+		const char *groupPath;
+	};
+
+	// command is an index into Commands, groups a range of Groups
+	struct Tab
+	{
+		unsigned short command;
+		Range groups;
+	};
+
+	// commands is a range of GroupCommands
+	struct Group
+	{
+		unsigned short command;
+		unsigned short tab;
+		Range commands;
+	};
+
+	constexpr unsigned int CommandCount = 301;
+	constexpr unsigned int TabCount = 10;
+	constexpr unsigned int GroupCount = 44;
+
+	// sorted by id
+	constexpr Command Commands[CommandCount] =
+	{
+		{ 1000, "cmdFontGroup", "cmdFontGroup", "ZF", "cmdHomeTab" },
+		{ 1001, "cmdFontFamily", "cmdFontFamily", "FF", "cmdHomeTab/cmdFontGroup" },
+		{ 1002, "cmdFontSize", "cmdFontSize", "FS", "cmdHomeTab/cmdFontGroup" },
+		{ 1003, "cmdClearFormatting", "cmdClearFormatting", "R", "cmdHomeTab/cmdFontGroup" },
+		{ 1005, "cmdSubscript", "cmdSubscript", "N", "cmdHomeTab/cmdFontGroup" },
+		{ 1006, "cmdSuperscript", "cmdSuperscript", "M", "cmdHomeTab/cmdFontGroup" },
+		{ 1007, "cmdStrikethrough", "cmdStrikethrough", "H", "cmdHomeTab/cmdFontGroup" },
+		{ 1008, "cmdUnderline", "cmdUnderline", "U", "cmdHomeTab/cmdFontGroup" },
+		{ 1009, "cmdItalic", "cmdItalic", "I", "cmdHomeTab/cmdFontGroup" },
+		{ 1010, "cmdBold", "cmdBold", "B", "cmdHomeTab/cmdFontGroup" },
+		{ 1013, "cmdFontColorPicker", "cmdFontColorPicker", "FC", "cmdHomeTab/cmdFontGroup" },
+		{ 1014, "cmdTextEditingGroup", "cmdTextEditingGroup", "ZE", "cmdHomeTab" },
+		{ 1015, "cmdCheckSpelling", "cmdCheckSpelling", "S", "cmdHomeTab/cmdTextEditingGroup" },
+		{ 1016, "cmdWordCount", "cmdWordCount", "W", "cmdHomeTab/cmdTextEditingGroup" },
+		{ 1017, "cmdFindButton", "cmdFindButton", "FD", "cmdHomeTab/cmdTextEditingGroup" },
+		{ 1018, "cmdFindAndReplace", "FindAndReplace", "", "" },
+		{ 1020, "cmdSemanticHtmlGroup", "cmdSemanticHtmlGroup", "ZS", "cmdHomeTab" },
+		{ 1021, "cmdSemanticHtmlGallery", "cmdSemanticHtmlGallery", "Y", "cmdHomeTab/cmdSemanticHtmlGroup" },
+		{ 1022, "cmdInsertHorizontalLine", "cmdInsertHorizontalLine", "L", "cmdInsertTab/cmdBreaksGroup" },
+		{ 1023, "cmdInsertLink", "cmdInsertLink", "K", "cmdHomeTab/cmdInsertGroup" },
+		{ 1024, "cmdViewPlainText", "ViewPlainText", "", "" },
+		{ 1025, "cmdFontBackgroundColor", "cmdFontBackgroundColor", "FH", "cmdHomeTab/cmdFontGroup" },
+		{ 1026, "cmdBullets", "cmdBullets", "L1", "cmdHomeTab/cmdParagraphGroup" },
+		{ 1027, "cmdNumbers", "cmdNumbers", "L2", "cmdHomeTab/cmdParagraphGroup" },
+		{ 1028, "cmdBlockquote", "cmdBlockquote", "Q", "cmdHomeTab/cmdParagraphGroup" },
+		{ 1029, "cmdAlignLeft", "cmdAlignLeft", "AL", "cmdHomeTab/cmdParagraphGroup" },
+		{ 1030, "cmdAlignRight", "cmdAlignRight", "AR", "cmdHomeTab/cmdParagraphGroup" },
+		{ 1031, "cmdAlignCenter", "cmdAlignCenter", "AC", "cmdHomeTab/cmdParagraphGroup" },
+		{ 1032, "cmdJustify", "cmdJustify", "AJ", "cmdHomeTab/cmdParagraphGroup" },
+		{ 1033, "cmdPaste", "cmdPaste", "", "cmdHomeTab/cmdClipboardGroup" },
+		{ 1035, "cmdCut", "cmdCut", "X", "cmdHomeTab/cmdClipboardGroup" },
+		{ 1036, "cmdCopyCommand", "cmdCopyCommand", "C", "cmdHomeTab/cmdClipboardGroup" },
+		{ 1037, "cmdPasteSpecial", "cmdPasteSpecial", "", "cmdHomeTab/cmdClipboardGroup" },
+		{ 1039, "cmdInsertClearBreak", "cmdInsertClearBreak", "B", "cmdInsertTab/cmdBreaksGroup" },
+		{ 1040, "cmdInsertPictureFromFile", "cmdInsertPictureFromFile", "", "cmdHomeTab/cmdInsertGroup" },
+		{ 1043, "cmdUndo", "cmdUndo", "", "" },
+		{ 1044, "cmdRedo", "cmdRedo", "", "" },
+		{ 1045, "cmdSelectAll", "cmdSelectAll", "AS", "cmdHomeTab/cmdTextEditingGroup" },
+		{ 1046, "cmdIndent", "Indent", "MI", "" },
+		{ 1047, "cmdOutdent", "Outdent", "MO", "" },
+		{ 1048, "cmdRTLTextBlock", "cmdRTLTextBlock", "R1", "cmdHomeTab/cmdParagraphGroup" },
+		{ 1049, "cmdLTRTextBlock", "cmdLTRTextBlock", "R2", "cmdHomeTab/cmdParagraphGroup" },
+		{ 1050, "cmdAlignmentGroup", "cmdAlignmentGroup", "ZA", "cmdImageContextTabGroup/cmdFormatImageTab" },
+		{ 1051, "cmdAlignmentGallery", "cmdAlignmentGallery", "", "cmdImageContextTabGroup/cmdFormatImageTab/cmdAlignmentGroup" },
+		{ 1052, "cmdMarginsGroup", "cmdMarginsGroup", "ZM", "cmdImageContextTabGroup/cmdFormatImageTab" },
+		{ 1053, "cmdAdjustTopMargin", "cmdAdjustTopMargin", "", "cmdImageContextTabGroup/cmdFormatImageTab/cmdMarginsGroup" },
+		{ 1054, "cmdAdjustBottomMargin", "cmdAdjustBottomMargin", "", "cmdImageContextTabGroup/cmdFormatImageTab/cmdMarginsGroup" },
+		{ 1055, "cmdAdjustLeftMargin", "cmdAdjustLeftMargin", "", "cmdImageContextTabGroup/cmdFormatImageTab/cmdMarginsGroup" },
+		{ 1056, "cmdAdjustRightMargin", "cmdAdjustRightMargin", "", "cmdImageContextTabGroup/cmdFormatImageTab/cmdMarginsGroup" },
+		{ 1057, "cmdVideoContextTabGroup", "cmdVideoContextTabGroup", "", "" },
+		{ 1058, "cmdFormatVideoTab", "cmdFormatVideoTab", "V", "cmdVideoContextTabGroup" },
+		{ 1059, "cmdFormatVideoGroup", "cmdFormatVideoGroup", "ZV", "cmdVideoContextTabGroup/cmdFormatVideoTab" },
+		{ 1060, "cmdVideoWebPreview", "cmdVideoWebPreview", "V", "cmdVideoContextTabGroup/cmdFormatVideoTab/cmdFormatVideoGroup" },
+		{ 1073, "cmdImageContextTabGroup", "cmdImageContextTabGroup", "IM", "" },
+		{ 1074, "cmdFormatImageTab", "cmdFormatImageTab", "P", "cmdImageContextTabGroup" },
+		{ 1075, "cmdFormatImageSizeGroup", "cmdFormatImageSizeGroup", "", "cmdImageContextTabGroup/cmdFormatImageTab" },
+		{ 1076, "cmdImageCrop", "cmdImageCrop", "C", "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageSizeGroup" },
+		{ 1077, "cmdFormatImageAdjustWidth", "cmdFormatImageAdjustWidth", "SW", "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageSizeGroup" },
+		{ 1078, "cmdFormatImageAdjustHeight", "cmdFormatImageAdjustHeight", "SH", "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageSizeGroup" },
+		{ 1079, "cmdCustomSizeGallery", "cmdCustomSizeGallery", "U", "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageSizeGroup" },
+		{ 1080, "cmdSetCustomSizeDefaults", "cmdSetCustomSizeDefaults", "", "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageSizeGroup" },
+		{ 1081, "cmdFormatImageLockAspectRatio", "cmdFormatImageLockAspectRatio", "L", "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageSizeGroup" },
+		{ 1082, "cmdFormatImageRotateGroup", "cmdFormatImageRotateGroup", "", "cmdImageContextTabGroup/cmdFormatImageTab" },
+		{ 1083, "cmdImageRotateCW", "cmdImageRotateCW", "RR", "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageRotateGroup" },
+		{ 1084, "cmdImageRotateCCW", "cmdImageRotateCCW", "RL", "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageRotateGroup" },
+		{ 1085, "cmdImageTilt", "cmdImageTilt", "RT", "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageRotateGroup" },
+		{ 1086, "cmdFormatImageStyleGroup", "cmdFormatImageStyleGroup", "", "cmdImageContextTabGroup/cmdFormatImageTab" },
+		{ 1087, "cmdImageBorderGallery", "cmdImageBorderGallery", "B", "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageStyleGroup" },
+		{ 1088, "cmdImageEffectsGallery", "cmdImageEffectsGallery", "E", "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageStyleGroup" },
+		{ 1089, "cmdImageEffectsRecolorGallery", "cmdImageEffectsRecolorGallery", "", "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageStyleGroup" },
+		{ 1090, "cmdImageEffectsSharpenGallery", "cmdImageEffectsSharpenGallery", "", "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageStyleGroup" },
+		{ 1091, "cmdImageEffectsBlurGallery", "cmdImageEffectsBlurGallery", "", "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageStyleGroup" },
+		{ 1092, "cmdImageEffectsEmbossGallery", "cmdImageEffectsEmbossGallery", "", "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageStyleGroup" },
+		{ 1093, "cmdImageContrast", "cmdImageContrast", "O", "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageStyleGroup" },
+		{ 1094, "cmdWatermark", "cmdWatermark", "W", "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageStyleGroup" },
+		{ 1095, "cmdFormatImagePropertiesGroup", "cmdFormatImagePropertiesGroup", "", "cmdImageContextTabGroup/cmdFormatImageTab" },
+		{ 1096, "cmdFormatImageSelectLink", "cmdFormatImageSelectLink", "KL", "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImagePropertiesGroup" },
+		{ 1097, "cmdFormatImageLinkOptions", "cmdFormatImageLinkOptions", "KK", "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImagePropertiesGroup" },
+		{ 1098, "cmdFormatImageAltText", "cmdFormatImageAltText", "T", "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImagePropertiesGroup" },
+		{ 1099, "cmdFormatImageSettingsGroup", "cmdFormatImageSettingsGroup", "", "cmdImageContextTabGroup/cmdFormatImageTab" },
+		{ 1100, "cmdFormatImageSaveSettings", "cmdFormatImageSaveSettings", "DS", "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageSettingsGroup" },
+		{ 1101, "cmdFormatImageRevertSettings", "cmdFormatImageRevertSettings", "DR", "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageSettingsGroup" },
+		{ 1102, "cmdInsertEmoticon", "cmdInsertEmoticon", "", "cmdInsertTab/cmdMediaGroup" },
+		{ 1103, "cmdCustomSizeSmall", "cmdCustomSizeSmall", "", "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageSizeGroup" },
+		{ 1104, "cmdCustomSizeMedium", "cmdCustomSizeMedium", "", "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageSizeGroup" },
+		{ 1105, "cmdCustomSizeLarge", "cmdCustomSizeLarge", "", "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageSizeGroup" },
+		{ 1106, "cmdCustomSizeOriginal", "cmdCustomSizeOriginal", "", "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImageSizeGroup" },
+		{ 1107, "cmdImageLinkToSource", "cmdImageLinkToSource", "", "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImagePropertiesGroup" },
+		{ 1108, "cmdImageLinkToUrl", "cmdImageLinkToUrl", "", "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImagePropertiesGroup" },
+		{ 1109, "cmdImageLinkToNone", "cmdImageLinkToNone", "", "cmdImageContextTabGroup/cmdFormatImageTab/cmdFormatImagePropertiesGroup" },
+		{ 1114, "cmdParagraphGroup", "cmdParagraphGroup", "ZP", "cmdHomeTab" },
+		{ 1115, "cmdVideoAspectRatioGroup", "cmdVideoAspectRatioGroup", "ZR", "cmdVideoContextTabGroup/cmdFormatVideoTab" },
+		{ 1116, "cmdVideoWidescreenAspectRatio", "cmdVideoWidescreenAspectRatio", "W", "cmdVideoContextTabGroup/cmdFormatVideoTab/cmdVideoAspectRatioGroup" },
+		{ 1117, "cmdVideoStandardAspectRatio", "cmdVideoStandardAspectRatio", "S", "cmdVideoContextTabGroup/cmdFormatVideoTab/cmdVideoAspectRatioGroup" },
+		{ 23010, "cmdFileMenu", "cmdFileMenu", "", "" },
+		{ 23020, "cmdClose", "cmdClose", "", "cmdFileMenu" },
+		{ 23031, "cmdImageBrightness", "ImageBrightness", "", "" },
+		{ 23033, "cmdWebImage", "cmdWebImage", "", "cmdHomeTab/cmdInsertGroup" },
+		{ 23040, "cmdClipboardGroup", "cmdClipboardGroup", "ZC", "cmdHomeTab" },
+		{ 23046, "cmdAddPlugin", "cmdAddPlugin", "PA", "cmdInsertTab/cmdPluginsGroup" },
+		{ 23047, "cmdManagePlugins", "cmdManagePlugins", "PM", "cmdInsertTab/cmdPluginsGroup" },
+		{ 23051, "cmdPasteSplit", "cmdPasteSplit", "V", "cmdHomeTab/cmdClipboardGroup" },
+		{ 23052, "cmdInsertImageSplit", "cmdInsertImageSplit", "E", "cmdHomeTab/cmdInsertGroup" },
+		{ 23053, "cmdInsertVideoSplit", "cmdInsertVideoSplit", "O", "cmdHomeTab/cmdInsertGroup" },
+		{ 23200, "cmdOptions", "cmdOptions", "", "cmdFileMenu" },
+		{ 23251, "cmdSplitNew", "cmdSplitNew", "", "cmdFileMenu" },
+		{ 23252, "cmdSplitSave", "cmdSplitSave", "", "cmdFileMenu" },
+		{ 23253, "cmdSplitPrint", "cmdSplitPrint", "", "cmdFileMenu" },
+		{ 23268, "cmdMRUList", "cmdMRUList", "", "cmdFileMenu" },
+		{ 23273, "cmdInsertMap", "cmdInsertMap", "M", "cmdInsertTab/cmdMediaGroup" },
+		{ 23274, "cmdInsertTags", "cmdInsertTags", "G", "cmdInsertTab/cmdMediaGroup" },
+		{ 23275, "cmdInsertVideoFromWeb", "cmdInsertVideoFromWeb", "", "cmdHomeTab/cmdInsertGroup" },
+		{ 23276, "cmdInsertVideoFromFile", "cmdInsertVideoFromFile", "", "cmdHomeTab/cmdInsertGroup" },
+		{ 23277, "cmdInsertVideoFromService", "cmdInsertVideoFromService", "", "cmdHomeTab/cmdInsertGroup" },
+		{ 23278, "cmdInsertTable", "cmdInsertTable", "T", "cmdInsertTab/cmdTablesGroup" },
+		{ 23295, "cmdNewPost", "cmdNewPost", "", "cmdFileMenu" },
+		{ 23296, "cmdNewPage", "cmdNewPage", "", "cmdFileMenu" },
+		{ 23297, "cmdSavePost", "cmdSavePost", "", "cmdFileMenu" },
+		{ 23298, "cmdPostAsDraft", "cmdPostAsDraft", "D", "cmdFileMenu" },
+		{ 23299, "cmdPostAsDraftAndEditOnline", "cmdPostAsDraftAndEditOnline", "", "cmdFileMenu" },
+		{ 23300, "cmdPrint", "cmdPrint", "", "cmdFileMenu" },
+		{ 23301, "cmdPrintPreview", "cmdPrintPreview", "", "cmdFileMenu" },
+		{ 23302, "cmdPostAndPublish", "cmdPostAndPublish", "P1", "cmdFileMenu" },
+		{ 23303, "cmdOpenPost", "cmdOpenPost", "", "" },
+		{ 23304, "cmdHelp", "cmdHelp", "", "" },
+		{ 23305, "cmdSelectBlog", "cmdSelectBlog", "P2", "cmdHomeTab/cmdPublishGroup" },
+		{ 23306, "cmdOpenDraftSplit", "cmdOpenDraftSplit", "O", "cmdFileMenu" },
+		{ 23307, "cmdOpenDraftMRU0", "OpenDraftMRU0", "", "" },
+		{ 23308, "cmdOpenDraftMRU1", "OpenDraftMRU1", "", "" },
+		{ 23309, "cmdOpenDraftMRU2", "OpenDraftMRU2", "", "" },
+		{ 23310, "cmdOpenDraftMRU3", "OpenDraftMRU3", "", "" },
+		{ 23311, "cmdOpenDraftMRU4", "OpenDraftMRU4", "", "" },
+		{ 23312, "cmdOpenDraftMRU5", "OpenDraftMRU5", "", "" },
+		{ 23313, "cmdOpenDraftMRU6", "OpenDraftMRU6", "", "" },
+		{ 23314, "cmdOpenDraftMRU7", "OpenDraftMRU7", "", "" },
+		{ 23315, "cmdOpenDraftMRU8", "OpenDraftMRU8", "", "" },
+		{ 23316, "cmdOpenDraftMRU9", "OpenDraftMRU9", "", "" },
+		{ 23317, "cmdOpenPostSplit", "cmdOpenPostSplit", "R", "cmdFileMenu" },
+		{ 23318, "cmdOpenPostMRU0", "OpenPostMRU0", "", "" },
+		{ 23319, "cmdOpenPostMRU1", "OpenPostMRU1", "", "" },
+		{ 23320, "cmdOpenPostMRU2", "OpenPostMRU2", "", "" },
+		{ 23321, "cmdOpenPostMRU3", "OpenPostMRU3", "", "" },
+		{ 23322, "cmdOpenPostMRU4", "OpenPostMRU4", "", "" },
+		{ 23323, "cmdOpenPostMRU5", "OpenPostMRU5", "", "" },
+		{ 23324, "cmdOpenPostMRU6", "OpenPostMRU6", "", "" },
+		{ 23325, "cmdOpenPostMRU7", "OpenPostMRU7", "", "" },
+		{ 23326, "cmdOpenPostMRU8", "OpenPostMRU8", "", "" },
+		{ 23327, "cmdOpenPostMRU9", "OpenPostMRU9", "", "" },
+		{ 23332, "cmdPreviewGroup", "cmdPreviewGroup", "", "cmdPreviewTab" },
+		{ 23335, "cmdConfigureWeblog", "cmdConfigureWeblog", "B", "cmdBlogProviderTab/cmdBlogProviderBlogGroup" },
+		{ 23336, "cmdAddWeblog", "cmdAddWeblog", "", "cmdHomeTab/cmdPublishGroup" },
+		{ 23339, "cmdClosePreview", "cmdClosePreview", "C", "cmdPreviewTab/cmdPreviewGroup" },
+		{ 23340, "cmdUpdateWeblogStyle", "cmdUpdateWeblogStyle", "R", "cmdBlogProviderTab/cmdBlogProviderThemeGroup" },
+		{ 23341, "cmdBrowserGroup", "cmdBrowserGroup", "", "cmdPreviewTab" },
+		{ 23342, "cmdViewUseStyles", "cmdViewUseStyles", "T", "cmdBlogProviderTab/cmdBlogProviderThemeGroup" },
+		{ 23343, "cmdBlogProviderThemeGroup", "cmdBlogProviderThemeGroup", "ZT", "cmdBlogProviderTab" },
+		{ 23344, "cmdBlogProviderButtonsGallery", "cmdBlogProviderButtonsGallery", "S", "cmdBlogProviderTab/cmdBlogProviderShortcutsGroup" },
+		{ 23348, "cmdBlogProviderShortcutsGroup", "cmdBlogProviderShortcutsGroup", "ZS", "cmdBlogProviderTab" },
+		{ 23349, "cmdInsertExtendedEntry", "cmdInsertExtendedEntry", "S", "cmdInsertTab/cmdBreaksGroup" },
+		{ 23352, "cmdBreaksGroup", "cmdBreaksGroup", "ZB", "cmdInsertTab" },
+		{ 23353, "cmdViewWeblog", "cmdViewWeblog", "", "" },
+		{ 23354, "cmdBlogProviderBlogGroup", "cmdBlogProviderBlogGroup", "ZB", "cmdBlogProviderTab" },
+		{ 23369, "cmdFormatTagPropertiesGroup", "cmdFormatTagPropertiesGroup", "", "cmdTagContextTabGroup/cmdFormatTagTab" },
+		{ 23370, "cmdEditTags", "cmdEditTags", "", "cmdTagContextTabGroup/cmdFormatTagTab/cmdFormatTagPropertiesGroup" },
+		{ 23371, "cmdFormatTableInsertGroup", "cmdFormatTableInsertGroup", "ZI", "cmdTableContextTabGroup/cmdFormatTableTab" },
+		{ 23372, "cmdFormatTableMoveGroup", "cmdFormatTableMoveGroup", "ZM", "cmdTableContextTabGroup/cmdFormatTableTab" },
+		{ 23373, "cmdInsertRowAbove", "cmdInsertRowAbove", "IA", "cmdTableContextTabGroup/cmdFormatTableTab/cmdFormatTableInsertGroup" },
+		{ 23374, "cmdInsertRowBelow", "cmdInsertRowBelow", "IB", "cmdTableContextTabGroup/cmdFormatTableTab/cmdFormatTableInsertGroup" },
+		{ 23375, "cmdMoveRowUp", "cmdMoveRowUp", "MA", "cmdTableContextTabGroup/cmdFormatTableTab/cmdFormatTableMoveGroup" },
+		{ 23376, "cmdMoveRowDown", "cmdMoveRowDown", "MB", "cmdTableContextTabGroup/cmdFormatTableTab/cmdFormatTableMoveGroup" },
+		{ 23377, "cmdInsertColumnLeft", "cmdInsertColumnLeft", "IL", "cmdTableContextTabGroup/cmdFormatTableTab/cmdFormatTableInsertGroup" },
+		{ 23378, "cmdInsertColumnRight", "cmdInsertColumnRight", "IR", "cmdTableContextTabGroup/cmdFormatTableTab/cmdFormatTableInsertGroup" },
+		{ 23379, "cmdMoveColumnLeft", "cmdMoveColumnLeft", "ML", "cmdTableContextTabGroup/cmdFormatTableTab/cmdFormatTableMoveGroup" },
+		{ 23380, "cmdMoveColumnRight", "cmdMoveColumnRight", "MR", "cmdTableContextTabGroup/cmdFormatTableTab/cmdFormatTableMoveGroup" },
+		{ 23381, "cmdDeleteRow", "cmdDeleteRow", "DR", "cmdTableContextTabGroup/cmdFormatTableTab/cmdFormatTableEditingGroup" },
+		{ 23382, "cmdDeleteColumn", "cmdDeleteColumn", "DC", "cmdTableContextTabGroup/cmdFormatTableTab/cmdFormatTableEditingGroup" },
+		{ 23383, "cmdDeleteTable", "cmdDeleteTable", "DT", "cmdTableContextTabGroup/cmdFormatTableTab/cmdFormatTableEditingGroup" },
+		{ 23384, "cmdFormatTableEditingGroup", "cmdFormatTableEditingGroup", "ZD", "cmdTableContextTabGroup/cmdFormatTableTab" },
+		{ 23385, "cmdFormatTablePropertiesGroup", "cmdFormatTablePropertiesGroup", "ZP", "cmdTableContextTabGroup/cmdFormatTableTab" },
+		{ 23386, "cmdRowProperties", "cmdRowProperties", "", "cmdTableContextTabGroup/cmdFormatTableTab/cmdFormatTablePropertiesGroup" },
+		{ 23387, "cmdColumnProperties", "cmdColumnProperties", "", "cmdTableContextTabGroup/cmdFormatTableTab/cmdFormatTablePropertiesGroup" },
+		{ 23388, "cmdTableProperties", "cmdTableProperties", "", "cmdTableContextTabGroup/cmdFormatTableTab/cmdFormatTablePropertiesGroup" },
+		{ 23389, "cmdCellProperties", "cmdCellProperties", "", "cmdTableContextTabGroup/cmdFormatTableTab/cmdFormatTablePropertiesGroup" },
+		{ 23390, "cmdFormatTablePropertiesSplit", "cmdFormatTablePropertiesSplit", "T", "cmdTableContextTabGroup/cmdFormatTableTab/cmdFormatTablePropertiesGroup" },
+		{ 23392, "cmdFormatTagProvidersGroup", "cmdFormatTagProvidersGroup", "", "cmdTagContextTabGroup/cmdFormatTagTab" },
+		{ 23393, "cmdAddTagProvider", "cmdAddTagProvider", "", "cmdTagContextTabGroup/cmdFormatTagTab/cmdFormatTagProvidersGroup" },
+		{ 23394, "cmdManageTagProviders", "cmdManageTagProviders", "", "cmdTagContextTabGroup/cmdFormatTagTab/cmdFormatTagProvidersGroup" },
+		{ 23395, "cmdAbout", "cmdAbout", "", "cmdFileMenu" },
+		{ 23397, "cmdClearCell", "cmdClearCell", "DE", "cmdTableContextTabGroup/cmdFormatTableTab/cmdFormatTableEditingGroup" },
+		{ 23398, "cmdAlignNone", "cmdAlignNone", "M", "" },
+		{ 23417, "cmdFormatMapGroup", "cmdFormatMapGroup", "M", "cmdMapContextTabGroup/cmdFormatMapTab" },
+		{ 23418, "cmdMapWebPreview", "cmdMapWebPreview", "M", "cmdMapContextTabGroup/cmdFormatMapTab/cmdFormatMapGroup" },
+		{ 23419, "cmdFormatMapPropertiesGroup", "cmdFormatMapPropertiesGroup", "M", "cmdMapContextTabGroup/cmdFormatMapTab" },
+		{ 23420, "cmdFormatMapEdit", "cmdFormatMapEdit", "M", "cmdMapContextTabGroup/cmdFormatMapTab/cmdFormatMapPropertiesGroup" },
+		{ 23421, "cmdDeleteDraft", "cmdDeleteDraft", "", "cmdFileMenu" },
+		{ 23422, "cmdActivateContexutalTab", "cmdActivateContextualTab", "", "" },
+		{ 23424, "cmdAddDecorator", "AddDecorator", "", "" },
+		{ 23425, "cmdAddToDictionary", "AddToDictionary", "", "" },
+		{ 23426, "cmdAddToGlossary", "AddToGlossary", "", "" },
+		{ 23427, "cmdApplySemanticHeader1", "ApplySemanticHeader1", "", "" },
+		{ 23428, "cmdApplySemanticHeader2", "ApplySemanticHeader2", "", "" },
+		{ 23429, "cmdApplySemanticHeader3", "ApplySemanticHeader3", "", "" },
+		{ 23430, "cmdApplySemanticHeader4", "ApplySemanticHeader4", "", "" },
+		{ 23431, "cmdApplySemanticHeader5", "ApplySemanticHeader5", "", "" },
+		{ 23432, "cmdApplySemanticHeader6", "ApplySemanticHeader6", "", "" },
+		{ 23434, "cmdClear", "Clear", "", "" },
+		{ 23435, "cmdColorize", "Colorize", "", "" },
+		{ 23436, "cmdDelete", "Delete", "", "" },
+		{ 23437, "cmdEditLink", "EditLink", "", "" },
+		{ 23438, "cmdFixWordSpelling", "FixWordSpelling", "", "" },
+		{ 23439, "cmdFocusNextPane", "FocusNextPane", "", "" },
+		{ 23440, "cmdFocusPreviousPane", "FocusPreviousPane", "", "" },
+		{ 23441, "cmdFont", "Font", "", "" },
+		{ 23442, "cmdFontColor", "FontColor", "", "" },
+		{ 23443, "cmdGlossary", "Glossary", "", "" },
+		{ 23444, "cmdIgnoreAll", "IgnoreAll", "", "" },
+		{ 23445, "cmdIgnoreOnce", "IgnoreOnce", "", "" },
+		{ 23446, "cmdImageDecoratorApply", "ImageDecoratorApply", "", "" },
+		{ 23447, "cmdImageEffectBlackAndWhite", "ImageEffectBlackAndWhite", "", "" },
+		{ 23448, "cmdImageEffectColorPop", "ImageEffectColorPop", "", "" },
+		{ 23449, "cmdImageEffectColorTemperature", "ImageEffectColorTemperature", "", "" },
+		{ 23450, "cmdImageEffectEmboss", "ImageEffectEmboss", "", "" },
+		{ 23451, "cmdImageEffectGaussianBlur", "ImageEffectGaussianBlur", "", "" },
+		{ 23452, "cmdImageEffectSepiaTone", "ImageEffectSepiaTone", "", "" },
+		{ 23453, "cmdImageEffectSharpen", "ImageEffectSharpen", "", "" },
+		{ 23454, "cmdImageReset", "ImageReset", "", "" },
+		{ 23455, "cmdImageRotate", "ImageRotate", "", "" },
+		{ 23456, "cmdInsertMenu", "InsertMenu", "", "" },
+		{ 23457, "cmdInsertTable2", "InsertTable2", "", "" },
+		{ 23458, "cmdMapAddPushpin", "MapAddPushpin", "", "" },
+		{ 23459, "cmdMapCenterMap", "MapCenterMap", "", "" },
+		{ 23460, "cmdMapDeletePushpin", "MapDeletePushpin", "", "" },
+		{ 23461, "cmdMapEditPushpin", "MapEditPushpin", "", "" },
+		{ 23462, "cmdMapZoomCityLevel", "MapZoomCityLevel", "", "" },
+		{ 23463, "cmdMapZoomRegionLevel", "MapZoomRegionLevel", "", "" },
+		{ 23464, "cmdMapZoomStreetLevel", "MapZoomStreetLevel", "", "" },
+		{ 23465, "cmdOpenDrafts", "OpenDrafts", "", "" },
+		{ 23466, "cmdOpenLink", "OpenLink", "", "" },
+		{ 23467, "cmdOpenRecentPosts", "OpenRecentPosts", "", "" },
+		{ 23468, "cmdOpenSpellingForm", "OpenSpellingForm", "", "" },
+		{ 23469, "cmdPostProperties", "PostProperties", "", "" },
+		{ 23470, "cmdRecentPost", "RecentPost", "", "" },
+		{ 23471, "cmdRemoveDecorator", "RemoveDecorator", "", "" },
+		{ 23472, "cmdRemoveLink", "RemoveLink", "", "" },
+		{ 23473, "cmdRemoveLinkAndClearFormatting", "RemoveLinkAndClearFormatting", "", "" },
+		{ 23474, "cmdShowCategoryPopup", "ShowCategoryPopup", "", "" },
+		{ 23475, "cmdShowImageUploadError", "ShowImageUploadError", "", "" },
+		{ 23476, "cmdShowMenu", "ShowMenu", "", "" },
+		{ 23477, "cmdShowVideoErrorMessage", "ShowVideoErrorMessage", "", "" },
+		{ 23478, "cmdStyle", "Style", "", "" },
+		{ 23479, "cmdTableMenu", "TableMenu", "", "" },
+		{ 23480, "cmdToolsMenu", "ToolsMenu", "", "" },
+		{ 23481, "cmdViewCode", "ViewCode", "", "" },
+		{ 23482, "cmdViewNormal", "ViewNormal", "", "" },
+		{ 23483, "cmdViewPreview", "ViewPreview", "", "" },
+		{ 23484, "cmdViewSidebar", "ViewSidebar", "", "" },
+		{ 23485, "cmdViewWeblogAdmin", "ViewWeblogAdmin", "", "" },
+		{ 23486, "cmdWeblogMenu", "WeblogMenu", "", "" },
+		{ 23487, "cmdWeblogPicker", "WeblogPicker", "", "" },
+		{ 23488, "cmdApplySemanticParagraph", "ApplySemanticParagraph", "", "" },
+		{ 30000, "cmdHomeTab", "cmdHomeTab", "H", "" },
+		{ 30001, "cmdInsertTab", "cmdInsertTab", "I", "" },
+		{ 30002, "cmdBlogProviderTab", "cmdBlogProviderTab", "B", "" },
+		{ 30005, "cmdTagContextTabGroup", "cmdTagContextTabGroup", "", "" },
+		{ 30006, "cmdTableContextTabGroup", "cmdTableContextTabGroup", "", "" },
+		{ 30007, "cmdMapContextTabGroup", "cmdMapContextTabGroup", "", "" },
+		{ 30015, "cmdDebugTab", "cmdDebugTab", "D", "" },
+		{ 30016, "cmdPreviewTab", "cmdPreviewTab", "R", "" },
+		{ 30017, "cmdFormatMapTab", "cmdFormatMapTab", "M", "cmdMapContextTabGroup" },
+		{ 30019, "cmdFormatTagTab", "cmdFormatTagTab", "T", "cmdTagContextTabGroup" },
+		{ 30020, "cmdFormatTableTab", "cmdFormatTableTab", "T", "cmdTableContextTabGroup" },
+		{ 30022, "cmdAccounts", "cmdAccounts", "", "cmdHomeTab/cmdPublishGroup" },
+		{ 30051, "cmdMediaGroup", "cmdMediaGroup", "ZM", "cmdInsertTab" },
+		{ 30052, "cmdTablesGroup", "cmdTablesGroup", "ZT", "cmdInsertTab" },
+		{ 30053, "cmdPluginsGroup", "cmdPluginsGroup", "ZP", "cmdInsertTab" },
+		{ 30056, "cmdPluginsGallery", "cmdPluginsGallery", "PP", "cmdInsertTab/cmdPluginsGroup" },
+		{ 30060, "cmdInsertGroup", "cmdInsertGroup", "ZI", "cmdHomeTab" },
+		{ 30064, "cmdImageArrangeGallery", "ImageArrangeGallery", "", "" },
+		{ 30066, "cmdPublishGroup", "cmdPublishGroup", "ZP1", "cmdHomeTab" },
+		{ 50000, "cmdQAT", "cmdQAT", "", "" },
+		{ 50400, "cmdGeneralDebugGroup", "cmdGeneralDebugGroup", "", "cmdDebugTab" },
+		{ 50401, "cmdDialogDebugGroup", "cmdDialogDebugGroup", "", "cmdDebugTab" },
+		{ 50402, "cmdTextDebugGroup", "cmdTextDebugGroup", "", "cmdDebugTab" },
+		{ 50403, "cmdValidateDebugGroup", "cmdValidateDebugGroup", "", "cmdDebugTab" },
+		{ 50500, "cmdDiagnosticsConsole", "cmdDiagnosticsConsole", "", "cmdDebugTab/cmdGeneralDebugGroup" },
+		{ 50502, "cmdShowBetaExpiredDialogs", "cmdShowBetaExpiredDialogs", "", "cmdDebugTab/cmdDialogDebugGroup" },
+		{ 50503, "cmdShowUpdateMessage", "cmdShowUpdateMessage", "", "cmdDebugTab/cmdDialogDebugGroup" },
+		{ 50504, "cmdShowWebLayoutWarning", "cmdShowWebLayoutWarning", "", "cmdDebugTab/cmdDialogDebugGroup" },
+		{ 50505, "cmdShowErrorDialog", "cmdShowErrorDialog", "", "cmdDebugTab/cmdDialogDebugGroup" },
+		{ 50506, "cmdBlogClientOptions", "cmdBlogClientOptions", "", "cmdDebugTab/cmdGeneralDebugGroup" },
+		{ 50507, "cmdShowDisplayMessageTestForm", "cmdShowDisplayMessageTestForm", "", "cmdDebugTab/cmdDialogDebugGroup" },
+		{ 50508, "cmdShowSupportingFilesForm", "cmdShowSupportingFilesForm", "", "cmdDebugTab/cmdDialogDebugGroup" },
+		{ 50509, "cmdInsertLoremIpsum", "cmdInsertLoremIpsum", "", "cmdDebugTab/cmdTextDebugGroup" },
+		{ 50510, "cmdValidateHtml", "cmdValidateHtml", "", "cmdDebugTab/cmdValidateDebugGroup" },
+		{ 50511, "cmdValidateXhtml", "cmdValidateXhtml", "", "cmdDebugTab/cmdValidateDebugGroup" },
+		{ 50512, "cmdValidateLocalizedResources", "cmdValidateLocalizedResources", "", "cmdDebugTab/cmdValidateDebugGroup" },
+		{ 50513, "cmdShowAtomImageEndpointSelector", "cmdShowAtomImageEndpointSelector", "", "cmdDebugTab/cmdDialogDebugGroup" },
+		{ 50514, "cmdRaiseAssertion", "cmdRaiseAssertion", "", "cmdDebugTab/cmdGeneralDebugGroup" },
+		{ 50515, "cmdShowGoogleCaptcha", "cmdShowGoogleCaptcha", "", "cmdDebugTab/cmdDialogDebugGroup" },
+		{ 50516, "cmdTerminateProcess", "cmdTerminateProcess", "", "cmdDebugTab/cmdGeneralDebugGroup" },
+		{ 50517, "cmdViewSource", "cmdViewSource", "", "cmdDebugTab/cmdGeneralDebugGroup" },
+	};
+
+	constexpr Tab Tabs[TabCount] =
+	{
+		{ 260, { 0, 8 } },	// cmdHomeTab
+		{ 261, { 8, 13 } },	// cmdInsertTab
+		{ 262, { 13, 16 } },	// cmdBlogProviderTab
+		{ 267, { 16, 19 } },	// cmdPreviewTab
+		{ 266, { 19, 23 } },	// cmdDebugTab
+		{ 54, { 23, 30 } },	// cmdFormatImageTab
+		{ 50, { 30, 34 } },	// cmdFormatVideoTab
+		{ 268, { 34, 38 } },	// cmdFormatMapTab
+		{ 270, { 38, 42 } },	// cmdFormatTableTab
+		{ 269, { 42, 44 } },	// cmdFormatTagTab
+	};
+
+	constexpr Group Groups[GroupCount] =
+	{
+		{ 98, 0, { 0, 5 } },	// cmdClipboardGroup
+		{ 278, 0, { 5, 10 } },	// cmdPublishGroup
+		{ 0, 0, { 10, 21 } },	// cmdFontGroup
+		{ 90, 0, { 21, 28 } },	// cmdParagraphGroup
+		{ 90, 0, { 28, 37 } },	// cmdParagraphGroup
+		{ 16, 0, { 37, 38 } },	// cmdSemanticHtmlGroup
+		{ 276, 0, { 38, 46 } },	// cmdInsertGroup
+		{ 11, 0, { 46, 50 } },	// cmdTextEditingGroup
+		{ 159, 1, { 50, 53 } },	// cmdBreaksGroup
+		{ 273, 1, { 53, 54 } },	// cmdTablesGroup
+		{ 272, 1, { 54, 65 } },	// cmdMediaGroup
+		{ 274, 1, { 65, 67 } },	// cmdPluginsGroup
+		{ 274, 1, { 67, 70 } },	// cmdPluginsGroup
+		{ 161, 2, { 70, 71 } },	// cmdBlogProviderBlogGroup
+		{ 157, 2, { 71, 72 } },	// cmdBlogProviderShortcutsGroup
+		{ 155, 2, { 72, 74 } },	// cmdBlogProviderThemeGroup
+		{ 278, 3, { 74, 79 } },	// cmdPublishGroup
+		{ 153, 3, { 79, 80 } },	// cmdBrowserGroup
+		{ 148, 3, { 80, 81 } },	// cmdPreviewGroup
+		{ 280, 4, { 81, 86 } },	// cmdGeneralDebugGroup
+		{ 281, 4, { 86, 94 } },	// cmdDialogDebugGroup
+		{ 282, 4, { 94, 95 } },	// cmdTextDebugGroup
+		{ 283, 4, { 95, 98 } },	// cmdValidateDebugGroup
+		{ 55, 5, { 98, 108 } },	// cmdFormatImageSizeGroup
+		{ 62, 5, { 108, 111 } },	// cmdFormatImageRotateGroup
+		{ 66, 5, { 111, 119 } },	// cmdFormatImageStyleGroup
+		{ 75, 5, { 119, 125 } },	// cmdFormatImagePropertiesGroup
+		{ 79, 5, { 125, 127 } },	// cmdFormatImageSettingsGroup
+		{ 42, 5, { 127, 128 } },	// cmdAlignmentGroup
+		{ 44, 5, { 128, 132 } },	// cmdMarginsGroup
+		{ 51, 6, { 132, 133 } },	// cmdFormatVideoGroup
+		{ 91, 6, { 133, 135 } },	// cmdVideoAspectRatioGroup
+		{ 42, 6, { 135, 136 } },	// cmdAlignmentGroup
+		{ 44, 6, { 136, 140 } },	// cmdMarginsGroup
+		{ 190, 7, { 140, 141 } },	// cmdFormatMapGroup
+		{ 192, 7, { 141, 142 } },	// cmdFormatMapPropertiesGroup
+		{ 42, 7, { 142, 143 } },	// cmdAlignmentGroup
+		{ 44, 7, { 143, 147 } },	// cmdMarginsGroup
+		{ 178, 8, { 147, 152 } },	// cmdFormatTablePropertiesGroup
+		{ 177, 8, { 152, 156 } },	// cmdFormatTableEditingGroup
+		{ 164, 8, { 156, 160 } },	// cmdFormatTableInsertGroup
+		{ 165, 8, { 160, 164 } },	// cmdFormatTableMoveGroup
+		{ 162, 9, { 164, 165 } },	// cmdFormatTagPropertiesGroup
+		{ 184, 9, { 165, 167 } },	// cmdFormatTagProvidersGroup
+	};
+
+	constexpr unsigned short GroupCommands[] =
+	{
+		101, 29, 32, 30, 31, 122, 125, 150, 271, 118, 1, 2, 3, 9, 8, 7,
+		6, 4, 5, 21, 10, 22, 23, 24, 25, 27, 26, 28, 22, 23, 24, 41,
+		40, 25, 27, 26, 28, 17, 19, 102, 34, 97, 103, 111, 112, 113, 12, 13,
+		14, 37, 18, 33, 158, 114, 19, 102, 34, 97, 103, 111, 112, 113, 109, 110,
+		82, 99, 100, 275, 99, 100, 149, 156, 154, 152, 122, 125, 150, 271, 118, 152,
+		151, 299, 297, 284, 289, 300, 285, 286, 287, 288, 290, 291, 296, 298, 292, 293,
+		294, 295, 56, 57, 58, 59, 83, 84, 85, 86, 60, 61, 64, 63, 65, 67,
+		68, 69, 70, 71, 72, 73, 74, 76, 87, 88, 89, 77, 78, 81, 80, 43,
+		45, 46, 48, 47, 52, 92, 93, 43, 45, 46, 48, 47, 191, 193, 43, 45,
+		46, 48, 47, 183, 181, 179, 180, 182, 174, 175, 176, 188, 166, 167, 170, 171,
+		168, 169, 172, 173, 163, 185, 186
+	};
+
+	constexpr unsigned int IdBucketCount = 76;
+	constexpr unsigned short IdDisplacements[IdBucketCount] =
+	{
+		48, 0, 3, 17, 73, 2, 47, 58, 116, 17, 72, 268, 173, 1, 3, 268,
+		1, 7, 201, 29, 27, 382, 224, 570, 0, 133, 171, 163, 0, 187, 283, 277,
+		1821, 194, 279, 709, 333, 42, 432, 53, 69, 266, 113, 401, 1, 378, 635, 654,
+		392, 888, 140, 3, 1, 523, 357, 65, 1105, 881, 194, 117, 877, 650, 12, 77,
+		309, 1, 1285, 117, 381, 459, 166, 742, 1101, 740, 718, 2
+	};
+
+	constexpr unsigned short IdSlots[CommandCount] =
+	{
+		144, 103, 123, 283, 49, 298, 80, 77, 72, 236, 184, 193, 6, 274, 96, 65,
+		132, 210, 198, 264, 254, 168, 85, 116, 154, 228, 122, 187, 271, 135, 243, 281,
+		253, 100, 145, 146, 34, 300, 268, 142, 278, 237, 67, 284, 35, 139, 296, 12,
+		111, 92, 266, 175, 275, 286, 297, 196, 11, 28, 140, 127, 166, 209, 27, 97,
+		125, 203, 90, 115, 171, 13, 180, 179, 240, 10, 273, 163, 241, 178, 258, 277,
+		159, 69, 257, 108, 75, 55, 130, 295, 7, 42, 164, 291, 101, 66, 165, 181,
+		0, 64, 84, 185, 23, 244, 87, 86, 81, 285, 149, 247, 216, 126, 288, 220,
+		129, 52, 88, 51, 189, 280, 109, 177, 182, 107, 211, 58, 152, 14, 18, 54,
+		270, 43, 172, 124, 292, 249, 2, 106, 221, 93, 8, 41, 120, 38, 121, 232,
+		224, 30, 212, 17, 201, 218, 250, 148, 205, 217, 37, 63, 110, 26, 219, 208,
+		45, 117, 157, 195, 186, 265, 102, 89, 76, 59, 289, 174, 53, 267, 147, 47,
+		138, 169, 104, 158, 73, 99, 60, 215, 248, 197, 24, 261, 199, 94, 167, 50,
+		231, 33, 70, 98, 46, 36, 112, 62, 156, 137, 31, 40, 279, 214, 161, 276,
+		44, 234, 4, 153, 1, 190, 194, 176, 136, 256, 251, 91, 57, 226, 282, 19,
+		200, 242, 287, 82, 114, 113, 95, 68, 141, 245, 105, 79, 128, 131, 207, 260,
+		143, 170, 15, 246, 71, 22, 173, 78, 191, 255, 188, 83, 269, 39, 151, 299,
+		56, 9, 192, 5, 202, 290, 48, 162, 155, 239, 238, 223, 134, 118, 29, 20,
+		259, 74, 160, 133, 119, 233, 225, 183, 3, 61, 32, 222, 293, 229, 263, 204,
+		272, 252, 227, 21, 150, 294, 262, 230, 213, 206, 25, 235, 16
+	};
+
+	constexpr unsigned int SymbolBucketCount = 76;
+	constexpr unsigned short SymbolDisplacements[SymbolBucketCount] =
+	{
+		34, 22, 3, 19, 7, 7, 7, 9, 252, 10, 5, 6, 1, 1, 0, 132,
+		22, 6, 43, 9, 183, 63, 1, 113, 39, 175, 1, 332, 3, 35, 2, 11,
+		110, 6, 278, 805, 121, 19, 11, 126, 1, 4, 12, 22, 10, 21, 8, 851,
+		38, 13, 31, 31, 117, 314, 254, 24, 1, 2685, 28, 2, 22, 4, 327, 187,
+		854, 50, 2282, 62, 38, 197, 265, 632, 116, 829, 7, 5
+	};
+
+	constexpr unsigned short SymbolSlots[CommandCount] =
+	{
+		185, 263, 18, 293, 244, 158, 74, 203, 66, 157, 116, 145, 114, 9, 275, 184,
+		199, 182, 72, 44, 296, 84, 60, 127, 69, 61, 280, 232, 266, 37, 257, 236,
+		300, 239, 259, 197, 92, 118, 204, 62, 173, 200, 42, 172, 151, 237, 205, 297,
+		261, 87, 23, 134, 190, 95, 112, 188, 108, 177, 201, 238, 250, 225, 138, 3,
+		161, 70, 90, 245, 265, 93, 107, 169, 22, 67, 224, 193, 46, 11, 50, 82,
+		81, 36, 248, 98, 153, 73, 176, 130, 51, 163, 208, 106, 269, 235, 291, 213,
+		171, 187, 156, 164, 260, 45, 241, 25, 191, 115, 55, 258, 146, 295, 144, 100,
+		149, 180, 96, 251, 186, 221, 86, 126, 195, 289, 41, 211, 88, 207, 29, 226,
+		54, 28, 94, 192, 13, 12, 110, 131, 217, 194, 274, 285, 97, 38, 26, 299,
+		135, 231, 123, 39, 2, 183, 198, 14, 214, 31, 4, 120, 216, 47, 129, 220,
+		76, 219, 117, 279, 294, 215, 53, 233, 150, 254, 247, 85, 281, 111, 7, 210,
+		276, 240, 65, 99, 1, 202, 15, 101, 252, 284, 48, 222, 56, 79, 168, 136,
+		52, 278, 0, 63, 160, 49, 286, 143, 5, 20, 125, 128, 223, 34, 33, 264,
+		32, 71, 121, 91, 119, 256, 242, 272, 255, 16, 10, 287, 282, 24, 162, 105,
+		212, 103, 102, 122, 154, 174, 159, 218, 179, 167, 78, 75, 58, 30, 19, 283,
+		262, 141, 298, 6, 270, 209, 175, 124, 290, 273, 68, 59, 246, 152, 165, 155,
+		64, 277, 142, 83, 268, 27, 43, 40, 181, 17, 253, 288, 166, 80, 104, 133,
+		227, 292, 139, 89, 21, 243, 234, 113, 140, 147, 228, 249, 189, 8, 178, 137,
+		148, 271, 35, 206, 230, 109, 170, 132, 77, 229, 267, 57, 196
+	};
+
+	constexpr unsigned int Avalanche(unsigned int hash)
+	{
+		hash ^= hash >> 16;
+		hash *= 0x85EBCA6Bu;
+		return hash ^ (hash >> 13);
+	}
+
+	constexpr unsigned int HashId(unsigned int seed, unsigned int id)
+	{
+		unsigned int hash = 2166136261u ^ seed;
+		for (int i = 0; i < 4; i++)
+			hash = (hash ^ ((id >> (i * 8)) & 0xFF)) * 16777619u;
+		return Avalanche(hash);
+	}
+
+	constexpr unsigned int HashSymbol(unsigned int seed, const char *symbol)
+	{
+		unsigned int hash = 2166136261u ^ seed;
+		for (; *symbol; symbol++)
+			hash = (hash ^ (unsigned char)*symbol) * 16777619u;
+		return Avalanche(hash);
+	}
+
+	constexpr bool SymbolEquals(const char *a, const char *b)
+	{
+		for (; *a && *a == *b; a++, b++)
+			;
+		return *a == *b;
+	}
+
+	// the index of the command in Commands, or -1
+	constexpr int FindById(unsigned int id)
+	{
+		unsigned short index = IdSlots[HashId(IdDisplacements[HashId(0, id) % IdBucketCount], id) % CommandCount];
+		return Commands[index].id == id ? index : -1;
+	}
+
+	constexpr int FindBySymbol(const char *symbol)
+	{
+		unsigned short index = SymbolSlots[HashSymbol(SymbolDisplacements[HashSymbol(0, symbol) % SymbolBucketCount], symbol) % CommandCount];
+		return SymbolEquals(Commands[index].symbol, symbol) ? index : -1;
+	}
+}
@@ -0,0 +1,197 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+/*
+Checks the base64 encoder in OpenLiveWriter.CppUtils (Base64Encoder.h) and
+measures its throughput:
+
+	Base64EncoderCheck [/benchmark]
+
+Every kernel the processor has (plain C++, SSSE3, AVX2) is compared with a
+bit at a time reference here, for every length up to a few hundred bytes and
+every alignment, and with RFC 4648's test vectors. Encoding in blocks that
+are multiples of 3 bytes long is checked to give the same characters as
+encoding in one go. Exits with 1 if anything differs.
+
+For a 32-bit x86 build, -msse2 is what brings in the SSSE3 and AVX2
+kernels; without it only the plain one is checked:
+
+	c++ -std=c++11 -O2 -msse2 -o Base64EncoderCheck Base64EncoderCheck.cpp
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../../src/unmanaged/OpenLiveWriter.CppUtils/Include/Base64Encoder.h"
+
+using namespace std;
+
+static const char* KernelNames[] = { "best", "C++", "SSSE3", "AVX2" };
+
+static string Reference(const uint8_t* bytes, size_t length)
+{
+	static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	string result;
+	unsigned index = 0;
+	int bits = 0;
+	for (size_t i = 0; i < length; i++)
+	{
+		for (int bit = 7; bit >= 0; bit--)
+		{
+			index = (index << 1) | ((bytes[i] >> bit) & 1);
+			if (++bits == 6)
+			{
+				result += alphabet[index];
+				index = 0;
+				bits = 0;
+			}
+		}
+	}
+	if (bits > 0)
+		result += alphabet[index << (6 - bits)];
+	while (result.size() % 4 != 0)
+		result += '=';
+	return result;
+}
+
+static string Encode(const uint8_t* bytes, size_t length, Base64Kernels kernels)
+{
+	// a guard past the end to catch overruns
+	vector<char> buffer((size_t)Base64Encoder::EncodedLength(length) + 16, '#');
+	size_t written = Base64Encoder::Encode(bytes, length, buffer.data(), kernels);
+	for (size_t i = written; i < buffer.size(); i++)
+	{
+		if (buffer[i] != '#')
+			return "(overran)";
+	}
+	return string(buffer.data(), written);
+}
+
+static int failures = 0;
+
+static void Expect(bool condition, const char* what, const char* detail)
+{
+	if (!condition)
+	{
+		printf("FAIL %s: %s\n", what, detail);
+		failures++;
+	}
+}
+
+static void CheckVectors()
+{
+	static const char* vectors[][2] =
+	{
+		{ "", "" },
+		{ "f", "Zg==" },
+		{ "fo", "Zm8=" },
+		{ "foo", "Zm9v" },
+		{ "foob", "Zm9vYg==" },
+		{ "fooba", "Zm9vYmE=" },
+		{ "foobar", "Zm9vYmFy" },
+		{ "Many hands make light work. Many hands make light work.", "TWFueSBoYW5kcyBtYWtlIGxpZ2h0IHdvcmsuIE1hbnkgaGFuZHMgbWFrZSBsaWdodCB3b3JrLg==" },
+	};
+	Base64Kernels best = Base64Encoder::ChooseKernels(BASE64_BEST_KERNELS);
+	for (size_t i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++)
+	{
+		for (int kernels = BASE64_SCALAR_KERNELS; kernels <= best; kernels++)
+			Expect(Encode((const uint8_t*)vectors[i][0], strlen(vectors[i][0]), (Base64Kernels)kernels) == vectors[i][1], "RFC 4648", vectors[i][0]);
+	}
+}
+
+static void CheckLengths()
+{
+	mt19937 random(43);
+	vector<uint8_t> bytes(600);
+	for (size_t i = 0; i < bytes.size(); i++)
+		bytes[i] = (uint8_t)random();
+
+	// runs of the characters at both ends of the alphabet
+	memset(&bytes[520], 0xFF, 40);
+	memset(&bytes[560], 0x00, 40);
+
+	Base64Kernels best = Base64Encoder::ChooseKernels(BASE64_BEST_KERNELS);
+	for (size_t offset = 0; offset < 32; offset++)
+	{
+		for (size_t length = 0; length + offset <= bytes.size(); length++)
+		{
+			string expected = Reference(&bytes[offset], length);
+			for (int kernels = BASE64_SCALAR_KERNELS; kernels <= best; kernels++)
+			{
+				char detail[100];
+				snprintf(detail, sizeof(detail), "%d bytes at %d, %s kernels", (int)length, (int)offset, KernelNames[kernels]);
+				Expect(Encode(&bytes[offset], length, (Base64Kernels)kernels) == expected, "same as reference", detail);
+			}
+		}
+	}
+}
+
+static void CheckBlocks()
+{
+	mt19937 random(7);
+	vector<uint8_t> bytes(100000);
+	for (size_t i = 0; i < bytes.size(); i++)
+		bytes[i] = (uint8_t)random();
+	string whole = Encode(bytes.data(), bytes.size(), BASE64_BEST_KERNELS);
+
+	const size_t blockSizes[] = { 3, 48, 3 * 1024, 48 * 1024 };
+	for (size_t i = 0; i < sizeof(blockSizes) / sizeof(blockSizes[0]); i++)
+	{
+		string blocks;
+		for (size_t start = 0; start < bytes.size(); start += blockSizes[i])
+			blocks += Encode(&bytes[start], min(blockSizes[i], bytes.size() - start), BASE64_BEST_KERNELS);
+
+		char detail[100];
+		snprintf(detail, sizeof(detail), "%d byte blocks", (int)blockSizes[i]);
+		Expect(blocks == whole, "blocks same as whole", detail);
+	}
+}
+
+static void Benchmark(size_t length)
+{
+	mt19937 random(1);
+	vector<uint8_t> bytes(length);
+	for (size_t i = 0; i < bytes.size(); i++)
+		bytes[i] = (uint8_t)random();
+	vector<char> encoded((size_t)Base64Encoder::EncodedLength(length));
+
+	Base64Kernels best = Base64Encoder::ChooseKernels(BASE64_BEST_KERNELS);
+	printf("%d bytes\n", (int)length);
+	for (int kernels = BASE64_SCALAR_KERNELS; kernels <= best; kernels++)
+	{
+		const int runs = 20;
+		auto start = chrono::steady_clock::now();
+		for (int i = 0; i < runs; i++)
+			Base64Encoder::Encode(bytes.data(), bytes.size(), encoded.data(), (Base64Kernels)kernels);
+		double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count() / runs;
+		printf("  %-6s %8.2f ms %8.0f MB/s\n", KernelNames[kernels], seconds * 1e3, length / seconds / 1e6);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc == 2 && strcmp(argv[1], "/benchmark") == 0)
+	{
+		// a block as XML-RPC uploads read them, and a large photo
+		Benchmark(48 * 1024);
+		Benchmark(12 * 1024 * 1024);
+		return 0;
+	}
+	if (argc != 1)
+	{
+		printf("usage: Base64EncoderCheck [/benchmark]\n");
+		return 2;
+	}
+
+	CheckVectors();
+	CheckLengths();
+	CheckBlocks();
+
+	Base64Kernels best = Base64Encoder::ChooseKernels(BASE64_BEST_KERNELS);
+	printf("%s (kernels up to %s)\n", failures == 0 ? "PASS" : "FAILED", KernelNames[best]);
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,493 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+/*
+Checks the HTML diff engine in OpenLiveWriter.CppUtils (HtmlDiff.h) and measures
+it on large posts with synthetic edits:
+
+	HtmlDiffCheck [/benchmark]
+
+Edit scripts of random sequences are compared with the edit distance a
+dynamic program here finds, both short ones and ones long enough for the
+linear space refinement or the dynamic program, and are applied to check
+that they give the new sequence (or, for sequences that are lined up by
+their unique tokens first, at least as long a one). Diffs of randomly
+edited HTML are applied to check that they give the new HTML, and HTML that
+is only formatted differently is checked to have the same signature. The
+SSE2 hash is compared with the plain one. Exits with 1 if anything differs.
+
+The benchmark diffs a 1 MB post against copies of it with a few, many and
+large edits, one formatted as a server might, and one with nothing in common.
+
+On 32-bit x86 the SSE2 hash is only built with -msse2:
+
+	c++ -std=c++11 -O2 -msse2 -o HtmlDiffCheck HtmlDiffCheck.cpp
+*/
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../../src/unmanaged/OpenLiveWriter.CppUtils/Include/HtmlDiff.h"
+
+using namespace std;
+
+typedef basic_string<HtmlDiffChar> Html;
+
+static int failures = 0;
+
+static void Expect(bool condition, const char* what, const string& detail)
+{
+	if (!condition)
+	{
+		printf("FAIL %s: %s\n", what, detail.c_str());
+		failures++;
+	}
+}
+
+static Html ToHtml(const string& text)
+{
+	return Html(text.begin(), text.end());
+}
+
+static string ToString(const Html& html)
+{
+	string text;
+	for (size_t i = 0; i < html.size(); i++)
+		text += html[i] < 128 ? (char)html[i] : '?';
+	return text;
+}
+
+// the edit distance (deletions and insertions) of a and b
+static int Distance(const vector<uint64_t>& a, const vector<uint64_t>& b)
+{
+	vector<int> row(b.size() + 1);
+	vector<int> next(b.size() + 1);
+	for (size_t j = 0; j <= b.size(); j++)
+		row[j] = (int)j;
+	for (size_t i = 1; i <= a.size(); i++)
+	{
+		next[0] = (int)i;
+		for (size_t j = 1; j <= b.size(); j++)
+			next[j] = a[i - 1] == b[j - 1] ? row[j - 1] : min(row[j], next[j - 1]) + 1;
+		row.swap(next);
+	}
+	return row[b.size()];
+}
+
+static void CheckSequences(const vector<uint64_t>& a, const vector<uint64_t>& b, const char* what, bool shortest)
+{
+	vector<HtmlDiffEdit> edits;
+	bool found = HtmlDiff::DiffSequences(a.empty() ? NULL : &a[0], (int)a.size(), b.empty() ? NULL : &b[0], (int)b.size(), (int)(a.size() + b.size()), edits);
+	Expect(found, what, "found");
+
+	// in order, and applying them gives b
+	vector<uint64_t> applied;
+	int differences = 0;
+	size_t oldPos = 0;
+	bool ordered = true;
+	for (size_t i = 0; i < edits.size(); i++)
+	{
+		if ((size_t)edits[i].oldStart < oldPos || edits[i].oldCount + edits[i].newCount == 0 || edits[i].newStart != (int)applied.size() + edits[i].oldStart - (int)oldPos)
+			ordered = false;
+		applied.insert(applied.end(), a.begin() + oldPos, a.begin() + edits[i].oldStart);
+		applied.insert(applied.end(), b.begin() + edits[i].newStart, b.begin() + edits[i].newStart + edits[i].newCount);
+		oldPos = edits[i].oldStart + edits[i].oldCount;
+		differences += edits[i].oldCount + edits[i].newCount;
+	}
+	applied.insert(applied.end(), a.begin() + oldPos, a.end());
+	Expect(ordered, what, "edits in order");
+	Expect(applied == b, what, "applied");
+
+	int distance = Distance(a, b);
+	char detail[100];
+	snprintf(detail, sizeof(detail), "%d differences, distance %d", differences, distance);
+	Expect(shortest ? differences == distance : differences >= distance, what, detail);
+
+	// too many
+	if (shortest && distance > 0)
+	{
+		Expect(!HtmlDiff::DiffSequences(a.empty() ? NULL : &a[0], (int)a.size(), b.empty() ? NULL : &b[0], (int)b.size(), distance - 1, edits), what, "over the limit");
+		Expect(HtmlDiff::DiffSequences(a.empty() ? NULL : &a[0], (int)a.size(), b.empty() ? NULL : &b[0], (int)b.size(), distance, edits), what, "at the limit");
+	}
+}
+
+static vector<uint64_t> Mutate(const vector<uint64_t>& a, int edits, int alphabet, mt19937& random)
+{
+	vector<uint64_t> b(a);
+	for (int e = 0; e < edits; e++)
+	{
+		size_t pos = b.empty() ? 0 : random() % (b.size() + 1);
+		switch (random() % 3)
+		{
+		case 0:
+			b.insert(b.begin() + pos, random() % alphabet);
+			break;
+		case 1:
+			if (pos < b.size())
+				b.erase(b.begin() + pos);
+			break;
+		default:
+			if (pos < b.size())
+				b[pos] = random() % alphabet;
+			break;
+		}
+	}
+	return b;
+}
+
+static void CheckRandomSequences()
+{
+	mt19937 random(46);
+	for (int run = 0; run < 3000; run++)
+	{
+		int alphabet = 2 + random() % 6;
+		vector<uint64_t> a(random() % 60);
+		for (size_t i = 0; i < a.size(); i++)
+			a[i] = random() % alphabet;
+		vector<uint64_t> b = run % 2 == 0 ? Mutate(a, random() % 10, alphabet, random) : vector<uint64_t>(random() % 60);
+		if (run % 2 != 0)
+		{
+			for (size_t i = 0; i < b.size(); i++)
+				b[i] = random() % alphabet;
+		}
+		CheckSequences(a, b, "random sequences", true);
+	}
+
+	// long enough, and different enough, for the middle snake, which finds the
+	// shortest scripts of these as they have no tokens that aren't repeated
+	for (int run = 0; run < 6; run++)
+	{
+		int alphabet = 4 + run * 20;
+		vector<uint64_t> a(2000 + random() % 2000);
+		for (size_t i = 0; i < a.size(); i++)
+			a[i] = random() % alphabet;
+		vector<uint64_t> b = run < 3 ? Mutate(a, 1500, alphabet, random) : vector<uint64_t>(a.size() + random() % 100);
+		if (run >= 3)
+		{
+			for (size_t i = 0; i < b.size(); i++)
+				b[i] = random() % alphabet;
+		}
+		CheckSequences(a, b, "long sequences", true);
+	}
+
+	// one short and one long, for the dynamic program
+	for (int run = 0; run < 4; run++)
+	{
+		vector<uint64_t> a(20 + random() % 200);
+		vector<uint64_t> b(3000 + random() % 2000);
+		for (size_t i = 0; i < a.size(); i++)
+			a[i] = random() % 4;
+		for (size_t i = 0; i < b.size(); i++)
+			b[i] = random() % 4;
+		if (run % 2 == 0)
+			a.swap(b);
+		CheckSequences(a, b, "short and long sequences", true);
+	}
+
+	// and for lining up unique tokens first
+	for (int run = 0; run < 6; run++)
+	{
+		int alphabet = 10 + run * 2000;
+		vector<uint64_t> a(3000 + random() % 2000);
+		for (size_t i = 0; i < a.size(); i++)
+			a[i] = random() % alphabet;
+		vector<uint64_t> b = Mutate(a, 1000 + run * 500, alphabet, random);
+		if (run % 2 == 0)
+			b.insert(b.begin() + b.size() / 3, a.begin() + a.size() / 2, a.end());
+		CheckSequences(a, b, "unique tokens", false);
+	}
+}
+
+static void CheckHash()
+{
+	mt19937 random(47);
+	vector<HtmlDiffChar> text(300);
+	for (size_t i = 0; i < text.size(); i++)
+		text[i] = (HtmlDiffChar)(random() % 3 == 0 ? random() : random() % 128);
+	for (size_t start = 0; start < 9; start++)
+	{
+		for (size_t length = 0; start + length <= text.size(); length++)
+		{
+			uint64_t hash = HtmlDiff::Hash(&text[start], length);
+			if (hash != HtmlDiff::HashScalar(&text[start], length))
+			{
+				Expect(false, "hash", "SSE2 and plain differ");
+				return;
+			}
+		}
+	}
+
+	// any character changed changes it
+	uint64_t hash = HtmlDiff::Hash(&text[0], text.size());
+	for (size_t i = 0; i < text.size(); i++)
+	{
+		text[i] ^= 1 << (i % 16);
+		Expect(HtmlDiff::Hash(&text[0], text.size()) != hash, "hash", "change");
+		text[i] ^= 1 << (i % 16);
+	}
+}
+
+static const char* Pieces[] =
+{
+	"<p>", "</p>", "<b>", "</b>", "<a href=\"http://example.com/a?b=1&amp;c=2\">", "</a>", "<br />",
+	"<img src='photo.jpg' alt=\"a > b\">", "<!-- comment -->", "<div class=\"wlWriterEditableSmartContent\">", "</div>",
+	" ", "  ", "\r\n", "\t", "the", "quick", "brown", "fox,", "jumps.", "&nbsp;", "a<b", "<", "x>y",
+};
+
+static string RandomHtml(int pieces, mt19937& random)
+{
+	string html;
+	for (int i = 0; i < pieces; i++)
+		html += Pieces[random() % (sizeof(Pieces) / sizeof(Pieces[0]))];
+	return html;
+}
+
+static string EditHtml(const string& html, int edits, mt19937& random)
+{
+	string edited(html);
+	for (int e = 0; e < edits; e++)
+	{
+		size_t pos = random() % (edited.size() + 1);
+		if (random() % 2 == 0)
+			edited.insert(pos, Pieces[random() % (sizeof(Pieces) / sizeof(Pieces[0]))]);
+		else
+			edited.erase(pos, random() % 12);
+	}
+	return edited;
+}
+
+static void CheckHtml()
+{
+	mt19937 random(48);
+	for (int run = 0; run < 2000; run++)
+	{
+		Html oldHtml = ToHtml(RandomHtml(random() % 80, random));
+		Html newHtml = ToHtml(EditHtml(ToString(oldHtml), random() % 8, random));
+
+		// tokens cover the HTML
+		vector<HtmlDiffToken> tokens;
+		HtmlDiff::Tokenize(oldHtml.data(), (int)oldHtml.size(), 0, tokens);
+		int covered = 0;
+		for (size_t i = 0; i < tokens.size(); i++)
+		{
+			if (tokens[i].start != covered || tokens[i].length <= 0)
+				break;
+			covered += tokens[i].length;
+		}
+		Expect(covered == (int)oldHtml.size(), "tokens", ToString(oldHtml));
+
+		vector<HtmlDiffHunk> hunks;
+		Expect(HtmlDiff::Diff(oldHtml.data(), (int)oldHtml.size(), newHtml.data(), (int)newHtml.size(), 0, 1 << 20, hunks), "diff", ToString(oldHtml));
+		Html applied;
+		int pos = 0;
+		for (size_t i = 0; i < hunks.size(); i++)
+		{
+			applied += oldHtml.substr(pos, hunks[i].oldStart - pos);
+			applied += newHtml.substr(hunks[i].newStart, hunks[i].newLength);
+			pos = hunks[i].oldStart + hunks[i].oldLength;
+		}
+		applied += oldHtml.substr(pos);
+		Expect(applied == newHtml, "applied hunks", ToString(oldHtml) + " -> " + ToString(newHtml));
+		Expect((oldHtml == newHtml) == hunks.empty(), "no hunks", ToString(oldHtml));
+	}
+}
+
+static bool SameSignature(const string& a, const string& b)
+{
+	Html htmlA = ToHtml(a);
+	Html htmlB = ToHtml(b);
+	return HtmlDiff::Signature(htmlA.data(), (int)htmlA.size(), HTML_DIFF_IGNORE_FORMATTING) ==
+		HtmlDiff::Signature(htmlB.data(), (int)htmlB.size(), HTML_DIFF_IGNORE_FORMATTING);
+}
+
+static void CheckFormatting()
+{
+	const char* same[][2] =
+	{
+		{ "<p>Hello   world</p>", "<P>Hello world</P>\r\n" },
+		{ "<p class=\"a\" id='b'>x</p>", "<p CLASS=a  ID=\"b\" >x</p>" },
+		{ "one<br>two", "one<br />two" },
+		{ "<div>\n\t<p>x</p>\n</div>", "<div>\r\n<p>x</p> </div>" },
+		{ "  <p>x</p>\r\n", "<p>x</p>" },
+		{ "<img src=\"a b.jpg\" alt=\"\">", "<IMG SRC='a b.jpg' ALT=''/>" },
+		// only inside a preformatted element is white space kept
+		{ "<pre>a  b</pre> c  d", "<PRE>a  b</PRE> c d" },
+		{ "<pre><pre>a</pre> b</pre>  c", "<pre><pre>a</pre> b</pre> c" },
+		{ "<pre/>a  b", "<pre />a b" },
+	};
+	for (size_t i = 0; i < sizeof(same) / sizeof(same[0]); i++)
+		Expect(SameSignature(same[i][0], same[i][1]), "same signature", same[i][0]);
+
+	const char* different[][2] =
+	{
+		{ "<p>Hello world</p>", "<p>Hello World</p>" },
+		{ "<p>Helloworld</p>", "<p>Hello world</p>" },
+		{ "<p class=\"a\">x</p>", "<p class=\"A\">x</p>" },
+		{ "<img src=\"a b.jpg\">", "<img src=\"a\" b.jpg>" },
+		{ "<!-- a -->", "<!--a-->" },
+		// white space next to markup is there or not, however much of it there is
+		{ "foo <b>bar</b>", "foo<b>bar</b>" },
+		{ "<b>foo</b> bar", "<b>foo</b>bar" },
+		{ "<div>\n<p>x</p></div>", "<div><p>x</p></div>" },
+		{ "x", "" },
+		// preformatted elements show their white space as it is
+		{ "<pre>a  b</pre>", "<pre>a b</pre>" },
+		{ "<PRE class=x>a\n b</PRE>", "<pre class=x>a b</pre>" },
+		{ "<textarea>a\r\nb</textarea>", "<textarea>a\nb</textarea>" },
+		{ "<div style=\"color: red; White-Space : pre-wrap\">a  b</div>", "<div style=\"color: red; White-Space : pre-wrap\">a b</div>" },
+		{ "<pre><b>a</b>  b</pre>", "<pre><b>a</b> b</pre>" },
+		{ "<pre><pre>a</pre>  b</pre>", "<pre><pre>a</pre> b</pre>" },
+	};
+	for (size_t i = 0; i < sizeof(different) / sizeof(different[0]); i++)
+		Expect(!SameSignature(different[i][0], different[i][1]), "different signature", different[i][0]);
+
+	// and the diff finds nothing to change
+	Html a = ToHtml("<p>One   two</p>\n<P CLASS=x>three</P>");
+	Html b = ToHtml("<p>One two</p>\r\n<p class=\"x\">three</p>");
+	vector<HtmlDiffHunk> hunks;
+	HtmlDiff::Diff(a.data(), (int)a.size(), b.data(), (int)b.size(), HTML_DIFF_IGNORE_FORMATTING, 100, hunks);
+	Expect(hunks.empty(), "formatting diff", "hunks");
+}
+
+static string Word(mt19937& random)
+{
+	// words that are rarer the later they come in a vocabulary of 30000, as in
+	// English; most sentences have some that are in the post once
+	static const char* letters = "etaoinshrdlucmfwypvbgkjqxz";
+	double rank = exp(uniform_real_distribution<double>(0, log(30000.0))(random));
+	mt19937 spelling((uint32_t)rank);
+	string word;
+	int length = 2 + spelling() % 8;
+	for (int i = 0; i < length; i++)
+		word += letters[spelling() % (i == 0 ? 26 : 10)];
+	return word;
+}
+
+static string Post(size_t size, mt19937& random)
+{
+	string post;
+	while (post.size() < size)
+	{
+		post += "<p class=\"body\">";
+		int length = 20 + random() % 80;
+		for (int i = 0; i < length; i++)
+		{
+			if (random() % 40 == 0)
+				post += "<a href=\"http://example.com/" + to_string(random() % 1000) + "\">link</a> ";
+			post += Word(random);
+			post += ' ';
+		}
+		post += "</p>\r\n";
+	}
+	return post;
+}
+
+static string Reformat(const string& html)
+{
+	// as a server might store it: bare line feeds, tags in capitals, attributes unquoted
+	string formatted;
+	for (size_t i = 0; i < html.size(); i++)
+	{
+		if (html[i] == '\r')
+			continue;
+		if (html.compare(i, 3, "<p ") == 0 || html.compare(i, 3, "</p") == 0)
+		{
+			formatted += html[i] == '<' && html[i + 1] == '/' ? "</P" : "<P ";
+			i += 2;
+			continue;
+		}
+		if (html.compare(i, 14, "class=\"body\">") == 0)
+		{
+			formatted += "class=body>";
+			i += 12;
+			continue;
+		}
+		formatted += html[i];
+	}
+	return formatted;
+}
+
+static void Measure(const char* name, const Html& a, const Html& b, int flags, int maxDifferences)
+{
+	vector<HtmlDiffHunk> hunks;
+	bool found = false;
+	int runs = 0;
+	auto start = chrono::steady_clock::now();
+	double elapsed;
+	do
+	{
+		found = HtmlDiff::Diff(a.data(), (int)a.size(), b.data(), (int)b.size(), flags, maxDifferences, hunks);
+		runs++;
+		elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	}
+	while (elapsed < 0.5);
+
+	size_t changed = 0;
+	for (size_t i = 0; i < hunks.size(); i++)
+		changed += hunks[i].newLength;
+	if (found)
+		printf("  %-28s %8.2f ms  %6d hunks, %8d characters\n", name, elapsed / runs * 1e3, (int)hunks.size(), (int)changed);
+	else
+		printf("  %-28s %8.2f ms  more than %d differences\n", name, elapsed / runs * 1e3, maxDifferences);
+}
+
+static void Benchmark()
+{
+	mt19937 random(49);
+	string post = Post(1024 * 1024, random);
+	Html a = ToHtml(post);
+	vector<HtmlDiffToken> tokens;
+	HtmlDiff::Tokenize(a.data(), (int)a.size(), 0, tokens);
+	printf("%d characters, %d tokens\n", (int)a.size(), (int)tokens.size());
+
+	auto start = chrono::steady_clock::now();
+	int runs = 0;
+	double elapsed;
+	do
+	{
+		HtmlDiff::Signature(a.data(), (int)a.size(), HTML_DIFF_IGNORE_FORMATTING);
+		runs++;
+		elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	}
+	while (elapsed < 0.5);
+	printf("  %-28s %8.2f ms\n", "signature", elapsed / runs * 1e3);
+
+	string fewEdits = EditHtml(post, 10, random);
+	string manyEdits = EditHtml(post, 1000, random);
+	string inserted = post.substr(0, post.size() / 2) + Post(100 * 1024, random) + post.substr(post.size() / 2);
+	const int maxDifferences = 50000;
+	Measure("same", a, a, 0, maxDifferences);
+	Measure("10 edits", a, ToHtml(fewEdits), 0, maxDifferences);
+	Measure("1000 edits", a, ToHtml(manyEdits), 0, maxDifferences);
+	Measure("100 KB inserted", a, ToHtml(inserted), 0, maxDifferences);
+	Measure("formatted, exact", a, ToHtml(Reformat(post)), 0, maxDifferences);
+	Measure("formatted, ignored", a, ToHtml(Reformat(post)), HTML_DIFF_IGNORE_FORMATTING, maxDifferences);
+	Measure("nothing in common", a, ToHtml(Post(1024 * 1024, random)), 0, maxDifferences);
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc == 2 && strcmp(argv[1], "/benchmark") == 0)
+	{
+		Benchmark();
+		return 0;
+	}
+	if (argc != 1)
+	{
+		printf("usage: HtmlDiffCheck [/benchmark]\n");
+		return 2;
+	}
+
+	CheckHash();
+	CheckRandomSequences();
+	CheckHtml();
+	CheckFormatting();
+
+	printf("%s\n", failures == 0 ? "PASS" : "FAILED");
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,502 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+/*
+Checks the image header reader in OpenLiveWriter.CppUtils (ImageHeaderReader.h)
+and measures it over a folder of photos:
+
+	ImageHeaderReaderCheck [/benchmark folder]
+
+Images of every format it knows are put together here a header at a time,
+JPEGs with and without EXIF in either byte order, with thumbnails, large
+segments before the frame and fill bytes, and what it reads from them is
+compared with what they were made with. Every truncation of them and
+thousands of corruptions are read too, which must not read out of bounds
+(build with -fsanitize=address to be sure) and must not report anything a
+truncated image doesn't have. Exits with 1 if anything differs.
+
+The benchmark reads the headers of every file in the folder from disk,
+reporting the time and bytes read per image against the size of the files,
+which is what decoding them has to read.
+
+It needs C++17 for std::filesystem, to walk the folder of images:
+
+	c++ -std=c++17 -O2 -o ImageHeaderReaderCheck ImageHeaderReaderCheck.cpp
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../../src/unmanaged/OpenLiveWriter.CppUtils/Include/ImageHeaderReader.h"
+
+using namespace std;
+
+class MemorySource : public ImageHeaderSource
+{
+public:
+	MemorySource(const vector<uint8_t>& bytes)
+		: bytes(bytes)
+	{
+	}
+
+	virtual size_t ReadAt(uint64_t offset, uint8_t* buffer, size_t count)
+	{
+		if (offset >= bytes.size())
+			return 0;
+		count = min(count, bytes.size() - (size_t)offset);
+		memcpy(buffer, &bytes[(size_t)offset], count);
+		return count;
+	}
+
+private:
+	const vector<uint8_t>& bytes;
+};
+
+class FileSource : public ImageHeaderSource
+{
+public:
+	FileSource(FILE* file)
+		: file(file)
+	{
+	}
+
+	virtual size_t ReadAt(uint64_t offset, uint8_t* buffer, size_t count)
+	{
+		if (fseek(file, (long)offset, SEEK_SET) != 0)
+			return 0;
+		return fread(buffer, 1, count, file);
+	}
+
+private:
+	FILE* file;
+};
+
+// Puts an image together a field at a time.
+class Builder
+{
+public:
+	vector<uint8_t> bytes;
+	bool bigEndian = true;
+
+	Builder& Bytes(const char* text, size_t length)
+	{
+		bytes.insert(bytes.end(), text, text + length);
+		return *this;
+	}
+
+	Builder& Text(const char* text)
+	{
+		return Bytes(text, strlen(text));
+	}
+
+	Builder& U8(uint32_t value)
+	{
+		bytes.push_back((uint8_t)value);
+		return *this;
+	}
+
+	Builder& U16(uint32_t value)
+	{
+		return bigEndian ? U8(value >> 8).U8(value) : U8(value).U8(value >> 8);
+	}
+
+	Builder& U24(uint32_t value)
+	{
+		return bigEndian ? U8(value >> 16).U8(value >> 8).U8(value) : U8(value).U8(value >> 8).U8(value >> 16);
+	}
+
+	Builder& U32(uint32_t value)
+	{
+		return bigEndian ? U16(value >> 16).U16(value) : U16(value).U16(value >> 16);
+	}
+
+	Builder& Fill(size_t count, uint8_t value)
+	{
+		bytes.insert(bytes.end(), count, value);
+		return *this;
+	}
+
+	Builder& Append(const vector<uint8_t>& more)
+	{
+		bytes.insert(bytes.end(), more.begin(), more.end());
+		return *this;
+	}
+
+	// A JPEG segment holding contents.
+	Builder& Segment(uint8_t marker, const vector<uint8_t>& contents)
+	{
+		bool wasBigEndian = bigEndian;
+		bigEndian = true;
+		U8(0xFF).U8(marker).U16((uint32_t)contents.size() + 2).Append(contents);
+		bigEndian = wasBigEndian;
+		return *this;
+	}
+};
+
+struct JpegOptions
+{
+	int width = 4000;
+	int height = 3000;
+	uint8_t frameMarker = 0xC0;
+	bool jfif = true;
+	bool exif = true;
+	bool exifBigEndian = true;
+	int orientation = 6;
+	bool thumbnail = true;
+	size_t largeSegment = 0;	// an APP2 of this size before the frame, as ICC profiles are
+	bool fillBytes = false;
+	size_t scanLength = 100000;
+};
+
+// the thumbnail's "JPEG"
+static const size_t ThumbnailLength = 3000;
+
+static vector<uint8_t> Exif(const JpegOptions& options, size_t* thumbnailOffset)
+{
+	// TIFF header, IFD0 with some entries around the orientation, IFD1 with the thumbnail
+	Builder tiff;
+	tiff.bigEndian = options.exifBigEndian;
+	tiff.Text(options.exifBigEndian ? "MM" : "II").U16(42).U32(8);
+
+	uint32_t ifd0Entries = options.orientation != 0 ? 3 : 2;
+	uint32_t ifd1 = 8 + 2 + ifd0Entries * 12 + 4;
+	tiff.U16(ifd0Entries);
+	tiff.U16(0x010F).U16(2).U32(4).Text("Foo").U8(0);	// Make
+	if (options.orientation != 0)
+		tiff.U16(0x0112).U16(3).U32(1).U16(options.orientation).U16(0);
+	tiff.U16(0x0131).U16(2).U32(4).Text("Bar").U8(0);	// Software
+	tiff.U32(options.thumbnail ? ifd1 : 0);
+
+	if (options.thumbnail)
+	{
+		uint32_t thumbnail = ifd1 + 2 + 3 * 12 + 4;
+		tiff.U16(3);
+		tiff.U16(0x0103).U16(3).U32(1).U16(6).U16(0);	// Compression
+		tiff.U16(0x0201).U16(4).U32(1).U32(thumbnail);
+		tiff.U16(0x0202).U16(4).U32(1).U32((uint32_t)ThumbnailLength);
+		tiff.U32(0);
+		tiff.U8(0xFF).U8(0xD8).Fill(ThumbnailLength - 4, 0x55).U8(0xFF).U8(0xD9);
+		*thumbnailOffset = thumbnail;
+	}
+
+	Builder exif;
+	exif.Bytes("Exif\0\0", 6).Append(tiff.bytes);
+	return exif.bytes;
+}
+
+static vector<uint8_t> Jpeg(const JpegOptions& options, size_t* thumbnailOffset)
+{
+	Builder jpeg;
+	jpeg.U8(0xFF).U8(0xD8);
+	if (options.jfif)
+		jpeg.Segment(0xE0, Builder().Bytes("JFIF\0\x01\x01\0\0\x01\0\x01\0\0", 14).bytes);
+
+	*thumbnailOffset = 0;
+	if (options.exif)
+	{
+		size_t start = jpeg.bytes.size() + 4 + 6;
+		size_t offset = 0;
+		jpeg.Segment(0xE1, Exif(options, &offset));
+		if (offset != 0)
+			*thumbnailOffset = start + offset;
+	}
+
+	if (options.largeSegment > 0)
+		jpeg.Segment(0xE2, vector<uint8_t>(options.largeSegment, 0x33));
+	jpeg.Segment(0xDB, vector<uint8_t>(65, 1));
+	if (options.fillBytes)
+		jpeg.U8(0xFF).U8(0xFF).U8(0xFF);
+	jpeg.Segment(options.frameMarker, Builder().U8(8).U16(options.height).U16(options.width).U8(3).Fill(9, 0x11).bytes);
+	jpeg.Segment(0xC4, vector<uint8_t>(30, 2));
+	jpeg.Segment(0xDA, vector<uint8_t>(10, 0));
+	jpeg.Fill(options.scanLength, 0xA5).U8(0xFF).U8(0xD9);
+	return jpeg.bytes;
+}
+
+static vector<uint8_t> Png(uint32_t width, uint32_t height)
+{
+	Builder png;
+	png.Bytes("\x89PNG\r\n\x1A\n", 8).U32(13).Text("IHDR").U32(width).U32(height).U8(8).U8(6).U8(0).U8(0).U8(0).U32(0);
+	png.U32(0).Text("IEND").U32(0xAE426082);
+	return png.bytes;
+}
+
+static vector<uint8_t> Gif(uint32_t width, uint32_t height)
+{
+	Builder gif;
+	gif.bigEndian = false;
+	gif.Text("GIF89a").U16(width).U16(height).U8(0).U8(0).U8(0).U8(0x3B);
+	return gif.bytes;
+}
+
+static vector<uint8_t> Bmp(int32_t width, int32_t height, bool core)
+{
+	Builder bmp;
+	bmp.bigEndian = false;
+	bmp.Text("BM").U32(0).U32(0).U32(0);
+	if (core)
+		bmp.U32(12).U16(width).U16(height).U16(1).U16(24);
+	else
+		bmp.U32(40).U32(width).U32((uint32_t)height).U16(1).U16(24).Fill(24, 0);
+	return bmp.bytes;
+}
+
+static vector<uint8_t> WebP(const char* kind, uint32_t width, uint32_t height)
+{
+	Builder chunk;
+	chunk.bigEndian = false;
+	if (strcmp(kind, "VP8 ") == 0)
+		chunk.U24(0).U8(0x9D).U8(0x01).U8(0x2A).U16(width).U16(height).Fill(20, 0);
+	else if (strcmp(kind, "VP8L") == 0)
+		chunk.U8(0x2F).U32((width - 1) | ((height - 1) << 14)).Fill(20, 0);
+	else
+		chunk.U8(0x08).U24(0).U24(width - 1).U24(height - 1);
+
+	Builder webp;
+	webp.bigEndian = false;
+	webp.Text("RIFF").U32((uint32_t)chunk.bytes.size() + 12).Text("WEBP").Text(kind).U32((uint32_t)chunk.bytes.size()).Append(chunk.bytes);
+	return webp.bytes;
+}
+
+static int failures = 0;
+
+static void Expect(bool condition, const char* what, const string& detail)
+{
+	if (!condition)
+	{
+		printf("FAIL %s: %s\n", what, detail.c_str());
+		failures++;
+	}
+}
+
+static ImageHeader Read(const vector<uint8_t>& bytes)
+{
+	MemorySource source(bytes);
+	ImageHeader header;
+	ImageHeaderReader::Read(source, &header);
+	return header;
+}
+
+static void ExpectHeader(const vector<uint8_t>& bytes, const ImageHeader& expected, const string& name)
+{
+	ImageHeader header = Read(bytes);
+	Expect(header.format == expected.format, "format", name);
+	Expect(header.width == expected.width && header.height == expected.height, "size", name);
+	Expect(header.orientation == expected.orientation, "orientation", name);
+	Expect(header.thumbnailOffset == expected.thumbnailOffset && header.thumbnailLength == expected.thumbnailLength, "thumbnail", name);
+	Expect(header.bytesRead <= 4 * (int)IMAGE_HEADER_WINDOW, "read a few KB", name);
+
+	// a truncated image is either read the same or not at all, besides its thumbnail
+	for (size_t length = 0; length < min(bytes.size(), (size_t)3 * IMAGE_HEADER_WINDOW); length++)
+	{
+		vector<uint8_t> truncated(bytes.begin(), bytes.begin() + length);
+		ImageHeader partial = Read(truncated);
+		bool same = partial.format == expected.format && partial.width == expected.width && partial.height == expected.height
+			&& partial.thumbnailOffset + partial.thumbnailLength <= (int64_t)length;
+		Expect(partial.format == IMAGE_HEADER_UNKNOWN || same, "truncated", name + " at " + to_string(length));
+	}
+}
+
+static ImageHeader Expected(int format, int width, int height, int orientation = 0, size_t thumbnailOffset = 0, size_t thumbnailLength = 0)
+{
+	ImageHeader header = {};
+	header.format = format;
+	header.width = width;
+	header.height = height;
+	header.orientation = orientation;
+	header.thumbnailOffset = thumbnailOffset;
+	header.thumbnailLength = (int32_t)thumbnailLength;
+	return header;
+}
+
+static void CheckJpegs()
+{
+	const uint8_t frameMarkers[] = { 0xC0, 0xC1, 0xC2, 0xC3, 0xC9, 0xCF };
+	for (size_t i = 0; i < sizeof(frameMarkers); i++)
+	{
+		for (int bigEndian = 0; bigEndian <= 1; bigEndian++)
+		{
+			JpegOptions options;
+			options.frameMarker = frameMarkers[i];
+			options.exifBigEndian = bigEndian != 0;
+			options.orientation = 1 + (int)i;
+			size_t thumbnail;
+			vector<uint8_t> jpeg = Jpeg(options, &thumbnail);
+
+			char name[100];
+			snprintf(name, sizeof(name), "JPEG SOF %02X, %s EXIF", frameMarkers[i], bigEndian ? "big endian" : "little endian");
+			ExpectHeader(jpeg, Expected(IMAGE_HEADER_JPEG, 4000, 3000, options.orientation, thumbnail, ThumbnailLength), name);
+			Expect(jpeg[thumbnail] == 0xFF && jpeg[thumbnail + 1] == 0xD8 && jpeg[thumbnail + ThumbnailLength - 1] == 0xD9, "thumbnail in place", name);
+		}
+	}
+
+	size_t thumbnail;
+	JpegOptions plain;
+	plain.exif = false;
+	ExpectHeader(Jpeg(plain, &thumbnail), Expected(IMAGE_HEADER_JPEG, 4000, 3000), "JPEG without EXIF");
+
+	JpegOptions bare;
+	bare.jfif = false;
+	bare.width = 65535;
+	bare.height = 1;
+	vector<uint8_t> jpeg = Jpeg(bare, &thumbnail);
+	ExpectHeader(jpeg, Expected(IMAGE_HEADER_JPEG, 65535, 1, 6, thumbnail, ThumbnailLength), "JPEG without JFIF");
+
+	JpegOptions noThumbnail;
+	noThumbnail.thumbnail = false;
+	noThumbnail.orientation = 0;
+	ExpectHeader(Jpeg(noThumbnail, &thumbnail), Expected(IMAGE_HEADER_JPEG, 4000, 3000), "JPEG with EXIF but no orientation or thumbnail");
+
+	JpegOptions large;
+	large.largeSegment = 60000;
+	large.fillBytes = true;
+	jpeg = Jpeg(large, &thumbnail);
+	ExpectHeader(jpeg, Expected(IMAGE_HEADER_JPEG, 4000, 3000, 6, thumbnail, ThumbnailLength), "JPEG with a large segment and fill bytes");
+
+	// tables only, and the scan before the frame
+	Builder tables;
+	tables.U8(0xFF).U8(0xD8).Segment(0xDB, vector<uint8_t>(65, 1)).U8(0xFF).U8(0xD9);
+	ExpectHeader(tables.bytes, Expected(IMAGE_HEADER_UNKNOWN, 0, 0), "JPEG without a frame");
+
+	// a thumbnail said to run past the EXIF is left out
+	JpegOptions options;
+	jpeg = Jpeg(options, &thumbnail);
+	for (size_t i = 0; i + 4 <= jpeg.size(); i++)
+	{
+		if (jpeg[i] == 0x02 && jpeg[i + 1] == 0x02 && jpeg[i + 2] == 0x00 && jpeg[i + 3] == 0x04)
+		{
+			jpeg[i + 8] = 0x7F;
+			break;
+		}
+	}
+	ImageHeader header = Read(jpeg);
+	Expect(header.format == IMAGE_HEADER_JPEG && header.thumbnailLength == 0 && header.orientation == 6, "thumbnail out of bounds", "JPEG");
+}
+
+static void CheckOthers()
+{
+	ExpectHeader(Png(1, 1), Expected(IMAGE_HEADER_PNG, 1, 1), "PNG");
+	ExpectHeader(Png(12000, 8000), Expected(IMAGE_HEADER_PNG, 12000, 8000), "large PNG");
+	ExpectHeader(Png(0x80000000u, 10), Expected(IMAGE_HEADER_UNKNOWN, 0, 0), "PNG too large");
+	ExpectHeader(Gif(640, 480), Expected(IMAGE_HEADER_GIF, 640, 480), "GIF");
+	ExpectHeader(Bmp(800, 600, false), Expected(IMAGE_HEADER_BMP, 800, 600), "BMP");
+	ExpectHeader(Bmp(800, -600, false), Expected(IMAGE_HEADER_BMP, 800, 600), "top down BMP");
+	ExpectHeader(Bmp(300, 200, true), Expected(IMAGE_HEADER_BMP, 300, 200), "OS/2 BMP");
+	ExpectHeader(WebP("VP8 ", 1920, 1080), Expected(IMAGE_HEADER_WEBP, 1920, 1080), "lossy WebP");
+	ExpectHeader(WebP("VP8L", 16383, 1), Expected(IMAGE_HEADER_WEBP, 16383, 1), "lossless WebP");
+	ExpectHeader(WebP("VP8X", 20000, 16384), Expected(IMAGE_HEADER_WEBP, 20000, 16384), "extended WebP");
+
+	vector<uint8_t> text(5000, 'x');
+	ExpectHeader(text, Expected(IMAGE_HEADER_UNKNOWN, 0, 0), "not an image");
+	ExpectHeader(vector<uint8_t>(), Expected(IMAGE_HEADER_UNKNOWN, 0, 0), "empty");
+}
+
+static void CheckCorruptions()
+{
+	// whatever they say, corrupted images mustn't be read out of bounds or report nonsense
+	vector<vector<uint8_t>> images;
+	size_t thumbnail;
+	JpegOptions little;
+	little.exifBigEndian = false;
+	little.scanLength = 100;
+	JpegOptions big;
+	big.scanLength = 100;
+	images.push_back(Jpeg(little, &thumbnail));
+	images.push_back(Jpeg(big, &thumbnail));
+	images.push_back(Png(100, 100));
+	images.push_back(Bmp(100, 100, false));
+	images.push_back(WebP("VP8X", 100, 100));
+
+	mt19937 random(44);
+	for (size_t i = 0; i < images.size(); i++)
+	{
+		for (int run = 0; run < 5000; run++)
+		{
+			vector<uint8_t> corrupt = images[i];
+			for (int flips = 1 + random() % 4; flips > 0; flips--)
+				corrupt[random() % min(corrupt.size(), (size_t)200)] = (uint8_t)random();
+
+			ImageHeader header = Read(corrupt);
+			bool sensible = header.format == IMAGE_HEADER_UNKNOWN
+				|| (header.width > 0 && header.height > 0 && header.orientation >= 0 && header.orientation <= 8
+				&& header.thumbnailOffset >= 0 && header.thumbnailOffset + header.thumbnailLength <= (int64_t)corrupt.size());
+			Expect(sensible, "corrupt", to_string(i) + " run " + to_string(run));
+		}
+	}
+}
+
+static void Benchmark(const char* folder)
+{
+	vector<string> paths;
+	for (const auto& entry : filesystem::directory_iterator(folder))
+	{
+		if (entry.is_regular_file())
+			paths.push_back(entry.path().string());
+	}
+
+	size_t images = 0;
+	uint64_t fileBytes = 0;
+	uint64_t bytesRead = 0;
+	double seconds = 0;
+	for (size_t i = 0; i < paths.size(); i++)
+	{
+		FILE* file = fopen(paths[i].c_str(), "rb");
+		if (file == NULL)
+			continue;
+
+		auto start = chrono::steady_clock::now();
+		FileSource source(file);
+		ImageHeader header;
+		bool read = ImageHeaderReader::Read(source, &header);
+		seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+		fseek(file, 0, SEEK_END);
+		long size = ftell(file);
+		fclose(file);
+		if (!read)
+		{
+			printf("  not read: %s\n", paths[i].c_str());
+			continue;
+		}
+
+		images++;
+		fileBytes += size;
+		bytesRead += header.bytesRead;
+		printf("  %dx%d orientation %d thumbnail %d bytes, read %d of %ld bytes: %s\n",
+			header.width, header.height, header.orientation, header.thumbnailLength, header.bytesRead, size, paths[i].c_str());
+	}
+
+	if (images == 0)
+	{
+		printf("no images in %s\n", folder);
+		return;
+	}
+	printf("%d images, %.1f MB: %.1f us and %.1f KB read per image, %.1f MB per image to decode\n",
+		(int)images, fileBytes / 1e6, seconds / images * 1e6, bytesRead / 1e3 / images, fileBytes / 1e6 / images);
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc == 3 && strcmp(argv[1], "/benchmark") == 0)
+	{
+		Benchmark(argv[2]);
+		return 0;
+	}
+	if (argc != 1)
+	{
+		printf("usage: ImageHeaderReaderCheck [/benchmark folder]\n");
+		return 2;
+	}
+
+	CheckJpegs();
+	CheckOthers();
+	CheckCorruptions();
+
+	printf("%s\n", failures == 0 ? "PASS" : "FAILED");
+	return failures == 0 ? 0 : 1;
+}
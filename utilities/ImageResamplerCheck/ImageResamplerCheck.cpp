@@ -0,0 +1,309 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+/*
+Checks the image resampler in OpenLiveWriter.CppUtils (ImageResampler.h) and
+measures its throughput:
+
+	ImageResamplerCheck [/benchmark]
+
+Every combination of kernels (plain C++, SSE2, AVX2, as far as the processor
+goes), thread count and pre-shrink is compared byte for byte with a simple
+reference here, which resamples the whole image one way and then the other
+with the same weights, without tiles, bands or vector instructions. Exits
+with 1 if any of them differ.
+
+Bands are resampled on several threads, hence -pthread:
+
+	c++ -std=c++11 -O2 -msse2 -pthread -o ImageResamplerCheck ImageResamplerCheck.cpp
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "../../src/unmanaged/OpenLiveWriter.CppUtils/Include/ImageResampler.h"
+
+using namespace std;
+
+struct Image
+{
+	int width;
+	int height;
+	int channels;
+	vector<uint8_t> pixels;
+
+	Image(int width, int height, int channels)
+		: width(width), height(height), channels(channels), pixels((size_t)width * height * channels)
+	{
+	}
+
+	int Stride() const
+	{
+		return width * channels;
+	}
+
+	uint8_t* Row(int y)
+	{
+		return &pixels[(size_t)y * Stride()];
+	}
+};
+
+static const char* FilterNames[] = { "box", "bicubic", "lanczos" };
+static const char* KernelNames[] = { "best", "scalar", "sse2", "avx2" };
+
+// Something like a photo: gradients, edges and noise.
+static Image MakeImage(int width, int height, int channels, unsigned seed)
+{
+	Image image(width, height, channels);
+	mt19937 random(seed);
+	for (int y = 0; y < height; y++)
+	{
+		uint8_t* row = image.Row(y);
+		for (int x = 0; x < width; x++)
+		{
+			for (int c = 0; c < channels; c++)
+			{
+				int value = (x * (c + 1) * 255 / width + y * 255 / height) / 2;
+				if (((x / 7) + (y / 5)) % 4 == 0)
+					value = 255 - value;
+				value += (int)(random() % 41) - 20;
+				row[x * channels + c] = (uint8_t)min(max(value, 0), 255);
+			}
+		}
+	}
+	return image;
+}
+
+static uint8_t Clamp(int32_t sum)
+{
+	sum >>= IMAGE_RESAMPLER_PRECISION;
+	return (uint8_t)(sum < 0 ? 0 : sum > 255 ? 255 : sum);
+}
+
+static Image Reference(Image& source, int width, int height, ImageResampleFilter filter, bool preshrink)
+{
+	int channels = source.channels;
+
+	// pre-shrink the whole image
+	int reduceX = preshrink ? ImageResampler::ReduceFactor(source.width, width) : 1;
+	int reduceY = preshrink ? ImageResampler::ReduceFactor(source.height, height) : 1;
+	Image reduced((source.width + reduceX - 1) / reduceX, (source.height + reduceY - 1) / reduceY, channels);
+	for (int y = 0; y < reduced.height; y++)
+	{
+		for (int x = 0; x < reduced.width; x++)
+		{
+			for (int c = 0; c < channels; c++)
+			{
+				uint32_t sum = 0, count = 0;
+				for (int sy = y * reduceY; sy < min((y + 1) * reduceY, source.height); sy++)
+				{
+					for (int sx = x * reduceX; sx < min((x + 1) * reduceX, source.width); sx++)
+					{
+						sum += source.Row(sy)[sx * channels + c];
+						count++;
+					}
+				}
+				reduced.Row(y)[x * channels + c] = (uint8_t)((sum + count / 2) / count);
+			}
+		}
+	}
+
+	ImageResampleTaps tapsX, tapsY;
+	ImageResampler::ComputeTaps(reduced.width, (double)source.width / reduceX, width, filter, &tapsX);
+	ImageResampler::ComputeTaps(reduced.height, (double)source.height / reduceY, height, filter, &tapsY);
+
+	Image horizontal(width, reduced.height, channels);
+	for (int y = 0; y < reduced.height; y++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			for (int c = 0; c < channels; c++)
+			{
+				int32_t sum = 1 << (IMAGE_RESAMPLER_PRECISION - 1);
+				for (int k = 0; k < tapsX.counts[x]; k++)
+					sum += reduced.Row(y)[(tapsX.starts[x] + k) * channels + c] * tapsX.weights[(size_t)x * tapsX.stride + k];
+				horizontal.Row(y)[x * channels + c] = Clamp(sum);
+			}
+		}
+	}
+
+	Image result(width, height, channels);
+	for (int y = 0; y < height; y++)
+	{
+		for (int i = 0; i < width * channels; i++)
+		{
+			int32_t sum = 1 << (IMAGE_RESAMPLER_PRECISION - 1);
+			for (int k = 0; k < tapsY.counts[y]; k++)
+				sum += horizontal.Row(tapsY.starts[y] + k)[i] * tapsY.weights[(size_t)y * tapsY.stride + k];
+			result.Row(y)[i] = Clamp(sum);
+		}
+	}
+	return result;
+}
+
+static Image FlipRows(Image& image)
+{
+	Image flipped(image.width, image.height, image.channels);
+	for (int y = 0; y < image.height; y++)
+		memcpy(flipped.Row(image.height - 1 - y), image.Row(y), image.Stride());
+	return flipped;
+}
+
+static Image Resample(Image& source, int width, int height, ImageResampleFilter filter, const ImageResampleOptions& options, bool bottomUp = false)
+{
+	Image result(width, height, source.channels);
+	bool resampled;
+	if (bottomUp)
+	{
+		// the same picture, stored from the bottom row up
+		Image stored = FlipRows(source);
+		resampled = ImageResampler::Resample(stored.Row(source.height - 1), source.width, source.height, -source.Stride(),
+			result.Row(height - 1), width, height, -result.Stride(), source.channels, filter, options);
+		result = FlipRows(result);
+	}
+	else
+	{
+		resampled = ImageResampler::Resample(source.Row(0), source.width, source.height, source.Stride(),
+			result.Row(0), width, height, result.Stride(), source.channels, filter, options);
+	}
+	if (!resampled)
+		result.width = 0;
+	return result;
+}
+
+static int failures = 0;
+
+static void Expect(bool condition, const char* what, const char* detail)
+{
+	if (!condition)
+	{
+		printf("FAIL %s: %s\n", what, detail);
+		failures++;
+	}
+}
+
+static void CheckSizes(int sourceWidth, int sourceHeight, int width, int height, int channels)
+{
+	Image source = MakeImage(sourceWidth, sourceHeight, channels, sourceWidth * 31 + sourceHeight);
+	ImageResampleKernels best = ImageResampler::ChooseKernels(IMAGE_RESAMPLE_BEST_KERNELS);
+	for (int filter = IMAGE_RESAMPLE_BOX; filter <= IMAGE_RESAMPLE_LANCZOS; filter++)
+	{
+		for (int preshrink = 0; preshrink < 2; preshrink++)
+		{
+			Image expected = Reference(source, width, height, (ImageResampleFilter)filter, preshrink != 0);
+			for (int kernels = IMAGE_RESAMPLE_SCALAR_KERNELS; kernels <= best; kernels++)
+			{
+				for (int threads = 1; threads <= 8; threads += 7)
+				{
+					ImageResampleOptions options;
+					options.kernels = (ImageResampleKernels)kernels;
+					options.threads = threads;
+					options.preshrink = preshrink != 0;
+					Image actual = Resample(source, width, height, (ImageResampleFilter)filter, options, threads == 8);
+
+					char detail[200];
+					snprintf(detail, sizeof(detail), "%dx%d to %dx%d, %d channels, %s, %s kernels, %d threads%s",
+						sourceWidth, sourceHeight, width, height, channels, FilterNames[filter], KernelNames[kernels], threads,
+						preshrink ? ", pre-shrunk" : "");
+					Expect(actual.width == width && actual.pixels == expected.pixels, "same as reference", detail);
+				}
+			}
+		}
+	}
+}
+
+static void CheckProperties()
+{
+	ImageResampleOptions options;
+
+	// resampling to the same size changes nothing
+	Image source = MakeImage(123, 77, 4, 1);
+	for (int filter = IMAGE_RESAMPLE_BOX; filter <= IMAGE_RESAMPLE_LANCZOS; filter++)
+		Expect(Resample(source, 123, 77, (ImageResampleFilter)filter, options).pixels == source.pixels, "same size is unchanged", FilterNames[filter]);
+
+	// a flat color stays flat, even through the negative lobes
+	Image flat(301, 199, 3);
+	for (size_t i = 0; i < flat.pixels.size(); i++)
+		flat.pixels[i] = (uint8_t)(i % 3 == 0 ? 200 : i % 3 == 1 ? 17 : 255);
+	for (int filter = IMAGE_RESAMPLE_BOX; filter <= IMAGE_RESAMPLE_LANCZOS; filter++)
+	{
+		Image shrunk = Resample(flat, 40, 27, (ImageResampleFilter)filter, options);
+		Image grown = Resample(flat, 700, 500, (ImageResampleFilter)filter, options);
+		bool same = true;
+		for (size_t i = 0; i < shrunk.pixels.size(); i++)
+			same = same && shrunk.pixels[i] == flat.pixels[i % 3];
+		for (size_t i = 0; i < grown.pixels.size(); i++)
+			same = same && grown.pixels[i] == flat.pixels[i % 3];
+		Expect(same, "flat color stays flat", FilterNames[filter]);
+	}
+
+	// nonsense is refused
+	uint8_t pixel[4] = { 0 };
+	Expect(!ImageResampler::Resample(pixel, 1, 1, 4, pixel, 0, 1, 4, 4, IMAGE_RESAMPLE_BICUBIC), "refuses", "empty destination");
+	Expect(!ImageResampler::Resample(pixel, 1, 1, 4, pixel, 1, 1, 4, 2, IMAGE_RESAMPLE_BICUBIC), "refuses", "2 channels");
+	Expect(!ImageResampler::Resample(pixel, 2, 1, 4, pixel, 1, 1, 4, 4, IMAGE_RESAMPLE_BICUBIC), "refuses", "short stride");
+}
+
+static void Benchmark(int sourceWidth, int sourceHeight, int width, int height, ImageResampleFilter filter)
+{
+	Image source = MakeImage(sourceWidth, sourceHeight, 3, 7);
+	ImageResampleKernels best = ImageResampler::ChooseKernels(IMAGE_RESAMPLE_BEST_KERNELS);
+	printf("%dx%d to %dx%d, %s\n", sourceWidth, sourceHeight, width, height, FilterNames[filter]);
+	for (int preshrink = 0; preshrink < 2; preshrink++)
+	{
+		for (int kernels = IMAGE_RESAMPLE_SCALAR_KERNELS; kernels <= best; kernels++)
+		{
+			for (int threads = 1; threads <= 2; threads++)
+			{
+				ImageResampleOptions options;
+				options.kernels = (ImageResampleKernels)kernels;
+				options.threads = threads == 1 ? 1 : 0;
+				options.preshrink = preshrink != 0;
+
+				const int runs = 3;
+				auto start = chrono::steady_clock::now();
+				for (int i = 0; i < runs; i++)
+					Resample(source, width, height, filter, options);
+				double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count() / runs;
+				printf("  %-6s %-10s %-12s %8.1f ms %8.1f megapixels/s\n", KernelNames[kernels], threads == 1 ? "1 thread" : "all cores",
+					preshrink ? "pre-shrunk" : "", seconds * 1e3, (double)sourceWidth * sourceHeight / seconds / 1e6);
+			}
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc == 2 && strcmp(argv[1], "/benchmark") == 0)
+	{
+		// a 24 megapixel photo, inserted at a typical width, and a thumbnail of it
+		Benchmark(6000, 4000, 1024, 683, IMAGE_RESAMPLE_BICUBIC);
+		Benchmark(6000, 4000, 1024, 683, IMAGE_RESAMPLE_LANCZOS);
+		Benchmark(6000, 4000, 240, 160, IMAGE_RESAMPLE_BICUBIC);
+		Benchmark(640, 480, 1600, 1200, IMAGE_RESAMPLE_LANCZOS);
+		return 0;
+	}
+	if (argc != 1)
+	{
+		printf("usage: ImageResamplerCheck [/benchmark]\n");
+		return 2;
+	}
+
+	CheckProperties();
+	CheckSizes(1, 1, 5, 3, 4);
+	CheckSizes(7, 5, 1, 1, 3);
+	CheckSizes(17, 9, 640, 480, 4);
+	CheckSizes(640, 480, 97, 61, 3);
+	CheckSizes(640, 480, 640, 97, 4);
+	CheckSizes(333, 250, 1000, 250, 3);
+	CheckSizes(3000, 2000, 300, 200, 3);
+	CheckSizes(2001, 1999, 33, 1000, 4);
+	CheckSizes(1200, 800, 1199, 801, 3);
+
+	ImageResampleKernels best = ImageResampler::ChooseKernels(IMAGE_RESAMPLE_BEST_KERNELS);
+	printf("%s (kernels up to %s)\n", failures == 0 ? "PASS" : "FAILED", KernelNames[best]);
+	return failures == 0 ? 0 : 1;
+}
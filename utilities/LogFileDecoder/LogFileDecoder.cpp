@@ -0,0 +1,520 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+/*
+Prints the binary logs LogFile writes (LogRecordFormat.h) as the CSV lines it
+used to write, one per entry:
+
+	LogFileDecoder <log.olwlog>...
+	LogFileDecoder /check
+	LogFileDecoder /benchmark
+
+facility,pid,category,sequence,MM-DD-YYYY HH:MM:SS (UTC),"message",""
+
+An entry whose process has no SESSION record (its log was deleted while it
+ran) gets an empty facility, and one whose location wasn't recorded gets
+"Line 0, ? (?)". A log that ends in a record cut short is printed up to it,
+with a warning. Exits with 1 if a file can't be read or isn't a log.
+
+/check writes entries the way LogFile does, some from several processes
+interleaved, and compares the decoded lines with the ones LogFile used to
+format; then decodes every truncation of the log and random damage to it
+(build with -fsanitize=address to be sure nothing is read out of bounds).
+Exits with 1 if anything differs.
+
+/benchmark measures entries per second and bytes per entry for the binary
+records and the CSV lines, building them as LogFile does without writing
+them to a file, on 30 call sites with real-looking source paths.
+
+	c++ -std=c++11 -O2 -o LogFileDecoder LogFileDecoder.cpp
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../../src/unmanaged/OpenLiveWriter.CppUtils/Include/LogRecordFormat.h"
+
+using namespace std;
+
+static int failures = 0;
+
+static void Expect(bool condition, const char* what, const string& detail)
+{
+	if (!condition)
+	{
+		printf("FAIL %s: %s\n", what, detail.c_str());
+		failures++;
+	}
+}
+
+// FILETIME (100ns ticks since 1601) to the SYSTEMTIME fields LogFile printed
+struct Time
+{
+	unsigned year, month, day, hour, minute, second;
+};
+
+static Time ToTime(uint64_t ticks)
+{
+	uint64_t seconds = ticks / 10000000;
+	// days since 1970 for the civil calendar below; 1601 to 1970 is 134774 days
+	int64_t days = (int64_t)(seconds / 86400) - 134774;
+	uint64_t secondOfDay = seconds % 86400;
+
+	days += 719468;
+	int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+	unsigned dayOfEra = (unsigned)(days - era * 146097);
+	unsigned yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+	unsigned dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+	unsigned monthIndex = (5 * dayOfYear + 2) / 153;
+
+	Time time;
+	time.day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+	time.month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+	time.year = (unsigned)(yearOfEra + era * 400) + (time.month <= 2 ? 1 : 0);
+	time.hour = (unsigned)(secondOfDay / 3600);
+	time.minute = (unsigned)(secondOfDay / 60 % 60);
+	time.second = (unsigned)(secondOfDay % 60);
+	return time;
+}
+
+// the message and line LogFile.h formatted before it wrote records
+static string FormatMessage(uint8_t kind, uint32_t hr, long line, const char* file, const char* timestamp)
+{
+	char message[2 * LOG_RECORD_MAX_STRING + 64];
+	if (kind == LOG_RECORD_ASSERT)
+		snprintf(message, sizeof(message), "ASSERT Failed: Line %ld, %s (%s)", line, file, timestamp);
+	else
+		snprintf(message, sizeof(message), "HRESULT %#08x: Line %ld, %s (%s)", hr, line, file, timestamp);
+	return message;
+}
+
+static string FormatLine(const char* facility, unsigned long pid, const char* category, long sequence, uint64_t ticks, const string& message)
+{
+	Time time = ToTime(ticks);
+	char line[3 * LOG_RECORD_MAX_STRING + 128];
+	snprintf(line, sizeof(line), "%s,%lu,%s,%05ld,%02u-%02u-%4u %02u:%02u:%02u,\"%s\",\"\"\r\n",
+		facility, pid, category, sequence,
+		time.month, time.day, time.year, time.hour, time.minute, time.second,
+		message.c_str());
+	return line;
+}
+
+struct Location
+{
+	uint32_t line;
+	string file;
+	string timestamp;
+};
+
+struct Session
+{
+	string facility;
+	map<uint32_t, Location> locations;
+};
+
+/*
+Decodes the size bytes of a log at data into CSV lines, returning false if it
+isn't a log; complete is set to whether all of it was read.
+*/
+static bool Decode(const void* data, size_t size, string& lines, bool& complete)
+{
+	LogRecordReader reader;
+	if (!reader.Open(data, size))
+		return false;
+
+	map<uint32_t, Session> sessions;
+	LogRecord record;
+	while (reader.Next(record))
+	{
+		switch (record.kind)
+		{
+		case LOG_RECORD_SESSION:
+		{
+			Session& session = sessions[record.pid];
+			session.facility.assign(record.text[0], record.textLength[0]);
+			session.locations.clear();
+			break;
+		}
+		case LOG_RECORD_LOCATION:
+		{
+			Location& location = sessions[record.pid].locations[record.location];
+			location.line = record.line;
+			location.file.assign(record.text[0], record.textLength[0]);
+			location.timestamp.assign(record.text[1], record.textLength[1]);
+			break;
+		}
+		case LOG_RECORD_ASSERT:
+		case LOG_RECORD_ERROR:
+		{
+			Session& session = sessions[record.pid];
+			map<uint32_t, Location>::const_iterator found = session.locations.find(record.location);
+			string message = found != session.locations.end()
+				? FormatMessage(record.kind, record.hr, found->second.line, found->second.file.c_str(), found->second.timestamp.c_str())
+				: FormatMessage(record.kind, record.hr, 0, "?", "?");
+			lines += FormatLine(session.facility.c_str(), record.pid, LogCategoryName(record.category), record.sequence, record.time, message);
+			break;
+		}
+		}
+	}
+	complete = reader.IsComplete();
+	return true;
+}
+
+static bool ReadFile(const char* path, vector<uint8_t>& data)
+{
+	FILE* file = fopen(path, "rb");
+	if (file == NULL)
+		return false;
+	uint8_t chunk[64 * 1024];
+	size_t read;
+	while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0)
+		data.insert(data.end(), chunk, chunk + read);
+	fclose(file);
+	return true;
+}
+
+static int Print(int count, char* paths[])
+{
+	int result = 0;
+	for (int i = 0; i < count; i++)
+	{
+		vector<uint8_t> data;
+		string lines;
+		bool complete;
+		if (!ReadFile(paths[i], data))
+		{
+			fprintf(stderr, "%s: can't be read\n", paths[i]);
+			result = 1;
+			continue;
+		}
+		if (!Decode(data.data(), data.size(), lines, complete))
+		{
+			fprintf(stderr, "%s: isn't a log\n", paths[i]);
+			result = 1;
+			continue;
+		}
+		fwrite(lines.data(), 1, lines.size(), stdout);
+		if (!complete)
+			fprintf(stderr, "%s: ends in a record cut short\n", paths[i]);
+	}
+	return result;
+}
+
+// a call site logging from a source file, as __LINE__, __FILE__ and __TIMESTAMP__ give them
+struct CallSite
+{
+	int line;
+	string file;
+	string timestamp;
+};
+
+static vector<CallSite> MakeCallSites(int count, mt19937& random)
+{
+	static const char* files[] = {
+		"WebPostFilter.cpp", "DraftsIndexer.cpp", "DraftsWatcher.cpp", "IndexerMetrics.cpp",
+		"HtmlDocumentHelper.h", "ParallelHtmlSubFilter.cpp", "UnicodeTextStreamSubFilter.cpp"
+	};
+	vector<CallSite> sites;
+	for (int i = 0; i < count; i++)
+	{
+		CallSite site;
+		site.line = 20 + (int)(random() % 900);
+		site.file = string("c:\\build\\openlivewriter\\src\\unmanaged\\OpenLiveWriter.Filter\\") + files[i % 7];
+		site.timestamp = "Tue Oct 13 14:2" + to_string(i % 10) + ":07 2015";
+		sites.push_back(site);
+	}
+	return sites;
+}
+
+/*
+Writes entries as LogFile does: a SESSION before a process's first entry and
+a LOCATION before the first entry from each call site, interned in a table
+searched the way LogFile searches it.
+*/
+class Writer
+{
+public:
+	Writer(uint32_t pid, const char* facility)
+		: m_pid(pid), m_facility(facility), m_sessionWritten(false)
+	{
+	}
+
+	void Append(LogRecordBuffer& record, uint8_t kind, uint32_t hr, uint32_t sequence, uint64_t ticks, const CallSite& site)
+	{
+		if (!m_sessionWritten)
+		{
+			record.AppendSession(m_pid, m_facility.c_str());
+			m_sessionWritten = true;
+		}
+
+		size_t location = 0;
+		while (location < m_sites.size() && !(m_sites[location]->line == site.line && m_sites[location]->file == site.file))
+			location++;
+		if (location == m_sites.size())
+		{
+			record.AppendLocation(m_pid, (uint32_t)location + 1, site.line, site.file.c_str(), site.timestamp.c_str());
+			m_sites.push_back(&site);
+		}
+		record.AppendEntry(kind, m_pid, sequence, ticks, LOG_CATEGORY_ERROR, (uint32_t)location + 1, hr);
+	}
+
+	// as LogFile does when it finds its log has been deleted
+	void Reset()
+	{
+		m_sessionWritten = false;
+		m_sites.clear();
+	}
+
+private:
+	uint32_t m_pid;
+	string m_facility;
+	bool m_sessionWritten;
+	vector<const CallSite*> m_sites;
+};
+
+struct Entry
+{
+	uint8_t kind;
+	uint32_t hr;
+	uint32_t sequence;
+	uint64_t ticks;
+	int site;
+};
+
+static vector<Entry> MakeEntries(int count, int sites, mt19937& random)
+{
+	static const uint32_t errors[] = { 0x80004005, 0x80070002, 0x8007000E, 0x80030002, 0x00000001 };
+	vector<Entry> entries;
+	uint64_t ticks = 130891000000000000ULL;	// October 2015
+	for (int i = 0; i < count; i++)
+	{
+		Entry entry;
+		entry.kind = random() % 4 == 0 ? LOG_RECORD_ASSERT : LOG_RECORD_ERROR;
+		entry.hr = entry.kind == LOG_RECORD_ERROR ? errors[random() % 5] : 0;
+		entry.sequence = 10001 + i;
+		ticks += random() % 50000000000ULL;
+		entry.ticks = ticks;
+		entry.site = (int)(random() % sites);
+		entries.push_back(entry);
+	}
+	return entries;
+}
+
+static string Expected(const char* facility, uint32_t pid, const Entry& entry, const CallSite& site)
+{
+	return FormatLine(facility, pid, "Error", entry.sequence, entry.ticks,
+		FormatMessage(entry.kind, entry.hr, site.line, site.file.c_str(), site.timestamp.c_str()));
+}
+
+static void CheckTimes()
+{
+	// 2015-10-13 14:23:07 and the earliest FILETIME
+	Time time = ToTime(130892197870000000ULL);
+	Expect(time.year == 2015 && time.month == 10 && time.day == 13 && time.hour == 14 && time.minute == 23 && time.second == 7,
+		"time", to_string(time.year) + "-" + to_string(time.month) + "-" + to_string(time.day));
+	time = ToTime(0);
+	Expect(time.year == 1601 && time.month == 1 && time.day == 1, "time zero", to_string(time.year));
+	// a leap day
+	time = ToTime(131011776000000000ULL);
+	Expect(time.year == 2016 && time.month == 2 && time.day == 29, "leap day", to_string(time.month) + "/" + to_string(time.day));
+}
+
+static void CheckRoundTrip()
+{
+	mt19937 random(1);
+	vector<CallSite> sites = MakeCallSites(12, random);
+	vector<Entry> entries = MakeEntries(2000, (int)sites.size(), random);
+
+	// two processes logging into the same file, one of them restarting with the same pid
+	Writer filter(4242, "WebPostFilter");
+	Writer tool(77, "FilterTool");
+	LogRecordBuffer record;
+	record.AppendFileHeader();
+	vector<uint8_t> log(record.GetData(), record.GetData() + record.GetLength());
+	string expected;
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		bool fromTool = i % 3 == 0;
+		if (i == 1000)
+			filter = Writer(4242, "WebPostFilter (restarted)");
+		record.Clear();
+		(fromTool ? tool : filter).Append(record, entries[i].kind, entries[i].hr, entries[i].sequence, entries[i].ticks, sites[entries[i].site]);
+		log.insert(log.end(), record.GetData(), record.GetData() + record.GetLength());
+		expected += Expected(fromTool ? "FilterTool" : (i < 1000 ? "WebPostFilter" : "WebPostFilter (restarted)"), fromTool ? 77 : 4242, entries[i], sites[entries[i].site]);
+	}
+
+	string lines;
+	bool complete = false;
+	Expect(Decode(log.data(), log.size(), lines, complete), "round trip", "not a log");
+	Expect(complete, "round trip", "incomplete");
+	Expect(lines == expected, "round trip", "lines differ");
+
+	// long strings are cut short, not overflowed
+	CallSite longSite = { 7, string(5000, 'x'), string(3000, 'y') };
+	Entry longEntry = { LOG_RECORD_ERROR, 0x80004005, 1, 130891000000000000ULL, 0 };
+	Writer writer(1, string(2000, 'f').c_str());
+	record.Clear();
+	record.AppendFileHeader();
+	writer.Append(record, longEntry.kind, longEntry.hr, longEntry.sequence, longEntry.ticks, longSite);
+	Expect(record.GetLength() <= LOG_RECORD_BUFFER_SIZE, "long strings", to_string(record.GetLength()));
+	CallSite cut = { 7, string(LOG_RECORD_MAX_STRING, 'x'), string(LOG_RECORD_MAX_STRING, 'y') };
+	lines.clear();
+	Expect(Decode(record.GetData(), record.GetLength(), lines, complete) && complete, "long strings", "not decoded");
+	Expect(lines == Expected(string(LOG_RECORD_MAX_STRING, 'f').c_str(), 1, longEntry, cut), "long strings", "lines differ");
+
+	// an entry from a process whose session was lost
+	LogRecordBuffer orphan;
+	orphan.AppendFileHeader();
+	orphan.AppendEntry(LOG_RECORD_ASSERT, 9, 10002, 130891000000000000ULL, LOG_CATEGORY_ERROR, 3, 0);
+	lines.clear();
+	Expect(Decode(orphan.GetData(), orphan.GetLength(), lines, complete) && complete, "orphan", "not decoded");
+	Expect(lines.find(",9,Error,10002,") == 0 && lines.find("ASSERT Failed: Line 0, ? (?)") != string::npos, "orphan", lines);
+
+	// a record of a kind from a later version is skipped
+	vector<uint8_t> later(log.begin(), log.begin() + 8);
+	const uint8_t unknown[] = { 3, 99, 1, 2 };
+	later.insert(later.end(), unknown, unknown + sizeof(unknown));
+	later.insert(later.end(), log.begin() + 8, log.end());
+	lines.clear();
+	Expect(Decode(later.data(), later.size(), lines, complete) && complete && lines == expected, "unknown kind", "lines differ");
+
+	// not a log
+	const char text[] = "WebPostFilter,4242,Error,10001,10-13-2015 14:23:07,\"\",\"\"\r\n";
+	Expect(!Decode(text, sizeof(text) - 1, lines, complete), "text log", "decoded");
+}
+
+static void CheckDamage()
+{
+	mt19937 random(2);
+	vector<CallSite> sites = MakeCallSites(6, random);
+	vector<Entry> entries = MakeEntries(40, (int)sites.size(), random);
+	Writer writer(4242, "WebPostFilter");
+	LogRecordBuffer record;
+	record.AppendFileHeader();
+	vector<uint8_t> log(record.GetData(), record.GetData() + record.GetLength());
+	vector<size_t> ends;
+	vector<string> expected(1);
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		record.Clear();
+		writer.Append(record, entries[i].kind, entries[i].hr, entries[i].sequence, entries[i].ticks, sites[entries[i].site]);
+		log.insert(log.end(), record.GetData(), record.GetData() + record.GetLength());
+		ends.push_back(log.size());
+		expected.push_back(expected.back() + Expected("WebPostFilter", 4242, entries[i], sites[entries[i].site]));
+	}
+
+	// every truncation decodes the entries before it, and is complete at an entry's end
+	for (size_t length = 8; length <= log.size(); length++)
+	{
+		vector<uint8_t> cut(log.begin(), log.begin() + length);
+		size_t whole = 0;
+		while (whole < ends.size() && ends[whole] <= length)
+			whole++;
+		string lines;
+		bool complete;
+		bool decoded = Decode(cut.data(), cut.size(), lines, complete);
+		Expect(decoded && lines == expected[whole], "truncated", to_string(length));
+		if (length == 8 || (whole > 0 && ends[whole - 1] == length))
+			Expect(complete, "truncated complete", to_string(length));
+	}
+
+	// random damage must not be read out of bounds
+	for (int i = 0; i < 20000; i++)
+	{
+		vector<uint8_t> damaged(log);
+		int changes = 1 + (int)(random() % 8);
+		for (int j = 0; j < changes; j++)
+			damaged[8 + random() % (damaged.size() - 8)] = (uint8_t)random();
+		damaged.resize(8 + random() % (damaged.size() - 7));
+		string lines;
+		bool complete;
+		Decode(damaged.data(), damaged.size(), lines, complete);
+	}
+}
+
+static void Benchmark()
+{
+	mt19937 random(3);
+	vector<CallSite> sites = MakeCallSites(30, random);
+	const int count = 1000000;
+	vector<Entry> entries = MakeEntries(count, (int)sites.size(), random);
+	volatile size_t sink = 0;
+
+	// the CSV lines LogFile used to format
+	size_t textBytes = 0;
+	auto start = chrono::steady_clock::now();
+	for (int i = 0; i < count; i++)
+	{
+		const CallSite& site = sites[entries[i].site];
+		string line = FormatLine("WebPostFilter", 4242, "Error", entries[i].sequence, entries[i].ticks,
+			FormatMessage(entries[i].kind, entries[i].hr, site.line, site.file.c_str(), site.timestamp.c_str()));
+		textBytes += line.size();
+	}
+	double text = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	sink = sink + textBytes;
+
+	// the records LogFile writes now, sessions and locations included
+	size_t binaryBytes = 0;
+	Writer writer(4242, "WebPostFilter");
+	LogRecordBuffer record;
+	start = chrono::steady_clock::now();
+	for (int i = 0; i < count; i++)
+	{
+		record.Clear();
+		writer.Append(record, entries[i].kind, entries[i].hr, entries[i].sequence, entries[i].ticks, sites[entries[i].site]);
+		binaryBytes += record.GetLength();
+	}
+	double binary = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	sink = sink + binaryBytes;
+
+	// decoding them back
+	vector<uint8_t> log;
+	record.Clear();
+	record.AppendFileHeader();
+	log.insert(log.end(), record.GetData(), record.GetData() + record.GetLength());
+	writer.Reset();
+	for (int i = 0; i < count; i++)
+	{
+		record.Clear();
+		writer.Append(record, entries[i].kind, entries[i].hr, entries[i].sequence, entries[i].ticks, sites[entries[i].site]);
+		log.insert(log.end(), record.GetData(), record.GetData() + record.GetLength());
+	}
+	string lines;
+	bool complete;
+	start = chrono::steady_clock::now();
+	Decode(log.data(), log.size(), lines, complete);
+	double decode = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	printf("%d entries from %d call sites, building them without writing them:\n", count, (int)sites.size());
+	printf("  CSV     %10.0f entries/s  %6.1f bytes/entry\n", count / text, (double)textBytes / count);
+	printf("  binary  %10.0f entries/s  %6.1f bytes/entry\n", count / binary, (double)binaryBytes / count);
+	printf("  decoding the binary log to CSV: %.0f entries/s\n", count / decode);
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc == 2 && strcmp(argv[1], "/benchmark") == 0)
+	{
+		Benchmark();
+		return 0;
+	}
+	if (argc == 2 && strcmp(argv[1], "/check") == 0)
+	{
+		CheckTimes();
+		CheckRoundTrip();
+		CheckDamage();
+		printf("%s\n", failures == 0 ? "PASS" : "FAILED");
+		return failures == 0 ? 0 : 1;
+	}
+	if (argc < 2)
+	{
+		printf("usage: LogFileDecoder <log.olwlog>... | /check | /benchmark\n");
+		return 2;
+	}
+	return Print(argc - 1, argv + 1);
+}
@@ -0,0 +1,908 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+/*
+Checks the post file decoder in OpenLiveWriter.CppUtils (PostFileDecoder.h and
+CompoundFileReader.h) and measures how long loading a post takes with it:
+
+	PostFileDecoderCheck [/benchmark] [post.wpost ...]
+
+Compound files are written here, the way structured storage lays them out
+(version 3 and 4, sibling trees, the mini stream, DIFAT sectors for large
+files), from a model of storages and streams with their sectors shuffled
+through the file, and the decoded buffer has to give the model back exactly:
+every name, parent, length, encoding and byte, with streams over the limit
+listed but not loaded. Files with garbage written over them, and with cycles
+in their sector chains and sibling trees, must be turned down or decoded
+without reading out of bounds or looping (build with -fsanitize=address to be
+sure). Exits with 1 if anything differs.
+
+Given .wpost (or any compound) files, it lists what is in them instead, to
+check the decoder against files structured storage wrote.
+
+The benchmark decodes a typical draft (30 metadata streams, 40 KB of contents,
+20 supporting files kept in the blob store) and one with 5 MB of embedded
+pictures, from memory as a mapped file would be. On Windows, given a .wpost
+file, it also times reading the same streams one at a time through IStorage,
+which is what PostEditorFile.Load did before.
+
+	c++ -std=c++11 -O2 -o PostFileDecoderCheck PostFileDecoderCheck.cpp
+	cl /EHsc /O2 PostFileDecoderCheck.cpp ole32.lib
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <objbase.h>
+#endif
+
+#include "../../src/unmanaged/OpenLiveWriter.CppUtils/Include/PostFileDecoder.h"
+
+using namespace std;
+
+static int failures = 0;
+
+static void Expect(bool condition, const char* what, const char* detail)
+{
+	if (!condition)
+	{
+		printf("FAIL %s: %s\n", what, detail);
+		failures++;
+	}
+}
+
+// A storage or stream in a model of a compound file.
+struct Node
+{
+	u16string name;
+	bool storage;
+	vector<uint8_t> data;
+	vector<Node> children;
+};
+
+static u16string Name(const char* name)
+{
+	return u16string(name, name + strlen(name));
+}
+
+static Node Storage(const u16string& name)
+{
+	Node node;
+	node.name = name;
+	node.storage = true;
+	return node;
+}
+
+static Node Storage(const char* name)
+{
+	return Storage(Name(name));
+}
+
+static Node Stream(const char* name, const vector<uint8_t>& data)
+{
+	Node node;
+	node.name = Name(name);
+	node.storage = false;
+	node.data = data;
+	return node;
+}
+
+// what the post editor writes for a string: UTF-16 with a byte order mark
+static vector<uint8_t> Utf16(const string& text)
+{
+	vector<uint8_t> data;
+	data.push_back(0xFF);
+	data.push_back(0xFE);
+	for (size_t i = 0; i < text.size(); i++)
+	{
+		data.push_back((uint8_t)text[i]);
+		data.push_back(0);
+	}
+	return data;
+}
+
+static vector<uint8_t> Utf8(const string& text)
+{
+	vector<uint8_t> data;
+	data.push_back(0xEF);
+	data.push_back(0xBB);
+	data.push_back(0xBF);
+	data.insert(data.end(), text.begin(), text.end());
+	return data;
+}
+
+static vector<uint8_t> Random(size_t length, mt19937& random)
+{
+	vector<uint8_t> data(length);
+	for (size_t i = 0; i < length; i++)
+		data[i] = (uint8_t)(random() & 0xFF);
+	return data;
+}
+
+// structured storage's order of siblings: shorter names first, then by uppercase
+static bool DirectoryOrder(const Node* a, const Node* b)
+{
+	if (a->name.size() != b->name.size())
+		return a->name.size() < b->name.size();
+	for (size_t i = 0; i < a->name.size(); i++)
+	{
+		char16_t x = a->name[i] >= 'a' && a->name[i] <= 'z' ? a->name[i] - 32 : a->name[i];
+		char16_t y = b->name[i] >= 'a' && b->name[i] <= 'z' ? b->name[i] - 32 : b->name[i];
+		if (x != y)
+			return x < y;
+	}
+	return false;
+}
+
+// sector numbers that mark free sectors, chain ends, FAT and DIFAT sectors
+static const uint32_t FREE = 0xFFFFFFFF;
+static const uint32_t END = 0xFFFFFFFE;
+static const uint32_t FAT = 0xFFFFFFFD;
+static const uint32_t DIFAT = 0xFFFFFFFC;
+
+/*
+Writes a model out as a compound file. Siblings are kept in a balanced tree in
+DirectoryOrder, and the
+sectors and mini sectors of every chain are spread over the file in a random
+order so that chains have to be followed rather than read straight through.
+*/
+class CompoundFileWriter
+{
+public:
+	static vector<uint8_t> Write(const Node& root, int version, uint32_t seed)
+	{
+		CompoundFileWriter writer(version, seed);
+		return writer.WriteFile(root);
+	}
+
+private:
+	struct Entry
+	{
+		const Node* node;
+		uint32_t left, right, child;
+		uint32_t start;
+		uint64_t size;
+	};
+
+	CompoundFileWriter(int version, uint32_t seed)
+		: m_shift(version == 4 ? 12 : 9), m_version(version), m_random(seed)
+	{
+	}
+
+	size_t SectorSize() const
+	{
+		return (size_t)1 << m_shift;
+	}
+
+	uint32_t AddEntry(const Node* node)
+	{
+		Entry entry = { node, FREE, FREE, FREE, 0, 0 };
+		m_entries.push_back(entry);
+		uint32_t id = (uint32_t)m_entries.size() - 1;
+		if (node->storage)
+		{
+			vector<const Node*> children;
+			for (size_t i = 0; i < node->children.size(); i++)
+				children.push_back(&node->children[i]);
+			sort(children.begin(), children.end(), DirectoryOrder);
+			uint32_t child = AddTree(children, 0, children.size());
+			m_entries[id].child = child;
+		}
+		return id;
+	}
+
+	uint32_t AddTree(const vector<const Node*>& siblings, size_t begin, size_t end)
+	{
+		if (begin == end)
+			return FREE;
+		size_t middle = (begin + end) / 2;
+		uint32_t id = AddEntry(siblings[middle]);
+		uint32_t left = AddTree(siblings, begin, middle);
+		uint32_t right = AddTree(siblings, middle + 1, end);
+		m_entries[id].left = left;
+		m_entries[id].right = right;
+		return id;
+	}
+
+	// Gives count sectors out of the free ones, in a random order.
+	vector<uint32_t> Allocate(vector<uint32_t>& free, size_t count)
+	{
+		vector<uint32_t> chain(free.end() - count, free.end());
+		free.resize(free.size() - count);
+		return chain;
+	}
+
+	static void Link(vector<uint32_t>& fat, const vector<uint32_t>& chain)
+	{
+		for (size_t i = 0; i < chain.size(); i++)
+			fat[chain[i]] = i + 1 < chain.size() ? chain[i + 1] : END;
+	}
+
+	static void Put16(uint8_t* p, uint32_t value)
+	{
+		p[0] = (uint8_t)value;
+		p[1] = (uint8_t)(value >> 8);
+	}
+
+	static void Put32(uint8_t* p, uint32_t value)
+	{
+		for (int i = 0; i < 4; i++)
+			p[i] = (uint8_t)(value >> (i * 8));
+	}
+
+	vector<uint8_t> WriteFile(const Node& root)
+	{
+		AddEntry(&root);
+
+		// short streams go in the mini stream, 64 byte mini sectors in a random order
+		size_t miniSectorCount = 0;
+		for (size_t i = 1; i < m_entries.size(); i++)
+		{
+			if (!m_entries[i].node->storage && m_entries[i].node->data.size() < 4096)
+				miniSectorCount += (m_entries[i].node->data.size() + 63) / 64;
+		}
+		vector<uint32_t> freeMini(miniSectorCount);
+		for (size_t i = 0; i < miniSectorCount; i++)
+			freeMini[i] = (uint32_t)i;
+		shuffle(freeMini.begin(), freeMini.end(), m_random);
+		vector<uint32_t> miniFat(miniSectorCount, FREE);
+		vector<uint8_t> miniStream(miniSectorCount * 64);
+
+		size_t sectorSize = SectorSize();
+		size_t perSector = sectorSize / 4;
+		size_t dataSectors = 0;
+		for (size_t i = 1; i < m_entries.size(); i++)
+		{
+			const Node* node = m_entries[i].node;
+			m_entries[i].size = node->storage ? 0 : node->data.size();
+			if (node->storage || node->data.empty())
+			{
+				m_entries[i].start = node->storage ? 0 : END;
+				continue;
+			}
+			if (node->data.size() < 4096)
+			{
+				vector<uint32_t> chain = Allocate(freeMini, (node->data.size() + 63) / 64);
+				Link(miniFat, chain);
+				for (size_t j = 0; j < chain.size(); j++)
+				{
+					size_t count = min((size_t)64, node->data.size() - j * 64);
+					memcpy(&miniStream[chain[j] * 64], &node->data[j * 64], count);
+				}
+				m_entries[i].start = chain[0];
+			}
+			else
+			{
+				dataSectors += (node->data.size() + sectorSize - 1) / sectorSize;
+			}
+		}
+
+		size_t miniStreamSectors = (miniStream.size() + sectorSize - 1) / sectorSize;
+		size_t miniFatSectors = (miniFat.size() + perSector - 1) / perSector;
+		size_t directorySectors = (m_entries.size() * 128 + sectorSize - 1) / sectorSize;
+		size_t contentSectors = dataSectors + miniStreamSectors + miniFatSectors + directorySectors;
+
+		// the FAT has to cover itself and the DIFAT too
+		size_t fatSectors = 1, difatSectors = 0;
+		for (;;)
+		{
+			difatSectors = fatSectors > 109 ? (fatSectors - 109 + perSector - 2) / (perSector - 1) : 0;
+			if (contentSectors + fatSectors + difatSectors <= fatSectors * perSector)
+				break;
+			fatSectors++;
+		}
+		size_t sectorCount = contentSectors + fatSectors + difatSectors;
+
+		vector<uint32_t> free(contentSectors);
+		for (size_t i = 0; i < contentSectors; i++)
+			free[i] = (uint32_t)i;
+		shuffle(free.begin(), free.end(), m_random);
+
+		vector<uint8_t> file((sectorCount + 1) * sectorSize);
+		vector<uint32_t> fat(fatSectors * perSector, FREE);
+
+		for (size_t i = 1; i < m_entries.size(); i++)
+		{
+			const Node* node = m_entries[i].node;
+			if (node->storage || node->data.size() < 4096)
+				continue;
+			vector<uint32_t> chain = Allocate(free, (node->data.size() + sectorSize - 1) / sectorSize);
+			Link(fat, chain);
+			for (size_t j = 0; j < chain.size(); j++)
+			{
+				size_t count = min(sectorSize, node->data.size() - j * sectorSize);
+				memcpy(&file[(chain[j] + 1) * sectorSize], &node->data[j * sectorSize], count);
+			}
+			m_entries[i].start = chain[0];
+		}
+
+		m_entries[0].start = END;
+		m_entries[0].size = miniStream.size();
+		if (!miniStream.empty())
+		{
+			vector<uint32_t> chain = Allocate(free, miniStreamSectors);
+			Link(fat, chain);
+			for (size_t j = 0; j < chain.size(); j++)
+				memcpy(&file[(chain[j] + 1) * sectorSize], &miniStream[j * sectorSize], min(sectorSize, miniStream.size() - j * sectorSize));
+			m_entries[0].start = chain[0];
+		}
+
+		uint32_t miniFatStart = END;
+		if (miniFatSectors > 0)
+		{
+			miniFat.resize(miniFatSectors * perSector, FREE);
+			vector<uint32_t> chain = Allocate(free, miniFatSectors);
+			Link(fat, chain);
+			for (size_t j = 0; j < chain.size(); j++)
+			{
+				for (size_t k = 0; k < perSector; k++)
+					Put32(&file[(chain[j] + 1) * sectorSize + k * 4], miniFat[j * perSector + k]);
+			}
+			miniFatStart = chain[0];
+		}
+
+		vector<uint32_t> directory = Allocate(free, directorySectors);
+		Link(fat, directory);
+		for (size_t i = 0; i < directorySectors * sectorSize / 128; i++)
+		{
+			uint8_t* raw = &file[(directory[i / (sectorSize / 128)] + 1) * sectorSize + (i % (sectorSize / 128)) * 128];
+			Put32(raw + 0x44, FREE);
+			Put32(raw + 0x48, FREE);
+			Put32(raw + 0x4C, FREE);
+			if (i >= m_entries.size())
+				continue;
+
+			const Entry& entry = m_entries[i];
+			for (size_t j = 0; j < entry.node->name.size(); j++)
+				Put16(raw + j * 2, entry.node->name[j]);
+			Put16(raw + 0x40, (uint32_t)(entry.node->name.size() + 1) * 2);
+			raw[0x42] = i == 0 ? 5 : entry.node->storage ? 1 : 2;
+			raw[0x43] = 1;
+			Put32(raw + 0x44, entry.left);
+			Put32(raw + 0x48, entry.right);
+			Put32(raw + 0x4C, entry.child);
+			Put32(raw + 0x74, entry.start);
+			Put32(raw + 0x78, (uint32_t)entry.size);
+			Put32(raw + 0x7C, m_version == 4 ? (uint32_t)(entry.size >> 32) : 0);
+		}
+
+		// the FAT and DIFAT sectors go last
+		vector<uint32_t> fatList;
+		for (size_t i = 0; i < fatSectors; i++)
+		{
+			fatList.push_back((uint32_t)(contentSectors + i));
+			fat[contentSectors + i] = FAT;
+		}
+		for (size_t i = 0; i < difatSectors; i++)
+			fat[contentSectors + fatSectors + i] = DIFAT;
+		for (size_t i = 0; i < fatSectors; i++)
+		{
+			for (size_t k = 0; k < perSector; k++)
+				Put32(&file[(fatList[i] + 1) * sectorSize + k * 4], fat[i * perSector + k]);
+		}
+
+		uint8_t* header = &file[0];
+		static const uint8_t signature[8] = { 0xD0, 0xCF, 0x11, 0xE0, 0xA1, 0xB1, 0x1A, 0xE1 };
+		memcpy(header, signature, 8);
+		Put16(header + 0x18, 0x3E);
+		Put16(header + 0x1A, m_version);
+		Put16(header + 0x1C, 0xFFFE);
+		Put16(header + 0x1E, m_shift);
+		Put16(header + 0x20, 6);
+		Put32(header + 0x28, m_version == 4 ? (uint32_t)directorySectors : 0);
+		Put32(header + 0x2C, (uint32_t)fatSectors);
+		Put32(header + 0x30, directory[0]);
+		Put32(header + 0x38, 4096);
+		Put32(header + 0x3C, miniFatStart);
+		Put32(header + 0x40, (uint32_t)miniFatSectors);
+		Put32(header + 0x44, difatSectors > 0 ? (uint32_t)(contentSectors + fatSectors) : END);
+		Put32(header + 0x48, (uint32_t)difatSectors);
+		for (size_t i = 0; i < 109; i++)
+			Put32(header + 0x4C + i * 4, i < fatSectors ? fatList[i] : FREE);
+		for (size_t i = 0; i < difatSectors; i++)
+		{
+			uint8_t* difat = &file[(contentSectors + fatSectors + i + 1) * sectorSize];
+			for (size_t k = 0; k < perSector - 1; k++)
+			{
+				size_t listed = 109 + i * (perSector - 1) + k;
+				Put32(difat + k * 4, listed < fatSectors ? fatList[listed] : FREE);
+			}
+			Put32(difat + (perSector - 1) * 4, i + 1 < difatSectors ? (uint32_t)(contentSectors + fatSectors + i + 1) : END);
+		}
+		return file;
+	}
+
+	uint16_t m_shift;
+	int m_version;
+	mt19937 m_random;
+	vector<Entry> m_entries;
+};
+
+// A decoded post, read back out of the buffer.
+struct Decoded
+{
+	vector<uint8_t> buffer;
+	vector<PostFileElement> elements;
+
+	bool Decode(const vector<uint8_t>& file, uint64_t maxStreamLength)
+	{
+		PostFileDecoder decoder;
+		if (!decoder.Open(file.data(), file.size(), maxStreamLength))
+			return false;
+		buffer.assign(decoder.GetLength(), 0xCC);
+		if (!decoder.Write(buffer.data()))
+			return false;
+		elements.resize(decoder.GetElementCount());
+		memcpy(elements.data(), buffer.data(), elements.size() * sizeof(PostFileElement));
+		return true;
+	}
+
+	u16string GetName(size_t i) const
+	{
+		u16string name;
+		for (int32_t j = 0; j < elements[i].nameLength; j++)
+			name += (char16_t)(buffer[elements[i].nameOffset + j * 2] | (buffer[elements[i].nameOffset + j * 2 + 1] << 8));
+		return name;
+	}
+};
+
+static string Narrow(const u16string& name)
+{
+	return string(name.begin(), name.end());
+}
+
+static bool StartsWith(const vector<uint8_t>& data, const char* mark, size_t length)
+{
+	return data.size() >= length && memcmp(data.data(), mark, length) == 0;
+}
+
+// the byte order marks StreamReader knows, in the order it looks for them
+static int32_t Encoding(const vector<uint8_t>& data)
+{
+	if (StartsWith(data, "\xFE\xFF", 2))
+		return POST_FILE_UTF16BE;
+	if (StartsWith(data, "\xFF\xFE\0\0", 4))
+		return POST_FILE_UTF32;
+	if (StartsWith(data, "\xFF\xFE", 2))
+		return POST_FILE_UTF16;
+	if (StartsWith(data, "\xEF\xBB\xBF", 3))
+		return POST_FILE_UTF8;
+	if (StartsWith(data, "\0\0\xFE\xFF", 4))
+		return POST_FILE_UTF32BE;
+	return POST_FILE_BINARY;
+}
+
+// Compares what was decoded from index on with node, a storage or stream whose parent is parent.
+static size_t CompareNode(const Decoded& decoded, size_t index, const Node& node, int32_t parent, uint64_t maxStreamLength, const char* what)
+{
+	if (index >= decoded.elements.size())
+	{
+		Expect(false, what, "too few elements");
+		return index;
+	}
+
+	const PostFileElement& element = decoded.elements[index];
+	string name = Narrow(node.name);
+	Expect(element.parent == parent, what, ("parent of " + name).c_str());
+	Expect(index == 0 || decoded.GetName(index) == node.name, what, ("name of " + name).c_str());
+	Expect(element.type == (node.storage ? POST_FILE_STORAGE : POST_FILE_STREAM), what, ("type of " + name).c_str());
+	if (!node.storage)
+	{
+		Expect(element.dataLength == (int64_t)node.data.size(), what, ("length of " + name).c_str());
+		if (node.data.size() > maxStreamLength)
+		{
+			Expect(element.flags == POST_FILE_NOT_LOADED, what, ("not loaded " + name).c_str());
+		}
+		else
+		{
+			Expect(element.flags == 0 && element.dataOffset % 8 == 0, what, ("loaded " + name).c_str());
+			Expect(element.encoding == Encoding(node.data), what, ("encoding of " + name).c_str());
+			Expect(node.data.empty() || (element.dataOffset + element.dataLength <= (int64_t)decoded.buffer.size() &&
+				memcmp(&decoded.buffer[(size_t)element.dataOffset], node.data.data(), node.data.size()) == 0), what, ("contents of " + name).c_str());
+		}
+		return index + 1;
+	}
+
+	// children come in directory order, each storage followed by what is in it
+	vector<const Node*> children;
+	for (size_t i = 0; i < node.children.size(); i++)
+		children.push_back(&node.children[i]);
+	sort(children.begin(), children.end(), DirectoryOrder);
+	size_t next = index + 1;
+	for (size_t i = 0; i < children.size(); i++)
+		next = CompareNode(decoded, next, *children[i], (int32_t)index, maxStreamLength, what);
+	return next;
+}
+
+static void CheckModel(const Node& root, uint64_t maxStreamLength, const char* what)
+{
+	for (int version = 3; version <= 4; version++)
+	{
+		vector<uint8_t> file = CompoundFileWriter::Write(root, version, version * 7 + 1);
+		Decoded decoded;
+		string detail = string(what) + (version == 3 ? " (version 3)" : " (version 4)");
+		if (!decoded.Decode(file, maxStreamLength))
+		{
+			Expect(false, "decoded", detail.c_str());
+			continue;
+		}
+		size_t end = CompareNode(decoded, 0, root, -1, maxStreamLength, detail.c_str());
+		Expect(end == decoded.elements.size(), "element count", detail.c_str());
+	}
+}
+
+// a supporting file's storage is named for its guid as Storage.NameFromGuid names it
+static u16string Guid(int i, mt19937& random)
+{
+	u16string name;
+	for (int j = 0; j < 16; j++)
+		name += (char16_t)(0x5D + (j == 0 ? i & 0xFF : random() & 0xFF));
+	return name;
+}
+
+// a draft as PostEditorFile.Save writes it, its pictures either embedded or in the blob store
+static Node MakePost(int pictures, size_t pictureLength, bool embedded, size_t contentsLength, mt19937& random)
+{
+	static const char* fields[] = {
+		"DestinationBlogId", "ServerSupportingFileDir", "Id", "IsPage", "Title", "Keywords", "Excerpt",
+		"Permalink", "Link", "Slug", "Password", "AuthorId", "AuthorName", "PageParentId", "PageParentName",
+		"PageOrder", "ETag", "CommentPolicy", "TrackbackPolicy", "ContentsVersionSignature", "OriginalSourcePath"
+	};
+	static const char* xmlFields[] = {
+		"Categories", "NewCategories", "PingUrlsPending", "PingUrlsSent", "AtomRemotePost",
+		"AttachedFiles", "ImageFiles", "ExtensionDataList"
+	};
+
+	Node post = Storage("Root Entry");
+	for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++)
+		post.children.push_back(Stream(fields[i], Utf16(string(fields[i]) + " value " + to_string(i))));
+	for (size_t i = 0; i < sizeof(xmlFields) / sizeof(xmlFields[0]); i++)
+		post.children.push_back(Stream(xmlFields[i], Utf8("<?xml version=\"1.0\" encoding=\"utf-8\"?><list><item name=\"" + to_string(i) + "\"/></list>")));
+
+	vector<uint8_t> ticks(8);
+	for (int i = 0; i < 8; i++)
+		ticks[i] = (uint8_t)(0x08D8A1B2C3D4E5F6ULL >> (i * 8));
+	post.children.push_back(Stream("DatePublished", ticks));
+	post.children.push_back(Stream("DatePublishedOverride", ticks));
+
+	string contents;
+	while (contents.size() < contentsLength)
+		contents += "<p>The quick brown fox jumps over the lazy dog.</p>\r\n";
+	post.children.push_back(Stream("Contents", Utf8(contents)));
+
+	Node supportingFiles = Storage("SupportingFiles");
+	for (int i = 0; i < pictures; i++)
+	{
+		Node file = Storage(Guid(i, random));
+		file.children.push_back(Stream("SupportingFileName", Utf16("picture" + to_string(i) + ".jpg")));
+		if (embedded)
+			file.children.push_back(Stream("SupportingFileContents", Random(pictureLength, random)));
+		else
+			file.children.push_back(Stream("SupportingFileBlob", Utf16("9f86d081884c7d659a2feaa0c55ad015a3bf4f1b2b0b822cd15d6c15b0f00a08")));
+		supportingFiles.children.push_back(file);
+	}
+	post.children.push_back(supportingFiles);
+	return post;
+}
+
+static void CheckPosts()
+{
+	mt19937 random(1);
+	CheckModel(MakePost(20, 0, false, 40 * 1024, random), UINT64_MAX, "draft");
+	CheckModel(MakePost(6, 300 * 1024, true, 4000, random), UINT64_MAX, "embedded pictures");
+	CheckModel(MakePost(6, 300 * 1024, true, 4000, random), 64 * 1024, "embedded pictures over the limit");
+
+	// a stream either side of the mini stream cutoff, an empty one and an
+	// empty storage
+	Node edges = Storage("Root Entry");
+	edges.children.push_back(Stream("Short", Random(4095, random)));
+	edges.children.push_back(Stream("Long", Random(4096, random)));
+	edges.children.push_back(Stream("Empty", vector<uint8_t>()));
+	edges.children.push_back(Storage("Nothing"));
+	edges.children.push_back(Stream("A name of thirty-one characters", Utf16("x")));
+	CheckModel(edges, UINT64_MAX, "edges");
+
+	// every byte order mark, and UTF-16 that is only a mark
+	Node marks = Storage("Root Entry");
+	const char* markedText[] = {
+		"\xFF\xFEx\0", "\xFE\xFF\0x", "\xEF\xBB\xBFx", "\xFF\xFE\0\0x\0\0\0", "\0\0\xFE\xFF\0\0\0x", "\xFF\xFE"
+	};
+	const size_t markedLength[] = { 4, 4, 4, 8, 8, 2 };
+	for (size_t i = 0; i < sizeof(markedText) / sizeof(markedText[0]); i++)
+		marks.children.push_back(Stream(("Marked" + to_string(i)).c_str(), vector<uint8_t>(markedText[i], markedText[i] + markedLength[i])));
+	CheckModel(marks, UINT64_MAX, "byte order marks");
+	CheckModel(Storage("Root Entry"), UINT64_MAX, "empty");
+
+	// over 109 FAT sectors in version 3, so the DIFAT spills out of the header
+	Node large = Storage("Root Entry");
+	large.children.push_back(Stream("Large", Random(9 * 1024 * 1024, random)));
+	large.children.push_back(Stream("Small", Utf16("after the large one")));
+	CheckModel(large, UINT64_MAX, "DIFAT sectors");
+
+	// nested a level deeper than posts are
+	Node deep = Storage("Root Entry");
+	Node* storage = &deep;
+	for (int i = 0; i < 6; i++)
+	{
+		storage->children.push_back(Stream("Level", Utf16(to_string(i))));
+		storage->children.push_back(Storage("Deeper"));
+		storage = &storage->children.back();
+	}
+	CheckModel(deep, UINT64_MAX, "nested storages");
+
+	vector<uint8_t> text = Utf16("not a compound file");
+	Decoded decoded;
+	Expect(!decoded.Decode(text, UINT64_MAX), "turned down", "not a compound file");
+}
+
+static uint32_t Get32(const vector<uint8_t>& file, size_t offset)
+{
+	return file[offset] | (file[offset + 1] << 8) | (file[offset + 2] << 16) | ((uint32_t)file[offset + 3] << 24);
+}
+
+static void Set32(vector<uint8_t>& file, size_t offset, uint32_t value)
+{
+	for (int i = 0; i < 4; i++)
+		file[offset + i] = (uint8_t)(value >> (i * 8));
+}
+
+static void CheckDamage()
+{
+	mt19937 random(3);
+	Node post = MakePost(4, 5000, true, 6000, random);
+	vector<uint8_t> original = CompoundFileWriter::Write(post, 3, 5);
+
+	// a FAT entry that points at itself: the Contents chain loops
+	{
+		vector<uint8_t> file = original;
+		uint32_t fatSector = Get32(file, 0x4C);
+		for (uint32_t i = 0; i < 128; i++)
+		{
+			size_t offset = (fatSector + 1) * 512 + i * 4;
+			if (Get32(file, offset) < 0xFFFFFFFA)
+				Set32(file, offset, i);
+		}
+		Decoded decoded;
+		Expect(!decoded.Decode(file, UINT64_MAX), "turned down", "FAT cycle");
+	}
+
+	// a sibling that is its own right sibling
+	{
+		vector<uint8_t> file = original;
+		size_t directory = (Get32(file, 0x30) + 1) * 512;
+		Set32(file, directory + 128 + 0x48, 1);
+		Decoded decoded;
+		Expect(!decoded.Decode(file, UINT64_MAX), "turned down", "sibling cycle");
+	}
+
+	// a storage that contains the root
+	{
+		vector<uint8_t> file = original;
+		size_t directory = (Get32(file, 0x30) + 1) * 512;
+		for (size_t i = 1; i < 4; i++)
+		{
+			if (file[directory + i * 128 + 0x42] == 1)
+				Set32(file, directory + i * 128 + 0x4C, 0);
+		}
+		Decoded decoded;
+		decoded.Decode(file, UINT64_MAX);
+	}
+
+	// garbage anywhere, most of all in the header, FAT and directory
+	int decodedCount = 0;
+	for (int i = 0; i < 3000; i++)
+	{
+		vector<uint8_t> file = original;
+		int changes = 1 + random() % 8;
+		for (int j = 0; j < changes; j++)
+		{
+			size_t offset = random() % 4 == 0 ? random() % file.size() : random() % min(file.size(), (size_t)2048);
+			if (offset >= file.size())
+				continue;
+			if (random() % 2 == 0)
+				file[offset] = (uint8_t)random();
+			else if (offset + 4 <= file.size())
+				Set32(file, offset, random() % 4 == 0 ? 0xFFFFFFFE : (uint32_t)(random() % 64));
+		}
+		if (random() % 16 == 0)
+			file.resize(random() % file.size());
+
+		Decoded decoded;
+		if (decoded.Decode(file, UINT64_MAX))
+			decodedCount++;
+	}
+	Expect(decodedCount < 3000, "garbage noticed", "garbage");
+}
+
+static void List(const char* path)
+{
+	FILE* input = fopen(path, "rb");
+	if (input == NULL)
+	{
+		printf("can't open %s\n", path);
+		failures++;
+		return;
+	}
+	vector<uint8_t> file;
+	uint8_t chunk[65536];
+	size_t read;
+	while ((read = fread(chunk, 1, sizeof(chunk), input)) > 0)
+		file.insert(file.end(), chunk, chunk + read);
+	fclose(input);
+
+	Decoded decoded;
+	if (!decoded.Decode(file, UINT64_MAX))
+	{
+		printf("%s: can't decode\n", path);
+		failures++;
+		return;
+	}
+	printf("%s: %d elements\n", path, (int)decoded.elements.size());
+	vector<int> depth(decoded.elements.size(), 0);
+	for (size_t i = 1; i < decoded.elements.size(); i++)
+	{
+		const PostFileElement& element = decoded.elements[i];
+		depth[i] = depth[element.parent] + 1;
+		string name = Narrow(decoded.GetName(i));
+		for (size_t j = 0; j < name.size(); j++)
+		{
+			if (name[j] < 32 || name[j] > 126)
+				name[j] = '?';
+		}
+		static const char* encodings[] = { "", " UTF-16", " UTF-8", " UTF-16BE", " UTF-32", " UTF-32BE" };
+		if (element.type == POST_FILE_STORAGE)
+			printf("%*s%s\\\n", depth[i] * 2, "", name.c_str());
+		else
+			printf("%*s%s %lld bytes%s\n", depth[i] * 2, "", name.c_str(), (long long)element.dataLength, encodings[element.encoding]);
+	}
+}
+
+#ifdef _WIN32
+// Reads every stream of a storage one at a time, as the managed code did.
+static size_t ReadStorage(IStorage* storage)
+{
+	size_t total = 0;
+	IEnumSTATSTG* elements = NULL;
+	if (FAILED(storage->EnumElements(0, NULL, 0, &elements)))
+		return 0;
+	STATSTG stat;
+	vector<uint8_t> buffer;
+	while (elements->Next(1, &stat, NULL) == S_OK)
+	{
+		if (stat.type == STGTY_STREAM)
+		{
+			IStream* stream = NULL;
+			if (SUCCEEDED(storage->OpenStream(stat.pwcsName, NULL, STGM_READ | STGM_SHARE_EXCLUSIVE, 0, &stream)))
+			{
+				buffer.resize((size_t)stat.cbSize.QuadPart);
+				ULONG read = 0;
+				stream->Read(buffer.data(), (ULONG)buffer.size(), &read);
+				total += read;
+				stream->Release();
+			}
+		}
+		else if (stat.type == STGTY_STORAGE)
+		{
+			IStorage* child = NULL;
+			if (SUCCEEDED(storage->OpenStorage(stat.pwcsName, NULL, STGM_READ | STGM_SHARE_EXCLUSIVE, NULL, 0, &child)))
+			{
+				total += ReadStorage(child);
+				child->Release();
+			}
+		}
+		CoTaskMemFree(stat.pwcsName);
+	}
+	elements->Release();
+	return total;
+}
+
+static void BenchmarkStorage(const char* path, int loads)
+{
+	wstring widePath(path, path + strlen(path));
+	CoInitialize(NULL);
+
+	auto start = chrono::steady_clock::now();
+	size_t total = 0;
+	for (int i = 0; i < loads; i++)
+	{
+		IStorage* storage = NULL;
+		if (FAILED(StgOpenStorageEx(widePath.c_str(), STGM_READ | STGM_SHARE_DENY_WRITE, STGFMT_STORAGE, 0, NULL, NULL, IID_IStorage, (void**)&storage)))
+		{
+			printf("can't open %s\n", path);
+			return;
+		}
+		total += ReadStorage(storage);
+		storage->Release();
+	}
+	double storageTime = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	start = chrono::steady_clock::now();
+	for (int i = 0; i < loads; i++)
+	{
+		HANDLE file = CreateFileW(widePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		LARGE_INTEGER size;
+		GetFileSizeEx(file, &size);
+		HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		PostFileDecoder decoder;
+		if (decoder.Open(view, (size_t)size.QuadPart, UINT64_MAX))
+		{
+			vector<uint8_t> buffer(decoder.GetLength());
+			decoder.Write(buffer.data());
+		}
+		UnmapViewOfFile(view);
+		CloseHandle(mapping);
+		CloseHandle(file);
+	}
+	double decodeTime = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	printf("%s, %d loads (%.1f KB of streams)\n", path, loads, total / (double)loads / 1024);
+	printf("  IStorage, a stream at a time  %8.1f us per load\n", storageTime * 1e6 / loads);
+	printf("  mapped and decoded            %8.1f us per load\n", decodeTime * 1e6 / loads);
+	CoUninitialize();
+}
+#endif
+
+static void BenchmarkPost(const char* what, const Node& post, int loads)
+{
+	vector<uint8_t> file = CompoundFileWriter::Write(post, 3, 9);
+	vector<uint8_t> buffer;
+	size_t elements = 0;
+
+	auto start = chrono::steady_clock::now();
+	for (int i = 0; i < loads; i++)
+	{
+		PostFileDecoder decoder;
+		if (!decoder.Open(file.data(), file.size(), UINT64_MAX))
+			return;
+		buffer.resize(decoder.GetLength());
+		decoder.Write(buffer.data());
+		elements = decoder.GetElementCount();
+	}
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	printf("  %-34s %5d KB, %3d elements  %8.1f us per load  %7.0f MB/s\n", what, (int)(file.size() / 1024), (int)elements,
+		seconds * 1e6 / loads, file.size() * (double)loads / seconds / 1e6);
+}
+
+static void Benchmark(int argc, char* argv[])
+{
+	mt19937 random(4);
+	printf("decoding from memory\n");
+	BenchmarkPost("draft, pictures in the blob store", MakePost(20, 0, false, 40 * 1024, random), 20000);
+	BenchmarkPost("draft, 5 MB of embedded pictures", MakePost(20, 256 * 1024, true, 40 * 1024, random), 200);
+#ifdef _WIN32
+	for (int i = 2; i < argc; i++)
+		BenchmarkStorage(argv[i], 200);
+#else
+	(void)argc;
+	(void)argv;
+#endif
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc >= 2 && strcmp(argv[1], "/benchmark") == 0)
+	{
+		Benchmark(argc, argv);
+		return 0;
+	}
+	if (argc >= 2)
+	{
+		for (int i = 1; i < argc; i++)
+			List(argv[i]);
+		return failures == 0 ? 0 : 1;
+	}
+
+	CheckPosts();
+	CheckDamage();
+
+	printf("%s\n", failures == 0 ? "PASS" : "FAILED");
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,1038 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+/*
+Generates the ribbon command tables from Ribbon.xml:
+
+	RibbonTableGenerator <Ribbon.xml> <CommandId.cs> <RibbonCommands.h> <RibbonCommandTable.cs> [/check]
+
+Both outputs carry the same data: every <Command> with its id, name, symbol,
+keytip, the name of its CommandId member and the path of tabs and groups it
+first appears under, a minimal
+perfect hash from id and from symbol into that list, and the tabs and groups
+of the ribbon as dense ranges over a single array of command indexes. The
+native header is all constexpr; the managed table is static readonly arrays.
+
+The outputs are checked in next to RibbonID.h and CommandId.cs. Run this
+after editing Ribbon.xml or CommandId.cs; /check only compares and fails if
+they are stale. It reads the markup with its own small XML reader rather than
+MSXML, so that the check can also run on a build machine without Windows.
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/*
+Just enough of an XML reader for ribbon markup: elements, attributes,
+comments, processing instructions and the predefined and numeric entities.
+Text content is skipped.
+*/
+struct XmlElement
+{
+	string name;
+	vector<pair<string, string> > attributes;
+	vector<XmlElement*> children;
+	XmlElement *parent;
+
+	XmlElement() : parent(NULL)
+	{
+	}
+
+	~XmlElement()
+	{
+		for (size_t i = 0; i < children.size(); i++)
+			delete children[i];
+	}
+
+	const string *GetAttribute(const char *attributeName) const
+	{
+		for (size_t i = 0; i < attributes.size(); i++)
+		{
+			if (attributes[i].first == attributeName)
+				return &attributes[i].second;
+		}
+		return NULL;
+	}
+};
+
+class XmlReader
+{
+public:
+	explicit XmlReader(const string &text) : m_text(text), m_pos(0)
+	{
+	}
+
+	XmlElement *Parse()
+	{
+		XmlElement *root = NULL;
+		XmlElement *current = NULL;
+		while (m_pos < m_text.size())
+		{
+			if (m_text[m_pos] != '<')
+			{
+				m_pos++;
+				continue;
+			}
+
+			if (StartsWith("<!--"))
+			{
+				Skip("-->");
+			}
+			else if (StartsWith("<?") || StartsWith("<!"))
+			{
+				Skip(">");
+			}
+			else if (StartsWith("</"))
+			{
+				m_pos += 2;
+				string name = ReadName();
+				if (!current || current->name != name)
+					Fail("unexpected </" + name + ">");
+				Skip(">");
+				current = current->parent;
+			}
+			else
+			{
+				m_pos++;
+				XmlElement *element = new XmlElement();
+				element->name = ReadName();
+				element->parent = current;
+				if (current)
+					current->children.push_back(element);
+				else if (!root)
+					root = element;
+				else
+					Fail("more than one root element");
+
+				bool empty = ReadAttributes(element);
+				if (!empty)
+					current = element;
+			}
+		}
+		if (current)
+			Fail("<" + current->name + "> is never closed");
+		if (!root)
+			Fail("no root element");
+		return root;
+	}
+
+private:
+	const string &m_text;
+	size_t m_pos;
+
+	bool StartsWith(const char *prefix) const
+	{
+		return m_text.compare(m_pos, strlen(prefix), prefix) == 0;
+	}
+
+	void Skip(const char *terminator)
+	{
+		size_t end = m_text.find(terminator, m_pos);
+		if (end == string::npos)
+			Fail(string("missing ") + terminator);
+		m_pos = end + strlen(terminator);
+	}
+
+	void SkipSpace()
+	{
+		while (m_pos < m_text.size() && isspace((unsigned char)m_text[m_pos]))
+			m_pos++;
+	}
+
+	string ReadName()
+	{
+		size_t start = m_pos;
+		while (m_pos < m_text.size() && !isspace((unsigned char)m_text[m_pos]) && !strchr("=/>", m_text[m_pos]))
+			m_pos++;
+		if (start == m_pos)
+			Fail("expected a name");
+		return m_text.substr(start, m_pos - start);
+	}
+
+	// returns true for <Element/>
+	bool ReadAttributes(XmlElement *element)
+	{
+		for (;;)
+		{
+			SkipSpace();
+			if (StartsWith("/>"))
+			{
+				m_pos += 2;
+				return true;
+			}
+			if (StartsWith(">"))
+			{
+				m_pos++;
+				return false;
+			}
+
+			string name = ReadName();
+			SkipSpace();
+			if (!StartsWith("="))
+				Fail("expected = after " + name);
+			m_pos++;
+			SkipSpace();
+			if (m_pos >= m_text.size() || (m_text[m_pos] != '"' && m_text[m_pos] != '\''))
+				Fail("expected a quoted value for " + name);
+			char quote = m_text[m_pos++];
+			size_t end = m_text.find(quote, m_pos);
+			if (end == string::npos)
+				Fail("unterminated value for " + name);
+			element->attributes.push_back(make_pair(name, Decode(m_text.substr(m_pos, end - m_pos))));
+			m_pos = end + 1;
+		}
+	}
+
+	string Decode(const string &value)
+	{
+		string result;
+		for (size_t i = 0; i < value.size(); i++)
+		{
+			if (value[i] != '&')
+			{
+				result += value[i];
+				continue;
+			}
+
+			size_t end = value.find(';', i);
+			if (end == string::npos)
+				Fail("unterminated entity in \"" + value + "\"");
+			string entity = value.substr(i + 1, end - i - 1);
+			i = end;
+
+			if (entity == "amp") result += '&';
+			else if (entity == "lt") result += '<';
+			else if (entity == "gt") result += '>';
+			else if (entity == "quot") result += '"';
+			else if (entity == "apos") result += '\'';
+			else if (entity.size() > 1 && entity[0] == '#')
+				AppendUtf8(result, entity[1] == 'x' ? strtoul(entity.c_str() + 2, NULL, 16) : strtoul(entity.c_str() + 1, NULL, 10));
+			else
+				Fail("unknown entity &" + entity + ";");
+		}
+		return result;
+	}
+
+	static void AppendUtf8(string &result, unsigned long codePoint)
+	{
+		if (codePoint < 0x80)
+		{
+			result += (char)codePoint;
+		}
+		else if (codePoint < 0x800)
+		{
+			result += (char)(0xC0 | (codePoint >> 6));
+			result += (char)(0x80 | (codePoint & 0x3F));
+		}
+		else if (codePoint < 0x10000)
+		{
+			result += (char)(0xE0 | (codePoint >> 12));
+			result += (char)(0x80 | ((codePoint >> 6) & 0x3F));
+			result += (char)(0x80 | (codePoint & 0x3F));
+		}
+		else
+		{
+			result += (char)(0xF0 | (codePoint >> 18));
+			result += (char)(0x80 | ((codePoint >> 12) & 0x3F));
+			result += (char)(0x80 | ((codePoint >> 6) & 0x3F));
+			result += (char)(0x80 | (codePoint & 0x3F));
+		}
+	}
+
+	void Fail(const string &message) const
+	{
+		size_t line = 1 + count(m_text.begin(), m_text.begin() + min(m_pos, m_text.size()), '\n');
+		ostringstream error;
+		error << "line " << line << ": " << message;
+		throw runtime_error(error.str());
+	}
+};
+
+struct Command
+{
+	unsigned int id;
+	string name;
+	string symbol;
+	string identifier;	// the CommandId member with the same id
+	string keytip;
+	string groupPath;
+};
+
+struct Group
+{
+	size_t command;
+	size_t tab;
+	size_t begin;
+	size_t end;
+};
+
+struct Tab
+{
+	size_t command;
+	size_t begin;
+	size_t end;
+};
+
+struct RibbonTables
+{
+	vector<Command> commands;		// sorted by id
+	vector<Tab> tabs;
+	vector<Group> groups;
+	vector<size_t> groupCommands;
+	vector<unsigned short> idDisplacements;
+	vector<unsigned short> idSlots;
+	vector<unsigned short> symbolDisplacements;
+	vector<unsigned short> symbolSlots;
+};
+
+/*
+FNV-1a with a seed and a final avalanche. The generated lookups carry their
+own copies of this; all three have to agree bit for bit.
+*/
+static unsigned int Hash(unsigned int seed, const unsigned char *data, size_t length)
+{
+	unsigned int hash = 2166136261u ^ seed;
+	for (size_t i = 0; i < length; i++)
+	{
+		hash ^= data[i];
+		hash *= 16777619u;
+	}
+	hash ^= hash >> 16;
+	hash *= 0x85EBCA6Bu;
+	hash ^= hash >> 13;
+	return hash;
+}
+
+static unsigned int HashId(unsigned int seed, unsigned int id)
+{
+	unsigned char bytes[4] = { (unsigned char)id, (unsigned char)(id >> 8), (unsigned char)(id >> 16), (unsigned char)(id >> 24) };
+	return Hash(seed, bytes, sizeof(bytes));
+}
+
+static unsigned int HashSymbol(unsigned int seed, const string &symbol)
+{
+	return Hash(seed, (const unsigned char*)symbol.data(), symbol.size());
+}
+
+/*
+Hash and displace: keys are split into buckets by their seed 0 hash, and
+buckets are placed largest first, each with the first seed that sends all of
+its keys to free slots. A lookup is two hashes and one comparison.
+*/
+template <typename HashFunction>
+static void BuildPerfectHash(size_t count, HashFunction hash, vector<unsigned short> &displacements, vector<unsigned short> &slots)
+{
+	size_t bucketCount = max<size_t>(1, (count + 3) / 4);
+	vector<vector<size_t> > buckets(bucketCount);
+	for (size_t i = 0; i < count; i++)
+		buckets[hash(0, i) % bucketCount].push_back(i);
+
+	vector<size_t> order(bucketCount);
+	for (size_t i = 0; i < bucketCount; i++)
+		order[i] = i;
+	stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return buckets[a].size() > buckets[b].size(); });
+
+	displacements.assign(bucketCount, 0);
+	slots.assign(count, 0);
+	vector<bool> used(count, false);
+	for (size_t i = 0; i < bucketCount; i++)
+	{
+		const vector<size_t> &bucket = buckets[order[i]];
+		if (bucket.empty())
+			break;
+
+		unsigned int seed;
+		vector<size_t> placed;
+		for (seed = 1; seed <= 0xFFFF; seed++)
+		{
+			placed.clear();
+			for (size_t j = 0; j < bucket.size(); j++)
+			{
+				size_t slot = hash(seed, bucket[j]) % count;
+				if (used[slot] || find(placed.begin(), placed.end(), slot) != placed.end())
+					break;
+				placed.push_back(slot);
+			}
+			if (placed.size() == bucket.size())
+				break;
+		}
+		if (seed > 0xFFFF)
+			throw runtime_error("couldn't find a perfect hash");
+
+		displacements[order[i]] = (unsigned short)seed;
+		for (size_t j = 0; j < bucket.size(); j++)
+		{
+			used[placed[j]] = true;
+			slots[placed[j]] = (unsigned short)bucket[j];
+		}
+	}
+}
+
+static bool IsIdentifier(const string &value)
+{
+	if (value.empty() || isdigit((unsigned char)value[0]))
+		return false;
+	for (size_t i = 0; i < value.size(); i++)
+	{
+		if (!isalnum((unsigned char)value[i]) && value[i] != '_')
+			return false;
+	}
+	return true;
+}
+
+static const XmlElement *FindChild(const XmlElement *element, const char *name)
+{
+	for (size_t i = 0; i < element->children.size(); i++)
+	{
+		if (element->children[i]->name == name)
+			return element->children[i];
+	}
+	return NULL;
+}
+
+/*
+Reads the members of the CommandId enum, which are one per line, either
+"Name = value," or, for None, just "Name,".
+*/
+static map<unsigned int, string> ReadCommandIds(const string &source)
+{
+	size_t begin = source.find("enum CommandId");
+	if (begin == string::npos || (begin = source.find('{', begin)) == string::npos)
+		throw runtime_error("no CommandId enum");
+	size_t end = source.find('}', begin);
+	if (end == string::npos)
+		throw runtime_error("the CommandId enum isn't closed");
+
+	map<unsigned int, string> commandIds;
+	unsigned long next = 0;
+	istringstream lines(source.substr(begin + 1, end - begin - 1));
+	string line;
+	while (getline(lines, line))
+	{
+		size_t start = line.find_first_not_of(" \t\r");
+		if (start == string::npos || line.compare(start, 2, "//") == 0)
+			continue;
+		size_t stop = line.find_first_of(" \t\r=,", start);
+		string name = line.substr(start, stop == string::npos ? string::npos : stop - start);
+		if (!IsIdentifier(name))
+			throw runtime_error("can't read the CommandId member in \"" + line + "\"");
+
+		size_t equals = line.find('=', start);
+		if (equals != string::npos)
+		{
+			char *valueEnd;
+			next = strtoul(line.c_str() + equals + 1, &valueEnd, 0);
+		}
+		if (!commandIds.insert(make_pair((unsigned int)next, name)).second)
+			throw runtime_error("CommandId." + name + " has the same value as CommandId." + commandIds[(unsigned int)next]);
+		next++;
+	}
+	return commandIds;
+}
+
+static void ReadCommands(const XmlElement *application, const map<unsigned int, string> &commandIds, RibbonTables &tables)
+{
+	const XmlElement *commands = FindChild(application, "Application.Commands");
+	if (!commands)
+		throw runtime_error("no <Application.Commands>");
+
+	for (size_t i = 0; i < commands->children.size(); i++)
+	{
+		const XmlElement *element = commands->children[i];
+		if (element->name != "Command")
+			continue;
+
+		const string *name = element->GetAttribute("Name");
+		const string *symbol = element->GetAttribute("Symbol");
+		const string *id = element->GetAttribute("Id");
+		const string *keytip = element->GetAttribute("Keytip");
+		if (!name)
+			throw runtime_error("a <Command> has no Name");
+		if (!id)
+			throw runtime_error("command " + *name + " has no Id");
+
+		Command command;
+		command.name = *name;
+		command.symbol = symbol ? *symbol : *name;
+		command.keytip = keytip ? *keytip : "";
+
+		char *end;
+		unsigned long value = strtoul(id->c_str(), &end, 0);
+		if (id->empty() || *end || value == 0 || value > 0xFFFF)
+			throw runtime_error("command " + *name + " has an invalid Id " + *id);
+		command.id = (unsigned int)value;
+
+		if (!IsIdentifier(command.name) || !IsIdentifier(command.symbol))
+			throw runtime_error("command " + *name + " has a name or symbol that isn't an identifier");
+
+		// CommandManager registers commands under CommandId.ToString(), which
+		// isn't always the symbol without its "cmd" prefix
+		map<unsigned int, string>::const_iterator member = commandIds.find(command.id);
+		if (member == commandIds.end())
+			throw runtime_error("command " + *name + " has an Id that isn't in CommandId.cs");
+		command.identifier = member->second;
+
+		tables.commands.push_back(command);
+	}
+
+	stable_sort(tables.commands.begin(), tables.commands.end(), [](const Command &a, const Command &b) { return a.id < b.id; });
+	set<string> names, symbols;
+	for (size_t i = 0; i < tables.commands.size(); i++)
+	{
+		const Command &command = tables.commands[i];
+		if (i > 0 && tables.commands[i - 1].id == command.id)
+			throw runtime_error("duplicate command id " + to_string(command.id));
+		if (!names.insert(command.name).second)
+			throw runtime_error("duplicate command name " + command.name);
+		if (!symbols.insert(command.symbol).second)
+			throw runtime_error("duplicate command symbol " + command.symbol);
+	}
+	if (tables.commands.size() > 0xFFFF)
+		throw runtime_error("too many commands");
+}
+
+static bool IsContainer(const string &name)
+{
+	return name == "ApplicationMenu" || name == "TabGroup" || name == "Tab" || name == "Group";
+}
+
+class ViewWalker
+{
+public:
+	ViewWalker(RibbonTables &tables) : m_tables(tables), m_currentTab(NPOS), m_currentGroup(NPOS)
+	{
+		for (size_t i = 0; i < tables.commands.size(); i++)
+			m_indexes[tables.commands[i].name] = i;
+	}
+
+	void Walk(const XmlElement *element, const string &path)
+	{
+		const string *commandName = element->GetAttribute("CommandName");
+		size_t command = NPOS;
+		if (commandName)
+		{
+			map<string, size_t>::const_iterator it = m_indexes.find(*commandName);
+			if (it == m_indexes.end())
+				throw runtime_error("<" + element->name + "> refers to unknown command " + *commandName);
+			command = it->second;
+
+			// the first place a command shows up is its home
+			if (m_visited.insert(command).second)
+				m_tables.commands[command].groupPath = path;
+		}
+
+		size_t tab = m_currentTab, group = m_currentGroup;
+		if (element->name == "Tab" && command != NPOS)
+		{
+			Tab entry = { command, m_tables.groups.size(), m_tables.groups.size() };
+			m_tables.tabs.push_back(entry);
+			m_currentTab = m_tables.tabs.size() - 1;
+		}
+		else if (element->name == "Group" && command != NPOS && m_currentTab != NPOS)
+		{
+			Group entry = { command, m_currentTab, m_tables.groupCommands.size(), m_tables.groupCommands.size() };
+			m_tables.groups.push_back(entry);
+			m_currentGroup = m_tables.groups.size() - 1;
+			m_groupMembers.clear();
+		}
+		else if (command != NPOS && m_currentGroup != NPOS && m_groupMembers.insert(command).second)
+		{
+			m_tables.groupCommands.push_back(command);
+			m_tables.groups[m_currentGroup].end = m_tables.groupCommands.size();
+		}
+
+		string childPath = path;
+		if (commandName && IsContainer(element->name))
+			childPath = path.empty() ? *commandName : path + "/" + *commandName;
+		for (size_t i = 0; i < element->children.size(); i++)
+			Walk(element->children[i], childPath);
+
+		if (element->name == "Tab" && command != NPOS)
+			m_tables.tabs[m_currentTab].end = m_tables.groups.size();
+		m_currentTab = tab;
+		m_currentGroup = group;
+	}
+
+private:
+	static const size_t NPOS = (size_t)-1;
+
+	RibbonTables &m_tables;
+	map<string, size_t> m_indexes;
+	set<size_t> m_visited;
+	set<size_t> m_groupMembers;
+	size_t m_currentTab;
+	size_t m_currentGroup;
+};
+
+static void BuildTables(const XmlElement *application, const map<unsigned int, string> &commandIds, RibbonTables &tables)
+{
+	if (application->name != "Application")
+		throw runtime_error("the root element isn't <Application>");
+
+	ReadCommands(application, commandIds, tables);
+
+	const XmlElement *views = FindChild(application, "Application.Views");
+	if (views)
+	{
+		ViewWalker walker(tables);
+		walker.Walk(views, "");
+	}
+
+	const vector<Command> &commands = tables.commands;
+	BuildPerfectHash(commands.size(), [&](unsigned int seed, size_t i) { return HashId(seed, commands[i].id); },
+		tables.idDisplacements, tables.idSlots);
+	BuildPerfectHash(commands.size(), [&](unsigned int seed, size_t i) { return HashSymbol(seed, commands[i].symbol); },
+		tables.symbolDisplacements, tables.symbolSlots);
+}
+
+static string Quote(const string &value, bool csharp)
+{
+	string result = "\"";
+	for (size_t i = 0; i < value.size(); i++)
+	{
+		unsigned char c = value[i];
+		if (c == '"' || c == '\\')
+		{
+			result += '\\';
+			result += c;
+		}
+		else if (c >= 0x20 && c < 0x7F)
+		{
+			result += c;
+		}
+		else
+		{
+			// keytips and paths are ASCII in practice; anything else is escaped byte by byte
+			char escape[8];
+			if (csharp)
+				snprintf(escape, sizeof(escape), "\\u%04x", c);
+			else
+				snprintf(escape, sizeof(escape), "\\%03o", c);
+			result += escape;
+		}
+	}
+	return result + "\"";
+}
+
+template <typename T>
+static void WriteList(ostringstream &out, const vector<T> &values, const char *indent)
+{
+	for (size_t i = 0; i < values.size(); i++)
+	{
+		if (i % 16 == 0)
+			out << (i ? ",\n" : "") << indent;
+		else
+			out << ", ";
+		out << values[i];
+	}
+	out << "\n";
+}
+
+static const char *HEADER_COMMENT =
+	"// Copyright (c) .NET Foundation. All rights reserved.\n"
+	"// Licensed under the MIT license. See LICENSE file in the project root for details.\n"
+	"//\n"
+	"// This file is automatically generated. DO NOT edit it manually.\n"
+	"// Edit Ribbon.xml or CommandId.cs and run utilities\\RibbonTableGenerator.\n";
+
+static string GenerateHeader(const RibbonTables &tables)
+{
+	ostringstream out;
+	out << HEADER_COMMENT
+		<< "\n"
+		<< "#pragma once\n"
+		<< "\n"
+		<< "namespace RibbonCommands\n"
+		<< "{\n"
+		<< "\tstruct Range\n"
+		<< "\t{\n"
+		<< "\t\tunsigned short begin;\n"
+		<< "\t\tunsigned short end;\n"
+		<< "\t};\n"
+		<< "\n"
+		<< "\tstruct Command\n"
+		<< "\t{\n"
+		<< "\t\tunsigned int id;\n"
+		<< "\t\tconst char *name;\n"
+		<< "\t\tconst char *symbol;\n"
+		<< "\t\tconst char *keytip;\n"
+		<< "\t\tconst char *groupPath;\n"
+		<< "\t};\n"
+		<< "\n"
+		<< "\t// command is an index into Commands, groups a range of Groups\n"
+		<< "\tstruct Tab\n"
+		<< "\t{\n"
+		<< "\t\tunsigned short command;\n"
+		<< "\t\tRange groups;\n"
+		<< "\t};\n"
+		<< "\n"
+		<< "\t// commands is a range of GroupCommands\n"
+		<< "\tstruct Group\n"
+		<< "\t{\n"
+		<< "\t\tunsigned short command;\n"
+		<< "\t\tunsigned short tab;\n"
+		<< "\t\tRange commands;\n"
+		<< "\t};\n"
+		<< "\n"
+		<< "\tconstexpr unsigned int CommandCount = " << tables.commands.size() << ";\n"
+		<< "\tconstexpr unsigned int TabCount = " << tables.tabs.size() << ";\n"
+		<< "\tconstexpr unsigned int GroupCount = " << tables.groups.size() << ";\n"
+		<< "\n"
+		<< "\t// sorted by id\n"
+		<< "\tconstexpr Command Commands[CommandCount] =\n"
+		<< "\t{\n";
+	for (size_t i = 0; i < tables.commands.size(); i++)
+	{
+		const Command &command = tables.commands[i];
+		out << "\t\t{ " << command.id << ", " << Quote(command.name, false) << ", " << Quote(command.symbol, false)
+			<< ", " << Quote(command.keytip, false) << ", " << Quote(command.groupPath, false) << " },\n";
+	}
+	out << "\t};\n"
+		<< "\n"
+		<< "\tconstexpr Tab Tabs[TabCount] =\n"
+		<< "\t{\n";
+	for (size_t i = 0; i < tables.tabs.size(); i++)
+	{
+		const Tab &tab = tables.tabs[i];
+		out << "\t\t{ " << tab.command << ", { " << tab.begin << ", " << tab.end << " } },\t// " << tables.commands[tab.command].name << "\n";
+	}
+	out << "\t};\n"
+		<< "\n"
+		<< "\tconstexpr Group Groups[GroupCount] =\n"
+		<< "\t{\n";
+	for (size_t i = 0; i < tables.groups.size(); i++)
+	{
+		const Group &group = tables.groups[i];
+		out << "\t\t{ " << group.command << ", " << group.tab << ", { " << group.begin << ", " << group.end << " } },\t// "
+			<< tables.commands[group.command].name << "\n";
+	}
+	out << "\t};\n"
+		<< "\n"
+		<< "\tconstexpr unsigned short GroupCommands[] =\n"
+		<< "\t{\n";
+	WriteList(out, tables.groupCommands, "\t\t");
+	out << "\t};\n"
+		<< "\n"
+		<< "\tconstexpr unsigned int IdBucketCount = " << tables.idDisplacements.size() << ";\n"
+		<< "\tconstexpr unsigned short IdDisplacements[IdBucketCount] =\n"
+		<< "\t{\n";
+	WriteList(out, tables.idDisplacements, "\t\t");
+	out << "\t};\n"
+		<< "\n"
+		<< "\tconstexpr unsigned short IdSlots[CommandCount] =\n"
+		<< "\t{\n";
+	WriteList(out, tables.idSlots, "\t\t");
+	out << "\t};\n"
+		<< "\n"
+		<< "\tconstexpr unsigned int SymbolBucketCount = " << tables.symbolDisplacements.size() << ";\n"
+		<< "\tconstexpr unsigned short SymbolDisplacements[SymbolBucketCount] =\n"
+		<< "\t{\n";
+	WriteList(out, tables.symbolDisplacements, "\t\t");
+	out << "\t};\n"
+		<< "\n"
+		<< "\tconstexpr unsigned short SymbolSlots[CommandCount] =\n"
+		<< "\t{\n";
+	WriteList(out, tables.symbolSlots, "\t\t");
+	out << "\t};\n"
+		<< "\n"
+		<< "\tconstexpr unsigned int Avalanche(unsigned int hash)\n"
+		<< "\t{\n"
+		<< "\t\thash ^= hash >> 16;\n"
+		<< "\t\thash *= 0x85EBCA6Bu;\n"
+		<< "\t\treturn hash ^ (hash >> 13);\n"
+		<< "\t}\n"
+		<< "\n"
+		<< "\tconstexpr unsigned int HashId(unsigned int seed, unsigned int id)\n"
+		<< "\t{\n"
+		<< "\t\tunsigned int hash = 2166136261u ^ seed;\n"
+		<< "\t\tfor (int i = 0; i < 4; i++)\n"
+		<< "\t\t\thash = (hash ^ ((id >> (i * 8)) & 0xFF)) * 16777619u;\n"
+		<< "\t\treturn Avalanche(hash);\n"
+		<< "\t}\n"
+		<< "\n"
+		<< "\tconstexpr unsigned int HashSymbol(unsigned int seed, const char *symbol)\n"
+		<< "\t{\n"
+		<< "\t\tunsigned int hash = 2166136261u ^ seed;\n"
+		<< "\t\tfor (; *symbol; symbol++)\n"
+		<< "\t\t\thash = (hash ^ (unsigned char)*symbol) * 16777619u;\n"
+		<< "\t\treturn Avalanche(hash);\n"
+		<< "\t}\n"
+		<< "\n"
+		<< "\tconstexpr bool SymbolEquals(const char *a, const char *b)\n"
+		<< "\t{\n"
+		<< "\t\tfor (; *a && *a == *b; a++, b++)\n"
+		<< "\t\t\t;\n"
+		<< "\t\treturn *a == *b;\n"
+		<< "\t}\n"
+		<< "\n"
+		<< "\t// the index of the command in Commands, or -1\n"
+		<< "\tconstexpr int FindById(unsigned int id)\n"
+		<< "\t{\n"
+		<< "\t\tunsigned short index = IdSlots[HashId(IdDisplacements[HashId(0, id) % IdBucketCount], id) % CommandCount];\n"
+		<< "\t\treturn Commands[index].id == id ? index : -1;\n"
+		<< "\t}\n"
+		<< "\n"
+		<< "\tconstexpr int FindBySymbol(const char *symbol)\n"
+		<< "\t{\n"
+		<< "\t\tunsigned short index = SymbolSlots[HashSymbol(SymbolDisplacements[HashSymbol(0, symbol) % SymbolBucketCount], symbol) % CommandCount];\n"
+		<< "\t\treturn SymbolEquals(Commands[index].symbol, symbol) ? index : -1;\n"
+		<< "\t}\n"
+		<< "}\n";
+	return out.str();
+}
+
+static string GenerateTable(const RibbonTables &tables)
+{
+	ostringstream out;
+	out << HEADER_COMMENT
+		<< "\n"
+		<< "namespace OpenLiveWriter.Localization\n"
+		<< "{\n"
+		<< "    /// <summary>\n"
+		<< "    /// The commands, tabs and groups of Ribbon.xml, with constant time lookups by id and symbol.\n"
+		<< "    /// </summary>\n"
+		<< "    public static class RibbonCommandTable\n"
+		<< "    {\n"
+		<< "        public const int CommandCount = " << tables.commands.size() << ";\n"
+		<< "        public const int TabCount = " << tables.tabs.size() << ";\n"
+		<< "        public const int GroupCount = " << tables.groups.size() << ";\n"
+		<< "\n"
+		<< "        // sorted by id\n"
+		<< "        private static readonly ushort[] ids =\n"
+		<< "        {\n";
+	vector<unsigned int> ids;
+	for (size_t i = 0; i < tables.commands.size(); i++)
+		ids.push_back(tables.commands[i].id);
+	WriteList(out, ids, "            ");
+	out << "        };\n";
+
+	const char *columns[] = { "symbols", "identifiers", "keytips", "groupPaths" };
+	for (size_t column = 0; column < 4; column++)
+	{
+		out << "\n"
+			<< "        private static readonly string[] " << columns[column] << " =\n"
+			<< "        {\n";
+		for (size_t i = 0; i < tables.commands.size(); i++)
+		{
+			const Command &command = tables.commands[i];
+			const string &value = column == 0 ? command.symbol : column == 1 ? command.identifier : column == 2 ? command.keytip : command.groupPath;
+			out << "            " << Quote(value, true) << ",\n";
+		}
+		out << "        };\n";
+	}
+
+	vector<size_t> tabCommands, tabRanges, groupTabs, groupCommandsOf, groupRanges;
+	for (size_t i = 0; i < tables.tabs.size(); i++)
+	{
+		tabCommands.push_back(tables.tabs[i].command);
+		tabRanges.push_back(tables.tabs[i].begin);
+	}
+	tabRanges.push_back(tables.groups.size());
+	for (size_t i = 0; i < tables.groups.size(); i++)
+	{
+		groupCommandsOf.push_back(tables.groups[i].command);
+		groupTabs.push_back(tables.groups[i].tab);
+		groupRanges.push_back(tables.groups[i].begin);
+	}
+	groupRanges.push_back(tables.groupCommands.size());
+
+	struct { const char *name; const char *comment; const vector<size_t> *values; } arrays[] =
+	{
+		{ "tabCommands", "// command index of each tab", &tabCommands },
+		{ "tabGroupStarts", "// tab i owns groups [tabGroupStarts[i], tabGroupStarts[i + 1])", &tabRanges },
+		{ "groupCommands", "// command index of each group", &groupCommandsOf },
+		{ "groupTabs", "// tab index of each group", &groupTabs },
+		{ "groupMemberStarts", "// group i owns groupMembers [groupMemberStarts[i], groupMemberStarts[i + 1])", &groupRanges },
+		{ "groupMembers", "// command indexes", &tables.groupCommands },
+	};
+	for (size_t i = 0; i < sizeof(arrays) / sizeof(arrays[0]); i++)
+	{
+		out << "\n"
+			<< "        " << arrays[i].comment << "\n"
+			<< "        private static readonly ushort[] " << arrays[i].name << " =\n"
+			<< "        {\n";
+		WriteList(out, *arrays[i].values, "            ");
+		out << "        };\n";
+	}
+
+	struct { const char *name; const vector<unsigned short> *values; } hashes[] =
+	{
+		{ "idDisplacements", &tables.idDisplacements },
+		{ "idSlots", &tables.idSlots },
+		{ "symbolDisplacements", &tables.symbolDisplacements },
+		{ "symbolSlots", &tables.symbolSlots },
+	};
+	for (size_t i = 0; i < sizeof(hashes) / sizeof(hashes[0]); i++)
+	{
+		out << "\n"
+			<< "        private static readonly ushort[] " << hashes[i].name << " =\n"
+			<< "        {\n";
+		WriteList(out, *hashes[i].values, "            ");
+		out << "        };\n";
+	}
+
+	out << "\n"
+		<< "        /// <summary>\n"
+		<< "        /// Gets the index of the command with the specified id, or -1.\n"
+		<< "        /// </summary>\n"
+		<< "        public static int FindById(uint id)\n"
+		<< "        {\n"
+		<< "            int index = idSlots[HashId(idDisplacements[HashId(0, id) % (uint)idDisplacements.Length], id) % CommandCount];\n"
+		<< "            return ids[index] == id ? index : -1;\n"
+		<< "        }\n"
+		<< "\n"
+		<< "        /// <summary>\n"
+		<< "        /// Gets the index of the command with the specified Ribbon.xml symbol, or -1.\n"
+		<< "        /// </summary>\n"
+		<< "        public static int FindBySymbol(string symbol)\n"
+		<< "        {\n"
+		<< "            if (symbol == null)\n"
+		<< "                return -1;\n"
+		<< "            int index = symbolSlots[HashSymbol(symbolDisplacements[HashSymbol(0, symbol) % (uint)symbolDisplacements.Length], symbol) % CommandCount];\n"
+		<< "            return symbols[index] == symbol ? index : -1;\n"
+		<< "        }\n"
+		<< "\n"
+		<< "        public static uint GetId(int index) { return ids[index]; }\n"
+		<< "        public static string GetSymbol(int index) { return symbols[index]; }\n"
+		<< "\n"
+		<< "        /// <summary>\n"
+		<< "        /// Gets the name of the command's CommandId member.\n"
+		<< "        /// </summary>\n"
+		<< "        public static string GetIdentifier(int index) { return identifiers[index]; }\n"
+		<< "\n"
+		<< "        public static string GetKeytip(int index) { return keytips[index]; }\n"
+		<< "\n"
+		<< "        /// <summary>\n"
+		<< "        /// Gets the tabs and groups the command first appears under, separated by slashes.\n"
+		<< "        /// </summary>\n"
+		<< "        public static string GetGroupPath(int index) { return groupPaths[index]; }\n"
+		<< "\n"
+		<< "        public static int GetTabCommand(int tab) { return tabCommands[tab]; }\n"
+		<< "        public static int GetTabGroupStart(int tab) { return tabGroupStarts[tab]; }\n"
+		<< "        public static int GetTabGroupEnd(int tab) { return tabGroupStarts[tab + 1]; }\n"
+		<< "\n"
+		<< "        public static int GetGroupCommand(int group) { return groupCommands[group]; }\n"
+		<< "        public static int GetGroupTab(int group) { return groupTabs[group]; }\n"
+		<< "        public static int GetGroupMemberStart(int group) { return groupMemberStarts[group]; }\n"
+		<< "        public static int GetGroupMemberEnd(int group) { return groupMemberStarts[group + 1]; }\n"
+		<< "        public static int GetGroupMember(int position) { return groupMembers[position]; }\n"
+		<< "\n"
+		<< "        private static uint Avalanche(uint hash)\n"
+		<< "        {\n"
+		<< "            hash ^= hash >> 16;\n"
+		<< "            hash *= 0x85EBCA6B;\n"
+		<< "            return hash ^ (hash >> 13);\n"
+		<< "        }\n"
+		<< "\n"
+		<< "        private static uint HashId(uint seed, uint id)\n"
+		<< "        {\n"
+		<< "            uint hash = 2166136261 ^ seed;\n"
+		<< "            for (int i = 0; i < 4; i++)\n"
+		<< "                hash = (hash ^ ((id >> (i * 8)) & 0xFF)) * 16777619;\n"
+		<< "            return Avalanche(hash);\n"
+		<< "        }\n"
+		<< "\n"
+		<< "        // symbols are identifiers, so hashing chars is hashing their ASCII bytes\n"
+		<< "        private static uint HashSymbol(uint seed, string symbol)\n"
+		<< "        {\n"
+		<< "            uint hash = 2166136261 ^ seed;\n"
+		<< "            foreach (char c in symbol)\n"
+		<< "                hash = (hash ^ (c & 0xFFu)) * 16777619;\n"
+		<< "            return Avalanche(hash);\n"
+		<< "        }\n"
+		<< "    }\n"
+		<< "}\n";
+	return out.str();
+}
+
+static bool ReadFile(const char *path, string &contents)
+{
+	ifstream file(path, ios::binary);
+	if (!file)
+		return false;
+	ostringstream buffer;
+	buffer << file.rdbuf();
+	contents = buffer.str();
+	return true;
+}
+
+// returns false if the file was stale
+static bool Output(const char *path, const string &contents, bool check)
+{
+	string existing;
+	if (ReadFile(path, existing) && existing == contents)
+		return true;
+	if (check)
+	{
+		fprintf(stderr, "%s is out of date with Ribbon.xml or CommandId.cs\n", path);
+		return false;
+	}
+
+	ofstream file(path, ios::binary | ios::trunc);
+	if (!file.write(contents.data(), contents.size()))
+		throw runtime_error(string("can't write ") + path);
+	printf("Wrote %s\n", path);
+	return true;
+}
+
+int main(int argc, char *argv[])
+{
+	bool check = argc == 6 && (strcmp(argv[5], "/check") == 0 || strcmp(argv[5], "-check") == 0);
+	if (argc != 5 && !check)
+	{
+		fprintf(stderr, "Usage: RibbonTableGenerator <Ribbon.xml> <CommandId.cs> <RibbonCommands.h> <RibbonCommandTable.cs> [/check]\n");
+		return 2;
+	}
+
+	const char *input = argv[2];
+	try
+	{
+		string source;
+		if (!ReadFile(input, source))
+			throw runtime_error("can't read the file");
+		map<unsigned int, string> commandIds = ReadCommandIds(source);
+
+		input = argv[1];
+		string markup;
+		if (!ReadFile(input, markup))
+			throw runtime_error("can't read the file");
+
+		XmlReader reader(markup);
+		XmlElement *application = reader.Parse();
+		RibbonTables tables;
+		try
+		{
+			BuildTables(application, commandIds, tables);
+		}
+		catch (...)
+		{
+			delete application;
+			throw;
+		}
+		delete application;
+
+		bool current = Output(argv[3], GenerateHeader(tables), check);
+		current = Output(argv[4], GenerateTable(tables), check) && current;
+		if (!current)
+			return 1;
+
+		printf("%u commands, %u tabs, %u groups\n", (unsigned)tables.commands.size(), (unsigned)tables.tabs.size(), (unsigned)tables.groups.size());
+		return 0;
+	}
+	catch (const exception &e)
+	{
+		fprintf(stderr, "Error in %s: %s\n", input, e.what());
+		return 1;
+	}
+}
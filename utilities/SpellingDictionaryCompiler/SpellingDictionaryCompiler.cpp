@@ -0,0 +1,547 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+/*
+Compiles word lists into the spelling dictionaries that OpenLiveWriter.Native
+maps into memory (see SpellingDictionary.h in OpenLiveWriter.CppUtils), and
+tests and benchmarks lookups in them:
+
+	SpellingDictionaryCompiler words.txt en-US.dic
+	SpellingDictionaryCompiler /test
+	SpellingDictionaryCompiler /benchmark en-US.dic [post.txt]
+
+Word lists are UTF-8, one word per line, most common words first; blank lines
+and lines starting with # are skipped. The compiled dictionaries go in the
+Dictionaries folder of the installation, named by language (en-US.dic).
+
+/benchmark checks a 10,000 word post, made of words from the dictionary with
+every twentieth one misspelled unless a post is given, in one batch as the
+spelling highlighter does, and times suggestions for the misspellings.
+
+	c++ -std=c++11 -O2 -o SpellingDictionaryCompiler SpellingDictionaryCompiler.cpp
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "../../src/unmanaged/OpenLiveWriter.CppUtils/Include/SpellingDictionary.h"
+
+using namespace std;
+
+typedef basic_string<SpellingChar> SpellingString;
+
+#ifdef _WIN32
+#define T(s) L##s
+#else
+#define T(s) u##s
+#endif
+
+static SpellingString FromUtf8(const string &text)
+{
+	SpellingString result;
+	for (size_t i = 0; i < text.size();)
+	{
+		unsigned char c = (unsigned char)text[i];
+		unsigned int codePoint;
+		size_t extra;
+		if (c < 0x80) { codePoint = c; extra = 0; }
+		else if ((c & 0xE0) == 0xC0) { codePoint = c & 0x1F; extra = 1; }
+		else if ((c & 0xF0) == 0xE0) { codePoint = c & 0x0F; extra = 2; }
+		else if ((c & 0xF8) == 0xF0) { codePoint = c & 0x07; extra = 3; }
+		else { i++; continue; }
+
+		if (i + extra >= text.size())
+			break;
+		for (size_t j = 1; j <= extra; j++)
+			codePoint = (codePoint << 6) | ((unsigned char)text[i + j] & 0x3F);
+		i += extra + 1;
+
+		if (codePoint >= 0x10000)
+		{
+			codePoint -= 0x10000;
+			result += (SpellingChar)(0xD800 + (codePoint >> 10));
+			result += (SpellingChar)(0xDC00 + (codePoint & 0x3FF));
+		}
+		else
+		{
+			result += (SpellingChar)codePoint;
+		}
+	}
+	return result;
+}
+
+static string Narrow(const SpellingString &text)
+{
+	string narrow;
+	for (size_t i = 0; i < text.size(); i++)
+	{
+		SpellingChar c = text[i];
+		if (c >= 0x20 && c < 0x7F)
+		{
+			narrow += (char)c;
+		}
+		else
+		{
+			char escape[8];
+			snprintf(escape, sizeof(escape), "\\u%04X", (unsigned int)c);
+			narrow += escape;
+		}
+	}
+	return narrow;
+}
+
+// buckets for a table at most three quarters full
+static uint32_t BucketCount(size_t entries)
+{
+	return (uint32_t)(entries + entries / 3 + 1);
+}
+
+// Lays out the dictionary image of a word list, dropping repeated and overlong words.
+static vector<uint32_t> Compile(const vector<SpellingString> &wordList)
+{
+	vector<SpellingString> words;
+	unordered_set<SpellingString> seen;
+	size_t maxWordLength = 0;
+	for (size_t i = 0; i < wordList.size(); i++)
+	{
+		const SpellingString &word = wordList[i];
+		if (word.empty() || word.size() > SPELLING_DICTIONARY_MAX_WORD_LENGTH || !seen.insert(word).second)
+			continue;
+		words.push_back(word);
+		if (word.size() > maxWordLength)
+			maxWordLength = word.size();
+	}
+
+	SpellingDictionaryHeader header;
+	header.magic = SPELLING_DICTIONARY_MAGIC;
+	header.version = SPELLING_DICTIONARY_VERSION;
+	header.wordCount = (uint32_t)words.size();
+	header.wordBucketCount = BucketCount(words.size());
+	header.maxWordLength = (uint32_t)maxWordLength;
+
+	vector<uint32_t> offsets(1, 0);
+	SpellingString text;
+	vector<uint32_t> wordBuckets(header.wordBucketCount * 2, 0);
+
+	// each distinct delete's hash, in the order first seen, and its words
+	vector<uint32_t> deleteHashes;
+	unordered_map<uint32_t, vector<uint32_t> > deletes;
+
+	for (uint32_t id = 0; id < words.size(); id++)
+	{
+		const SpellingString &word = words[id];
+		text += word;
+		offsets.push_back((uint32_t)text.size());
+
+		uint32_t hash = SpellingDictionary::Hash(word.c_str(), word.size(), word.size());
+		uint32_t i = hash % header.wordBucketCount;
+		while (wordBuckets[i * 2 + 1] != 0)
+			i = (i + 1) % header.wordBucketCount;
+		wordBuckets[i * 2] = hash;
+		wordBuckets[i * 2 + 1] = id + 1;
+
+		for (size_t skip = 0; skip < word.size(); skip++)
+		{
+			if (skip > 0 && SpellingDictionary::Fold(word[skip]) == SpellingDictionary::Fold(word[skip - 1]))
+				continue;
+
+			hash = SpellingDictionary::Hash(word.c_str(), word.size(), skip);
+			vector<uint32_t> &postings = deletes[hash];
+			if (postings.empty())
+				deleteHashes.push_back(hash);
+			if (postings.empty() || postings.back() != id)
+				postings.push_back(id);
+		}
+	}
+
+	header.deleteBucketCount = BucketCount(deleteHashes.size());
+	header.textLength = (uint32_t)text.size();
+	vector<uint32_t> deleteBuckets(header.deleteBucketCount * 2, 0);
+	vector<uint32_t> postings;
+	for (size_t d = 0; d < deleteHashes.size(); d++)
+	{
+		const vector<uint32_t> &words = deletes[deleteHashes[d]];
+		uint32_t i = deleteHashes[d] % header.deleteBucketCount;
+		while (deleteBuckets[i * 2 + 1] != 0)
+			i = (i + 1) % header.deleteBucketCount;
+		deleteBuckets[i * 2] = deleteHashes[d];
+		deleteBuckets[i * 2 + 1] = (uint32_t)postings.size() + 1;
+		postings.insert(postings.end(), words.begin(), words.end());
+		postings.back() |= SPELLING_DICTIONARY_LAST_POSTING;
+	}
+	header.postingCount = (uint32_t)postings.size();
+
+	vector<uint32_t> image(sizeof(header) / 4);
+	memcpy(&image[0], &header, sizeof(header));
+	image.insert(image.end(), offsets.begin(), offsets.end());
+	image.insert(image.end(), wordBuckets.begin(), wordBuckets.end());
+	image.insert(image.end(), deleteBuckets.begin(), deleteBuckets.end());
+	image.insert(image.end(), postings.begin(), postings.end());
+
+	size_t textStart = image.size();
+	image.resize(textStart + (text.size() * sizeof(SpellingChar) + 3) / 4, 0);
+	if (!text.empty())
+		memcpy(&image[textStart], text.c_str(), text.size() * sizeof(SpellingChar));
+	return image;
+}
+
+static bool ReadFile(const char *path, string &contents)
+{
+	FILE *file = fopen(path, "rb");
+	if (file == NULL)
+		return false;
+	char buffer[65536];
+	size_t read;
+	while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		contents.append(buffer, read);
+	fclose(file);
+	return true;
+}
+
+static vector<SpellingString> ReadWordList(const string &contents)
+{
+	vector<SpellingString> words;
+	size_t start = 0;
+	if (contents.compare(0, 3, "\xEF\xBB\xBF") == 0)
+		start = 3;
+	while (start < contents.size())
+	{
+		size_t end = contents.find('\n', start);
+		if (end == string::npos)
+			end = contents.size();
+		string line = contents.substr(start, end - start);
+		start = end + 1;
+
+		while (!line.empty() && (line[line.size() - 1] == '\r' || line[line.size() - 1] == ' ' || line[line.size() - 1] == '\t'))
+			line.erase(line.size() - 1);
+		if (line.empty() || line[0] == '#')
+			continue;
+		words.push_back(FromUtf8(line));
+	}
+	return words;
+}
+
+static int failures = 0;
+
+static void Fail(const char *what, const SpellingString &word, const string &expected, const string &actual)
+{
+	printf("FAIL %s(%s)\n  expected %s\n  actual   %s\n", what, Narrow(word).c_str(), expected.c_str(), actual.c_str());
+	failures++;
+}
+
+static void ExpectCheck(const SpellingDictionary &dictionary, const SpellingString &word, SpellingCheck expected)
+{
+	SpellingCheck actual = dictionary.Check(word.c_str(), word.size());
+	if (actual != expected)
+		Fail("Check", word, to_string((int)expected), to_string((int)actual));
+}
+
+// expected lists the first suggestions, most likely first, separated by spaces
+static void ExpectSuggestions(const SpellingDictionary &dictionary, const SpellingString &word, const SpellingString &expected)
+{
+	SpellingSuggestion suggestions[8];
+	size_t count = dictionary.Suggest(word.c_str(), word.size(), suggestions, 8);
+	SpellingString actual;
+	for (size_t i = 0; i < count; i++)
+	{
+		size_t length;
+		const SpellingChar *spelling = dictionary.GetWord(suggestions[i].word, &length);
+		if (i > 0)
+			actual += ' ';
+		actual.append(spelling, length);
+	}
+	if (actual.compare(0, expected.size(), expected) != 0)
+		Fail("Suggest", word, Narrow(expected), Narrow(actual));
+}
+
+static void Test()
+{
+	static const SpellingChar *WORDS[] =
+	{
+		T("the"), T("of"), T("and"), T("a"), T("to"), T("in"), T("is"), T("you"), T("that"), T("it"),
+		T("he"), T("was"), T("for"), T("on"), T("are"), T("with"), T("they"), T("be"), T("at"), T("one"),
+		T("have"), T("this"), T("from"), T("word"), T("words"), T("world"), T("would"), T("weird"),
+		T("receive"), T("believe"), T("separate"), T("definitely"), T("necessary"), T("occasion"),
+		T("London"), T("Paris"), T("iPhone"), T("don't"), T("café"), T("naïve"), T("Ärger"), T("über"),
+		T("привет"), T("Москва"), T("αλφα"), T("the"),
+	};
+	vector<SpellingString> words;
+	for (size_t i = 0; i < sizeof(WORDS) / sizeof(WORDS[0]); i++)
+		words.push_back(WORDS[i]);
+
+	vector<uint32_t> image = Compile(words);
+	SpellingDictionary dictionary;
+	if (!dictionary.Open(&image[0], image.size() * 4))
+	{
+		printf("FAIL Open\n");
+		failures++;
+		return;
+	}
+	if (dictionary.GetWordCount() != words.size() - 1)
+		Fail("GetWordCount", T(""), to_string(words.size() - 1), to_string(dictionary.GetWordCount()));
+
+	// damaged images are refused
+	vector<uint32_t> truncated(image.begin(), image.end() - 8);
+	SpellingDictionary damaged;
+	if (damaged.Open(&truncated[0], truncated.size() * 4) || damaged.Open(&image[0], 16))
+		Fail("Open", T("<damaged>"), "false", "true");
+
+	ExpectCheck(dictionary, T("the"), SPELLING_CORRECT);
+	ExpectCheck(dictionary, T("The"), SPELLING_CORRECT);
+	ExpectCheck(dictionary, T("THE"), SPELLING_CORRECT);
+	ExpectCheck(dictionary, T("tHe"), SPELLING_CAPITALIZATION);
+	ExpectCheck(dictionary, T("London"), SPELLING_CORRECT);
+	ExpectCheck(dictionary, T("LONDON"), SPELLING_CORRECT);
+	ExpectCheck(dictionary, T("london"), SPELLING_CAPITALIZATION);
+	ExpectCheck(dictionary, T("iPhone"), SPELLING_CORRECT);
+	ExpectCheck(dictionary, T("IPhone"), SPELLING_CORRECT);
+	ExpectCheck(dictionary, T("iphone"), SPELLING_CAPITALIZATION);
+	ExpectCheck(dictionary, T("don't"), SPELLING_CORRECT);
+	ExpectCheck(dictionary, T("Don’t"), SPELLING_CORRECT);
+	ExpectCheck(dictionary, T("CAFÉ"), SPELLING_CORRECT);
+	ExpectCheck(dictionary, T("ärger"), SPELLING_CAPITALIZATION);
+	ExpectCheck(dictionary, T("Über"), SPELLING_CORRECT);
+	ExpectCheck(dictionary, T("ПРИВЕТ"), SPELLING_CORRECT);
+	ExpectCheck(dictionary, T("москва"), SPELLING_CAPITALIZATION);
+	ExpectCheck(dictionary, T("ΑΛΦΑ"), SPELLING_CORRECT);
+	ExpectCheck(dictionary, T("teh"), SPELLING_MISSPELLED);
+	ExpectCheck(dictionary, T("th"), SPELLING_MISSPELLED);
+	ExpectCheck(dictionary, T("thee"), SPELLING_MISSPELLED);
+	ExpectCheck(dictionary, T(""), SPELLING_CORRECT);
+	ExpectCheck(dictionary, SpellingString(100, 'a'), SPELLING_MISSPELLED);
+
+	// the batch gives the same answers as one at a time
+	SpellingString text = T("The teh london");
+	int starts[] = { 0, 4, 8 };
+	int lengths[] = { 3, 3, 6 };
+	unsigned char results[3];
+	dictionary.CheckWords(text.c_str(), starts, lengths, 3, results);
+	if (results[0] != SPELLING_CORRECT || results[1] != SPELLING_MISSPELLED || results[2] != SPELLING_CAPITALIZATION)
+		Fail("CheckWords", text, "0 4 3", to_string(results[0]) + " " + to_string(results[1]) + " " + to_string(results[2]));
+
+	ExpectSuggestions(dictionary, T("teh"), T("the"));				// swap
+	ExpectSuggestions(dictionary, T("th"), T("the"));				// deletion
+	ExpectSuggestions(dictionary, T("thhe"), T("the"));				// insertion
+	ExpectSuggestions(dictionary, T("tha"), T("the that"));			// substitution, then a commoner word further away
+	ExpectSuggestions(dictionary, T("recieve"), T("receive"));
+	ExpectSuggestions(dictionary, T("beleive"), T("believe"));
+	ExpectSuggestions(dictionary, T("seperate"), T("separate"));
+	ExpectSuggestions(dictionary, T("neccessary"), T("necessary"));
+	ExpectSuggestions(dictionary, T("ocasion"), T("occasion"));
+	ExpectSuggestions(dictionary, T("wrod"), T("word"));
+	ExpectSuggestions(dictionary, T("worlds"), T("words world"));	// equally close words, commoner first
+	ExpectSuggestions(dictionary, T("london"), T("London"));
+	ExpectSuggestions(dictionary, T("cafe"), T("café"));
+
+	SpellingSuggestion suggestions[8];
+	if (dictionary.Suggest(T("xyzzyq"), 6, suggestions, 8) != 0)
+		Fail("Suggest", T("xyzzyq"), "no suggestions", "some");
+	if (dictionary.Suggest(T("teh"), 3, suggestions, 1) != 1 || suggestions[0].distance != 1)
+		Fail("Suggest", T("teh"), "one suggestion at distance 1", "something else");
+
+	static const struct { const SpellingChar *a; const SpellingChar *b; unsigned int distance; } DISTANCES[] =
+	{
+		{ T("the"), T("the"), 0 }, { T("teh"), T("the"), 1 }, { T("ca"), T("abc"), 3 },
+		{ T("kitten"), T("sitting"), 3 }, { T(""), T("ab"), 2 }, { T("abcd"), T("badc"), 2 },
+	};
+	for (size_t i = 0; i < sizeof(DISTANCES) / sizeof(DISTANCES[0]); i++)
+	{
+		SpellingString a = DISTANCES[i].a, b = DISTANCES[i].b;
+		unsigned int distance = SpellingDictionary::Distance(a.c_str(), a.size(), b.c_str(), b.size(), 5);
+		if (distance != DISTANCES[i].distance)
+			Fail("Distance", a + T(" ") + b, to_string(DISTANCES[i].distance), to_string(distance));
+		if (SpellingDictionary::Distance(a.c_str(), a.size(), b.c_str(), b.size(), 1) != (distance > 1 ? 2 : distance))
+			Fail("Distance", a + T(" ") + b, "limited to 2", "not limited");
+	}
+}
+
+static bool Load(const char *path, vector<uint32_t> &image, SpellingDictionary &dictionary)
+{
+	string contents;
+	if (!ReadFile(path, contents))
+	{
+		printf("Can't read %s\n", path);
+		return false;
+	}
+	image.assign(contents.size() / 4 + 1, 0);
+	memcpy(&image[0], contents.data(), contents.size());
+	if (!dictionary.Open(image.empty() ? NULL : &image[0], contents.size()))
+	{
+		printf("%s isn't a spelling dictionary\n", path);
+		return false;
+	}
+	return true;
+}
+
+// roughly what the highlighter takes for words: letters, digits and apostrophes
+static bool IsWordCharacter(SpellingChar c)
+{
+	return c == '\'' || (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') ||
+		(c >= 0xC0 && c != 0xD7 && c != 0xF7 && (c < 0x2000 || c == 0x2019));
+}
+
+static int Benchmark(const char *dictionaryPath, const char *postPath)
+{
+	vector<uint32_t> image;
+	SpellingDictionary dictionary;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	if (!Load(dictionaryPath, image, dictionary))
+		return 1;
+	double loadSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	if (dictionary.GetWordCount() == 0)
+	{
+		printf("%s has no words\n", dictionaryPath);
+		return 1;
+	}
+
+	// the post, and its words as the highlighter would find them
+	SpellingString text;
+	vector<int> starts, lengths;
+	if (postPath != NULL)
+	{
+		string contents;
+		if (!ReadFile(postPath, contents))
+		{
+			printf("Can't read %s\n", postPath);
+			return 1;
+		}
+		text = FromUtf8(contents);
+		for (size_t i = 0; i < text.size();)
+		{
+			if (!IsWordCharacter(text[i]))
+			{
+				i++;
+				continue;
+			}
+			size_t end = i;
+			while (end < text.size() && IsWordCharacter(text[end]))
+				end++;
+			starts.push_back((int)i);
+			lengths.push_back((int)(end - i));
+			i = end;
+		}
+	}
+	else
+	{
+		// common words more often than rare ones, and every twentieth one misspelled
+		uint32_t random = 12345;
+		for (int i = 0; i < 10000; i++)
+		{
+			random = random * 1103515245 + 12345;
+			uint32_t word = (uint32_t)(((uint64_t)(random >> 8) * (random >> 8) >> 32) % dictionary.GetWordCount());
+			size_t length;
+			const SpellingChar *spelling = dictionary.GetWord(word, &length);
+			SpellingString copy(spelling, length);
+			if (i % 20 == 19 && copy.size() > 2)
+				swap(copy[copy.size() / 2], copy[copy.size() / 2 - 1]);
+			starts.push_back((int)text.size());
+			lengths.push_back((int)copy.size());
+			text += copy;
+			text += ' ';
+		}
+	}
+	if (starts.empty())
+	{
+		printf("The post has no words\n");
+		return 1;
+	}
+
+	vector<unsigned char> results(starts.size());
+	const int ROUNDS = 50;
+	start = chrono::steady_clock::now();
+	for (int round = 0; round < ROUNDS; round++)
+		dictionary.CheckWords(text.c_str(), &starts[0], &lengths[0], starts.size(), &results[0]);
+	double checkSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count() / ROUNDS;
+
+	vector<size_t> misspelled;
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		if (results[i] != SPELLING_CORRECT)
+			misspelled.push_back(i);
+	}
+
+	double suggestSeconds = 0;
+	size_t suggested = 0;
+	if (!misspelled.empty())
+	{
+		SpellingSuggestion suggestions[10];
+		start = chrono::steady_clock::now();
+		for (size_t i = 0; i < misspelled.size(); i++)
+		{
+			size_t word = misspelled[i];
+			if (dictionary.Suggest(text.c_str() + starts[word], lengths[word], suggestions, 10) > 0)
+				suggested++;
+		}
+		suggestSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	}
+
+	printf("dictionary: %u words, %.2f MB, read and opened in %.3f ms\n", dictionary.GetWordCount(), image.size() * 4 / 1e6, loadSeconds * 1e3);
+	printf("check: %u words in %.3f ms (%.0f ns/word)\n", (unsigned int)starts.size(), checkSeconds * 1e3, checkSeconds * 1e9 / starts.size());
+	if (!misspelled.empty())
+	{
+		printf("suggest: %u misspellings in %.3f ms (%.1f us each), %u with suggestions\n",
+			(unsigned int)misspelled.size(), suggestSeconds * 1e3, suggestSeconds * 1e6 / misspelled.size(), (unsigned int)suggested);
+	}
+	return 0;
+}
+
+static int Usage()
+{
+	printf("Usage: SpellingDictionaryCompiler words.txt dictionary.dic\n"
+		   "       SpellingDictionaryCompiler /test\n"
+		   "       SpellingDictionaryCompiler /benchmark dictionary.dic [post.txt]\n");
+	return 2;
+}
+
+static bool IsOption(const char *argument, const char *option)
+{
+	return (argument[0] == '/' || argument[0] == '-') && strcmp(argument + 1, option) == 0;
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc == 2 && IsOption(argv[1], "test"))
+	{
+		Test();
+		if (failures > 0)
+		{
+			printf("%d failures\n", failures);
+			return 1;
+		}
+		printf("All lookups match\n");
+		return 0;
+	}
+
+	if ((argc == 3 || argc == 4) && IsOption(argv[1], "benchmark"))
+		return Benchmark(argv[2], argc == 4 ? argv[3] : NULL);
+
+	if (argc != 3)
+		return Usage();
+
+	string contents;
+	if (!ReadFile(argv[1], contents))
+	{
+		printf("Can't read %s\n", argv[1]);
+		return 1;
+	}
+	vector<uint32_t> image = Compile(ReadWordList(contents));
+
+	FILE *output = fopen(argv[2], "wb");
+	if (output == NULL || fwrite(&image[0], 4, image.size(), output) != image.size())
+	{
+		printf("Can't write %s\n", argv[2]);
+		if (output != NULL)
+			fclose(output);
+		return 1;
+	}
+	fclose(output);
+
+	const SpellingDictionaryHeader *header = (const SpellingDictionaryHeader *)&image[0];
+	printf("%u words, %u deletes, %.2f MB\n", header->wordCount, header->postingCount, image.size() * 4 / 1e6);
+	return 0;
+}
@@ -0,0 +1,451 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+/*
+Checks the thumbnail cache in OpenLiveWriter.CppUtils (ThumbnailCache.h) and
+measures opening a gallery of photos with it cold and warm:
+
+	ThumbnailCacheCheck [/benchmark]
+
+Thumbnails are stored and found against a model here that remembers what was
+stored: whatever the cache finds has to be exactly what was last stored for
+its key, and the most recent thumbnails that fit have to be found. Thumbnails
+that keep being found have to survive a stream of new ones, a cache that was
+closed has to keep its thumbnails when it's opened again and one that wasn't
+(as after a crash) has to come back empty. Caches with garbage written over
+them must not be read out of bounds (build with -fsanitize=address to be
+sure), and readers on several threads, locked as OpenLiveWriter.Native locks
+them, have to find whole thumbnails while another thread stores. Exits with 1
+if anything differs.
+
+The benchmark opens a gallery of 48 twelve megapixel photos at 160x120: cold,
+each is resampled (ImageResampler.h, as the managed code would after decoding
+it, which isn't counted) and stored; warm, each is found, after the cache has
+been written to a file and read back as a new session would map it.
+
+It needs C++17 for std::shared_mutex, which stands in for the SRW lock:
+
+	c++ -std=c++17 -O2 -msse2 -pthread -o ThumbnailCacheCheck ThumbnailCacheCheck.cpp
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+#include "../../src/unmanaged/OpenLiveWriter.CppUtils/Include/ImageResampler.h"
+#include "../../src/unmanaged/OpenLiveWriter.CppUtils/Include/ThumbnailCache.h"
+
+using namespace std;
+
+struct Key
+{
+	uint8_t hash[THUMBNAIL_CACHE_HASH_LENGTH];
+	uint32_t requestedWidth;
+	uint32_t requestedHeight;
+
+	bool operator<(const Key& other) const
+	{
+		int compared = memcmp(hash, other.hash, sizeof(hash));
+		if (compared != 0)
+			return compared < 0;
+		if (requestedWidth != other.requestedWidth)
+			return requestedWidth < other.requestedWidth;
+		return requestedHeight < other.requestedHeight;
+	}
+};
+
+struct Thumbnail
+{
+	uint32_t width;
+	uint32_t height;
+	vector<uint8_t> pixels;
+};
+
+static Key MakeKey(uint32_t image, uint32_t requestedWidth, uint32_t requestedHeight)
+{
+	// a stand-in for the SHA-256 of the image
+	Key key;
+	mt19937 random(image);
+	for (size_t i = 0; i < sizeof(key.hash); i++)
+		key.hash[i] = (uint8_t)random();
+	key.requestedWidth = requestedWidth;
+	key.requestedHeight = requestedHeight;
+	return key;
+}
+
+static Thumbnail MakeThumbnail(uint32_t width, uint32_t height, uint32_t seed)
+{
+	Thumbnail thumbnail;
+	thumbnail.width = width;
+	thumbnail.height = height;
+	thumbnail.pixels.resize((size_t)width * height * 4);
+	mt19937 random(seed);
+	for (size_t i = 0; i < thumbnail.pixels.size(); i++)
+		thumbnail.pixels[i] = (uint8_t)random();
+	return thumbnail;
+}
+
+static int failures = 0;
+
+static void Expect(bool condition, const char* what, const char* detail)
+{
+	if (!condition)
+	{
+		printf("FAIL %s: %s\n", what, detail);
+		failures++;
+	}
+}
+
+static bool Store(ThumbnailCache& cache, const Key& key, const Thumbnail& thumbnail)
+{
+	return cache.Store(key.hash, key.requestedWidth, key.requestedHeight, thumbnail.width, thumbnail.height, thumbnail.pixels.data(), thumbnail.width * 4);
+}
+
+static bool Find(const ThumbnailCache& cache, const Key& key, Thumbnail* thumbnail, bool* store)
+{
+	thumbnail->pixels.assign((size_t)key.requestedWidth * key.requestedHeight * 4, 0);
+	if (!cache.Find(key.hash, key.requestedWidth, key.requestedHeight, &thumbnail->width, &thumbnail->height, thumbnail->pixels.data(), store))
+		return false;
+	thumbnail->pixels.resize((size_t)thumbnail->width * thumbnail->height * 4);
+	return true;
+}
+
+static bool Same(const Thumbnail& a, const Thumbnail& b)
+{
+	return a.width == b.width && a.height == b.height && a.pixels == b.pixels;
+}
+
+static void CheckAgainstModel()
+{
+	vector<uint64_t> memory(2 * 1024 * 1024 / 8);
+	ThumbnailCache cache;
+	Expect(cache.Open(memory.data(), memory.size() * 8), "open", "2 MB");
+
+	// thumbnails of a few sizes, some images at more than one, some stored again
+	map<Key, Thumbnail> model;
+	vector<Key> order;
+	mt19937 random(45);
+	const uint32_t sizes[][2] = { { 64, 64 }, { 160, 120 }, { 96, 96 }, { 200, 150 } };
+	for (uint32_t i = 0; i < 3000; i++)
+	{
+		uint32_t image = random() % 700;
+		const uint32_t* size = sizes[random() % 4];
+		Key key = MakeKey(image, size[0], size[1]);
+		Thumbnail thumbnail = MakeThumbnail(size[0] - random() % 20, size[1] - random() % 20, i);
+
+		Expect(Store(cache, key, thumbnail), "stored", "thumbnail");
+		model[key] = thumbnail;
+		order.push_back(key);
+
+		// everything found is what was last stored
+		if (i % 100 == 99)
+		{
+			uint32_t found = 0;
+			for (map<Key, Thumbnail>::iterator entry = model.begin(); entry != model.end(); ++entry)
+			{
+				Thumbnail cached;
+				bool store;
+				if (Find(cache, entry->first, &cached, &store))
+				{
+					found++;
+					Expect(Same(cached, entry->second), "found what was stored", "model");
+				}
+			}
+			Expect(found == cache.GetThumbnailCount(), "count", "model");
+		}
+	}
+
+	// the most recent thumbnails are all there
+	map<Key, bool> recent;
+	for (size_t i = order.size() - 20; i < order.size(); i++)
+		recent[order[i]] = true;
+	for (map<Key, bool>::iterator entry = recent.begin(); entry != recent.end(); ++entry)
+	{
+		Thumbnail cached;
+		bool store;
+		Expect(Find(cache, entry->first, &cached, &store) && Same(cached, model[entry->first]), "recent found", "model");
+	}
+
+	// one too large isn't stored
+	Thumbnail large = MakeThumbnail(1000, 1000, 1);
+	Expect(!Store(cache, MakeKey(1, 1000, 1000), large), "too large", "1000x1000");
+	Thumbnail wide = MakeThumbnail(65, 64, 1);
+	Expect(!Store(cache, MakeKey(1, 64, 64), wide), "larger than requested", "65x64");
+	cache.Close();
+}
+
+static void CheckHotThumbnailsKept()
+{
+	vector<uint64_t> memory(2 * 1024 * 1024 / 8);
+	ThumbnailCache cache;
+	cache.Open(memory.data(), memory.size() * 8);
+
+	// a gallery that keeps being opened, while many other images go through
+	const uint32_t hot = 10;
+	for (uint32_t i = 0; i < hot; i++)
+		Store(cache, MakeKey(i, 64, 64), MakeThumbnail(64, 64, i));
+
+	uint32_t misses = 0;
+	for (uint32_t i = 0; i < 5000; i++)
+	{
+		Store(cache, MakeKey(1000 + i, 96, 96), MakeThumbnail(96, 96, i));
+		if (i % 10 == 0)
+		{
+			for (uint32_t h = 0; h < hot; h++)
+			{
+				Key key = MakeKey(h, 64, 64);
+				Thumbnail cached;
+				bool store;
+				if (!Find(cache, key, &cached, &store))
+				{
+					misses++;
+					Store(cache, key, MakeThumbnail(64, 64, h));
+				}
+				else if (store)
+					Store(cache, key, cached);
+			}
+		}
+	}
+	char detail[100];
+	snprintf(detail, sizeof(detail), "%d misses", (int)misses);
+	Expect(misses == 0, "used thumbnails kept", detail);
+
+	// and ones that weren't used went
+	Thumbnail cached;
+	bool store;
+	Expect(!Find(cache, MakeKey(1000, 96, 96), &cached, &store), "unused thumbnails evicted", "first");
+}
+
+static void CheckReopening()
+{
+	vector<uint64_t> memory(THUMBNAIL_CACHE_MIN_SIZE / 8);
+	Key key = MakeKey(7, 160, 120);
+	Thumbnail thumbnail = MakeThumbnail(160, 107, 7);
+	Thumbnail cached;
+	bool store;
+
+	ThumbnailCache cache;
+	cache.Open(memory.data(), memory.size() * 8);
+	Store(cache, key, thumbnail);
+	cache.Close();
+
+	cache.Open(memory.data(), memory.size() * 8);
+	Expect(Find(cache, key, &cached, &store) && Same(cached, thumbnail), "kept when closed", "reopen");
+
+	// not closed
+	ThumbnailCache crashed;
+	crashed.Open(memory.data(), memory.size() * 8);
+	Expect(!Find(crashed, key, &cached, &store) && crashed.GetThumbnailCount() == 0, "emptied when not closed", "reopen");
+	Store(crashed, key, thumbnail);
+	crashed.Close();
+
+	// another size
+	vector<uint64_t> larger(memory);
+	larger.resize(memory.size() * 2);
+	crashed.Open(larger.data(), larger.size() * 8);
+	Expect(!Find(crashed, key, &cached, &store), "emptied when resized", "reopen");
+	crashed.Close();
+
+	Expect(!cache.Open(memory.data(), THUMBNAIL_CACHE_MIN_SIZE - 8), "too small", "open");
+}
+
+static void CheckGarbage()
+{
+	mt19937 random(46);
+	for (int run = 0; run < 200; run++)
+	{
+		vector<uint64_t> memory(THUMBNAIL_CACHE_MIN_SIZE / 8);
+		ThumbnailCache cache;
+		cache.Open(memory.data(), memory.size() * 8);
+		for (uint32_t i = 0; i < 100; i++)
+			Store(cache, MakeKey(i, 64, 64), MakeThumbnail(64, 64, i));
+		cache.Close();
+
+		// garbage over the slots and records of a closed cache
+		uint8_t* bytes = (uint8_t*)memory.data();
+		size_t start = sizeof(ThumbnailCacheHeader);
+		for (int i = 0; i < 200; i++)
+			bytes[start + random() % (memory.size() * 8 - start)] = (uint8_t)random();
+		if (run % 2 == 0)
+		{
+			// records that say they are far larger than they are
+			for (int i = 0; i < 20; i++)
+				*(uint32_t*)(bytes + ((start + random() % (memory.size() * 8 - start)) & ~(size_t)63)) = random();
+		}
+
+		cache.Open(memory.data(), memory.size() * 8);
+		for (uint32_t i = 0; i < 300; i++)
+		{
+			Thumbnail cached;
+			bool store;
+			Find(cache, MakeKey(i % 150, 64, 64), &cached, &store);
+			Store(cache, MakeKey(i, 64, 64), MakeThumbnail(64, 64, i));
+		}
+		Thumbnail cached;
+		bool store;
+		Expect(Find(cache, MakeKey(299, 64, 64), &cached, &store) && Same(cached, MakeThumbnail(64, 64, 299)), "stores after garbage", "garbage");
+		cache.Close();
+	}
+}
+
+static void CheckConcurrentReaders()
+{
+	vector<uint64_t> memory(2 * 1024 * 1024 / 8);
+	ThumbnailCache cache;
+	cache.Open(memory.data(), memory.size() * 8);
+
+	// every thumbnail of an image is filled with the same byte, so a torn one shows
+	shared_mutex lock;
+	atomic<bool> done(false);
+	atomic<int> torn(0);
+	atomic<int> found(0);
+
+	vector<thread> readers;
+	for (int r = 0; r < 4; r++)
+	{
+		readers.push_back(thread([&, r]()
+		{
+			mt19937 random(r);
+			while (!done)
+			{
+				uint32_t image = random() % 400;
+				Key key = MakeKey(image, 96, 96);
+				Thumbnail cached;
+				bool store = false;
+				bool hit;
+				{
+					shared_lock<shared_mutex> shared(lock);
+					hit = Find(cache, key, &cached, &store);
+				}
+				if (hit)
+				{
+					found++;
+					for (size_t i = 0; i < cached.pixels.size(); i++)
+					{
+						if (cached.pixels[i] != (uint8_t)image)
+						{
+							torn++;
+							break;
+						}
+					}
+					if (store)
+					{
+						unique_lock<shared_mutex> exclusive(lock);
+						Store(cache, key, cached);
+					}
+				}
+			}
+		}));
+	}
+
+	for (uint32_t i = 0; i < 20000; i++)
+	{
+		uint32_t image = i % 400;
+		Thumbnail thumbnail;
+		thumbnail.width = 96;
+		thumbnail.height = 90;
+		thumbnail.pixels.assign(96 * 90 * 4, (uint8_t)image);
+		unique_lock<shared_mutex> exclusive(lock);
+		Store(cache, MakeKey(image, 96, 96), thumbnail);
+	}
+	done = true;
+	for (size_t r = 0; r < readers.size(); r++)
+		readers[r].join();
+
+	char detail[100];
+	snprintf(detail, sizeof(detail), "%d torn of %d found", (int)torn, (int)found);
+	Expect(torn == 0 && found > 0, "concurrent readers", detail);
+}
+
+static void Benchmark()
+{
+	const int photos = 48;
+	const int photoWidth = 4000;
+	const int photoHeight = 3000;
+	const uint32_t thumbnailWidth = 160;
+	const uint32_t thumbnailHeight = 120;
+
+	// one photo's pixels stand in for all of them; the keys differ
+	vector<uint8_t> photo((size_t)photoWidth * photoHeight * 4);
+	mt19937 random(2);
+	for (size_t i = 0; i < photo.size(); i++)
+		photo[i] = (uint8_t)(random() & 0xFF);
+
+	vector<uint64_t> memory(64 * 1024 * 1024 / 8);
+	ThumbnailCache cache;
+	cache.Open(memory.data(), memory.size() * 8);
+
+	vector<uint8_t> thumbnail(thumbnailWidth * thumbnailHeight * 4);
+	auto start = chrono::steady_clock::now();
+	for (int i = 0; i < photos; i++)
+	{
+		ImageResampler::Resample(photo.data(), photoWidth, photoHeight, photoWidth * 4,
+			thumbnail.data(), thumbnailWidth, thumbnailHeight, thumbnailWidth * 4, 4, IMAGE_RESAMPLE_BICUBIC);
+		Key key = MakeKey(i, thumbnailWidth, thumbnailHeight);
+		cache.Store(key.hash, thumbnailWidth, thumbnailHeight, thumbnailWidth, thumbnailHeight, thumbnail.data(), thumbnailWidth * 4);
+	}
+	double cold = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	cache.Close();
+
+	// a new session: the cache comes back from disk
+	const char* path = "ThumbnailCacheCheck.cache";
+	FILE* file = fopen(path, "wb");
+	fwrite(memory.data(), 8, memory.size(), file);
+	fclose(file);
+	memory.assign(memory.size(), 0);
+
+	start = chrono::steady_clock::now();
+	file = fopen(path, "rb");
+	size_t read = fread(memory.data(), 8, memory.size(), file);
+	fclose(file);
+	if (read != memory.size())
+		printf("couldn't read %s\n", path);
+	cache.Open(memory.data(), memory.size() * 8);
+	int found = 0;
+	for (int i = 0; i < photos; i++)
+	{
+		Key key = MakeKey(i, thumbnailWidth, thumbnailHeight);
+		uint32_t width, height;
+		bool store;
+		if (cache.Find(key.hash, thumbnailWidth, thumbnailHeight, &width, &height, thumbnail.data(), &store))
+			found++;
+	}
+	double warm = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	cache.Close();
+	remove(path);
+
+	printf("%d photos, %dx%d, to %dx%d thumbnails (%d found warm)\n",
+		photos, photoWidth, photoHeight, (int)thumbnailWidth, (int)thumbnailHeight, found);
+	printf("  cold  %8.2f ms (resampling and storing, not counting decoding)\n", cold * 1e3);
+	printf("  warm  %8.2f ms (reading a 64 MB cache file and finding)\n", warm * 1e3);
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc == 2 && strcmp(argv[1], "/benchmark") == 0)
+	{
+		Benchmark();
+		return 0;
+	}
+	if (argc != 1)
+	{
+		printf("usage: ThumbnailCacheCheck [/benchmark]\n");
+		return 2;
+	}
+
+	CheckAgainstModel();
+	CheckHotThumbnailsKept();
+	CheckReopening();
+	CheckGarbage();
+	CheckConcurrentReaders();
+
+	printf("%s\n", failures == 0 ? "PASS" : "FAILED");
+	return failures == 0 ? 0 : 1;
+}
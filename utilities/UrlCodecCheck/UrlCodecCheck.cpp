@@ -0,0 +1,304 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+/*
+Checks the path/URL codec in OpenLiveWriter.CppUtils (UrlCodec.h) against a
+table of conversions taken from Windows, and measures its throughput:
+
+	UrlCodecCheck [/benchmark]
+
+The expected URLs are what new Uri(path).AbsoluteUri gives on Windows and the
+expected paths what Uri.LocalPath gives, except where noted. Exits with 1 if
+any conversion is wrong.
+
+Build it with and without -msse2 on 32-bit x86 to check both ways of
+finding runs:
+
+	c++ -std=c++11 -O2 -msse2 -o UrlCodecCheck UrlCodecCheck.cpp
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../../src/unmanaged/OpenLiveWriter.CppUtils/Include/UrlCodec.h"
+
+using namespace std;
+
+typedef basic_string<UrlChar> UrlString;
+
+#ifdef _WIN32
+#define T(s) L##s
+#else
+#define T(s) u##s
+#endif
+
+struct Conversion
+{
+	const UrlChar *path;
+	const UrlChar *url;
+};
+
+// paths and their URLs, both ways
+static const Conversion ROUND_TRIPS[] =
+{
+	{ T("C:\\Users\\writer\\Pictures\\beach.jpg"), T("file:///C:/Users/writer/Pictures/beach.jpg") },
+	{ T("C:\\My Pictures\\a b.png"), T("file:///C:/My%20Pictures/a%20b.png") },
+	{ T("c:\\lower\\case"), T("file:///c:/lower/case") },
+	{ T("C:\\"), T("file:///C:/") },
+	{ T("C:\\100%.png"), T("file:///C:/100%25.png") },
+	{ T("C:\\a#b.png"), T("file:///C:/a%23b.png") },
+	{ T("C:\\what?.png"), T("file:///C:/what%3F.png") },
+	{ T("C:\\caf\u00E9\\na\u00EFve.jpg"), T("file:///C:/caf%C3%A9/na%C3%AFve.jpg") },
+	{ T("C:\\\u65E5\u672C\\\u5199\u771F.png"), T("file:///C:/%E6%97%A5%E6%9C%AC/%E5%86%99%E7%9C%9F.png") },
+	{ T("C:\\emoji\\\U0001F600.png"), T("file:///C:/emoji/%F0%9F%98%80.png") },
+	{ T("C:\\a[1]{2}^`|.png"), T("file:///C:/a%5B1%5D%7B2%7D%5E%60%7C.png") },
+	{ T("C:\\keep!$&'()*+,;=@~-._.png"), T("file:///C:/keep!$&'()*+,;=@~-._.png") },
+	{ T("C:\\Program Files (x86)\\Open Live Writer\\OpenLiveWriter.exe"), T("file:///C:/Program%20Files%20(x86)/Open%20Live%20Writer/OpenLiveWriter.exe") },
+	{ T("\\\\server\\share\\dir\\file.txt"), T("file://server/share/dir/file.txt") },
+	{ T("\\\\server\\share\\a#1 b.png"), T("file://server/share/a%231%20b.png") },
+};
+
+// paths that only go one way
+static const Conversion PATHS_TO_URLS[] =
+{
+	{ T("C:/mixed\\slashes/file.txt"), T("file:///C:/mixed/slashes/file.txt") },
+	{ T("C:"), T("file:///C:/") },
+	// Uri rejects these; they are what the Win32 long path forms refer to
+	{ T("\\\\?\\C:\\long\\path.txt"), T("file:///C:/long/path.txt") },
+	{ T("\\\\?\\UNC\\server\\share\\file.txt"), T("file://server/share/file.txt") },
+	{ T("//server/share/file.txt"), T("file://server/share/file.txt") },
+};
+
+// URLs that only go one way
+static const Conversion URLS_TO_PATHS[] =
+{
+	{ T("C:\\a b.png"), T("FILE:///C:/a%20b.png") },
+	{ T("C:\\a b.png"), T("file://localhost/C:/a b.png") },
+	{ T("C:\\dir\\file.txt"), T("file:/C:/dir/file.txt") },
+	{ T("C:\\dir\\file.txt"), T("file:///C|/dir/file.txt") },
+	{ T("C:\\dir\\file.txt"), T("file:///C:/dir/file.txt?query#fragment") },
+	{ T("C:\\"), T("file:///C:") },
+	{ T("\\\\server\\share\\file.txt"), T("file:////server/share/file.txt") },
+	{ T("C:\\caf\u00E9.jpg"), T("file:///C:/caf%c3%a9.jpg") },
+	// escapes that aren't UTF-8 are left alone
+	{ T("C:\\bad%C3.jpg"), T("file:///C:/bad%C3.jpg") },
+	{ T("C:\\bad%E9%.jpg"), T("file:///C:/bad%E9%.jpg") },
+	{ T("C:\\surrogate%ED%A0%80.jpg"), T("file:///C:/surrogate%ED%A0%80.jpg") },
+	{ T("C:\\100%zz"), T("file:///C:/100%zz") },
+};
+
+static const UrlChar *INVALID_PATHS[] =
+{
+	T(""), T("relative\\path.txt"), T("\\rooted\\no\\drive"), T("C:relative"), T("1:\\digit"), T("\\\\"),
+};
+
+static const UrlChar *INVALID_URLS[] =
+{
+	T(""), T("http://example.com/a.png"), T("file:relative"), T("file:///no/drive"), T("SupportingFileReference://3EF3AA3F"),
+};
+
+static string Narrow(const UrlString &text)
+{
+	string narrow;
+	for (size_t i = 0; i < text.size(); i++)
+	{
+		UrlChar c = text[i];
+		if (c >= 0x20 && c < 0x7F)
+		{
+			narrow += (char)c;
+		}
+		else
+		{
+			char escape[8];
+			snprintf(escape, sizeof(escape), "\\u%04X", (unsigned int)c);
+			narrow += escape;
+		}
+	}
+	return narrow;
+}
+
+static int failures = 0;
+
+static void Fail(const char *what, const UrlString &input, const UrlString &expected, const UrlString &actual)
+{
+	printf("FAIL %s(%s)\n  expected %s\n  actual   %s\n", what, Narrow(input).c_str(), Narrow(expected).c_str(), Narrow(actual).c_str());
+	failures++;
+}
+
+typedef size_t (*Converter)(const UrlChar *, size_t, UrlChar *, size_t);
+
+static void Check(const char *what, Converter convert, const UrlString &input, const UrlString &expected)
+{
+	// measure, then convert into a buffer of exactly the right size
+	size_t length = convert(input.c_str(), input.size(), NULL, 0);
+	if (length == URL_CODEC_INVALID)
+	{
+		Fail(what, input, expected, T("<invalid>"));
+		return;
+	}
+
+	vector<UrlChar> buffer(length + 1, (UrlChar)'#');
+	convert(input.c_str(), input.size(), &buffer[0], buffer.size());
+	UrlString actual(&buffer[0], length);
+	if (actual != expected || buffer[length] != 0)
+	{
+		Fail(what, input, expected, actual);
+		return;
+	}
+
+	// a buffer one short gets a truncated, terminated result
+	if (length > 0)
+	{
+		vector<UrlChar> shortBuffer(length, (UrlChar)'#');
+		size_t needed = convert(input.c_str(), input.size(), &shortBuffer[0], shortBuffer.size());
+		if (needed != length || shortBuffer[length - 1] != 0 || UrlString(&shortBuffer[0]) != expected.substr(0, length - 1))
+			Fail(what, input, expected, T("<bad truncation>"));
+	}
+}
+
+static void CheckInvalid(const char *what, Converter convert, const UrlString &input)
+{
+	UrlChar buffer[64];
+	if (convert(input.c_str(), input.size(), buffer, 64) != URL_CODEC_INVALID)
+		Fail(what, input, T("<invalid>"), buffer);
+}
+
+static void CheckBatch()
+{
+	vector<const UrlChar *> paths;
+	vector<size_t> lengths;
+	size_t total = 0;
+	for (size_t i = 0; i < sizeof(ROUND_TRIPS) / sizeof(ROUND_TRIPS[0]); i++)
+	{
+		paths.push_back(ROUND_TRIPS[i].path);
+		lengths.push_back(UrlCodec::Length(ROUND_TRIPS[i].path));
+		total += UrlCodec::Length(ROUND_TRIPS[i].url) + 1;
+	}
+	paths.push_back(INVALID_PATHS[1]);
+	lengths.push_back(UrlCodec::Length(INVALID_PATHS[1]));
+
+	// an arena that holds about half of them, reset between rounds
+	vector<UrlChar> buffer(total / 2 + 64);
+	UrlCodecArena arena(&buffer[0], buffer.size());
+	vector<const UrlChar *> results(paths.size());
+	vector<size_t> resultLengths(paths.size());
+	size_t done = 0;
+	int rounds = 0;
+	while (done < paths.size())
+	{
+		arena.Reset();
+		size_t converted = UrlCodec::PathsToUrls(&paths[done], &lengths[done], paths.size() - done, arena, &results[done], &resultLengths[done]);
+		if (converted == 0)
+		{
+			printf("FAIL PathsToUrls made no progress\n");
+			failures++;
+			return;
+		}
+		for (size_t i = done; i < done + converted; i++)
+		{
+			if (i < sizeof(ROUND_TRIPS) / sizeof(ROUND_TRIPS[0]))
+			{
+				if (results[i] == NULL || UrlString(results[i], resultLengths[i]) != ROUND_TRIPS[i].url)
+					Fail("PathsToUrls", paths[i], ROUND_TRIPS[i].url, results[i] == NULL ? T("<null>") : results[i]);
+			}
+			else if (results[i] != NULL)
+			{
+				Fail("PathsToUrls", paths[i], T("<null>"), results[i]);
+			}
+		}
+		done += converted;
+		rounds++;
+	}
+	if (rounds < 2)
+	{
+		printf("FAIL PathsToUrls didn't fill the arena\n");
+		failures++;
+	}
+}
+
+static void Benchmark()
+{
+	// the kind of paths a post's supporting files have
+	vector<UrlString> paths;
+	for (int i = 0; i < 512; i++)
+	{
+		char name[128];
+		snprintf(name, sizeof(name), "C:\\Users\\writer\\AppData\\Roaming\\OpenLiveWriter\\PostSupportingFiles\\%08x-%d\\image %d_thumb.png", i * 2654435761u, i, i);
+		UrlString path;
+		for (const char *c = name; *c != 0; c++)
+			path += (UrlChar)*c;
+		paths.push_back(path);
+	}
+
+	vector<const UrlChar *> pathPointers;
+	vector<size_t> pathLengths;
+	for (size_t i = 0; i < paths.size(); i++)
+	{
+		pathPointers.push_back(paths[i].c_str());
+		pathLengths.push_back(paths[i].size());
+	}
+
+	vector<UrlChar> buffer(256 * 1024);
+	UrlCodecArena arena(&buffer[0], buffer.size());
+	vector<const UrlChar *> urls(paths.size());
+	vector<size_t> urlLengths(paths.size());
+	vector<UrlChar> pathBuffer(256 * 1024);
+	UrlCodecArena pathArena(&pathBuffer[0], pathBuffer.size());
+	vector<const UrlChar *> decoded(paths.size());
+	vector<size_t> decodedLengths(paths.size());
+
+	const int ROUNDS = 2000;
+	size_t characters = 0;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (int round = 0; round < ROUNDS; round++)
+	{
+		arena.Reset();
+		UrlCodec::PathsToUrls(&pathPointers[0], &pathLengths[0], paths.size(), arena, &urls[0], &urlLengths[0]);
+		characters += arena.GetUsed();
+	}
+	double encodeSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	start = chrono::steady_clock::now();
+	for (int round = 0; round < ROUNDS; round++)
+	{
+		pathArena.Reset();
+		UrlCodec::UrlsToPaths(&urls[0], &urlLengths[0], urls.size(), pathArena, &decoded[0], &decodedLengths[0]);
+	}
+	double decodeSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	double conversions = (double)ROUNDS * paths.size();
+	printf("path to URL: %.0f conversions/s, %.1f MB/s of URLs\n", conversions / encodeSeconds, characters * sizeof(UrlChar) / encodeSeconds / 1e6);
+	printf("URL to path: %.0f conversions/s\n", conversions / decodeSeconds);
+}
+
+int main(int argc, char *argv[])
+{
+	for (size_t i = 0; i < sizeof(ROUND_TRIPS) / sizeof(ROUND_TRIPS[0]); i++)
+	{
+		Check("PathToUrl", UrlCodec::PathToUrl, ROUND_TRIPS[i].path, ROUND_TRIPS[i].url);
+		Check("UrlToPath", UrlCodec::UrlToPath, ROUND_TRIPS[i].url, ROUND_TRIPS[i].path);
+	}
+	for (size_t i = 0; i < sizeof(PATHS_TO_URLS) / sizeof(PATHS_TO_URLS[0]); i++)
+		Check("PathToUrl", UrlCodec::PathToUrl, PATHS_TO_URLS[i].path, PATHS_TO_URLS[i].url);
+	for (size_t i = 0; i < sizeof(URLS_TO_PATHS) / sizeof(URLS_TO_PATHS[0]); i++)
+		Check("UrlToPath", UrlCodec::UrlToPath, URLS_TO_PATHS[i].url, URLS_TO_PATHS[i].path);
+	for (size_t i = 0; i < sizeof(INVALID_PATHS) / sizeof(INVALID_PATHS[0]); i++)
+		CheckInvalid("PathToUrl", UrlCodec::PathToUrl, INVALID_PATHS[i]);
+	for (size_t i = 0; i < sizeof(INVALID_URLS) / sizeof(INVALID_URLS[0]); i++)
+		CheckInvalid("UrlToPath", UrlCodec::UrlToPath, INVALID_URLS[i]);
+	CheckBatch();
+
+	if (failures > 0)
+	{
+		printf("%d failures\n", failures);
+		return 1;
+	}
+	printf("All conversions match\n");
+
+	if (argc > 1 && (strcmp(argv[1], "/benchmark") == 0 || strcmp(argv[1], "-benchmark") == 0))
+		Benchmark();
+	return 0;
+}
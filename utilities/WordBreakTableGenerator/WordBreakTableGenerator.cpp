@@ -0,0 +1,321 @@
+// Copyright (c) .NET Foundation. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+/*
+Generates the Word_Break property table used by the filter's word segmenter
+(WordSegmenter.h) from the Unicode Character Database:
+
+	WordBreakTableGenerator <UCD directory> <WordBreakTable.h> [/check]
+
+The UCD directory is an extracted UCD.zip; the generator reads
+UnicodeData.txt, auxiliary/WordBreakProperty.txt and emoji/emoji-data.txt.
+Every code point gets a byte: its Word_Break value in the low bits, plus a
+flag for Extended_Pictographic (rule WB3c) and one for letters and numbers
+(general category L or N), which the segmenter uses to tell words from
+punctuation and spaces. The bytes are stored as a two-stage table of
+128-entry blocks with duplicate blocks shared.
+
+The output is checked in. Run this when moving to a new Unicode version,
+then run "FilterTool segment conformance" against the WordBreakTest.txt of
+the same version; /check only compares and fails if the table is stale.
+
+	c++ -std=c++11 -O2 -o WordBreakTableGenerator WordBreakTableGenerator.cpp
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static const unsigned int CODE_POINT_COUNT = 0x110000;
+static const unsigned int BLOCK_SHIFT = 7;
+static const unsigned int BLOCK_SIZE = 1 << BLOCK_SHIFT;
+
+// in the order of WordBreakProperty in the generated header
+static const char *PROPERTY_NAMES[] =
+{
+	"Other", "CR", "LF", "Newline", "Extend", "ZWJ", "Regional_Indicator", "Format",
+	"Katakana", "Hebrew_Letter", "ALetter", "Single_Quote", "Double_Quote",
+	"MidNumLet", "MidLetter", "MidNum", "Numeric", "ExtendNumLet", "WSegSpace"
+};
+
+static const char *ENUM_NAMES[] =
+{
+	"WB_OTHER", "WB_CR", "WB_LF", "WB_NEWLINE", "WB_EXTEND", "WB_ZWJ", "WB_REGIONAL_INDICATOR", "WB_FORMAT",
+	"WB_KATAKANA", "WB_HEBREW_LETTER", "WB_ALETTER", "WB_SINGLE_QUOTE", "WB_DOUBLE_QUOTE",
+	"WB_MIDNUMLET", "WB_MIDLETTER", "WB_MIDNUM", "WB_NUMERIC", "WB_EXTENDNUMLET", "WB_WSEGSPACE"
+};
+
+static const int PROPERTY_COUNT = sizeof(PROPERTY_NAMES) / sizeof(PROPERTY_NAMES[0]);
+static const unsigned char EXTENDED_PICTOGRAPHIC = 0x20;
+static const unsigned char WORD_CHARACTER = 0x40;
+
+static string Trim(const string &value)
+{
+	size_t start = value.find_first_not_of(" \t\r");
+	if (start == string::npos)
+		return string();
+	size_t end = value.find_last_not_of(" \t\r");
+	return value.substr(start, end - start + 1);
+}
+
+static bool ReadFile(const string &path, string &contents)
+{
+	ifstream file(path.c_str(), ios::in | ios::binary);
+	if (!file)
+		return false;
+	ostringstream buffer;
+	buffer << file.rdbuf();
+	contents = buffer.str();
+	return true;
+}
+
+// Parses "XXXX" or "XXXX..YYYY".
+static bool ParseRange(const string &field, unsigned int &first, unsigned int &last)
+{
+	string range = Trim(field);
+	size_t dots = range.find("..");
+	char *end;
+	first = strtoul(range.c_str(), &end, 16);
+	if (end == range.c_str())
+		return false;
+	last = dots == string::npos ? first : strtoul(range.c_str() + dots + 2, &end, 16);
+	return first <= last && last < CODE_POINT_COUNT;
+}
+
+/*
+Reads the "range ; value # comment" lines of a UCD property file, calling
+assign for every range. Returns the version from the "# Name-X.Y.Z.txt"
+line at the top, or an empty string if the file can't be read.
+*/
+template <typename Assign>
+static string ReadPropertyFile(const string &path, Assign assign)
+{
+	string contents;
+	if (!ReadFile(path, contents))
+	{
+		fprintf(stderr, "Can't read %s\n", path.c_str());
+		return string();
+	}
+
+	string version = "unknown";
+	istringstream lines(contents);
+	string line;
+	bool first = true;
+	while (getline(lines, line))
+	{
+		if (first)
+		{
+			// # WordBreakProperty-14.0.0.txt
+			size_t dash = line.rfind('-');
+			size_t dot = line.rfind(".txt");
+			if (line.compare(0, 1, "#") == 0 && dash != string::npos && dot != string::npos && dash < dot)
+				version = line.substr(dash + 1, dot - dash - 1);
+			first = false;
+		}
+
+		size_t hash = line.find('#');
+		if (hash != string::npos)
+			line.erase(hash);
+		size_t semicolon = line.find(';');
+		if (semicolon == string::npos)
+			continue;
+
+		unsigned int firstCodePoint, lastCodePoint;
+		if (!ParseRange(line.substr(0, semicolon), firstCodePoint, lastCodePoint))
+		{
+			fprintf(stderr, "%s: invalid line: %s\n", path.c_str(), line.c_str());
+			return string();
+		}
+		assign(firstCodePoint, lastCodePoint, Trim(line.substr(semicolon + 1)));
+	}
+	return version;
+}
+
+// Marks letters and numbers, including the ranges given as First/Last pairs.
+static bool ReadUnicodeData(const string &path, vector<unsigned char> &properties)
+{
+	string contents;
+	if (!ReadFile(path, contents))
+	{
+		fprintf(stderr, "Can't read %s\n", path.c_str());
+		return false;
+	}
+
+	istringstream lines(contents);
+	string line;
+	unsigned int rangeStart = 0;
+	while (getline(lines, line))
+	{
+		vector<string> fields;
+		istringstream fieldStream(line);
+		string field;
+		while (getline(fieldStream, field, ';'))
+			fields.push_back(field);
+		if (fields.size() < 3)
+			continue;
+
+		unsigned int codePoint, unused;
+		if (!ParseRange(fields[0], codePoint, unused))
+		{
+			fprintf(stderr, "%s: invalid line: %s\n", path.c_str(), line.c_str());
+			return false;
+		}
+
+		const string &name = fields[1];
+		if (name.find(", First>") != string::npos)
+		{
+			rangeStart = codePoint;
+			continue;
+		}
+		unsigned int first = name.find(", Last>") != string::npos ? rangeStart : codePoint;
+
+		char category = fields[2].empty() ? 0 : fields[2][0];
+		if (category == 'L' || category == 'N')
+		{
+			for (unsigned int c = first; c <= codePoint; c++)
+				properties[c] |= WORD_CHARACTER;
+		}
+	}
+	return true;
+}
+
+static string GenerateHeader(const vector<unsigned char> &properties, const string &version)
+{
+	// share identical blocks
+	vector<unsigned short> stage1;
+	vector<unsigned char> stage2;
+	map<vector<unsigned char>, unsigned short> blocks;
+	for (unsigned int start = 0; start < CODE_POINT_COUNT; start += BLOCK_SIZE)
+	{
+		vector<unsigned char> block(properties.begin() + start, properties.begin() + start + BLOCK_SIZE);
+		map<vector<unsigned char>, unsigned short>::iterator found = blocks.find(block);
+		if (found == blocks.end())
+		{
+			unsigned short index = (unsigned short)blocks.size();
+			found = blocks.insert(make_pair(block, index)).first;
+			stage2.insert(stage2.end(), block.begin(), block.end());
+		}
+		stage1.push_back(found->second);
+	}
+
+	ostringstream out;
+	out << "// Copyright (c) .NET Foundation. All rights reserved.\n"
+		"// Licensed under the MIT license. See LICENSE file in the project root for details.\n"
+		"\n"
+		"// Generated by utilities\\WordBreakTableGenerator from the Unicode " << version << " character database.\n"
+		"// Do not edit; regenerate it instead.\n"
+		"\n"
+		"#pragma once\n"
+		"\n"
+		"// Word_Break property values (UAX #29)\n"
+		"enum WordBreakProperty\n"
+		"{\n";
+	for (int i = 0; i < PROPERTY_COUNT; i++)
+		out << "\t" << ENUM_NAMES[i] << (i == 0 ? " = 0" : "") << ",\n";
+	out << "\tWB_PROPERTY_COUNT\n"
+		"};\n"
+		"\n"
+		"const unsigned char WB_PROPERTY_MASK = 0x1F;\n"
+		"const unsigned char WB_EXTENDED_PICTOGRAPHIC = 0x" << hex << (int)EXTENDED_PICTOGRAPHIC << ";\n"
+		"// general category L or N\n"
+		"const unsigned char WB_WORD_CHARACTER = 0x" << (int)WORD_CHARACTER << dec << ";\n"
+		"\n"
+		"const unsigned int WORD_BREAK_BLOCK_SHIFT = " << BLOCK_SHIFT << ";\n"
+		"\n"
+		"static const unsigned short WORD_BREAK_STAGE1[" << stage1.size() << "] =\n"
+		"{\n";
+	for (size_t i = 0; i < stage1.size(); i++)
+		out << (i % 16 == 0 ? "\t" : " ") << stage1[i] << "," << (i % 16 == 15 || i + 1 == stage1.size() ? "\n" : "");
+	out << "};\n"
+		"\n"
+		"static const unsigned char WORD_BREAK_STAGE2[" << stage2.size() << "] =\n"
+		"{\n";
+	for (size_t i = 0; i < stage2.size(); i++)
+		out << (i % 32 == 0 ? "\t" : " ") << (int)stage2[i] << "," << (i % 32 == 31 || i + 1 == stage2.size() ? "\n" : "");
+	out << "};\n"
+		"\n"
+		"// The Word_Break value and flags of a code point.\n"
+		"inline unsigned char GetWordBreak(unsigned int codePoint)\n"
+		"{\n"
+		"\treturn WORD_BREAK_STAGE2[(WORD_BREAK_STAGE1[codePoint >> WORD_BREAK_BLOCK_SHIFT] << WORD_BREAK_BLOCK_SHIFT)\n"
+		"\t\t| (codePoint & ((1 << WORD_BREAK_BLOCK_SHIFT) - 1))];\n"
+		"}\n";
+	return out.str();
+}
+
+static bool Output(const char *path, const string &contents, bool check)
+{
+	string existing;
+	if (ReadFile(path, existing) && existing == contents)
+		return true;
+	if (check)
+	{
+		fprintf(stderr, "%s is out of date\n", path);
+		return false;
+	}
+
+	ofstream file(path, ios::out | ios::binary | ios::trunc);
+	file << contents;
+	if (!file)
+	{
+		fprintf(stderr, "Can't write %s\n", path);
+		return false;
+	}
+	printf("Wrote %s\n", path);
+	return true;
+}
+
+int main(int argc, char *argv[])
+{
+	bool check = argc == 4 && (strcmp(argv[3], "/check") == 0 || strcmp(argv[3], "-check") == 0);
+	if (argc != 3 && !check)
+	{
+		fprintf(stderr, "Usage: WordBreakTableGenerator <UCD directory> <WordBreakTable.h> [/check]\n");
+		return 1;
+	}
+
+	string directory = argv[1];
+	vector<unsigned char> properties(CODE_POINT_COUNT, 0);
+
+	bool valid = true;
+	string version = ReadPropertyFile(directory + "/auxiliary/WordBreakProperty.txt",
+		[&](unsigned int first, unsigned int last, const string &value)
+		{
+			int property = 0;
+			while (property < PROPERTY_COUNT && value != PROPERTY_NAMES[property])
+				property++;
+			if (property == PROPERTY_COUNT)
+			{
+				fprintf(stderr, "Unknown Word_Break value %s\n", value.c_str());
+				valid = false;
+				return;
+			}
+			for (unsigned int c = first; c <= last; c++)
+				properties[c] = (properties[c] & ~0x1F) | property;
+		});
+	if (version.empty() || !valid)
+		return 1;
+
+	if (ReadPropertyFile(directory + "/emoji/emoji-data.txt",
+		[&](unsigned int first, unsigned int last, const string &value)
+		{
+			if (value == "Extended_Pictographic")
+			{
+				for (unsigned int c = first; c <= last; c++)
+					properties[c] |= EXTENDED_PICTOGRAPHIC;
+			}
+		}).empty())
+		return 1;
+
+	if (!ReadUnicodeData(directory + "/UnicodeData.txt", properties))
+		return 1;
+
+	return Output(argv[2], GenerateHeader(properties, version), check) ? 0 : 1;
+}